@@ -0,0 +1,837 @@
+/*
+ * microbench.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * microbench: microbenchmarks for getdiff parsers and list primitives.
+ * Linked with getdiff objects - all but getdiff.o - so the functions
+ * measured are the ones shipped. Inputs are generated in a temporary
+ * directory: planet (nginx) and Geofabrik (apache) listings with 2000
+ * entries, a large newerFiles.txt and many state.txt files.
+ *
+ * Each benchmark runs long enough to fill '--time' seconds; best of
+ * '--rounds' rounds is reported as ns/op, allocations/op and bytes/op.
+ * Allocations are counted by malloc() family wrappers below; glibc
+ * supports replacing them in the executable. Measurement is single threaded.
+ *
+ * Results may be saved to a baseline file and later runs compared with it;
+ * a regression is slower ns/op past '--threshold' percent or more
+ * allocations/op.
+ *
+ * Build and run: make bench    Save baseline: make bench-save
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/stat.h>
+
+#include "getdiff.h"
+#include "util.h"
+#include "ztError.h"
+#include "list.h"
+#include "fileio.h"
+#include "parse.h"
+#include "parseAnchor.h"
+
+#define LISTING_FILES    1000      /* change files in listing; two entries each **/
+#define STATE_FILES      1000
+#define NEWER_LINES      100000
+#define BENCH_NAME_MAX   48
+#define BASE_SEQUENCE    6125000u
+#define BASE_TIME        1790812800L   /* 2026-10-01T00:00:00Z **/
+
+/* globals getdiff.c defines for the rest of the objects **/
+char   *progName = "microbench";
+int    fVerbose = 0;
+FILE   *fLogPtr = NULL;
+int    fUsingPreviousID = 0;
+
+typedef struct BENCH_ {
+
+  const char  *name;
+  int         (*setup)(void);
+  int         (*run)(long iteration);  /* one op; returns ztSuccess **/
+  void        (*teardown)(void);
+
+} BENCH;
+
+typedef struct RESULT_ {
+
+  char    name[BENCH_NAME_MAX];
+  double  nsOp;
+  double  allocsOp;
+  double  bytesOp;
+
+} RESULT;
+
+/* allocation counters; only while 'counting' is set **/
+static int        counting = 0;
+static long long  allocCount = 0;
+static long long  allocBytes = 0;
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static double  minTime = 0.5;
+static int     rounds = 3;
+static long    newerLines = NEWER_LINES;
+static double  threshold = 10.0;
+static char    *inputDir = NULL;
+
+static char  planetHtml[PATH_MAX];
+static char  geofabrikHtml[PATH_MAX];
+static char  newerFile[PATH_MAX];
+static char  *stateFiles[STATE_FILES];
+static char  *timeLines[STATE_FILES];
+static char  *sequences[STATE_FILES];
+static char  *anchorLines[LISTING_FILES * 2];
+static char  *shuffledNames[LISTING_FILES * 2];
+
+static STATE_INFO  *stateInfo = NULL;
+static PATH_PART   *pathPart = NULL;
+
+static void usage(const char *name);
+static double nowNs(void);
+static int makeInputs(const char *dir);
+static int writeListing(const char *filename, int isTable);
+static void freeInputs(void);
+static int runBench(BENCH *bench, RESULT *result);
+static int saveResults(const char *filename, RESULT *results, int count);
+static int compareResults(const char *filename, RESULT *results, int count);
+
+static int benchPlanetHtml(long iteration);
+static int benchGeofabrikHtml(long iteration);
+static int benchParseAnchor(long iteration);
+static int setupStateInfo(void);
+static void teardownStateInfo(void);
+static int benchStateFile(long iteration);
+static int benchTimestamp(long iteration);
+static int benchListInsert(long iteration);
+static int benchFile2List(long iteration);
+static int setupPathPart(void);
+static void teardownPathPart(void);
+static int benchSequence2Path(long iteration);
+
+static BENCH benches[] = {
+
+  {"parseHtmlFile/planet-2000",     NULL, benchPlanetHtml, NULL},
+  {"parseHtmlFile/geofabrik-2000",  NULL, benchGeofabrikHtml, NULL},
+  {"parseAnchor/2000-lines",        NULL, benchParseAnchor, NULL},
+  {"stateFile2StateInfo",           setupStateInfo, benchStateFile, teardownStateInfo},
+  {"parseTimestampLine",            NULL, benchTimestamp, NULL},
+  {"ListInsertInOrder/2000",        NULL, benchListInsert, NULL},
+  {"file2StringList/newerFiles",    NULL, benchFile2List, NULL},
+  {"sequence2PathPart",             setupPathPart, benchSequence2Path, teardownPathPart},
+  {NULL, NULL, NULL, NULL}
+};
+
+void *malloc(size_t size){
+
+  if(counting){
+    allocCount++;
+    allocBytes += size;
+  }
+
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size){
+
+  if(counting){
+    allocCount++;
+    allocBytes += nmemb * size;
+  }
+
+  return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size){
+
+  if(counting){
+    allocCount++;
+    allocBytes += size;
+  }
+
+  return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr){
+
+  __libc_free(ptr);
+}
+
+int main(int argc, char *argv[]){
+
+  struct option longOptions[] = {
+    {"time", 1, NULL, 't'},
+    {"rounds", 1, NULL, 'r'},
+    {"lines", 1, NULL, 'n'},
+    {"filter", 1, NULL, 'f'},
+    {"save", 1, NULL, 's'},
+    {"compare", 1, NULL, 'c'},
+    {"threshold", 1, NULL, 'T'},
+    {"dir", 1, NULL, 'd'},
+    {"help", 0, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
+
+  char  *filter = NULL;
+  char  *saveFile = NULL;
+  char  *compareFile = NULL;
+  char  tmpDir[] = "/tmp/microbench.XXXXXX";
+  int   option;
+  int   result;
+  int   count = 0;
+  int   exitCode = EXIT_SUCCESS;
+
+  RESULT  results[sizeof(benches) / sizeof(benches[0])];
+
+  while((option = getopt_long(argc, argv, "t:r:n:f:s:c:T:d:h", longOptions, NULL)) != -1){
+
+    switch(option){
+
+    case 't':
+      minTime = atof(optarg);
+      break;
+
+    case 'r':
+      rounds = atoi(optarg);
+      break;
+
+    case 'n':
+      newerLines = atol(optarg);
+      break;
+
+    case 'f':
+      filter = optarg;
+      break;
+
+    case 's':
+      saveFile = optarg;
+      break;
+
+    case 'c':
+      compareFile = optarg;
+      break;
+
+    case 'T':
+      threshold = atof(optarg);
+      break;
+
+    case 'd':
+      inputDir = optarg;
+      break;
+
+    case 'h':
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if(minTime <= 0 || rounds < 1 || newerLines < 1 || threshold < 0){
+    fprintf(stderr, "%s: Error invalid option value.\n", progName);
+    return EXIT_FAILURE;
+  }
+
+  if(! inputDir){
+    inputDir = mkdtemp(tmpDir);
+    if(! inputDir){
+      fprintf(stderr, "%s: Error failed mkdtemp(): %s\n", progName, strerror(errno));
+      return EXIT_FAILURE;
+    }
+  }
+  else if(mkdir(inputDir, 0755) != 0 && errno != EEXIST){
+    fprintf(stderr, "%s: Error failed mkdir() for <%s>: %s\n", progName, inputDir, strerror(errno));
+    return EXIT_FAILURE;
+  }
+
+  result = makeInputs(inputDir);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed to write inputs in <%s>.\n", progName, inputDir);
+    return EXIT_FAILURE;
+  }
+
+  fprintf(stdout, "getdiff %s microbench; %.2f s per round, best of %d; inputs in %s\n\n",
+          VERSION, minTime, rounds, inputDir);
+  fprintf(stdout, "%-32s %14s %12s %14s\n", "benchmark", "ns/op", "allocs/op", "bytes/op");
+
+  for(BENCH *bench = benches; bench->name; bench++){
+
+    if(filter && ! strstr(bench->name, filter))
+      continue;
+
+    result = runBench(bench, &results[count]);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error benchmark <%s> failed: %s\n", progName, bench->name, ztCode2Msg(result));
+      exitCode = EXIT_FAILURE;
+      continue;
+    }
+
+    fprintf(stdout, "%-32s %14.1f %12.1f %14.1f\n", results[count].name,
+            results[count].nsOp, results[count].allocsOp, results[count].bytesOp);
+    count++;
+  }
+
+  if(compareFile && compareResults(compareFile, results, count) != 0)
+    exitCode = EXIT_FAILURE;
+
+  if(saveFile && saveResults(saveFile, results, count) != ztSuccess)
+    exitCode = EXIT_FAILURE;
+
+  /* remove generated inputs unless user named directory **/
+  if(inputDir == tmpDir){
+    char command[PATH_MAX + 16];
+    snprintf(command, sizeof(command), "rm -rf '%s'", tmpDir);
+    if(system(command) != 0)
+      fprintf(stderr, "%s: Warning failed to remove <%s>.\n", progName, tmpDir);
+  }
+
+  freeInputs();
+
+  return exitCode;
+
+} /* END main() **/
+
+static void usage(const char *name){
+
+  fprintf(stdout,
+    "Usage: %s [OPTION]\n"
+    "Microbenchmarks for getdiff parsers and list primitives.\n\n"
+    "  -t, --time SECONDS     minimum time per round; default 0.5\n"
+    "  -r, --rounds N         rounds per benchmark, best is reported; default 3\n"
+    "  -n, --lines N          newerFiles.txt lines; default %d\n"
+    "  -f, --filter STRING    run benchmarks with STRING in name only\n"
+    "  -s, --save FILE        write results to baseline FILE\n"
+    "  -c, --compare FILE     compare results with baseline FILE; exit 1 on regression\n"
+    "  -T, --threshold PCT    ns/op increase counted as regression; default 10\n"
+    "  -d, --dir DIR          write inputs to DIR and keep them; default temporary\n"
+    "  -h, --help             print this help\n",
+    name, NEWER_LINES);
+
+} /* END usage() **/
+
+static double nowNs(void){
+
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+/* runBench(): doubles iterations until a run fills 'minTime', then runs
+ * 'rounds' rounds of that many iterations; best ns/op is kept. Allocation
+ * counts do not change between rounds.
+ *
+ *************************************************************************/
+static int runBench(BENCH *bench, RESULT *result){
+
+  long    iterations = 1;
+  long    index;
+  double  start, elapsed = 0;
+  double  best = 0;
+  int     ret;
+
+  ASSERTARGS(bench && result);
+
+  if(bench->setup){
+    ret = bench->setup();
+    if(ret != ztSuccess)
+      return ret;
+  }
+
+  /* calibrate; also warms caches **/
+  while(1){
+
+    start = nowNs();
+    for(index = 0; index < iterations; index++){
+      ret = bench->run(index);
+      if(ret != ztSuccess)
+        goto done;
+    }
+    elapsed = nowNs() - start;
+
+    if(elapsed >= minTime * 1e9 || iterations >= (1L << 30))
+      break;
+
+    iterations *= 2;
+  }
+
+  memset(result, 0, sizeof(RESULT));
+  snprintf(result->name, sizeof(result->name), "%s", bench->name);
+
+  for(int round = 0; round < rounds; round++){
+
+    allocCount = 0;
+    allocBytes = 0;
+    counting = 1;
+
+    start = nowNs();
+    for(index = 0; index < iterations; index++){
+      ret = bench->run(index);
+      if(ret != ztSuccess)
+        break;
+    }
+    elapsed = nowNs() - start;
+
+    counting = 0;
+
+    if(ret != ztSuccess)
+      goto done;
+
+    if(round == 0 || elapsed < best)
+      best = elapsed;
+
+    result->allocsOp = (double) allocCount / iterations;
+    result->bytesOp = (double) allocBytes / iterations;
+  }
+
+  result->nsOp = best / iterations;
+  ret = ztSuccess;
+
+done:
+
+  counting = 0;
+
+  if(bench->teardown)
+    bench->teardown();
+
+  return ret;
+
+} /* END runBench() **/
+
+/* benchmarks; 'iteration' picks input in round robin where there are many **/
+
+static int benchListing(const char *filename){
+
+  STRING_LIST  *list;
+  int          result;
+
+  list = initialStringList();
+  if(! list)
+    return ztMemoryAllocate;
+
+  result = parseHtmlFile(list, filename);
+
+  if(result == ztSuccess && DL_SIZE(list) != LISTING_FILES * 2)
+    result = ztParseError;
+
+  zapStringList((void **) &list);
+
+  return result;
+}
+
+static int benchPlanetHtml(long iteration){
+
+  return benchListing(planetHtml);
+}
+
+static int benchGeofabrikHtml(long iteration){
+
+  return benchListing(geofabrikHtml);
+}
+
+static int benchParseAnchor(long iteration){
+
+  STRING_LIST  *list;
+  int          result = ztSuccess;
+
+  list = initialStringList();
+  if(! list)
+    return ztMemoryAllocate;
+
+  for(int index = 0; result == ztSuccess && index < LISTING_FILES * 2; index++)
+    result = parseAnchor(list, anchorLines[index]);
+
+  zapStringList((void **) &list);
+
+  return result;
+}
+
+static int setupStateInfo(void){
+
+  stateInfo = initialStateInfo();
+
+  return stateInfo ? ztSuccess : ztMemoryAllocate;
+}
+
+static void teardownStateInfo(void){
+
+  zapStateInfo(&stateInfo);
+  stateInfo = NULL;
+}
+
+static int benchStateFile(long iteration){
+
+  return stateFile2StateInfo(stateInfo, stateFiles[iteration % STATE_FILES]);
+}
+
+static int benchTimestamp(long iteration){
+
+  struct tm  tmStruct;
+
+  return parseTimestampLine(&tmStruct, timeLines[iteration % STATE_FILES]);
+}
+
+/* list does not own strings; no destroy function **/
+static int benchListInsert(long iteration){
+
+  DLIST  list;
+  int    result = ztSuccess;
+
+  initialDL(&list, NULL, NULL);
+
+  for(int index = 0; result == ztSuccess && index < LISTING_FILES * 2; index++)
+    result = ListInsertInOrder(&list, shuffledNames[index]);
+
+  destroyDL(&list);
+
+  return result;
+}
+
+static int benchFile2List(long iteration){
+
+  STRING_LIST  *list;
+  int          result;
+
+  list = initialStringList();
+  if(! list)
+    return ztMemoryAllocate;
+
+  result = file2StringList(list, newerFile);
+
+  zapStringList((void **) &list);
+
+  return result;
+}
+
+static int setupPathPart(void){
+
+  pathPart = initialPathPart();
+
+  return pathPart ? ztSuccess : ztMemoryAllocate;
+}
+
+static void teardownPathPart(void){
+
+  zapPathPart((void **) &pathPart);
+  pathPart = NULL;
+}
+
+static int benchSequence2Path(long iteration){
+
+  return sequence2PathPart(pathPart, sequences[iteration % STATE_FILES]);
+}
+
+/* makeInputs(): writes input files to 'dir' and fills in-memory inputs.
+ * Names, times and sequence numbers follow bench/replserver.
+ *
+ *************************************************************************/
+static int makeInputs(const char *dir){
+
+  char    name[PATH_MAX];
+  char    line[256];
+  char    timeStr[32];
+  FILE    *fPtr;
+  time_t  mtime;
+  struct tm  tmTime;
+  int     index;
+  int     result;
+  unsigned int  seq;
+  unsigned int  rand = 1;
+
+  ASSERTARGS(dir);
+
+  snprintf(planetHtml, sizeof(planetHtml), "%s/planet.html", dir);
+  snprintf(geofabrikHtml, sizeof(geofabrikHtml), "%s/geofabrik.html", dir);
+  snprintf(newerFile, sizeof(newerFile), "%s/%s", dir, NEW_DIFFERS);
+
+  result = writeListing(planetHtml, 0);
+  if(result != ztSuccess)
+    return result;
+
+  result = writeListing(geofabrikHtml, 1);
+  if(result != ztSuccess)
+    return result;
+
+  /* state files; time line and sequence string are kept for their benchmarks **/
+  for(index = 0; index < STATE_FILES; index++){
+
+    seq = BASE_SEQUENCE + (unsigned int) index;
+    mtime = BASE_TIME + (time_t) index * 60;
+    gmtime_r(&mtime, &tmTime);
+
+    strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H\\:%M\\:%SZ", &tmTime);
+
+    snprintf(name, sizeof(name), "%s/%03u.state.txt", dir, seq % 1000u);
+
+    fPtr = fopen(name, "w");
+    if(! fPtr)
+      return ztOpenFileError;
+
+    fprintf(fPtr, "#Sat Oct 18 20:21:39 UTC 2026\nsequenceNumber=%u\ntimestamp=%s\n", seq, timeStr);
+    fclose(fPtr);
+
+    stateFiles[index] = STRDUP(name);
+
+    snprintf(line, sizeof(line), "timestamp=%s", timeStr);
+    timeLines[index] = STRDUP(line);
+
+    snprintf(line, sizeof(line), "%u", seq);
+    sequences[index] = STRDUP(line);
+  }
+
+  /* newerFiles.txt; one pair per two lines as getdiff writes it **/
+  fPtr = fopen(newerFile, "w");
+  if(! fPtr)
+    return ztOpenFileError;
+
+  for(long count = 0; count < newerLines; count++){
+
+    seq = BASE_SEQUENCE + (unsigned int) (count / 2);
+
+    fprintf(fPtr, "/minute/%03u/%03u/%03u%s\n", seq / 1000000u, (seq / 1000u) % 1000u,
+            seq % 1000u, (count % 2) ? STATE_EXT : CHANGE_EXT);
+  }
+
+  fclose(fPtr);
+
+  /* anchor lines and shuffled names for parseAnchor() and ListInsertInOrder() **/
+  for(index = 0; index < LISTING_FILES * 2; index++){
+
+    char entry[32];
+
+    snprintf(entry, sizeof(entry), "%03d%s", index / 2, (index % 2) ? STATE_EXT : CHANGE_EXT);
+
+    snprintf(line, sizeof(line), "<a href=\"%s\">%s</a>%*s18-Oct-2026 20:21 %8s",
+             entry, entry, (int) (51 - strlen(entry)), "", (index % 2) ? "113" : "1234");
+
+    anchorLines[index] = STRDUP(line);
+    shuffledNames[index] = STRDUP(entry);
+  }
+
+  for(index = LISTING_FILES * 2 - 1; index > 0; index--){
+
+    char *swap;
+    int  other;
+
+    rand = rand * 1103515245u + 12345u;
+    other = (int) ((rand >> 8) % (unsigned int) (index + 1));
+
+    swap = shuffledNames[index];
+    shuffledNames[index] = shuffledNames[other];
+    shuffledNames[other] = swap;
+  }
+
+  return ztSuccess;
+
+} /* END makeInputs() **/
+
+/* writeListing(): planet listing is nginx 'pre' style, Geofabrik is apache table **/
+static int writeListing(const char *filename, int isTable){
+
+  FILE  *fPtr;
+  char  name[32];
+
+  fPtr = fopen(filename, "w");
+  if(! fPtr)
+    return ztOpenFileError;
+
+  if(isTable)
+    fprintf(fPtr, "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 3.2 Final//EN\">\n<html>\n"
+            "<head>\n<title>Index of /europe/andorra-updates/000/004/</title>\n</head>\n<body>\n"
+            "<h1>Index of /europe/andorra-updates/000/004/</h1>\n"
+            "<table>\n<tr><th valign=\"top\"><img src=\"/icons/blank.gif\" alt=\"[ICO]\"></th>"
+            "<th><a href=\"?C=N;O=D\">Name</a></th><th><a href=\"?C=M;O=A\">Last modified</a></th>"
+            "<th><a href=\"?C=S;O=A\">Size</a></th></tr>\n"
+            "<tr><td valign=\"top\"><img src=\"/icons/back.gif\" alt=\"[PARENTDIR]\"></td>"
+            "<td><a href=\"../\">Parent Directory</a></td><td>&nbsp;</td><td align=\"right\">  - </td></tr>\n");
+  else
+    fprintf(fPtr, "<html>\n<head><title>Index of /replication/minute/006/125/</title></head>\n<body>\n"
+            "<h1>Index of /replication/minute/006/125/</h1><hr><pre><a href=\"../\">../</a>\n");
+
+  for(int index = 0; index < LISTING_FILES * 2; index++){
+
+    snprintf(name, sizeof(name), "%03d%s", index / 2, (index % 2) ? STATE_EXT : CHANGE_EXT);
+
+    if(isTable)
+      fprintf(fPtr, "<tr><td valign=\"top\"><img src=\"/icons/unknown.gif\" alt=\"[   ]\"></td>"
+              "<td><a href=\"%s\">%s</a></td><td align=\"right\">2026-10-18 20:21  </td>"
+              "<td align=\"right\">%s</td></tr>\n", name, name, (index % 2) ? "113 " : "1.2K");
+    else
+      fprintf(fPtr, "<a href=\"%s\">%s</a>%*s18-Oct-2026 20:21 %8s\n",
+              name, name, (int) (51 - strlen(name)), "", (index % 2) ? "113" : "1234");
+  }
+
+  if(isTable)
+    fprintf(fPtr, "<tr><th colspan=\"5\"><hr></th></tr>\n</table>\n</body></html>\n");
+  else
+    fprintf(fPtr, "</pre><hr></body>\n</html>\n");
+
+  fclose(fPtr);
+
+  return ztSuccess;
+
+} /* END writeListing() **/
+
+static void freeInputs(void){
+
+  for(int index = 0; index < STATE_FILES; index++){
+    free(stateFiles[index]);
+    free(timeLines[index]);
+    free(sequences[index]);
+  }
+
+  for(int index = 0; index < LISTING_FILES * 2; index++){
+    free(anchorLines[index]);
+    free(shuffledNames[index]);
+  }
+}
+
+/* baseline file: comment lines start with '#', then one line per benchmark:
+ *
+ *   name ns/op allocs/op bytes/op
+ *
+ *************************************************************************/
+static int saveResults(const char *filename, RESULT *results, int count){
+
+  FILE    *fPtr;
+  char    partName[PATH_MAX];
+  char    timeStr[32];
+  time_t  now = time(NULL);
+  struct tm  tmTime;
+
+  ASSERTARGS(filename && results);
+
+  snprintf(partName, sizeof(partName), "%s.part", filename);
+
+  fPtr = fopen(partName, "w");
+  if(! fPtr){
+    fprintf(stderr, "%s: Error failed fopen() for <%s>: %s\n", progName, partName, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  gmtime_r(&now, &tmTime);
+  strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%SZ", &tmTime);
+
+  fprintf(fPtr, "# getdiff microbench baseline\n# version %s\n# date %s\n", VERSION, timeStr);
+  fprintf(fPtr, "# name ns/op allocs/op bytes/op\n");
+
+  for(int index = 0; index < count; index++)
+    fprintf(fPtr, "%s %.1f %.1f %.1f\n", results[index].name,
+            results[index].nsOp, results[index].allocsOp, results[index].bytesOp);
+
+  if(fclose(fPtr) != 0 || rename(partName, filename) != 0){
+    fprintf(stderr, "%s: Error failed to write <%s>: %s\n", progName, filename, strerror(errno));
+    return ztWriteError;
+  }
+
+  fprintf(stdout, "\nbaseline saved to %s\n", filename);
+
+  return ztSuccess;
+
+} /* END saveResults() **/
+
+/* compareResults(): prints change from baseline for each benchmark.
+ * returns number of regressions; a missing baseline file is not an error,
+ * -1 on memory allocation failure.
+ *
+ *************************************************************************/
+static int compareResults(const char *filename, RESULT *results, int count){
+
+  FILE    *fPtr;
+  char    line[256];
+  char    version[32] = "unknown";
+  char    name[BENCH_NAME_MAX];
+  double  nsOp, allocsOp, bytesOp;
+  double  delta;
+  int     regressions = 0;
+  int     found;
+
+  ASSERTARGS(filename && results);
+
+  fPtr = fopen(filename, "r");
+  if(! fPtr){
+    fprintf(stdout, "\nno baseline <%s>; save one with: make bench-save\n", filename);
+    return 0;
+  }
+
+  RESULT  *base = (RESULT *) calloc(count ? count : 1, sizeof(RESULT));
+  int     *have = (int *) calloc(count ? count : 1, sizeof(int));
+
+  if(! (base && have)){
+    fclose(fPtr);
+    free(base);
+    free(have);
+    return -1;
+  }
+
+  while(fgets(line, sizeof(line), fPtr)){
+
+    if(line[0] == '#'){
+      sscanf(line, "# version %31s", version);
+      continue;
+    }
+
+    if(sscanf(line, "%47s %lf %lf %lf", name, &nsOp, &allocsOp, &bytesOp) != 4)
+      continue;
+
+    for(int index = 0; index < count; index++){
+      if(strcmp(results[index].name, name) == 0){
+        base[index].nsOp = nsOp;
+        base[index].allocsOp = allocsOp;
+        base[index].bytesOp = bytesOp;
+        have[index] = 1;
+      }
+    }
+  }
+
+  fclose(fPtr);
+
+  fprintf(stdout, "\ncompared with %s (version %s); threshold %.1f%%\n", filename, version, threshold);
+  fprintf(stdout, "%-32s %14s %10s %12s %12s\n", "benchmark", "base ns/op", "change", "base allocs", "allocs/op");
+
+  found = 0;
+  for(int index = 0; index < count; index++){
+
+    if(! have[index]){
+      fprintf(stdout, "%-32s %14s\n", results[index].name, "new");
+      continue;
+    }
+
+    found++;
+
+    delta = base[index].nsOp > 0 ?
+      (results[index].nsOp - base[index].nsOp) * 100.0 / base[index].nsOp : 0;
+
+    int isSlower = delta > threshold;
+    int moreAllocs = results[index].allocsOp > base[index].allocsOp + 0.5;
+
+    fprintf(stdout, "%-32s %14.1f %+9.1f%% %12.1f %12.1f%s\n", results[index].name,
+            base[index].nsOp, delta, base[index].allocsOp, results[index].allocsOp,
+            (isSlower || moreAllocs) ? "  REGRESSION" : "");
+
+    if(isSlower || moreAllocs)
+      regressions++;
+  }
+
+  free(base);
+  free(have);
+
+  fprintf(stdout, "\n%d of %d compared; %d regression%s\n", found, count, regressions,
+          regressions == 1 ? "" : "s");
+
+  return regressions;
+
+} /* END compareResults() **/
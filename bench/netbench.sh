@@ -0,0 +1,166 @@
+#!/bin/bash
+
+# netbench.sh
+# runs getdiff against stand-in replication server bench/replserver on the
+# loopback interface and reports files/sec, bytes/sec and request counts.
+# No network access is needed. Run from anywhere: make netbench or
+#   bench/netbench.sh [-n PAIRS] [-s BYTES] [-L MS] [-B KIB] [-e PCT] [-d PCT]
+#                     [-g planet|geofabrik] [-p PORT] [-k]
+#
+# getdiff waits SLEEP_INTERVAL between downloads to spare real servers; a
+# copy built with PACE=0 (bench/getdiff-nopace) is used unless -k is given.
+
+SCRIPT_DIR=$(cd "$(dirname "$0")" && pwd)
+REPO=$(dirname "$SCRIPT_DIR")
+
+PAIRS=61
+SIZE=262144
+LATENCY=0
+BANDWIDTH=0
+ERROR_RATE=0
+DROP_RATE=0
+LAYOUT=planet
+PORT=18080
+KEEP_PACE=0
+
+FIRST=6125000
+MAX_PAIRS_RUN=61   # MAX_OSC_DOWNLOAD in getdiff.h
+
+usage(){
+  echo "Usage: $0 [-n PAIRS] [-s BYTES] [-L MS] [-B KIB] [-e PCT] [-d PCT] [-g planet|geofabrik] [-p PORT] [-k]"
+  echo "  -n  change file pairs to download; default $PAIRS"
+  echo "  -s  uncompressed change file size; default $SIZE"
+  echo "  -L  server latency per request in milliseconds; default 0"
+  echo "  -B  server bandwidth per connection in KiB/s; default no limit"
+  echo "  -e  percent of requests answered with 503; default 0"
+  echo "  -d  percent of change file bodies cut off; default 0"
+  echo "  -g  layout: planet (minute) or geofabrik; default planet"
+  echo "  -p  server port on 127.0.0.1; default $PORT"
+  echo "  -k  keep getdiff pacing between downloads"
+}
+
+while getopts "n:s:L:B:e:d:g:p:kh" opt; do
+  case $opt in
+    n) PAIRS=$OPTARG ;;
+    s) SIZE=$OPTARG ;;
+    L) LATENCY=$OPTARG ;;
+    B) BANDWIDTH=$OPTARG ;;
+    e) ERROR_RATE=$OPTARG ;;
+    d) DROP_RATE=$OPTARG ;;
+    g) LAYOUT=$OPTARG ;;
+    p) PORT=$OPTARG ;;
+    k) KEEP_PACE=1 ;;
+    h) usage; exit 0 ;;
+    *) usage; exit 1 ;;
+  esac
+done
+
+case $LAYOUT in
+  planet)    SOURCE=http://planet.openstreetmap.org/replication/minute/ ;;
+  geofabrik) SOURCE=http://download.geofabrik.de/europe/andorra-updates/ ;;
+  *) echo "$0: Error layout is planet or geofabrik."; exit 1 ;;
+esac
+
+if ! [[ $PAIRS =~ ^[1-9][0-9]*$ ]]; then
+  echo "$0: Error -n needs a positive number."; exit 1
+fi
+
+make -s -C "$REPO" replserver || exit 1
+
+if [ $KEEP_PACE -eq 1 ]; then
+  make -s -C "$REPO" || exit 1
+  GETDIFF=$REPO/getdiff
+else
+  make -s -C "$REPO" PACE=0 OBJ_DIR=obj/nopace EXEC=bench/getdiff-nopace || exit 1
+  GETDIFF=$REPO/bench/getdiff-nopace
+fi
+
+WORK=$(mktemp -d /tmp/netbench.XXXXXX) || exit 1
+mkdir "$WORK/root"
+echo "# netbench" > "$WORK/getdiff.conf"
+
+LAST=$((FIRST + PAIRS - 1))
+
+"$SCRIPT_DIR/replserver" -p "$PORT" -f "$FIRST" -l "$LAST" -s "$SIZE" -L "$LATENCY" -B "$BANDWIDTH" \
+    -e "$ERROR_RATE" -d "$DROP_RATE" -o "$WORK/server.stats" > "$WORK/server.out" 2>&1 &
+SERVER_PID=$!
+
+cleanup(){
+  kill "$SERVER_PID" 2>/dev/null
+  wait "$SERVER_PID" 2>/dev/null
+}
+trap cleanup EXIT
+
+# wait for listen socket
+for i in $(seq 50); do
+  (echo > "/dev/tcp/127.0.0.1/$PORT") 2>/dev/null && break
+  sleep 0.1
+done
+
+echo "netbench: $PAIRS pairs, $LAYOUT layout, size $SIZE, latency ${LATENCY}ms, bandwidth ${BANDWIDTH}KiB/s," \
+     "errors ${ERROR_RATE}%, drops ${DROP_RATE}%, pacing $([ $KEEP_PACE -eq 1 ] && echo on || echo off)"
+
+FAILED=0
+START=$(date +%s%N)
+
+# range runs; getdiff downloads at most MAX_PAIRS_RUN pairs per run
+begin=$FIRST
+while [ $begin -le $LAST ]; do
+  end=$((begin + MAX_PAIRS_RUN - 1))
+  [ $end -gt $LAST ] && end=$LAST
+
+  env -u no_proxy -u NO_PROXY -u all_proxy -u ALL_PROXY http_proxy=http://127.0.0.1:$PORT \
+      "$GETDIFF" -d "$WORK/root" -s "$SOURCE" -b $begin -e $end -c "$WORK/getdiff.conf" \
+      >> "$WORK/getdiff.out" 2>&1
+  rc=$?
+  if [ $rc -ne 0 ]; then
+    echo "netbench: getdiff exit code $rc for range $begin to $end; see $WORK/getdiff.out"
+    FAILED=$((FAILED + 1))
+  fi
+
+  begin=$((end + 1))
+done
+
+STOP=$(date +%s%N)
+
+cleanup
+trap - EXIT
+
+stat_value(){
+  awk -v key="$1" '$1 == key { print $2 }' "$WORK/server.stats"
+}
+
+FILES=$(find "$WORK/root" -name '[0-9][0-9][0-9].osc.gz' -o -name '[0-9][0-9][0-9].state.txt' | wc -l)
+BYTES=$(find "$WORK/root" \( -name '[0-9][0-9][0-9].osc.gz' -o -name '[0-9][0-9][0-9].state.txt' \) -printf '%s\n' |
+        awk '{ sum += $1 } END { print sum + 0 }')
+
+awk -v start="$START" -v stop="$STOP" -v files="$FILES" -v bytes="$BYTES" -v pairs="$PAIRS" \
+    -v requests="$(stat_value requests)" -v heads="$(stat_value head_requests)" \
+    -v listings="$(stat_value listings)" -v conns="$(stat_value connections)" \
+    -v wire="$(stat_value body_bytes)" -v s2="$(stat_value status_2xx)" \
+    -v s4="$(stat_value status_4xx)" -v s5="$(stat_value status_5xx)" \
+    -v injected="$(stat_value injected_errors)" -v dropped="$(stat_value dropped_bodies)" \
+    -v failed="$FAILED" 'BEGIN {
+  secs = (stop - start) / 1e9
+  if (secs <= 0) secs = 1e-9
+  printf "elapsed_seconds   %.3f\n", secs
+  printf "files             %d of %d\n", files, pairs * 2
+  printf "files_per_sec     %.2f\n", files / secs
+  printf "bytes_on_disk     %d\n", bytes
+  printf "bytes_per_sec     %.0f\n", bytes / secs
+  printf "wire_bytes        %d\n", wire
+  printf "requests          %d (head %d, listings %d)\n", requests, heads, listings
+  printf "requests_per_file %.2f\n", (files ? requests / files : 0)
+  printf "connections       %d\n", conns
+  printf "status            2xx %d, 4xx %d, 5xx %d\n", s2, s4, s5
+  printf "injected          errors %d, dropped bodies %d\n", injected, dropped
+  printf "failed_runs       %d\n", failed
+}'
+
+if [ $FAILED -eq 0 ]; then
+  rm -rf "$WORK"
+else
+  echo "netbench: work directory kept: $WORK"
+fi
+
+exit $FAILED
@@ -0,0 +1,1528 @@
+/*
+ * replserver.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * replserver: stand-in replication server for tests and benchmarks; no
+ * network access is needed. Serves synthetic replication tree - change
+ * files, state.txt files and directory listings - for sequence numbers
+ * 'first' to 'last' under any base path:
+ *
+ *   {base}state.txt  {base}NNN/  {base}NNN/NNN/  {base}NNN/NNN/NNN.osc.gz
+ *   {base}NNN/NNN/NNN.state.txt
+ *
+ * base ending with "-updates/" is Geofabrik layout and daily; others are
+ * planet layout with granularity from "minute", "hour" or "day" in base.
+ * Requests may be in origin form or absolute form, so getdiff reaches it
+ * without changes through curl proxy environment variable:
+ *
+ *   http_proxy=http://127.0.0.1:8080 getdiff -s http://planet.openstreetmap.org/replication/minute/ ...
+ *
+ * Latency, bandwidth, error rate and dropped connections are set on the
+ * command line. Request counts are written to 'stats' file and standard
+ * output on SIGTERM or SIGINT; "GET /_stats" returns them while running.
+ *
+ * With --oauth USER:PASSWORD it is also stand-in OSM login server and
+ * Geofabrik cookie consumer for getdiff cookie login - six steps in
+ * getCookieFile() - and change files need the cookie it hands out:
+ *
+ *   POST /get_cookie?action=get_authorization_url    JSON for login
+ *   GET  /login?cookie_test=true  POST /login        session and login
+ *   GET  /oauth2/authorize  POST /oauth2/authorize   grant; redirect
+ *   GET  /logout                                     end session
+ *   GET  /get_cookie?action=get_cookie&code=..&state=..&format=http
+ *
+ * getdiff finds it with LOGIN_HOST and CONSUMER_URL configuration keys.
+ *
+ * Build: make replserver    Run: bench/replserver --help
+ */
+
+#define _GNU_SOURCE   /* strcasestr() **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <zlib.h>
+
+#define REQUEST_MAX     8192
+#define SEND_CHUNK      (16 * 1024)
+#define CACHE_SLOTS     64
+#define BASE_TIME       1790812800L   /* 2026-10-01T00:00:00Z **/
+
+/* --oauth stand-in values; fixed, there is one user **/
+#define OAUTH_CLIENT_ID   "replserver-client"
+#define OAUTH_CSRF        "replserver-csrf-token"
+#define OAUTH_CODE        "replserver-code"
+#define OAUTH_STATE       "replserver-state"
+#define OAUTH_SESSION     "_osm_session="
+#define OAUTH_LOGGED_IN   "_osm_session=replserver-user"
+#define OAUTH_COOKIE      "gf_download_oauth=\"login|2026-10-01|replserver-cookie-token==\""
+#define OAUTH_COOKIE_DAYS 7
+
+typedef enum LISTING_ {
+
+  LISTING_AUTO = 0,
+  LISTING_PLANET,
+  LISTING_GEOFABRIK,
+  LISTING_OFF
+
+} LISTING;
+
+typedef struct SERVER_CONF_ {
+
+  char          address[INET_ADDRSTRLEN];
+  int           port;
+  unsigned int  first;
+  unsigned int  last;
+  long          size;          /* uncompressed change file bytes **/
+  long          latencyMs;     /* before each response **/
+  long          bandwidth;     /* bytes per second per connection; 0 no limit **/
+  double        errorRate;     /* percent of requests answered 'errorCode' **/
+  int           errorCode;
+  double        dropRate;      /* percent of file bodies cut in half **/
+  unsigned int  seed;
+  LISTING       listing;
+  char          *statsFile;
+  int           verbose;
+  char          *oauthUser;    /* with --oauth; login server and consumer **/
+  char          *oauthPassword;
+
+} SERVER_CONF;
+
+typedef struct STATS_ {
+
+  long       requests;
+  long       heads;
+  long       listings;
+  long       changeFiles;
+  long       stateFiles;
+  long       errors;       /* injected **/
+  long       dropped;
+  long       notFound;
+  long       connections;
+  long       logins;       /* cookies handed out with --oauth **/
+  long long  bytes;        /* body bytes sent **/
+  long       status[6];    /* by first digit: 1xx to 5xx **/
+
+} STATS;
+
+typedef struct CACHE_SLOT_ {
+
+  unsigned int  seq;
+  char          *data;
+  size_t        length;
+
+} CACHE_SLOT;
+
+static SERVER_CONF      conf;
+static STATS            stats;
+static CACHE_SLOT       cache[CACHE_SLOTS];
+static pthread_mutex_t  statsLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t  cacheLock = PTHREAD_MUTEX_INITIALIZER;
+static time_t           startTime;
+
+static volatile sig_atomic_t  stopServer = 0;
+
+static void usage(const char *name);
+static void stopHandler(int signum);
+static void *serveConnection(void *arg);
+static int handleRequest(int fd, char *head, const char *form, unsigned int *rand, int *keepAlive);
+static int serveTree(int fd, const char *base, const char *rest, int isHead, int keepAlive, unsigned int *rand,
+                     int hasCookie);
+static int isLoginPath(const char *path);
+static int serveLogin(int fd, const char *head, const char *path, const char *form, int isPost, int keepAlive);
+static int serveListing(int fd, const char *path, const char *base, int root, int parent, int isHead, int keepAlive);
+static int sendResponse(int fd, int status, const char *type, const char *body, size_t length,
+                        time_t mtime, int isHead, int keepAlive, int drop);
+static int sendReply(int fd, int status, const char *type, const char *body, size_t length,
+                     time_t mtime, int isHead, int keepAlive, int drop, const char *extra);
+static int sendAll(int fd, const char *data, size_t size);
+static int splitPath(const char *path, char *base, size_t size, const char **rest);
+static int parseTriplet(const char *str);
+static int entryRange(unsigned int *low, unsigned int *high, unsigned long start, unsigned long lo, unsigned long hi);
+static long stepSeconds(const char *base);
+static int isGeofabrik(const char *base);
+static char *changeFile(unsigned int seq, size_t *length);
+static char *makeChangeFile(unsigned int seq, size_t *length);
+static int appendFormat(char **buffer, size_t *length, size_t *size, const char *format, ...);
+static void countStatus(int status, long long bytes);
+static int writeStats(FILE *toFile);
+static int isPercent(double *value, const char *arg);
+static int headerValue(char *dst, size_t size, const char *head, const char *name);
+static int formValue(char *dst, size_t size, const char *form, const char *name);
+static int urlEncode(char *dst, size_t size, const char *src);
+
+int main(int argc, char *argv[]){
+
+  struct option longOptions[] = {
+    {"address", 1, NULL, 'a'},
+    {"port", 1, NULL, 'p'},
+    {"first", 1, NULL, 'f'},
+    {"last", 1, NULL, 'l'},
+    {"size", 1, NULL, 's'},
+    {"latency", 1, NULL, 'L'},
+    {"bandwidth", 1, NULL, 'B'},
+    {"error-rate", 1, NULL, 'e'},
+    {"error-code", 1, NULL, 'c'},
+    {"drop-rate", 1, NULL, 'd'},
+    {"seed", 1, NULL, 'S'},
+    {"listing", 1, NULL, 'g'},
+    {"stats", 1, NULL, 'o'},
+    {"oauth", 1, NULL, 'O'},
+    {"verbose", 0, NULL, 'v'},
+    {"help", 0, NULL, 'h'},
+    {0, 0, 0, 0}
+  };
+
+  int                 option;
+  int                 listenFD, fd;
+  int                 one = 1;
+  struct sockaddr_in  serverAddr;
+  struct sigaction    action;
+  pthread_t           thread;
+  pthread_attr_t      attr;
+  FILE                *statsPtr;
+  int                 *fdPtr;
+
+  memset(&conf, 0, sizeof(SERVER_CONF));
+  strcpy(conf.address, "127.0.0.1");
+  conf.port = 8080;
+  conf.first = 6125000;
+  conf.last = 6125120;
+  conf.size = 64 * 1024;
+  conf.errorCode = 503;
+  conf.seed = 1;
+
+  while((option = getopt_long(argc, argv, "a:p:f:l:s:L:B:e:c:d:S:g:o:O:vh", longOptions, NULL)) != -1){
+
+    switch(option){
+
+    case 'a':
+      if(strlen(optarg) >= sizeof(conf.address) || inet_pton(AF_INET, optarg, &serverAddr.sin_addr) != 1){
+        fprintf(stderr, "replserver: Error invalid IPv4 address: <%s>\n", optarg);
+        return 1;
+      }
+      strcpy(conf.address, optarg);
+      break;
+
+    case 'p':
+      conf.port = atoi(optarg);
+      break;
+
+    case 'f':
+      conf.first = (unsigned int) strtoul(optarg, NULL, 10);
+      break;
+
+    case 'l':
+      conf.last = (unsigned int) strtoul(optarg, NULL, 10);
+      break;
+
+    case 's':
+      conf.size = atol(optarg);
+      break;
+
+    case 'L':
+      conf.latencyMs = atol(optarg);
+      break;
+
+    case 'B':
+      conf.bandwidth = atol(optarg) * 1024L;
+      break;
+
+    case 'e':
+      if(! isPercent(&conf.errorRate, optarg)){
+        fprintf(stderr, "replserver: Error invalid percent for --error-rate: <%s>\n", optarg);
+        return 1;
+      }
+      break;
+
+    case 'c':
+      conf.errorCode = atoi(optarg);
+      break;
+
+    case 'd':
+      if(! isPercent(&conf.dropRate, optarg)){
+        fprintf(stderr, "replserver: Error invalid percent for --drop-rate: <%s>\n", optarg);
+        return 1;
+      }
+      break;
+
+    case 'S':
+      conf.seed = (unsigned int) strtoul(optarg, NULL, 10);
+      break;
+
+    case 'g':
+      if(strcmp(optarg, "auto") == 0)
+        conf.listing = LISTING_AUTO;
+      else if(strcmp(optarg, "planet") == 0)
+        conf.listing = LISTING_PLANET;
+      else if(strcmp(optarg, "geofabrik") == 0)
+        conf.listing = LISTING_GEOFABRIK;
+      else if(strcmp(optarg, "off") == 0)
+        conf.listing = LISTING_OFF;
+      else {
+        fprintf(stderr, "replserver: Error --listing is one of: auto, planet, geofabrik or off.\n");
+        return 1;
+      }
+      break;
+
+    case 'o':
+      conf.statsFile = optarg;
+      break;
+
+    case 'O':
+      if(! strchr(optarg, ':') || optarg[0] == ':'){
+        fprintf(stderr, "replserver: Error --oauth argument is USER:PASSWORD: <%s>\n", optarg);
+        return 1;
+      }
+      conf.oauthUser = optarg;
+      conf.oauthPassword = strchr(optarg, ':');
+      *conf.oauthPassword++ = '\0';
+      break;
+
+    case 'v':
+      conf.verbose = 1;
+      break;
+
+    case 'h':
+      usage(argv[0]);
+      return 0;
+
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if(conf.port < 1 || conf.port > 65535 || conf.first < 100 || conf.last < conf.first ||
+     conf.last > 999999999 || conf.size < 256 || conf.latencyMs < 0 || conf.bandwidth < 0 ||
+     conf.errorCode < 400 || conf.errorCode > 599){
+    fprintf(stderr, "replserver: Error invalid setting; see: %s --help\n", argv[0]);
+    return 1;
+  }
+
+  listenFD = socket(AF_INET, SOCK_STREAM, 0);
+  if(listenFD < 0){
+    fprintf(stderr, "replserver: Error failed socket(): %s\n", strerror(errno));
+    return 1;
+  }
+
+  setsockopt(listenFD, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  memset(&serverAddr, 0, sizeof(serverAddr));
+  serverAddr.sin_family = AF_INET;
+  serverAddr.sin_port = htons((unsigned short) conf.port);
+  inet_pton(AF_INET, conf.address, &serverAddr.sin_addr);
+
+  if(bind(listenFD, (struct sockaddr *) &serverAddr, sizeof(serverAddr)) != 0 || listen(listenFD, 64) != 0){
+    fprintf(stderr, "replserver: Error failed bind() or listen() on %s:%d: %s\n",
+            conf.address, conf.port, strerror(errno));
+    close(listenFD);
+    return 1;
+  }
+
+  /* no SA_RESTART; accept() returns on signal **/
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = stopHandler;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+  startTime = time(NULL);
+
+  fprintf(stdout, "replserver: Serving sequences %u to %u on http://%s:%d/\n",
+          conf.first, conf.last, conf.address, conf.port);
+  if(conf.oauthUser)
+    fprintf(stdout, "replserver: Login for user <%s>; LOGIN_HOST http://%s:%d and CONSUMER_URL http://%s:%d/get_cookie\n",
+            conf.oauthUser, conf.address, conf.port, conf.address, conf.port);
+  fflush(stdout);
+
+  while(! stopServer){
+
+    fd = accept(listenFD, NULL, NULL);
+    if(fd < 0){
+      if(errno == EINTR || errno == ECONNABORTED)
+        continue;
+      fprintf(stderr, "replserver: Error failed accept(): %s\n", strerror(errno));
+      break;
+    }
+
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    fdPtr = (int *) malloc(sizeof(int));
+    if(!fdPtr){
+      close(fd);
+      continue;
+    }
+
+    *fdPtr = fd;
+
+    if(pthread_create(&thread, &attr, serveConnection, fdPtr) != 0){
+      close(fd);
+      free(fdPtr);
+    }
+  }
+
+  close(listenFD);
+  pthread_attr_destroy(&attr);
+
+  pthread_mutex_lock(&statsLock);
+
+  writeStats(stdout);
+
+  if(conf.statsFile){
+    statsPtr = fopen(conf.statsFile, "w");
+    if(statsPtr){
+      writeStats(statsPtr);
+      fclose(statsPtr);
+    }
+    else
+      fprintf(stderr, "replserver: Error failed fopen() for stats file: <%s>\n", conf.statsFile);
+  }
+
+  pthread_mutex_unlock(&statsLock);
+
+  return 0;
+
+} /* END main() **/
+
+static void usage(const char *name){
+
+  fprintf(stdout,
+    "Usage: %s [OPTION]\n"
+    "Stand-in replication server; synthetic change files tree for getdiff tests.\n\n"
+    "  -a, --address IPV4     Listen address; default 127.0.0.1.\n"
+    "  -p, --port PORT        Listen port; default 8080.\n"
+    "  -f, --first SEQ        First sequence number served; default 6125000.\n"
+    "  -l, --last SEQ         Last sequence number; latest in state.txt; default 6125120.\n"
+    "  -s, --size BYTES       Uncompressed change file size; default 65536.\n"
+    "  -L, --latency MS       Delay before each response; default 0.\n"
+    "  -B, --bandwidth KIB    Bandwidth per connection in KiB/s; default no limit.\n"
+    "  -e, --error-rate PCT   Percent of requests answered with error code; default 0.\n"
+    "  -c, --error-code CODE  Injected error status; default 503.\n"
+    "  -d, --drop-rate PCT    Percent of file bodies cut off half way; default 0.\n"
+    "  -S, --seed NUM         Seed for error and drop choice; default 1.\n"
+    "  -g, --listing STYLE    Listing style: auto, planet, geofabrik or off; default auto.\n"
+    "  -o, --stats FILE       Write request counts to FILE on exit.\n"
+    "  -O, --oauth USER:PASS  Also stand-in OSM login and cookie consumer; change\n"
+    "                         files need the cookie.\n"
+    "  -v, --verbose          Print each request.\n"
+    "  -h, --help             Show this information.\n\n"
+    "Use with: http_proxy=http://ADDRESS:PORT getdiff -s http://planet.openstreetmap.org/replication/minute/\n"
+    "With --oauth set keys in getdiff configuration file:\n"
+    "  LOGIN_HOST http://ADDRESS:PORT\n  CONSUMER_URL http://ADDRESS:PORT/get_cookie\n",
+    name);
+
+  return;
+
+} /* END usage() **/
+
+static void stopHandler(int signum){
+
+  (void) signum;
+
+  stopServer = 1;
+
+} /* END stopHandler() **/
+
+/* serveConnection(): thread for one connection; keep-alive requests are
+ * served until client closes or asks to close. Request body - POST form
+ * with --oauth - is read by its Content-Length.
+ *
+ ***************************************************************************/
+
+static void *serveConnection(void *arg){
+
+  int           fd = *(int *) arg;
+  char          buffer[REQUEST_MAX + 1];
+  char          form[REQUEST_MAX + 1];
+  char          value[32];
+  size_t        used = 0, headLength, formLength;
+  ssize_t       got;
+  char          *end;
+  int           keepAlive = 1;
+  unsigned int  rand;
+
+  free(arg);
+
+  /* same seed, same choices for same connection order **/
+  pthread_mutex_lock(&statsLock);
+  stats.connections++;
+  rand = conf.seed * 2654435761u + (unsigned int) stats.connections;
+  pthread_mutex_unlock(&statsLock);
+
+  while(keepAlive && ! stopServer){
+
+    end = NULL;
+    while(! (end = (used ? strstr(buffer, "\r\n\r\n") : NULL))){
+
+      if(used >= REQUEST_MAX)
+        break;
+
+      got = recv(fd, buffer + used, REQUEST_MAX - used, 0);
+      if(got <= 0)
+        break;
+
+      used += (size_t) got;
+      buffer[used] = '\0';
+    }
+
+    if(!end)
+      break;
+
+    *end = '\0';
+    headLength = (size_t) (end + 4 - buffer);
+
+    formLength = 0;
+    if(headerValue(value, sizeof(value), buffer, "Content-Length") == 0)
+      formLength = strtoul(value, NULL, 10);
+
+    if(formLength > REQUEST_MAX - headLength)
+      break;
+
+    while(used < headLength + formLength){
+
+      got = recv(fd, buffer + used, REQUEST_MAX - used, 0);
+      if(got <= 0)
+        break;
+
+      used += (size_t) got;
+      buffer[used] = '\0';
+    }
+
+    if(used < headLength + formLength)
+      break;
+
+    memcpy(form, buffer + headLength, formLength);
+    form[formLength] = '\0';
+
+    if(handleRequest(fd, buffer, form, &rand, &keepAlive) != 0)
+      break;
+
+    /* pipelined request after this one **/
+    used -= headLength + formLength;
+    memmove(buffer, buffer + headLength + formLength, used);
+    buffer[used] = '\0';
+  }
+
+  close(fd);
+
+  return NULL;
+
+} /* END serveConnection() **/
+
+static int handleRequest(int fd, char *head, const char *form, unsigned int *rand, int *keepAlive){
+
+  char  method[16] = {0};
+  char  target[2048] = {0};
+  char  version[16] = {0};
+  char  base[2048];
+  char  cookie[1024];
+  char  *path;
+  const char  *rest;
+  int   isHead, isPost;
+
+  if(sscanf(head, "%15s %2047s %15s", method, target, version) != 3){
+    sendResponse(fd, 400, "text/plain", "bad request\n", 12, 0, 0, 0, 0);
+    return 1;
+  }
+
+  if(strcasestr(head, "\r\nConnection: close") || strcmp(version, "HTTP/1.0") == 0)
+    *keepAlive = 0;
+
+  if(conf.verbose)
+    fprintf(stdout, "replserver: %s %s\n", method, target);
+
+  isHead = (strcmp(method, "HEAD") == 0);
+  isPost = (conf.oauthUser && strcmp(method, "POST") == 0);
+  if(! isHead && ! isPost && strcmp(method, "GET") != 0)
+
+    return sendResponse(fd, 405, "text/plain", "method not allowed\n", 19, 0, 0, *keepAlive, 0);
+
+  /* absolute form from proxy client: drop scheme and host **/
+  path = target;
+  if(strncasecmp(path, "http://", 7) == 0 || strncasecmp(path, "https://", 8) == 0){
+    path = strchr(strstr(path, "//") + 2, '/');
+    if(!path)
+      path = "/";
+  }
+
+  pthread_mutex_lock(&statsLock);
+  stats.requests++;
+  if(isHead)
+    stats.heads++;
+  pthread_mutex_unlock(&statsLock);
+
+  if(strcmp(path, "/_stats") == 0){
+
+    char    *body = NULL;
+    size_t  length = 0;
+    FILE    *memPtr;
+    int     result;
+
+    memPtr = open_memstream(&body, &length);
+    if(!memPtr)
+      return 1;
+
+    pthread_mutex_lock(&statsLock);
+    writeStats(memPtr);
+    pthread_mutex_unlock(&statsLock);
+
+    fclose(memPtr);
+
+    result = sendResponse(fd, 200, "text/plain", body, length, 0, isHead, *keepAlive, 0);
+    free(body);
+
+    return result;
+  }
+
+  if(conf.latencyMs)
+    usleep((useconds_t) conf.latencyMs * 1000);
+
+  if(conf.errorRate > 0.0 && (rand_r(rand) % 10000) < (unsigned int) (conf.errorRate * 100.0)){
+
+    pthread_mutex_lock(&statsLock);
+    stats.errors++;
+    pthread_mutex_unlock(&statsLock);
+
+    return sendResponse(fd, conf.errorCode, "text/plain", "injected error\n", 15, 0, isHead, *keepAlive, 0);
+  }
+
+  if(conf.oauthUser && isLoginPath(path))
+
+    return serveLogin(fd, head, path, form, isPost, *keepAlive);
+
+  if(isPost || splitPath(path, base, sizeof(base), &rest) != 0)
+
+    return sendResponse(fd, 404, "text/plain", "not found\n", 10, 0, isHead, *keepAlive, 0);
+
+  cookie[0] = '\0';
+  headerValue(cookie, sizeof(cookie), head, "Cookie");
+
+  return serveTree(fd, base, rest, isHead, *keepAlive, rand, strstr(cookie, OAUTH_COOKIE) != NULL);
+
+} /* END handleRequest() **/
+
+/* serveTree(): 'rest' is path after 'base'; it matched splitPath(). With
+ * --oauth change files are for requests with 'hasCookie' only.
+ *
+ ***************************************************************************/
+
+static int serveTree(int fd, const char *base, const char *rest, int isHead, int keepAlive, unsigned int *rand,
+                     int hasCookie){
+
+  int           root, parent, file;
+  unsigned int  seq;
+  long          step = stepSeconds(base);
+  char          body[256];
+  char          dateStr[64];
+  char          path[4096];
+  char          *data;
+  size_t        length;
+  time_t        mtime;
+  struct tm     tmTime;
+  int           drop, result;
+
+  if(*rest == '\0' || strcmp(rest, "state.txt") == 0){
+
+    if(*rest == '\0'){
+      snprintf(path, sizeof(path), "%s", base);
+      return serveListing(fd, path, base, -1, -1, isHead, keepAlive);
+    }
+
+    seq = conf.last;
+  }
+  else {
+
+    root = parseTriplet(rest);
+    parent = (rest[4] != '\0') ? parseTriplet(rest + 4) : -1;
+    file = (parent >= 0 && rest[8] != '\0') ? parseTriplet(rest + 8) : -1;
+
+    if(file < 0){
+      snprintf(path, sizeof(path), "%s%s", base, rest);
+      return serveListing(fd, path, base, root, parent, isHead, keepAlive);
+    }
+
+    seq = (unsigned int) root * 1000000u + (unsigned int) parent * 1000u + (unsigned int) file;
+    if(seq < conf.first || seq > conf.last)
+      return sendResponse(fd, 404, "text/plain", "not found\n", 10, 0, isHead, keepAlive, 0);
+  }
+
+  mtime = BASE_TIME + (time_t) (seq - conf.first) * step;
+
+  if(strstr(rest, ".osc.gz")){
+
+    if(conf.oauthUser && ! hasCookie)
+      return sendResponse(fd, 403, "text/plain", "login cookie required\n", 22, 0, isHead, keepAlive, 0);
+
+    data = changeFile(seq, &length);
+    if(!data)
+      return sendResponse(fd, 500, "text/plain", "no memory\n", 10, 0, isHead, keepAlive, 0);
+
+    drop = (conf.dropRate > 0.0 && (rand_r(rand) % 10000) < (unsigned int) (conf.dropRate * 100.0));
+
+    pthread_mutex_lock(&statsLock);
+    stats.changeFiles++;
+    pthread_mutex_unlock(&statsLock);
+
+    result = sendResponse(fd, 200, "application/x-gzip", data, length, mtime, isHead, keepAlive, drop);
+    free(data);
+
+    return result;
+  }
+
+  gmtime_r(&mtime, &tmTime);
+  strftime(dateStr, sizeof(dateStr), "%a %b %d %H:%M:%S UTC %Y", &tmTime);
+
+  length = (size_t) snprintf(body, sizeof(body), "#%s\nsequenceNumber=%u\n", dateStr, seq);
+
+  strftime(dateStr, sizeof(dateStr), "%Y-%m-%dT%H\\:%M\\:%SZ", &tmTime);
+  length += (size_t) snprintf(body + length, sizeof(body) - length, "timestamp=%s\n", dateStr);
+
+  pthread_mutex_lock(&statsLock);
+  stats.stateFiles++;
+  pthread_mutex_unlock(&statsLock);
+
+  return sendResponse(fd, 200, "text/plain", body, length, mtime, isHead, keepAlive, 0);
+
+} /* END serveTree() **/
+
+/* serveListing(): directory page in planet (Apache "pre") or Geofabrik
+ * (table) style; 'root' and 'parent' are -1 when not in path.
+ *
+ ***************************************************************************/
+
+static int serveListing(int fd, const char *path, const char *base, int root, int parent, int isHead, int keepAlive){
+
+  char          *body = NULL;
+  size_t        length = 0, size = 0;
+  int           isTable;
+  unsigned int  low, high, index, seq;
+  int           isEmpty;
+  time_t        mtime;
+  struct tm     tmTime;
+  char          dateStr[32];
+  char          name[32];
+  const char    *ext[2] = {".osc.gz", ".state.txt"};
+  int           part, result = 0;
+  long          step = stepSeconds(base);
+
+  if(conf.listing == LISTING_OFF)
+
+    return sendResponse(fd, 403, "text/plain", "forbidden\n", 10, 0, isHead, keepAlive, 0);
+
+  isTable = (conf.listing == LISTING_GEOFABRIK || (conf.listing == LISTING_AUTO && isGeofabrik(base)));
+
+  /* entries in this directory: roots, parents or files **/
+  if(root < 0)
+    isEmpty = entryRange(&low, &high, 0, conf.first / 1000000u, conf.last / 1000000u);
+  else if(parent < 0)
+    isEmpty = entryRange(&low, &high, (unsigned long) root * 1000u, conf.first / 1000u, conf.last / 1000u);
+  else
+    isEmpty = entryRange(&low, &high, (unsigned long) root * 1000000u + (unsigned long) parent * 1000u,
+                         conf.first, conf.last);
+
+  if(isEmpty)
+
+    return sendResponse(fd, 404, "text/plain", "not found\n", 10, 0, isHead, keepAlive, 0);
+
+  if(isTable)
+    result = appendFormat(&body, &length, &size,
+                          "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 3.2 Final//EN\">\n<html>\n"
+                          "<head>\n<title>Index of %s</title>\n</head>\n<body>\n<h1>Index of %s</h1>\n"
+                          "<table>\n<tr><th valign=\"top\"><img src=\"/icons/blank.gif\" alt=\"[ICO]\"></th>"
+                          "<th><a href=\"?C=N;O=D\">Name</a></th><th><a href=\"?C=M;O=A\">Last modified</a></th>"
+                          "<th><a href=\"?C=S;O=A\">Size</a></th></tr>\n"
+                          "<tr><td valign=\"top\"><img src=\"/icons/back.gif\" alt=\"[PARENTDIR]\"></td>"
+                          "<td><a href=\"../\">Parent Directory</a></td><td>&nbsp;</td><td align=\"right\">  - </td></tr>\n",
+                          path, path);
+  else
+    result = appendFormat(&body, &length, &size,
+                          "<html>\n<head><title>Index of %s</title></head>\n<body>\n"
+                          "<h1>Index of %s</h1><hr><pre><a href=\"../\">../</a>\n", path, path);
+
+  for(index = low; result == 0 && index <= high; index++){
+
+    if(root >= 0 && parent >= 0){
+
+      seq = (unsigned int) root * 1000000u + (unsigned int) parent * 1000u + index;
+      mtime = BASE_TIME + (time_t) (seq - conf.first) * step;
+      gmtime_r(&mtime, &tmTime);
+
+      for(part = 0; result == 0 && part < 2; part++){
+
+        snprintf(name, sizeof(name), "%03u%s", index, ext[part]);
+
+        if(isTable){
+          strftime(dateStr, sizeof(dateStr), "%Y-%m-%d %H:%M", &tmTime);
+          result = appendFormat(&body, &length, &size,
+                                "<tr><td valign=\"top\"><img src=\"/icons/unknown.gif\" alt=\"[   ]\"></td>"
+                                "<td><a href=\"%s\">%s</a></td><td align=\"right\">%s  </td>"
+                                "<td align=\"right\">%s</td></tr>\n", name, name, dateStr, part ? "113 " : "1.2K");
+        }
+        else {
+          strftime(dateStr, sizeof(dateStr), "%d-%b-%Y %H:%M", &tmTime);
+          result = appendFormat(&body, &length, &size, "<a href=\"%s\">%s</a>%*s%s %8s\n",
+                                name, name, (int) (51 - strlen(name)), "", dateStr, part ? "113" : "1234");
+        }
+      }
+    }
+    else if(isTable)
+      result = appendFormat(&body, &length, &size,
+                            "<tr><td valign=\"top\"><img src=\"/icons/folder.gif\" alt=\"[DIR]\"></td>"
+                            "<td><a href=\"%03u/\">%03u/</a></td><td align=\"right\">2026-10-01 00:00  </td>"
+                            "<td align=\"right\">  - </td></tr>\n", index, index);
+    else
+      result = appendFormat(&body, &length, &size, "<a href=\"%03u/\">%03u/</a>%*s01-Oct-2026 00:00        -\n",
+                            index, index, 47, "");
+  }
+
+  /* state.txt is listed at base **/
+  if(result == 0 && root < 0){
+
+    if(isTable)
+      result = appendFormat(&body, &length, &size,
+                            "<tr><td valign=\"top\"><img src=\"/icons/text.gif\" alt=\"[TXT]\"></td>"
+                            "<td><a href=\"state.txt\">state.txt</a></td><td align=\"right\">2026-10-01 00:00  </td>"
+                            "<td align=\"right\">113 </td></tr>\n");
+    else
+      result = appendFormat(&body, &length, &size, "<a href=\"state.txt\">state.txt</a>%*s01-Oct-2026 00:00      113\n",
+                            42, "");
+  }
+
+  if(result == 0)
+    result = appendFormat(&body, &length, &size, isTable ? "</table>\n</body>\n</html>\n" :
+                                                           "</pre><hr></body>\n</html>\n");
+
+  if(result != 0){
+    free(body);
+    return sendResponse(fd, 500, "text/plain", "no memory\n", 10, 0, isHead, keepAlive, 0);
+  }
+
+  pthread_mutex_lock(&statsLock);
+  stats.listings++;
+  pthread_mutex_unlock(&statsLock);
+
+  result = sendResponse(fd, 200, "text/html", body, length, BASE_TIME, isHead, keepAlive, 0);
+  free(body);
+
+  return result;
+
+} /* END serveListing() **/
+
+/* isLoginPath(): paths served with --oauth; query string is not matched **/
+
+static int isLoginPath(const char *path){
+
+  const char  *names[] = {"/get_cookie", "/login", "/oauth2/authorize", "/logout", NULL};
+  size_t      length = strcspn(path, "?");
+  int         index;
+
+  for(index = 0; names[index]; index++)
+    if(length == strlen(names[index]) && strncmp(path, names[index], length) == 0)
+      return 1;
+
+  return 0;
+
+} /* END isLoginPath() **/
+
+/* serveLogin(): stand-in OSM login server and Geofabrik cookie consumer;
+ * checks what getCookieFile() sends at each step and answers as those
+ * servers do. Fields are in query string or POST 'form'. Session, state
+ * and code are fixed strings, so nothing is kept between requests.
+ *
+ ***************************************************************************/
+
+static int serveLogin(int fd, const char *head, const char *path, const char *form, int isPost, int keepAlive){
+
+  char        host[256];
+  char        cookie[1024];
+  char        field[1024];
+  char        redirect[1024];
+  char        encoded[1024];
+  char        body[2048];
+  char        extra[2048];
+  char        dateStr[64];
+  const char  *query;
+  const char  *fields;
+  size_t      length;
+  int         loggedIn;
+  time_t      expires;
+  struct tm   tmTime;
+
+  query = strchr(path, '?');
+  query = query ? query + 1 : "";
+
+  if(headerValue(host, sizeof(host), head, "Host") != 0)
+    snprintf(host, sizeof(host), "%s:%d", conf.address, conf.port);
+
+  cookie[0] = '\0';
+  headerValue(cookie, sizeof(cookie), head, "Cookie");
+  loggedIn = (strstr(cookie, OAUTH_LOGGED_IN) != NULL);
+
+  /* consumer: 1) authorization request and 6) cookie **/
+  if(strncmp(path, "/get_cookie", 11) == 0){
+
+    formValue(field, sizeof(field), query, "action");
+
+    if(isPost && strcmp(field, "get_authorization_url") == 0){
+
+      snprintf(redirect, sizeof(redirect), "http://%s/get_cookie?action=get_cookie", host);
+      if(urlEncode(encoded, sizeof(encoded), redirect) != 0)
+        return sendResponse(fd, 500, "text/plain", "host too long\n", 14, 0, 0, keepAlive, 0);
+
+      length = (size_t) snprintf(body, sizeof(body),
+                                 "{\"authorization_url\": \"http://%s/oauth2/authorize?client_id=%s&redirect_uri=%s"
+                                 "&response_type=code&scope=read_prefs&state=%s\", \"state\": \"%s\", "
+                                 "\"redirect_uri\": \"%s\", \"client_id\": \"%s\"}\n",
+                                 host, OAUTH_CLIENT_ID, encoded, OAUTH_STATE, OAUTH_STATE, redirect, OAUTH_CLIENT_ID);
+
+      return sendResponse(fd, 200, "application/json", body, length, 0, 0, keepAlive, 0);
+    }
+
+    if(! isPost && strcmp(field, "get_cookie") == 0 &&
+       formValue(field, sizeof(field), query, "code") == 0 && strcmp(field, OAUTH_CODE) == 0 &&
+       formValue(field, sizeof(field), query, "state") == 0 && strcmp(field, OAUTH_STATE) == 0 &&
+       formValue(field, sizeof(field), query, "format") == 0 && strcmp(field, "http") == 0){
+
+      expires = time(NULL) + OAUTH_COOKIE_DAYS * 24L * 3600L;
+      gmtime_r(&expires, &tmTime);
+      strftime(dateStr, sizeof(dateStr), "%a, %d %b %Y %H:%M:%S GMT", &tmTime);
+
+      /* format parseCookieFile() reads **/
+      length = (size_t) snprintf(body, sizeof(body), "%s; expires=%s; HttpOnly; Path=/; Secure\n",
+                                 OAUTH_COOKIE, dateStr);
+
+      pthread_mutex_lock(&statsLock);
+      stats.logins++;
+      pthread_mutex_unlock(&statsLock);
+
+      return sendResponse(fd, 200, "text/plain", body, length, 0, 0, keepAlive, 0);
+    }
+
+    return sendResponse(fd, 403, "text/plain", "forbidden\n", 10, 0, 0, keepAlive, 0);
+  }
+
+  /* OSM: 2) login page and 3) login; wrong user or password gets page again **/
+  if(strncmp(path, "/login", 6) == 0){
+
+    if(isPost){
+
+      if(! strstr(cookie, OAUTH_SESSION) ||
+         formValue(field, sizeof(field), form, "authenticity_token") != 0 || strcmp(field, OAUTH_CSRF) != 0)
+
+        return sendResponse(fd, 403, "text/plain", "invalid authenticity token\n", 27, 0, 0, keepAlive, 0);
+
+      if(formValue(field, sizeof(field), form, "username") == 0 && strcmp(field, conf.oauthUser) == 0 &&
+         formValue(field, sizeof(field), form, "password") == 0 && strcmp(field, conf.oauthPassword) == 0){
+
+        snprintf(extra, sizeof(extra), "Location: http://%s/\r\nSet-Cookie: %s; path=/; HttpOnly\r\n",
+                 host, OAUTH_LOGGED_IN);
+
+        return sendReply(fd, 302, "text/html", "", 0, 0, 0, keepAlive, 0, extra);
+      }
+    }
+
+    length = (size_t) snprintf(body, sizeof(body),
+                               "<!DOCTYPE html>\n<html>\n<head>\n"
+                               "<meta name=\"csrf-param\" content=\"authenticity_token\" />\n"
+                               "<meta name=\"csrf-token\" content=\"%s\" />\n</head>\n<body>\n"
+                               "<form action=\"/login\" method=\"post\">\n<input name=\"username\" />\n"
+                               "<input name=\"password\" type=\"password\" />\n</form>\n</body>\n</html>\n",
+                               OAUTH_CSRF);
+
+    snprintf(extra, sizeof(extra), "Set-Cookie: %sreplserver-session; path=/; HttpOnly\r\n", OAUTH_SESSION);
+
+    return sendReply(fd, 200, "text/html", body, length, 0, 0, keepAlive, 0, loggedIn ? NULL : extra);
+  }
+
+  /* OSM: 4) authorize page, then its form redirects to consumer **/
+  if(strncmp(path, "/oauth2/authorize", 17) == 0){
+
+    if(! loggedIn){
+      snprintf(extra, sizeof(extra), "Location: http://%s/login\r\n", host);
+      return sendReply(fd, 302, "text/html", "", 0, 0, 0, keepAlive, 0, extra);
+    }
+
+    fields = isPost ? form : query;
+
+    if(formValue(field, sizeof(field), fields, "client_id") != 0 || strcmp(field, OAUTH_CLIENT_ID) != 0 ||
+       formValue(field, sizeof(field), fields, "state") != 0 || strcmp(field, OAUTH_STATE) != 0 ||
+       formValue(redirect, sizeof(redirect), fields, "redirect_uri") != 0 ||
+       (isPost && (formValue(field, sizeof(field), form, "authenticity_token") != 0 ||
+                   strcmp(field, OAUTH_CSRF) != 0)))
+
+      return sendResponse(fd, 400, "text/plain", "invalid authorization request\n", 30, 0, 0, keepAlive, 0);
+
+    if(isPost){
+      snprintf(extra, sizeof(extra), "Location: %s%ccode=%s&state=%s\r\n", redirect,
+               strchr(redirect, '?') ? '&' : '?', OAUTH_CODE, OAUTH_STATE);
+      return sendReply(fd, 302, "text/html", "", 0, 0, 0, keepAlive, 0, extra);
+    }
+
+    length = (size_t) snprintf(body, sizeof(body),
+                               "<!DOCTYPE html>\n<html>\n<head>\n"
+                               "<meta name=\"csrf-token\" content=\"%s\" />\n</head>\n<body>\n"
+                               "<form action=\"/oauth2/authorize\" method=\"post\">\n"
+                               "<input type=\"submit\" name=\"commit\" value=\"Authorize\" />\n"
+                               "</form>\n</body>\n</html>\n", OAUTH_CSRF);
+
+    return sendResponse(fd, 200, "text/html", body, length, 0, 0, keepAlive, 0);
+  }
+
+  /* OSM: 5) logout **/
+  snprintf(extra, sizeof(extra), "Location: http://%s/\r\nSet-Cookie: %s; path=/; HttpOnly\r\n",
+           host, OAUTH_SESSION);
+
+  return sendReply(fd, 302, "text/html", "", 0, 0, 0, keepAlive, 0, extra);
+
+} /* END serveLogin() **/
+
+/* sendResponse(): head then body paced to 'bandwidth'; with 'drop' half of
+ * body is sent and connection is closed - returns non-zero.
+ *
+ ***************************************************************************/
+
+static int sendResponse(int fd, int status, const char *type, const char *body, size_t length,
+                        time_t mtime, int isHead, int keepAlive, int drop){
+
+  return sendReply(fd, status, type, body, length, mtime, isHead, keepAlive, drop, NULL);
+
+} /* END sendResponse() **/
+
+/* sendReply(): sendResponse() with 'extra' header lines, each ending with
+ * "\r\n" - Location and Set-Cookie for --oauth; NULL for none.
+ **********************************************************************/
+
+static int sendReply(int fd, int status, const char *type, const char *body, size_t length,
+                     time_t mtime, int isHead, int keepAlive, int drop, const char *extra){
+
+  char             head[REQUEST_MAX];
+  char             dateStr[64];
+  int              headLength;
+  size_t           sent = 0, toSend, chunk;
+  struct tm        tmTime;
+  struct timespec  start, now;
+  double           elapsed, due;
+  const char       *reason;
+
+  switch(status){
+  case 200: reason = "OK"; break;
+  case 302: reason = "Found"; break;
+  case 400: reason = "Bad Request"; break;
+  case 403: reason = "Forbidden"; break;
+  case 404: reason = "Not Found"; break;
+  case 405: reason = "Method Not Allowed"; break;
+  case 429: reason = "Too Many Requests"; break;
+  case 500: reason = "Internal Server Error"; break;
+  case 502: reason = "Bad Gateway"; break;
+  case 503: reason = "Service Unavailable"; break;
+  case 504: reason = "Gateway Timeout"; break;
+  default:  reason = "Error"; break;
+  }
+
+  if(mtime == 0)
+    mtime = startTime;
+
+  gmtime_r(&mtime, &tmTime);
+  strftime(dateStr, sizeof(dateStr), "%a, %d %b %Y %H:%M:%S GMT", &tmTime);
+
+  headLength = snprintf(head, sizeof(head),
+                        "HTTP/1.1 %d %s\r\nServer: replserver\r\nContent-Type: %s\r\n"
+                        "Content-Length: %lu\r\nLast-Modified: %s\r\n%sConnection: %s\r\n\r\n",
+                        status, reason, type, (unsigned long) length, dateStr, extra ? extra : "",
+                        keepAlive ? "keep-alive" : "close");
+
+  if(headLength < 0 || (size_t) headLength >= sizeof(head))
+    return 1;
+
+  if(sendAll(fd, head, (size_t) headLength) != 0)
+    return 1;
+
+  toSend = isHead ? 0 : (drop ? length / 2 : length);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  while(sent < toSend){
+
+    chunk = (toSend - sent < SEND_CHUNK) ? toSend - sent : SEND_CHUNK;
+
+    if(sendAll(fd, body + sent, chunk) != 0){
+      countStatus(status, (long long) sent);
+      return 1;
+    }
+
+    sent += chunk;
+
+    if(conf.bandwidth){
+
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      elapsed = (double) (now.tv_sec - start.tv_sec) + (double) (now.tv_nsec - start.tv_nsec) / 1e9;
+      due = (double) sent / (double) conf.bandwidth;
+
+      if(due > elapsed)
+        usleep((useconds_t) ((due - elapsed) * 1e6));
+    }
+  }
+
+  countStatus(status, (long long) sent);
+
+  if(drop){
+
+    pthread_mutex_lock(&statsLock);
+    stats.dropped++;
+    pthread_mutex_unlock(&statsLock);
+
+    return 1;
+  }
+
+  return keepAlive ? 0 : 1;
+
+} /* END sendReply() **/
+
+static int sendAll(int fd, const char *data, size_t size){
+
+  ssize_t  sent;
+
+  while(size){
+
+    sent = send(fd, data, size, MSG_NOSIGNAL);
+    if(sent < 0 && errno == EINTR)
+      continue;
+
+    if(sent <= 0)
+      return 1;
+
+    data += sent;
+    size -= (size_t) sent;
+  }
+
+  return 0;
+
+} /* END sendAll() **/
+
+/* splitPath(): 'base' is shortest path prefix - not ending in a triplet -
+ * with rest in tree form; see top of file. Returns non-zero on no match.
+ *
+ ***************************************************************************/
+
+static int splitPath(const char *path, char *base, size_t size, const char **rest){
+
+  const char  *slash, *tail;
+  int         isMatch;
+
+  for(slash = strchr(path, '/'); slash; slash = strchr(slash + 1, '/')){
+
+    tail = slash + 1;
+
+    /* base must not end with a triplet directory **/
+    if(slash - path >= 4 && slash[-4] == '/' && parseTriplet(slash - 3) >= 0)
+      continue;
+
+    isMatch = (*tail == '\0' || strcmp(tail, "state.txt") == 0);
+
+    if(! isMatch && parseTriplet(tail) >= 0 && tail[3] == '/'){
+
+      if(tail[4] == '\0')
+        isMatch = 1;
+
+      else if(parseTriplet(tail + 4) >= 0 && tail[7] == '/'){
+
+        if(tail[8] == '\0')
+          isMatch = 1;
+        else if(parseTriplet(tail + 8) >= 0 &&
+                (strcmp(tail + 11, ".osc.gz") == 0 || strcmp(tail + 11, ".state.txt") == 0))
+          isMatch = 1;
+      }
+    }
+
+    if(isMatch){
+
+      if((size_t) (tail - path) >= size)
+        return 1;
+
+      memcpy(base, path, (size_t) (tail - path));
+      base[tail - path] = '\0';
+      *rest = tail;
+
+      return 0;
+    }
+  }
+
+  return 1;
+
+} /* END splitPath() **/
+
+/* parseTriplet(): "NNN" at 'str' as number; -1 when not three digits **/
+
+static int parseTriplet(const char *str){
+
+  if(! (isdigit((unsigned char) str[0]) && isdigit((unsigned char) str[1]) &&
+        isdigit((unsigned char) str[2])))
+    return -1;
+
+  return (str[0] - '0') * 100 + (str[1] - '0') * 10 + (str[2] - '0');
+
+} /* END parseTriplet() **/
+
+/* entryRange(): entries 'low' to 'high' - 0 to 999 - of directory holding
+ * 'start' to 'start + 999' that fall in 'lo' to 'hi'; non-zero when none.
+ **/
+
+static int entryRange(unsigned int *low, unsigned int *high, unsigned long start, unsigned long lo, unsigned long hi){
+
+  unsigned long  from, to;
+
+  from = (lo > start) ? lo : start;
+  to = (hi < start + 999u) ? hi : start + 999u;
+
+  if(from > to)
+    return 1;
+
+  *low = (unsigned int) (from - start);
+  *high = (unsigned int) (to - start);
+
+  return 0;
+
+} /* END entryRange() **/
+
+static long stepSeconds(const char *base){
+
+  if(isGeofabrik(base) || strstr(base, "/day/"))
+    return 86400L;
+
+  if(strstr(base, "/hour/"))
+    return 3600L;
+
+  return 60L;
+
+} /* END stepSeconds() **/
+
+static int isGeofabrik(const char *base){
+
+  size_t  length = strlen(base);
+
+  return (length >= 9 && strcmp(base + length - 9, "-updates/") == 0);
+
+} /* END isGeofabrik() **/
+
+/* changeFile(): gzip change file for 'seq' from cache; caller frees copy **/
+
+static char *changeFile(unsigned int seq, size_t *length){
+
+  CACHE_SLOT  *slot = &cache[seq % CACHE_SLOTS];
+  char        *data, *copy;
+  size_t      dataLength;
+
+  pthread_mutex_lock(&cacheLock);
+
+  if(slot->data && slot->seq == seq){
+
+    copy = (char *) malloc(slot->length);
+    if(copy){
+      memcpy(copy, slot->data, slot->length);
+      *length = slot->length;
+    }
+
+    pthread_mutex_unlock(&cacheLock);
+
+    return copy;
+  }
+
+  pthread_mutex_unlock(&cacheLock);
+
+  data = makeChangeFile(seq, &dataLength);
+  if(!data)
+    return NULL;
+
+  copy = (char *) malloc(dataLength);
+
+  pthread_mutex_lock(&cacheLock);
+
+  if(copy){
+    memcpy(copy, data, dataLength);
+    free(slot->data);
+    slot->data = copy;
+    slot->seq = seq;
+    slot->length = dataLength;
+  }
+
+  pthread_mutex_unlock(&cacheLock);
+
+  *length = dataLength;
+
+  return data;
+
+} /* END changeFile() **/
+
+/* makeChangeFile(): osmChange document with one node per line, about
+ * conf.size bytes, compressed with gzip header.
+ *
+ ***************************************************************************/
+
+static char *makeChangeFile(unsigned int seq, size_t *length){
+
+  char      *xml = NULL;
+  size_t    xmlLength = 0, xmlSize = 0;
+  char      *gz;
+  uLong     gzSize;
+  z_stream  stream;
+  long      id;
+  int       result;
+
+  result = appendFormat(&xml, &xmlLength, &xmlSize,
+                        "<?xml version='1.0' encoding='UTF-8'?>\n"
+                        "<osmChange version=\"0.6\" generator=\"replserver\">\n<modify>\n");
+
+  for(id = (long) seq * 100L; result == 0 && (long) xmlLength < conf.size; id++)
+    result = appendFormat(&xml, &xmlLength, &xmlSize,
+                          "  <node id=\"%ld\" version=\"%ld\" timestamp=\"2026-10-01T00:00:00Z\" uid=\"%ld\" "
+                          "user=\"bench\" changeset=\"%u\" lat=\"%.7f\" lon=\"%.7f\"/>\n",
+                          id, id % 7 + 1, id % 9973, seq, (double) (id % 1800000) / 10000.0 - 90.0,
+                          (double) (id % 3600000) / 10000.0 - 180.0);
+
+  if(result == 0)
+    result = appendFormat(&xml, &xmlLength, &xmlSize, "</modify>\n</osmChange>\n");
+
+  if(result != 0){
+    free(xml);
+    return NULL;
+  }
+
+  memset(&stream, 0, sizeof(stream));
+
+  /* 16 + MAX_WBITS: gzip header and trailer **/
+  if(deflateInit2(&stream, 6, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK){
+    free(xml);
+    return NULL;
+  }
+
+  gzSize = deflateBound(&stream, (uLong) xmlLength);
+  gz = (char *) malloc(gzSize);
+
+  if(gz){
+    stream.next_in = (Bytef *) xml;
+    stream.avail_in = (uInt) xmlLength;
+    stream.next_out = (Bytef *) gz;
+    stream.avail_out = (uInt) gzSize;
+
+    if(deflate(&stream, Z_FINISH) != Z_STREAM_END){
+      free(gz);
+      gz = NULL;
+    }
+    else
+      *length = (size_t) stream.total_out;
+  }
+
+  deflateEnd(&stream);
+  free(xml);
+
+  return gz;
+
+} /* END makeChangeFile() **/
+
+static int appendFormat(char **buffer, size_t *length, size_t *size, const char *format, ...){
+
+  va_list  args;
+  int      needed;
+  char     *newBuffer;
+  size_t   newSize;
+
+  va_start(args, format);
+  needed = vsnprintf(NULL, 0, format, args);
+  va_end(args);
+
+  if(needed < 0)
+    return 1;
+
+  if(*length + (size_t) needed + 1 > *size){
+
+    newSize = *size ? *size : 4096;
+    while(*length + (size_t) needed + 1 > newSize)
+      newSize *= 2;
+
+    newBuffer = (char *) realloc(*buffer, newSize);
+    if(!newBuffer)
+      return 1;
+
+    *buffer = newBuffer;
+    *size = newSize;
+  }
+
+  va_start(args, format);
+  vsnprintf(*buffer + *length, *size - *length, format, args);
+  va_end(args);
+
+  *length += (size_t) needed;
+
+  return 0;
+
+} /* END appendFormat() **/
+
+static void countStatus(int status, long long bytes){
+
+  pthread_mutex_lock(&statsLock);
+
+  if(status >= 100 && status < 600)
+    stats.status[status / 100]++;
+
+  if(status == 404)
+    stats.notFound++;
+
+  stats.bytes += bytes;
+
+  pthread_mutex_unlock(&statsLock);
+
+  return;
+
+} /* END countStatus() **/
+
+/* writeStats(): "key value" lines; caller holds 'statsLock' **/
+
+static int writeStats(FILE *toFile){
+
+  fprintf(toFile, "requests %ld\n", stats.requests);
+  fprintf(toFile, "head_requests %ld\n", stats.heads);
+  fprintf(toFile, "connections %ld\n", stats.connections);
+  fprintf(toFile, "listings %ld\n", stats.listings);
+  fprintf(toFile, "change_files %ld\n", stats.changeFiles);
+  fprintf(toFile, "state_files %ld\n", stats.stateFiles);
+  fprintf(toFile, "body_bytes %lld\n", stats.bytes);
+  fprintf(toFile, "status_2xx %ld\n", stats.status[2]);
+  fprintf(toFile, "status_4xx %ld\n", stats.status[4]);
+  fprintf(toFile, "status_5xx %ld\n", stats.status[5]);
+  fprintf(toFile, "not_found %ld\n", stats.notFound);
+  fprintf(toFile, "injected_errors %ld\n", stats.errors);
+  fprintf(toFile, "dropped_bodies %ld\n", stats.dropped);
+  fprintf(toFile, "logins %ld\n", stats.logins);
+
+  return 0;
+
+} /* END writeStats() **/
+
+static int isPercent(double *value, const char *arg){
+
+  char  *endPtr;
+
+  *value = strtod(arg, &endPtr);
+
+  return (endPtr != arg && *endPtr == '\0' && *value >= 0.0 && *value <= 100.0);
+
+} /* END isPercent() **/
+
+/* headerValue(): value of header 'name' in request 'head'; 0 when found **/
+
+static int headerValue(char *dst, size_t size, const char *head, const char *name){
+
+  char        pattern[64];
+  const char  *start;
+  size_t      length;
+
+  snprintf(pattern, sizeof(pattern), "\r\n%s:", name);
+
+  start = strcasestr(head, pattern);
+  if(!start)
+    return 1;
+
+  start += strlen(pattern);
+  start += strspn(start, " \t");
+
+  length = strcspn(start, "\r\n");
+  if(length >= size)
+    return 1;
+
+  memcpy(dst, start, length);
+  dst[length] = '\0';
+
+  return 0;
+
+} /* END headerValue() **/
+
+/* formValue(): decoded value of 'name' in "a=1&b=2" query or form; 0 when
+ * found, else 'dst' is empty string.
+ **********************************************************************/
+
+static int formValue(char *dst, size_t size, const char *form, const char *name){
+
+  size_t        nameLength = strlen(name);
+  size_t        length = 0;
+  const char    *ptr = form;
+  unsigned int  hex;
+
+  dst[0] = '\0';
+
+  while(ptr && *ptr){
+
+    if(strncmp(ptr, name, nameLength) == 0 && ptr[nameLength] == '='){
+
+      for(ptr += nameLength + 1; *ptr && *ptr != '&'; length++){
+
+        if(length + 1 >= size){
+          dst[0] = '\0';
+          return 1;
+        }
+
+        if(*ptr == '%' && isxdigit((unsigned char) ptr[1]) && isxdigit((unsigned char) ptr[2])){
+          sscanf(ptr + 1, "%2x", &hex);
+          dst[length] = (char) hex;
+          ptr += 3;
+        }
+        else {
+          dst[length] = (*ptr == '+') ? ' ' : *ptr;
+          ptr++;
+        }
+      }
+
+      dst[length] = '\0';
+
+      return 0;
+    }
+
+    ptr = strchr(ptr, '&');
+    if(ptr)
+      ptr++;
+  }
+
+  return 1;
+
+} /* END formValue() **/
+
+/* urlEncode(): 'src' percent encoded but for unreserved characters **/
+
+static int urlEncode(char *dst, size_t size, const char *src){
+
+  size_t  length = 0;
+
+  for(; *src; src++){
+
+    if(length + 4 > size)
+      return 1;
+
+    if(isalnum((unsigned char) *src) || strchr("-._~", *src))
+      dst[length++] = *src;
+    else
+      length += (size_t) sprintf(dst + length, "%%%02X", (unsigned char) *src);
+  }
+
+  dst[length] = '\0';
+
+  return 0;
+
+} /* END urlEncode() **/
@@ -11,8 +11,6 @@
 
 #include <time.h>
 
-extern int fd2Close;
-
 extern int serverResponse;
 
 /* user may set cookieLogFP for progress/error logging **/
@@ -21,11 +19,36 @@ extern FILE *cookieLogFP;
 /* geofabrik cookie file has only one single line - they may change this format */
 #define MAX_COOKIE_LINES 1
 
+/* OSM OAuth login for the cookie; getCookieFile() in cookie.c. Default
+ * servers; LOGIN_HOST and CONSUMER_URL configuration keys override them at
+ * run time, e.g. for stand-in servers from "bench/replserver --oauth":
+ *   LOGIN_HOST   http://127.0.0.1:8080
+ *   CONSUMER_URL http://127.0.0.1:8080/get_cookie
+ **************************************************************************/
+#ifndef OSM_LOGIN_HOST
+#define OSM_LOGIN_HOST       "https://www.openstreetmap.org"
+#endif
+
+#ifndef COOKIE_CONSUMER_URL
+#define COOKIE_CONSUMER_URL  "https://osm-internal.download.geofabrik.de/get_cookie"
+#endif
+
+#define COOKIE_USER_AGENT    "getdiff/" VERSION
+
+/* cookie cache; one cookie file for each OSM user shared by all instances,
+ * default {HOME}/.cache/getdiff/ or COOKIE_CACHE key / --cookie-cache DIR.
+ **************************************************************************/
+#define COOKIE_CACHE_PARENT   ".cache"
+#define COOKIE_CACHE_ENTRY    "getdiff"
+
+#define COOKIE_EXPIRE_AHEAD   (2 * 60 * 60)   /* renew at start; as isExpiredCookie() **/
+#define COOKIE_REFRESH_AHEAD  (6 * 60 * 60)   /* background renewal before expiry **/
+#define COOKIE_RETRY_SECONDS  (5 * 60)
+
 typedef struct COOKIE_FILES_{
 
   char *cookieFile;
-  char *scriptFile;
-  char *jsonFile;
+  char *lockFile;     /* flock()ed while cookie is checked and renewed **/
 
 } COOKIE_FILES;
 
@@ -56,7 +79,9 @@ typedef struct	COOKIE_ {
 
 } COOKIE;
 
-int cookieSetFilenames(COOKIE_FILES *cfiles, SKELETON *dirs);
+int cookieSetFilenames(COOKIE_FILES *cfiles, MY_SETTING *settings);
+
+void zapCookieFiles(COOKIE_FILES *cfiles);
 
 //int getCookieFile (SETTINGS *settings);
 
@@ -81,10 +106,6 @@ int isExpiredCookie(COOKIE *ck);
 
 int removeFiles (COOKIE_FILES *cfiles);
 
-int pipeSpawnScript (const char *prog, char * const argList[], char **outputString);
-
-int getResponseCode (int *code, char *msg);
-
 //void logUnseen(SETTINGS *settings, char *msg, char *lastPart);
 
 //int getCookieRetry (SETTINGS *settings);
@@ -93,6 +114,12 @@ int getResponseCode (int *code, char *msg);
 
 int doCookie(MY_SETTING *settings, SKELETON *dirs);
 
+int startCookieRefresh(MY_SETTING *settings);
+
+int cookieTokenChanged(char **token);
+
+void stopCookieRefresh(void);
+
 char *getCookieToken();
 
 void destroyCookie();
@@ -0,0 +1,23 @@
+/*
+ * crc32.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CRC32_H_
+#define CRC32_H_
+
+#include <stddef.h>
+
+/* gzip CRC32 (reflected polynomial 0xEDB88320); same value as zlib crc32().
+ * start with crc = 0 and feed data in any number of pieces.
+ *
+ * uses carry-less multiply (PCLMULQDQ) folding on x86-64 when CPU has it,
+ * else slicing-by-8 tables.
+ ************************************************************************/
+
+unsigned int crc32Update(unsigned int crc, const unsigned char *buf, size_t len);
+
+const char *crc32Method(void);
+
+#endif /* CRC32_H_ **/
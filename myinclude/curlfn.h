@@ -97,7 +97,7 @@ int download2File(char *filename, CURL *handle, CURLU *parseHandle);
 
 //char *getPrefixCURLU(CURLU *parseUrlHandle);
 
-char *getUrlStringCURLU(const CURLU *parseUrlHandle);
+char *getUrlStringCURLU(CURLU *parseUrlHandle);
 
 int performQuery(MEMORY_STRUCT *dst, char *whichData, CURL *qHandle, CURLU *srvrURL);
 
@@ -109,6 +109,10 @@ int writeLogCurl(FILE *to, char *msg);
 
 int download2FileRetry(char *filename, CURL *handle, CURLU *parseHandle);
 
+int download2Memory(MEMORY_STRUCT *dst, CURL *handle, CURLU *parseHandle);
+
+int download2MemoryRetry(MEMORY_STRUCT *dst, CURL *handle, CURLU *parseHandle);
+
 ZT_EXIT_CODE responseCode2ztCode(long resCode);
 
 MEMORY_STRUCT *initialMS(void);
@@ -9,6 +9,7 @@
 #include <unistd.h>
 
 #include "getdiff.h"
+#include "logger.h"
 
 void fprintPathPart(FILE *file, PATH_PART *pp);
 
@@ -16,6 +17,8 @@ void fprintStateInfo(FILE *toStream, STATE_INFO *si);
 
 int logMessage(FILE *to, char *msg);
 
+int logMessageLevel(FILE *to, LOG_LEVEL level, char *msg);
+
 void fprintSkeleton(FILE *toFP, SKELETON *skl);
 
 void fprintGdFiles(FILE *toFP, GD_FILES *gdfiles);
@@ -0,0 +1,28 @@
+/*
+ * events.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+/* events channel: one NDJSON record per completed change file pair,
+ * written to a named pipe (FIFO) or Unix domain stream socket.
+ *
+ * {"path":"...osc.gz","state":"...state.txt","sequence":N,"timestamp":"...","size":N}
+ *
+ * writes never block downloads; record is dropped when no reader is
+ * connected or reader is not keeping up.
+ ************************************************************************/
+
+/* record fits in one atomic pipe write **/
+#define EVENT_MAX_RECORD  4096
+
+int openEvents(const char *path);
+
+int emitPairEvent(const char *oscFile, const char *stateFile);
+
+void closeEvents(void);
+
+#endif /* EVENTS_H_ **/
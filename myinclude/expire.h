@@ -0,0 +1,42 @@
+/*
+ * expire.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef EXPIRE_H_
+#define EXPIRE_H_
+
+#include <stdint.h>
+
+/* tile expiry list: each downloaded change file is scanned on worker
+ * threads for node locations; web mercator z/x/y tiles touched at zoom
+ * levels MIN to MAX are written - one per line, no duplicates - to
+ * EXPIRE_TILES in source directory when download is done:
+ *
+ *   14/8185/5449
+ *
+ * file is merged with tiles already there; tile server removes it after
+ * expiry. Ways and relations have no location in change files; node cache
+ * - node id to tile, kept in EXPIRE_CACHE in source directory between
+ * runs - gives tiles of their nodes and old tile of moved or deleted node.
+ * Node not changed since cache started has no tile.
+ ************************************************************************/
+
+#define EXPIRE_MAX_ZOOM   20
+#define EXPIRE_CACHE      "expireNodes.cache"
+#define EXPIRE_CACHE_MAX  ((size_t) 1 << 22)   /* nodes; about 128 MB table **/
+
+int string2ZoomRange(int *minZoom, int *maxZoom, const char *string);
+
+int startExpire(int minZoom, int maxZoom, const char *sourceDir);
+
+int isExpiring(void);
+
+int expirePair(const char *oscFile);
+
+int finishExpire(const char *tilesFile);
+
+int lonLat2Tile(uint32_t *x, uint32_t *y, double lon, double lat, int zoom);
+
+#endif /* EXPIRE_H_ **/
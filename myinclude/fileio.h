@@ -32,6 +32,10 @@ int readStartID(char **idString, char *filename);
 
 int writeStartID (char *idStr, char *filename);
 
+int commitFile(const char *partName, const char *name);
+
+int writeAll(int fd, const void *buffer, size_t size);
+
 int writeNewerFiles(char const *toFile, STRING_LIST *list);
 
 FILE *initialLog(const char *name);
@@ -2,6 +2,7 @@
 #define GD_PRIMITIVES_H_
 
 #include <time.h>
+#include "sequence.h"
 
 typedef struct SKELETON_ {
 
@@ -24,13 +25,37 @@ typedef struct GD_FILES_ { // get differ files
   char *previousSeqFile; // ID; sequence number
   char *prevStateFile;   // member to be removed
   char *newDiffersFile;
+  char *cursorFile;      // consumer cursor for newDiffersFile
   char *rangeFile;
+  char *expireFile;      // tile expiry list
 
   // temporary files
   char *latestStateFile;
 
+  // per-source; work directory or {tree}/.source/, see setSourceFiles()
+  char *sourceDir;
+  char *sourceLockFile;  // {tree}/.lock.getdiff
+  char *sourceTmp;
+  char *journalFile;     // journal.h
+
 } GD_FILES;
 
+/* regional change files; one bit per region in object masks **/
+#define MAX_REGIONS  32
+
+/* command from command line; default is download **/
+typedef enum GD_COMMAND_ {
+
+  CMD_DOWNLOAD = 0,
+  CMD_PENDING,      /* print entries past consumer cursor **/
+  CMD_ACK,          /* advance consumer cursor **/
+  CMD_VERIFY,       /* check local change files tree **/
+  CMD_LOOKUP,       /* sequence numbers that changed an object **/
+  CMD_EXTRACT,      /* write one file from tree or pack to stdout **/
+  CMD_SERVE         /* local replication mirror over HTTP **/
+
+} GD_COMMAND;
+
 typedef struct MY_SETTING_ {
 
   char *source;
@@ -41,12 +66,56 @@ typedef struct MY_SETTING_ {
   char *pswd;
   char *startNumber;
   char *endNumber;
+  char *eventsPath;   /* FIFO or Unix socket for per pair events **/
+  char *streamTarget; /* "-" for stdout or file descriptor number **/
 
   int verbose;
   int newDifferOff;
 
   int textOnly;
 
+  int streamTee;      /* with streamTarget; keep change files on disk too **/
+
+  int merge;          /* merge downloaded change files into one **/
+
+  int zstdMode;       /* ZST_MODE from transcode.h; zero is off **/
+
+  int summary;        /* write summary sidecar for each change file **/
+
+  char *regionArgs[MAX_REGIONS];  /* "NAME=/full/path.poly" **/
+  int  numRegions;
+
+  int expire;         /* write tile expiry list; zoom levels below **/
+  int expireMinZoom;
+  int expireMaxZoom;
+
+  int index;          /* add downloaded change files to object id index **/
+
+  long      retainDays;   /* retention policy for change files tree; zero is off **/
+  long      retainCount;
+  long long retainBytes;
+
+  int pack;           /* pack completed parent directories into pack files **/
+
+  char *storeDir;     /* content store shared by work directories **/
+
+  char *cookieCache;  /* cookie cache directory shared by instances **/
+
+  char *loginHost;    /* OSM login server for cookie; default OSM_LOGIN_HOST **/
+  char *consumerURL;  /* cookie consumer; default COOKIE_CONSUMER_URL **/
+
+  int publicMeta;     /* internal source; metadata from public server **/
+
+  char *logLevel;     /* "error", "warning", "info" or "debug"; see logger.h **/
+
+  char *metricsDir;   /* Prometheus textfile collector directory; see metrics.h **/
+
+  GD_COMMAND command;
+  long       ackCount;
+  char       *lookupObject; /* with CMD_LOOKUP; "way/123" **/
+  char       *extractArg;   /* with CMD_EXTRACT; "4428" or "4428.state.txt" **/
+  char       *serveArg;     /* with CMD_SERVE; "[ADDRESS:]PORT" **/
+
 } MY_SETTING;
 
 typedef struct URL_PARTS_ { // not used?
@@ -57,6 +126,8 @@ typedef struct URL_PARTS_ { // not used?
 
 typedef struct PATH_PART_ {
 
+  SEQ_NUM seqNum;     /* integer key; string members below are formatted from it **/
+
   char sequenceNum[10];
 
   char rootEntry[5];  /* 3 characters (digits) + ending slash character
@@ -89,6 +160,8 @@ int buildDirectories(SKELETON *dir, const char *where);
 
 int setFilenames(GD_FILES *gdFiles, SKELETON *dir);
 
+int setSourceFiles(GD_FILES *gdFiles, const char *treeDir, int isWorkSource);
+
 PATH_PART *initialPathPart(void);
 
 void zapPathPart(void **pathPart);
@@ -15,12 +15,15 @@
 
 /* #define VERSION "0.01.89" **/
 
-#define VERSION "0.01.90"
+/* #define VERSION "0.01.90" **/
+
+#define VERSION "0.01.91"
 
 /* constant strings; I use defines for them **/
 #define WORK_ENTRY         "getdiff"
 #define CONF_NAME          "getdiff.conf"
 
+#define WORK_SOURCE        ".source.getdiff"  /* tree of work directory source; srclock.h **/
 #define LOCK_FILE          ".lock.getdiff"
 #define LOG_NAME           "getdiff.log"
 #define PREV_SEQ_FILE      "previous.seq"
@@ -29,8 +32,11 @@
 #define PREV_STATE_FILE    "previous.state.txt"
 
 #define NEW_DIFFERS        "newerFiles.txt"
+#define NEW_DIFFERS_CURSOR "newerFiles.cursor"  /* consumer position in NEW_DIFFERS **/
 #define RANGE_FILE         "rangeList.txt"
+#define EXPIRE_TILES       "expireTiles.txt"   /* with expire option **/
 #define LATEST_STATE_FILE  "latest.state.txt"
+#define JOURNAL_FILE       "journal.wal"       /* pair commit journal; journal.h **/
 
 #define HTML_EXT            ".html"
 
@@ -44,11 +50,15 @@
 /* TEST_SITE test connection; list? google, osm & geofabrik **/
 #define TEST_SITE          "www.geofabrik.de"
 #define INTERNAL_SERVER    "osm-internal.download.geofabrik.de"
+#define PUBLIC_SERVER      "download.geofabrik.de"
 
 
 /* maximum allowed number of change files to download per invocation **/
 #define MAX_OSC_DOWNLOAD 61
+/* seconds between downloads; make PACE=0 builds without it for benchmarks **/
+#ifndef SLEEP_INTERVAL
 #define SLEEP_INTERVAL 1
+#endif
 
 #ifndef MAX_USER_NAME
 #define MAX_USER_NAME 64
@@ -75,6 +85,18 @@ int isStateFileList(STRING_LIST *list);
 
 int isGoodSequenceString(const char *string);
 
+int isSameSequenceString(const char *first, const char *second);
+
+int runQueueCommand(MY_SETTING *setting);
+
+int runVerifyCommand(MY_SETTING *setting);
+
+int runLookupCommand(MY_SETTING *setting);
+
+int runExtractCommand(MY_SETTING *setting);
+
+int runServeCommand(MY_SETTING *setting);
+
 int myDownload(char *remotePathSuffix, char *localFile);
 
 char *fetchLatestSequence(char *remoteName, char *localDest);
@@ -83,19 +105,19 @@ int areNumsGoodPair(const char *startNum, const char *endNum);
 
 int isRemoteFile(char *remoteSuffix);
 
-int areAdjacentStrings(char *sourceSuffix, char *firstStr, char *secondStr);
-
 int isEndNewer(PATH_PART *startPP, PATH_PART *endPP);
 
 int getDiffersList(STRING_LIST *destList, PATH_PART *startPP, PATH_PART *endPP);
 
 int downloadFilesList(STRING_LIST *completed, STRING_LIST *downloadList, char *localDestPrefix, int textOnly);
 
+int pairDone(const char *oscFile, const char *stateFile);
+
 int getParentPage(STRING_LIST *destList, char *parentSuffix);
 
 int prependGranularity(STRING_LIST **list, char *gString);
 
-int isSourceSupported(char const *source, const CURLU *cParseHandle);
+int isSourceSupported(char const *source, CURLU *cParseHandle);
 
 int isSourceSupported_old(char const *source);
 
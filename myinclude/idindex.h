@@ -0,0 +1,54 @@
+/*
+ * idindex.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef IDINDEX_H_
+#define IDINDEX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "osc.h"
+#include "sequence.h"
+
+/* object id index: maps node, way and relation ids to sequence numbers of
+ * change files that changed them; kept in INDEX_DIR in change files tree.
+ *
+ * each download run writes one segment file - made on worker threads while
+ * next files download. Segment has keys sorted, each key with its sequence
+ * numbers (posting list); keys and sequence numbers are delta encoded as
+ * variable length integers in blocks of INDEX_BLOCK_KEYS keys. Block index
+ * at end of file has first key and offset for each block, lookup does a
+ * binary search on it then reads one block.
+ *
+ * more than INDEX_MAX_SEGMENTS segments: smallest segments are merged.
+ *
+ *   {prefix}/index/00000012.idx
+ *
+ ************************************************************************/
+
+#define INDEX_DIR           "index"
+#define INDEX_EXT           ".idx"
+#define INDEX_BLOCK_KEYS    128
+#define INDEX_MAX_SEGMENTS  8
+
+/* key: id and element type; sorts by id then type **/
+#define INDEX_KEY(type, id)  (((uint64_t) (id) << 2) | (uint64_t) (type))
+#define INDEX_KEY_TYPE(key)  ((OSC_TYPE) ((key) & 3))
+#define INDEX_KEY_ID(key)    ((long long) ((key) >> 2))
+
+int startIndex(const char *prefix);
+
+int isIndexing(void);
+
+int indexPair(const char *oscFile);
+
+int finishIndex(void);
+
+int lookupIndex(SEQ_NUM **seqs, size_t *count, const char *prefix, uint64_t key);
+
+int string2IndexKey(uint64_t *key, const char *string);
+
+#endif /* IDINDEX_H_ **/
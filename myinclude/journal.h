@@ -0,0 +1,50 @@
+/*
+ * journal.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include "sequence.h"
+
+/* pair commit journal: {tree}/.source/journal.wal - one text record per
+ * line, each appended with a single write() then fdatasync():
+ *
+ *   B u|r FIRST LAST   run begins; update or range run with its sequences
+ *   P SEQ              change file and state.txt for SEQ are whole on disk
+ *   L SEQ              pairs to SEQ are in list file, 'previous.seq' moved
+ *   E                  run ended; nothing to resume
+ *
+ * pair files are downloaded to ".part" names, synced then renamed; "P" is
+ * written after that. A run that did not write "E" - crash, SIGTERM or
+ * download failure - is resumed by next run: committed pairs are not
+ * downloaded again and published pairs of same range are skipped.
+ * A partial last line is ignored.
+ ************************************************************************/
+
+#define JOURNAL_BEGIN      'B'
+#define JOURNAL_PAIR       'P'
+#define JOURNAL_PUBLISHED  'L'
+#define JOURNAL_END        'E'
+
+int openJournal(const char *name, int isRange, SEQ_NUM first, SEQ_NUM last);
+
+int isJournalOn(void);
+
+int journalResumed(void);
+
+int isPairCommitted(SEQ_NUM seq);
+
+int isPairPublished(SEQ_NUM seq);
+
+int journalPair(SEQ_NUM seq);
+
+int journalPublished(SEQ_NUM seq);
+
+int endJournal(void);
+
+void closeJournal(void);
+
+#endif /* JOURNAL_H_ **/
@@ -0,0 +1,57 @@
+/*
+ * localsrc.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef LOCALSRC_H_
+#define LOCALSRC_H_
+
+#include "curlfn.h"
+
+/* local source; SOURCE is "file:///dir/" URL or plain "/dir/" path to a
+ * directory laid out as replication directory on server:
+ *
+ *   {dir}/state.txt
+ *   {dir}/NNN/NNN/NNN.osc.gz & NNN.state.txt
+ *
+ * as an rsync'd copy or a mount of a mirror. Last entry of 'dir' tells
+ * granularity as in URL: ".../replication/minute/", ".../{area}-updates/"
+ * or a getdiff tree ".../getdiff/planet/minute/".
+ *
+ * "downloads" become copies; hard link, else reflink, else copy_file_range().
+ * Directory listings are made as HTML pages with pairs only, so getdiff
+ * parses them as it parses server pages. No network, no wait between files
+ * and no limit per run; the rest - validation, newerFiles.txt and
+ * previous.seq - is as for remote source.
+ ************************************************************************/
+
+#define FILE_SCHEME  "file://"
+
+typedef struct LOCAL_REPORT_ {
+
+  long       linked;
+  long       cloned;
+  long       copied;
+  long       listings;
+  long long  bytes;
+
+} LOCAL_REPORT;
+
+int isLocalSource(const char *source);
+
+int isGoodLocalSource(const char *source);
+
+int localSourceURL(char **url, const char *source);
+
+int startLocalSource(const char *sourceURL);
+
+int isLocalSourceOn(void);
+
+int localFetch(const char *pathSuffix, const char *localFile, MEMORY_STRUCT *dst);
+
+int isLocalFile(const char *pathSuffix);
+
+int finishLocalSource(void);
+
+#endif /* LOCALSRC_H_ **/
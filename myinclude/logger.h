@@ -0,0 +1,58 @@
+/*
+ * logger.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef LOGGER_H_
+#define LOGGER_H_
+
+#include <stdio.h>
+
+/* asynchronous log writer: logMessage() puts lines on a lock free ring
+ * buffer; a background thread formats them with a timestamp cached per
+ * second and writes each batch with one fflush(). Lines below the level
+ * set with --log-level are dropped. Ring is drained on exit and on fatal
+ * signals, so nothing queued is lost.
+ *
+ * Anything written straight to the log FILE pointer - list dumps and such -
+ * must call syncLogger() first to keep lines in order.
+ ************************************************************************/
+
+typedef enum LOG_LEVEL_ {
+
+  LOG_ERROR = 0,
+  LOG_WARNING,
+  LOG_INFO,
+  LOG_DEBUG
+
+} LOG_LEVEL;
+
+#define LOG_DEFAULT_LEVEL  LOG_INFO
+
+int string2LogLevel(LOG_LEVEL *level, const char *string);
+
+const char *logLevel2String(LOG_LEVEL level);
+
+LOG_LEVEL messageLevel(const char *msg);
+
+int startLogger(FILE *to, LOG_LEVEL level);
+
+int isLoggerFor(FILE *to);
+
+int isLevelLogged(LOG_LEVEL level);
+
+int queueLogLine(LOG_LEVEL level, int kind, const char *msg);
+
+void syncLogger(void);
+
+void stopLogger(void);
+
+int writeLogLine(FILE *to, int kind, const char *msg);
+
+/* kind argument for queueLogLine() **/
+#define LOG_LINE   0
+#define LOG_START  1
+#define LOG_DONE   2
+
+#endif /* LOGGER_H_ */
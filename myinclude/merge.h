@@ -0,0 +1,39 @@
+/*
+ * merge.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MERGE_H_
+#define MERGE_H_
+
+#include "sequence.h"
+
+#ifndef DLIST_H_
+#include "list.h"
+#endif
+
+/* merge: many change files into one; for each object - node, way or
+ * relation id - only its last version is kept with its action.
+ * Output is sorted: nodes, ways then relations, each by id.
+ *
+ * memory is bounded by MERGE_MEM_LIMIT; past that, sorted runs are written
+ * to temporary files and merged at the end (external sort).
+ ************************************************************************/
+
+#ifndef MERGE_MEM_LIMIT
+#define MERGE_MEM_LIMIT   (64L * 1024L * 1024L)
+#endif
+
+/* open run files at most; more are merged into one larger run **/
+#ifndef MERGE_MAX_RUNS
+#define MERGE_MAX_RUNS    256
+#endif
+
+#define MERGED_DIR        "merged"
+
+int mergeChangeFiles(const char *destFile, STRING_LIST *oscFiles, const char *tmpDir);
+
+int writeMergedState(const char *destFile, const char *lastStateFile, SEQ_NUM first, SEQ_NUM last);
+
+#endif /* MERGE_H_ **/
@@ -0,0 +1,55 @@
+/*
+ * metrics.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+/* Prometheus textfile metrics: with --metrics DIR each run writes
+ * DIR/getdiff-{tree}.prom - "getdiff-planet-minute.prom" - for node
+ * exporter textfile collector; temporary file then rename(), so collector
+ * never reads a partial file. Written at end of run and every
+ * METRICS_INTERVAL seconds while files are downloaded.
+ *
+ * Counters - files, bytes, requests and retries by response code, runs,
+ * freshness lag histogram - carry on from file left by last run; gauges
+ * are for this run: phase durations, latest local sequence and timestamp.
+ *
+ * All calls are no-op until startMetrics() succeeds.
+ ************************************************************************/
+
+#define METRICS_INTERVAL  60
+
+typedef enum METRICS_PHASE_ {
+
+  METRICS_SETUP = 0,   /* start to latest state.txt fetch **/
+  METRICS_LATEST,      /* latest state.txt from remote **/
+  METRICS_LIST,        /* directory listings; files to download **/
+  METRICS_DOWNLOAD,    /* change files and state.txt files **/
+  METRICS_FINISH,      /* list files, post processing, cleanup **/
+
+  METRICS_PHASES
+
+} METRICS_PHASE;
+
+int startMetrics(const char *dir, const char *treeDir, const char *workDir);
+
+int isMetricsOn(void);
+
+void metricsPhase(METRICS_PHASE phase);
+
+void metricsRequest(long code, long long bytes);
+
+void metricsRetry(long code);
+
+void metricsFile(long long bytes);
+
+void metricsState(const char *stateFile);
+
+void metricsTick(void);
+
+int finishMetrics(int result);
+
+#endif /* METRICS_H_ **/
@@ -0,0 +1,92 @@
+/*
+ * osc.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef OSC_H_
+#define OSC_H_
+
+#include <stddef.h>
+#include <zlib.h>
+
+/* streaming reader for osmChange files (.osc.gz); one element - node, way
+ * or relation - at a time with its action, nothing else is kept in memory.
+ *
+ *   reader = oscOpen(filename);
+ *   while((result = oscNext(reader, &element)) == ztSuccess){ ... }
+ *   oscClose(&reader);  // result is ztEndOfFile when all is read
+ *
+ ************************************************************************/
+
+typedef enum OSC_ACTION_ {
+
+  OSC_NO_ACTION = 0,
+  OSC_CREATE,
+  OSC_MODIFY,
+  OSC_DELETE
+
+} OSC_ACTION;
+
+/* order is output order in merged files **/
+typedef enum OSC_TYPE_ {
+
+  OSC_NODE = 0,
+  OSC_WAY,
+  OSC_RELATION
+
+} OSC_TYPE;
+
+typedef struct OSC_ELEMENT_ {
+
+  OSC_TYPE    type;
+  OSC_ACTION  action;
+  long long   id;
+  long        version;
+
+  int         hasLocation;  /* node with lat & lon; deleted nodes may have none **/
+  double      lat;
+  double      lon;
+
+  char        *text;    /* whole element from start tag to end tag; owned by reader,
+                           good until next oscNext() call **/
+  size_t      length;
+
+} OSC_ELEMENT;
+
+#define OSC_IN_BUFFER  (64 * 1024)
+
+typedef struct OSC_READER_ {
+
+  gzFile         gz;
+
+  unsigned char  in[OSC_IN_BUFFER];
+  size_t         inPos;
+  size_t         inLen;
+  int            eof;
+
+  char           *tag;      /* current tag "<...>" **/
+  size_t         tagLen;
+  size_t         tagSize;
+
+  char           *elem;     /* current element text **/
+  size_t         elemLen;
+  size_t         elemSize;
+
+  OSC_ACTION     action;
+
+} OSC_READER;
+
+OSC_READER *oscOpen(const char *filename);
+
+int oscNext(OSC_READER *reader, OSC_ELEMENT *element);
+
+void oscClose(OSC_READER **reader);
+
+int oscAttribute(const char *tag, const char *name, const char **value, size_t *length);
+
+const char *oscActionName(OSC_ACTION action);
+
+const char *oscTypeName(OSC_TYPE type);
+
+#endif /* OSC_H_ **/
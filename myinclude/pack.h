@@ -0,0 +1,94 @@
+/*
+ * pack.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PACK_H_
+#define PACK_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sequence.h"
+
+/* pack file: one completed parent directory - up to 1000 change files with
+ * their state.txt and sidecar files - in one file next to where directory
+ * was:
+ *
+ *   {prefix}/006/123/000.osc.gz ... 999.state.txt  ->  {prefix}/006/123.pack
+ *
+ *   "GDPACK01"      magic
+ *   members         file bytes as they were on disk, in name order
+ *   index           'count' PACK_ENTRY sorted by name
+ *   PACK_TRAILER    at end of file
+ *
+ * member CRC32 is checked when it is read. Parents are packed only when
+ * every sequence number in them is before 'bound' - downloaded and consumed
+ * by updater; recent directories stay loose files. Pack file modification
+ * time is that of its newest member.
+ ************************************************************************/
+
+#define PACK_EXT          ".pack"
+#define PACK_MAGIC        "GDPACK01"
+#define PACK_NAME_SIZE    32
+#define PACK_MAX_PARENTS  100   /* per run **/
+
+typedef struct PACK_ENTRY_ {
+
+  char      name[PACK_NAME_SIZE];  /* "456.osc.gz" **/
+  uint64_t  offset;
+  uint64_t  length;
+  int64_t   mtime;
+  uint32_t  crc;
+  uint32_t  reserved;
+
+} PACK_ENTRY;
+
+typedef struct PACK_TRAILER_ {
+
+  uint64_t  indexOffset;
+  uint32_t  count;         /* index entries **/
+  uint32_t  base;          /* first sequence number in parent **/
+  uint32_t  changeCount;   /* change files in pack **/
+  uint32_t  reserved;
+  char      magic[8];
+
+} PACK_TRAILER;
+
+typedef struct PACK_FILE_ {
+
+  int           fd;
+  PACK_TRAILER  trailer;
+  PACK_ENTRY    *entries;
+
+} PACK_FILE;
+
+typedef struct PACK_REPORT_ {
+
+  long       parents;   /* packed this run **/
+  long       files;
+  long long  bytes;
+  int        more;      /* stopped at PACK_MAX_PARENTS **/
+
+} PACK_REPORT;
+
+int packTree(PACK_REPORT *report, const char *prefix, SEQ_NUM bound);
+
+int packParent(const char *parentDir, const char *packFile, SEQ_NUM base, long *files, long long *bytes);
+
+PACK_FILE *packOpen(const char *packFile);
+
+void packClose(PACK_FILE **pack);
+
+const PACK_ENTRY *packFind(const PACK_FILE *pack, const char *name);
+
+int packCopy(const PACK_FILE *pack, const PACK_ENTRY *entry, int outFD);
+
+int packCheck(const PACK_FILE *pack, const PACK_ENTRY *entry);
+
+int packFileName(char *buffer, size_t size, const char *prefix, SEQ_NUM seq);
+
+int extractMember(const char *prefix, SEQ_NUM seq, const char *ext, int outFD);
+
+#endif /* PACK_H_ **/
@@ -0,0 +1,50 @@
+/*
+ * queue.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef QUEUE_H_
+#define QUEUE_H_
+
+#include <sys/types.h>
+
+#ifndef DLIST_H_
+#include "list.h"
+#endif
+
+/* queue file: append only text file, one entry per line; getdiff is the
+ * only producer. Consumer progress is kept in separate cursor file as
+ * "<byte offset> <inode> <first line CRC32>" so consumers never delete or
+ * rewrite queue file. Inode and first line tell a replaced queue file;
+ * a new file may get the old inode number, its first entry is different.
+ * Cursor written without CRC - two fields - is still read.
+ **************************************************************************/
+
+/* consumed bytes at queue file start before producer compacts it **/
+#ifndef QUEUE_COMPACT_SIZE
+#define QUEUE_COMPACT_SIZE  (1024L * 1024L)
+#endif
+
+typedef struct QUEUE_CURSOR_ {
+
+  off_t  offset;  /* first byte not yet consumed **/
+  ino_t  inode;   /* queue file inode when cursor was written; 0 unknown **/
+  unsigned int  first;  /* CRC32 of queue file first line; 0 unknown **/
+
+} QUEUE_CURSOR;
+
+int queueAppend(const char *queueFile, STRING_LIST *list);
+
+int queueReadCursor(QUEUE_CURSOR *cursor, const char *cursorFile);
+
+int queueWriteCursor(const char *cursorFile, const QUEUE_CURSOR *cursor);
+
+int queuePending(STRING_LIST *pending, QUEUE_CURSOR *next,
+                 const char *queueFile, const char *cursorFile);
+
+int queueAck(const char *queueFile, const char *cursorFile, long count);
+
+int queueCompact(const char *queueFile, const char *cursorFile);
+
+#endif /* QUEUE_H_ **/
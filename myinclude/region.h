@@ -0,0 +1,82 @@
+/*
+ * region.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef REGION_H_
+#define REGION_H_
+
+#include <stdint.h>
+#include "gd_primitives.h"
+
+/* regional change files from one larger feed.
+ *
+ * each region is a name and an Osmosis polygon (.poly) file; regions are
+ * set with --region NAME=FILE. Each downloaded change file is filtered in
+ * sequence order into one change file per region, same sequence number:
+ *
+ *   {workDir}/regions/{name}/NNN/NNN/NNN.osc.gz & NNN.state.txt
+ *   {workDir}/regions/{name}/state.txt        latest, as on a server
+ *
+ * node goes to region its location is in - old and new location for a
+ * moved node. Way goes to regions of its nodes, relation to regions of its
+ * members. Locations are not in change files for unchanged nodes, so a
+ * compact cache maps (type, id) to region bit mask and is kept between runs
+ * in {workDir}/regions/objects.cache; only objects in some region are kept.
+ ************************************************************************/
+
+#define REGIONS_DIR       "regions"
+#define REGION_CACHE      "objects.cache"
+#define REGIONS_LOCK      ".lock.regions"   /* in work directory; one writer **/
+#define REGION_NAME_MAX   64
+
+typedef struct POLY_RING_ {
+
+  double  *lon;
+  double  *lat;
+  int     count;
+
+} POLY_RING;
+
+typedef struct REGION_ {
+
+  char       name[REGION_NAME_MAX + 1];
+  POLY_RING  *rings;
+  int        numRings;
+  double     minLon, minLat, maxLon, maxLat;
+
+} REGION;
+
+/* open addressing (type, id) -> mask table **/
+typedef struct REGION_CACHE_ {
+
+  uint64_t  *keys;   /* zero is empty slot **/
+  uint32_t  *masks;
+  size_t    size;    /* power of two **/
+  size_t    count;
+
+} REGION_CACHE_TABLE;
+
+typedef struct REGION_SET_ {
+
+  REGION              regions[MAX_REGIONS];
+  int                 numRegions;
+  char                *regionsDir;
+  REGION_CACHE_TABLE  cache;
+
+} REGION_SET;
+
+int isGoodRegionName(const char *name);
+
+REGION_SET *initialRegionSet(char **regionArgs, int numRegions, const char *workDir);
+
+int filterChangeFile(REGION_SET *set, const char *oscFile, const char *stateFile, const char *pathSuffix);
+
+int closeRegionSet(REGION_SET **set);
+
+int readPolyFile(REGION *region, const char *polyFile);
+
+int pointInRegion(const REGION *region, double lat, double lon);
+
+#endif /* REGION_H_ **/
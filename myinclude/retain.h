@@ -0,0 +1,64 @@
+/*
+ * retain.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RETAIN_H_
+#define RETAIN_H_
+
+#include "sequence.h"
+
+/* retention for change files tree: oldest change files - with their
+ * state.txt and sidecar files - are removed while any policy is over its
+ * limit; emptied NNN/NNN directories are removed too.
+ *
+ *   days    change file downloaded more than 'maxDays' days ago
+ *   count   tree has more than 'maxCount' change files
+ *   bytes   tree is over 'maxBytes' bytes
+ *
+ * files at or after 'bound' sequence are never removed; caller sets it to
+ * first entry updater has not consumed from newerFiles.txt - or last
+ * downloaded sequence if that is older. Runs on its own thread next to
+ * downloads; at most RETAIN_MAX_PAIRS are removed per run, rest is left
+ * for next run.
+ ************************************************************************/
+
+#define RETAIN_MAX_PAIRS  20000
+
+typedef struct RETAIN_POLICY_ {
+
+  long       maxDays;    /* zero is no limit for all three **/
+  long       maxCount;
+  long long  maxBytes;
+
+} RETAIN_POLICY;
+
+typedef struct RETAIN_REPORT_ {
+
+  SEQ_NUM    bound;
+  long       pairs;         /* change files in tree before removal **/
+  long long  bytes;         /* with maxBytes only **/
+  long       removedPairs;
+  long       removedFiles;
+  long long  removedBytes;
+  long       removedDirs;
+  int        more;          /* stopped at RETAIN_MAX_PAIRS **/
+
+} RETAIN_REPORT;
+
+#define RETAIN_POLICY_SET(p)  ((p)->maxDays || (p)->maxCount || (p)->maxBytes)
+
+int string2Bytes(long long *bytes, const char *string);
+
+int consumerFloor(SEQ_NUM *floor, const char *queueFile, const char *cursorFile);
+
+int startRetention(const char *prefix, const RETAIN_POLICY *policy, SEQ_NUM bound);
+
+int isRetaining(void);
+
+int finishRetention(void);
+
+int runRetention(RETAIN_REPORT *report, const char *prefix, const RETAIN_POLICY *policy, SEQ_NUM bound);
+
+#endif /* RETAIN_H_ **/
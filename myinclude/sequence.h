@@ -0,0 +1,54 @@
+/*
+ * sequence.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SEQUENCE_H_
+#define SEQUENCE_H_
+
+#include <stddef.h>
+
+/* sequence number as integer; replication sequence numbers are at most
+ * 9 digits - they map into /NNN/NNN/NNN paths. **/
+typedef unsigned int SEQ_NUM;
+
+#define SEQ_NONE      ((SEQ_NUM) 0)
+#define SEQ_MIN       ((SEQ_NUM) 100)        /* 3 digits; had to go back to day/2014 **/
+#define SEQ_MAX       ((SEQ_NUM) 999999999)  /* 9 digits **/
+
+#define SEQ_PER_DIR   1000  /* files per parent, parents per root **/
+
+/* root, parent & file components - each 0 to 999 **/
+#define SEQ_ROOT(seq)       ((seq) / 1000000)
+#define SEQ_PARENT(seq)     (((seq) / 1000) % 1000)
+#define SEQ_FILE(seq)       ((seq) % 1000)
+
+/* parent key: (root * 1000 + parent); unique parent directory number **/
+#define SEQ_PARENT_KEY(seq) ((seq) / 1000)
+
+/* buffer sizes including terminating null character **/
+#define SEQ_STR_SIZE    10  /* "999999999" **/
+#define SEQ_PATH_SIZE   13  /* "/NNN/NNN/NNN" **/
+
+int string2Sequence(SEQ_NUM *seq, const char *string);
+
+int isGoodSequence(SEQ_NUM seq);
+
+int sequence2String(char *buffer, size_t size, SEQ_NUM seq);
+
+void sequence2Path(char *buffer, SEQ_NUM seq);
+
+void sequence2Entries(char *rootEntry, char *parentEntry, char *fileEntry, SEQ_NUM seq);
+
+int path2Sequence(SEQ_NUM *seq, const char *path);
+
+int leadTriplet(const char *name);
+
+int triplet(const char *name);
+
+int areSameRoot(SEQ_NUM first, SEQ_NUM second);
+
+int areAdjacentParents(SEQ_NUM first, SEQ_NUM second);
+
+#endif /* SEQUENCE_H_ **/
@@ -0,0 +1,56 @@
+/*
+ * serve.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SERVE_H_
+#define SERVE_H_
+
+/* local replication mirror; minimal HTTP/1.1 server for change files tree
+ * in work directory. Each tree is mounted under upstream server name and
+ * path, so mirror URL is upstream URL with mirror in front:
+ *
+ *   http://mirror:8080/planet.openstreetmap.org/replication/minute/
+ *   http://mirror:8080/download.geofabrik.de/europe/germany-updates/
+ *
+ * below each mount, layout is that of upstream replication directory:
+ *
+ *   state.txt              newest complete pair in tree
+ *   NNN/ NNN/NNN/          HTML listings with anchors; as parseAnchor() reads
+ *   NNN/NNN/NNN.osc.gz     change file; sent with sendfile()
+ *   NNN/NNN/NNN.state.txt  its state file
+ *
+ * files in pack files are sent from pack after CRC check. Only GET and HEAD
+ * with names above are served; nothing else in work directory is reachable.
+ * Server is read only and takes no lock; getdiff downloads next to it.
+ ************************************************************************/
+
+#define SERVE_DEFAULT_ADDRESS  "0.0.0.0"
+#define SERVE_MAX_MOUNTS       4
+#define SERVE_IDLE_SECONDS     5       /* keep alive connection timeout **/
+#define SERVE_HEAD_SIZE        8192    /* request line and headers **/
+
+typedef struct SERVE_MOUNT_ {
+
+  char  *urlPath;     /* "/planet.openstreetmap.org/replication/minute/" **/
+  char  *treeDir;     /* change files tree; prefix from setDiffersDirPrefix() **/
+
+} SERVE_MOUNT;
+
+typedef struct SERVE_REPORT_ {
+
+  long       connections;
+  long       requests;
+  long       files;       /* 200 responses with file body **/
+  long       notFound;
+  long long  bytes;       /* body bytes sent **/
+
+} SERVE_REPORT;
+
+int parseServeAddress(char *address, size_t size, int *port, const char *arg);
+
+int runServer(SERVE_REPORT *report, const char *address, int port,
+              SERVE_MOUNT *mounts, int numMounts, int numThreads, int verbose);
+
+#endif /* SERVE_H_ **/
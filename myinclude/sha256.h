@@ -0,0 +1,39 @@
+/*
+ * sha256.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SHA256_H_
+#define SHA256_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* SHA-256 (FIPS 180-4); feed data in any number of pieces between
+ * sha256Init() and sha256Final(). Hex string is 64 lower case characters.
+ ************************************************************************/
+
+#define SHA256_SIZE      32
+#define SHA256_HEX_SIZE  (2 * SHA256_SIZE + 1)
+
+typedef struct SHA256_CTX_ {
+
+  uint32_t       state[8];
+  uint64_t       length;      /* bytes so far **/
+  unsigned char  block[64];
+  size_t         used;        /* bytes in block **/
+
+} SHA256_CTX;
+
+void sha256Init(SHA256_CTX *ctx);
+
+void sha256Update(SHA256_CTX *ctx, const unsigned char *data, size_t len);
+
+void sha256Final(SHA256_CTX *ctx, unsigned char digest[SHA256_SIZE]);
+
+void sha256Hex(char hex[SHA256_HEX_SIZE], const unsigned char digest[SHA256_SIZE]);
+
+int sha256File(char hex[SHA256_HEX_SIZE], long long *size, const char *fileName);
+
+#endif /* SHA256_H_ **/
@@ -0,0 +1,61 @@
+/*
+ * srclock.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SRCLOCK_H_
+#define SRCLOCK_H_
+
+/* per-source locks; each source - change files tree geofabrik/ or
+ * planet/{minute, hour, day}/ - has its own lock {tree}/.lock.getdiff,
+ * so downloads from different sources run in the same work directory
+ * at the same time. fcntl() record locks are used; they go away with
+ * the process, lock files are never removed.
+ *
+ * Work directory source - named in {workDir}/.source.getdiff - keeps
+ * its files where they always were, in work directory. Any other source
+ * keeps them in {tree}/.source/:
+ *
+ *   previous.seq  newerFiles.txt  newerFiles.cursor  rangeList.txt
+ *   expireTiles.txt  journal.wal  latest.state.txt  tmp/
+ *
+ *   {workDir}/.lock.getdiff   shared by downloads; exclusive for naming
+ *                             work directory source and for old
+ *                             versions - they lock whole work directory.
+ *   source lock byte 0        exclusive; one download for source, holds
+ *                             "progName PID" as getLock() writes it.
+ *   source lock byte 1        tree state; exclusive while download writes
+ *                             a pair, removes or commits, shared by
+ *                             read-only commands: verify, lookup, extract.
+ *
+ * readers wait only for the write in progress; writer waits for readers
+ * which are in before it.
+ ************************************************************************/
+
+#define SOURCE_DIR        ".source"
+
+#define SOURCE_RUN_BYTE    0
+#define SOURCE_STATE_BYTE  1
+
+int lockWorkDir(const char *name);
+
+int isWorkDirExclusive(void);
+
+int shareWorkDir(void);
+
+int lockSource(const char *name);
+
+void unlockSource(void);
+
+void unlockWorkDir(void);
+
+int sourceWriteBegin(void);
+
+void sourceWriteEnd(void);
+
+int lockSourceRead(int *pFD, const char *name);
+
+void unlockSourceRead(int fd);
+
+#endif /* SRCLOCK_H_ **/
@@ -0,0 +1,58 @@
+/*
+ * store.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef STORE_H_
+#define STORE_H_
+
+/* content addressed store shared by work directories:
+ *
+ *   {store}/objects/ab/cdef...   file content named by its SHA-256
+ *   {store}/keys/12/3456...      manifest for one remote file, one line:
+ *                                "SHA256 SIZE KEY"; named by SHA-256 of KEY
+ *
+ * KEY is remote file without scheme, as in
+ * "planet.openstreetmap.org/replication/minute/006/123/456.osc.gz".
+ * Geofabrik INTERNAL and PUBLIC servers share state.txt files; those are
+ * keyed with PUBLIC server name so either source finds the other's.
+ *
+ * after download, file is hashed; when object exists, local file is
+ * replaced by hard link to it, else file is linked into store. Before
+ * download, manifest for KEY is read; when object is there and hashes
+ * right, file is linked from store and not fetched. Where hard link fails -
+ * store on other file system - reflink is tried, then copy.
+ *
+ * objects are never written in place; downloads go to a removed name.
+ *
+ * finishStore() sweeps store: object with one link - no tree has the file
+ * any more - is removed, then manifests whose object is gone.
+ ************************************************************************/
+
+#define STORE_OBJECTS  "objects"
+#define STORE_KEYS     "keys"
+
+typedef struct STORE_REPORT_ {
+
+  long       added;         /* new objects **/
+  long       linked;        /* downloads replaced by link to object **/
+  long       skipped;       /* fetches skipped; file from store **/
+  long long  savedBytes;    /* linked and skipped bytes **/
+  long       removed;       /* objects swept **/
+  long       dropped;       /* manifests swept **/
+  long long  freedBytes;    /* swept object bytes **/
+
+} STORE_REPORT;
+
+int startStore(const char *storeDir, const char *sourceURL);
+
+int isStoring(void);
+
+int storeFetch(const char *pathSuffix, const char *localFile);
+
+int storeAdd(const char *pathSuffix, const char *localFile);
+
+int finishStore(void);
+
+#endif /* STORE_H_ **/
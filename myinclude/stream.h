@@ -0,0 +1,35 @@
+/*
+ * stream.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#include <stddef.h>
+
+/* stream mode: change files are written in sequence order to standard output
+ * or an inherited file descriptor as one concatenated gzip stream; gzip
+ * members may be concatenated, "zcat" and zlib readers see one osmChange
+ * document after another.
+ *
+ * with "-" our standard output is moved to standard error first, so program
+ * messages never mix with stream data.
+ ************************************************************************/
+
+int openStream(const char *target, int tee);
+
+int isStreaming(void);
+
+int isStreamTee(void);
+
+int isGzipComplete(const char *data, size_t size);
+
+int streamWrite(const char *data, size_t size, const char *name);
+
+int memory2File(const char *filename, const char *data, size_t size);
+
+void closeStream(void);
+
+#endif /* STREAM_H_ **/
@@ -0,0 +1,52 @@
+/*
+ * summary.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SUMMARY_H_
+#define SUMMARY_H_
+
+#include "osc.h"
+
+/* summary sidecar: each downloaded change file is read once on worker
+ * threads - while next files download - and a small text file is written
+ * next to it: NNN.osc.gz -> NNN.summary.txt
+ *
+ *   node.create=12        create / modify / delete count per element type
+ *   node.minId=...        smallest and largest id per element type
+ *   changesets=7          distinct changeset ids
+ *   minLat=... maxLon=..  bounding box of nodes with location
+ *
+ * updater can schedule heavy change files without reading them.
+ ************************************************************************/
+
+#define SUMMARY_EXT   ".summary.txt"
+
+typedef struct OSC_SUMMARY_ {
+
+  long       count[3][4];   /* [OSC_TYPE][OSC_ACTION] **/
+  long long  minId[3];
+  long long  maxId[3];
+  long       changesets;
+  int        hasBox;
+  double     minLat;
+  double     minLon;
+  double     maxLat;
+  double     maxLon;
+
+} OSC_SUMMARY;
+
+int startSummary(void);
+
+int isSummarizing(void);
+
+int summaryPair(const char *oscFile);
+
+int finishSummary(void);
+
+int summarizeChangeFile(OSC_SUMMARY *summary, const char *oscFile);
+
+int writeSummaryFile(const char *summaryFile, const OSC_SUMMARY *summary);
+
+#endif /* SUMMARY_H_ **/
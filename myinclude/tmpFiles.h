@@ -1,16 +0,0 @@
-/*
- * tmpFiles.h
- *
- *  Created on: Aug 4, 2023
- *      Author: wael
- */
-
-#ifndef TMP_FILES_H_
-#define TMP_FILES_H_
-
-int writeScript(char *fileName);
-
-int writeJSONfile(char *filename, char *usr, char *pswd);
-
-
-#endif /* TMP_FILES_H_ */
@@ -0,0 +1,48 @@
+/*
+ * transcode.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef TRANSCODE_H_
+#define TRANSCODE_H_
+
+#ifndef DLIST_H_
+#include "list.h"
+#endif
+
+/* zstd transcode stage: each downloaded change file is inflated - which
+ * checks gzip CRC32 and length - and written as zstd ".osc.zst" file.
+ * Work is done on worker threads while next files download.
+ *
+ * requires program built with zstd support: make ZSTD=1
+ ************************************************************************/
+
+#define ZST_EXT      ".osc.zst"
+#define ZST_LEVEL    3
+
+typedef enum ZST_MODE_ {
+
+  ZST_OFF = 0,
+  ZST_REPLACE,   /* .osc.zst replaces .osc.gz **/
+  ZST_COPY       /* .osc.zst is written next to .osc.gz **/
+
+} ZST_MODE;
+
+int isZstdSupported(void);
+
+int string2ZstdMode(ZST_MODE *mode, const char *string);
+
+int startTranscode(ZST_MODE mode);
+
+int isTranscoding(void);
+
+int transcodePair(const char *oscFile, const char *stateFile);
+
+int finishTranscode(void);
+
+int gzip2Zstd(const char *gzName, const char *zstName, int level);
+
+int zstdListNames(STRING_LIST *list);
+
+#endif /* TRANSCODE_H_ **/
@@ -213,5 +213,13 @@ int isGoodExecutable(char *file);
 
 char *arg2FullPath(const char *arg);
 
+int compareUint64(const void *first, const void *second);
+
+int compareStrings(const void *first, const void *second);
+
+int jsonValue(char *dst, size_t size, const char *json, const char *key);
+
+size_t jsonEscape(char *dest, size_t size, const char *src);
+
 
 #endif /* UTIL_H_ */
@@ -0,0 +1,58 @@
+/*
+ * verify.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef VERIFY_H_
+#define VERIFY_H_
+
+#include <stddef.h>
+#include "sequence.h"
+
+/* verify local change files tree for one source:
+ *
+ *   {prefix}/NNN/NNN/NNN.osc.gz   must decompress completely; CRC32 and
+ *                                 ISIZE in each gzip member trailer match
+ *   {prefix}/NNN/NNN/NNN.state.txt  "sequenceNumber" matches path
+ *
+ * both files of a pair must exist; sequence numbers must not have gaps.
+ * A pair transcoded to ".osc.zst" - --zstd replace - counts as present.
+ * Files are checked on a worker pool, one thread per CPU.
+ ************************************************************************/
+
+typedef enum VERIFY_STATUS_ {
+
+  VERIFY_OK = 0,
+  VERIFY_EMPTY,        /* zero length file **/
+  VERIFY_BAD_HEADER,   /* not gzip or unsupported header **/
+  VERIFY_BAD_DATA,     /* inflate error **/
+  VERIFY_TRUNCATED,    /* end of file inside member **/
+  VERIFY_BAD_CRC,      /* trailer CRC32 does not match data **/
+  VERIFY_BAD_SIZE,     /* trailer ISIZE does not match data **/
+  VERIFY_NO_SEQUENCE,  /* state.txt without good sequenceNumber line **/
+  VERIFY_WRONG_SEQ,    /* state.txt sequenceNumber is not path sequence **/
+  VERIFY_READ_ERROR    /* open() or read() failed **/
+
+} VERIFY_STATUS;
+
+typedef struct VERIFY_REPORT_ {
+
+  long  pairs;       /* sequence numbers found **/
+  long  checked;     /* gzip files decompressed **/
+  long  corrupt;
+  long  orphaned;
+  long  missing;     /* sequence numbers in gaps **/
+  long  unexpected;  /* files that do not belong in tree **/
+
+} VERIFY_REPORT;
+
+int verifyTree(VERIFY_REPORT *report, const char *prefix, SEQ_NUM first, SEQ_NUM last, int numThreads);
+
+VERIFY_STATUS verifyGzipFile(const char *path);
+
+VERIFY_STATUS verifyStateFile(const char *path, SEQ_NUM seq);
+
+const char *verifyStatusString(VERIFY_STATUS status);
+
+#endif /* VERIFY_H_ **/
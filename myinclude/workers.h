@@ -0,0 +1,62 @@
+/*
+ * workers.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef WORKERS_H_
+#define WORKERS_H_
+
+#include <pthread.h>
+
+/* small fixed size thread pool; jobs are taken in submit order.
+ *
+ *   pool = initialWorkPool(numCPUs(), myFunc, free);
+ *   submitWork(pool, arg); ...
+ *   result = finishWorkPool(&pool); // waits for all jobs
+ *
+ * 'func' returns ztSuccess or error code; first error is kept and returned
+ * by finishWorkPool(). 'freeArg' - may be NULL - is called after each job.
+ ************************************************************************/
+
+#define MAX_WORKERS   64
+
+typedef int (*WORK_FUNC)(void *arg);
+
+typedef struct WORK_JOB_ {
+
+  void              *arg;
+  struct WORK_JOB_  *next;
+
+} WORK_JOB;
+
+typedef struct WORK_POOL_ {
+
+  pthread_t        threads[MAX_WORKERS];
+  int              numThreads;
+
+  WORK_FUNC        func;
+  void             (*freeArg)(void *arg);
+
+  WORK_JOB         *head;
+  WORK_JOB         *tail;
+
+  pthread_mutex_t  lock;
+  pthread_cond_t   hasWork;
+
+  int              closing;
+  int              firstError;
+  long             doneCount;
+  long             failedCount;
+
+} WORK_POOL;
+
+WORK_POOL *initialWorkPool(int numThreads, WORK_FUNC func, void (*freeArg)(void *arg));
+
+int submitWork(WORK_POOL *pool, void *arg);
+
+int finishWorkPool(WORK_POOL **pool);
+
+int numCPUs(void);
+
+#endif /* WORKERS_H_ **/
@@ -78,6 +78,7 @@
 #include "configure.h"
 #include "util.h"
 #include "ztError.h"
+#include "localsrc.h"
 
 /* exported global variable **/
 int myFgetsError;
@@ -832,7 +833,7 @@ printf("setConfValue(): set in entry with key is: <%s>\n\n", entry->key);
   case INET_URL_CT:
 
 //    if(isOkayFormat4HTTPS(value) != TRUE)
-    if(isOkayFormat4URL(value) != TRUE)
+    if(isOkayFormat4URL(value) != TRUE && isGoodLocalSource(value) != TRUE)
       return ztConfInvalidValue;
 
     break;
@@ -38,17 +38,22 @@
 #include <errno.h>
 #include <time.h>
 #include <unistd.h>
-#include <sys/wait.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/stat.h>
 
 #include "getdiff.h"
 #include "util.h"
 #include "ztError.h"
 #include "cookie.h"
 #include "fileio.h"
-#include "tmpFiles.h"
+#include "curlfn.h"
+#include "sha256.h"
 
 #include "debug.h"
+#include "logger.h"
 
 #define LOG_UNSEEN
 //#undef LOG_UNSEEN
@@ -60,33 +65,75 @@ int serverResponse = 0;
 
 FILE *cookieLogFP = NULL;
 
-#define SCRIPT_FILE        "oauth_cookie_client.py"
-#define JSON_FILE          "settings.json"
-#define COOKIE_FILE        "geofabrikCookie.txt"
+#define COOKIE_FILE_PREFIX "geofabrikCookie"
+
+#define OAUTH_TIMEOUT      60L    /* seconds for each request **/
+#define OAUTH_FIELD_SIZE   2048   /* token, state, client id and URLs **/
+#define OAUTH_FORM_SIZE    8192
+
+/* one request; 'code' is its response code, 'location' its redirect **/
+typedef struct OAUTH_STEP_ {
+
+  const char     *method;
+  const char     *url;
+  const char     *postData;     /* NULL for GET **/
+  int            follow;        /* follow redirects **/
+  long           code;
+  MEMORY_STRUCT  body;
+  char           location[OAUTH_FIELD_SIZE];
+
+} OAUTH_STEP;
+
+static size_t oauthBodyCallback(void *contents, size_t size, size_t nmemb, void *userp);
+static int oauthRequest(CURL *handle, OAUTH_STEP *step);
+static int oauthExpect(OAUTH_STEP *step, long expected, long alsoOkay);
+static int findAuthenticityToken(char *dst, size_t size, const char *page);
+static int formAppend(char *form, size_t size, CURL *handle, const char *name, const char *value);
+static int writeCookieText(const char *filename, const char *text);
+static int readCachedCookie(COOKIE *ck, const char *cookieFile);
+static void clearCookie(COOKIE *ck);
+static int refreshCache(MY_SETTING *settings, COOKIE_FILES *cfiles, COOKIE *ck, time_t ahead, int retry);
+static void *refreshMain(void *arg);
+
+/* background refresh; see startCookieRefresh() **/
+static COOKIE_FILES     refreshFiles;
+static MY_SETTING       *refreshSetting = NULL;
+static pthread_t        refreshThread;
+static pthread_mutex_t  refreshLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   refreshWake = PTHREAD_COND_INITIALIZER;
+static int              refreshOn = 0;
+static int              refreshStop = 0;
+static int              refreshChanged = 0;
+static char             *refreshToken = NULL;
+static time_t           refreshExpire = 0;
 
 /* getCookieFile (): function retrieves OSM login cookie via "geofabrik" web server,
  *   function stores the cookie in a text file on disk.
  *
- *   Function runs "oauth_cookie_client.py" script to retrieve the cookie. Script behaviour
- *   is summarized in pipeSpawnScript () function below. Also see repository:
+ *   Login is done with curl library in this process; steps are those of
+ *   "oauth_cookie_client.py" script from Geofabrik, see repository:
  *   https://github.com/geofabrik/sendfile_osm_oauth_protector/blob/master/doc/client.md
- *   for more information about the script.
  *
- *   Function calls fork() then runs the script as the child process in a pipe
- *   with redirection of standard error to capture error messages by the
- *   parent process. In case of error; function calls  getResponseCode() function
- *   to parse error message for server response code.
- * Script error message example:
- *   POST https://www.openstreetmap.org/oauth/authorize, received HTTP code 403 but expected 200
+ *   1) POST consumer "?action=get_authorization_url"; JSON with authorization_url,
+ *      state, redirect_uri and client_id.
+ *   2) GET OSM "/login?cookie_test=true" for session and authenticity token.
+ *   3) POST OSM "/login" with user name and password; expects 302.
+ *   4) GET authorization_url; 302 when already granted, else 200 with form
+ *      which is POSTed back - expects 302.
+ *   5) GET OSM "/logout".
+ *   6) GET redirect location from (4) with "&format=http"; body is cookie text.
  *
- *      In case of script failure; function sets global variable (int serverResponse) to
- *      received Response Code when possible. If we fail to parse error message for
- *      Response Code then function sets (int serverResponse) to zero.
- *      User (caller) should check serverResponse value on failure.
+ *   Steps 2 to 5 share OSM session cookies in one curl handle. Servers are
+ *   settings->loginHost and settings->consumerURL - LOGIN_HOST and CONSUMER_URL
+ *   keys - or OSM_LOGIN_HOST and COOKIE_CONSUMER_URL in cookie.h; "replserver
+ *   --oauth" in bench/ is a stand-in for both.
  *
+ *      On failure function sets global variable (int serverResponse) to received
+ *      Response Code. It is zero when no response was received.
+ *      User (caller) should check serverResponse value on failure.
  *
  * Geofabrik \Response codes I know:
- *  403 --> invalid user or password
+ *  403 --> invalid user or password; also login page returned instead of redirect
  *  429 --> too many requests
  *  500 --> internal server error
  *
@@ -94,231 +141,496 @@ FILE *cookieLogFP = NULL;
  *
  * Return:
  *   ztSuccess,
- *   ztPyExecNotFound : could not find python3 executable.
- *   ztCreateFileErr,
- *   ztWriteError,
- *   ztUnusableFile : failed IsArgUsableFile() call.
- *   ztGotNull,
- *   ztEmptyString,
- *   ztUnrecognizedMsg : unrecognized error message from script.
+ *   ztFailedLibCall : curl failed or no response.
+ *   ztParseError : could not find expected field in server response.
  *   ztMemoryAllocate,
- *   ztBadResponse : parse error, failed to convert string to long.
- *   ztHighResponse : server response code > 599
- *   ztFailedSysCall,
- *   ztChildProcessFailed : exit code for script was not EXIT_SUCCESS or (0).
- *
- * getCookieFile(): function downloads cookie file from "geofabrik" internal
- * server using the python script provided by "geofabrik". The script is executed
- * in a pipe with the function pipeSpawnScript() to redirect STDERROR output to
- * capture the script error messages.
- *
- * Command line to run the script: (arguments list - our array below)
- *  $ /usr/bin/python3 oauth_cookie_client.py -s settings.json -o geofabrikCookie.txt
+ *   ztOpenFileError, ztWriteError,
+ *   ztResponse403, ztResponse429, ztResponse500,
+ *   ztResponseUnknown : any other unexpected response code.
  *
  **********************************************************************************/
 
 int getCookieFile (MY_SETTING *settings, COOKIE_FILES *cfiles){
 
-  char  *argsList[5]; /* array of 5 pointers to character strings - uninitialized **/
+  CURL        *handle = NULL;     /* consumer requests; no session **/
+  CURL        *session = NULL;    /* OSM requests; keeps cookies **/
+  OAUTH_STEP  step;
+  char        authorizationURL[OAUTH_FIELD_SIZE];
+  char        state[OAUTH_FIELD_SIZE];
+  char        redirectURI[OAUTH_FIELD_SIZE];
+  char        clientId[OAUTH_FIELD_SIZE];
+  char        token[OAUTH_FIELD_SIZE];
+  char        location[OAUTH_FIELD_SIZE];
+  char        url[OAUTH_FIELD_SIZE];
+  char        *form = NULL;
+  const char  *loginHost;
+  const char  *consumerURL;
+  int         result;
 
-  char  *pyExec = "/usr/bin/python3"; /* python executable **/
+  /* do not allow NULL pointers **/
+  ASSERTARGS (settings && settings->usr && settings->pswd && cfiles && cfiles->cookieFile);
 
-  char  tmpBuf[1024] = {0}; /* buffer to build strings **/
+  loginHost = settings->loginHost ? settings->loginHost : OSM_LOGIN_HOST;
+  consumerURL = settings->consumerURL ? settings->consumerURL : COOKIE_CONSUMER_URL;
 
-  int   result;
+  /* global serverResponse is set if we can get it **/
+  serverResponse = 0;
 
-  char  *scriptErrorMessage; /* pointer to error message from script -
-                                this gets filled by pipeSpawnScript() **/
+  memset(&step, 0, sizeof(OAUTH_STEP));
 
-  char  *markerStr = "received HTTP code"; /* included in script error message -
-                                              used to parse the error message */
-  char  *lastPart = NULL;
+  handle = curl_easy_init();
+  session = curl_easy_init();
+  form = (char *) malloc(OAUTH_FORM_SIZE);
 
-  int   responseCode = 0; /* only change when we get from getResponseCode() */
+  if(! (handle && session && form)){
+    result = ztMemoryAllocate;
+    goto CLEAN_UP;
+  }
 
-  int   scriptResult; /* returned result from pipeSpawnScript() */
+  /* empty name turns cookie engine on without reading a file **/
+  curl_easy_setopt(session, CURLOPT_COOKIEFILE, "");
 
-  /* do not allow NULL pointers **/
-  ASSERTARGS (settings && cfiles && cfiles->scriptFile && cfiles->jsonFile);
+  /* 1) authorization request from consumer **/
+  snprintf(url, sizeof(url), "%s?action=get_authorization_url", consumerURL);
 
-  /* global serverResponse is set if we can get it **/
-  serverResponse = 0;
+  step.method = "POST";
+  step.url = url;
+  step.postData = "";
+  step.follow = 1;
 
-  /* check python executable **/
-  result = isExecutableUsable(pyExec);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed isExecutableUsable() function for: <%s>.\n",
-            progName, pyExec);
-    fprintf(stderr," function failed for: <%s>\n", ztCode2Msg(result));
-    return result;
+  result = oauthRequest(handle, &step);
+  if(result == ztSuccess)
+    result = oauthExpect(&step, 200L, 0L);
+  if(result != ztSuccess)
+    goto CLEAN_UP;
+
+  if(jsonValue(authorizationURL, sizeof(authorizationURL), step.body.memory, "authorization_url") != ztSuccess ||
+     jsonValue(state, sizeof(state), step.body.memory, "state") != ztSuccess ||
+     jsonValue(redirectURI, sizeof(redirectURI), step.body.memory, "redirect_uri") != ztSuccess ||
+     jsonValue(clientId, sizeof(clientId), step.body.memory, "client_id") != ztSuccess){
+
+    fprintf(stderr, "%s: Error authorization fields were not found in first response by the consumer.\n", progName);
+    result = ztParseError;
+    goto CLEAN_UP;
   }
 
-  /* write script file in our working directory **/
-  result = writeScript(cfiles->scriptFile);
-  if (result != ztSuccess){
-    fprintf(stderr, "%s: Error failed to write script to file.\n", progName);
-    return result;
+  /* 2) OSM session and authenticity token **/
+  snprintf(url, sizeof(url), "%s/login?cookie_test=true", loginHost);
+
+  step.method = "GET";
+  step.postData = NULL;
+  step.follow = 1;
+
+  result = oauthRequest(session, &step);
+  if(result == ztSuccess)
+    result = oauthExpect(&step, 200L, 0L);
+  if(result != ztSuccess)
+    goto CLEAN_UP;
+
+  if(findAuthenticityToken(token, sizeof(token), step.body.memory) != ztSuccess){
+    fprintf(stderr, "%s: Error could not find the authenticity_token in login page.\n", progName);
+    result = ztParseError;
+    goto CLEAN_UP;
   }
 
-  /* write JSON setting file in our working directory **/
-  result = writeJSONfile(cfiles->jsonFile, settings->usr, settings->pswd);
-  if (result != ztSuccess){
-    fprintf(stderr, "%s: Error failed to write JSON settings file.\n", progName);
-    removeFile(cfiles->scriptFile);
-    return result;
+  /* 3) login **/
+  form[0] = '\0';
+  result = formAppend(form, OAUTH_FORM_SIZE, session, "username", settings->usr);
+  if(result == ztSuccess)
+    result = formAppend(form, OAUTH_FORM_SIZE, session, "password", settings->pswd);
+  if(result == ztSuccess)
+    result = formAppend(form, OAUTH_FORM_SIZE, session, "referer", "/");
+  if(result == ztSuccess)
+    result = formAppend(form, OAUTH_FORM_SIZE, session, "commit", "Login");
+  if(result == ztSuccess)
+    result = formAppend(form, OAUTH_FORM_SIZE, session, "authenticity_token", token);
+  if(result != ztSuccess)
+    goto CLEAN_UP;
+
+  snprintf(url, sizeof(url), "%s/login", loginHost);
+
+  step.method = "POST";
+  step.postData = form;
+  step.follow = 0;
+
+  result = oauthRequest(session, &step);
+
+  /* failed login shows login page again **/
+  if(result == ztSuccess && step.code == 200L){
+    fprintf(stderr, "%s: Error login to OSM failed; login page was returned.\n", progName);
+    serverResponse = 403;
+    result = ztResponse403;
+    goto CLEAN_UP;
+  }
+
+  if(result == ztSuccess)
+    result = oauthExpect(&step, 302L, 0L);
+  if(result != ztSuccess)
+    goto CLEAN_UP;
+
+  /* 4) authorize; redirect when granted before, else submit the form **/
+  step.method = "GET";
+  step.url = authorizationURL;
+  step.postData = NULL;
+  step.follow = 0;
+
+  result = oauthRequest(session, &step);
+  if(result != ztSuccess)
+    goto CLEAN_UP;
+
+  if(step.code != 302L){
+
+    result = oauthExpect(&step, 200L, 0L);
+    if(result != ztSuccess)
+      goto CLEAN_UP;
+
+    if(findAuthenticityToken(token, sizeof(token), step.body.memory) != ztSuccess){
+      fprintf(stderr, "%s: Error could not find the authenticity_token in authorization page.\n", progName);
+      result = ztParseError;
+      goto CLEAN_UP;
+    }
+
+    form[0] = '\0';
+    result = formAppend(form, OAUTH_FORM_SIZE, session, "client_id", clientId);
+    if(result == ztSuccess)
+      result = formAppend(form, OAUTH_FORM_SIZE, session, "redirect_uri", redirectURI);
+    if(result == ztSuccess)
+      result = formAppend(form, OAUTH_FORM_SIZE, session, "authenticity_token", token);
+    if(result == ztSuccess)
+      result = formAppend(form, OAUTH_FORM_SIZE, session, "state", state);
+    if(result == ztSuccess)
+      result = formAppend(form, OAUTH_FORM_SIZE, session, "response_type", "code");
+    if(result == ztSuccess)
+      result = formAppend(form, OAUTH_FORM_SIZE, session, "scope", "read_prefs");
+    if(result == ztSuccess)
+      result = formAppend(form, OAUTH_FORM_SIZE, session, "nonce", "");
+    if(result == ztSuccess)
+      result = formAppend(form, OAUTH_FORM_SIZE, session, "code_challenge", "");
+    if(result == ztSuccess)
+      result = formAppend(form, OAUTH_FORM_SIZE, session, "code_challenge_method", "");
+    if(result == ztSuccess)
+      result = formAppend(form, OAUTH_FORM_SIZE, session, "commit", "Authorize");
+    if(result != ztSuccess)
+      goto CLEAN_UP;
+
+    step.method = "POST";
+    step.postData = form;
+
+    result = oauthRequest(session, &step);
+    if(result == ztSuccess)
+      result = oauthExpect(&step, 302L, 0L);
+    if(result != ztSuccess)
+      goto CLEAN_UP;
+  }
+
+  if(! step.location[0] || ! strchr(step.location, '?')){
+    fprintf(stderr, "%s: Error redirect URL after authorization misses query string.\n", progName);
+    result = ztParseError;
+    goto CLEAN_UP;
+  }
+
+  strcpy(location, step.location);
+
+  /* 5) logout **/
+  snprintf(url, sizeof(url), "%s/logout", loginHost);
+
+  step.url = url;
+  step.method = "GET";
+  step.postData = NULL;
+  step.follow = 0;
+
+  result = oauthRequest(session, &step);
+  if(result == ztSuccess)
+    result = oauthExpect(&step, 200L, 302L);
+  if(result != ztSuccess)
+    goto CLEAN_UP;
+
+  /* 6) final cookie **/
+  if(snprintf(url, sizeof(url), "%s&format=http", location) >= (int) sizeof(url)){
+    result = ztFnameLong;
+    goto CLEAN_UP;
   }
 
-  /* set the pointers in our argument list array - command line arguments. **/
-  argsList[0] = STRDUP(pyExec);
+  step.follow = 1;
 
-  argsList[1] = STRDUP(cfiles->scriptFile);
+  result = oauthRequest(handle, &step);
+  if(result == ztSuccess)
+    result = oauthExpect(&step, 200L, 0L);
+  if(result != ztSuccess)
+    goto CLEAN_UP;
 
-  sprintf (tmpBuf, "-s%s", cfiles->jsonFile);
-  argsList[2] = STRDUP(tmpBuf);
+  result = writeCookieText(cfiles->cookieFile, step.body.memory);
+  if(result != ztSuccess)
+    goto CLEAN_UP;
 
-  sprintf (tmpBuf, "-o%s", cfiles->cookieFile);
-  argsList[3] = STRDUP(tmpBuf);
+  /* check cookie file status **/
+  result = isFileUsable(cfiles->cookieFile);
+  if(result == ztSuccess)
+    serverResponse = 200;
+  else
+    result = ztUnknownError;
 
-  /* correct; no space between switch and its argument in above 2 sprintf() calls. **/
+CLEAN_UP:
 
-  argsList[4] = NULL; /* last pointer must be NULL **/
+  if(step.body.memory)
+    free(step.body.memory);
 
-  /* run the script in a pipe **/
-  scriptResult = pipeSpawnScript (pyExec, argsList, &scriptErrorMessage);
+  if(form){
+    memset(form, 0, OAUTH_FORM_SIZE); /* has password **/
+    free(form);
+  }
 
-  /* remove temporary files - no longer needed **/
+  if(session)
+    curl_easy_cleanup(session);
 
-  result = removeFile(cfiles->scriptFile);
-  if (result != ztSuccess)
-    fprintf(stderr, "%s: Warning failed to remove temporary script file(s)!\n", progName);
+  if(handle)
+    curl_easy_cleanup(handle);
 
-  result = removeFile(cfiles->jsonFile);
-  if (result != ztSuccess)
-    fprintf(stderr, "%s: Warning failed to remove temporary JSON file(s)!\n", progName);
+  if(result == ztSuccess || ! serverResponse)
 
-  /* examine scriptResult now;
-   * script writes error messages to STDERR,
-   * pipeSpawnScript() gets this in our third parameter,
-   * it allocates memory and fills string when possible */
+    return result;
 
-  if (scriptResult == ztSuccess){
+  switch(serverResponse){
 
-    /* check cookie file status **/
-    result = isFileUsable(cfiles->cookieFile);
-    if(result == ztSuccess){
+  case 403:
 
-      serverResponse = 200; /* set global variable - we assume this! **/
-      return ztSuccess; /* script run okay AND cookie file is okay **/
-    }
+    fprintf(stderr, "%s: Error received server response code 403; invalid credentials.\n"
+            "Wrong user name or password for OSM account.\n", progName);
+
+    return ztResponse403;
+    break;
+
+  case 429:
+
+    fprintf(stderr, "%s: Error received server response code 429; \"too many requests error.\"\n"
+            "Please do not use this program for some period of time - one hour maybe.\n\n"
+            "This program has a limit for how many requests it sends as not to overwhelm\n"
+            "the server. Please do not abuse this free service Geofabrik.de provides.\n", progName);
+
+    return ztResponse429;
+    break;
+
+  case 500:
+
+    fprintf(stderr, "%s: Error received server response code 500; internal server error.\n"
+            "One of the two servers - geofabrik.de or openstreetmap.org - might be busy or down.\n",
+            progName);
 
-    else
+    return ztResponse500;
+    break;
 
-      return ztUnknownError; /* script was okay but file was not **/
+  default:
+
+    fprintf(stderr, "%s: Error received server response code < %d > from server.\n"
+            "This code could be from either servers - geofabrik.de or openstreetmap.org.\n"
+            "This code is not handled by this program.\n", progName, serverResponse);
+
+    return ztResponseUnknown;
+    break;
+
+  } /* end switch(serverResponse) **/
+
+  return result;
+
+} /* END getCookieFile() */
+
+/* oauthBodyCallback(): appends received data to MEMORY_STRUCT; kept
+ * null terminated.
+ **********************************************************************/
+
+static size_t oauthBodyCallback(void *contents, size_t size, size_t nmemb, void *userp){
+
+  MEMORY_STRUCT  *body = (MEMORY_STRUCT *) userp;
+  size_t         realSize = size * nmemb;
+  char           *memory;
+
+  memory = (char *) realloc(body->memory, body->size + realSize + 1);
+  if(! memory)
+    return 0;
+
+  body->memory = memory;
+  memcpy(body->memory + body->size, contents, realSize);
+  body->size += realSize;
+  body->memory[body->size] = '\0';
+
+  return realSize;
+
+} /* END oauthBodyCallback() **/
+
+/* oauthRequest(): performs 'step' with 'handle'; sets code, body and location **/
+
+static int oauthRequest(CURL *handle, OAUTH_STEP *step){
+
+  CURLcode  curlCode;
+  char      *redirect = NULL;
+
+  ASSERTARGS(handle && step && step->url && step->method);
+
+  step->code = 0;
+  step->location[0] = '\0';
+  step->body.size = 0;
+
+  if(step->body.memory)
+    step->body.memory[0] = '\0';
+
+  curl_easy_setopt(handle, CURLOPT_URL, step->url);
+  curl_easy_setopt(handle, CURLOPT_USERAGENT, COOKIE_USER_AGENT);
+  curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, step->follow ? 1L : 0L);
+  curl_easy_setopt(handle, CURLOPT_TIMEOUT, OAUTH_TIMEOUT);
+  curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, oauthBodyCallback);
+  curl_easy_setopt(handle, CURLOPT_WRITEDATA, (void *) &step->body);
+
+  if(step->postData)
+    curl_easy_setopt(handle, CURLOPT_POSTFIELDS, step->postData);
+  else
+    curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
+
+  curlCode = curl_easy_perform(handle);
+  if(curlCode != CURLE_OK){
+    fprintf(stderr, "%s: Error %s %s failed: %s\n", progName, step->method, step->url,
+            curl_easy_strerror(curlCode));
+    if(cookieLogFP)
+      logMessage(cookieLogFP, "Error failed curl_easy_perform() for cookie request.");
+
+    return ztFailedLibCall;
   }
 
-  /* scriptResult != ztSuccess; failed script result **/
-  if(scriptErrorMessage == NULL){
+  curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &step->code);
 
-    /*
-      #ifdef LOG_UNSEEN
-      logUnseen (settings, "No error message: (scriptErrorMessage == NULL)", "NULL");
-      #endif
-    */
-    fprintf (stderr, "%s: Error failed script with no error message"
-             " (message pointer = NULL) in getCookieFile().\n", progName);
+  if(curl_easy_getinfo(handle, CURLINFO_REDIRECT_URL, &redirect) == CURLE_OK && redirect)
+    snprintf(step->location, sizeof(step->location), "%s", redirect);
 
-    return scriptResult;
+  /* body is never NULL after a request **/
+  if(! step->body.memory){
+    step->body.memory = (char *) calloc(1, 1);
+    if(! step->body.memory)
+      return ztMemoryAllocate;
   }
 
-  /* we have an error message, try to get response code **/
-  lastPart = strstr(scriptErrorMessage, markerStr);
+  return ztSuccess;
 
-  if( ! lastPart ){
+} /* END oauthRequest() **/
 
-    /* error message doesn't include markerStr -> unrecognized message
-     * for now we log such error messages */
-    /*
-      #ifdef LOG_UNSEEN
-      sprintf (tmpBuf, "UNRECOGNIZED message: <%s>", scriptErrorMessage);
-      logUnseen (settings, tmpBuf, "No lastPart");
-      #endif
-    */
-    fprintf(stderr, "%s: Error failed script with UNRECOGNIZED server error"
-            " message in getCookieFile()\n "
-            " Server Error Message: <%s>.\n", progName, scriptErrorMessage);
+/* oauthExpect(): ztSuccess when 'step' code is 'expected' or 'alsoOkay',
+ * otherwise reports and sets serverResponse.
+ **********************************************************************/
 
-    return scriptResult;
+static int oauthExpect(OAUTH_STEP *step, long expected, long alsoOkay){
 
-  }
+  char  message[PATH_MAX];
 
-  else { /* error massage has lastPart, try to get response code **/
+  if(step->code == expected || (alsoOkay && step->code == alsoOkay))
 
-    result = getResponseCode (&responseCode, lastPart);
-    if (result == ztSuccess){
+    return ztSuccess;
 
-      /* set global variable: 'serverResponse' **/
-      serverResponse = responseCode;
+  serverResponse = (int) step->code;
 
-      switch(responseCode){
+  snprintf(message, sizeof(message), "%s %.1024s, received HTTP code %ld but expected %ld",
+           step->method, step->url, step->code, expected);
 
-      case 403:
+  fprintf(stderr, "%s: Error %s\n", progName, message);
+  if(cookieLogFP)
+    logMessage(cookieLogFP, message);
 
-        fprintf(stderr, "%s: Error received server response code 403; invalid credentials.\n"
-                "Wrong user name or password for OSM account.\n", progName);
+  return ztResponseUnknown;
 
-        return ztResponse403;
-        break;
+} /* END oauthExpect() **/
 
-      case 429:
+/* findAuthenticityToken(): value from <meta name="csrf-token" content="..."> **/
 
-        fprintf(stderr, "%s: Error received server response code 429; \"too many requests error.\"\n"
-                "Please do not use this program for some period of time - one hour maybe.\n\n"
-                "This program has a limit for how many requests it sends as not to overwhelm\n"
-                "the server. Please do not abuse this free service Geofabrik.de provides.\n", progName);
+static int findAuthenticityToken(char *dst, size_t size, const char *page){
 
-        return ztResponse429;
-        break;
+  const char  *marker = "name=\"csrf-token\" content=\"";
+  const char  *start;
+  const char  *end;
 
-      case 500:
+  ASSERTARGS(dst && page);
 
-        fprintf(stderr, "%s: Error received server response code 500; internal server error.\n"
-                "One of the two servers - geofabrik.de or openstreetmap.org - might be busy or down.\n",
-                progName);
+  start = strstr(page, marker);
+  if(! start)
+    return ztParseError;
 
-        return ztResponse500;
-        break;
+  start += strlen(marker);
 
-      default:
+  end = strchr(start, '"');
+  if(! end || end == start || (size_t) (end - start) >= size)
+    return ztParseError;
 
-        fprintf(stderr, "%s: Error received server response code < %d > from server.\n"
-                "This code could be from either servers - geofabrik.de or openstreetmap.org.\n"
-                "This code is not handled by this program.\n", progName, responseCode);
+  memcpy(dst, start, end - start);
+  dst[end - start] = '\0';
 
-        return ztResponseUnknown;
-        break;
+  return ztSuccess;
 
-      } /* end switch(responseCode) **/
+} /* END findAuthenticityToken() **/
 
-      return scriptResult;
+/* formAppend(): appends "name=value" URL encoded to 'form' **/
 
-    }
-    else{ /* failed to get response code from error message **/
+static int formAppend(char *form, size_t size, CURL *handle, const char *name, const char *value){
 
-      /*
-	#ifdef LOG_UNSEEN
-	sprintf (tmpBuf, "Failed to get response code from error message: <%s>", scriptErrorMessage);
-	logUnseen (settings, tmpBuf, lastPart);
-	#endif
-      */
-      return scriptResult;
+  char    *encoded;
+  size_t  length = strlen(form);
+  int     written;
 
-    }
+  encoded = curl_easy_escape(handle, value, 0);
+  if(! encoded)
+    return ztMemoryAllocate;
 
-  }
+  written = snprintf(form + length, size - length, "%s%s=%s", length ? "&" : "", name, encoded);
+
+  curl_free(encoded);
+
+  if(written < 0 || (size_t) written >= size - length)
+    return ztFnameLong;
 
   return ztSuccess;
 
-} /* END getCookieFile() */
+} /* END formAppend() **/
+
+/* writeCookieText(): cookie text to 'filename' with ending line feed;
+ * written to temporary name then renamed so readers never see part of it.
+ **********************************************************************/
+
+static int writeCookieText(const char *filename, const char *text){
+
+  char   tmpName[PATH_MAX];
+  FILE   *filePtr;
+  int    fd;
+  size_t length = strlen(text);
+  int    result = ztSuccess;
+
+  if(snprintf(tmpName, sizeof(tmpName), "%s.tmp", filename) >= (int) sizeof(tmpName))
+    return ztFnameLong;
+
+  errno = 0;
+  fd = open(tmpName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  filePtr = (fd < 0) ? NULL : fdopen(fd, "w");
+  if(! filePtr){
+    if(fd >= 0)
+      close(fd);
+    fprintf (stderr, "%s: Error could not open file for writing! <%s>\n", progName, tmpName);
+    fprintf(stderr, "System error message: %s\n\n", strerror(errno));
+    return ztOpenFileError;
+  }
+
+  if(fputs(text, filePtr) == EOF)
+    result = ztWriteError;
+
+  if(result == ztSuccess && (length == 0 || text[length - 1] != '\n') && fputc('\n', filePtr) == EOF)
+    result = ztWriteError;
+
+  if(fclose(filePtr) != 0)
+    result = ztWriteError;
+
+  if(result == ztSuccess && rename(tmpName, filename) != 0)
+    result = ztWriteError;
+
+  if(result != ztSuccess)
+    remove(tmpName);
+
+  return result;
+
+} /* END writeCookieText() **/
 
 int day2num (char *day){
 
@@ -877,274 +1189,6 @@ int parseTimeStr (struct tm *expireTM, char const *str){
 
 } /* END parseTimeStr() **/
 
-int fd2Close = -1;
-
-/* pipeSpawnScript(): runs script in a pipe AND gets script STDERR output
- * in char **outputString variable
- *
- * How oauth_cookie_client.py script work:
- *   - script usually outputs the cookie string to terminal on success: standard output.
- *   - on failure script writes an error message with server response code to
- *     "STANDARD ERROR" then exits.
- *   - cookie string can be written to a file with -o (--output) option which is used
- *     in argList here, so on success there is no terminal output
- *   - this function gets the error message in its "outputString" variable from
- *     STDERR_FILENO. Again "STANDARD ERROR" not "standard output".
- *
- * Returns: ztFailedSysCall, ztMemoryAllocate, ztChildProcessFailed, ztSuccess.
- * In case of "ztChildProcessFailed" script error message is copied into the
- * third variable (outputString). Parameter (outputString) is set to NULL if
- * we can not read error message.
- *
- ******************************************************************************/
-
-int pipeSpawnScript (const char *prog, char* const argList[], char **outputString){
-
-  /* function prototype to match execv() system call from man page:
-   *
-   *      int execv(const char *pathname, char *const argv[]);
-   *
-   ******************************************************************/
-
-  pid_t childPid;
-  int   fds[2];          /* pipe fds are in alphabetical order (0->read & 1->write) */
-  FILE  *scriptTerminal; /* so we can use fgets() */
-  int   waitStatus;      /* exit status; code */
-  int   result;
-  char  temBuf[1024] = {0};
-
-  errno = 0;
-
-  // create the pipe
-  result = pipe(fds);
-
-  if (result == -1){ // failed pipe() call
-
-    perror ("pipe");
-    fprintf (stderr, "%s: Error failed system call to pipe()\n", progName);
-
-    return ztFailedSysCall;
-  }
-
-  childPid = fork();
-  if (childPid == -1){ // failed fork() call
-
-    perror ("fork");
-    fprintf (stderr, "%s: Error failed system call to fork()\n", progName);
-
-    return ztFailedSysCall;
-  }
-
-  if (childPid == (pid_t) 0){ // this is the child, do child work
-
-    if(fd2Close != -1){
-      fprintf(stdout, "Cookie has a locked2CloseFD set by user; closing...\n");
-      close(fd2Close);
-    }
-
-    // close the pipe read end
-    close (fds[0]);
-
-    scriptTerminal = fdopen (fds[1], "w");
-
-    /* connect pipe write end to STANDARD ERROR:
-     *   this is like shell redirection.
-     * Note that we ignore standard output.
-     * *********************************************************************/
-    result = dup2 (fds[1], STDERR_FILENO);
-    if (result == -1){
-
-      perror ("dup2");
-      fprintf (stderr, "%s: Error failed system call to dup2()\n", progName);
-      return ztFailedSysCall;
-    }
-
-    // run the script; this replaces the child process!
-    execv (prog, argList);
-
-    /* The execv function returns only if an error occurs. */
-    fprintf (stderr, "%s: Error: I am the CHILD in pipeSpawnScript():\n"
-             "If you see this then there was an error in execv() call...\n", progName);
-    fprintf (stderr, "%s: Error in pipeSpawnScript(): an error occurred in"
-             " execv() ... aborting!\n",
-             progName);
-    abort();  // TODO: return error AND remove abort()
-
-    fflush(scriptTerminal);
-
-    close (fds[1]);
-
-  } // end child work
-
-  else { // this is the parent; do parent work
-
-    // close the pipe write end
-    close (fds[1]);
-
-    // wait for the child to finish AND store its exit status
-    waitpid (childPid, &waitStatus, 0);
-
-    if (WEXITSTATUS(waitStatus) == EXIT_SUCCESS) {
-
-      return ztSuccess;
-    }
-
-    else { /*  WEXITSTATUS(waitStatus) != EXIT_SUCCESS
-            * failed script -> get its error text message */
-
-      // convert script output terminal to FILE * ,,, so we can use fgets() function
-      scriptTerminal = fdopen (fds[0], "r");
-
-      if ( ! scriptTerminal ){
-
-        perror ("fdopen");
-        fprintf (stderr, "%s: Error returned from fdopen() call.\n", progName);
-        return ztFailedSysCall;
-      }
-
-      while ( !feof (scriptTerminal)) // script writes only ONE line, still use while()
-
-        fgets (temBuf, 1023, scriptTerminal);
-
-      /* maybe there is nothing to get or read! */
-      if (strlen(temBuf) == 0){
-
-        *outputString = NULL; /* make sure it is NULL in this case */
-        return ztChildProcessFailed;
-      }
-
-      // remove linefeed character
-      temBuf[strlen(temBuf) -1] = '\0';
-
-      *outputString = (char *) malloc ((strlen(temBuf) + 1) * sizeof(char));
-      if ( *outputString == NULL){
-
-        fprintf(stderr, "%s: Error allocating memory in pipeSpawnScript().\n", progName);
-        return ztMemoryAllocate;
-      }
-
-      strcpy (*outputString, temBuf);
-
-      fprintf (stderr, "pipeSpawnScript(): The script failed to retrieve cookie; error message from script was:\n  < %s >\n\n", temBuf);
-
-      return ztChildProcessFailed;
-
-    } // end failed script
-
-  } // end parent work
-
-} /* END pipeSpawnScript() **/
-
-/* getResponseCode(): Function extracts 'response code' ABC from the following
- *  exact string message: received HTTP code ABC but expected 200
- *  function sets the integer pointed to by code to response code on ztSuccess.
- *  On errors code is set to zero except when error is ztHighResponse.
- *
- * NOTE: edited script at original line # 67 by removing the word "status" from
- * error message:
- * report_error("POST {}, received HTTP status code {} but expected 200".format(url, r.status_code))
- * became:
- * report_error("POST {}, received HTTP code {} but expected 200".format(url, r.status_code))
- * this way ALL error messages now start with the phrase: "received HTTP code".
- * also added a comment line below as:
- * # NOTE: removed the word 'status' from the above line. W.H.\n
- *
- *  returns:
- *  ztInvalidArg : message does not match "received HTTP code ABC but expected 200"
- *  ztMemoryAllocate : could not allocate memory for own message copy
- *  ztEmptyString : Empty error message (msg)
- *  ztBadResponse : failed to convert string to long - has non digit maybe
- *  ztHighResponse : when code > 599
- *  ztSuccess.
- *
- *  TODO: rename function to getScriptResponseCode()
- *
- ******************************************************************************/
-
-int getResponseCode (int *code, char *msg){
-
-  char  *myMsg;
-  char *startDigit = "123456789";
-  char *startMarker = "received HTTP code";
-  char *subStr1;
-  char *expectedStr = "but expected 200";
-  char *subStr2;
-  char *codeStr;
-  char *codeToken;
-  char *spaceDel = "\040";
-  int codeNum;
-  char *endPtr;
-
-
-  ASSERTARGS (code && msg);
-
-  *code = 0; /* only change when we get it */
-
-  if (strlen(msg) == 0){
-
-    fprintf (stderr, "%s: Error in getResponseCode(): Empty string in msg parameter.\n",
-             progName);
-    return ztEmptyString;
-  }
-
-  /* msg must include startMarker AND expectedStr strings */
-  subStr1 = strstr (msg, startMarker);
-
-  if ( ! subStr1 || (subStr1 != msg)){
-
-    fprintf (stderr, "%s: Error in getResponseCode(): invalid msg parameter: <%s>\n",
-             progName, msg);
-    return ztInvalidArg;
-  }
-
-  subStr2 = strstr (msg, expectedStr);
-
-  if ( ! subStr2 || (strcmp(subStr2, expectedStr) != 0)){
-
-    fprintf (stderr, "%s: Error in getResponseCode(): invalid msg parameter: <%s>\n",
-             progName, msg);
-    return ztInvalidArg;
-  }
-
-  myMsg = strdup(msg);
-
-  if ( ! myMsg ){
-
-    fprintf (stderr, "%s: Error in getResponseCode(): memory allocation.\n", progName);
-    return ztMemoryAllocate;
-  }
-
-  /* find the start of received code string */
-  codeStr = strpbrk(myMsg, startDigit);
-
-  if ( ! codeStr ){
-
-    fprintf (stderr, "%s: Error in getResponseCode(): invalid msg parameter: <%s>\n",
-             progName, msg);
-    return ztInvalidArg;
-  }
-
-  codeToken = strtok(codeStr, spaceDel);
-
-  codeNum = (int) strtol (codeToken, &endPtr, 10);
-
-  if ( *endPtr != '\0' ){ /* may have something other than digits */
-
-    fprintf (stderr, "%s: Error in getResponseCode(): invalid msg parameter: <%s>\n",
-             progName, msg);
-    return ztParseError; //ztBadResponse;
-  }
-
-  *code = codeNum;
-
-  if (codeNum > 599)
-
-    return ztResponseUnknown; //ztHighResponse;
-
-  return ztSuccess;
-}
-
-
 /* getCookieRetry ():
  *
  * short wait  --> sleep 10 seconds
@@ -1152,11 +1196,10 @@ int getResponseCode (int *code, char *msg){
  *
  * Returns:
  *  ztSuccess,
- *  ztPyExecNotFound,
- *  ztOutResource,
+ *  ztFailedLibCall,
+ *  ztParseError,
  *  ztUnknownError,
- *  ztUnrecognizedMsg,
- *  ztHighResponse,
+ *  ztResponseUnknown,
  *  ztResponse403,
  *  ztResponse429,
  *  ztResponse500,
@@ -1171,6 +1214,10 @@ int getResponseCode (int *code, char *msg){
  *  We test the received file, if it is NOT a cookie file we retry ONE time
  *  after the delay time.
  *
+ *  Login is now done in process (see getCookieFile()) and response codes are
+ *  back; no retry for 403 (credentials) or 429 (too many requests) since
+ *  retry can not help there.
+ *
  *  New return code "ztNotCookieFile" when received file is NOT a cookie file.
  *
  *******************************************************************************/
@@ -1184,10 +1231,14 @@ int getCookieRetry (MY_SETTING *settings, COOKIE_FILES *cfiles){
 
   result = getCookieFile(settings, cfiles);
 
+  if(result == ztResponse403 || result == ztResponse429)
+
+    return result;
+
   if(result != ztSuccess){
-    fprintf(stdout, "getCookieRetry():: Failed getCookieFile() - Script failed probably! Retrying after delay.\n");
+    fprintf(stdout, "getCookieRetry():: Failed getCookieFile() - Retrying after delay.\n");
     if(cookieLogFP)
-      logMessage(cookieLogFP,"getCookieRetry():: Failed getCookieFile() - Script failed probably! Retrying after delay");
+      logMessage(cookieLogFP,"getCookieRetry():: Failed getCookieFile() - Retrying after delay");
 
     sleep(delayTime);
 
@@ -1255,120 +1306,61 @@ int getCookieRetry (MY_SETTING *settings, COOKIE_FILES *cfiles){
 } /* END getCookieRetry() */
 
 /* doCookie():
- *  - python script provided by Geofabrik is used to download login cookie.
- *  - login cookie is saved to 'geofabrikCookie.txt' file in program workDir.
+ *  - login cookie is retrieved by getCookieFile() with OSM OAuth login.
+ *  - login cookie is kept in cookie cache; one file for each OSM user shared
+ *    by all work directories and instances: {cache}/geofabrikCookie-{key}.txt
  *  - cookie file is parsed into 'COOKIE' structure.
  *  - cookie file is NOT replaced until it has expired - about 48 hours.
  *  - usr & pswd are NOT used (tested) when existing cookie is not expired.
+ *  - renewal is done under lock on cache; an instance waiting for the lock
+ *    finds the cookie renewed by another and does not login again.
  *
  ******************************************************************************/
 
 int doCookie(MY_SETTING *settings, SKELETON *dirs){
 
-  ASSERTARGS(settings && settings->usr && settings->pswd &&
-	     dirs && dirs->workDir && dirs->tmp);
+  ASSERTARGS(settings && settings->usr && settings->pswd && dirs);
 
   int result;
-  int preExist;
-  int removedFlag = 0;
 
   COOKIE_FILES cfiles;
 
-  result = cookieSetFilenames(&cfiles, dirs);
+  result = cookieSetFilenames(&cfiles, settings);
   if(result != ztSuccess){
     fprintf(stderr, "%s: Error failed cookieSetFilenames().\n", progName);
     return result;
   }
 
-  result = isFileUsable(cfiles.cookieFile);
-
-  preExist = (result == ztSuccess);
-
-  if(preExist){
-    fprintf(stdout, "%s: doCookie():: Checking pre-existing cookie file for its expiration time.\n", progName);
-    if(cookieLogFP)
-      logMessage(cookieLogFP, "doCookie():: Checking pre-existing cookie file for its expiration time.");
-
-    if( ! isCookieFile(cfiles.cookieFile)){
-
-      /* this was added for the Geofabrik new python script! new script does NOT
-       * provide any error message on failure or sets any server response code!
-       *************************************************************************/
-
-      fprintf(stdout, "%s: doCookie():: Pre-exiting file is NOT cookie file, removing.\n", progName);
-      if(cookieLogFP)
-        logMessage(cookieLogFP, "doCookie():: Pre-exiting file is NOT cookie file, removing.");
-
-      remove(cfiles.cookieFile);
-      removedFlag = 1;
-    }
-  }
-
-  /* if cookie file was NOT found OR it was REMOVED; get new cookie file **/
-
-  if(! preExist || removedFlag){
-
-    result = getCookieRetry(settings, &cfiles);
-    if(result == ztNotCookieFile){
-      fprintf(stderr, "%s: Error, getCookieRetry() failed to retrieve a cookie file!\n"
-	      "Most likely this is for invalid user or password, "
-	      "please double check both before retrying.\n", progName);
-      if(cookieLogFP)
-        logMessage(cookieLogFP, "Error, getCookieRetry() failed to retrieve a cookie file!\n"
-		   " Most likely this is for invalid user or password,\n"
-		   " please double check both before retrying.");
-
-      return result;
-    }
-    else if(result != ztSuccess){
-      fprintf(stderr, "%s: Error, failed getCookieRetry() for:\n %s\n", progName, ztCode2Msg(result));
-      if(cookieLogFP){
-        logMessage(cookieLogFP, "Error, failed getCookieRetry() for:");
-        logMessage(cookieLogFP, ztCode2Msg(result));
-      }
-
-      return result;
-    }
-  }
-
-  /* now we have cookie file: old (pre-exist) or new file **/
-
   if( ! cookie ){
 
     cookie = (COOKIE *)malloc(sizeof(COOKIE));
     if(! cookie){
       fprintf(stderr, "%s: Error allocating memory in initialCookie().\n", progName);
+      zapCookieFiles(&cfiles);
       return ztMemoryAllocate;
     }
+    memset(cookie, 0, sizeof(COOKIE));
   }
-  memset(cookie, 0, sizeof(COOKIE));
 
-  result = parseCookieFile(cookie, cfiles.cookieFile);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed parseCookieFile() function.\n", progName);
-    if(cookieLogFP)
-      logMessage(cookieLogFP, "Error failed parseCookieFile() function.");
+  /* no lock to read; cookie file is replaced by rename() **/
+  result = readCachedCookie(cookie, cfiles.cookieFile);
 
-    return result;
-  }
+  if(result == ztSuccess && isExpiredCookie(cookie) == FALSE){
 
-  if(fVerbose){
-    fprintCookie(stdout, cookie);
-    if(fLogPtr)
-      fprintCookie(fLogPtr, cookie);
+    if(cookieLogFP)
+      logMessage(cookieLogFP, "doCookie():: Using cookie from cookie cache.");
   }
+  else {
 
-  if(isExpiredCookie(cookie) == FALSE){
+    fprintf(stdout, "%s: doCookie():: No usable cookie in cache, retrieving new cookie file.\n", progName);
+    if(cookieLogFP)
+      logMessage(cookieLogFP, "doCookie():: No usable cookie in cache, retrieving new cookie file.");
 
-    return ztSuccess;
+    result = refreshCache(settings, &cfiles, cookie, COOKIE_EXPIRE_AHEAD, 1);
   }
 
-  // expired cookie, get a new one
-  fprintf(stdout, "%s: Current cookie has expired, retrieving new cookie file.\n", progName);
-  if(cookieLogFP)
-    logMessage(cookieLogFP, "Current cookie has expired, retrieving new cookie file.");
+  zapCookieFiles(&cfiles);
 
-  result = getCookieRetry(settings, &cfiles);
   if(result == ztNotCookieFile){
     fprintf(stderr, "%s: Error, getCookieRetry() failed to retrieve a cookie file!\n"
 	    "Most likely this is for invalid user or password, "
@@ -1381,24 +1373,21 @@ int doCookie(MY_SETTING *settings, SKELETON *dirs){
     return result;
   }
   else if(result != ztSuccess){
-    fprintf(stderr, "%s: Error, failed getCookieRetry() for:\n %s\n", progName, ztCode2Msg(result));
+    fprintf(stderr, "%s: Error, failed refreshCache() for:\n %s\n", progName, ztCode2Msg(result));
     if(cookieLogFP){
-      logMessage(cookieLogFP, "Error, failed getCookieRetry() for:");
-      logMessage(cookieLogFP, ztCode2Msg(result));
+      logMessage(cookieLogFP, "Error, failed refreshCache() for:");
+      logMessageLevel(cookieLogFP, LOG_ERROR, ztCode2Msg(result));
     }
 
     return result;
   }
 
-  memset(cookie, 0, sizeof(COOKIE));
-
-  result = parseCookieFile(cookie, cfiles.cookieFile);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed parseCookieFile() function.\n", progName);
-    if(cookieLogFP)
-      logMessage(cookieLogFP, "Error failed parseCookieFile() function.");
-
-    return result;
+  if(fVerbose){
+    fprintCookie(stdout, cookie);
+    if(fLogPtr){
+      syncLogger();
+      fprintCookie(fLogPtr, cookie);
+    }
   }
 
   /* test NEW cookie for expiration time - should never happen case! **/
@@ -1414,27 +1403,76 @@ int doCookie(MY_SETTING *settings, SKELETON *dirs){
 
 } /* END doCookie() **/
 
-int cookieSetFilenames(COOKIE_FILES *cfiles, SKELETON *dirs){
+/* cookieSetFilenames(): cookie and lock files in cookie cache directory;
+ * settings->cookieCache or {HOME}/.cache/getdiff, made when missing. Key in
+ * file name is from SHA-256 of OSM user name; credentials never show.
+ ******************************************************************************/
+
+int cookieSetFilenames(COOKIE_FILES *cfiles, MY_SETTING *settings){
 
-  ASSERTARGS(cfiles && dirs);
+  ASSERTARGS(cfiles && settings && settings->usr);
+
+  SHA256_CTX     ctx;
+  unsigned char  digest[SHA256_SIZE];
+  char           hex[SHA256_HEX_SIZE];
+  char           cacheDir[PATH_MAX];
+  char           name[PATH_MAX];
+  char           *home;
+  int            result;
 
   memset(cfiles, 0, sizeof(COOKIE_FILES));
 
-  cfiles->cookieFile = appendName2Dir(dirs->workDir, COOKIE_FILE);
+  if(settings->cookieCache){
+
+    if(snprintf(cacheDir, sizeof(cacheDir), "%s", settings->cookieCache) >= (int) sizeof(cacheDir))
+      return ztFnameLong;
+  }
+  else {
+
+    home = getHome();
+    if(! home){
+      fprintf(stderr, "cookieSetFilenames(): Error failed getHome().\n");
+      return ztFailedSysCall;
+    }
+
+    snprintf(cacheDir, sizeof(cacheDir), "%s/%s", home, COOKIE_CACHE_PARENT);
+    free(home);
+
+    result = myMkDir(cacheDir);
+    if(result != ztSuccess)
+      return result;
+
+    strncat(cacheDir, "/" COOKIE_CACHE_ENTRY, sizeof(cacheDir) - strlen(cacheDir) - 1);
+  }
+
+  result = myMkDir(cacheDir);
+  if(result != ztSuccess){
+    fprintf(stderr, "cookieSetFilenames(): Error failed myMkDir() for cookie cache: <%s>\n", cacheDir);
+    return result;
+  }
+
+  /* cookie is a credential; owner only **/
+  chmod(cacheDir, 0700);
+
+  sha256Init(&ctx);
+  sha256Update(&ctx, (const unsigned char *) settings->usr, strlen(settings->usr));
+  sha256Final(&ctx, digest);
+  sha256Hex(hex, digest);
+
+  snprintf(name, sizeof(name), "%s-%.16s.txt", COOKIE_FILE_PREFIX, hex);
+
+  cfiles->cookieFile = appendName2Dir(cacheDir, name);
   if(! cfiles->cookieFile){
     fprintf(stderr, "cookieSetFilenames(): Error failed appendName2Dir() for cookieFile.\n");
     return ztMemoryAllocate;
   }
 
-  cfiles->scriptFile = appendName2Dir(dirs->tmp, SCRIPT_FILE);
-  if(! cfiles->scriptFile){
-    fprintf(stderr, "cookieSetFilenames(): Error failed appendName2Dir() for scriptFile.\n");
-    return ztMemoryAllocate;
-  }
+  snprintf(name, sizeof(name), "%s-%.16s.lock", COOKIE_FILE_PREFIX, hex);
 
-  cfiles->jsonFile = appendName2Dir(dirs->tmp, JSON_FILE);
-  if(! cfiles->jsonFile){
-    fprintf(stderr, "cookieSetFilenames(): Error failed appendName2Dir() for jsonFile.\n");
+  cfiles->lockFile = appendName2Dir(cacheDir, name);
+  if(! cfiles->lockFile){
+    fprintf(stderr, "cookieSetFilenames(): Error failed appendName2Dir() for lockFile.\n");
+    zapCookieFiles(cfiles);
     return ztMemoryAllocate;
   }
 
@@ -1442,6 +1480,264 @@ int cookieSetFilenames(COOKIE_FILES *cfiles, SKELETON *dirs){
 
 } /* END cookieSetFilenames() **/
 
+void zapCookieFiles(COOKIE_FILES *cfiles){
+
+  if(! cfiles)
+    return;
+
+  if(cfiles->cookieFile)
+    free(cfiles->cookieFile);
+
+  if(cfiles->lockFile)
+    free(cfiles->lockFile);
+
+  memset(cfiles, 0, sizeof(COOKIE_FILES));
+
+} /* END zapCookieFiles() **/
+
+/* readCachedCookie(): parses cookie file in cache into 'ck'; ztNotCookieFile
+ * when missing or not a cookie file. Members from earlier parse are freed.
+ ******************************************************************************/
+
+static int readCachedCookie(COOKIE *ck, const char *cookieFile){
+
+  clearCookie(ck);
+
+  if(isFileUsable(cookieFile) != ztSuccess || ! isCookieFile((char *) cookieFile))
+
+    return ztNotCookieFile;
+
+  return parseCookieFile(ck, cookieFile);
+
+} /* END readCachedCookie() **/
+
+static void clearCookie(COOKIE *ck){
+
+  if(ck->token)
+    free(ck->token);
+
+  if(ck->expireTimeStr)
+    free(ck->expireTimeStr);
+
+  memset(ck, 0, sizeof(COOKIE));
+
+} /* END clearCookie() **/
+
+/* refreshCache(): renews cookie in cache when it expires in less than
+ * 'ahead' seconds; 'ck' is set to cookie in cache. Exclusive lock on cache
+ * lock file is held while checking and renewing, so only one instance logs
+ * in; others wait then read its cookie. 'retry' selects getCookieRetry().
+ ******************************************************************************/
+
+static int refreshCache(MY_SETTING *settings, COOKIE_FILES *cfiles, COOKIE *ck, time_t ahead, int retry){
+
+  time_t  now;
+  int     lockFD;
+  int     result;
+
+  lockFD = open(cfiles->lockFile, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if(lockFD < 0){
+    fprintf(stderr, "%s: Error failed open() for cookie lock file <%s>: %s\n",
+            progName, cfiles->lockFile, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  while(flock(lockFD, LOCK_EX) != 0){
+
+    if(errno != EINTR){
+      close(lockFD);
+      return ztFailedSysCall;
+    }
+  }
+
+  /* renewed by another instance while we waited? **/
+  result = readCachedCookie(ck, cfiles->cookieFile);
+
+  now = time(NULL);
+
+  if(result == ztSuccess && (ck->expireSeconds - now) > ahead){
+
+    if(cookieLogFP)
+      logMessage(cookieLogFP, "refreshCache():: Cookie in cache was renewed by another instance.");
+  }
+  else {
+
+    result = retry ? getCookieRetry(settings, cfiles) : getCookieFile(settings, cfiles);
+
+    if(result == ztSuccess)
+      result = readCachedCookie(ck, cfiles->cookieFile);
+
+    if(result == ztSuccess && cookieLogFP)
+      logMessage(cookieLogFP, "refreshCache():: Renewed cookie in cookie cache.");
+  }
+
+  flock(lockFD, LOCK_UN);
+  close(lockFD);
+
+  return result;
+
+} /* END refreshCache() **/
+
+/* startCookieRefresh(): starts thread to renew cookie COOKIE_REFRESH_AHEAD
+ * seconds before it expires; call after doCookie() while its cookie is
+ * set. New token is picked up with cookieTokenChanged() between transfers,
+ * so downloads never wait for login. 'settings' must outlive the thread.
+ ******************************************************************************/
+
+int startCookieRefresh(MY_SETTING *settings){
+
+  ASSERTARGS(settings);
+
+  int  result;
+
+  if(refreshOn)
+    return ztSuccess;
+
+  if(! (cookie && cookie->expireSeconds)){
+    fprintf(stderr, "startCookieRefresh(): Error; COOKIE structure is not initialized."
+            " Call doCookie() first.\n");
+    return ztInvalidArg;
+  }
+
+  result = cookieSetFilenames(&refreshFiles, settings);
+  if(result != ztSuccess)
+    return result;
+
+  refreshSetting = settings;
+  refreshExpire = cookie->expireSeconds;
+  refreshStop = 0;
+  refreshChanged = 0;
+
+  if(pthread_create(&refreshThread, NULL, refreshMain, NULL) != 0){
+    fprintf(stderr, "%s: Error failed pthread_create() for cookie refresh.\n", progName);
+    zapCookieFiles(&refreshFiles);
+    return ztFailedSysCall;
+  }
+
+  refreshOn = 1;
+
+  return ztSuccess;
+
+} /* END startCookieRefresh() **/
+
+/* cookieTokenChanged(): TRUE when cookie was renewed since last call;
+ * 'token' is set to new token - caller frees.
+ ******************************************************************************/
+
+int cookieTokenChanged(char **token){
+
+  int  changed = FALSE;
+
+  ASSERTARGS(token);
+
+  *token = NULL;
+
+  if(! refreshOn)
+    return FALSE;
+
+  pthread_mutex_lock(&refreshLock);
+
+  if(refreshChanged && refreshToken){
+    *token = STRDUP(refreshToken);
+    refreshChanged = 0;
+    changed = TRUE;
+  }
+
+  pthread_mutex_unlock(&refreshLock);
+
+  return changed;
+
+} /* END cookieTokenChanged() **/
+
+void stopCookieRefresh(void){
+
+  if(! refreshOn)
+    return;
+
+  pthread_mutex_lock(&refreshLock);
+  refreshStop = 1;
+  pthread_cond_signal(&refreshWake);
+  pthread_mutex_unlock(&refreshLock);
+
+  pthread_join(refreshThread, NULL);
+
+  if(refreshToken){
+    free(refreshToken);
+    refreshToken = NULL;
+  }
+
+  zapCookieFiles(&refreshFiles);
+
+  refreshOn = 0;
+
+} /* END stopCookieRefresh() **/
+
+/* refreshMain(): cookie refresh thread; sleeps until renewal time or stop,
+ * renews through cache, retries after COOKIE_RETRY_SECONDS on failure.
+ ******************************************************************************/
+
+static void *refreshMain(void *arg){
+
+  COOKIE           ck;
+  struct timespec  until;
+  time_t           wake;
+  int              result;
+
+  (void) arg;
+
+  memset(&ck, 0, sizeof(COOKIE));
+
+  pthread_mutex_lock(&refreshLock);
+
+  wake = refreshExpire - COOKIE_REFRESH_AHEAD;
+
+  while(! refreshStop){
+
+    if(time(NULL) < wake){
+
+      until.tv_sec = wake;
+      until.tv_nsec = 0;
+
+      pthread_cond_timedwait(&refreshWake, &refreshLock, &until);
+      continue;
+    }
+
+    pthread_mutex_unlock(&refreshLock);
+
+    result = refreshCache(refreshSetting, &refreshFiles, &ck, COOKIE_REFRESH_AHEAD, 0);
+
+    pthread_mutex_lock(&refreshLock);
+
+    if(result == ztSuccess && ck.token){
+
+      if(refreshToken)
+        free(refreshToken);
+
+      refreshToken = STRDUP(ck.token);
+      refreshExpire = ck.expireSeconds;
+      refreshChanged = 1;
+
+      if(cookieLogFP)
+        logMessage(cookieLogFP, "Cookie refresh: new cookie token is in use.");
+    }
+    else if(cookieLogFP)
+      logMessageLevel(cookieLogFP, LOG_ERROR, "Cookie refresh: Error failed to renew cookie; will retry.");
+
+    /* next renewal; retry later when renewal did not move expiry far enough **/
+    wake = refreshExpire - COOKIE_REFRESH_AHEAD;
+
+    if(wake <= time(NULL))
+      wake = time(NULL) + COOKIE_RETRY_SECONDS;
+  }
+
+  pthread_mutex_unlock(&refreshLock);
+
+  clearCookie(&ck);
+
+  return NULL;
+
+} /* END refreshMain() **/
+
 
 char *getCookieToken(){
 
@@ -1506,7 +1802,7 @@ int isCookieFile(char *name){
 
       fprintf (stderr, "%s: Error in isCookieFile() function: multiple lines found in file.\n",progName);
       if(cookieLogFP)
-        logMessage(cookieLogFP, "isCookieFile():: Error: multiple lines found in file.");
+        logMessageLevel(cookieLogFP, LOG_ERROR, "isCookieFile():: Error: multiple lines found in file.");
 
       fclose(filePtr);
       return FALSE;
@@ -1522,7 +1818,7 @@ int isCookieFile(char *name){
   if( ! (subStr && (subStr == myLine)) ){
     fprintf (stderr, "%s: Error in isCookieFile(): file does not start with string 'gf_download_oauth=login|'.\n", progName);
     if(cookieLogFP)
-      logMessage(cookieLogFP, "isCookieFile():: Error: file does not start with string 'gf_download_oauth=login|'.");
+      logMessageLevel(cookieLogFP, LOG_ERROR, "isCookieFile():: Error: file does not start with string 'gf_download_oauth=login|'.");
 
     return FALSE;
   }
@@ -1541,7 +1837,7 @@ int isCookieFile(char *name){
   if(count != 4){
     fprintf (stderr, "%s: Error in isCookieFile(): file does not have exactly 4 semi-colons, count is: %d\n", progName, count);
     if(cookieLogFP)
-      logMessage(cookieLogFP, "isCookieFile():: Error: file does not have exactly 4 semi-colons.");
+      logMessageLevel(cookieLogFP, LOG_ERROR, "isCookieFile():: Error: file does not have exactly 4 semi-colons.");
 
     return FALSE;
   }
@@ -1554,7 +1850,7 @@ int isCookieFile(char *name){
     if( ! strstr(myLine, *mover)){
       fprintf (stderr, "%s: Error in isCookieFile(): line does not contain sub-string: '%s'.\n", progName, *mover);
       if(cookieLogFP)
-        logMessage(cookieLogFP, "isCookieFile():: Error: line does not contain a required sub-string.");
+        logMessageLevel(cookieLogFP, LOG_ERROR, "isCookieFile():: Error: line does not contain a required sub-string.");
 
       return FALSE;
     }
@@ -0,0 +1,242 @@
+/*
+ * crc32.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * CRC32 for gzip trailer check; see crc32.h.
+ *
+ * PCLMULQDQ folding is from Intel paper "Fast CRC Computation for Generic
+ * Polynomials Using PCLMULQDQ Instruction" - bit reflected constants at end
+ * of the paper. Folds 64 bytes per round, needs at least 64 bytes and
+ * whole 16 bytes blocks; the tail goes to slicing-by-8.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "crc32.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HAVE_PCLMUL_CRC 1
+#include <immintrin.h>
+#endif
+
+static uint32_t crcTable[8][256];
+
+static pthread_once_t crcOnce = PTHREAD_ONCE_INIT;
+
+static int useClmul = 0;
+
+static void crc32Init(void);
+static uint32_t crc32Slice8(uint32_t crc, const unsigned char *buf, size_t len);
+
+#ifdef HAVE_PCLMUL_CRC
+static uint32_t crc32Clmul(const unsigned char *buf, size_t len, uint32_t crc);
+#endif
+
+unsigned int crc32Update(unsigned int crc, const unsigned char *buf, size_t len){
+
+  uint32_t  value = ~((uint32_t) crc);
+  size_t    chunk;
+
+  pthread_once(&crcOnce, crc32Init);
+
+#ifdef HAVE_PCLMUL_CRC
+  if(useClmul && len >= 64){
+
+    chunk = len & ~((size_t) 15);
+
+    value = crc32Clmul(buf, chunk, value);
+
+    buf += chunk;
+    len -= chunk;
+  }
+#else
+  (void) chunk;
+#endif
+
+  value = crc32Slice8(value, buf, len);
+
+  return (unsigned int) ~value;
+
+} /* END crc32Update() **/
+
+const char *crc32Method(void){
+
+  pthread_once(&crcOnce, crc32Init);
+
+  return useClmul ? "pclmul" : "slicing-by-8";
+
+} /* END crc32Method() **/
+
+static void crc32Init(void){
+
+  uint32_t  c;
+  int       n, k;
+
+  for(n = 0; n < 256; n++){
+
+    c = (uint32_t) n;
+    for(k = 0; k < 8; k++)
+      c = (c & 1) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+
+    crcTable[0][n] = c;
+  }
+
+  for(n = 0; n < 256; n++){
+
+    c = crcTable[0][n];
+    for(k = 1; k < 8; k++){
+      c = crcTable[0][c & 0xff] ^ (c >> 8);
+      crcTable[k][n] = c;
+    }
+  }
+
+#ifdef HAVE_PCLMUL_CRC
+  __builtin_cpu_init();
+  useClmul = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif
+
+} /* END crc32Init() **/
+
+static uint32_t crc32Slice8(uint32_t crc, const unsigned char *buf, size_t len){
+
+  uint32_t  one, two;
+
+  while(len && ((uintptr_t) buf & 7)){
+    crc = crcTable[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+    len--;
+  }
+
+  while(len >= 8){
+
+    memcpy(&one, buf, 4);
+    memcpy(&two, buf + 4, 4);
+
+    one ^= crc; /* little endian only; x86-64 and arm64 **/
+
+    crc = crcTable[7][one & 0xff] ^ crcTable[6][(one >> 8) & 0xff] ^
+          crcTable[5][(one >> 16) & 0xff] ^ crcTable[4][one >> 24] ^
+          crcTable[3][two & 0xff] ^ crcTable[2][(two >> 8) & 0xff] ^
+          crcTable[1][(two >> 16) & 0xff] ^ crcTable[0][two >> 24];
+
+    buf += 8;
+    len -= 8;
+  }
+
+  while(len--)
+    crc = crcTable[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+
+  return crc;
+
+} /* END crc32Slice8() **/
+
+#ifdef HAVE_PCLMUL_CRC
+
+/* crc32Clmul(): 'crc' is pre inverted; 'len' >= 64 and multiple of 16 **/
+
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc32Clmul(const unsigned char *buf, size_t len, uint32_t crc){
+
+  static const uint64_t k1k2[2] __attribute__((aligned(16))) = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+  static const uint64_t k3k4[2] __attribute__((aligned(16))) = { 0x01751997d0ULL, 0x00ccaa009eULL };
+  static const uint64_t k5k0[2] __attribute__((aligned(16))) = { 0x0163cd6124ULL, 0x0000000000ULL };
+  static const uint64_t poly[2] __attribute__((aligned(16))) = { 0x01db710641ULL, 0x01f7011641ULL };
+
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+  x1 = _mm_loadu_si128((const __m128i *) (buf + 0x00));
+  x2 = _mm_loadu_si128((const __m128i *) (buf + 0x10));
+  x3 = _mm_loadu_si128((const __m128i *) (buf + 0x20));
+  x4 = _mm_loadu_si128((const __m128i *) (buf + 0x30));
+
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int) crc));
+
+  x0 = _mm_load_si128((const __m128i *) k1k2);
+
+  buf += 64;
+  len -= 64;
+
+  /* fold 4 x 128 bits in parallel **/
+  while(len >= 64){
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+    y5 = _mm_loadu_si128((const __m128i *) (buf + 0x00));
+    y6 = _mm_loadu_si128((const __m128i *) (buf + 0x10));
+    y7 = _mm_loadu_si128((const __m128i *) (buf + 0x20));
+    y8 = _mm_loadu_si128((const __m128i *) (buf + 0x30));
+
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+    buf += 64;
+    len -= 64;
+  }
+
+  /* fold into 128 bits **/
+  x0 = _mm_load_si128((const __m128i *) k3k4);
+
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+  /* single 16 bytes blocks **/
+  while(len >= 16){
+
+    x2 = _mm_loadu_si128((const __m128i *) buf);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    buf += 16;
+    len -= 16;
+  }
+
+  /* 128 bits to 64 bits **/
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  x1 = _mm_srli_si128(x1, 8);
+  x1 = _mm_xor_si128(x1, x2);
+
+  x0 = _mm_loadl_epi64((const __m128i *) k5k0);
+
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, x3);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  /* Barrett reduction to 32 bits **/
+  x0 = _mm_load_si128((const __m128i *) poly);
+
+  x2 = _mm_and_si128(x1, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  return (uint32_t) _mm_extract_epi32(x1, 1);
+
+} /* END crc32Clmul() **/
+
+#endif /* HAVE_PCLMUL_CRC **/
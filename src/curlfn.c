@@ -12,6 +12,7 @@
  * The main functions are:
  *
  *  1 - download2File() --> download2FileRetry()
+ *      download2Memory() --> download2MemoryRetry() : body kept in memory
  *  2 - performQuery()  --> performQueryRetry()
  *
  * NOTES:
@@ -72,6 +73,8 @@
 
 #include "curlfn.h"
 #include "ansi_escapes.h"
+#include "logger.h"
+#include "metrics.h"
 
 /* global exported variables:
  *
@@ -781,6 +784,8 @@ curl_free(path);
     sizeDownload = (long) dlSize;
   }
 
+  metricsRequest(responseCode, (long long) dlSize);
+
   /* CURLINFO_CONTENT_LENGTH_DOWNLOAD_T is content-length value from header **/
   result = curl_easy_getinfo(handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &clSize);
   if(result != CURLE_OK){
@@ -994,6 +999,8 @@ int download2FileRetry(char *destFile, CURL *handle, CURLU *parseHandle){
 
     if (result == ztResponseNone) delay = 2 * delay;
 
+    metricsRetry(responseCode);
+
     sleep(delay);
   }
 
@@ -1044,6 +1051,218 @@ int download2FileRetry(char *destFile, CURL *handle, CURLU *parseHandle){
 
 } /* END download2FileRetry() **/
 
+/* download2Memory():
+ * same as download2File() but body is kept in 'dst' memory structure;
+ * nothing is written to disk. 'dst' is emptied first, then filled with
+ * whole body - not null terminated by server, WriteMemoryCallback() adds one.
+ *
+ * default write function (fwrite) is restored before return, so
+ * download2File() can use the same easy handle after this call.
+ *
+ * returns same codes as download2File(), ztBadSizeDownload when body size
+ * does not match content-length header.
+ *
+ ****************************************************************************/
+
+int download2Memory(MEMORY_STRUCT *dst, CURL *handle, CURLU *parseHandle){
+
+  CURLcode   result, performResult;
+
+  curl_off_t clSize;
+  curl_off_t dlSize;
+
+  char   logBuffer[PATH_MAX] = {0};
+
+
+  ASSERTARGS (dst && handle && parseHandle);
+
+  if (sessionFlag == 0){
+    fprintf(stderr, "download2Memory(): Error, curl session not initialized. You must call\n "
+	    " initialCurlSession() first and check its return value.\n");
+    if(curlLogtoFP)
+      writeLogCurl(curlLogtoFP, "download2Memory(): Error, curl session not initialized.");
+
+    return ztNoCurlSession;
+  }
+
+  /* start empty; retry reuses same structure **/
+  dst->size = 0;
+  if(dst->memory)
+    dst->memory[0] = '\0';
+
+  result = curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
+  if (result == CURLE_OK)
+    result = curl_easy_setopt(handle, CURLOPT_WRITEDATA, (void *) dst);
+  if (result == CURLE_OK)
+    result = curl_easy_setopt(handle, CURLOPT_XFERINFOFUNCTION, progressCallback);
+
+  if (result != CURLE_OK){
+    fprintf(stderr, "download2Memory(): Error failed curl_easy_setopt() for write function and data.\n");
+
+    if(curlLogtoFP)
+      writeLogCurl(curlLogtoFP, "download2Memory(): Error failed curl_easy_setopt() "
+                   "for write function and data.");
+
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, NULL);
+    return ztFailedLibCall;
+  }
+
+  fprintf(stdout, "Downloading to memory: %s\n", getUrlStringCURLU(parseHandle));
+
+  sizeDownload = 0L;
+  meterFull = 0;
+
+  performResult = curl_easy_perform(handle);
+
+  /* back to default fwrite() for download2File() **/
+  curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, NULL);
+  curl_easy_setopt(handle, CURLOPT_WRITEDATA, NULL);
+
+  result = curl_easy_getinfo (handle, CURLINFO_RESPONSE_CODE, &responseCode);
+  if (result != CURLE_OK){
+
+    responseCode = -1;
+
+    fprintf(stderr, "download2Memory(): Error failed curl_easy_getinfo() for CURLINFO_RESPONSE_CODE.\n");
+    if(curlLogtoFP)
+      writeLogCurl(curlLogtoFP,"download2Memory(): Error failed curl_easy_getinfo() for CURLINFO_RESPONSE_CODE.");
+
+    return ztFailedLibCall;
+  }
+
+  result = curl_easy_getinfo(handle, CURLINFO_SIZE_DOWNLOAD_T, &dlSize);
+  if(result == CURLE_OK)
+    result = curl_easy_getinfo(handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &clSize);
+
+  if(result != CURLE_OK){
+
+    fprintf(stderr, "download2Memory(): Error failed curl_easy_getinfo() for download sizes.\n");
+    if(curlLogtoFP)
+      writeLogCurl(curlLogtoFP,"download2Memory(): Error failed curl_easy_getinfo() for download sizes.");
+
+    return ztFailedLibCall;
+  }
+
+  sizeDownload = (long) dlSize;
+
+  metricsRequest(responseCode, (long long) dlSize);
+
+  if (performResult == CURLE_COULDNT_CONNECT)
+
+    return ztNetConnFailed;
+
+  if (performResult == CURLE_COULDNT_RESOLVE_HOST)
+
+    return ztHostResolveFailed;
+
+  if(performResult != CURLE_OK){
+
+    fprintf(stderr,"download2Memory(): Error failed curl_easy_perform() function.\n");
+    fprintf(stderr," Current Remote URL: <%s>\n", getUrlStringCURLU(parseHandle));
+    fprintf(stderr, " curl_easy_strerror() for result: <%s>\n", curl_easy_strerror(performResult));
+
+    if(curlLogtoFP){
+      sprintf(logBuffer,
+	      "download2Memory(): Error failed curl_easy_perform() function.\n"
+	      " Remote URL: <%s>\n"
+	      " curl_easy_strerror() for result: <%s>\n",
+	      getUrlStringCURLU(parseHandle), curl_easy_strerror(performResult));
+
+      writeLogCurl(curlLogtoFP, logBuffer);
+    }
+
+    return responseCode2ztCode(responseCode);
+  }
+
+  if(responseCode != OK_RESPONSE_CODE)
+
+    return responseCode2ztCode(responseCode);
+
+  /* size test; content-length of -1 is unknown **/
+  if(((long) clSize != -1 && (size_t) clSize != dst->size) ||
+     ((size_t) dlSize != dst->size)){
+
+    fprintf(stderr, "download2Memory(): Error failed 'size test'...\n"
+            "\tsizeDownload: %ld\n"
+            "\tsizeHeader: %ld\n"
+            "\tsizeMemory: %lu\n\n",
+            (long) dlSize, (long) clSize, (unsigned long) dst->size);
+
+    if(curlLogtoFP){
+      sprintf(logBuffer, "download2Memory(): Error failed 'size test'; URL: <%s>",
+              getUrlStringCURLU(parseHandle));
+      writeLogCurl(curlLogtoFP, logBuffer);
+    }
+
+    return ztBadSizeDownload;
+  }
+
+  return ztSuccess;
+
+} /* END download2Memory() **/
+
+/* download2MemoryRetry(): download2Memory() with download2FileRetry() rules **/
+
+int download2MemoryRetry(MEMORY_STRUCT *dst, CURL *handle, CURLU *parseHandle){
+
+  ASSERTARGS(dst && handle && parseHandle);
+
+  int   result;
+  int   delay = 2 * 5;
+
+  result = download2Memory(dst, handle, parseHandle);
+
+  if(result == ztSuccess)
+
+    return result;
+
+  if( (result == ztResponseNone)||
+      (result == ztResponse302) ||
+      (result == ztResponse500) ||
+      (result == ztResponse502) ||
+      (result == ztResponse503) ||
+      (result == ztResponse504) ||
+      (result == ztNetConnFailed) ||
+      (result == ztHostResolveFailed) ){
+
+    if (result == ztResponseNone) delay = 2 * delay;
+
+    metricsRetry(responseCode);
+
+    sleep(delay);
+  }
+  else {
+
+    fprintf(stderr,
+	    "download2MemoryRetry(): Error failed download2Memory() on first try and NO retry case.\n"
+        " function failed with Zone Tree Code: <%s>\n", ztCode2ErrorStr(result));
+
+    return result;
+  }
+
+  result = download2Memory(dst, handle, parseHandle);
+  if(result != ztSuccess){
+
+    fprintf(stderr,
+	    "download2MemoryRetry(): Error failed download2Memory() for second attempt.\n"
+	    " function failed with Zone Tree Code: <%s>\n", ztCode2ErrorStr(result));
+
+    if(curlLogtoFP){
+
+      char  logBuffer[PATH_MAX] = {0};
+
+      sprintf(logBuffer,
+	      "download2MemoryRetry(): Error failed download2Memory() for second attempt.\n"
+	      " function failed with Zone Tree Code: <%s>\n", ztCode2ErrorStr(result));
+
+      writeLogCurl(curlLogtoFP, logBuffer);
+    }
+  }
+
+  return result;
+
+} /* END download2MemoryRetry() **/
+
 
 /* getUrlStringCURLU():
  * Returns character pointer to string in current parse handle.
@@ -1061,7 +1280,7 @@ int download2FileRetry(char *destFile, CURL *handle, CURLU *parseHandle){
  *
  **************************************************************************/
 
-char *getUrlStringCURLU(const CURLU *parseUrlHandle){
+char *getUrlStringCURLU(CURLU *parseUrlHandle){
 
   CURLUcode  result; /* curl parse URL API return code **/
 
@@ -1113,7 +1332,15 @@ char *getUrlStringCURLU(const CURLU *parseUrlHandle){
 
     return url;
 
-  sprintf(myUrl, "%s://%s%s", scheme, host, path);
+  /* port is kept; a mirror is not on default port **/
+  char  *port = NULL;
+
+  if(curl_url_get(parseUrlHandle, CURLUPART_PORT, &port, 0) == CURLUE_OK && port){
+    sprintf(myUrl, "%s://%s:%s%s", scheme, host, port, path);
+    curl_free(port);
+  }
+  else
+    sprintf(myUrl, "%s://%s%s", scheme, host, path);
 
   url = STRDUP(myUrl); /* STRDUP() terminates program on memory failure! **/
 
@@ -1510,6 +1737,9 @@ int writeLogCurl(FILE *to, char *msg){
 
   myPID = getpid();
 
+  /* lines queued before this one are written first **/
+  syncLogger();
+
   fprintf(to, "\n- - - - - - - - - - - - Start Curl Functions Log - - - - - - - - - - - - - - -\n\n");
 
   fprintf (to, "%s [%d] writeLogCurl() received message below:\n %s\n", timestamp, (int) myPID, msg);
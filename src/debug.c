@@ -14,6 +14,8 @@
 #include "getdiff.h"
 #include "util.h"
 #include "ztError.h"
+#include "logger.h"
+#include "debug.h"
 
 
 void fprintPathPart(FILE *file, PATH_PART *pp){
@@ -89,19 +91,31 @@ void fprintStateInfo(FILE *toStream, STATE_INFO *si){
  * to the string "DONE" tail footer is written, otherwise 'msg' is appended to
  * current time then written to 'to' file.
  *
+ * Level is taken from 'msg' text by messageLevel(); lines that do not say
+ * their level - file names after "... file below:", debug output - go
+ * through logMessageLevel() with the level of the line they belong to.
+ *
  * It is an error if 'msg' is empty (string length == 0) or longer than PATH_MAX.
  *
  *****************************************************************************/
 
 int logMessage(FILE *to, char *msg){
 
-  char   *startTemplate =
-    "+++++++++++++++++++++++++++++++++++ STARTING +++++++++++++++++++++++++++++++++\n"
-    "%s [%d]: %s started. (Version: %s)\n";
+  ASSERTARGS (to && msg);
+
+  return logMessageLevel(to, messageLevel(msg), msg);
+
+} /* END logMessage() **/
+
+/* logMessageLevel(): logMessage() with explicit 'level'. When logger is
+ * running for 'to' the line is queued for writer thread and lines below log
+ * level are dropped; see logger.h. Otherwise it is written in place.
+ *
+ *****************************************************************************/
+
+int logMessageLevel(FILE *to, LOG_LEVEL level, char *msg){
 
-  char   *doneTemplate =
-    "%s [%d]: %s is done.\n"
-    "===================================== DONE ===================================\n\n";
+  int  kind = LOG_LINE;
 
   ASSERTARGS (to && msg);
 
@@ -115,42 +129,27 @@ int logMessage(FILE *to, char *msg){
     return ztInvalidArg;
   }
 
-  char   *timestamp = NULL;
-  pid_t   myPID;
-
-  char   tmpBuf[PATH_MAX] = {0};
-
-  timestamp = formatMsgHeadTime(); //vsprintf()
-  if(! timestamp){
-    fprintf(stderr,"logMessage(): Error failed formatMsgHeadTime().\n");
-    return ztMemoryAllocate;
-  }
-
-  myPID = getpid();
-
-  if(strcmp(msg, "START") == 0){
-
-    sprintf(tmpBuf, startTemplate, timestamp, (int) myPID, progName, VERSION);
-    fprintf(to, tmpBuf);
-  }
+  if(strcmp(msg, "START") == 0)
+    kind = LOG_START;
 
-  else if(strcmp(msg, "DONE") == 0){
+  else if(strcmp(msg, "DONE") == 0)
+    kind = LOG_DONE;
 
-    sprintf(tmpBuf, doneTemplate, timestamp, (int) myPID, progName);
-    fprintf(to, tmpBuf);
-  }
+  if(isLoggerFor(to)){
 
-  else{
+    if(kind != LOG_LINE)
+      level = LOG_ERROR;
 
-    fprintf (to, "%s [%d]: %s\n", timestamp, (int) myPID, msg);
+    if(queueLogLine(level, kind, msg) == ztSuccess)
+      return ztSuccess;
 
+    /* longer than a slot; keep order **/
+    syncLogger();
   }
 
-  fflush(to);
-
-  return ztSuccess;
+  return writeLogLine(to, kind, msg);
 
-} /* END logMessage() **/
+} /* END logMessageLevel() **/
 
 #define OK_TEMPLATE "  member \"%s\" is set to: %s\n"
 #define NEG_TEMPLATE "  member \"%s\" is not set.\n"
@@ -249,16 +248,46 @@ void fprintGdFiles(FILE *toFP, GD_FILES *gdfiles){
   else
     fprintf(destFP, NEG_TEMPLATE, "newDiffersFile");
 
+  if(gdfiles->cursorFile)
+    fprintf(destFP, OK_TEMPLATE, "cursorFile", gdfiles->cursorFile);
+  else
+    fprintf(destFP, NEG_TEMPLATE, "cursorFile");
+
   if(gdfiles->rangeFile)
     fprintf(destFP, OK_TEMPLATE, "rangeFile", gdfiles->rangeFile);
   else
     fprintf(destFP, NEG_TEMPLATE, "rangeFile");
 
+  if(gdfiles->expireFile)
+    fprintf(destFP, OK_TEMPLATE, "expireFile", gdfiles->expireFile);
+  else
+    fprintf(destFP, NEG_TEMPLATE, "expireFile");
+
   if(gdfiles->latestStateFile)
     fprintf(destFP, OK_TEMPLATE, "latestStateFile", gdfiles->latestStateFile);
   else
     fprintf(destFP, NEG_TEMPLATE, "latestStateFile");
 
+  if(gdfiles->sourceDir)
+    fprintf(destFP, OK_TEMPLATE, "sourceDir", gdfiles->sourceDir);
+  else
+    fprintf(destFP, NEG_TEMPLATE, "sourceDir");
+
+  if(gdfiles->sourceLockFile)
+    fprintf(destFP, OK_TEMPLATE, "sourceLockFile", gdfiles->sourceLockFile);
+  else
+    fprintf(destFP, NEG_TEMPLATE, "sourceLockFile");
+
+  if(gdfiles->sourceTmp)
+    fprintf(destFP, OK_TEMPLATE, "sourceTmp", gdfiles->sourceTmp);
+  else
+    fprintf(destFP, NEG_TEMPLATE, "sourceTmp");
+
+  if(gdfiles->journalFile)
+    fprintf(destFP, OK_TEMPLATE, "journalFile", gdfiles->journalFile);
+  else
+    fprintf(destFP, NEG_TEMPLATE, "journalFile");
+
   fprintf(destFP, "fprintGdfiles() is Done.\n\n");
 
   return;
@@ -319,6 +348,16 @@ void fprintSetting(FILE *toFP, MY_SETTING *settings){
   else
     fprintf(destFP, NEG_TEMPLATE, "endNumber");
 
+  if(settings->eventsPath)
+    fprintf(destFP, OK_TEMPLATE, "eventsPath", settings->eventsPath);
+  else
+    fprintf(destFP, NEG_TEMPLATE, "eventsPath");
+
+  if(settings->streamTarget)
+    fprintf(destFP, OK_TEMPLATE, "streamTarget", settings->streamTarget);
+  else
+    fprintf(destFP, NEG_TEMPLATE, "streamTarget");
+
   if(settings->verbose)
     fprintf(destFP, "  member \"verbose\" is On.\n");
   else
@@ -334,6 +373,82 @@ void fprintSetting(FILE *toFP, MY_SETTING *settings){
   else
     fprintf(destFP, "  member \"textOnly\" is Off.\n");
 
+  if(settings->streamTee)
+    fprintf(destFP, "  member \"streamTee\" is On.\n");
+  else
+    fprintf(destFP, "  member \"streamTee\" is Off.\n");
+
+  if(settings->merge)
+    fprintf(destFP, "  member \"merge\" is On.\n");
+  else
+    fprintf(destFP, "  member \"merge\" is Off.\n");
+
+  fprintf(destFP, "  member \"zstdMode\" is: %d\n", settings->zstdMode);
+
+  for(int index = 0; index < settings->numRegions; index++)
+    fprintf(destFP, "  member \"regionArgs[%d]\" is: <%s>\n", index, settings->regionArgs[index]);
+
+  if(settings->summary)
+    fprintf(destFP, "  member \"summary\" is On.\n");
+  else
+    fprintf(destFP, "  member \"summary\" is Off.\n");
+
+  if(settings->expire)
+    fprintf(destFP, "  member \"expire\" is On; zoom levels: %d to %d\n", settings->expireMinZoom, settings->expireMaxZoom);
+  else
+    fprintf(destFP, "  member \"expire\" is Off.\n");
+
+  fprintf(destFP, "  member \"retainDays\" is: %ld\n", settings->retainDays);
+  fprintf(destFP, "  member \"retainCount\" is: %ld\n", settings->retainCount);
+  fprintf(destFP, "  member \"retainBytes\" is: %lld\n", settings->retainBytes);
+
+  if(settings->index)
+    fprintf(destFP, "  member \"index\" is On.\n");
+  else
+    fprintf(destFP, "  member \"index\" is Off.\n");
+
+  if(settings->pack)
+    fprintf(destFP, "  member \"pack\" is On.\n");
+  else
+    fprintf(destFP, "  member \"pack\" is Off.\n");
+
+  if(settings->storeDir)
+    fprintf(destFP, "  member \"storeDir\" is: <%s>\n", settings->storeDir);
+
+  if(settings->cookieCache)
+    fprintf(destFP, "  member \"cookieCache\" is: <%s>\n", settings->cookieCache);
+
+  if(settings->loginHost)
+    fprintf(destFP, "  member \"loginHost\" is: <%s>\n", settings->loginHost);
+
+  if(settings->consumerURL)
+    fprintf(destFP, "  member \"consumerURL\" is: <%s>\n", settings->consumerURL);
+
+  if(settings->publicMeta)
+    fprintf(destFP, "  member \"publicMeta\" is On.\n");
+  else
+    fprintf(destFP, "  member \"publicMeta\" is Off.\n");
+
+  if(settings->logLevel)
+    fprintf(destFP, "  member \"logLevel\" is: <%s>\n", settings->logLevel);
+
+  if(settings->metricsDir)
+    fprintf(destFP, "  member \"metricsDir\" is: <%s>\n", settings->metricsDir);
+
+  fprintf(destFP, "  member \"command\" is: %d\n", (int) settings->command);
+
+  if(settings->command == CMD_ACK)
+    fprintf(destFP, "  member \"ackCount\" is: %ld\n", settings->ackCount);
+
+  if(settings->lookupObject)
+    fprintf(destFP, "  member \"lookupObject\" is: <%s>\n", settings->lookupObject);
+
+  if(settings->extractArg)
+    fprintf(destFP, "  member \"extractArg\" is: <%s>\n", settings->extractArg);
+
+  if(settings->serveArg)
+    fprintf(destFP, "  member \"serveArg\" is: <%s>\n", settings->serveArg);
+
   fprintf(destFP, "fprintSetting() is Done.\n\n");
 
   return;
@@ -0,0 +1,287 @@
+/*
+ * events.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * per pair completion events to the updater; see events.h.
+ *
+ * channel path is a named pipe (FIFO) or Unix domain stream socket made by
+ * the updater; a FIFO is created if path does not exist. We connect lazily,
+ * updater may start after us. A record is never split: FIFO writes are not
+ * more than PIPE_BUF bytes (atomic); on a socket a short write closes the
+ * connection so reader does not see a broken line.
+ *
+ * Records may come from zstd worker threads; eventsLock keeps connect, send
+ * and close of the descriptor to one thread at a time. Callers send in
+ * sequence order - see transcode.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "events.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+#include "debug.h"
+
+static char  *eventsPath = NULL;
+static int   eventsFD = -1;
+static int   isSocket = 0;
+
+static pthread_mutex_t  eventsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static int connectEvents(void);
+static int sendRecord(const char *record, size_t length);
+
+/* openEvents(): sets events channel to 'path'.
+ * not having a reader yet is not an error.
+ *
+ ***************************************************************************/
+
+int openEvents(const char *path){
+
+  ASSERTARGS(path);
+
+  struct stat  status;
+
+  if(eventsPath)
+    closeEvents();
+
+  /* reader may go away any time; get EPIPE instead of being killed **/
+  signal(SIGPIPE, SIG_IGN);
+
+  errno = 0;
+  if(stat(path, &status) != 0){
+
+    if(errno != ENOENT){
+      fprintf(stderr, "%s: Error failed stat() for events path <%s>: %s\n", progName, path, strerror(errno));
+      return ztFailedSysCall;
+    }
+
+    if(mkfifo(path, S_IRUSR | S_IWUSR) != 0){
+      fprintf(stderr, "%s: Error failed mkfifo() for events path <%s>: %s\n", progName, path, strerror(errno));
+      return ztFailedSysCall;
+    }
+
+    isSocket = 0;
+  }
+  else if(S_ISFIFO(status.st_mode))
+
+    isSocket = 0;
+
+  else if(S_ISSOCK(status.st_mode)){
+
+    if(strlen(path) >= sizeof(((struct sockaddr_un *) 0)->sun_path)){
+      fprintf(stderr, "%s: Error events socket path is too long: <%s>\n", progName, path);
+      return ztFnameLong;
+    }
+
+    isSocket = 1;
+  }
+  else {
+    fprintf(stderr, "%s: Error events path <%s> is not a FIFO or socket.\n", progName, path);
+    return ztInvalidArg;
+  }
+
+  eventsPath = STRDUP(path);
+
+  pthread_mutex_lock(&eventsLock);
+  connectEvents();
+  pthread_mutex_unlock(&eventsLock);
+
+  return ztSuccess;
+
+} /* END openEvents() **/
+
+/* emitPairEvent(): writes one record for completed change file and its
+ * state.txt file; both are local names. Dropped record is logged, it is
+ * not an error - 'newerFiles.txt' still has every completed pair.
+ *
+ ***************************************************************************/
+
+int emitPairEvent(const char *oscFile, const char *stateFile){
+
+  ASSERTARGS(oscFile && stateFile);
+
+  char        record[EVENT_MAX_RECORD];
+  char        oscJson[PATH_MAX], stateJson[PATH_MAX];
+  char        timeStr[32] = {0};
+  char        *src, *dst;
+  long        size = 0;
+  int         length;
+  int         result;
+  STATE_INFO  *si;
+
+  if(!eventsPath)
+
+    return ztSuccess;
+
+  si = initialStateInfo();
+  if(!si){
+    fprintf(stderr, "%s: Error failed initialStateInfo().\n", progName);
+    logMessage(fLogPtr, "Error failed initialStateInfo().");
+    return ztMemoryAllocate;
+  }
+
+  result = stateFile2StateInfo(si, stateFile);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed stateFile2StateInfo() for event.\n", progName);
+    logMessage(fLogPtr, "Error failed stateFile2StateInfo() for event.");
+    zapStateInfo(&si);
+    return result;
+  }
+
+  /* state.txt escapes colons: 2026-10-18T10\:20\:02Z **/
+  for(src = si->timeString, dst = timeStr; *src && dst < timeStr + sizeof(timeStr) - 1; src++)
+    if(*src != '\\')
+      *dst++ = *src;
+
+  getFileSize(&size, oscFile);
+
+  if(!jsonEscape(oscJson, sizeof(oscJson), oscFile) ||
+     !jsonEscape(stateJson, sizeof(stateJson), stateFile)){
+    zapStateInfo(&si);
+    return ztInvalidArg;
+  }
+
+  length = snprintf(record, sizeof(record),
+                    "{\"path\":\"%s\",\"state\":\"%s\",\"sequence\":%s,\"timestamp\":\"%s\",\"size\":%ld}\n",
+                    oscJson, stateJson, si->seqNumStr, timeStr, size);
+
+  zapStateInfo(&si);
+
+  if(length < 0 || length >= (int) sizeof(record)){
+    logMessage(fLogPtr, "Event record is too long; dropped.");
+    return ztSuccess;
+  }
+
+  pthread_mutex_lock(&eventsLock);
+  result = sendRecord(record, (size_t) length);
+  pthread_mutex_unlock(&eventsLock);
+
+  if(result != ztSuccess){
+
+    logMessageLevel(fLogPtr, LOG_WARNING, "No events reader or reader is behind; dropped event for file below:");
+    logMessageLevel(fLogPtr, LOG_WARNING, (char *) oscFile);
+
+    return ztSuccess;
+  }
+
+  if(fVerbose)
+    fprintf(stdout, "%s: Sent event for: %s\n", progName, oscFile);
+
+  return ztSuccess;
+
+} /* END emitPairEvent() **/
+
+void closeEvents(void){
+
+  pthread_mutex_lock(&eventsLock);
+
+  if(eventsFD >= 0)
+    close(eventsFD);
+
+  eventsFD = -1;
+
+  pthread_mutex_unlock(&eventsLock);
+
+  if(eventsPath)
+    free(eventsPath);
+
+  eventsPath = NULL;
+
+} /* END closeEvents() **/
+
+/* connectEvents(): non-blocking connect / open; returns ztSuccess when
+ * a reader is there. Caller holds eventsLock.
+ **************************************************************************/
+
+static int connectEvents(void){
+
+  struct sockaddr_un  address;
+  int                 fd;
+
+  if(eventsFD >= 0)
+
+    return ztSuccess;
+
+  if(!isSocket){
+
+    /* ENXIO: nobody has FIFO open for reading yet **/
+    fd = open(eventsPath, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if(fd < 0)
+      return ztFailedSysCall;
+
+    eventsFD = fd;
+    return ztSuccess;
+  }
+
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(fd < 0)
+    return ztFailedSysCall;
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, eventsPath);
+
+  if(connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0){
+    close(fd);
+    return ztFailedSysCall;
+  }
+
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  eventsFD = fd;
+
+  return ztSuccess;
+
+} /* END connectEvents() **/
+
+/* sendRecord(): one retry with fresh connection when reader went away **/
+
+static int sendRecord(const char *record, size_t length){
+
+  ssize_t  count;
+  int      tries;
+
+  for(tries = 0; tries < 2; tries++){
+
+    if(connectEvents() != ztSuccess)
+
+      return ztFailedSysCall;
+
+    if(isSocket)
+      count = send(eventsFD, record, length, MSG_NOSIGNAL);
+    else
+      count = write(eventsFD, record, length);
+
+    if(count == (ssize_t) length)
+
+      return ztSuccess;
+
+    if(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+
+      return ztFailedSysCall; /* reader is behind; keep connection **/
+
+    /* EPIPE, short socket write or other error; start over **/
+    close(eventsFD);
+    eventsFD = -1;
+
+    if(count > 0) /* part of a record went out; do not send it twice **/
+      return ztFailedSysCall;
+  }
+
+  return ztFailedSysCall;
+
+} /* END sendRecord() **/
+
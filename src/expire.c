@@ -0,0 +1,850 @@
+/*
+ * expire.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * tile expiry list; see expire.h.
+ *
+ * jobs keep tiles at max zoom only, sorted and without duplicates per file,
+ * then add them to run array under a lock. Lower zoom tiles are made at the
+ * end by shifting x and y; one sort over all gives deduplicated output in
+ * zoom, x, y order.
+ *
+ * node cache maps node id to its tile at EXPIRE_MAX_ZOOM, like region.c
+ * object cache; kept between runs in EXPIRE_CACHE. A job reads its file on
+ * its own, then waits for its turn - files in submit order - to look up and
+ * update cache: moved or deleted node expires its old tile, way and
+ * relation expire tiles of nodes they reference.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "expire.h"
+#include "osc.h"
+#include "workers.h"
+#include "util.h"
+#include "fileio.h"
+#include "ztError.h"
+#include "getdiff.h"
+#include "debug.h"
+
+/* zoom in top byte, then x and y 28 bits each; sorts as zoom, x, y **/
+#define TILE_KEY(z, x, y)   (((uint64_t) (z) << 56) | ((uint64_t) (x) << 28) | (uint64_t) (y))
+#define TILE_ZOOM(key)      ((int) ((key) >> 56))
+#define TILE_X(key)         ((uint32_t) (((key) >> 28) & 0x0FFFFFFF))
+#define TILE_Y(key)         ((uint32_t) ((key) & 0x0FFFFFFF))
+
+/* web mercator limit **/
+#define MAX_LATITUDE   85.0511287798
+
+#define CACHE_MAGIC    "getdiff-expire-cache 1\n"
+#define CACHE_INITIAL  ((size_t) 1 << 16)
+
+/* node id in job list; deleted node has top bit set **/
+#define NODE_DELETED   ((uint64_t) 1 << 63)
+
+typedef struct TILE_ARRAY_ {
+
+  uint64_t  *keys;
+  size_t    count;
+  size_t    size;
+
+} TILE_ARRAY;
+
+/* open addressing node id -> tile key at EXPIRE_MAX_ZOOM **/
+typedef struct NODE_TILE_TABLE_ {
+
+  uint64_t  *keys;   /* zero is empty slot **/
+  uint64_t  *tiles;  /* zero: node has no tile **/
+  size_t    size;    /* power of two **/
+  size_t    count;
+
+} NODE_TILE_TABLE;
+
+typedef struct EXPIRE_JOB_ {
+
+  char           *oscFile;
+  unsigned long  ticket;
+
+} EXPIRE_JOB;
+
+static WORK_POOL        *expirePool = NULL;
+static int              expireMinZoom = 0;
+static int              expireMaxZoom = 0;
+static TILE_ARRAY       runTiles = {NULL, 0, 0};
+static long             runFiles = 0;
+static pthread_mutex_t  tilesLock = PTHREAD_MUTEX_INITIALIZER;
+
+static char             *cacheFile = NULL;
+static unsigned long    nextTicket = 0;     /* main thread only **/
+
+/* cacheLock: nodeCache and nextTurn **/
+static pthread_mutex_t  cacheLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   turnCond = PTHREAD_COND_INITIALIZER;
+static NODE_TILE_TABLE  nodeCache = {NULL, NULL, 0, 0};
+static unsigned long    nextTurn = 0;
+
+static int expireJob(void *arg);
+static void freeJob(void *arg);
+static int applyNodes(TILE_ARRAY *tiles, const TILE_ARRAY *nodes, const TILE_ARRAY *refs);
+static int appendRefs(TILE_ARRAY *refs, const OSC_ELEMENT *element);
+static uint64_t cacheGet(NODE_TILE_TABLE *table, uint64_t key);
+static int cacheSet(NODE_TILE_TABLE *table, uint64_t key, uint64_t tile);
+static int growCache(NODE_TILE_TABLE *table, size_t newSize);
+static size_t slotOf(const NODE_TILE_TABLE *table, uint64_t key);
+static int loadCache(void);
+static int saveCache(void);
+static void freeCache(void);
+static int appendTile(TILE_ARRAY *array, uint64_t key);
+static void uniqueTiles(TILE_ARRAY *array);
+static int readTilesFile(TILE_ARRAY *array, const char *tilesFile);
+
+/* string2ZoomRange(): "14" or "12-16" **/
+
+int string2ZoomRange(int *minZoom, int *maxZoom, const char *string){
+
+  ASSERTARGS(minZoom && maxZoom && string);
+
+  char  *endPtr;
+  long  first, last;
+
+  errno = 0;
+  first = strtol(string, &endPtr, 10);
+  if(errno || endPtr == string)
+    return ztInvalidArg;
+
+  last = first;
+
+  if(*endPtr == '-'){
+
+    string = endPtr + 1;
+
+    last = strtol(string, &endPtr, 10);
+    if(errno || endPtr == string)
+      return ztInvalidArg;
+  }
+
+  if(*endPtr != '\0' || first < 0 || last > EXPIRE_MAX_ZOOM || first > last)
+    return ztInvalidArg;
+
+  *minZoom = (int) first;
+  *maxZoom = (int) last;
+
+  return ztSuccess;
+
+} /* END string2ZoomRange() **/
+
+/* startExpire(): loads node cache from 'sourceDir'/EXPIRE_CACHE **/
+
+int startExpire(int minZoom, int maxZoom, const char *sourceDir){
+
+  ASSERTARGS(sourceDir);
+
+  int  result;
+
+  if(minZoom < 0 || maxZoom > EXPIRE_MAX_ZOOM || minZoom > maxZoom)
+    return ztInvalidArg;
+
+  cacheFile = appendName2Dir(sourceDir, EXPIRE_CACHE);
+  if(!cacheFile)
+    return ztMemoryAllocate;
+
+  result = loadCache();
+  if(result != ztSuccess){
+    freeCache();
+    return result;
+  }
+
+  expirePool = initialWorkPool(numCPUs() > 1 ? numCPUs() - 1 : 1, expireJob, freeJob);
+  if(!expirePool){
+    fprintf(stderr, "%s: Error failed initialWorkPool().\n", progName);
+    freeCache();
+    return ztFailedSysCall;
+  }
+
+  expireMinZoom = minZoom;
+  expireMaxZoom = maxZoom;
+  runFiles = 0;
+  nextTicket = nextTurn = 0;
+
+  return ztSuccess;
+
+} /* END startExpire() **/
+
+int isExpiring(void){
+
+  return (expirePool != NULL);
+
+} /* END isExpiring() **/
+
+int expirePair(const char *oscFile){
+
+  ASSERTARGS(oscFile);
+
+  EXPIRE_JOB  *job;
+  int         result;
+
+  job = (EXPIRE_JOB *) malloc(sizeof(EXPIRE_JOB));
+  if(!job){
+    fprintf(stderr, "%s: Error allocating memory in expirePair().\n", progName);
+    return ztMemoryAllocate;
+  }
+
+  job->oscFile = STRDUP(oscFile);
+  job->ticket = nextTicket++;
+
+  result = submitWork(expirePool, job);
+  if(result != ztSuccess){
+    /* not queued; no later ticket is out yet **/
+    nextTicket--;
+    freeJob(job);
+  }
+
+  return result;
+
+} /* END expirePair() **/
+
+/* finishExpire(): waits for queued files then writes 'tilesFile' - merged
+ * with tiles already in it - and saves node cache. NULL 'tilesFile' only
+ * waits and drops tiles; used on error exit.
+ *
+ ***************************************************************************/
+
+int finishExpire(const char *tilesFile){
+
+  TILE_ARRAY  all = {NULL, 0, 0};
+  FILE        *filePtr;
+  char        partFile[PATH_MAX];
+  char        logBuffer[PATH_MAX + 64];
+  size_t      index, base;
+  uint64_t    key;
+  int         zoom;
+  int         result;
+
+  if(!expirePool)
+    return ztSuccess;
+
+  result = finishWorkPool(&expirePool);
+
+  if(result == ztSuccess && tilesFile)
+    result = saveCache();
+
+  freeCache();
+
+  if(result != ztSuccess || !tilesFile || !runTiles.count){
+    free(runTiles.keys);
+    memset(&runTiles, 0, sizeof(TILE_ARRAY));
+    return result;
+  }
+
+  all = runTiles;
+  memset(&runTiles, 0, sizeof(TILE_ARRAY));
+
+  uniqueTiles(&all);
+
+  /* lower zoom levels from max zoom tiles **/
+  base = all.count;
+
+  for(zoom = expireMaxZoom - 1; zoom >= expireMinZoom && result == ztSuccess; zoom--){
+
+    for(index = 0; index < base && result == ztSuccess; index++){
+
+      key = all.keys[index];
+      result = appendTile(&all, TILE_KEY(zoom, TILE_X(key) >> (expireMaxZoom - zoom), TILE_Y(key) >> (expireMaxZoom - zoom)));
+    }
+  }
+
+  if(result == ztSuccess)
+    result = readTilesFile(&all, tilesFile);
+
+  if(result != ztSuccess){
+    free(all.keys);
+    return result;
+  }
+
+  uniqueTiles(&all);
+
+  if(snprintf(partFile, sizeof(partFile), "%s.part", tilesFile) >= (int) sizeof(partFile)){
+    free(all.keys);
+    return ztFnameLong;
+  }
+
+  errno = 0;
+  filePtr = fopen(partFile, "w");
+  if(!filePtr){
+    fprintf(stderr, "%s: Error failed fopen() for <%s>: %s\n", progName, partFile, strerror(errno));
+    free(all.keys);
+    return ztOpenFileError;
+  }
+
+  for(index = 0; index < all.count; index++)
+    fprintf(filePtr, "%d/%u/%u\n", TILE_ZOOM(all.keys[index]), TILE_X(all.keys[index]), TILE_Y(all.keys[index]));
+
+  if(ferror(filePtr))
+    result = ztWriteError;
+
+  if(fclose(filePtr) != 0)
+    result = ztWriteError;
+
+  if(result == ztSuccess && rename(partFile, tilesFile) != 0){
+    fprintf(stderr, "%s: Error failed rename() to <%s>: %s\n", progName, tilesFile, strerror(errno));
+    result = ztFailedSysCall;
+  }
+
+  if(result != ztSuccess)
+    removeFile(partFile);
+  else {
+    snprintf(logBuffer, sizeof(logBuffer), "Wrote <%lu> expired tiles from <%ld> change files to: %s",
+             (unsigned long) all.count, runFiles, tilesFile);
+    logMessage(fLogPtr, logBuffer);
+
+    if(fVerbose)
+      fprintf(stdout, "%s: %s\n", progName, logBuffer);
+  }
+
+  free(all.keys);
+
+  return result;
+
+} /* END finishExpire() **/
+
+/* lonLat2Tile(): web mercator (slippy map) tile numbers **/
+
+int lonLat2Tile(uint32_t *x, uint32_t *y, double lon, double lat, int zoom){
+
+  ASSERTARGS(x && y);
+
+  double  n, latRad, tileX, tileY;
+
+  if(zoom < 0 || zoom > EXPIRE_MAX_ZOOM || lon < -180.0 || lon > 180.0 || lat < -90.0 || lat > 90.0)
+    return ztInvalidArg;
+
+  if(lat > MAX_LATITUDE)
+    lat = MAX_LATITUDE;
+  else if(lat < -MAX_LATITUDE)
+    lat = -MAX_LATITUDE;
+
+  n = (double) (1U << zoom);
+  latRad = lat * M_PI / 180.0;
+
+  tileX = (lon + 180.0) / 360.0 * n;
+  tileY = (1.0 - log(tan(latRad) + 1.0 / cos(latRad)) / M_PI) / 2.0 * n;
+
+  /* lon 180 and lat -MAX_LATITUDE land one past last tile **/
+  if(tileX >= n) tileX = n - 1;
+  if(tileY >= n) tileY = n - 1;
+  if(tileY < 0) tileY = 0;
+
+  *x = (uint32_t) tileX;
+  *y = (uint32_t) tileY;
+
+  return ztSuccess;
+
+} /* END lonLat2Tile() **/
+
+/* expireJob(): 'arg' is EXPIRE_JOB; file is read first, cache is used
+ * in ticket order. A failed read still takes its turn, so later files
+ * do not wait for ever.
+ *
+ ***************************************************************************/
+
+static int expireJob(void *arg){
+
+  EXPIRE_JOB   *job = (EXPIRE_JOB *) arg;
+  OSC_READER   *reader;
+  OSC_ELEMENT  element;
+  TILE_ARRAY   tiles = {NULL, 0, 0};
+  TILE_ARRAY   nodes = {NULL, 0, 0};   /* node id then its tile; zero none **/
+  TILE_ARRAY   refs = {NULL, 0, 0};    /* node ids in ways and relations **/
+  uint64_t     *newKeys;
+  uint64_t     tile;
+  uint32_t     x, y;
+  size_t       newSize;
+  int          result;
+
+  reader = oscOpen(job->oscFile);
+  if(!reader){
+    fprintf(stderr, "%s: Error failed oscOpen() for: <%s>\n", progName, job->oscFile);
+    result = ztOpenFileError;
+  }
+  else {
+
+    while((result = oscNext(reader, &element)) == ztSuccess){
+
+      if(element.type != OSC_NODE){
+
+        /* deleted way or relation has no members in change file **/
+        if(element.action != OSC_DELETE)
+          result = appendRefs(&refs, &element);
+      }
+      else {
+
+        tile = 0;
+        if(element.hasLocation && lonLat2Tile(&x, &y, element.lon, element.lat, EXPIRE_MAX_ZOOM) == ztSuccess)
+          tile = TILE_KEY(EXPIRE_MAX_ZOOM, x, y);
+
+        result = appendTile(&nodes, (uint64_t) element.id | (element.action == OSC_DELETE ? NODE_DELETED : 0));
+        if(result == ztSuccess)
+          result = appendTile(&nodes, tile);
+      }
+
+      if(result != ztSuccess)
+        break;
+    }
+
+    oscClose(&reader);
+
+    if(result == ztEndOfFile)
+      result = ztSuccess;
+    else {
+      fprintf(stderr, "%s: Error failed reading change file: <%s>\n", progName, job->oscFile);
+      if(result == ztSuccess)
+        result = ztUnknownError;
+    }
+  }
+
+  pthread_mutex_lock(&cacheLock);
+
+  while(nextTurn != job->ticket)
+    pthread_cond_wait(&turnCond, &cacheLock);
+
+  if(result == ztSuccess)
+    result = applyNodes(&tiles, &nodes, &refs);
+
+  nextTurn++;
+  pthread_cond_broadcast(&turnCond);
+
+  pthread_mutex_unlock(&cacheLock);
+
+  free(nodes.keys);
+  free(refs.keys);
+
+  if(result != ztSuccess){
+    free(tiles.keys);
+    return result;
+  }
+
+  uniqueTiles(&tiles);
+
+  pthread_mutex_lock(&tilesLock);
+
+  if(runTiles.count + tiles.count > runTiles.size){
+
+    newSize = runTiles.size ? runTiles.size : 4096;
+    while(newSize < runTiles.count + tiles.count)
+      newSize *= 2;
+
+    newKeys = (uint64_t *) realloc(runTiles.keys, newSize * sizeof(uint64_t));
+    if(newKeys){
+      runTiles.keys = newKeys;
+      runTiles.size = newSize;
+    }
+    else
+      result = ztMemoryAllocate;
+  }
+
+  if(result == ztSuccess && tiles.count){
+    memcpy(runTiles.keys + runTiles.count, tiles.keys, tiles.count * sizeof(uint64_t));
+    runTiles.count += tiles.count;
+  }
+
+  runFiles++;
+
+  pthread_mutex_unlock(&tilesLock);
+
+  free(tiles.keys);
+
+  if(result != ztSuccess)
+    fprintf(stderr, "%s: Error allocating memory in expireJob().\n", progName);
+
+  return result;
+
+} /* END expireJob() **/
+
+static void freeJob(void *arg){
+
+  EXPIRE_JOB  *job = (EXPIRE_JOB *) arg;
+
+  if(!job)
+    return;
+
+  free(job->oscFile);
+  free(job);
+
+} /* END freeJob() **/
+
+/* applyNodes(): caller holds cacheLock. Nodes first - old tile from cache
+ * and tile in file, cache is set; deleted node is taken out - then
+ * referenced nodes from cache; ways in file see final node tiles, file
+ * order of elements does not matter. Tiles go to 'tiles' at expireMaxZoom.
+ *
+ ***************************************************************************/
+
+static int applyNodes(TILE_ARRAY *tiles, const TILE_ARRAY *nodes, const TILE_ARRAY *refs){
+
+  uint64_t  id, old, tile;
+  size_t    index;
+  int       shift = EXPIRE_MAX_ZOOM - expireMaxZoom;
+  int       result = ztSuccess;
+
+  for(index = 0; index + 1 < nodes->count && result == ztSuccess; index += 2){
+
+    id = nodes->keys[index] & ~NODE_DELETED;
+    old = cacheGet(&nodeCache, id);
+    tile = nodes->keys[index + 1];
+
+    if(old)
+      result = appendTile(tiles, TILE_KEY(expireMaxZoom, TILE_X(old) >> shift, TILE_Y(old) >> shift));
+
+    if(result == ztSuccess && tile && tile != old)
+      result = appendTile(tiles, TILE_KEY(expireMaxZoom, TILE_X(tile) >> shift, TILE_Y(tile) >> shift));
+
+    if(result == ztSuccess)
+      result = cacheSet(&nodeCache, id, (nodes->keys[index] & NODE_DELETED) ? 0 : tile);
+  }
+
+  for(index = 0; index < refs->count && result == ztSuccess; index++){
+
+    tile = cacheGet(&nodeCache, refs->keys[index]);
+
+    if(tile)
+      result = appendTile(tiles, TILE_KEY(expireMaxZoom, TILE_X(tile) >> shift, TILE_Y(tile) >> shift));
+  }
+
+  return result;
+
+} /* END applyNodes() **/
+
+/* appendRefs(): node ids from <nd ref=".."> in way and <member type="node"
+ * ref=".."> in relation. Way members of relation are not followed; their
+ * changes and their nodes' changes expire their tiles.
+ *
+ ***************************************************************************/
+
+static int appendRefs(TILE_ARRAY *refs, const OSC_ELEMENT *element){
+
+  const char  *ptr, *end, *value;
+  const char  *tagName;
+  size_t      length;
+  long long   id;
+  int         result = ztSuccess;
+
+  tagName = (element->type == OSC_WAY) ? "<nd " : "<member ";
+
+  ptr = element->text;
+  end = element->text + element->length;
+
+  while(result == ztSuccess && ptr < end && (ptr = strstr(ptr, tagName))){
+
+    ptr++;
+
+    if(element->type == OSC_RELATION &&
+       (oscAttribute(ptr, "type", &value, &length) != ztSuccess || length != 4 || strncmp(value, "node", 4) != 0))
+      continue;
+
+    if(oscAttribute(ptr, "ref", &value, &length) != ztSuccess)
+      continue;
+
+    id = strtoll(value, NULL, 10);
+    if(id > 0)
+      result = appendTile(refs, (uint64_t) id);
+  }
+
+  return result;
+
+} /* END appendRefs() **/
+
+static int appendTile(TILE_ARRAY *array, uint64_t key){
+
+  uint64_t  *newKeys;
+  size_t    newSize;
+
+  if(array->count == array->size){
+
+    newSize = array->size ? array->size * 2 : 1024;
+
+    newKeys = (uint64_t *) realloc(array->keys, newSize * sizeof(uint64_t));
+    if(!newKeys){
+      fprintf(stderr, "%s: Error allocating memory for tiles.\n", progName);
+      return ztMemoryAllocate;
+    }
+
+    array->keys = newKeys;
+    array->size = newSize;
+  }
+
+  array->keys[array->count++] = key;
+
+  return ztSuccess;
+
+} /* END appendTile() **/
+
+static void uniqueTiles(TILE_ARRAY *array){
+
+  size_t  index, kept;
+
+  if(array->count < 2)
+    return;
+
+  qsort(array->keys, array->count, sizeof(uint64_t), compareUint64);
+
+  for(index = 1, kept = 1; index < array->count; index++)
+    if(array->keys[index] != array->keys[kept - 1])
+      array->keys[kept++] = array->keys[index];
+
+  array->count = kept;
+
+} /* END uniqueTiles() **/
+
+/* readTilesFile(): tiles left from earlier runs; missing file is fine **/
+
+static int readTilesFile(TILE_ARRAY *array, const char *tilesFile){
+
+  FILE          *filePtr;
+  char          line[64];
+  unsigned int  zoom, x, y;
+  int           result = ztSuccess;
+
+  filePtr = fopen(tilesFile, "r");
+  if(!filePtr)
+    return ztSuccess;
+
+  while(result == ztSuccess && fgets(line, sizeof(line), filePtr)){
+
+    if(sscanf(line, "%u/%u/%u", &zoom, &x, &y) != 3 || zoom > EXPIRE_MAX_ZOOM ||
+       x >= (1U << zoom) || y >= (1U << zoom))
+      continue;
+
+    result = appendTile(array, TILE_KEY(zoom, x, y));
+  }
+
+  fclose(filePtr);
+
+  return result;
+
+} /* END readTilesFile() **/
+
+static uint64_t cacheGet(NODE_TILE_TABLE *table, uint64_t key){
+
+  size_t  slot;
+
+  if(! table->count)
+    return 0;
+
+  slot = slotOf(table, key);
+
+  return (table->keys[slot] == key) ? table->tiles[slot] : 0;
+
+} /* END cacheGet() **/
+
+/* cacheSet(): zero tile is not inserted; existing entry is set to zero.
+ * Past EXPIRE_CACHE_MAX nodes new ones are not added.
+ *
+ ***************************************************************************/
+
+static int cacheSet(NODE_TILE_TABLE *table, uint64_t key, uint64_t tile){
+
+  size_t  slot;
+  int     result;
+
+  if(! key)
+    return ztSuccess;
+
+  if(table->size){
+
+    slot = slotOf(table, key);
+
+    if(table->keys[slot] == key){
+      table->tiles[slot] = tile;
+      return ztSuccess;
+    }
+  }
+
+  if(! tile || table->count >= EXPIRE_CACHE_MAX)
+    return ztSuccess;
+
+  /* keep load under one half **/
+  if((table->count + 1) * 2 > table->size){
+
+    result = growCache(table, table->size ? table->size * 2 : CACHE_INITIAL);
+    if(result != ztSuccess)
+      return result;
+  }
+
+  slot = slotOf(table, key);
+
+  table->keys[slot] = key;
+  table->tiles[slot] = tile;
+  table->count++;
+
+  return ztSuccess;
+
+} /* END cacheSet() **/
+
+static int growCache(NODE_TILE_TABLE *table, size_t newSize){
+
+  NODE_TILE_TABLE  bigger;
+  size_t           index, slot;
+
+  bigger.keys = (uint64_t *) calloc(newSize, sizeof(uint64_t));
+  bigger.tiles = (uint64_t *) calloc(newSize, sizeof(uint64_t));
+  bigger.size = newSize;
+  bigger.count = table->count;
+
+  if(!bigger.keys || !bigger.tiles){
+    fprintf(stderr, "%s: Error allocating memory for expire node cache.\n", progName);
+    free(bigger.keys);
+    free(bigger.tiles);
+    return ztMemoryAllocate;
+  }
+
+  for(index = 0; index < table->size; index++){
+
+    if(! table->keys[index])
+      continue;
+
+    slot = slotOf(&bigger, table->keys[index]);
+
+    bigger.keys[slot] = table->keys[index];
+    bigger.tiles[slot] = table->tiles[index];
+  }
+
+  free(table->keys);
+  free(table->tiles);
+
+  *table = bigger;
+
+  return ztSuccess;
+
+} /* END growCache() **/
+
+/* slotOf(): slot with 'key' or first empty slot; linear probing **/
+
+static size_t slotOf(const NODE_TILE_TABLE *table, uint64_t key){
+
+  size_t  slot;
+
+  slot = (size_t) ((key * 0x9E3779B97F4A7C15ULL) >> 17) & (table->size - 1);
+
+  while(table->keys[slot] && table->keys[slot] != key)
+    slot = (slot + 1) & (table->size - 1);
+
+  return slot;
+
+} /* END slotOf() **/
+
+/* cache file: text header then (node id, tile key) records in host byte
+ * order; file not ours starts with empty cache.
+ ***************************************************************************/
+
+static int loadCache(void){
+
+  FILE      *fp;
+  char      line[64];
+  uint64_t  key, tile;
+  long      count = 0, index;
+  int       result = ztSuccess;
+
+  fp = fopen(cacheFile, "rb");
+  if(!fp)
+    return ztSuccess; /* first run **/
+
+  if(! fgets(line, sizeof(line), fp) || strcmp(line, CACHE_MAGIC) != 0 ||
+     ! fgets(line, sizeof(line), fp) || sscanf(line, "count=%ld", &count) != 1 || count < 0){
+
+    fclose(fp);
+    fprintf(stdout, "%s: Expire cache file is not ours; starting with empty cache.\n", progName);
+    logMessage(fLogPtr, "Expire cache file is not ours; starting with empty cache.");
+    return ztSuccess;
+  }
+
+  for(index = 0; index < count && result == ztSuccess; index++){
+
+    if(fread(&key, sizeof(key), 1, fp) != 1 || fread(&tile, sizeof(tile), 1, fp) != 1){
+      fprintf(stderr, "%s: Error expire cache file is truncated: <%s>\n", progName, cacheFile);
+      result = ztMalformedFile;
+      break;
+    }
+
+    result = cacheSet(&nodeCache, key, tile);
+  }
+
+  fclose(fp);
+
+  if(result == ztSuccess && fVerbose)
+    fprintf(stdout, "%s: Loaded <%ld> nodes into expire cache.\n", progName, count);
+
+  return result;
+
+} /* END loadCache() **/
+
+static int saveCache(void){
+
+  NODE_TILE_TABLE  *table = &nodeCache;
+  FILE             *fp;
+  char             partFile[PATH_MAX];
+  size_t           index;
+  long             count = 0;
+  int              result = ztSuccess;
+
+  if(snprintf(partFile, sizeof(partFile), "%s.part", cacheFile) >= (int) sizeof(partFile))
+    return ztFnameLong;
+
+  /* deleted nodes are dropped **/
+  for(index = 0; index < table->size; index++)
+    if(table->keys[index] && table->tiles[index])
+      count++;
+
+  errno = 0;
+  fp = fopen(partFile, "wb");
+  if(!fp){
+    fprintf(stderr, "%s: Error failed fopen() for <%s>: %s\n", progName, partFile, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  fprintf(fp, "%scount=%ld\n", CACHE_MAGIC, count);
+
+  for(index = 0; index < table->size; index++){
+
+    if(! table->keys[index] || ! table->tiles[index])
+      continue;
+
+    if(fwrite(table->keys + index, sizeof(uint64_t), 1, fp) != 1 ||
+       fwrite(table->tiles + index, sizeof(uint64_t), 1, fp) != 1){
+      result = ztWriteError;
+      break;
+    }
+  }
+
+  if(fclose(fp) != 0 && result == ztSuccess)
+    result = ztWriteError;
+
+  if(result == ztSuccess && rename(partFile, cacheFile) != 0)
+    result = ztFailedSysCall;
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed writing expire cache file: <%s>\n", progName, cacheFile);
+    unlink(partFile);
+  }
+
+  return result;
+
+} /* END saveCache() **/
+
+static void freeCache(void){
+
+  free(nodeCache.keys);
+  free(nodeCache.tiles);
+  memset(&nodeCache, 0, sizeof(NODE_TILE_TABLE));
+
+  free(cacheFile);
+  cacheFile = NULL;
+
+} /* END freeCache() **/
@@ -20,6 +20,7 @@
 #include "getdiff.h"
 
 #include "debug.h"
+#include "queue.h"
 
 /* file2StringList(): reads file into string list.
  *
@@ -433,9 +434,15 @@ int readStartID(char **idString, char *filename){
 
 } /* END readStartID() **/
 
+/* writeStartID(): file is written under temporary name then renamed; it
+ * is advanced after each pair - a crash leaves old or new number.
+ **/
+
 int writeStartID (char *idStr, char *filename){
 
   FILE   *fPtr;
+  char   tmpName[PATH_MAX] = {0};
+  int    result;
 
   ASSERTARGS (idStr && filename);
 
@@ -444,32 +451,121 @@ int writeStartID (char *idStr, char *filename){
     return ztInvalidArg;
   }
 
+  if(strlen(filename) + 5 >= PATH_MAX){
+    fprintf(stderr, "%s: Error filename is too long: <%s>\n", progName, filename);
+    return ztFnameLong;
+  }
+
+  sprintf(tmpName, "%s.tmp", filename);
+
   errno = 0;
-  fPtr = fopen(filename, "w");
+  fPtr = fopen(tmpName, "w");
   if (!fPtr){
-    fprintf (stderr, "%s: Error failed fopen() for file! <%s>\n", progName, filename);
+    fprintf (stderr, "%s: Error failed fopen() for file! <%s>\n", progName, tmpName);
     fprintf(stderr, "System error message: %s\n\n", strerror(errno));
     return ztOpenFileError;
   }
 
   fprintf(fPtr, "%s\n", idStr); /* we write linefeed **/
 
+  result = (fflush(fPtr) == 0 && fsync(fileno(fPtr)) == 0) ? ztSuccess : ztWriteError;
+
   fclose(fPtr);
 
-  return ztSuccess;
+  if(result == ztSuccess)
+    result = commitFile(tmpName, filename);
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed writing file: <%s>\n", progName, filename);
+    unlink(tmpName);
+  }
+
+  return result;
 
 } /* END writeStartID() **/
 
-/* writeNewerFile():
- *
- * initial string list
- *
- * if toFile exist (usable) -> read file into string list
+/* commitFile(): fully written 'partName' takes 'name'; data is synced before
+ * rename() and directory after it, so 'name' is whole after a crash.
  *
- * append completedList to string list
- *
- * write string list to file.
+ *************************************************************************/
+
+int commitFile(const char *partName, const char *name){
+
+  ASSERTARGS(partName && name);
+
+  char  dirName[PATH_MAX] = {0};
+  char  *slash;
+  int   fd;
+  int   result = ztSuccess;
+
+  errno = 0;
+  fd = open(partName, O_RDONLY | O_CLOEXEC);
+  if(fd < 0 || fsync(fd) != 0){
+    fprintf(stderr, "%s: Error failed fsync() for <%s>: %s\n", progName, partName, strerror(errno));
+    if(fd >= 0)
+      close(fd);
+    return ztWriteError;
+  }
+
+  close(fd);
+
+  if(rename(partName, name) != 0){
+    fprintf(stderr, "%s: Error failed rename() for <%s>: %s\n", progName, name, strerror(errno));
+    return ztFailedSysCall;
+  }
+
+  strncpy(dirName, name, sizeof(dirName) - 1);
+
+  slash = strrchr(dirName, '/');
+  if(slash == dirName)
+    slash[1] = '\0';
+  else if(slash)
+    slash[0] = '\0';
+  else
+    strcpy(dirName, ".");
+
+  fd = open(dirName, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if(fd < 0 || fsync(fd) != 0)
+    result = ztFailedSysCall;
+
+  if(fd >= 0)
+    close(fd);
+
+  return result;
+
+} /* END commitFile() **/
+
+/* writeAll(): write() loop for whole 'buffer'; retries short writes and EINTR **/
+
+int writeAll(int fd, const void *buffer, size_t size){
+
+  const char  *ptr = (const char *) buffer;
+  ssize_t     count;
+
+  while(size){
+
+    count = write(fd, ptr, size);
+    if(count < 0 && errno == EINTR)
+      continue;
+
+    if(count <= 0){
+      fprintf(stderr, "%s: Error failed write(): %s\n", progName, strerror(errno));
+      return ztWriteError;
+    }
+
+    ptr += count;
+    size -= (size_t) count;
+  }
+
+  return ztSuccess;
+
+} /* END writeAll() **/
+
+/* writeNewerFile(): appends list entries to 'toFile' queue file.
  *
+ * file is append only; no read & rewrite of the whole file. Entries are
+ * written with one write() then fsync() - see queue.c. Consumers keep
+ * their place in the cursor file and do not need to delete 'toFile'.
  *
  *************************************************************************/
 
@@ -488,44 +584,11 @@ int writeNewerFiles(char const *toFile, STRING_LIST *list){
     return ztInvalidArg;
   }
 
-  STRING_LIST   *fileList;
-  int           result;
-  ELEM          *elem;
-  char          *line;
-
-  fileList = initialStringList();
-  if(!fileList){
-    fprintf(stderr, "%s: Error failed initialStringList() function.\n", progName);
-    return ztMemoryAllocate;
-  }
-
-
-  result = isFileUsable(toFile);
-  if(result == ztSuccess){
-    result = file2StringList(fileList, toFile);
-    if(result != ztSuccess){
-      fprintf(stderr, "%s: Error failed file2StringList() function.\n", progName);
-      return result;
-    }
-  }
-
-  elem = DL_HEAD(list);
-  while(elem){
-
-    line = (char *)DL_DATA(elem);
-
-    result = insertNextDL(fileList, DL_TAIL(fileList), (void *) line);
-    if(result != ztSuccess){
-      fprintf(stderr, "%s: Error failed inesrtNextDL() function.\n", progName);
-      return result;
-    }
-
-    elem = DL_NEXT(elem);
-  }
+  int  result;
 
-  result = stringList2File(toFile, fileList);
+  result = queueAppend(toFile, list);
   if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed stringList2File() function.\n", progName);
+    fprintf(stderr, "%s: Error failed queueAppend() function.\n", progName);
     return result;
   }
 
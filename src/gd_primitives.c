@@ -18,6 +18,7 @@
 #include "fileio.h"
 #include "util.h"
 #include "debug.h"
+#include "srclock.h"
 
 int setupFilesys(SKELETON *directories, GD_FILES *files, const char *root){
 
@@ -172,22 +173,126 @@ int setFilenames(GD_FILES *gdFiles, SKELETON *dir){
     return ztMemoryAllocate;
   }
 
+  gdFiles->cursorFile = appendName2Dir(dir->workDir, NEW_DIFFERS_CURSOR);
+  if(! gdFiles->cursorFile){
+    fprintf(stderr, "%s: Error failed appendName2Dir() for cursorFile.\n", progName);
+    return ztMemoryAllocate;
+  }
+
   gdFiles->rangeFile = appendName2Dir(dir->workDir, RANGE_FILE);
   if(! gdFiles->rangeFile){
     fprintf(stderr, "%s: Error failed appendName2Dir() for rangeFile.\n", progName);
     return ztMemoryAllocate;
   }
 
+  gdFiles->expireFile = appendName2Dir(dir->workDir, EXPIRE_TILES);
+  if(! gdFiles->expireFile){
+    fprintf(stderr, "%s: Error failed appendName2Dir() for expireFile.\n", progName);
+    return ztMemoryAllocate;
+  }
+
   gdFiles->latestStateFile = appendName2Dir(dir->tmp, LATEST_STATE_FILE);
   if(! gdFiles->latestStateFile){
     fprintf(stderr, "%s: Error failed appendName2Dir() for latestStateFile.\n", progName);
     return ztMemoryAllocate;
   }
 
+  gdFiles->journalFile = appendName2Dir(dir->workDir, JOURNAL_FILE);
+  if(! gdFiles->journalFile){
+    fprintf(stderr, "%s: Error failed appendName2Dir() for journalFile.\n", progName);
+    return ztMemoryAllocate;
+  }
+
+  /* work directory source; setSourceFiles() moves these for another source **/
+  gdFiles->sourceDir = STRDUP(dir->workDir);
+  gdFiles->sourceTmp = STRDUP(dir->tmp);
+  if(! gdFiles->sourceDir || ! gdFiles->sourceTmp){
+    fprintf(stderr, "%s: Error failed STRDUP() for sourceDir.\n", progName);
+    return ztMemoryAllocate;
+  }
+
   return ztSuccess;
 
 } /* END setFilenames2() **/
 
+/* setSourceFiles(): source lock is {treeDir}/.lock.getdiff - see srclock.h.
+ * Work directory source - 'isWorkSource' - keeps its files where setFilenames()
+ * put them. Any other source has them in {treeDir}/.source/; directory and
+ * its tmp/ are made. Log file and work directory lock are not moved.
+ *
+ ******************************************************************************/
+
+int setSourceFiles(GD_FILES *gdFiles, const char *treeDir, int isWorkSource){
+
+  ASSERTARGS(gdFiles && treeDir);
+
+  char   *names[] = {PREV_SEQ_FILE, NEW_DIFFERS, NEW_DIFFERS_CURSOR, RANGE_FILE,
+                     EXPIRE_TILES, JOURNAL_FILE, LATEST_STATE_FILE};
+  char   **members[] = {&gdFiles->previousSeqFile, &gdFiles->newDiffersFile,
+                        &gdFiles->cursorFile, &gdFiles->rangeFile,
+                        &gdFiles->expireFile, &gdFiles->journalFile,
+                        &gdFiles->latestStateFile};
+  int    numNames = sizeof(names) / sizeof(char *);
+  int    index;
+  int    result;
+
+  if(gdFiles->sourceLockFile)
+    free(gdFiles->sourceLockFile);
+
+  gdFiles->sourceLockFile = appendName2Dir(treeDir, LOCK_FILE);
+  if(! gdFiles->sourceLockFile){
+    fprintf(stderr, "%s: Error failed appendName2Dir() for source lock file.\n", progName);
+    return ztMemoryAllocate;
+  }
+
+  if(isWorkSource)
+
+    return ztSuccess;
+
+  if(gdFiles->sourceDir)
+    free(gdFiles->sourceDir);
+
+  if(gdFiles->sourceTmp)
+    free(gdFiles->sourceTmp);
+
+  gdFiles->sourceDir = appendName2Dir(treeDir, SOURCE_DIR "/");
+  gdFiles->sourceTmp = gdFiles->sourceDir ? appendName2Dir(gdFiles->sourceDir, "tmp/") : NULL;
+
+  if(! gdFiles->sourceDir || ! gdFiles->sourceTmp){
+    fprintf(stderr, "%s: Error failed appendName2Dir() for source files.\n", progName);
+    return ztMemoryAllocate;
+  }
+
+  result = myMkDir(gdFiles->sourceDir);
+  if(result == ztSuccess)
+    result = myMkDir(gdFiles->sourceTmp);
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed myMkDir() for source directory: <%s>.\n", progName, gdFiles->sourceDir);
+    return result;
+  }
+
+  for(index = 0; index < numNames; index++){
+
+    if(*members[index])
+      free(*members[index]);
+
+    /* latest.state.txt is fetched to tmp/ then moved to source directory **/
+    if(index == numNames - 1)
+      *members[index] = appendName2Dir(gdFiles->sourceTmp, names[index]);
+    else
+      *members[index] = appendName2Dir(gdFiles->sourceDir, names[index]);
+
+    if(! *members[index]){
+      fprintf(stderr, "%s: Error failed appendName2Dir() for <%s>.\n", progName, names[index]);
+      return ztMemoryAllocate;
+    }
+  }
+
+  return ztSuccess;
+
+} /* END setSourceFiles() **/
+
 
 PATH_PART *initialPathPart(void){
 
@@ -496,41 +601,21 @@ int sequence2PathPart(PATH_PART *pathPart, const char *sequenceStr){
 
   memset(pathPart, 0, sizeof(PATH_PART)); /* zero-out all members **/
 
-  /* to format with leading character using printf(), variable must be integer type **/
-  int    seqNum;
-  char   *endPtr;
-
-  seqNum = (int) strtol(sequenceStr, &endPtr, 10);
-  if( *endPtr != '\0'){
-    fprintf(stderr, "%s: Error in sequence2PathPart() failed strtol() for sequenceStr.\n", progName);
+  if(string2Sequence(&pathPart->seqNum, sequenceStr) != ztSuccess){
+    fprintf(stderr, "%s: Error in sequence2PathPart() failed string2Sequence() for sequenceStr.\n", progName);
     return ztInvalidArg;
   }
 
-  /* make a string from seqNum with leading zeros **/
-  char   tmpBuf[10] = {0};
-
-  sprintf(tmpBuf, "%09d", seqNum);
-
   strcpy(pathPart->sequenceNum, sequenceStr); /* copy as received, NOT as formatted **/
 
-  /* make Entry members from formatted string **/
-
-  strncpy(pathPart->rootEntry, tmpBuf, 3);
-
-  pathPart->rootEntry[3] = '/';
-  pathPart->rootEntry[4] = '\0';
-
-  strncpy(pathPart->parentEntry, tmpBuf + 3, 3);
-
-  pathPart->parentEntry[3] = '/';
-  pathPart->parentEntry[4] = '\0';
+  /* make Entry members from table; no "%09d" formatting **/
+  sequence2Entries(pathPart->rootEntry, pathPart->parentEntry, pathPart->fileEntry, pathPart->seqNum);
 
-  strncpy(pathPart->fileEntry, tmpBuf + 6, 3);
+  /* parentPath is "/NNN/NNN/" and filePath is "/NNN/NNN/NNN" **/
+  sequence2Path(pathPart->filePath, pathPart->seqNum);
 
-  /* make members parentPath & filePath from entries above **/
-  snprintf(pathPart->parentPath, sizeof(pathPart->parentPath), "/%s%s", pathPart->rootEntry, pathPart->parentEntry);
-
-  snprintf(pathPart->filePath, sizeof(pathPart->filePath), "%s%s", pathPart->parentPath, pathPart->fileEntry);
+  memcpy(pathPart->parentPath, pathPart->filePath, 9);
+  pathPart->parentPath[9] = '\0';
 
   return ztSuccess;
 
@@ -622,6 +707,42 @@ void zapSetting(MY_SETTING *settings){
   if(settings->endNumber)
 	free(settings->endNumber);
 
+  if(settings->eventsPath)
+	free(settings->eventsPath);
+
+  if(settings->streamTarget)
+	free(settings->streamTarget);
+
+  for(int index = 0; index < settings->numRegions; index++)
+	free(settings->regionArgs[index]);
+
+  if(settings->lookupObject)
+	free(settings->lookupObject);
+
+  if(settings->extractArg)
+	free(settings->extractArg);
+
+  if(settings->serveArg)
+	free(settings->serveArg);
+
+  if(settings->storeDir)
+	free(settings->storeDir);
+
+  if(settings->cookieCache)
+	free(settings->cookieCache);
+
+  if(settings->loginHost)
+	free(settings->loginHost);
+
+  if(settings->consumerURL)
+	free(settings->consumerURL);
+
+  if(settings->logLevel)
+	free(settings->logLevel);
+
+  if(settings->metricsDir)
+	free(settings->metricsDir);
+
   memset(settings, 0, sizeof(MY_SETTING));
 
   return;
@@ -659,6 +780,18 @@ void zapSkeleton(SKELETON *skel){
 
 void zapGd_files(GD_FILES *gf){
 
+  if(gf->sourceDir)
+	free(gf->sourceDir);
+
+  if(gf->sourceLockFile)
+	free(gf->sourceLockFile);
+
+  if(gf->sourceTmp)
+	free(gf->sourceTmp);
+
+  if(gf->journalFile)
+	free(gf->journalFile);
+
   if(gf->lockFile)
 	free(gf->lockFile);
 
@@ -674,9 +807,15 @@ void zapGd_files(GD_FILES *gf){
   if(gf->newDiffersFile)
 	free(gf->newDiffersFile);
 
+  if(gf->cursorFile)
+	free(gf->cursorFile);
+
   if(gf->rangeFile)
 	free(gf->rangeFile);
 
+  if(gf->expireFile)
+	free(gf->expireFile);
+
   if(gf->latestStateFile)
 	free(gf->latestStateFile);
 
@@ -685,4 +824,63 @@ void zapGd_files(GD_FILES *gf){
   return;
 }
 
+/* isStateFileList():
+ *  - must be a STRING_LT
+ *  - must have exactly THREE lines
+ *  - one line must start with "timestamp=" substring
+ *  - one line must start with "sequenceNumber=" substring
+ *
+ * **************************************************/
+int isStateFileList(STRING_LIST *list){
+
+  ASSERTARGS(list);
+
+  if( ! TYPE_STRING_LIST(list) )
+
+    return FALSE;
+
+//  if(DL_SIZE(list) != 3)
+  if(DL_SIZE(list) < 3)
+
+    return FALSE;
+
+  ELEM   *elem;
+  char   *timeLine = NULL;
+  char   *sequenceLine = NULL;
+
+  elem = findElemSubString(list, "timestamp=");
+  if(elem)
+    timeLine = (char*) DL_DATA(elem);
+
+  elem = findElemSubString(list, "sequenceNumber=");
+  if(elem)
+    sequenceLine = (char*) DL_DATA(elem);
+
+  if(! timeLine)
+    fprintf(stderr, "isStateFileList(): Error could not find timeLine.\n");
+
+  if(! sequenceLine)
+    fprintf(stderr, "isStateFileList(): Error could not find sequenceLine.\n");
+
+  if(timeLine && sequenceLine)
+
+    return TRUE;
+
+  return FALSE;
+
+} /* END isStateFileList() **/
+
+int isGoodSequenceString(const char *string){
+
+  SEQ_NUM  seq;
+
+  ASSERTARGS(string);
+
+  /* 3 to 9 digits, no leading zero; had to go back to day/2014 **/
+  if(string2Sequence(&seq, string) != ztSuccess)
+
+    return FALSE;
+
+  return TRUE;
 
+} /* END isGoodSequenceString() **/
@@ -17,6 +17,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 #include "usage.h"
 #include "ztError.h"
@@ -27,10 +33,31 @@
 #include "curlfn.h"
 #include "cookie.h"
 #include "fileio.h"
-#include "tmpFiles.h"
 #include "parseAnchor.h"
 
 #include "debug.h"
+#include "queue.h"
+#include "events.h"
+#include "stream.h"
+#include "sequence.h"
+#include "merge.h"
+#include "transcode.h"
+#include "verify.h"
+#include "crc32.h"
+#include "summary.h"
+#include "region.h"
+#include "expire.h"
+#include "idindex.h"
+#include "retain.h"
+#include "pack.h"
+#include "store.h"
+#include "serve.h"
+#include "workers.h"
+#include "localsrc.h"
+#include "srclock.h"
+#include "journal.h"
+#include "logger.h"
+#include "metrics.h"
 
 /*global variables **/
 char   *progName = NULL;
@@ -41,9 +68,61 @@ int    fUsingPreviousID = 0;
 /* curl easy handle and curl parse handle **/
 static CURL   *downloadHandle = NULL;
 static CURLU  *curlParseHandle = NULL;
+static int    localSource = 0;
 static char   *sourceURL = NULL;
+
+/* --public-meta: state.txt, listings and headers from public server,
+ * only change files from internal server; login on first change file **/
+static CURL   *metaHandle = NULL;
+static CURLU  *metaParseHandle = NULL;
+static char   *metaSourceURL = NULL;
+static MY_SETTING *loginSetting = NULL; /* set while login is pending **/
+static SKELETON   *loginDir = NULL;
+
+static int    extractFD = -1;   /* standard output for --extract **/
 static char   *tmpDir = NULL;
 
+/* stream mode: 'previous.seq' is updated after each emitted change file;
+ * NULL for range download **/
+static char   *streamSeqFile = NULL;
+
+static REGION_SET  *regionSet = NULL; /* with region option **/
+static int         regionsFD = -1;     /* REGIONS_LOCK in work directory **/
+
+/* pair publish: each committed pair goes to list file - and 'previous.seq'
+ * for update run - right away; set when no end of run step rewrites list.
+ * Journal entries are in journal.h **/
+static int    pairPublish = 0;
+static char   *pairListFile = NULL;    /* NULL with newDifferOff **/
+static char   *pairSeqFile = NULL;     /* NULL for range download **/
+static char   *pairGranularity = NULL; /* range from planet source **/
+
+/* SIGTERM & SIGINT: download stops at next pair **/
+static volatile sig_atomic_t  stopRequest = 0;
+
+static int fetchRemote(char *remotePathSuffix, char *localFile, MEMORY_STRUCT *dst, int isMeta);
+static int initialMetaHandles(char *path);
+static int pendingLogin(void);
+static int myDownload2Memory(char *remotePathSuffix, MEMORY_STRUCT *dst);
+static int streamPair(MEMORY_STRUCT *oscMemory, char *oscFile, char *stateFile);
+static int mergeCompleted(STRING_LIST **mergedList, STRING_LIST *completed, const char *begin, const char *end, char *localDestPrefix);
+static int filterCompleted(STRING_LIST *completed, char *localDestPrefix);
+static char *workSourceTree(SKELETON *dirs, char *treeDir, int claim);
+static int commitPair(const char *stateFile);
+static int dropPublished(STRING_LIST *list);
+static void onStopSignal(int signum);
+static int startFeatures(MY_SETTING *setting, SKELETON *dirs, GD_FILES *files, char *treeDir);
+static int startTreeFeatures(MY_SETTING *setting, char *treeDir);
+static int startRetentionRun(MY_SETTING *setting, GD_FILES *files, char *treeDir, const char *startSeq);
+static int startPairCommit(MY_SETTING *setting, SKELETON *dirs, GD_FILES *files, char *treeDir,
+                           STRING_LIST *newDiffersList, const char *startSeq, const char *endSeq);
+static int finishFeatures(MY_SETTING *setting, GD_FILES *files, char *treeDir, STRING_LIST *completedList, STRING_LIST **mergedList);
+static int packSourceTree(MY_SETTING *setting, GD_FILES *files, char *treeDir, const char *endSeq);
+static void closeFeatures(int status);
+static int startSession(MY_SETTING *setting);
+static int startDownloadHandle(MY_SETTING *setting, SKELETON *dirs);
+static void closeSession(void);
+
 int main(int argc, char *argv[]){
 
   /* progName is used in output / log messages. **/
@@ -66,6 +145,29 @@ int main(int argc, char *argv[]){
     return result;
   }
 
+  /* queue commands only need work directory; no lock, log or network.
+   * consumer runs them while getdiff may be appending to queue file.
+   * verify only reads local tree; also runs next to getdiff. **/
+  if(mySetting.command == CMD_VERIFY)
+
+    return runVerifyCommand(&mySetting);
+
+  if(mySetting.command == CMD_LOOKUP)
+
+    return runLookupCommand(&mySetting);
+
+  if(mySetting.command == CMD_EXTRACT)
+
+    return runExtractCommand(&mySetting);
+
+  if(mySetting.command == CMD_SERVE)
+
+    return runServeCommand(&mySetting);
+
+  if(mySetting.command != CMD_DOWNLOAD)
+
+    return runQueueCommand(&mySetting);
+
   /* source argument is required **/
   if(! mySetting.source){
     fprintf (stderr, "%s: Error missing required  remote 'source url' argument.\n",
@@ -87,19 +189,59 @@ int main(int argc, char *argv[]){
     return result;
   }
 
-  int lockFD;
+  /* from here on failures go to EXIT_CLEAN; locks, run metrics, workers,
+   * regions lock and log are closed there **/
+  int         value2Return = ztSuccess; /* value to return at EXIT_CLEAN **/
+
+  /* checked in EXIT_CLEAN **/
+  STRING_LIST *newDiffersList = NULL;
+  STRING_LIST *completedList = NULL;
+  STRING_LIST *mergedList = NULL; /* merged pair with merge option **/
+
+  /* source tree first; lock is for that tree so other sources run next
+   * to us - see srclock.h **/
+  char  *diffDestPrefix; /* new differs destination on local machine;
+                            Prefix: first (start part of the path)
+                            Suffix: second (end part of the path) **/
+  char  *lowerSource = NULL;
+  int   isWorkSource;
+
+  string2Lower(&lowerSource, mySetting.source);
+  diffDestPrefix = lowerSource ? setDiffersDirPrefix(&myDir, lowerSource) : NULL;
+  if(lowerSource)
+    free(lowerSource);
+
+  if(!diffDestPrefix){
+    fprintf(stderr, "%s: Error failed setDiffersDirPrefix() function.\n", progName);
+    value2Return = ztInvalidArg;
+    goto EXIT_CLEAN;
+  }
 
-  result = getLock(&lockFD, myFiles.lockFile);
+  result = lockWorkDir(myFiles.lockFile);
   if(result != ztSuccess){
     fprintf(stderr, "%s: Error failed to obtain lock file. Another instance is using work directory!\n", progName);
-    return ztInvalidUsage;
+    value2Return = ztInvalidUsage;
+    goto EXIT_CLEAN;
   }
 
-  /* Note that we pass 'lockFD' to cookie.c functions if we have to use'em below with:
-   *
-   *   fd2CloseFD = lockFD; // let fork()ed child release it -- cookie.c
-   *
-   **********************************************************************************/
+  /* work directory source is named while we are alone **/
+  isWorkSource = (workSourceTree(&myDir, diffDestPrefix, isWorkDirExclusive()) == diffDestPrefix);
+
+  shareWorkDir();
+
+  result = setSourceFiles(&myFiles, diffDestPrefix, isWorkSource);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed setSourceFiles() function.\n", progName);
+    value2Return = result;
+    goto EXIT_CLEAN;
+  }
+
+  result = lockSource(myFiles.sourceLockFile);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed to obtain source lock file. Another instance is downloading this source!\n", progName);
+    value2Return = ztInvalidUsage;
+    goto EXIT_CLEAN;
+  }
 
   /* handle user changing log file - this was an after thought
    * if set by user, change default already set in myFile.logFile **/
@@ -116,14 +258,15 @@ int main(int argc, char *argv[]){
   fLogPtr = initialLog(myFiles.logFile);
   if(! fLogPtr){
     fprintf(stderr, "%s: Error failed initialLog().\n", progName);
-    return ztOpenFileError;
+    value2Return = ztOpenFileError;
+    goto EXIT_CLEAN;
   }
 
   if (mySetting.verbose == 1){ /* set global 'fVerbose' & make some noise! **/
     fVerbose = 1;
 
     fprintf(stdout, "%s: Starting...\n", progName);
-    fprintf(stdout, "%s: Got lock Okay, lockFD is: %d\n", progName, lockFD);
+    fprintf(stdout, "%s: Got source lock Okay: %s\n", progName, myFiles.sourceLockFile);
     fprintSetting(stdout, &mySetting);
     fprintSkeleton(stdout, &myDir);
     fprintGdFiles(stdout, &myFiles);
@@ -133,55 +276,35 @@ int main(int argc, char *argv[]){
     fprintGdFiles(fLogPtr, &myFiles);
   }
 
-  /* let our curl and cookie functions use our log file **/
-  curlLogtoFP = fLogPtr;
-  cookieLogFP = fLogPtr;
-
-  /* set global "sourceURL" variable:
-   * convert source string to lower case - in 'sourceURL'.
-   * curl URL parser is used to verify source URL.
-   ******************************************************/
-  result = string2Lower((char **) &sourceURL, mySetting.source);
-  if(!sourceURL){
-    fprintf(stderr, "%s: Error failed string2Lower() function.\n", progName);
-    return result;
-  }
-
-  CURLUcode   curluResult; /* parser returned type from curl_url_get() & curl_url_set() **/
-  int   useInternal;
-  char  *secToken = NULL; /* needed for geofabrik internal server **/
-  char  *host = NULL;
-  char  *path = NULL;
-
-  int         value2Return = ztSuccess; /* value to return at EXIT_CLEAN **/
+  /* log lines go to writer thread from here on; verbose sets debug level **/
+  LOG_LEVEL  logLevel = fVerbose ? LOG_DEBUG : LOG_DEFAULT_LEVEL;
 
-  /* checked in EXIT_CLEAN **/
-  STRING_LIST *newDiffersList = NULL;
-  STRING_LIST *completedList = NULL;
+  if(mySetting.logLevel)
+    string2LogLevel(&logLevel, mySetting.logLevel);
 
-  result = initialCurlSession();
-  if (result != ztSuccess){
-    fprintf(stderr, "%s: Error failed initialCurlSession() function.\n", progName);
-    logMessage(fLogPtr, "Error failed initialCurlSession() function.");
+  result = startLogger(fLogPtr, logLevel);
+  if(result != ztSuccess)
+    fprintf(stderr, "%s: Warning failed startLogger(); log lines are written in place.\n", progName);
 
-    return result;
+  if(! isWorkSource){
+    logMessage(fLogPtr, "Work directory files are for another source; files for this one are in directory below:");
+    logMessage(fLogPtr, myFiles.sourceDir);
   }
-  else
-    logMessage(fLogPtr, "Initialed curl session okay.");
-
-  /* get curl parse handle using sourceURL - in LOWER case **/
-  curlParseHandle = initialURL(sourceURL);
-  if (! curlParseHandle ){
-    fprintf(stderr, "%s: Error failed initialURL() function.\n", progName);
-    logMessage(fLogPtr,"Error failed initialURL() function.");
 
-    value2Return = ztFailedLibCall;
+  result = startFeatures(&mySetting, &myDir, &myFiles, diffDestPrefix);
+  if(result != ztSuccess){
+    value2Return = result;
     goto EXIT_CLEAN;
   }
 
-  if(fVerbose){
-    fprintf(stdout, "%s: Acquired curl parse handle with initialURL() function okay.\n", progName);
-    logMessage(fLogPtr, "Acquired curl parse handle with initialURL() function okay.");
+  /* let our curl and cookie functions use our log file **/
+  curlLogtoFP = fLogPtr;
+  cookieLogFP = fLogPtr;
+
+  result = startSession(&mySetting);
+  if(result != ztSuccess){
+    value2Return = result;
+    goto EXIT_CLEAN;
   }
 
   result = chkRequired(&mySetting, myFiles.previousSeqFile);
@@ -217,7 +340,8 @@ int main(int argc, char *argv[]){
         fprintf(stderr, "%s: Error failed renameFile() for <%s>.\n", progName, myFiles.newDiffersFile);
         logMessage(fLogPtr, "Error failed renameFile() for 'newerFiles.txt'.");
 
-        return result;
+        value2Return = result;
+        goto EXIT_CLEAN;
       }
       else{
         fprintf(stdout, "%s: Renamed 'newerFiles.txt' to 'newerFiles.txt.old~'.\n", progName);
@@ -234,91 +358,30 @@ int main(int argc, char *argv[]){
 	logMessage(fLogPtr, "Removed <previous.state.txt> file from work directory; using 'previous.seq' now.");
   }
 
-  /* set tmpDir; some functions write their own temporary files **/
-  tmpDir = STRDUP(myDir.tmp);
-
-  char *diffDestPrefix; /* new differs destination on local machine;
-                           Prefix: first (start part of the path)
-                           Suffix: second (end part of the path) **/
+  /* set tmpDir; some functions write their own temporary files.
+   * each source has its own; names there are not unique across sources **/
+  tmpDir = STRDUP(myFiles.sourceTmp);
 
-  diffDestPrefix = setDiffersDirPrefix(&myDir, sourceURL);
-  if(!diffDestPrefix){
-    fprintf(stderr, "%s: Error failed setDiffersDirPrefix() function.\n", progName);
-    logMessage(fLogPtr, "Error failed setDiffersDirPrefix() function.");
-    return ztFatalError;
-  }
   if(fVerbose){
     fprintf(stdout, "%s: Download destination for new differs: %s\n", progName, diffDestPrefix);
-    logMessage(fLogPtr, "Download destination for new differs is below:-");
-    logMessage(fLogPtr, diffDestPrefix);
-  }
-
-  /* use curl parse handle to retrieve 'host' to set useInternal flag,
-   * get 'path' also, used down below in the code.
-   *******************************************************************/
-  curluResult = curl_url_get(curlParseHandle, CURLUPART_HOST, &host, 0);
-  if (curluResult != CURLUE_OK ) {
-    fprintf(stderr, "%s: Error failed curl_url_get() for 'host' part.\n", progName);
-    logMessage(fLogPtr, "Error failed curl_url_get() for 'host' part.");
-
-    value2Return = ztFailedLibCall;
-    goto EXIT_CLEAN;
+    logMessageLevel(fLogPtr, LOG_DEBUG, "Download destination for new differs is below:-");
+    logMessageLevel(fLogPtr, LOG_DEBUG, diffDestPrefix);
   }
 
-  curluResult = curl_url_get(curlParseHandle, CURLUPART_PATH, &path, 0);
-  if (curluResult != CURLUE_OK ) {
-    fprintf(stderr, "%s: Error failed curl_url_get() for path part.\n", progName);
-    logMessage(fLogPtr, "Error failed curl_url_get() for path part.");
-
-    value2Return = ztFailedLibCall;
+  result = startTreeFeatures(&mySetting, diffDestPrefix);
+  if(result != ztSuccess){
+    value2Return = result;
     goto EXIT_CLEAN;
   }
 
-  if(fVerbose){
-    fprintf(stdout, "%s: Retrieved 'host' and 'path' from curl parse handle okay.\n", progName);
-    logMessage(fLogPtr, "Retrieved 'host' and 'path' from curl parse handle okay.");
-  }
-
-  useInternal = (strcmp(host, INTERNAL_SERVER) == 0);
-
-  if(useInternal){ /* set cookie; login token from cookie file. see 'cookie.c' file **/
-
-    fd2Close = lockFD; // let fork()ed child release it; child inherits fd -- cookie.c
-
-    if(fVerbose)
-      fprintf(stdout, "%s: Geofabrik Internal Server is in use, calling getLoginToken() function...\n", progName);
-    logMessage(fLogPtr, "Geofabrik Internal Server is in use, Calling getLoginToken() function...");
-
-    secToken = getLoginToken(&mySetting, &myDir);
-    if(!secToken){
-      fprintf(stderr, "%s: Error failed getLoginToken() function.\n", progName);
-      logMessage(fLogPtr, "Error failed getLoginToken() function.");
+  /* nothing for local source; localFetch() does the "downloads" **/
+  if(! localSource){
 
-      value2Return = ztNoCookieToken;
+    result = startDownloadHandle(&mySetting, &myDir);
+    if(result != ztSuccess){
+      value2Return = result;
       goto EXIT_CLEAN;
     }
-
-    if(fVerbose){
-      fprintf(stdout, "%s: Retrieved 'login token' from cookie file okay.\n", progName);
-      logMessage(fLogPtr, "Retrieved 'login token' from cookie file okay.");
-    }
-
-  } /* end if(useInternal) **/
-
-  /* to communicate with remote server; get downloadHandle **/
-  downloadHandle = initialOperation(curlParseHandle, secToken);
-  if( !downloadHandle ){
-    fprintf(stderr, "%s: Error failed initialOperation() function.\n", progName);
-    logMessage(fLogPtr, "Error failed initialOperation() function.");
-
-    value2Return = ztFailedLibCall;
-    goto EXIT_CLEAN;
-  }
-  else{
-    if(fVerbose){
-      fprintf(stdout, "%s: Obtained curl download handle okay.\n", progName);
-      logMessage(fLogPtr, "Obtained curl download handle okay.");
-    }
   }
 
   int   firstUse;
@@ -389,6 +452,8 @@ int main(int argc, char *argv[]){
     fprintf(stdout, "%s: Getting latest 'state.txt' file from remote ...\n", progName);
     logMessage(fLogPtr, "Getting latest 'state.txt' file from remote ...");
 
+    metricsPhase(METRICS_LATEST);
+
     endSequenceNum = fetchLatestSequence(STATE_FILE, myFiles.latestStateFile);
     /* fetch latest sequence number from remote server; it is in 'state.txt'
      * file found at program required 'source' argument with name 'state.txt'.
@@ -439,11 +504,18 @@ int main(int argc, char *argv[]){
       logMessage(fLogPtr, startSequenceNum);
 
       fUsingPreviousID = 1;
+
+      /* retention runs next to downloads; range runs do not use it **/
+      result = startRetentionRun(&mySetting, &myFiles, diffDestPrefix, startSequenceNum);
+      if(result != ztSuccess){
+        value2Return = result;
+        goto EXIT_CLEAN;
+      }
     }
 
     /* handle case we do nothing;
      * test is NOT done when firstUse == TRUE. **/
-    if(!firstUse && strcmp(startSequenceNum, endSequenceNum) == 0){
+    if(!firstUse && isSameSequenceString(startSequenceNum, endSequenceNum)){
       fprintf(stdout, "%s: No new differs from server; latest sequence number equals previous sequence number; exiting.\n", progName);
       logMessage(fLogPtr, "No new differs from server; latest sequence number equals previous sequence number; exiting.");
 
@@ -486,7 +558,8 @@ int main(int argc, char *argv[]){
     fprintf(stderr, "%s: Error failed sequence2PathPart() for startSequenceNum.\n", progName);
     logMessage(fLogPtr, "Error failed sequence2PathPart() for startSequenceNum.");
 
-    return result;
+    value2Return = result;
+    goto EXIT_CLEAN;
   }
 
   result = sequence2PathPart(&endSeqPP, endSequenceNum);
@@ -494,7 +567,8 @@ int main(int argc, char *argv[]){
     fprintf(stderr, "%s: Error failed sequence2PathPart() for endSequenceNum.\n", progName);
     logMessage(fLogPtr, "Error failed sequence2PathPart() for endSequenceNum.");
 
-    return result;
+    value2Return = result;
+    goto EXIT_CLEAN;
   }
 
   newDiffersList = initialStringList();
@@ -506,6 +580,8 @@ int main(int argc, char *argv[]){
     goto EXIT_CLEAN;
   }
 
+  metricsPhase(METRICS_LIST);
+
   result = getDiffersList(newDiffersList, &startSeqPP, &endSeqPP);
   if(result != ztSuccess){
     fprintf(stderr, "%s: Error failed getDiffersList().\n", progName);
@@ -524,6 +600,7 @@ int main(int argc, char *argv[]){
   }
 
   fprintStringList(NULL, newDiffersList);
+  syncLogger();
   fprintStringList(fLogPtr, newDiffersList);
 
   /** newDiffersList: each line is in an element
@@ -537,8 +614,9 @@ int main(int argc, char *argv[]){
 
   **/
 
-  /* do not download more than MAX_OSC_DOWNLOAD in one session ... trim list **/
-  if(DL_SIZE(newDiffersList) > (MAX_OSC_DOWNLOAD * 2)){
+  /* do not download more than MAX_OSC_DOWNLOAD in one session ... trim list;
+   * no server to spare with local source. **/
+  if(! localSource && DL_SIZE(newDiffersList) > (MAX_OSC_DOWNLOAD * 2)){
 
     fprintf(stdout, STYLE_BOLD
             "Updating data older than 2 months is not advisable.\n"
@@ -564,6 +642,7 @@ int main(int argc, char *argv[]){
     logMessage(fLogPtr, "Printing TRIMMED differs list below:");
 
     fprintStringList(NULL, newDiffersList);
+    syncLogger();
     fprintStringList(fLogPtr, newDiffersList);
 
     // replace latestStateFile with that in trimmed list
@@ -599,7 +678,8 @@ int main(int argc, char *argv[]){
       fprintf(stderr, "%s: Error failed sequence2PathPart() for endSequenceNum.\n", progName);
       logMessage(fLogPtr, "Error failed sequence2PathPart() for endSequenceNum.");
 
-      return result;
+      value2Return = result;
+      goto EXIT_CLEAN;
     }
   } //end if(size big)
 
@@ -624,10 +704,36 @@ int main(int argc, char *argv[]){
     goto EXIT_CLEAN;
   }
 
+  if(isStreaming()){
+
+    /* range download does not move 'previous.seq' **/
+    if(!mySetting.endNumber)
+      streamSeqFile = myFiles.previousSeqFile;
+
+    logMessage(fLogPtr, isStreamTee() ? "Streaming change files with tee to disk." :
+                                        "Streaming change files; not kept on disk.");
+  }
+
+  /* journal and pair publish; stream and text only runs keep their own
+   * bookkeeping **/
+  if(! isStreaming() && ! mySetting.textOnly){
+
+    result = startPairCommit(&mySetting, &myDir, &myFiles, diffDestPrefix,
+                             newDiffersList, startSequenceNum, endSequenceNum);
+    if(result != ztSuccess){
+      value2Return = result;
+      goto EXIT_CLEAN;
+    }
+  }
+
   fprintf(stdout, "%s: Downloading <%d> files...\n\n", progName, DL_SIZE(newDiffersList));
   logMessage(fLogPtr, "Downloading files...");
 
+  metricsPhase(METRICS_DOWNLOAD);
+
   result = downloadFilesList(completedList, newDiffersList, diffDestPrefix, mySetting.textOnly);
+
+  metricsPhase(METRICS_FINISH);
   if(result != ztSuccess){
     fprintf(stderr, "%s: Error failed downloadFilesList().\n"
     		"See completed list in log file.", progName);
@@ -637,6 +743,7 @@ int main(int argc, char *argv[]){
     if((DL_SIZE(newDiffersList) != DL_SIZE(completedList)))
     	logMessage(fLogPtr, "Incomplete download ...");
     logMessage(fLogPtr, "Completed list is below:");
+    syncLogger();
     fprintStringList(fLogPtr, completedList);
 
     value2Return = result;
@@ -646,21 +753,37 @@ int main(int argc, char *argv[]){
   fprintf(stdout, "%s: Download complete.\n\n", progName);
   logMessage(fLogPtr, "Download complete.");
 
+  /* readers wait while tree, lists and 'previous.seq' are brought up to date **/
+  result = sourceWriteBegin();
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed sourceWriteBegin() function.\n", progName);
+    logMessage(fLogPtr, "Error failed sourceWriteBegin() function.");
+
+    value2Return = result;
+    goto EXIT_CLEAN;
+  }
+
+  result = finishFeatures(&mySetting, &myFiles, diffDestPrefix, completedList, &mergedList);
+  if(result != ztSuccess){
+    value2Return = result;
+    goto EXIT_CLEAN;
+  }
+
   char *toFile;
 
   if(mySetting.endNumber){
     toFile = myFiles.rangeFile;
 
-    if(strstr(sourceURL, "planet")){
+    if(diffDestPrefix != myDir.geofabrik){
 
       /* prepend [minute | hour | day] to path from PLANET source
        * this is done when using RANGE function and for server
-       * is planet server
+       * is planet server; local source path may not say "planet"
        * granularity
        *****************************************************/
       char *granularity = lastOfPath(sourceURL);
 
-      result = prependGranularity(&completedList, granularity);
+      result = prependGranularity(mergedList ? &mergedList : &completedList, granularity);
       if(result != ztSuccess){
         fprintf(stderr, "%s: Error failed prependGranularity() function.\n", progName);
         logMessage(fLogPtr, "Error failed prependGranularity() function.");
@@ -680,8 +803,16 @@ int main(int argc, char *argv[]){
   else
     toFile = NULL;
 
-  if(!mySetting.textOnly && toFile){ //no list file is written with TEXT_ONLY option!
-    result = writeNewerFiles(toFile, completedList);
+  /* streamed change files are not on disk; nothing for list consumers **/
+  if(isStreaming() && ! isStreamTee())
+    toFile = NULL;
+
+  /* each pair was appended as it was committed **/
+  if(pairPublish)
+    toFile = NULL;
+
+  if(!mySetting.textOnly && toFile && DL_SIZE(completedList)){ //no list file is written with TEXT_ONLY option!
+    result = writeNewerFiles(toFile, mergedList ? mergedList : completedList);
     if(result != ztSuccess){
       fprintf(stderr, "%s: Error failed writeNewerFiles().\n", progName);
       logMessage(fLogPtr, "Error failed writeNewerFiles().");
@@ -694,6 +825,29 @@ int main(int argc, char *argv[]){
     logMessage(fLogPtr, "Wrote (appended) completed list to file below:");
     logMessage(fLogPtr, toFile);
 
+    SEQ_NUM  lastSeq;
+
+    /* range rerun after a crash from here does not list it again **/
+    if(path2Sequence(&lastSeq, (char *) DL_DATA(DL_TAIL(completedList))) == ztSuccess)
+      result = journalPublished(lastSeq);
+
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed journalPublished().\n", progName);
+      logMessage(fLogPtr, "Error failed journalPublished().");
+
+      value2Return = result;
+      goto EXIT_CLEAN;
+    }
+  }
+
+  /* consumed entries are dropped while readers wait **/
+  if(!mySetting.endNumber && !mySetting.newDifferOff && !mySetting.textOnly){
+
+    result = queueCompact(myFiles.newDiffersFile, myFiles.cursorFile);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Warning failed queueCompact(); queue file is kept as is.\n", progName);
+      logMessage(fLogPtr, "Warning failed queueCompact(); queue file is kept as is.");
+    }
   }
 
   if(!mySetting.textOnly && DL_SIZE(newDiffersList) != DL_SIZE(completedList)){
@@ -713,9 +867,11 @@ int main(int argc, char *argv[]){
     fprintStringList(stderr, newDiffersList);
 
     logMessage(fLogPtr, "Completed list is below:");
+    syncLogger();
     fprintStringList(fLogPtr, completedList);
 
     logMessage(fLogPtr, "New Differs list is below:");
+    syncLogger();
     fprintStringList(fLogPtr, newDiffersList);
 
     value2Return = ztUnknownError;
@@ -737,10 +893,10 @@ int main(int argc, char *argv[]){
      * rename() function is used to move the file. **/
 
     char permLocation[1024] = {0};
-    if(SLASH_ENDING(myDir.workDir))
-      sprintf(permLocation, "%s%s", myDir.workDir, LATEST_STATE_FILE);
+    if(SLASH_ENDING(myFiles.sourceDir))
+      sprintf(permLocation, "%s%s", myFiles.sourceDir, LATEST_STATE_FILE);
     else
-      sprintf(permLocation, "%s/%s", myDir.workDir, LATEST_STATE_FILE);
+      sprintf(permLocation, "%s/%s", myFiles.sourceDir, LATEST_STATE_FILE);
 
     result = renameFile(myFiles.latestStateFile, permLocation);
     if(result != ztSuccess){
@@ -752,6 +908,27 @@ int main(int argc, char *argv[]){
     }
   }
 
+  result = endJournal();
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed endJournal().\n", progName);
+    logMessage(fLogPtr, "Error failed endJournal().");
+
+    value2Return = result;
+    goto EXIT_CLEAN;
+  }
+
+  /* retention removes from same tree; it finishes first **/
+  if(mySetting.pack && !mySetting.endNumber){
+
+    result = packSourceTree(&mySetting, &myFiles, diffDestPrefix, endSequenceNum);
+    if(result != ztSuccess){
+      value2Return = result;
+      goto EXIT_CLEAN;
+    }
+  }
+
+  sourceWriteEnd();
+
   fprintf(stdout, "%s: Successfully downloaded <%d> files to: %s\n Exiting normally.\n",
           progName, DL_SIZE(completedList), diffDestPrefix);
   char logBuff[1024] = {0};
@@ -761,37 +938,10 @@ int main(int argc, char *argv[]){
 
 EXIT_CLEAN:
 
-  if(sourceURL){
-	free(sourceURL);
-	sourceURL = NULL;
-  }
-
-  if(tmpDir){
-	free(tmpDir);
-	tmpDir = NULL;
-  }
-
-  if(host){
-    curl_free(host);
-    host = NULL;
-  }
-
-  if(path){
-    curl_free(path);
-    path = NULL;
-  }
-
-  if(downloadHandle){
-    easyCleanup(downloadHandle);
-    downloadHandle = NULL;
-  }
-
-  if(curlParseHandle){
-    urlCleanup(curlParseHandle);
-    curlParseHandle = NULL;
-  }
+  /* workers and files of each feature; no end of run files **/
+  closeFeatures(value2Return);
 
-  closeCurlSession();
+  closeSession();
 
   if(newDiffersList)
     zapStringList((void **) &newDiffersList);
@@ -799,10 +949,15 @@ EXIT_CLEAN:
   if(completedList)
     zapStringList((void **) &completedList);
 
+  if(mergedList)
+    zapStringList((void **) &mergedList);
+
   if(fLogPtr){
     /* write "DONE" footer to log file **/
     logMessage(fLogPtr, "DONE");
 
+    stopLogger();
+
     fclose(fLogPtr);
 
     fLogPtr = NULL;
@@ -810,9 +965,10 @@ EXIT_CLEAN:
     cookieLogFP = NULL;
   }
 
-  releaseLock(lockFD);
+  /* lock files are kept; other instances may hold them **/
+  unlockSource();
 
-  removeFile(myFiles.lockFile);
+  unlockWorkDir();
 
   zapSetting(&mySetting);
 
@@ -824,1379 +980,3435 @@ EXIT_CLEAN:
 
 } /* END main() **/
 
-/* getSettings(): Gets program settings; from the command line and configuration
- * file; we do not look at configuration file when ALL settings are provided on
- * the command line.
- *
- * Parameters:
- *   settings: pointer to MY_SETTING structure, caller allocates memory.
- *   argc: main() command line argument count.
- *   argv: main() character pointer to command line arguments.
- *
- *   Function uses several globally defined macros; mostly for names.
+/* startFeatures(): starts features that run next to downloads - metrics,
+ * events, zstd, summary, expire and regions - in that order. Each one is
+ * stopped by closeFeatures(), also when a later one fails to start.
  *
- * Return: ztSuccess on success, several error codes maybe returned.
- *
- * Known bug: wrong value in configuration file causes this function to fail;
- * even when corresponding command line is used to set that particular option.
- * Maybe add IGNORE flag to CONF_ENTRY? Then set flags after parseCmdLine()?
- *
- ******************************************************************************/
+ ***************************************************************************/
 
-int getSettings(MY_SETTING *settings, int argc, char* const argv[]){
+static int startFeatures(MY_SETTING *setting, SKELETON *dirs, GD_FILES *files, char *treeDir){
 
-  ASSERTARGS(settings && argv);
-
-  if(argc == 1){ /* no argument --> show short help is done in main() **/
-    fprintf(stderr, "%s: getSettings(): Error invalid value for argc.\n", progName);
-    return ztInvalidArg;
-  }
+  ASSERTARGS(setting && dirs && files && treeDir);
 
-  /* set some sensible defaults we may have to use.
-   *  - {HOME} is current user home directory.
-   *  - default work directory: {HOME}/getdiff/
-   *  - default configuration file: {HOME}/getdiff.conf
-   *
-   ********************************************/
+  int  result;
 
-  char  *homeDir;
-  char  *defConfFile;
+  /* metrics file is written at EXIT_CLEAN; counters start with logger **/
+  if(setting->metricsDir){
 
-  int   result;
+    result = startMetrics(setting->metricsDir, treeDir, dirs->workDir);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed startMetrics() for: <%s>\n", progName, setting->metricsDir);
+      logMessage(fLogPtr, "Error failed startMetrics() function.");
+      return result;
+    }
 
-  homeDir = getHome();
-  if( ! homeDir ){
-    fprintf(stderr, "%s: Error failed getHome() function.\n", progName);
-    return ztUnknownError;
+    logMessage(fLogPtr, "Writing Prometheus metrics file to directory below:");
+    logMessage(fLogPtr, setting->metricsDir);
   }
 
-  appendEntry2Path(&defConfFile, homeDir, CONF_NAME);
+  /* events channel to updater; opened before any download **/
+  if(setting->eventsPath){
 
-  /* parse command line arguments first; give user chance to set
-   * configuration file.
-   * Note that ALL settings are zeroed out going in **/
-  memset(settings, 0, sizeof(MY_SETTING));
+    result = openEvents(setting->eventsPath);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed openEvents() for: <%s>\n", progName, setting->eventsPath);
+      logMessage(fLogPtr, "Error failed openEvents() function.");
+      return result;
+    }
 
-  result = parseCmdLine(settings, argc, argv);
-  if (result != ztSuccess){
-    fprintf(stderr, "%s: Error failed parseCmdLine().\n", progName);
-    return result;
+    logMessage(fLogPtr, "Events channel is set to path below:");
+    logMessage(fLogPtr, setting->eventsPath);
   }
 
-  if((settings->configureFile) &&
-     (isFileUsable(settings->configureFile) != ztSuccess)){
+  /* zstd workers start before first download completes **/
+  if(setting->zstdMode != ZST_OFF){
 
-    fprintf(stderr, "%s: Error specified configuration file is not usable.\n"
-            " File checked: %s\n", progName, settings->configureFile);
-    return ztInvalidArg;
-  }
+    result = startTranscode((ZST_MODE) setting->zstdMode);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed startTranscode().\n", progName);
+      logMessage(fLogPtr, "Error failed startTranscode() function.");
+      return result;
+    }
 
-  if(! settings->configureFile)
+    logMessage(fLogPtr, "Transcoding change files to zstd on worker threads.");
+  }
 
-    settings->configureFile = STRDUP(defConfFile);
+  if(setting->summary){
 
-  free(defConfFile);
+    result = startSummary();
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed startSummary().\n", progName);
+      logMessage(fLogPtr, "Error failed startSummary() function.");
+      return result;
+    }
 
-  result = isFileUsable(settings->configureFile);
+    logMessage(fLogPtr, "Writing summary files on worker threads.");
+  }
 
-  if(result != ztSuccess)
+  if(setting->expire){
 
-    fprintf(stdout, "%s: Warning not using any configuration file;\n"
-            " file not specified by user and default configuration file is not usable.\n"
-            " Checked for configure file <%s>\n"
-            " File is not usable for: <%s>\n",
-            progName, settings->configureFile, ztCode2Msg(result));
+    result = startExpire(setting->expireMinZoom, setting->expireMaxZoom, files->sourceDir);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed startExpire().\n", progName);
+      logMessage(fLogPtr, "Error failed startExpire() function.");
+      return result;
+    }
 
-  int  haveConfArgs = (settings->usr && settings->pswd &&
-                       settings->source && settings->rootWD &&
-                       settings->startNumber && settings->endNumber &&
-                       settings->logFile && settings->newDifferOff &&
-					   settings->verbose);
+    logMessage(fLogPtr, "Collecting expired tiles on worker threads.");
+  }
 
-  /* skip processing configuration file when
-   * ALL arguments are given on the command line **/
+  /* polygon files are read and object cache loaded before any download **/
+  if(setting->numRegions){
 
-  if(result == ztSuccess && ! haveConfArgs ){
+    /* regions tree and object cache are for work directory; one at a time **/
+    char  *regionsLock = appendName2Dir(dirs->workDir, REGIONS_LOCK);
 
-    /* our array for configure entries with value member set to 'NULL' **/
-    CONF_ENTRY  confEntries[] = {
-      {"USER", NULL, NAME_CT, 0},
-      {"PASSWD", NULL, NAME_CT, 0},
-      {"SOURCE", NULL, INET_URL_CT, 0},
-      {"DIRECTORY", NULL, DIR_CT, 0},
-	  {"LOG_FILE", NULL, FILE_CT, 0},
-      {"BEGIN", NULL, DIGITS9_CT, 0},
-      {"END", NULL, DIGITS9_CT, 0},
-      {"VERBOSE", NULL, BOOL_CT, 0},
-      {"NEWER_FILE", NULL, NONE_CT, 0}, /* NONE_CT accepts 'none' and 'off' for value **/
-      {NULL, NULL, 0, 0}
-    };
+    result = regionsLock ? getLock(&regionsFD, regionsLock) : ztMemoryAllocate;
+    if(regionsLock)
+      free(regionsLock);
 
-    result = initialConf(confEntries, 9);
     if(result != ztSuccess){
-      fprintf(stderr, "%s: Error failed initialConf() function for <%s>. Exiting.\n",
-              progName, ztCode2Msg(result));
-      return result;
+      fprintf(stderr, "%s: Error another instance is writing regions in work directory.\n", progName);
+      logMessage(fLogPtr, "Error another instance is writing regions in work directory.");
+      return ztInvalidUsage;
     }
 
-    int numFound;
+    regionSet = initialRegionSet(setting->regionArgs, setting->numRegions, dirs->workDir);
+    if(!regionSet){
+      fprintf(stderr, "%s: Error failed initialRegionSet().\n", progName);
+      logMessage(fLogPtr, "Error failed initialRegionSet() function.");
+      return ztInvalidArg;
+    }
+  }
 
-    confErrLineNum = 0; /* on error set by configureGetValue() **/
+  return ztSuccess;
 
-    result = configureGetValues(confEntries, &numFound, settings->configureFile);
+} /* END startFeatures() **/
 
-    /*
-     * configureGetValues() reads and checks all
-     * entries regardless of command line settings!
-     * we could remove entries set on the command line???
-     * wrong entries in the configuration file will NOT
-     * get checked then.
-     * we may have an array of set command line values and
-     * then not check configure corresponding value?!
-     * or add IGNORE member in CONF_ENTRY?! which we set
-     * after reading command line.
-     *
-     ****************************************************/
+/* startTreeFeatures(): object id index and content store; store needs
+ * 'sourceURL' set.
+ *
+ ***************************************************************************/
 
-    if(result != ztSuccess){
-      fprintf(stderr, "%s: Error failed configureGetValues() function for <%s>. Exiting.\n",
-              progName, ztCode2Msg(result));
+static int startTreeFeatures(MY_SETTING *setting, char *treeDir){
 
-      if(confErrLineNum)
+  ASSERTARGS(setting && treeDir);
 
-        fprintf(stderr, "Error in configuration file at line number: <%d>\n",  confErrLineNum);
+  int  result;
 
+  /* index lives in change files tree **/
+  if(setting->index){
+
+    result = startIndex(treeDir);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed startIndex().\n", progName);
+      logMessage(fLogPtr, "Error failed startIndex() function.");
       return result;
     }
 
-    /* mergeConfigure(): brings in values from configuration file to settings **/
-    result = mergeConfigure(settings, confEntries);
+    logMessage(fLogPtr, "Indexing object ids on worker threads.");
+  }
+
+  /* store is shared with other work directories **/
+  if(setting->storeDir){
+
+    result = startStore(setting->storeDir, sourceURL);
     if(result != ztSuccess){
-      fprintf(stderr, "%s: Error failed mergeConfigure() function.\n", progName);
+      fprintf(stderr, "%s: Error failed startStore().\n", progName);
+      logMessage(fLogPtr, "Error failed startStore() function.");
       return result;
     }
 
-    // TODO: zap conf entries() :: reverse initialConf(confEntries, 8);
+    logMessage(fLogPtr, "Using content store below:");
+    logMessage(fLogPtr, setting->storeDir);
+  }
 
-  } /* end if(... process configuration file ...) **/
+  return ztSuccess;
 
-  /* if user did not specify where to have work directory; use $HOME **/
-  if( ! settings->rootWD)
+} /* END startTreeFeatures() **/
 
-    settings->rootWD = STRDUP(homeDir);
+/* startRetentionRun(): starts retention for update run from 'startSeq';
+ * files from previous sequence on and those updater has not consumed are
+ * kept. Nothing is done without a retention policy.
+ *
+ ***************************************************************************/
 
-  result = isDirUsable(settings->rootWD);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed isDirUsable() function for work directory"
-            " root! Directory tested: <%s>\n"
-            "Directory must exist and user ownership for this directory is required.\n"
-            "function failed for: <%s>\n",
-            progName, settings->rootWD, ztCode2Msg(result));
-    return result;
-  }
+static int startRetentionRun(MY_SETTING *setting, GD_FILES *files, char *treeDir, const char *startSeq){
 
-  /* root for work directory can not end with "getdiff" entry **/
-  char   *lastEntry;
+  ASSERTARGS(setting && files && treeDir && startSeq);
 
-  lastEntry = lastOfPath(settings->rootWD);
-  if(strcmp(lastEntry,WORK_ENTRY) == 0){
+  int  result;
 
-    fprintf(stderr, "%s: Error root for work directory can not end with <%s> entry.\n",
-            progName, WORK_ENTRY);
-    return ztInvalidArg;
+  RETAIN_POLICY  policy = {setting->retainDays, setting->retainCount, setting->retainBytes};
+
+  if(RETAIN_POLICY_SET(&policy) && (setting->newDifferOff || setting->textOnly)){
+    fprintf(stdout, "%s: Retention is skipped; it needs 'newerFiles.txt' to know what updater has consumed.\n", progName);
+    logMessage(fLogPtr, "Retention is skipped; it needs 'newerFiles.txt' to know what updater has consumed.");
   }
+  else if(RETAIN_POLICY_SET(&policy)){
 
-  /* logFile setting: use default {workdir}/getdiff.log if not set by user **/
+    SEQ_NUM  floor, bound;
 
+    result = string2Sequence(&bound, startSeq);
+    if(result == ztSuccess)
+      result = consumerFloor(&floor, files->newDiffersFile, files->cursorFile);
 
+    if(result == ztSuccess){
 
-  return ztSuccess;
+      if(floor != SEQ_NONE && floor < bound)
+        bound = floor;
 
-} /* END getSettings() **/
+      result = startRetention(treeDir, &policy, bound);
+    }
 
-/* mergeConfigure(): merges configure 'value' into settings.
- * Member 'value' is used only if NOT set in settings
- *
- *
- *****************************************************************/
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed starting retention.\n", progName);
+      logMessage(fLogPtr, "Error failed starting retention.");
 
-int mergeConfigure(MY_SETTING *settings, CONF_ENTRY confEntries[]){
+      return result;
+    }
 
-  CONF_ENTRY   *mover;
+    logMessage(fLogPtr, "Removing old change files on retention thread.");
+  }
 
-  ASSERTARGS (settings && confEntries);
+  return ztSuccess;
 
-  /* use configure setting only when not in 'settings' structure **/
-  mover= confEntries;
-  while (mover->key){
+} /* END startRetentionRun() **/
 
-    switch (mover->index){ /* index member is set in initialConf() **/
+/* startPairCommit(): opens journal for 'startSeq' to 'endSeq' and drops
+ * pairs it has from 'newDiffersList'; a rerun picks up from it. Sets pair
+ * publish when no end of run step rewrites the list, and stop signals.
+ *
+ ***************************************************************************/
 
-    case 0: // USER
+static int startPairCommit(MY_SETTING *setting, SKELETON *dirs, GD_FILES *files, char *treeDir,
+                           STRING_LIST *newDiffersList, const char *startSeq, const char *endSeq){
 
-      if ( ! settings->usr && mover->value)
+  ASSERTARGS(setting && dirs && files && treeDir && newDiffersList && startSeq && endSeq);
 
-        settings->usr = STRDUP(mover->value);
+  char  logStr[256];
+  int   result;
 
-      break;
+  SEQ_NUM  firstSeq, lastSeq;
 
-    case 1: // PASSWD
+  result = string2Sequence(&firstSeq, startSeq);
+  if(result == ztSuccess)
+    result = string2Sequence(&lastSeq, endSeq);
 
-      if ( ! settings->pswd && mover->value)
+  if(result == ztSuccess)
+    result = openJournal(files->journalFile, (setting->endNumber != NULL), firstSeq, lastSeq);
 
-        settings->pswd = STRDUP (mover->value);
+  if(result == ztSuccess)
+    result = dropPublished(newDiffersList);
 
-      break;
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed starting journal: <%s>\n", progName, files->journalFile);
+    logMessage(fLogPtr, "Error failed starting journal; file below:");
+    logMessageLevel(fLogPtr, LOG_ERROR, files->journalFile);
 
-    case 2: // SOURCE
+    return result;
+  }
 
-      if ( ! settings->source && mover->value) {
+  if(journalResumed()){
+    fprintf(stdout, "%s: Resuming interrupted run; <%d> pairs on disk are not downloaded again.\n",
+            progName, journalResumed());
+    sprintf(logStr, "Resuming interrupted run; <%d> pairs on disk are not downloaded again.", journalResumed());
+    logMessage(fLogPtr, logStr);
+  }
 
-        settings->source = STRDUP (mover->value);
-      }
-      break;
+  /* merge, regions, transcode and end of run files need whole list **/
+  pairPublish = ! (setting->merge || regionSet || isTranscoding() ||
+                   isSummarizing() || isExpiring() || isIndexing());
 
-    case 3: // DEST_DIR; root for work directory
+  if(pairPublish && setting->endNumber){
+    pairListFile = files->rangeFile;
+    if(treeDir != dirs->geofabrik)
+      pairGranularity = lastOfPath(sourceURL);
+  }
+  else if(pairPublish){
+    pairListFile = setting->newDifferOff ? NULL : files->newDiffersFile;
+    pairSeqFile = files->previousSeqFile;
+  }
 
-      if ( ! settings->rootWD && mover->value){
+  struct sigaction  stopAction;
 
-        settings->rootWD = STRDUP (mover->value);
+  /* second signal is not caught; it stops program right away **/
+  memset(&stopAction, 0, sizeof(stopAction));
+  stopAction.sa_handler = onStopSignal;
+  sigemptyset(&stopAction.sa_mask);
+  stopAction.sa_flags = SA_RESETHAND;
 
-      }
-      break;
+  sigaction(SIGTERM, &stopAction, NULL);
+  sigaction(SIGINT, &stopAction, NULL);
 
-    case 4: // LOG_FILE
+  return ztSuccess;
 
-      if ( !settings->logFile && mover->value){
+} /* END startPairCommit() **/
 
-          settings->logFile = STRDUP (mover->value);
-      }
-      break;
+/* finishFeatures(): end of run files for features started by startFeatures()
+ * and startTreeFeatures(), then regional files, zstd names and merge into
+ * 'mergedList'. Caller holds tree state for writing.
+ *
+ ***************************************************************************/
 
-    case 5: // BEGIN
+static int finishFeatures(MY_SETTING *setting, GD_FILES *files, char *treeDir, STRING_LIST *completedList, STRING_LIST **mergedList){
 
-      if ( !settings->startNumber && mover->value){
+  ASSERTARGS(setting && files && treeDir && completedList && mergedList);
 
-        settings->startNumber = STRDUP (mover->value);
-      }
-      break;
+  int  result;
 
-    case 6: // END
+  if(isSummarizing()){
 
-      if ( !settings->endNumber && mover->value){
+    result = finishSummary();
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed writing summary files.\n", progName);
+      logMessage(fLogPtr, "Error failed writing summary files.");
 
-        settings->endNumber = STRDUP (mover->value);
-      }
-      break;
+      return result;
+    }
+  }
 
-    case 7: // VERBOSE
+  if(isExpiring()){
 
-      if (settings->verbose == 1)
+    result = finishExpire(files->expireFile);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed writing expired tiles file.\n", progName);
+      logMessage(fLogPtr, "Error failed writing expired tiles file.");
 
-        break;
+      return result;
+    }
+  }
 
-      if(mover->value){
+  if(isIndexing()){
 
-        char *lowerValue;
+    result = finishIndex();
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed writing object id index.\n", progName);
+      logMessage(fLogPtr, "Error failed writing object id index.");
 
-        string2Lower(&lowerValue, mover->value); // do NOT use strcasecmp()
-        if(!lowerValue){
-          fprintf(stderr, "mergeConfigure(): Error failed string2Lower() for value!\n");
-          return ztMemoryAllocate;
-        }
+      return result;
+    }
+  }
 
-        if ((strcmp(lowerValue, "true") == 0) ||
-            (strcmp(lowerValue, "on") == 0) ||
-            (strcmp(mover->value, "1") == 0))
+  /* regions first; transcode renames list entries to .osc.zst **/
+  if(regionSet){
 
-          settings->verbose = 1;
+    result = filterCompleted(completedList, treeDir);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed filterCompleted().\n", progName);
+      logMessage(fLogPtr, "Error failed filterCompleted().");
 
-      }
+      return result;
+    }
+  }
 
-      break;
+  if(isTranscoding()){
 
-    case 8: // newDifferOff
+    result = finishTranscode();
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed transcoding change files to zstd.\n", progName);
+      logMessage(fLogPtr, "Error failed transcoding change files to zstd.");
 
-      if(!settings->newDifferOff && mover->value)
+      return result;
+    }
 
-        settings->newDifferOff = 1;
+    /* list file names what is on disk **/
+    result = zstdListNames(completedList);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed zstdListNames().\n", progName);
+      logMessage(fLogPtr, "Error failed zstdListNames().");
 
-      break;
+      return result;
+    }
 
-    default:
+    fprintf(stdout, "%s: Transcoded change files to zstd.\n", progName);
+    logMessage(fLogPtr, "Transcoded change files to zstd.");
+  }
 
-      break;
-    } // end switch
+  /* merged pair is written to list file instead of downloaded files **/
+  if(setting->merge){
 
-    mover++;
+    result = mergeCompleted(mergedList, completedList, setting->startNumber, setting->endNumber, treeDir);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed mergeCompleted() function.\n", progName);
+      logMessage(fLogPtr, "Error failed mergeCompleted() function.");
 
-  } // end while()
+      return result;
+    }
+  }
 
   return ztSuccess;
 
-} /* END mergeConfigure() **/
+} /* END finishFeatures() **/
 
-int chkRequired(MY_SETTING *settings, char *previousFile){
+/* packSourceTree(): packs completed parent directories; updater must have
+ * consumed them. Retention removes from same tree; it finishes first.
+ *
+ ***************************************************************************/
 
-  ASSERTARGS(settings && previousFile);
+static int packSourceTree(MY_SETTING *setting, GD_FILES *files, char *treeDir, const char *endSeq){
 
-  int result;
+  ASSERTARGS(setting && files && treeDir && endSeq);
 
-  /* source must be supported; curl URL parser is used. **/
-  if( isSourceSupported(sourceURL, curlParseHandle) != ztSuccess){
-//  if( isSourceSupported_old(sourceURL) != ztSuccess){
-    fprintf (stderr, "%s: Error specified source URL is not supported by this program.\n", progName);
-    logMessage(fLogPtr, "Error specified source URL is not supported by this program.");
-    return ztInvalidArg;
-  }
+  PACK_REPORT  packReport;
+  SEQ_NUM      floor, bound;
+  int          result;
 
-  /* can we reach 'source'? network connection is required.
-   * note: curl session is not required for isConnCurl() function. **/
-  result = isConnCurl(settings->source);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error could not connect to 'source': <%s>\n"
-            "This program requires internet connection.", progName, settings->source);
-    logMessage(fLogPtr, "Not connected! This program requires internet connection.");
-    return result;
+  if(setting->newDifferOff){
+    fprintf(stdout, "%s: Packing is skipped; it needs 'newerFiles.txt' to know what updater has consumed.\n", progName);
+    logMessage(fLogPtr, "Packing is skipped; it needs 'newerFiles.txt' to know what updater has consumed.");
+    return ztSuccess;
   }
 
-  /* user name and password argument are required when
-   * geofabrik internal server is in use **/
-
-  int useInternal = 0;
+  finishRetention();
 
-  if(strstr(sourceURL, INTERNAL_SERVER))
+  result = string2Sequence(&bound, endSeq);
+  if(result == ztSuccess)
+    result = consumerFloor(&floor, files->newDiffersFile, files->cursorFile);
 
-    useInternal = 1;
+  if(result == ztSuccess){
 
-  if(useInternal && ( ! settings->usr)){
-    fprintf(stderr, "%s: Error missing 'usr' argument;\n"
-            "User name for 'OSM ACCOUNT' is required for geofabrik.de internal server.\n"
-            "Note that email associated with the account can be used for user name.\n", progName);
-    logMessage(fLogPtr, "Error missing 'usr' argument; User name for 'OSM ACCOUNT' is required for geofabrik.de internal server.");
-    return ztMissingArg;
-  }
+    if(floor != SEQ_NONE && floor < bound)
+      bound = floor;
 
-  if(useInternal && (! settings->pswd)){
-    fprintf(stderr, "%s: Error missing 'passwd' argument.\n"
-            "Password for 'OSM ACCOUNT' is required for geofabrik.de internal server.\n", progName);
-    logMessage(fLogPtr, "Error missing 'passwd' argument; password for 'OSM ACCOUNT' is required for geofabrik.de internal server.");
-    return ztMissingArg;
+    result = packTree(&packReport, treeDir, bound);
   }
 
-  /* 'begin' argument is required for program first time use only.
-   * On exit program writes "previous.state.txt" file in its working
-   * directory, it is program first run when this file is NOT found.
-   * Note that we do not look inside the file!
-   *
-   ************************************************************/
-
-  int   firstUse;
-
-  result = isFileUsable(previousFile);
-
-  firstUse = (result != ztSuccess);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed packing change files tree.\n", progName);
+    logMessage(fLogPtr, "Error failed packing change files tree.");
 
-  if(firstUse && (! settings->startNumber)){
-    fprintf(stderr, "%s: Error missing 'begin' argument; argument is required for program first use.\n", progName);
-    logMessage(fLogPtr, "Error missing 'begin' argument; argument is required for program first use.");
-    return ztMissingArg;
+    return result;
   }
 
-  if(settings->endNumber && (settings->startNumber == NULL)){
-    fprintf(stderr, "%s: Error missing 'begin' argument with 'end' set; argument is required to download a range of files.\n", progName);
-    logMessage(fLogPtr, "Error missing 'begin' argument with 'end' set; argument is required to download a range of files.");
-    return ztMissingArg;
+  if(packReport.parents){
+    char packBuff[256];
+    snprintf(packBuff, sizeof(packBuff), "Packed %ld directories; %ld files, %lld bytes%s.",
+             packReport.parents, packReport.files, packReport.bytes,
+             packReport.more ? "; more are left for next run" : "");
+    fprintf(stdout, "%s: %s\n", progName, packBuff);
+    logMessage(fLogPtr, packBuff);
   }
 
   return ztSuccess;
 
-} /* END chkRequired() **/
+} /* END packSourceTree() **/
 
-char *setDiffersDirPrefix(SKELETON *skl, const char *src){
+/* startSession(): sets 'sourceURL' - lower case, local source keeps its
+ * case, "file:///dir/" see localsrc.h - and starts curl session; curl
+ * parse handle verifies remote source URL. Undone by closeSession().
+ *
+ ***************************************************************************/
 
-  char *dest = NULL;
+static int startSession(MY_SETTING *setting){
 
-  ASSERTARGS(skl && src);
+  ASSERTARGS(setting);
 
-  if(strstr(src, "geofabrik"))
-    dest = skl->geofabrik;
-  else if(strstr(src, "minute"))
-    dest = skl->planetMin;
-  else if(strstr(src, "hour"))
-    dest = skl->planetHour;
-  else if(strstr(src, "day"))
-    dest = skl->planetDay;
+  int  result;
+
+  localSource = isLocalSource(setting->source);
+
+  if(localSource)
+    result = localSourceURL((char **) &sourceURL, setting->source);
   else
-    ;
+    result = string2Lower((char **) &sourceURL, setting->source);
+  if(!sourceURL){
+    fprintf(stderr, "%s: Error failed %s function.\n", progName,
+            localSource ? "localSourceURL()" : "string2Lower()");
+    return (result != ztSuccess) ? result : ztInvalidArg;
+  }
 
-  return dest;
+  result = initialCurlSession();
+  if (result != ztSuccess){
+    fprintf(stderr, "%s: Error failed initialCurlSession() function.\n", progName);
+    logMessage(fLogPtr, "Error failed initialCurlSession() function.");
 
-} /* END setDiffersDirPrefix() **/
+    return result;
+  }
+  else
+    logMessage(fLogPtr, "Initialed curl session okay.");
 
-char *getLoginToken(MY_SETTING *setting, SKELETON *myDir){
+  /* local source has no server; no curl parse handle **/
+  if(localSource){
 
-  ASSERTARGS(setting && myDir);
+    result = startLocalSource(sourceURL);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed startLocalSource() function.\n", progName);
+      logMessage(fLogPtr, "Error failed startLocalSource() function.");
 
-  char *token = NULL;
-  int  result;
+      return result;
+    }
 
-  result = doCookie(setting, myDir);
-  if(result != ztSuccess){
+    logMessage(fLogPtr, "Using local source directory below:");
+    logMessage(fLogPtr, sourceURL);
+  }
 
-    /* handle ztExpiredCookie return as fatal error **/
+  /* get curl parse handle using sourceURL - in LOWER case **/
+  else if (! (curlParseHandle = initialURL(sourceURL))){
+    fprintf(stderr, "%s: Error failed initialURL() function.\n", progName);
+    logMessage(fLogPtr,"Error failed initialURL() function.");
 
-    fprintf(stderr, "%s: Error failed doCookie() function.\n", progName);
-    logMessage(fLogPtr, "Error failed doCookie() function.");
+    return ztFailedLibCall;
+  }
 
-    return token;
+  if(fVerbose && ! localSource){
+    fprintf(stdout, "%s: Acquired curl parse handle with initialURL() function okay.\n", progName);
+    logMessage(fLogPtr, "Acquired curl parse handle with initialURL() function okay.");
   }
 
-  token = getCookieToken();
+  return ztSuccess;
 
-  if(!token){
+} /* END startSession() **/
 
-    fprintf(stderr, "%s: Error failed getCookieToken() function.\n", progName);
-    logMessage(fLogPtr, "Error failed getCookieToken() function.");
+/* startDownloadHandle(): curl download handle for remote source; login
+ * for Geofabrik internal server, or metadata from public server with
+ * login left to first change file.
+ *
+ ***************************************************************************/
 
-    return token;
-  }
+static int startDownloadHandle(MY_SETTING *setting, SKELETON *dirs){
 
-  destroyCookie(); /* tell cookie logic to cleanup **/
+  ASSERTARGS(setting && dirs);
 
-  return token;
+  CURLUcode  curluResult; /* parser returned type from curl_url_get() & curl_url_set() **/
+  int        useInternal;
+  char       *secToken = NULL; /* needed for geofabrik internal server **/
+  char       *host = NULL;
+  char       *path = NULL;
+  int        result = ztSuccess;
 
-} /* END getLoginTiken() **/
+  /* use curl parse handle to retrieve 'host' to set useInternal flag,
+   * get 'path' also for public metadata server.
+   *******************************************************************/
+  curluResult = curl_url_get(curlParseHandle, CURLUPART_HOST, &host, 0);
+  if (curluResult != CURLUE_OK ) {
+    fprintf(stderr, "%s: Error failed curl_url_get() for 'host' part.\n", progName);
+    logMessage(fLogPtr, "Error failed curl_url_get() for 'host' part.");
 
-/* isStateFileList():
- *  - must be a STRING_LT
- *  - must have exactly THREE lines
- *  - one line must start with "timestamp=" substring
- *  - one line must start with "sequenceNumber=" substring
- *
- * **************************************************/
-int isStateFileList(STRING_LIST *list){
+    result = ztFailedLibCall;
+    goto HANDLE_CLEAN;
+  }
 
-  ASSERTARGS(list);
+  curluResult = curl_url_get(curlParseHandle, CURLUPART_PATH, &path, 0);
+  if (curluResult != CURLUE_OK ) {
+    fprintf(stderr, "%s: Error failed curl_url_get() for path part.\n", progName);
+    logMessage(fLogPtr, "Error failed curl_url_get() for path part.");
 
-  if( ! TYPE_STRING_LIST(list) )
+    result = ztFailedLibCall;
+    goto HANDLE_CLEAN;
+  }
 
-    return FALSE;
+  if(fVerbose){
+    fprintf(stdout, "%s: Retrieved 'host' and 'path' from curl parse handle okay.\n", progName);
+    logMessageLevel(fLogPtr, LOG_DEBUG, "Retrieved 'host' and 'path' from curl parse handle okay.");
+  }
 
-//  if(DL_SIZE(list) != 3)
-  if(DL_SIZE(list) < 3)
+  useInternal = (strcmp(host, INTERNAL_SERVER) == 0);
 
-    return FALSE;
+  /* metadata from public server; no cookie until first change file **/
+  if(useInternal && setting->publicMeta){
 
-  ELEM   *elem;
-  char   *timeLine = NULL;
-  char   *sequenceLine = NULL;
+    result = initialMetaHandles(path);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed initialMetaHandles() function.\n", progName);
+      logMessage(fLogPtr, "Error failed initialMetaHandles() function.");
 
-  elem = findElemSubString(list, "timestamp=");
-  if(elem)
-    timeLine = (char*) DL_DATA(elem);
+      goto HANDLE_CLEAN;
+    }
 
-  elem = findElemSubString(list, "sequenceNumber=");
-  if(elem)
-    sequenceLine = (char*) DL_DATA(elem);
+    loginSetting = setting;
+    loginDir = dirs;
+    useInternal = 0;
 
-  if(! timeLine)
-    fprintf(stderr, "isStateFileList(): Error could not find timeLine.\n");
+    if(fVerbose)
+      fprintf(stdout, "%s: Using public server for metadata <%s>; login is left to first change file.\n",
+              progName, metaSourceURL);
+    logMessage(fLogPtr, "Using public server for metadata; login is left to first change file.");
+  }
 
-  if(! sequenceLine)
-    fprintf(stderr, "isStateFileList(): Error could not find sequenceLine.\n");
+  if(useInternal){ /* set cookie; login token from cookie file. see 'cookie.c' file **/
 
-  if(timeLine && sequenceLine)
+    if(fVerbose)
+      fprintf(stdout, "%s: Geofabrik Internal Server is in use, calling getLoginToken() function...\n", progName);
+    logMessage(fLogPtr, "Geofabrik Internal Server is in use, Calling getLoginToken() function...");
 
-    return TRUE;
+    secToken = getLoginToken(setting, dirs);
+    if(!secToken){
+      fprintf(stderr, "%s: Error failed getLoginToken() function.\n", progName);
+      logMessage(fLogPtr, "Error failed getLoginToken() function.");
 
-  return FALSE;
+      result = ztNoCookieToken;
+      goto HANDLE_CLEAN;
+    }
 
-} /* END isStateFileList() **/
+    if(fVerbose){
+      fprintf(stdout, "%s: Retrieved 'login token' from cookie file okay.\n", progName);
+      logMessageLevel(fLogPtr, LOG_DEBUG, "Retrieved 'login token' from cookie file okay.");
+    }
 
-int isGoodSequenceString(const char *string){
+  } /* end if(useInternal) **/
 
-  char   *digits = "1234567890";
+  /* to communicate with remote server; get downloadHandle **/
+  downloadHandle = initialOperation(curlParseHandle, secToken);
+  if( !downloadHandle ){
+    fprintf(stderr, "%s: Error failed initialOperation() function.\n", progName);
+    logMessage(fLogPtr, "Error failed initialOperation() function.");
 
-  ASSERTARGS(string);
+    result = ztFailedLibCall;
+    goto HANDLE_CLEAN;
+  }
+  else{
+    if(fVerbose){
+      fprintf(stdout, "%s: Obtained curl download handle okay.\n", progName);
+      logMessageLevel(fLogPtr, LOG_DEBUG, "Obtained curl download handle okay.");
+    }
+  }
 
-  if((strlen(string) > 9) || (strlen(string) < 3)) // had to go back to day/2014
+HANDLE_CLEAN:
 
-    return FALSE;
+  if(host)
+    curl_free(host);
 
-  if(strspn(string, digits) != strlen(string))
+  if(path)
+    curl_free(path);
 
-    return FALSE;
+  return result;
 
-  if(string[0] == '0')
+} /* END startDownloadHandle() **/
 
-    return FALSE;
+/* closeFeatures(): stops every feature - finished or not - and closes its
+ * files; safe for features never started. Journal is closed without end
+ * record, so next run resumes; metrics file gets 'status'.
+ *
+ ***************************************************************************/
 
-  return TRUE;
+static void closeFeatures(int status){
 
-} /* END isGoodSequenceString() **/
+  closeJournal();
 
-/* myDownload():
- * appends 'remotePathSuffix' to current 'pathPrefix' in curl parse handle.
- * 'remotePathSuffix' is the path part from the sequence number, might include
- * change file name and state.txt file name.
- *
- * originalPath is restored before exit (return).
- *
- ******************************************************************************/
+  finishMetrics(status);
 
-int myDownload(char *remotePathSuffix, char *localFile){
+  /* workers may still send events **/
+  finishTranscode();
 
-  int   result;
+  finishSummary();
 
-  CURLUcode   curluResult; /* returned type by curl_url_get() & curl_url_set() **/
-  char        *originalPath;
-  char        newPath[PATH_MAX] = {0};
+  /* tiles are dropped on error exit **/
+  finishExpire(NULL);
 
-  char        *currentSourceURL;
+  /* files on disk are good; keep what is indexed **/
+  finishIndex();
 
-  ASSERTARGS(remotePathSuffix && localFile);
+  /* writes retention report to log **/
+  finishRetention();
 
-  result = isGoodFilename(localFile);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed isGoodFilename() for 'localFile' parameter in myDownload(): <%s>.\n",
-            progName, localFile);
-    return result;
-  }
+  finishStore();
 
-  /* ensure that "curlParseHandle" is intact
-   * currentSourceURL is NEVER NULL; it can be empty string **/
-  currentSourceURL = getUrlStringCURLU(curlParseHandle);
+  /* saves object cache for next run **/
+  closeRegionSet(&regionSet);
 
-  if(strcmp(sourceURL, currentSourceURL) != 0){
-    fprintf(stderr, "%s: Error fatal NOT same strings in sourceURL: <%s> and currentSourceURL: <%s>.\n",
-            progName, sourceURL, currentSourceURL);
-    return ztFatalError;
+  if(regionsFD != -1){
+    releaseLock(regionsFD);
+    regionsFD = -1;
   }
 
-  /* append remote path suffix to current path in parse handle **/
-  if(remotePathSuffix){
+  closeEvents();
 
-    char   *allowed = "0123456789.acegostxz\057"; /* 057 octal for forward slash, letters
-                                                     are from: state.txt & .osc.gz **/
+  closeStream();
+  streamSeqFile = NULL;
 
-    if(strspn(remotePathSuffix, allowed) != strlen(remotePathSuffix)){
-      fprintf(stderr, "%s: Error 'remotePathSuffix' parameter has disallowed character.\n", progName);
-      return ztInvalidArg;
-    }
+} /* END closeFeatures() **/
 
-    curluResult = curl_url_get(curlParseHandle, CURLUPART_PATH, &originalPath, 0);
-    if(curluResult != CURLUE_OK ) {
-      fprintf(stderr, "%s: Error failed curl_url_get() for path part.\n"
-              "Curl error message: <%s>\n", progName,
-              curl_url_strerror(curluResult));
-      return ztFailedLibCall;
-    }
+/* closeSession(): curl handles, cookie refresh and local source **/
 
-    /* use ONLY ONE slash between parts **/
+static void closeSession(void){
 
-    if(remotePathSuffix[0] == '\057')
+  stopCookieRefresh();
 
-      remotePathSuffix++;
+  finishLocalSource();
 
-    if(SLASH_ENDING(originalPath))
-      sprintf(newPath, "%s%s", originalPath, remotePathSuffix);
-    else
-      sprintf(newPath, "%s/%s", originalPath, remotePathSuffix);
+  if(sourceURL){
+	free(sourceURL);
+	sourceURL = NULL;
+  }
 
+  if(tmpDir){
+	free(tmpDir);
+	tmpDir = NULL;
+  }
 
-    curluResult = curl_url_set (curlParseHandle, CURLUPART_PATH, newPath, 0);
-    if(curluResult != CURLUE_OK){
-      fprintf(stderr, "%s: Error failed curl_url_set() for new path.\n", progName);
-      return ztFailedLibCall;
-    }
+  if(downloadHandle){
+    easyCleanup(downloadHandle);
+    downloadHandle = NULL;
   }
 
-  result = download2FileRetry(localFile, downloadHandle, curlParseHandle);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed to download file: <%s>.\n"
-            " Function failed for: <%s>\n",progName, localFile, ztCode2Msg(result));
+  if(curlParseHandle){
+    urlCleanup(curlParseHandle);
+    curlParseHandle = NULL;
+  }
 
-    if(result == ztNetConnFailed){
-      fprintf(stderr, "download failed for lost established connection; check cables please.\n");
-      logMessage(fLogPtr, "download failed for lost established connection; check cables please.");
-    }
+  if(metaHandle){
+    easyCleanup(metaHandle);
+    metaHandle = NULL;
+  }
 
-    /* restore originalPath **/
-    curluResult = curl_url_set (curlParseHandle, CURLUPART_PATH, originalPath, 0);
-    if(curluResult != CURLUE_OK ) {
+  if(metaParseHandle){
+    urlCleanup(metaParseHandle);
+    metaParseHandle = NULL;
+  }
+
+  if(metaSourceURL){
+    free(metaSourceURL);
+    metaSourceURL = NULL;
+  }
+
+  closeCurlSession();
+
+} /* END closeSession() **/
+
+/* getSettings(): Gets program settings; from the command line and configuration
+ * file; we do not look at configuration file when ALL settings are provided on
+ * the command line.
+ *
+ * Parameters:
+ *   settings: pointer to MY_SETTING structure, caller allocates memory.
+ *   argc: main() command line argument count.
+ *   argv: main() character pointer to command line arguments.
+ *
+ *   Function uses several globally defined macros; mostly for names.
+ *
+ * Return: ztSuccess on success, several error codes maybe returned.
+ *
+ * Known bug: wrong value in configuration file causes this function to fail;
+ * even when corresponding command line is used to set that particular option.
+ * Maybe add IGNORE flag to CONF_ENTRY? Then set flags after parseCmdLine()?
+ *
+ ******************************************************************************/
+
+int getSettings(MY_SETTING *settings, int argc, char* const argv[]){
+
+  ASSERTARGS(settings && argv);
+
+  if(argc == 1){ /* no argument --> show short help is done in main() **/
+    fprintf(stderr, "%s: getSettings(): Error invalid value for argc.\n", progName);
+    return ztInvalidArg;
+  }
+
+  /* set some sensible defaults we may have to use.
+   *  - {HOME} is current user home directory.
+   *  - default work directory: {HOME}/getdiff/
+   *  - default configuration file: {HOME}/getdiff.conf
+   *
+   ********************************************/
+
+  char  *homeDir;
+  char  *defConfFile;
+
+  int   result;
+
+  homeDir = getHome();
+  if( ! homeDir ){
+    fprintf(stderr, "%s: Error failed getHome() function.\n", progName);
+    return ztUnknownError;
+  }
+
+  appendEntry2Path(&defConfFile, homeDir, CONF_NAME);
+
+  /* parse command line arguments first; give user chance to set
+   * configuration file.
+   * Note that ALL settings are zeroed out going in **/
+  memset(settings, 0, sizeof(MY_SETTING));
+
+  result = parseCmdLine(settings, argc, argv);
+  if (result != ztSuccess){
+    fprintf(stderr, "%s: Error failed parseCmdLine().\n", progName);
+    return result;
+  }
+
+  /* before anything else is printed; "-" moves our stdout to stderr **/
+  if (settings->streamTarget){
+
+    result = openStream(settings->streamTarget, settings->streamTee);
+    if (result != ztSuccess){
+      fprintf(stderr, "%s: Error failed openStream() for: <%s>\n", progName, settings->streamTarget);
+      return result;
+    }
+  }
+
+  /* extracted file is only output on standard output; as for stream **/
+  if (settings->command == CMD_EXTRACT){
+
+    fflush(stdout);
+
+    extractFD = dup(STDOUT_FILENO);
+    if (extractFD < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0){
+      fprintf(stderr, "%s: Error failed dup() for standard output: %s\n", progName, strerror(errno));
+      return ztFailedSysCall;
+    }
+  }
+
+  if((settings->configureFile) &&
+     (isFileUsable(settings->configureFile) != ztSuccess)){
+
+    fprintf(stderr, "%s: Error specified configuration file is not usable.\n"
+            " File checked: %s\n", progName, settings->configureFile);
+    return ztInvalidArg;
+  }
+
+  if(! settings->configureFile)
+
+    settings->configureFile = STRDUP(defConfFile);
+
+  free(defConfFile);
+
+  result = isFileUsable(settings->configureFile);
+
+  if(result != ztSuccess)
+
+    fprintf(stdout, "%s: Warning not using any configuration file;\n"
+            " file not specified by user and default configuration file is not usable.\n"
+            " Checked for configure file <%s>\n"
+            " File is not usable for: <%s>\n",
+            progName, settings->configureFile, ztCode2Msg(result));
+
+  int  haveConfArgs = (settings->usr && settings->pswd &&
+                       settings->source && settings->rootWD &&
+                       settings->startNumber && settings->endNumber &&
+                       settings->logFile && settings->newDifferOff &&
+					   settings->verbose && settings->eventsPath);
+
+  /* skip processing configuration file when
+   * ALL arguments are given on the command line **/
+
+  if(result == ztSuccess && ! haveConfArgs ){
+
+    /* our array for configure entries with value member set to 'NULL' **/
+    CONF_ENTRY  confEntries[] = {
+      {"USER", NULL, NAME_CT, 0},
+      {"PASSWD", NULL, NAME_CT, 0},
+      {"SOURCE", NULL, INET_URL_CT, 0},
+      {"DIRECTORY", NULL, DIR_CT, 0},
+	  {"LOG_FILE", NULL, FILE_CT, 0},
+      {"BEGIN", NULL, DIGITS9_CT, 0},
+      {"END", NULL, DIGITS9_CT, 0},
+      {"VERBOSE", NULL, BOOL_CT, 0},
+      {"NEWER_FILE", NULL, NONE_CT, 0}, /* NONE_CT accepts 'none' and 'off' for value **/
+      {"EVENTS", NULL, FILE_CT, 0},
+      {"RETAIN_DAYS", NULL, ANY_CT, 0},
+      {"RETAIN_COUNT", NULL, ANY_CT, 0},
+      {"RETAIN_SIZE", NULL, ANY_CT, 0},
+      {"STORE", NULL, DIR_CT, 0},
+      {"COOKIE_CACHE", NULL, DIR_CT, 0},
+      {"PUBLIC_META", NULL, BOOL_CT, 0},
+      {"LOG_LEVEL", NULL, ANY_CT, 0},
+      {"METRICS", NULL, DIR_CT, 0},
+      {"LOGIN_HOST", NULL, INET_URL_CT, 0},
+      {"CONSUMER_URL", NULL, INET_URL_CT, 0},
+      {NULL, NULL, 0, 0}
+    };
+
+    result = initialConf(confEntries, 20);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed initialConf() function for <%s>. Exiting.\n",
+              progName, ztCode2Msg(result));
+      return result;
+    }
+
+    int numFound;
+
+    confErrLineNum = 0; /* on error set by configureGetValue() **/
+
+    result = configureGetValues(confEntries, &numFound, settings->configureFile);
+
+    /*
+     * configureGetValues() reads and checks all
+     * entries regardless of command line settings!
+     * we could remove entries set on the command line???
+     * wrong entries in the configuration file will NOT
+     * get checked then.
+     * we may have an array of set command line values and
+     * then not check configure corresponding value?!
+     * or add IGNORE member in CONF_ENTRY?! which we set
+     * after reading command line.
+     *
+     ****************************************************/
+
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed configureGetValues() function for <%s>. Exiting.\n",
+              progName, ztCode2Msg(result));
+
+      if(confErrLineNum)
+
+        fprintf(stderr, "Error in configuration file at line number: <%d>\n",  confErrLineNum);
+
+      return result;
+    }
+
+    /* mergeConfigure(): brings in values from configuration file to settings **/
+    result = mergeConfigure(settings, confEntries);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed mergeConfigure() function.\n", progName);
+      return result;
+    }
+
+    // TODO: zap conf entries() :: reverse initialConf(confEntries, 8);
+
+  } /* end if(... process configuration file ...) **/
+
+  /* if user did not specify where to have work directory; use $HOME **/
+  if( ! settings->rootWD)
+
+    settings->rootWD = STRDUP(homeDir);
+
+  result = isDirUsable(settings->rootWD);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed isDirUsable() function for work directory"
+            " root! Directory tested: <%s>\n"
+            "Directory must exist and user ownership for this directory is required.\n"
+            "function failed for: <%s>\n",
+            progName, settings->rootWD, ztCode2Msg(result));
+    return result;
+  }
+
+  /* root for work directory can not end with "getdiff" entry **/
+  char   *lastEntry;
+
+  lastEntry = lastOfPath(settings->rootWD);
+  if(strcmp(lastEntry,WORK_ENTRY) == 0){
+
+    fprintf(stderr, "%s: Error root for work directory can not end with <%s> entry.\n",
+            progName, WORK_ENTRY);
+    return ztInvalidArg;
+  }
+
+  /* logFile setting: use default {workdir}/getdiff.log if not set by user **/
+
+
+
+  return ztSuccess;
+
+} /* END getSettings() **/
+
+/* mergeConfigure(): merges configure 'value' into settings.
+ * Member 'value' is used only if NOT set in settings
+ *
+ *
+ *****************************************************************/
+
+int mergeConfigure(MY_SETTING *settings, CONF_ENTRY confEntries[]){
+
+  CONF_ENTRY   *mover;
+
+  ASSERTARGS (settings && confEntries);
+
+  /* use configure setting only when not in 'settings' structure **/
+  mover= confEntries;
+  while (mover->key){
+
+    switch (mover->index){ /* index member is set in initialConf() **/
+
+    case 0: // USER
+
+      if ( ! settings->usr && mover->value)
+
+        settings->usr = STRDUP(mover->value);
+
+      break;
+
+    case 1: // PASSWD
+
+      if ( ! settings->pswd && mover->value)
+
+        settings->pswd = STRDUP (mover->value);
+
+      break;
+
+    case 2: // SOURCE
+
+      if ( ! settings->source && mover->value) {
+
+        settings->source = STRDUP (mover->value);
+      }
+      break;
+
+    case 3: // DEST_DIR; root for work directory
+
+      if ( ! settings->rootWD && mover->value){
+
+        settings->rootWD = STRDUP (mover->value);
+
+      }
+      break;
+
+    case 4: // LOG_FILE
+
+      if ( !settings->logFile && mover->value){
+
+          settings->logFile = STRDUP (mover->value);
+      }
+      break;
+
+    case 5: // BEGIN
+
+      if ( !settings->startNumber && mover->value){
+
+        settings->startNumber = STRDUP (mover->value);
+      }
+      break;
+
+    case 6: // END
+
+      if ( !settings->endNumber && mover->value){
+
+        settings->endNumber = STRDUP (mover->value);
+      }
+      break;
+
+    case 7: // VERBOSE
+
+      if (settings->verbose == 1)
+
+        break;
+
+      if(mover->value){
+
+        char *lowerValue;
+
+        string2Lower(&lowerValue, mover->value); // do NOT use strcasecmp()
+        if(!lowerValue){
+          fprintf(stderr, "mergeConfigure(): Error failed string2Lower() for value!\n");
+          return ztMemoryAllocate;
+        }
+
+        if ((strcmp(lowerValue, "true") == 0) ||
+            (strcmp(lowerValue, "on") == 0) ||
+            (strcmp(mover->value, "1") == 0))
+
+          settings->verbose = 1;
+
+      }
+
+      break;
+
+    case 8: // newDifferOff
+
+      if(!settings->newDifferOff && mover->value)
+
+        settings->newDifferOff = 1;
+
+      break;
+
+    case 9: // EVENTS
+
+      if ( !settings->eventsPath && mover->value){
+
+        settings->eventsPath = STRDUP (mover->value);
+      }
+      break;
+
+    case 10: // RETAIN_DAYS
+    case 11: // RETAIN_COUNT
+
+      if (mover->value && ((mover->index == 10) ? !settings->retainDays : !settings->retainCount)){
+
+        char  *endPtr;
+        long  value;
+
+        errno = 0;
+        value = strtol(mover->value, &endPtr, 10);
+        if (errno || *endPtr != '\0' || value < 1){
+          fprintf(stderr, "mergeConfigure(): Error invalid value for '%s' key; must be positive integer: <%s>\n",
+                  mover->key, mover->value);
+          return ztConfInvalidValue;
+        }
+
+        if (mover->index == 10)
+          settings->retainDays = value;
+        else
+          settings->retainCount = value;
+      }
+      break;
+
+    case 12: // RETAIN_SIZE
+
+      if ( !settings->retainBytes && mover->value &&
+           string2Bytes(&settings->retainBytes, mover->value) != ztSuccess){
+
+        fprintf(stderr, "mergeConfigure(): Error invalid value for 'RETAIN_SIZE' key: <%s>\n", mover->value);
+        return ztConfInvalidValue;
+      }
+      break;
+
+    case 13: // STORE
+
+      if ( !settings->storeDir && mover->value)
+
+        settings->storeDir = STRDUP (mover->value);
+
+      break;
+
+    case 14: // COOKIE_CACHE
+
+      if ( !settings->cookieCache && mover->value)
+
+        settings->cookieCache = STRDUP (mover->value);
+
+      break;
+
+    case 15: // PUBLIC_META
+
+      if (settings->publicMeta || ! mover->value)
+
+        break;
+
+      {
+        char *lowerValue;
+
+        string2Lower(&lowerValue, mover->value); // do NOT use strcasecmp()
+        if(!lowerValue){
+          fprintf(stderr, "mergeConfigure(): Error failed string2Lower() for value!\n");
+          return ztMemoryAllocate;
+        }
+
+        if ((strcmp(lowerValue, "true") == 0) ||
+            (strcmp(lowerValue, "on") == 0) ||
+            (strcmp(mover->value, "1") == 0))
+
+          settings->publicMeta = 1;
+
+        free(lowerValue);
+      }
+
+      break;
+
+    case 16: // LOG_LEVEL
+
+      if (settings->logLevel || ! mover->value)
+
+        break;
+
+      {
+        LOG_LEVEL  level;
+        char       *lowerValue;
+
+        string2Lower(&lowerValue, mover->value);
+        if(!lowerValue){
+          fprintf(stderr, "mergeConfigure(): Error failed string2Lower() for value!\n");
+          return ztMemoryAllocate;
+        }
+
+        if (string2LogLevel(&level, lowerValue) != ztSuccess){
+          fprintf(stderr, "mergeConfigure(): Error invalid value for 'LOG_LEVEL' key; must be one of "
+                  "error, warning, info or debug: <%s>\n", mover->value);
+          free(lowerValue);
+          return ztConfInvalidValue;
+        }
+
+        settings->logLevel = lowerValue;
+      }
+
+      break;
+
+    case 17: // METRICS
+
+      if ( !settings->metricsDir && mover->value)
+
+        settings->metricsDir = STRDUP (mover->value);
+
+      break;
+
+    case 18: // LOGIN_HOST
+
+      if ( !settings->loginHost && mover->value){
+
+        settings->loginHost = STRDUP (mover->value);
+
+        /* paths are appended: "{LOGIN_HOST}/login" **/
+        if(settings->loginHost){
+          size_t length = strlen(settings->loginHost);
+          while(length > 0 && settings->loginHost[length - 1] == '/')
+            settings->loginHost[--length] = '\0';
+        }
+      }
+
+      break;
+
+    case 19: // CONSUMER_URL
+
+      if ( !settings->consumerURL && mover->value)
+
+        settings->consumerURL = STRDUP (mover->value);
+
+      break;
+
+    default:
+
+      break;
+    } // end switch
+
+    mover++;
+
+  } // end while()
+
+  return ztSuccess;
+
+} /* END mergeConfigure() **/
+
+int chkRequired(MY_SETTING *settings, char *previousFile){
+
+  ASSERTARGS(settings && previousFile);
+
+  int result;
+  int firstUse;
+
+  /* local source was checked by startLocalSource(); server checks are skipped **/
+  if(isLocalSourceOn())
+    goto CHECK_BEGIN;
+
+  /* source must be supported; curl URL parser is used. **/
+  if( isSourceSupported(sourceURL, curlParseHandle) != ztSuccess){
+//  if( isSourceSupported_old(sourceURL) != ztSuccess){
+    fprintf (stderr, "%s: Error specified source URL is not supported by this program.\n", progName);
+    logMessage(fLogPtr, "Error specified source URL is not supported by this program.");
+    return ztInvalidArg;
+  }
+
+  /* can we reach 'source'? network connection is required.
+   * note: curl session is not required for isConnCurl() function. **/
+  result = isConnCurl(settings->source);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error could not connect to 'source': <%s>\n"
+            "This program requires internet connection.", progName, settings->source);
+    logMessage(fLogPtr, "Not connected! This program requires internet connection.");
+    return result;
+  }
+
+  /* user name and password argument are required when
+   * geofabrik internal server is in use **/
+
+  int useInternal = 0;
+
+  /* not for a mirror with internal server name in its path **/
+  if(strstr(sourceURL, "://" INTERNAL_SERVER))
+
+    useInternal = 1;
+
+  if(useInternal && ( ! settings->usr)){
+    fprintf(stderr, "%s: Error missing 'usr' argument;\n"
+            "User name for 'OSM ACCOUNT' is required for geofabrik.de internal server.\n"
+            "Note that email associated with the account can be used for user name.\n", progName);
+    logMessage(fLogPtr, "Error missing 'usr' argument; User name for 'OSM ACCOUNT' is required for geofabrik.de internal server.");
+    return ztMissingArg;
+  }
+
+  if(useInternal && (! settings->pswd)){
+    fprintf(stderr, "%s: Error missing 'passwd' argument.\n"
+            "Password for 'OSM ACCOUNT' is required for geofabrik.de internal server.\n", progName);
+    logMessage(fLogPtr, "Error missing 'passwd' argument; password for 'OSM ACCOUNT' is required for geofabrik.de internal server.");
+    return ztMissingArg;
+  }
+
+  /* 'begin' argument is required for program first time use only.
+   * On exit program writes "previous.state.txt" file in its working
+   * directory, it is program first run when this file is NOT found.
+   * Note that we do not look inside the file!
+   *
+   ************************************************************/
+
+CHECK_BEGIN:
+
+  result = isFileUsable(previousFile);
+
+  firstUse = (result != ztSuccess);
+
+  if(firstUse && (! settings->startNumber)){
+    fprintf(stderr, "%s: Error missing 'begin' argument; argument is required for program first use.\n", progName);
+    logMessage(fLogPtr, "Error missing 'begin' argument; argument is required for program first use.");
+    return ztMissingArg;
+  }
+
+  if(settings->endNumber && (settings->startNumber == NULL)){
+    fprintf(stderr, "%s: Error missing 'begin' argument with 'end' set; argument is required to download a range of files.\n", progName);
+    logMessage(fLogPtr, "Error missing 'begin' argument with 'end' set; argument is required to download a range of files.");
+    return ztMissingArg;
+  }
+
+  return ztSuccess;
+
+} /* END chkRequired() **/
+
+char *setDiffersDirPrefix(SKELETON *skl, const char *src){
+
+  char *dest = NULL;
+
+  ASSERTARGS(skl && src);
+
+  /* local source directory may be named as on server: "{area}-updates" **/
+  if(strstr(src, "geofabrik") || strstr(src, "-updates"))
+    dest = skl->geofabrik;
+  else if(strstr(src, "minute"))
+    dest = skl->planetMin;
+  else if(strstr(src, "hour"))
+    dest = skl->planetHour;
+  else if(strstr(src, "day"))
+    dest = skl->planetDay;
+  else
+    ;
+
+  return dest;
+
+} /* END setDiffersDirPrefix() **/
+
+char *getLoginToken(MY_SETTING *setting, SKELETON *myDir){
+
+  ASSERTARGS(setting && myDir);
+
+  char *token = NULL;
+  int  result;
+
+  result = doCookie(setting, myDir);
+  if(result != ztSuccess){
+
+    /* handle ztExpiredCookie return as fatal error **/
+
+    fprintf(stderr, "%s: Error failed doCookie() function.\n", progName);
+    logMessage(fLogPtr, "Error failed doCookie() function.");
+
+    return token;
+  }
+
+  token = getCookieToken();
+
+  if(!token){
+
+    fprintf(stderr, "%s: Error failed getCookieToken() function.\n", progName);
+    logMessage(fLogPtr, "Error failed getCookieToken() function.");
+
+    return token;
+  }
+
+  /* renew ahead of expiry on its own thread; fetchRemote() picks it up **/
+  result = startCookieRefresh(setting);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Warning failed startCookieRefresh(); cookie is not renewed during run.\n", progName);
+    logMessage(fLogPtr, "Warning failed startCookieRefresh(); cookie is not renewed during run.");
+  }
+
+  destroyCookie(); /* tell cookie logic to cleanup **/
+
+  return token;
+
+} /* END getLoginTiken() **/
+
+/* runQueueCommand(): handles consumer commands on 'newerFiles.txt' queue.
+ *
+ *  - CMD_PENDING: prints entries past consumer cursor to stdout, one per line.
+ *  - CMD_ACK: advances cursor over 'ackCount' entries; consumer acknowledges
+ *    what it has processed from the last CMD_PENDING output.
+ *
+ ***************************************************************************/
+
+int runQueueCommand(MY_SETTING *setting){
+
+  ASSERTARGS(setting);
+
+  SKELETON     myDir;
+  GD_FILES     myFiles;
+  STRING_LIST  *pending;
+  ELEM         *elem;
+  int          result;
+
+  char         *lowerSource = NULL;
+  char         *treeDir = NULL;
+  char         lockName[PATH_MAX];
+  int          lockFD = -1;
+
+  result = setupFilesys(&myDir, &myFiles, setting->rootWD);
+  if(result != ztSuccess){
+    fprintf (stderr, "%s: Error failed setupFilesys() function.\n", progName);
+    return result;
+  }
+
+  /* list and cursor in work directory unless source is another one **/
+  if(setting->source){
+
+    string2Lower(&lowerSource, setting->source);
+    treeDir = lowerSource ? setDiffersDirPrefix(&myDir, lowerSource) : NULL;
+    if(lowerSource)
+      free(lowerSource);
+
+    if(!treeDir){
+      fprintf(stderr, "%s: Error failed setDiffersDirPrefix() function.\n", progName);
+      zapSkeleton(&myDir);
+      zapGd_files(&myFiles);
+      return ztInvalidArg;
+    }
+
+    result = setSourceFiles(&myFiles, treeDir, workSourceTree(&myDir, treeDir, 0) == treeDir);
+    if(result != ztSuccess){
+      zapSkeleton(&myDir);
+      zapGd_files(&myFiles);
+      return result;
+    }
+  }
+  else
+    treeDir = workSourceTree(&myDir, NULL, 0);
+
+  /* shared lock on tree; download compacts queue with it exclusive **/
+  if(treeDir){
+
+    snprintf(lockName, sizeof(lockName), "%s%s", treeDir, LOCK_FILE);
+
+    result = lockSourceRead(&lockFD, lockName);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed lockSourceRead() for: <%s>\n", progName, lockName);
+      zapSkeleton(&myDir);
+      zapGd_files(&myFiles);
+      return result;
+    }
+  }
+
+  if(setting->command == CMD_ACK){
+
+    result = queueAck(myFiles.newDiffersFile, myFiles.cursorFile, setting->ackCount);
+    if(result != ztSuccess)
+      fprintf(stderr, "%s: Error failed queueAck() function.\n", progName);
+  }
+  else {
+
+    pending = initialStringList();
+    if(!pending){
+      fprintf(stderr, "%s: Error failed initialStringList().\n", progName);
+      zapSkeleton(&myDir);
+      zapGd_files(&myFiles);
+      return ztMemoryAllocate;
+    }
+
+    result = queuePending(pending, NULL, myFiles.newDiffersFile, myFiles.cursorFile);
+    if(result == ztSuccess){
+
+      elem = DL_HEAD(pending);
+      while(elem){
+        fprintf(stdout, "%s\n", (char *) DL_DATA(elem));
+        elem = DL_NEXT(elem);
+      }
+    }
+    else
+      fprintf(stderr, "%s: Error failed queuePending() function.\n", progName);
+
+    zapStringList((void **) &pending);
+  }
+
+  unlockSourceRead(lockFD);
+
+  zapSkeleton(&myDir);
+  zapGd_files(&myFiles);
+
+  return result;
+
+} /* END runQueueCommand() **/
+
+/* runVerifyCommand(): checks local change files tree for 'source';
+ * 'begin' and 'end' limit the check to a range of sequence numbers.
+ * Returns ztMalformedFile when problems are found.
+ *
+ ***************************************************************************/
+
+int runVerifyCommand(MY_SETTING *setting){
+
+  ASSERTARGS(setting);
+
+  SKELETON         myDir;
+  GD_FILES         myFiles;
+  VERIFY_REPORT    report;
+  char             lockName[PATH_MAX];
+  int              lockFD;
+  char             *lowerSource = NULL;
+  char             *prefix;
+  SEQ_NUM          first = SEQ_NONE, last = SEQ_NONE;
+  struct timespec  startTime, endTime;
+  double           seconds;
+  int              numThreads;
+  int              result;
+
+  if(! setting->source){
+    fprintf (stderr, "%s: Error missing required  remote 'source url' argument.\n", progName);
+    return ztMissingArg;
+  }
+
+  if((setting->startNumber && string2Sequence(&first, setting->startNumber) != ztSuccess) ||
+     (setting->endNumber && string2Sequence(&last, setting->endNumber) != ztSuccess)){
+    fprintf(stderr, "%s: Error invalid 'begin' or 'end' sequence number for verify.\n", progName);
+    return ztInvalidArg;
+  }
+
+  if(first != SEQ_NONE && last != SEQ_NONE && first > last){
+    fprintf(stderr, "%s: Error 'begin' is after 'end' for verify.\n", progName);
+    return ztInvalidArg;
+  }
+
+  result = setupFilesys(&myDir, &myFiles, setting->rootWD);
+  if(result != ztSuccess){
+    fprintf (stderr, "%s: Error failed setupFilesys() function.\n", progName);
+    return result;
+  }
+
+  string2Lower(&lowerSource, setting->source);
+  if(!lowerSource){
+    fprintf(stderr, "%s: Error failed string2Lower() function.\n", progName);
+    zapSkeleton(&myDir);
+    zapGd_files(&myFiles);
+    return ztMemoryAllocate;
+  }
+
+  prefix = setDiffersDirPrefix(&myDir, lowerSource);
+  free(lowerSource);
+
+  if(!prefix){
+    fprintf(stderr, "%s: Error failed setDiffersDirPrefix() function.\n", progName);
+    zapSkeleton(&myDir);
+    zapGd_files(&myFiles);
+    return ztInvalidArg;
+  }
+
+  /* shared lock on tree; waits while a download writes to it **/
+  snprintf(lockName, sizeof(lockName), "%s%s", prefix, LOCK_FILE);
+
+  result = lockSourceRead(&lockFD, lockName);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed lockSourceRead() for: <%s>\n", progName, lockName);
+    zapSkeleton(&myDir);
+    zapGd_files(&myFiles);
+    return result;
+  }
+
+  numThreads = numCPUs();
+
+  if(setting->verbose)
+    fprintf(stdout, "%s: Verifying <%s> with %d threads; crc32 method: %s\n",
+            progName, prefix, numThreads, crc32Method());
+
+  clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+  result = verifyTree(&report, prefix, first, last, numThreads);
+
+  clock_gettime(CLOCK_MONOTONIC, &endTime);
+
+  unlockSourceRead(lockFD);
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed verifyTree() function.\n", progName);
+    zapSkeleton(&myDir);
+    zapGd_files(&myFiles);
+    return result;
+  }
+
+  seconds = (double) (endTime.tv_sec - startTime.tv_sec) +
+            (double) (endTime.tv_nsec - startTime.tv_nsec) / 1e9;
+
+  fprintf(stdout, "%s: Verified %ld sequence numbers, %ld gzip files in %.2f seconds.\n"
+          " corrupt: %ld  orphaned: %ld  missing: %ld  unexpected: %ld\n",
+          progName, report.pairs, report.checked, seconds,
+          report.corrupt, report.orphaned, report.missing, report.unexpected);
+
+  zapSkeleton(&myDir);
+  zapGd_files(&myFiles);
+
+  if(report.corrupt || report.orphaned || report.missing)
+
+    return ztMalformedFile;
+
+  return ztSuccess;
+
+} /* END runVerifyCommand() **/
+
+/* runLookupCommand(): prints change files that changed object in
+ * 'lookupObject' using index in local change files tree for 'source'.
+ * Returns ztStringNotFound when object is not in index.
+ ***************************************************************************/
+
+int runLookupCommand(MY_SETTING *setting){
+
+  ASSERTARGS(setting && setting->lookupObject);
+
+  SKELETON         myDir;
+  GD_FILES         myFiles;
+  SEQ_NUM          *seqs = NULL;
+  size_t           count = 0, index;
+  uint64_t         key;
+  char             *lowerSource = NULL;
+  char             *prefix;
+  char             seqPath[SEQ_PATH_SIZE];
+  char             fileName[PATH_MAX];
+  char             lockName[PATH_MAX];
+  int              lockFD;
+  struct timespec  startTime, endTime;
+  double           milliSeconds;
+  int              result;
+
+  if(! setting->source){
+    fprintf (stderr, "%s: Error missing required  remote 'source url' argument.\n", progName);
+    return ztMissingArg;
+  }
+
+  if(string2IndexKey(&key, setting->lookupObject) != ztSuccess)
+    return ztInvalidArg;
+
+  result = setupFilesys(&myDir, &myFiles, setting->rootWD);
+  if(result != ztSuccess){
+    fprintf (stderr, "%s: Error failed setupFilesys() function.\n", progName);
+    return result;
+  }
+
+  string2Lower(&lowerSource, setting->source);
+  if(!lowerSource){
+    fprintf(stderr, "%s: Error failed string2Lower() function.\n", progName);
+    zapSkeleton(&myDir);
+    zapGd_files(&myFiles);
+    return ztMemoryAllocate;
+  }
+
+  prefix = setDiffersDirPrefix(&myDir, lowerSource);
+  free(lowerSource);
+
+  if(!prefix){
+    fprintf(stderr, "%s: Error failed setDiffersDirPrefix() function.\n", progName);
+    zapSkeleton(&myDir);
+    zapGd_files(&myFiles);
+    return ztInvalidArg;
+  }
+
+  /* shared lock on tree; waits while a download writes to it **/
+  snprintf(lockName, sizeof(lockName), "%s%s", prefix, LOCK_FILE);
+
+  result = lockSourceRead(&lockFD, lockName);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed lockSourceRead() for: <%s>\n", progName, lockName);
+    zapSkeleton(&myDir);
+    zapGd_files(&myFiles);
+    return result;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+  result = lookupIndex(&seqs, &count, prefix, key);
+
+  clock_gettime(CLOCK_MONOTONIC, &endTime);
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed lookupIndex() function.\n", progName);
+    unlockSourceRead(lockFD);
+    zapSkeleton(&myDir);
+    zapGd_files(&myFiles);
+    return result;
+  }
+
+  for(index = 0; index < count; index++){
+
+    sequence2Path(seqPath, seqs[index]);
+
+    /* change file may be transcoded or in pack file **/
+    snprintf(fileName, sizeof(fileName), "%s%s%s", prefix, seqPath + (SLASH_ENDING(prefix) ? 1 : 0), CHANGE_EXT);
+    if(isFileReadable(fileName) != ztSuccess)
+      snprintf(fileName, sizeof(fileName), "%s%s%s", prefix, seqPath + (SLASH_ENDING(prefix) ? 1 : 0), ZST_EXT);
+
+    if(isFileReadable(fileName) != ztSuccess &&
+       packFileName(fileName, sizeof(fileName), prefix, seqs[index]) == ztSuccess){
+      size_t  length = strlen(fileName);
+      snprintf(fileName + length, sizeof(fileName) - length, ":%s%s", seqPath + 9, CHANGE_EXT);
+    }
+
+    fprintf(stdout, "%s/%lld: %u %s\n", oscTypeName(INDEX_KEY_TYPE(key)), INDEX_KEY_ID(key), seqs[index], fileName);
+  }
+
+  unlockSourceRead(lockFD);
+
+  milliSeconds = (double) (endTime.tv_sec - startTime.tv_sec) * 1e3 +
+                 (double) (endTime.tv_nsec - startTime.tv_nsec) / 1e6;
+
+  if(setting->verbose)
+    fprintf(stdout, "%s: Found %lu change files for %s/%lld in %.2f milliseconds.\n",
+            progName, (unsigned long) count, oscTypeName(INDEX_KEY_TYPE(key)), INDEX_KEY_ID(key), milliSeconds);
+
+  free(seqs);
+  zapSkeleton(&myDir);
+  zapGd_files(&myFiles);
+
+  return count ? ztSuccess : ztStringNotFound;
+
+} /* END runLookupCommand() **/
+
+/* runExtractCommand(): writes one file for 'extractArg' sequence number to
+ * stdout; from change files tree for 'source' or its pack file. Extension
+ * defaults to change file ".osc.gz".
+ ***************************************************************************/
+
+int runExtractCommand(MY_SETTING *setting){
+
+  ASSERTARGS(setting && setting->extractArg);
+
+  SKELETON   myDir;
+  GD_FILES   myFiles;
+  SEQ_NUM    seq;
+  char       seqString[16];
+  char       *lowerSource = NULL;
+  char       *prefix;
+  const char *ext;
+  char       lockName[PATH_MAX];
+  int        lockFD;
+  size_t     digits;
+  int        result;
+
+  if(! setting->source){
+    fprintf (stderr, "%s: Error missing required  remote 'source url' argument.\n", progName);
+    return ztMissingArg;
+  }
+
+  digits = strspn(setting->extractArg, "0123456789");
+  if(digits == 0 || digits >= sizeof(seqString))
+    return ztInvalidArg;
+
+  memcpy(seqString, setting->extractArg, digits);
+  seqString[digits] = '\0';
+
+  if(string2Sequence(&seq, seqString) != ztSuccess){
+    fprintf(stderr, "%s: Error invalid sequence number for extract: <%s>\n", progName, seqString);
+    return ztInvalidArg;
+  }
+
+  ext = setting->extractArg[digits] ? setting->extractArg + digits : CHANGE_EXT;
+
+  result = setupFilesys(&myDir, &myFiles, setting->rootWD);
+  if(result != ztSuccess){
+    fprintf (stderr, "%s: Error failed setupFilesys() function.\n", progName);
+    return result;
+  }
+
+  string2Lower(&lowerSource, setting->source);
+  if(!lowerSource){
+    fprintf(stderr, "%s: Error failed string2Lower() function.\n", progName);
+    zapSkeleton(&myDir);
+    zapGd_files(&myFiles);
+    return ztMemoryAllocate;
+  }
+
+  prefix = setDiffersDirPrefix(&myDir, lowerSource);
+  free(lowerSource);
+
+  if(!prefix){
+    fprintf(stderr, "%s: Error failed setDiffersDirPrefix() function.\n", progName);
+    zapSkeleton(&myDir);
+    zapGd_files(&myFiles);
+    return ztInvalidArg;
+  }
+
+  /* shared lock on tree; waits while a download writes to it **/
+  snprintf(lockName, sizeof(lockName), "%s%s", prefix, LOCK_FILE);
+
+  result = lockSourceRead(&lockFD, lockName);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed lockSourceRead() for: <%s>\n", progName, lockName);
+    zapSkeleton(&myDir);
+    zapGd_files(&myFiles);
+    return result;
+  }
+
+  result = extractMember(prefix, seq, ext, extractFD);
+
+  unlockSourceRead(lockFD);
+
+  if(result == ztFileNotFound)
+    fprintf(stderr, "%s: Error file for sequence <%u> with extension <%s> not found in tree or pack.\n",
+            progName, seq, ext);
+  else if(result != ztSuccess)
+    fprintf(stderr, "%s: Error failed extractMember() function.\n", progName);
+
+  close(extractFD);
+  extractFD = -1;
+
+  zapSkeleton(&myDir);
+  zapGd_files(&myFiles);
+
+  return result;
+
+} /* END runExtractCommand() **/
+
+/* runServeCommand(): serves change files trees in work directory as local
+ * replication mirror; see serve.h. Planet trees are always mounted, the
+ * geofabrik tree under server and path of 'source' when it is geofabrik.
+ * Runs until SIGINT or SIGTERM.
+ ***************************************************************************/
+
+int runServeCommand(MY_SETTING *setting){
+
+  ASSERTARGS(setting && setting->serveArg);
+
+  SKELETON      myDir;
+  GD_FILES      myFiles;
+  SERVE_MOUNT   mounts[SERVE_MAX_MOUNTS];
+  SERVE_REPORT  report;
+  char          address[INET_ADDRSTRLEN];
+  char          geofabrikPath[PATH_MAX];
+  char          *lowerSource = NULL;
+  char          *start, *slash;
+  int           isMirror;
+  int           numMounts = 0;
+  int           numThreads;
+  int           port;
+  int           result;
+
+  result = parseServeAddress(address, sizeof(address), &port, setting->serveArg);
+  if(result != ztSuccess)
+    return result;
+
+  result = setupFilesys(&myDir, &myFiles, setting->rootWD);
+  if(result != ztSuccess){
+    fprintf (stderr, "%s: Error failed setupFilesys() function.\n", progName);
+    return result;
+  }
+
+  mounts[numMounts].urlPath = "/planet.openstreetmap.org/replication/minute/";
+  mounts[numMounts++].treeDir = myDir.planetMin;
+
+  mounts[numMounts].urlPath = "/planet.openstreetmap.org/replication/hour/";
+  mounts[numMounts++].treeDir = myDir.planetHour;
+
+  mounts[numMounts].urlPath = "/planet.openstreetmap.org/replication/day/";
+  mounts[numMounts++].treeDir = myDir.planetDay;
+
+  if(setting->source)
+    string2Lower(&lowerSource, setting->source);
+
+  if(lowerSource && strstr(lowerSource, "geofabrik")){
+
+    /* drop scheme; and mirror server when we serve from a mirror **/
+    start = strstr(lowerSource, "://");
+    start = start ? start + 3 : lowerSource;
+
+    slash = strchr(start, '/');
+    if(slash){
+      *slash = '\0';
+      isMirror = (strstr(start, "geofabrik") == NULL);
+      *slash = '/';
+      if(isMirror)
+        start = slash + 1;
+    }
+
+    snprintf(geofabrikPath, sizeof(geofabrikPath), "/%s%s", start, SLASH_ENDING(start) ? "" : "/");
+
+    mounts[numMounts].urlPath = geofabrikPath;
+    mounts[numMounts++].treeDir = myDir.geofabrik;
+  }
+
+  if(lowerSource)
+    free(lowerSource);
+
+  numThreads = numCPUs() * 4;
+  if(numThreads > MAX_WORKERS)
+    numThreads = MAX_WORKERS;
+
+  result = runServer(&report, address, port, mounts, numMounts, numThreads, setting->verbose);
+
+  if(result != ztSuccess)
+    fprintf(stderr, "%s: Error failed runServer() function.\n", progName);
+
+  fprintf(stdout, "%s: Served %ld connections, %ld requests; %ld files, %lld bytes; not found: %ld\n",
+          progName, report.connections, report.requests, report.files, report.bytes, report.notFound);
+
+  zapSkeleton(&myDir);
+  zapGd_files(&myFiles);
+
+  return result;
+
+} /* END runServeCommand() **/
+
+/* isSameSequenceString(): compares as integers; FALSE if either is not good **/
+
+int isSameSequenceString(const char *first, const char *second){
+
+  SEQ_NUM  firstSeq, secondSeq;
+
+  ASSERTARGS(first && second);
+
+  if((string2Sequence(&firstSeq, first) != ztSuccess) ||
+     (string2Sequence(&secondSeq, second) != ztSuccess))
+
+    return FALSE;
+
+  return (firstSeq == secondSeq);
+
+} /* END isSameSequenceString() **/
+
+/* myDownload():
+ * appends 'remotePathSuffix' to current 'pathPrefix' in curl parse handle.
+ * 'remotePathSuffix' is the path part from the sequence number, might include
+ * change file name and state.txt file name.
+ *
+ * originalPath is restored before exit (return).
+ *
+ ******************************************************************************/
+
+int myDownload(char *remotePathSuffix, char *localFile){
+
+  ASSERTARGS(remotePathSuffix && localFile);
+
+  return fetchRemote(remotePathSuffix, localFile, NULL, ! strstr(remotePathSuffix, CHANGE_EXT));
+
+} /* END myDownload() **/
+
+/* myDownload2Memory(): as myDownload() but file is kept in 'dst' memory **/
+
+static int myDownload2Memory(char *remotePathSuffix, MEMORY_STRUCT *dst){
+
+  ASSERTARGS(remotePathSuffix && dst);
+
+  return fetchRemote(remotePathSuffix, NULL, dst, ! strstr(remotePathSuffix, CHANGE_EXT));
+
+} /* END myDownload2Memory() **/
+
+/* fetchRemote(): work horse for myDownload() and myDownload2Memory();
+ * exactly one of 'localFile' or 'dst' is set. 'isMeta' is set for all but
+ * change files; those go to public server with --public-meta.
+ *
+ ******************************************************************************/
+
+static int fetchRemote(char *remotePathSuffix, char *localFile, MEMORY_STRUCT *dst, int isMeta){
+
+  int   result;
+
+  CURLUcode   curluResult; /* returned type by curl_url_get() & curl_url_set() **/
+  char        *originalPath;
+  char        newPath[PATH_MAX] = {0};
+
+  char        *currentSourceURL;
+  char        *newToken;
+
+  CURL        *handle = downloadHandle;
+  CURLU       *parseHandle = curlParseHandle;
+  char        *handleURL = sourceURL;
+
+  ASSERTARGS(remotePathSuffix && (localFile || dst));
+
+  result = localFile ? isGoodFilename(localFile) : ztSuccess;
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed isGoodFilename() for 'localFile' parameter in myDownload(): <%s>.\n",
+            progName, localFile);
+    return result;
+  }
+
+  if(isLocalSourceOn())
+
+    return localFetch(remotePathSuffix, localFile, dst);
+
+  if(isMeta && metaHandle){
+    handle = metaHandle;
+    parseHandle = metaParseHandle;
+    handleURL = metaSourceURL;
+  }
+  else if(loginSetting){
+
+    result = pendingLogin();
+    if(result != ztSuccess)
+
+      return result;
+  }
+
+  /* cookie renewed in background; use it from this transfer on **/
+  if(cookieTokenChanged(&newToken)){
+
+    if(curl_easy_setopt(downloadHandle, CURLOPT_COOKIE, newToken) == CURLE_OK)
+      logMessage(fLogPtr, "Using renewed cookie for internal server.");
+
+    free(newToken);
+  }
+
+  /* ensure that parse handle is intact
+   * currentSourceURL is NEVER NULL; it can be empty string **/
+  currentSourceURL = getUrlStringCURLU(parseHandle);
+
+  if(strcmp(handleURL, currentSourceURL) != 0){
+    fprintf(stderr, "%s: Error fatal NOT same strings in sourceURL: <%s> and currentSourceURL: <%s>.\n",
+            progName, handleURL, currentSourceURL);
+    return ztFatalError;
+  }
+
+  /* append remote path suffix to current path in parse handle **/
+  if(remotePathSuffix){
+
+    char   *allowed = "0123456789.acegostxz\057"; /* 057 octal for forward slash, letters
+                                                     are from: state.txt & .osc.gz **/
+
+    if(strspn(remotePathSuffix, allowed) != strlen(remotePathSuffix)){
+      fprintf(stderr, "%s: Error 'remotePathSuffix' parameter has disallowed character.\n", progName);
+      return ztInvalidArg;
+    }
+
+    curluResult = curl_url_get(parseHandle, CURLUPART_PATH, &originalPath, 0);
+    if(curluResult != CURLUE_OK ) {
+      fprintf(stderr, "%s: Error failed curl_url_get() for path part.\n"
+              "Curl error message: <%s>\n", progName,
+              curl_url_strerror(curluResult));
+      return ztFailedLibCall;
+    }
+
+    /* use ONLY ONE slash between parts **/
+
+    if(remotePathSuffix[0] == '\057')
+
+      remotePathSuffix++;
+
+    if(SLASH_ENDING(originalPath))
+      sprintf(newPath, "%s%s", originalPath, remotePathSuffix);
+    else
+      sprintf(newPath, "%s/%s", originalPath, remotePathSuffix);
+
+
+    curluResult = curl_url_set (parseHandle, CURLUPART_PATH, newPath, 0);
+    if(curluResult != CURLUE_OK){
+      fprintf(stderr, "%s: Error failed curl_url_set() for new path.\n", progName);
+      return ztFailedLibCall;
+    }
+  }
+
+  if(localFile)
+    result = download2FileRetry(localFile, handle, parseHandle);
+  else
+    result = download2MemoryRetry(dst, handle, parseHandle);
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed to download file: <%s>.\n"
+            " Function failed for: <%s>\n",progName, localFile ? localFile : remotePathSuffix, ztCode2Msg(result));
+
+    if(result == ztNetConnFailed){
+      fprintf(stderr, "download failed for lost established connection; check cables please.\n");
+      logMessageLevel(fLogPtr, LOG_ERROR, "download failed for lost established connection; check cables please.");
+    }
+
+    /* restore originalPath **/
+    curluResult = curl_url_set (parseHandle, CURLUPART_PATH, originalPath, 0);
+    if(curluResult != CURLUE_OK ) {
       fprintf(stderr, "%s: Error failed curl_url_set() for path part.\n"
               "Curl error message: <%s>\n", progName, curl_url_strerror(curluResult));
 
-      //return ztFailedLibCall;
-    }
+      //return ztFailedLibCall;
+    }
+
+    return result;
+  }
+
+  /* restore originalPath before return **/
+  curluResult = curl_url_set (parseHandle, CURLUPART_PATH, originalPath, 0);
+  if(curluResult != CURLUE_OK ) {
+    fprintf(stderr, "%s: Error failed curl_url_set() for path part.\n"
+            "Curl error message: <%s>\n", progName, curl_url_strerror(curluResult));
+
+    return ztFailedLibCall;
+  }
+
+  return ztSuccess;
+
+} /* END fetchRemote() **/
+
+/* initialMetaHandles(): parse and download handles for public server
+ * with same 'path' as internal source; no cookie.
+ *
+ ******************************************************************************/
+
+static int initialMetaHandles(char *path){
+
+  ASSERTARGS(path);
+
+  metaSourceURL = (char *) malloc(strlen("https://" PUBLIC_SERVER) + strlen(path) + 1);
+  if(!metaSourceURL)
+    return ztMemoryAllocate;
+
+  sprintf(metaSourceURL, "https://%s%s", PUBLIC_SERVER, path);
+
+  metaParseHandle = initialURL(metaSourceURL);
+  if(!metaParseHandle)
+    return ztFailedLibCall;
+
+  /* keep it as curl writes it; compared in fetchRemote() **/
+  free(metaSourceURL);
+  metaSourceURL = getUrlStringCURLU(metaParseHandle);
+  if(strlen(metaSourceURL) == 0){
+    metaSourceURL = NULL;
+    return ztFailedLibCall;
+  }
+
+  metaHandle = initialOperation(metaParseHandle, NULL);
+  if(!metaHandle)
+    return ztFailedLibCall;
+
+  return ztSuccess;
+
+} /* END initialMetaHandles() **/
+
+/* pendingLogin(): login left from main() with --public-meta; first change
+ * file from internal server sets cookie in 'downloadHandle'.
+ *
+ ******************************************************************************/
+
+static int pendingLogin(void){
+
+  char  *token;
+
+  logMessage(fLogPtr, "First change file from internal server, calling getLoginToken() function...");
+
+  token = getLoginToken(loginSetting, loginDir);
+  if(!token){
+    fprintf(stderr, "%s: Error failed getLoginToken() function.\n", progName);
+    logMessage(fLogPtr, "Error failed getLoginToken() function.");
+
+    return ztNoCookieToken;
+  }
+
+  loginSetting = NULL;
+  loginDir = NULL;
+
+  if(curl_easy_setopt(downloadHandle, CURLOPT_COOKIE, token) != CURLE_OK){
+    free(token);
+    fprintf(stderr, "%s: Error failed curl_easy_setopt() for CURLOPT_COOKIE.\n", progName);
+    logMessage(fLogPtr, "Error failed curl_easy_setopt() for CURLOPT_COOKIE.");
+
+    return ztFailedLibCall;
+  }
+
+  free(token);
+
+  return ztSuccess;
+
+} /* END pendingLogin() **/
+
+char *fetchLatestSequence(char *remoteName, char *localDest){
+
+  ASSERTARGS(remoteName && localDest);
+
+  int result;
+  char *latestSequence = NULL;
+
+  if(fVerbose){
+    fprintf(stdout, "fetchLatestSequence(): Downloading latest \"state.txt\" file from remote server.\n");
+    logMessageLevel(fLogPtr, LOG_DEBUG, "fetchLatestSequence(): Downloading latest \"state.txt\" file from remote server.");
+  }
+
+  result = myDownload(remoteName, localDest);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed myDownload() in fetchLatestSequence().\n", progName);
+    logMessage(fLogPtr, "Error failed myDownload() in fetchLatestSequence().");
+
+    return latestSequence;
+  }
+
+  if(fVerbose){
+    fprintf(stdout, "fetchLatestSequence(): Wrote latest \"state.txt\" to local file: <%s>.\n", localDest);
+    logMessageLevel(fLogPtr, LOG_DEBUG, "fetchLatestSequence(): Wrote latest \"state.txt\" to local file below:");
+    logMessageLevel(fLogPtr, LOG_DEBUG, localDest);
+  }
+
+  latestSequence = stateFile2SequenceString(localDest);
+
+  if(! latestSequence ){
+    fprintf(stderr, "%s: fetchLatestSequence(): Error failed to get 'latestSequence'.\n"
+    		"   stateFile2SequenceString(localDest) failed in fetchLatestSequence() function.\n", progName);
+    logMessageLevel(fLogPtr, LOG_ERROR, "fetchLatestSequence(): Error failed stateFile2SequenceString(localDest) to set latestSequence");
+    return latestSequence;
+  }
+
+  if(fVerbose){
+    fprintf(stdout, "fetchLatestSequence(): Extracted latest SEQUENCE NUMBER from remote server: <%s>\n", latestSequence);
+    logMessageLevel(fLogPtr, LOG_DEBUG, "fetchLatestSequence(): Extracted latest SEQUENCE NUMBER from remote server below:");
+    logMessageLevel(fLogPtr, LOG_DEBUG, latestSequence);
+  }
+
+  return latestSequence;
+
+} /* fetchLatestSequence() **/
+
+/* areNumsGoodPair(): are numbers good pair?
+ *
+ *  FIXME fix comments and feed back msgs FIXME
+ *  - numbers are already good sequence numbers; checked at getSettings().
+ *  - numbers are compared as integers; SEQ_NUM from sequence.h.
+ *  - we assume that minute, hour and day granularities all have different sequence
+ *    numbers grouped as follows:
+ *    * minute sequence numbers are 7 digits such as: 6321780
+ *    * hour sequence numbers are 6 digits such as: 106276
+ *    * day sequence numbers are 4 digits such as: 4428
+ *
+ * 1- end & start must share root entry; must be from the same granularity.
+ *    must share root entry also because we do NOT fetch thousands of files.
+ * 2- if they do not share 'parentEntry'; then parents must be adjacent entries.
+ * 3- files (change file + state.txt file) for both start and end sequence
+ *    numbers must exist on remote server; we only check for state.txt file
+ *    for both and assume corresponding change file has the same status.
+ * 4- end time stamp must be newer than start time stamp.
+ *
+ *****************************************/
+
+int areNumsGoodPair(const char *startNum, const char *endNum){
+
+  ASSERTARGS(startNum && endNum);
+
+  int result;
+  PATH_PART startPP, endPP;
+
+  result = sequence2PathPart(&startPP, startNum);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed sequence2PathPart() function.\n", progName);
+    logMessage(fLogPtr, "Error failed sequence2PathPart() function.");
+
+    return result;
+  }
+
+  result = sequence2PathPart(&endPP, endNum);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed sequence2PathPart() function.\n", progName);
+    logMessage(fLogPtr, "Error failed sequence2PathPart() function.");
+
+    return result;
+  }
+
+  if(endPP.seqNum < startPP.seqNum){
+    fprintf(stderr, "%s: Error end sequence number is smaller than start sequence number!\n"
+            "End number must be the newer (larger) sequence number.\n"
+            "Sequence numbers must be of the same GRANULARITY (minutely, hourly or daily) and no more than %d change files apart.\n",
+            progName, MAX_OSC_DOWNLOAD);
+    logMessage(fLogPtr, "Error end sequence number is smaller than start sequence number!\n"
+               "End number must be the newer (larger) sequence number.\n"
+               "Sequence numbers must be of the same GRANULARITY (minutely, hourly or daily) and no more than 61 change files apart.");
+
+    return ztInvalidArg;
+  }
+
+  if(fVerbose){
+    fprintf(stdout, "start PATH_PART is below:\n");
+    fprintPathPart(NULL, &startPP);
+
+    printf("end PATH_PART is below:\n");
+    fprintPathPart(NULL, &endPP);
+  }
+
+  if(! areSameRoot(startPP.seqNum, endPP.seqNum)){
+
+    fprintf(stderr, "%s: Error; start and end sequence numbers do not share root entry.\n", progName);
+    logMessage(fLogPtr, "Error; sequence numbers (both) must of the same granularity.");
+
+    return ztInvalidArg;
+  }
+
+  if(SEQ_PARENT_KEY(startPP.seqNum) != SEQ_PARENT_KEY(endPP.seqNum)){
+
+    /* integer check; no need to fetch root listing to find adjacent parents **/
+    if(! areAdjacentParents(startPP.seqNum, endPP.seqNum) ){
+      fprintf(stderr, "%s: Error; start & end sequence numbers are NOT from adjacent directories!\n"
+              " start parent directory is: %s\n"
+              " end parent directory is: %s\n"
+              " Sequence numbers must be from same GRANULARITY with begin being the older of\n"
+              " the two and no more than %d change files can be downloaded each invocation.\n\n",
+              progName, startPP.parentPath, endPP.parentPath, MAX_OSC_DOWNLOAD);
+      logMessage(fLogPtr, "Error; start & end sequence numbers are NOT from adjacent directories!");
+
+      return ztInvalidArg;
+    }
+  } /* end if not same parent **/
+
+  /* check if files exist on remote server **/
+  char fileSuffix[PATH_MAX] = {0};
+
+  sprintf(fileSuffix, "%s%s", startPP.filePath, STATE_EXT);
+
+  printf("calling isRemote() with fileSuffix = %s\n", fileSuffix);
+
+  result = isRemoteFile(fileSuffix);
+  if(result == ztFileNotFound){
+    fprintf(stderr, "%s: Error, change file for start sequence number is not available.\n"
+            "Please check server site for available files.\n\n", progName);
+    logMessage(fLogPtr, "Error, change file for start sequence number is not available.\n"
+               "Please check server site for available files.\n");
+
+    return ztFileNotFound;
+  }
+  else if(result != ztSuccess){
+    fprintf(stderr, "%s: Error, failed isRemoteFile() function for start sequence number.\n"
+            " You may retry later but function failed for: <%s>.\n\n",
+            progName, ztCode2ErrorStr(result));
+    logMessage(fLogPtr, "Error, failed isRemoteFile() function for start sequence number.\n"
+               " You may retry later but function failed for: -- see below --");
+    logMessageLevel(fLogPtr, LOG_ERROR, ztCode2ErrorStr(result));
+
+    return result;;
+  }
+  else{ /* result == ztSuccess **/
+    if(fVerbose){
+      fprintf(stdout, "%s: Change file for start sequence number is available from remote.\n", progName);
+      logMessageLevel(fLogPtr, LOG_DEBUG, "Change file for start sequence number is available from remote.");
+    }
+  }
+
+  /* is file for end sequence available? **/
+  sprintf(fileSuffix, "%s%s", endPP.filePath, STATE_EXT);
+
+  result = isRemoteFile(fileSuffix);
+  if(result == ztFileNotFound){
+    fprintf(stderr, "%s: Error, change file for end sequence number is not available.\n"
+            "Please check server site for available files.\n\n", progName);
+    logMessage(fLogPtr, "Error, change file for end sequence number is not available.\n"
+               "Please check server site for available files.\n");
+
+    return ztFileNotFound;
+  }
+  else if(result != ztSuccess){
+    fprintf(stderr, "%s: Error, failed isRemoteFile() function for end sequence number.\n"
+            " You may retry later but function failed for: <%s>.\n\n",
+            progName, ztCode2ErrorStr(result));
+    logMessage(fLogPtr, "Error, failed isRemoteFile() function for end sequence number.\n"
+               " You may retry later but function failed for: -- see below --");
+    logMessageLevel(fLogPtr, LOG_ERROR, ztCode2ErrorStr(result));
+
+    return result;
+  }
+  else{ /* result == ztSuccess **/
+    if(fVerbose){
+      fprintf(stdout, "%s: Change file for end sequence number is available from remote.\n", progName);
+      logMessageLevel(fLogPtr, LOG_DEBUG, "Change file for end sequence number is available from remote.");
+    }
+  }
+
+  /* allow single change file download **/
+  if(startPP.seqNum == endPP.seqNum) return ztSuccess;
+
+  /* unless endSeq == startSeq 'end' must be newer than 'start' -
+   * compare time stamps from state.txt files **/
+
+  result = isEndNewer(&startPP, &endPP);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error 'end' does not have more recent time stamp than 'start'.\n", progName);
+    logMessage(fLogPtr, "Error 'end' does not have more recent time stamp than 'start'.");
+
+    return result;
+  }
+
+  return ztSuccess;
+
+} /* END areNumsGoodPair() **/
+
+/* isRemoteFile2(): is file available - exist - on remote server?
+ *
+ * - function tries to retrieve 'header' ONLY for file from remote server
+ * - if 'header' was NOT found, then file does NOT exist on remote
+ * - 'header' is saved to tmpDir with appended ".Header" to filename.
+ *
+ * Caller should check returns for any error.
+ *
+ ******************************************************************/
+
+int isRemoteFile(char *remoteSuffix){
+
+  char *toDir = (char *) tmpDir; // set to global tmpDir
+
+  ASSERTARGS(remoteSuffix && toDir);
+
+  int  result;
+
+  /* this function uses myDownload() to get header for file from remote:
+     prototype: int myDownload(char *remotePathSuffix, char *localFile)
+     first argument is our argument here 'remoteSuffix' we make string
+     for the second argument, saving header to 'tmpDir'.
+
+     Another approach is to partially retrieve first chunk bytes (say 1024) to
+     memory; not to file, then compare to (look for) some hint string.
+  *********************************************************************/
+
+  char localFile[PATH_MAX] = {0};
+
+  /* no header for local source; file is there or not **/
+  if(isLocalSourceOn())
+
+    return isLocalFile(remoteSuffix);
+
+  if(SLASH_ENDING(toDir))
+    sprintf(localFile, "%s%s.Header", toDir, lastOfPath(remoteSuffix));
+  else
+    sprintf(localFile, "%s/%s.Header", toDir, lastOfPath(remoteSuffix));
+
+  /* set 2 options in global 'downloadHandle' - or 'metaHandle' with
+   * --public-meta: CURLOPT_NOBODY & CURLOPT_HEADER **/
+
+  CURLcode curlCode;
+  CURL     *handle = metaHandle ? metaHandle : downloadHandle;
+
+  curlCode = curl_easy_setopt(handle, CURLOPT_NOBODY, 1L);
+  if (curlCode != CURLE_OK){
+    fprintf(stderr, "%s: Error failed curl_easy_setopt() for CURLOP_NOBODY.\n", progName);
+    logMessage(fLogPtr, "Error failed curl_easy_setopt() for CURLOP_NOBODY.");
+
+    return ztFailedLibCall;
+  }
+
+  curlCode = curl_easy_setopt(handle, CURLOPT_HEADER, 1L);
+  if (curlCode != CURLE_OK){
+    fprintf(stderr, "%s: Error failed curl_easy_setopt() for CURLOP_HEADER.\n", progName);
+    logMessage(fLogPtr, "Error failed curl_easy_setopt() for CURLOP_HEADER.");
+
+    return ztFailedLibCall;
+  }
+
+  result = fetchRemote(remoteSuffix, localFile, NULL, 1);
+
+  /* restore 2 options to defaults **/
+  curlCode = curl_easy_setopt(handle, CURLOPT_NOBODY, 0L);
+  if (curlCode != CURLE_OK){
+    fprintf(stderr, "%s: Error failed curl_easy_setopt() for CURLOP_NOBODY (unset).\n", progName);
+    logMessage(fLogPtr, "Error failed curl_easy_setopt() for CURLOP_NOBODY (unset).");
+
+    return ztFailedLibCall;
+  }
+
+  result = curl_easy_setopt(handle, CURLOPT_HEADER, 0L);
+  if (curlCode != CURLE_OK){
+    fprintf(stderr, "getRemoteHeader(): Error failed curl_easy_setopt() for CURLOP_HEADER (restore).\n");
+    logMessageLevel(fLogPtr, LOG_ERROR, "getRemoteHeader(): Error failed curl_easy_setopt() for CURLOP_HEADER (restore).");
+
+    return ztFailedLibCall;
+  }
+
+#ifdef REMOVE_TMP
+  removeFile(localFile);
+#endif
+
+  if(result == ztResponse404)
+
+    return ztFileNotFound;
+
+  else if(result == ztResponse200)
+
+    return ztSuccess;
+
+  return result;
+
+} /* END isRemoteFile2() **/
+
+/* isEndNewer(): returns ztSuccess when 'end' has a newer
+ *               or more recent time stamp than that of 'start'.
+ *
+ ***************************************************************/
+
+int isEndNewer(PATH_PART *startPP, PATH_PART *endPP){
+
+  char *toDir = (char *) tmpDir; // must be set upstream
+
+  ASSERTARGS(startPP && endPP && toDir);
+
+  int result;
+
+  /* get state.txt files for both, to compare their age. **/
+  char remoteSuffix[128] = {0};
+  char startLocalFile[PATH_MAX] = {0};
+  char endLocalFile[PATH_MAX] = {0};
+
+  STATE_INFO *startStateInfo, *endStateInfo;
+
+  /* initial state infos **/
+  startStateInfo = initialStateInfo();
+  if(!startStateInfo){
+    fprintf(stderr, "%s: Error failed initialStateInfo() call for start number.\n", progName);
+    logMessage(fLogPtr, "Error failed initialStateInfo() call for start number.");
+
+    return ztMemoryAllocate;
+  }
+
+  endStateInfo = initialStateInfo();
+  if(!endStateInfo){
+    fprintf(stderr, "%s: Error failed initialStateInfo() call for end number.\n", progName);
+    logMessage(fLogPtr, "Error failed initialStateInfo() call for end number.");
+
+    return ztMemoryAllocate;
+  }
+
+  sprintf(remoteSuffix, "%s%s", startPP->filePath, STATE_EXT);
+
+  if(SLASH_ENDING(toDir))
+    sprintf(startLocalFile, "%s%s%s", toDir, startPP->fileEntry, STATE_EXT);
+  else
+    sprintf(startLocalFile, "%s/%s%s", toDir, startPP->fileEntry, STATE_EXT);
+
+  /* download start state.txt file **/
+  result = myDownload(remoteSuffix, startLocalFile);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed myDownload() function for start state.txt file.\n", progName);
+    logMessage(fLogPtr, "Error failed myDownload() function for start state.txt file.");
+
+    return result;
+  }
+
+  sprintf(remoteSuffix, "%s%s", endPP->filePath, STATE_EXT);
+
+  if(SLASH_ENDING(toDir))
+    sprintf(endLocalFile, "%s%s%s", toDir, endPP->fileEntry, STATE_EXT);
+  else
+    sprintf(endLocalFile, "%s/%s%s", toDir, endPP->fileEntry, STATE_EXT);
+
+  /* download end state.txt file **/
+  result = myDownload(remoteSuffix, endLocalFile);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed myDownload() function for end state.txt file.\n", progName);
+    logMessage(fLogPtr, "Error failed myDownload() function for end state.txt file.");
+
+    return result;
+  }
+
+  /* parse state.txt files (start & end) into STATE_INFOs **/
+  result = stateFile2StateInfo(startStateInfo, startLocalFile);
+
+#ifdef REMOVE_TMP
+  removeFile(startLocalFile);
+  if(result != ztSuccess)
+	removeFile(endLocalFile);
+#endif
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed stateFile2StateInfo() function for start state.txt file.\n", progName);
+    logMessage(fLogPtr, "Error failed stateFile2StateInfo() function for start state.txt file.");
 
     return result;
   }
 
-  /* restore originalPath before return **/
-  curluResult = curl_url_set (curlParseHandle, CURLUPART_PATH, originalPath, 0);
-  if(curluResult != CURLUE_OK ) {
-    fprintf(stderr, "%s: Error failed curl_url_set() for path part.\n"
-            "Curl error message: <%s>\n", progName, curl_url_strerror(curluResult));
+  result = stateFile2StateInfo(endStateInfo, endLocalFile);
 
-    return ztFailedLibCall;
+#ifdef REMOVE_TMP
+  removeFile(endLocalFile);
+#endif
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed stateFile2StateInfo() function for end state.txt file.\n", progName);
+    logMessage(fLogPtr, "Error failed stateFile2StateInfo() function for end state.txt file.");
+
+    return result;
+  }
+
+  /*
+    fprintf(stdout, "printing STATE_INFO for START below:\n");
+    fprintStateInfo2(stdout, startStateInfo);
+
+    fprintf(stdout, "printing STATE_INFO for END below:\n");
+    fprintStateInfo2(stdout, endStateInfo);
+  **/
+
+  if(endStateInfo->timeValue < startStateInfo->timeValue){
+    fprintf(stderr, "%s: Error end change file is not newer than start change file.\n", progName);
+    logMessage(fLogPtr,"Error end change file is not newer than start change file.");
+
+    return ztInvalidArg;
   }
 
   return ztSuccess;
 
-} /* END myDownload() **/
+} /* END isEndNewer() **/
 
-char *fetchLatestSequence(char *remoteName, char *localDest){
+int getDiffersList(STRING_LIST *destList, PATH_PART *startPP, PATH_PART *endPP){
 
-  ASSERTARGS(remoteName && localDest);
+  ASSERTARGS(destList && startPP && endPP);
+
+  ASSERTARGS(startPP->parentPath && startPP->fileEntry); // needed: is filled out structure?
+  ASSERTARGS(endPP->parentPath && endPP->fileEntry);
+
+  if(DL_SIZE(destList)){
+    fprintf(stderr, "%s: Error destList is not empty.\n", progName);
+    logMessage(fLogPtr, "Error destList is not empty.");
+    return ztListNotEmpty;
+  }
 
   int result;
-  char *latestSequence = NULL;
+  STRING_LIST *parentsList;
+  STRING_LIST *childrenList;
 
-  if(fVerbose){
-    fprintf(stdout, "fetchLatestSequence(): Downloading latest \"state.txt\" file from remote server.\n");
-    logMessage(fLogPtr, "fetchLatestSequence(): Downloading latest \"state.txt\" file from remote server.");
+  char *newPath;
+
+  /* fill parentList: list of Parent Page(s) from startSequenceNum & endSequenceNum
+   * there will be one page when start & end share parent or two when they do not
+   *******************************************************************************/
+  parentsList = initialStringList();
+  if(!parentsList){
+    fprintf(stderr, "%s: Error failed initialStringList().\n", progName);
+    logMessage(fLogPtr, "Error failed initialStringList().");
+
+    return ztMemoryAllocate;
   }
 
-  result = myDownload(remoteName, localDest);
+  newPath = STRDUP(startPP->parentPath);
+
+  /* insert start 'parentPath' as FIRST element.
+   * ALWAYS use dynamically allocated memory for data pointer in ELEM. **/
+
+  result = insertNextDL(parentsList, DL_TAIL(parentsList), (void *) newPath);
   if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed myDownload() in fetchLatestSequence().\n", progName);
-    logMessage(fLogPtr, "Error failed myDownload() in fetchLatestSequence().");
+    fprintf(stderr, "%s: Error failed insertNextTo() function.\n", progName);
+    logMessage(fLogPtr, "Error failed insertNextTo() function.");
 
-    return latestSequence;
+    return result;
   }
 
-  if(fVerbose){
-    fprintf(stdout, "fetchLatestSequence(): Wrote latest \"state.txt\" to local file: <%s>.\n", localDest);
-    logMessage(fLogPtr, "fetchLatestSequence(): Wrote latest \"state.txt\" to local file below:");
-    logMessage(fLogPtr, localDest);
-  }
+  /* if they do NOT share parent entry, add end parentPath to list as SECOND element. **/
+  if(strcmp(startPP->parentPath, endPP->parentPath) != 0){
 
-  latestSequence = stateFile2SequenceString(localDest);
+    newPath = STRDUP(endPP->parentPath);
 
-  if(! latestSequence ){
-    fprintf(stderr, "%s: fetchLatestSequence(): Error failed to get 'latestSequence'.\n"
-    		"   stateFile2SequenceString(localDest) failed in fetchLatestSequence() function.\n", progName);
-    logMessage(fLogPtr, "fetchLatestSequence(): Error failed stateFile2SequenceString(localDest) to set latestSequence");
-    return latestSequence;
-  }
+    result = insertNextDL(parentsList, DL_TAIL(parentsList), (void *) newPath);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed insertNextTo() function.\n", progName);
+      logMessage(fLogPtr, "Error failed insertNextTo() function.");
 
-  if(fVerbose){
-    fprintf(stdout, "fetchLatestSequence(): Extracted latest SEQUENCE NUMBER from remote server: <%s>\n", latestSequence);
-    logMessage(fLogPtr, "fetchLatestSequence(): Extracted latest SEQUENCE NUMBER from remote server below:");
-    logMessage(fLogPtr, latestSequence);
+      return result;
+    }
   }
 
-  return latestSequence;
+  ELEM *parentElem;
+  char *currentParent;
 
-} /* fetchLatestSequence() **/
+  ELEM *startElem;
+  ELEM *endElem;
+  ELEM *diffElem;
 
-/* areNumsGoodPair(): are numbers good pair?
- *
- *  FIXME fix comments and feed back msgs FIXME
- *  - numbers are already good sequence numbers; checked at getSettings().
- *  - we avoid changing strings to integers.
- *  - we assume that minute, hour and day granularities all have different sequence
- *    numbers grouped as follows:
- *    * minute sequence numbers are 7 digits such as: 6321780
- *    * hour sequence numbers are 6 digits such as: 106276
- *    * day sequence numbers are 4 digits such as: 4428
- *
- * 1- end & start must share root entry; must be from the same granularity.
- *    must share root entry also because we do NOT fetch thousands of files.
- * 2- if they do not share 'parentEntry'; then parents must be adjacent entries.
- * 3- files (change file + state.txt file) for both start and end sequence
- *    numbers must exist on remote server; we only check for state.txt file
- *    for both and assume corresponding change file has the same status.
- * 4- end time stamp must be newer than start time stamp.
- *
- *****************************************/
+  char *filename;
+  char buffer[64] = {0};
+  char *newDiff;
 
-int areNumsGoodPair(const char *startNum, const char *endNum){
+  parentElem = DL_HEAD(parentsList);
 
-  ASSERTARGS(startNum && endNum);
+  while(parentElem){
 
-  if(strlen(endNum) != strlen(startNum)){
-    if(strlen(endNum) > (strlen(startNum) + 1)){
+    currentParent = (char *) DL_DATA(parentElem);
 
-      fprintf(stderr, "%s: Error end sequence number is much larger than start sequence number - has more digits.\n"
-              "Sequence numbers must be of the same GRANULARITY (minutely, hourly or daily) and no more than %d change files apart.\n",
-              progName, MAX_OSC_DOWNLOAD);
-      logMessage(fLogPtr, "Error end sequence number is much larger than start sequence number - has more digits.\n"
-                 "Sequence numbers must be of the same GRANULARITY (minutely, hourly or daily) and no more than 61 change files apart.");
+    childrenList = initialStringList();
+    if(!childrenList){
+      fprintf(stderr, "%s: Error failed initialStringList().\n", progName);
+      logMessage(fLogPtr, "Error failed initialStringList().");
 
-      return ztInvalidArg;
+      return ztMemoryAllocate;
     }
-    else if(strlen(endNum) < strlen(startNum)){
-      fprintf(stderr, "%s: Error end sequence number is smaller than start sequence number!\n"
-              "End number must be the newer (larger) sequence number.\n"
-              "Sequence numbers must be of the same GRANULARITY (minutely, hourly or daily) and no more than %d change files apart.\n",
-              progName, MAX_OSC_DOWNLOAD);
-      logMessage(fLogPtr, "Error end sequence number is smaller than start sequence number!\n"
-                 "End number must be the newer (larger) sequence number.\n"
-                 "Sequence numbers must be of the same GRANULARITY (minutely, hourly or daily) and no more than 61 change files apart.");
 
-      return ztInvalidArg;
+    result = getParentPage(childrenList, currentParent);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed getParentPage() function.\n", progName);
+      logMessage(fLogPtr, "Error failed getParentPage() function.");
+
+      return result;
     }
-  }
 
-  int result;
-  PATH_PART startPP, endPP;
+    char logStr[1024] = {0};
 
-  result = sequence2PathPart(&startPP, startNum);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed sequence2PathPart() function.\n", progName);
-    logMessage(fLogPtr, "Error failed sequence2PathPart() function.");
+    fprintf(stdout, "%s: Retrieved childrenList from remote server with size: %d\n", progName, DL_SIZE(childrenList));
+    sprintf(logStr, "Retrieved childrenList from remote server with size: %d", DL_SIZE(childrenList));
+    logMessage(fLogPtr, logStr);
+    /*
+      if(fVerbose){
+      fprintStringList(NULL, childrenList);
+      fprintStringList(fLogPtr, childrenList);
+      }
+    **/
+    if(parentElem == DL_HEAD(parentsList)){
+      startElem = findElemSubString(childrenList, startPP->fileEntry);
 
-    return result;
-  }
+      if(fUsingPreviousID){ /* start AFTER last one we downloaded **/
+        startElem = DL_NEXT(DL_NEXT(startElem));
+      }
+    }
+    else
+      startElem = DL_HEAD(childrenList);
 
-  result = sequence2PathPart(&endPP, endNum);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed sequence2PathPart() function.\n", progName);
-    logMessage(fLogPtr, "Error failed sequence2PathPart() function.");
+    if(parentElem == DL_TAIL(parentsList))
+      endElem = DL_NEXT(findElemSubString(childrenList, endPP->fileEntry)); // files are in pairs (.osc & .state.txt)
+    else
+      endElem = DL_TAIL(childrenList);
 
-    return result;
-  }
+    diffElem = startElem;
+    while(diffElem){
 
-  if(fVerbose){
-    fprintf(stdout, "start PATH_PART is below:\n");
-    fprintPathPart(NULL, &startPP);
+      filename = (char *) DL_DATA(diffElem);
+      sprintf(buffer, "%s%s", currentParent, filename);
 
-    printf("end PATH_PART is below:\n");
-    fprintPathPart(NULL, &endPP);
-  }
+      newDiff = STRDUP(buffer);
 
-  if(strcmp(startPP.rootEntry, endPP.rootEntry) != 0){
+      result = insertNextDL(destList, DL_TAIL(destList), (void *) newDiff);
+      if(result != ztSuccess){
+        fprintf(stderr, "%s: Error failed insertNextDL().\n", progName);
+        logMessage(fLogPtr, "Error failed insertNextDL().");
+        return result;
+      }
 
-    fprintf(stderr, "%s: Error; start and end sequence numbers do not share root entry.\n", progName);
-    logMessage(fLogPtr, "Error; sequence numbers (both) must of the same granularity.");
+      if(diffElem == endElem)
+        break;
 
-    return ztInvalidArg;
-  }
+      diffElem = DL_NEXT(diffElem);
+    }
 
-  if(strcmp(startPP.parentEntry, endPP.parentEntry) != 0){
+    parentElem = DL_NEXT(parentElem);
 
-    if(! areAdjacentStrings(startPP.rootEntry, startPP.parentEntry, endPP.parentEntry) ){
-      fprintf(stderr, "%s: Error; start & end sequence numbers are NOT from adjacent directories!\n"
-              " start parent directory is: %s\n"
-              " end parent directory is: %s\n"
-              " Sequence numbers must be from same GRANULARITY with begin being the older of\n"
-              " the two and no more than %d change files can be downloaded each invocation.\n\n",
-              progName, startPP.parentPath, endPP.parentPath, MAX_OSC_DOWNLOAD);
-      logMessage(fLogPtr, "Error; start & end sequence numbers are NOT from adjacent directories!");
+  }/* end while(parentElem) **/
 
-      return ztInvalidArg;
-    }
-  } /* end if not same parent **/
+  //TODO: cleanup
 
-  /* check if files exist on remote server **/
-  char fileSuffix[PATH_MAX] = {0};
+  return ztSuccess;
 
-  sprintf(fileSuffix, "%s%s", startPP.filePath, STATE_EXT);
+} /* END getDiffersList() **/
 
-  printf("calling isRemote() with fileSuffix = %s\n", fileSuffix);
 
-  result = isRemoteFile(fileSuffix);
-  if(result == ztFileNotFound){
-    fprintf(stderr, "%s: Error, change file for start sequence number is not available.\n"
-            "Please check server site for available files.\n\n", progName);
-    logMessage(fLogPtr, "Error, change file for start sequence number is not available.\n"
-               "Please check server site for available files.\n");
+int downloadFilesList(STRING_LIST *completed, STRING_LIST *downloadList, char *localDestPrefix, int textOnly){
+
+  int    result;
+  ELEM   *elem;
+  char   *filename;
+  char   *pathSuffix;
+  char   localFilename[1024];
+  char   partFilename[1024 + 8];
+  char   oscFilename[1024] = {0}; /* local change file waiting for its state.txt **/
+
+  MEMORY_STRUCT  *oscMemory = NULL; /* stream mode: change file waiting for its state.txt **/
+
+  int    iCount = 0;
+  int    sleepSeconds = 0;
+  int    fromStore;
+  int    fromJournal;
+  long   fileSize;
+  SEQ_NUM  seq;
+
+  ASSERTARGS(completed && downloadList && localDestPrefix);
+
+  /* completed: filename is inserted once download is completed successfully
+   * the list should be empty. caller initials list.
+   */
+
+  elem = DL_HEAD(downloadList);
+  while(elem){
 
-    return ztFileNotFound;
-  }
-  else if(result != ztSuccess){
-    fprintf(stderr, "%s: Error, failed isRemoteFile() function for start sequence number.\n"
-            " You may retry later but function failed for: <%s>.\n\n",
-            progName, ztCode2ErrorStr(result));
-    logMessage(fLogPtr, "Error, failed isRemoteFile() function for start sequence number.\n"
-               " You may retry later but function failed for: -- see below --");
-    logMessage(fLogPtr, ztCode2ErrorStr(result));
+    pathSuffix = (char *)DL_DATA(elem);
+    filename = lastOfPath(pathSuffix);
 
-    return result;;
-  }
-  else{ /* result == ztSuccess **/
-    if(fVerbose){
-      fprintf(stdout, "%s: Change file for start sequence number is available from remote.\n", progName);
-      logMessage(fLogPtr, "Change file for start sequence number is available from remote.");
+    if(textOnly && ! strstr(filename, ".state.txt")){
+      elem = DL_NEXT(elem);
+      continue;
     }
-  }
 
-  /* is file for end sequence available? **/
-  sprintf(fileSuffix, "%s%s", endPP.filePath, STATE_EXT);
+    /* stop request is taken between pairs; committed pairs are kept **/
+    if(stopRequest && strstr(filename, CHANGE_EXT)){
+      fprintf(stderr, "%s: Stopped by signal; next run resumes after last committed pair.\n", progName);
+      logMessage(fLogPtr, "Stopped by signal; next run resumes after last committed pair.");
+      if(oscMemory)
+        zapMS(&oscMemory);
+      return ztFailedDownload;
+    }
 
-  result = isRemoteFile(fileSuffix);
-  if(result == ztFileNotFound){
-    fprintf(stderr, "%s: Error, change file for end sequence number is not available.\n"
-            "Please check server site for available files.\n\n", progName);
-    logMessage(fLogPtr, "Error, change file for end sequence number is not available.\n"
-               "Please check server site for available files.\n");
+    iCount++;
 
-    return ztFileNotFound;
-  }
-  else if(result != ztSuccess){
-    fprintf(stderr, "%s: Error, failed isRemoteFile() function for end sequence number.\n"
-            " You may retry later but function failed for: <%s>.\n\n",
-            progName, ztCode2ErrorStr(result));
-    logMessage(fLogPtr, "Error, failed isRemoteFile() function for end sequence number.\n"
-               " You may retry later but function failed for: -- see below --");
-    logMessage(fLogPtr, ztCode2ErrorStr(result));
+    /* long runs write metrics file as they go **/
+    metricsTick();
 
-    return result;
-  }
-  else{ /* result == ztSuccess **/
-    if(fVerbose){
-      fprintf(stdout, "%s: Change file for end sequence number is available from remote.\n", progName);
-      logMessage(fLogPtr, "Change file for end sequence number is available from remote.");
-    }
-  }
+    /* no delay for first 12 files **/
+    if(iCount < 11)
+      sleepSeconds = SLEEP_INTERVAL;
 
-  /* allow single change file download **/
-  if(strcmp(startPP.sequenceNum, endPP.sequenceNum) == 0) return ztSuccess;
+    /* increment sleep time after each 7 (had 4 before) files **/
+    else if( (iCount % 7) == 0 )
+      sleepSeconds += SLEEP_INTERVAL;
+      //sleepSeconds = SLEEP_INTERVAL;
 
-  /* unless endSeq == startSeq 'end' must be newer than 'start' -
-   * compare time stamps from state.txt files **/
+    else ;
 
-  result = isEndNewer(&startPP, &endPP);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error 'end' does not have more recent time stamp than 'start'.\n", progName);
-    logMessage(fLogPtr, "Error 'end' does not have more recent time stamp than 'start'.");
+    memset(localFilename, 0, sizeof(localFilename));
+    if(SLASH_ENDING(localDestPrefix))
+      sprintf(localFilename, "%s%s", localDestPrefix, pathSuffix + 1); // (pathSuffix + 1) skip FIRST slash in path
+    else
+      sprintf(localFilename, "%s/%s", localDestPrefix, pathSuffix + 1);
 
-    return result;
-  }
+    /* pair committed by interrupted run is whole on disk **/
+    fromJournal = (isJournalOn() && path2Sequence(&seq, pathSuffix) == ztSuccess &&
+                   isPairCommitted(seq) && isFileUsable(localFilename) == ztSuccess);
 
-  return ztSuccess;
+    /* known file is linked from store; no wait and no fetch **/
+    fromStore = (! fromJournal && isStoring() && ! (isStreaming() && strstr(filename, CHANGE_EXT)) &&
+                 storeFetch(pathSuffix, localFilename) == ztSuccess);
 
-} /* END areNumsGoodPair() **/
+    /* wait before next download **/
+    if(! fromStore && ! fromJournal && ! isLocalSourceOn())
+      sleep(sleepSeconds);
 
-/* isRemoteFile2(): is file available - exist - on remote server?
- *
- * - function tries to retrieve 'header' ONLY for file from remote server
- * - if 'header' was NOT found, then file does NOT exist on remote
- * - 'header' is saved to tmpDir with appended ".Header" to filename.
- *
- * Caller should check returns for any error.
- *
- ******************************************************************/
+    /* readers do not see a file while it is written; store link is whole **/
+    result = sourceWriteBegin();
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed sourceWriteBegin() function.\n", progName);
+      logMessage(fLogPtr, "Error failed sourceWriteBegin() function.");
+      if(oscMemory)
+        zapMS(&oscMemory);
+      return result;
+    }
 
-int isRemoteFile(char *remoteSuffix){
+    if(fromJournal){
 
-  char *toDir = (char *) tmpDir; // set to global tmpDir
+      if(fVerbose)
+        fprintf(stdout, "%s: From journal: %s\n", progName, localFilename);
 
-  ASSERTARGS(remoteSuffix && toDir);
+      result = ztSuccess;
+    }
+    else if(fromStore){
 
-  int  result;
+      if(fVerbose)
+        fprintf(stdout, "%s: From store: %s\n", progName, localFilename);
 
-  /* this function uses myDownload() to get header for file from remote:
-     prototype: int myDownload(char *remotePathSuffix, char *localFile)
-     first argument is our argument here 'remoteSuffix' we make string
-     for the second argument, saving header to 'tmpDir'.
+      result = ztSuccess;
+    }
+    else if(isStreaming() && strstr(filename, CHANGE_EXT)){
 
-     Another approach is to partially retrieve first chunk bytes (say 1024) to
-     memory; not to file, then compare to (look for) some hint string.
-  *********************************************************************/
+      if(! oscMemory)
+        oscMemory = initialMS();
 
-  char localFile[PATH_MAX] = {0};
+      if(! oscMemory){
+        fprintf(stderr, "%s: Error failed initialMS().\n", progName);
+        logMessage(fLogPtr, "Error failed initialMS().");
+        sourceWriteEnd();
+        return ztMemoryAllocate;
+      }
 
-  if(SLASH_ENDING(toDir))
-    sprintf(localFile, "%s%s.Header", toDir, lastOfPath(remoteSuffix));
-  else
-    sprintf(localFile, "%s/%s.Header", toDir, lastOfPath(remoteSuffix));
+      result = myDownload2Memory(pathSuffix, oscMemory);
+      if(result == ztSuccess)
+        metricsFile((long long) oscMemory->size);
+    }
+    else {
 
-  /* set 2 options in global 'downloadHandle': CURLOPT_NOBODY & CURLOPT_HEADER **/
+      /* file from old name is never written in place; it may be linked to store **/
+      if(isStoring())
+        unlink(localFilename);
 
-  CURLcode curlCode;
+      /* file takes its name only when whole and on disk **/
+      sprintf(partFilename, "%s.part", localFilename);
 
-  curlCode = curl_easy_setopt(downloadHandle, CURLOPT_NOBODY, 1L);
-  if (curlCode != CURLE_OK){
-    fprintf(stderr, "%s: Error failed curl_easy_setopt() for CURLOP_NOBODY.\n", progName);
-    logMessage(fLogPtr, "Error failed curl_easy_setopt() for CURLOP_NOBODY.");
+      result = myDownload(pathSuffix, partFilename);
+      if(result == ztSuccess)
+        result = commitFile(partFilename, localFilename);
+      else
+        unlink(partFilename);
 
-    return ztFailedLibCall;
-  }
+      if(result == ztSuccess && isMetricsOn()){
+        fileSize = 0;
+        getFileSize(&fileSize, localFilename);
+        metricsFile((long long) fileSize);
+      }
 
-  curlCode = curl_easy_setopt(downloadHandle, CURLOPT_HEADER, 1L);
-  if (curlCode != CURLE_OK){
-    fprintf(stderr, "%s: Error failed curl_easy_setopt() for CURLOP_HEADER.\n", progName);
-    logMessage(fLogPtr, "Error failed curl_easy_setopt() for CURLOP_HEADER.");
+      if(result == ztSuccess && isStoring() && storeAdd(pathSuffix, localFilename) != ztSuccess){
+        fprintf(stderr, "%s: Warning failed storeAdd() for: <%s>; file is kept.\n", progName, localFilename);
+        logMessage(fLogPtr, "Warning failed storeAdd() function; file is kept.");
+      }
+    }
 
-    return ztFailedLibCall;
-  }
+    if(result == ztSuccess){
+      /* each list must have its own copy of data; this is
+       * so zapString() does not free same pointer again. **/
 
-  result = myDownload(remoteSuffix, localFile);
+      char *pathSuffixCopy;
+      pathSuffixCopy = STRDUP(pathSuffix);
 
-  /* restore 2 options to defaults **/
-  curlCode = curl_easy_setopt(downloadHandle, CURLOPT_NOBODY, 0L);
-  if (curlCode != CURLE_OK){
-    fprintf(stderr, "%s: Error failed curl_easy_setopt() for CURLOP_NOBODY (unset).\n", progName);
-    logMessage(fLogPtr, "Error failed curl_easy_setopt() for CURLOP_NOBODY (unset).");
+      insertNextDL(completed, DL_TAIL(completed), (void *) pathSuffixCopy); //(void **) pathSuffixCopy);
 
-    return ztFailedLibCall;
-  }
+      /* latest local sequence and its timestamp for metrics **/
+      if(! strstr(filename, CHANGE_EXT))
+        metricsState(localFilename);
+
+      /* list is sorted; change file comes before its state.txt file **/
+      if(strstr(filename, CHANGE_EXT))
+        strcpy(oscFilename, localFilename);
+
+      else if(oscFilename[0] &&
+              strncmp(oscFilename, localFilename, strlen(localFilename) - strlen(STATE_EXT)) == 0){
+
+        if(isStreaming()){
+
+          result = streamPair(oscMemory, oscFilename, localFilename);
+          if(result != ztSuccess){
+            zapMS(&oscMemory);
+            sourceWriteEnd();
+            return result;
+          }
+
+          /* without tee there is no change file on disk to announce **/
+          if(! isStreamTee()){
+            oscFilename[0] = '\0';
+            sourceWriteEnd();
+            elem = DL_NEXT(elem);
+            continue;
+          }
+        }
 
-  result = curl_easy_setopt(downloadHandle, CURLOPT_HEADER, 0L);
-  if (curlCode != CURLE_OK){
-    fprintf(stderr, "getRemoteHeader(): Error failed curl_easy_setopt() for CURLOP_HEADER (restore).\n");
-    logMessage(fLogPtr, "getRemoteHeader(): Error failed curl_easy_setopt() for CURLOP_HEADER (restore).");
+        result = pairDone(oscFilename, localFilename);
+        if(result != ztSuccess){
+          fprintf(stderr, "%s: Error failed pairDone() for: <%s>\n", progName, oscFilename);
+          logMessage(fLogPtr, "Error failed pairDone() function.");
+          sourceWriteEnd();
+          return result;
+        }
 
-    return ztFailedLibCall;
-  }
+        result = commitPair(localFilename);
+        if(result != ztSuccess){
+          fprintf(stderr, "%s: Error failed commitPair() for: <%s>\n", progName, localFilename);
+          logMessage(fLogPtr, "Error failed commitPair() function.");
+          sourceWriteEnd();
+          return result;
+        }
 
-#ifdef REMOVE_TMP
-  removeFile(localFile);
-#endif
+        oscFilename[0] = '\0';
+      }
+    }
+    else{
+      fprintf(stderr, "%s: Error failed myDownload() function for localFilename: <%s>\n",
+              progName, localFilename);
+      char logBuff[2048] = {0};
+      sprintf(logBuff, "Error failed myDownload() function for localFilename: <%s>\n", localFilename);
+      logMessage(fLogPtr, logBuff);
 
-  if(result == ztResponse404)
+      if(oscMemory)
+        zapMS(&oscMemory);
 
-    return ztFileNotFound;
+      sourceWriteEnd();
+      return result;
+    }
 
-  else if(result == ztResponse200)
+    sourceWriteEnd();
 
-    return ztSuccess;
+    /* file sizes are checked in download2File() function **/
 
-  return result;
+    elem = DL_NEXT(elem);
+  }
 
-} /* END isRemoteFile2() **/
+  if(oscMemory)
+    zapMS(&oscMemory);
+
+  return ztSuccess;
+
+} /* END downloadFilesList() **/
 
-/* areAdjacentStrings(): are firstStr & secondStr adjacent in string list?
- * string list is constructed from sourceSuffix.
+/* mergeCompleted(): merges change files for a range of sequence numbers
+ * into one file pair in MERGED_DIR under 'localDestPrefix':
  *
- * secondStr comes AFTER firstStr only.
+ *   merged/{first}-{last}.osc.gz & merged/{first}-{last}.state.txt
  *
- ************************************************************************/
+ * range is 'begin' to 'end' from settings when both are set - range function -
+ * else first to last change file in 'completed' list. Files are taken from the
+ * tree, so pairs downloaded by earlier runs in that range are merged too; every
+ * change file in range must be there.
+ * sequence numbers are zero padded to 9 digits so names sort in order.
+ * 'mergedList' is set to new list with these two path suffixes.
+ *
+ ***************************************************************************/
 
-int areAdjacentStrings(char *sourceSuffix, char *firstStr, char *secondStr){
+static int mergeCompleted(STRING_LIST **mergedList, STRING_LIST *completed, const char *begin, const char *end, char *localDestPrefix){
 
-  char *toDir = (char *) tmpDir; // use tmpDir
+  ASSERTARGS(mergedList && completed && localDestPrefix);
 
-  ASSERTARGS(sourceSuffix && firstStr && secondStr && tmpDir);
+  STRING_LIST  *oscList;
+  ELEM         *elem;
+  char         *suffix;
+  char         buffer[PATH_MAX];
+  char         seqPath[SEQ_PATH_SIZE];
+  char         mergedDir[PATH_MAX];
+  char         oscSuffix[64], stateSuffix[64];
+  char         destOsc[PATH_MAX], destState[PATH_MAX], lastState[PATH_MAX] = {0};
+  SEQ_NUM      first = SEQ_NONE, last = SEQ_NONE, seq;
+  int          result;
 
-  int result;
-  char *filename = "areAdjacent.html";
-  char myFile[512] = {0};
+  if(begin && end){
+
+    if(string2Sequence(&first, begin) != ztSuccess || string2Sequence(&last, end) != ztSuccess){
+      fprintf(stderr, "%s: Error invalid merge range: <%s> to <%s>\n", progName, begin, end);
+      logMessage(fLogPtr, "Error invalid merge range.");
+      return ztInvalidArg;
+    }
+  }
+  else {
 
-  STRING_LIST *list;
+    for(elem = DL_HEAD(completed); elem; elem = DL_NEXT(elem)){
 
-  list = initialStringList();
+      suffix = (char *) DL_DATA(elem);
 
-  if(!list){
-    fprintf(stderr, "%s: Error failed initialStringList() in areAdjacentStrings(). Terminating program.\n", progName);
-    logMessage(fLogPtr, "Error failed initialStringList()in areAdjacentStrings(). Terminating program.");
+      if(strstr(suffix, STATE_EXT) || path2Sequence(&seq, suffix) != ztSuccess)
+        continue;
 
-    exit(ztMemoryAllocate);
+      if(first == SEQ_NONE || seq < first)
+        first = seq;
+      if(seq > last)
+        last = seq;
+    }
   }
 
-  if(SLASH_ENDING(toDir))
-    sprintf(myFile, "%s%s", toDir, filename);
-  else
-    sprintf(myFile, "%s/%s", toDir, filename);
+  oscList = initialStringList();
+  if(!oscList){
+    fprintf(stderr, "%s: Error failed initialStringList().\n", progName);
+    logMessage(fLogPtr, "Error failed initialStringList().");
+    return ztMemoryAllocate;
+  }
 
-  /* curl parse handle has the starting part of the 'path' or the 'path' prefix,
-   * we provide the rest of the path - or the 'path' suffix - to myDownload()
-   * as the first parameter. Second parameter is our local file name.
-   ***********************************************************************/
+  /* change file for each sequence; state.txt file of the last one **/
+  for(seq = first; first != SEQ_NONE && seq <= last; seq++){
 
-  result = myDownload(sourceSuffix, myFile);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed myDownload(), result is: %s\n\n", progName, ztCode2ErrorStr(result));
-    logMessage(fLogPtr, "Error failed myDownload() function; see reason below:");
-    logMessage(fLogPtr, ztCode2ErrorStr(result));
+    sequence2Path(seqPath, seq);
 
-    zapStringList((void **) &list);
-    return FALSE;
-  }
+    if(SLASH_ENDING(localDestPrefix))
+      snprintf(buffer, sizeof(buffer), "%s%s%s", localDestPrefix, seqPath + 1, CHANGE_EXT);
+    else
+      snprintf(buffer, sizeof(buffer), "%s%s%s", localDestPrefix, seqPath, CHANGE_EXT);
+
+    if(isFileUsable(buffer) != ztSuccess){
+      fprintf(stderr, "%s: Error missing change file to merge: <%s>\n", progName, buffer);
+      logMessage(fLogPtr, "Error missing change file to merge; file is below:");
+      logMessage(fLogPtr, buffer);
+      zapStringList((void **) &oscList);
+      return ztFileNotFound;
+    }
 
-  result = parseHtmlFile(list, myFile);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed parseHtmlFile().\n", progName);
-    logMessage(fLogPtr, "Error failed parseHtmlFile().");
+    insertNextDL(oscList, DL_TAIL(oscList), (void *) STRDUP(buffer));
 
-    zapStringList((void **) &list);
-    return FALSE;
+    if(seq == last){
+      strcpy(lastState, buffer);
+      strcpy(lastState + strlen(lastState) - strlen(CHANGE_EXT), STATE_EXT);
+    }
   }
-  /*
-    printf("areAjacentStrings(): after parseHtmlFile() printing 'list' below:\n");
-    fprintStringList(stdout, list);
-  */
-  ELEM *firstElem, *secondElem;
-
-  firstElem = findElemString(list, firstStr);
-  if(!firstElem){
-    fprintf(stderr, "%s: Error failed findElemString() for 'firstStr': <%s>.\n", progName, firstStr);
-    logMessage(fLogPtr, "Error failed findElemString() for 'firstStr'.");
 
-    zapStringList((void **) &list);
-    return FALSE;
+  if(DL_SIZE(oscList) == 0 || !lastState[0]){
+    fprintf(stderr, "%s: Error no change files to merge.\n", progName);
+    logMessage(fLogPtr, "Error no change files to merge.");
+    zapStringList((void **) &oscList);
+    return ztListEmpty;
   }
 
-  secondElem = findElemString(list, secondStr);
-  if(!secondElem){
-    fprintf(stderr, "%s: Error failed findElemString() for 'secondStr': <%s>.\n", progName, secondStr);
-    logMessage(fLogPtr, "Error failed findElemString() for 'secondStr'.");
+  if(SLASH_ENDING(localDestPrefix))
+    sprintf(mergedDir, "%s%s", localDestPrefix, MERGED_DIR);
+  else
+    sprintf(mergedDir, "%s/%s", localDestPrefix, MERGED_DIR);
 
-    zapStringList((void **) &list);
-    return FALSE;
+  result = myMkDir(mergedDir);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed myMkDir() for: <%s>\n", progName, mergedDir);
+    logMessage(fLogPtr, "Error failed myMkDir() for merged directory.");
+    zapStringList((void **) &oscList);
+    return result;
   }
 
-  /* result is TRUE only if second element is next to first element **/
-  if(secondElem == DL_NEXT(firstElem)){
-
-#ifdef REMOVE_TMP
-    removeFile(myFile);
-#endif
+  sprintf(oscSuffix, "/%s/%09u-%09u%s", MERGED_DIR, first, last, CHANGE_EXT);
+  sprintf(stateSuffix, "/%s/%09u-%09u%s", MERGED_DIR, first, last, STATE_EXT);
 
-    zapStringList((void **) &list);
-    return TRUE;
+  if(snprintf(destOsc, sizeof(destOsc), "%s/%09u-%09u%s", mergedDir, first, last, CHANGE_EXT) >= (int) sizeof(destOsc) ||
+     snprintf(destState, sizeof(destState), "%s/%09u-%09u%s", mergedDir, first, last, STATE_EXT) >= (int) sizeof(destState)){
+    fprintf(stderr, "%s: Error merged filename is too long.\n", progName);
+    zapStringList((void **) &oscList);
+    return ztFnameLong;
   }
 
-  return FALSE;
+  fprintf(stdout, "%s: Merging <%d> change files into: %s\n", progName, DL_SIZE(oscList), destOsc);
+  logMessage(fLogPtr, "Merging downloaded change files into file below:");
+  logMessage(fLogPtr, destOsc);
 
-} /* END areAdjacentStrings()  **/
+  result = mergeChangeFiles(destOsc, oscList, tmpDir);
 
-/* isEndNewer(): returns ztSuccess when 'end' has a newer
- *               or more recent time stamp than that of 'start'.
- *
- ***************************************************************/
+  zapStringList((void **) &oscList);
 
-int isEndNewer(PATH_PART *startPP, PATH_PART *endPP){
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed mergeChangeFiles().\n", progName);
+    logMessage(fLogPtr, "Error failed mergeChangeFiles().");
+    return result;
+  }
 
-  char *toDir = (char *) tmpDir; // must be set upstream
+  result = writeMergedState(destState, lastState, first, last);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed writeMergedState().\n", progName);
+    logMessage(fLogPtr, "Error failed writeMergedState().");
+    return result;
+  }
 
-  ASSERTARGS(startPP && endPP && toDir);
+  *mergedList = initialStringList();
+  if(! *mergedList){
+    fprintf(stderr, "%s: Error failed initialStringList().\n", progName);
+    logMessage(fLogPtr, "Error failed initialStringList().");
+    return ztMemoryAllocate;
+  }
 
-  int result;
+  insertNextDL(*mergedList, DL_TAIL(*mergedList), (void *) STRDUP(oscSuffix));
+  insertNextDL(*mergedList, DL_TAIL(*mergedList), (void *) STRDUP(stateSuffix));
 
-  /* get state.txt files for both, to compare their age. **/
-  char remoteSuffix[128] = {0};
-  char startLocalFile[PATH_MAX] = {0};
-  char endLocalFile[PATH_MAX] = {0};
+  fprintf(stdout, "%s: Merged change file is done.\n", progName);
+  logMessage(fLogPtr, "Merged change file is done.");
 
-  STATE_INFO *startStateInfo, *endStateInfo;
+  return ztSuccess;
 
-  /* initial state infos **/
-  startStateInfo = initialStateInfo();
-  if(!startStateInfo){
-    fprintf(stderr, "%s: Error failed initialStateInfo() call for start number.\n", progName);
-    logMessage(fLogPtr, "Error failed initialStateInfo() call for start number.");
+} /* END mergeCompleted() **/
 
-    return ztMemoryAllocate;
-  }
+/* filterCompleted(): writes regional change files for each downloaded
+ * pair in 'completed', in sequence order - object cache depends on it.
+ *
+ ***************************************************************************/
 
-  endStateInfo = initialStateInfo();
-  if(!endStateInfo){
-    fprintf(stderr, "%s: Error failed initialStateInfo() call for end number.\n", progName);
-    logMessage(fLogPtr, "Error failed initialStateInfo() call for end number.");
+static int filterCompleted(STRING_LIST *completed, char *localDestPrefix){
 
-    return ztMemoryAllocate;
-  }
+  ASSERTARGS(completed && localDestPrefix);
 
-  sprintf(remoteSuffix, "%s%s", startPP->filePath, STATE_EXT);
+  ELEM   *elem;
+  char   *suffix, *stateSuffix;
+  char   oscFile[PATH_MAX], stateFile[PATH_MAX];
+  int    count = 0;
+  int    result;
 
-  if(SLASH_ENDING(toDir))
-    sprintf(startLocalFile, "%s%s%s", toDir, startPP->fileEntry, STATE_EXT);
-  else
-    sprintf(startLocalFile, "%s/%s%s", toDir, startPP->fileEntry, STATE_EXT);
+  fprintf(stdout, "%s: Writing regional change files for <%d> regions.\n", progName, regionSet->numRegions);
 
-  /* download start state.txt file **/
-  result = myDownload(remoteSuffix, startLocalFile);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed myDownload() function for start state.txt file.\n", progName);
-    logMessage(fLogPtr, "Error failed myDownload() function for start state.txt file.");
+  /* list is sorted; change file comes before its state.txt file **/
+  for(elem = DL_HEAD(completed); elem && DL_NEXT(elem); elem = DL_NEXT(elem)){
 
-    return result;
-  }
+    suffix = (char *) DL_DATA(elem);
+    stateSuffix = (char *) DL_DATA(DL_NEXT(elem));
 
-  sprintf(remoteSuffix, "%s%s", endPP->filePath, STATE_EXT);
+    if(! strstr(suffix, CHANGE_EXT) || ! strstr(stateSuffix, STATE_EXT))
+      continue;
 
-  if(SLASH_ENDING(toDir))
-    sprintf(endLocalFile, "%s%s%s", toDir, endPP->fileEntry, STATE_EXT);
-  else
-    sprintf(endLocalFile, "%s/%s%s", toDir, endPP->fileEntry, STATE_EXT);
+    snprintf(oscFile, sizeof(oscFile), "%s%s%s", localDestPrefix, SLASH_ENDING(localDestPrefix) ? "" : "/", suffix + 1);
+    snprintf(stateFile, sizeof(stateFile), "%s%s%s", localDestPrefix, SLASH_ENDING(localDestPrefix) ? "" : "/", stateSuffix + 1);
 
-  /* download end state.txt file **/
-  result = myDownload(remoteSuffix, endLocalFile);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed myDownload() function for end state.txt file.\n", progName);
-    logMessage(fLogPtr, "Error failed myDownload() function for end state.txt file.");
+    result = filterChangeFile(regionSet, oscFile, stateFile, suffix);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed filterChangeFile() for: <%s>\n", progName, oscFile);
+      logMessage(fLogPtr, "Error failed filterChangeFile() for file below:");
+      logMessageLevel(fLogPtr, LOG_ERROR, oscFile);
+      return result;
+    }
 
-    return result;
+    count++;
+    elem = DL_NEXT(elem);
   }
 
-  /* parse state.txt files (start & end) into STATE_INFOs **/
-  result = stateFile2StateInfo(startStateInfo, startLocalFile);
+  fprintf(stdout, "%s: Wrote regional change files for <%d> change files.\n", progName, count);
+  logMessage(fLogPtr, "Wrote regional change files for downloaded change files.");
 
-#ifdef REMOVE_TMP
-  removeFile(startLocalFile);
-  if(result != ztSuccess)
-	removeFile(endLocalFile);
-#endif
+  return ztSuccess;
 
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed stateFile2StateInfo() function for start state.txt file.\n", progName);
-    logMessage(fLogPtr, "Error failed stateFile2StateInfo() function for start state.txt file.");
+} /* END filterCompleted() **/
 
-    return result;
-  }
+/* workSourceTree(): tree of work directory source - the source whose files
+ * are in work directory, where they were before per-source locks; any other
+ * source keeps them in {tree}/.source/. Source is named by its tree path in
+ * {workDir}/.source.getdiff. Without that file it is the tree holding the
+ * sequence in {workDir}/previous.seq, else 'treeDir'; with 'claim' set -
+ * caller holds work directory lock exclusive - the file is written then.
+ * Returns one of 'dirs' tree members; NULL when 'treeDir' is NULL and none
+ * is found.
+ *
+ ******************************************************************************/
 
-  result = stateFile2StateInfo(endStateInfo, endLocalFile);
+static char *workSourceTree(SKELETON *dirs, char *treeDir, int claim){
 
-#ifdef REMOVE_TMP
-  removeFile(endLocalFile);
-#endif
+  ASSERTARGS(dirs);
 
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed stateFile2StateInfo() function for end state.txt file.\n", progName);
-    logMessage(fLogPtr, "Error failed stateFile2StateInfo() function for end state.txt file.");
+  char       *trees[] = {treeDir, dirs->geofabrik, dirs->planetMin, dirs->planetHour, dirs->planetDay};
+  int        numTrees = sizeof(trees) / sizeof(char *);
+  size_t     workLength = strlen(dirs->workDir);
+  char       markFile[PATH_MAX], name[PATH_MAX], line[PATH_MAX];
+  char       *seqString;
+  char       *found = NULL;
+  FILE       *filePtr;
+  PATH_PART  pathPart;
+  int        index;
 
-    return result;
-  }
+  snprintf(markFile, sizeof(markFile), "%s%s", dirs->workDir, WORK_SOURCE);
 
-  /*
-    fprintf(stdout, "printing STATE_INFO for START below:\n");
-    fprintStateInfo2(stdout, startStateInfo);
+  filePtr = fopen(markFile, "r");
+  if(filePtr){
 
-    fprintf(stdout, "printing STATE_INFO for END below:\n");
-    fprintStateInfo2(stdout, endStateInfo);
-  **/
+    if(! fgets(line, sizeof(line), filePtr))
+      line[0] = '\0';
+    fclose(filePtr);
 
-  if(endStateInfo->timeValue < startStateInfo->timeValue){
-    fprintf(stderr, "%s: Error end change file is not newer than start change file.\n", progName);
-    logMessage(fLogPtr,"Error end change file is not newer than start change file.");
+    line[strcspn(line, "\n")] = '\0';
 
-    return ztInvalidArg;
+    for(index = 1; index < numTrees; index++)
+      if(strcmp(trees[index] + workLength, line) == 0)
+        return trees[index];
   }
 
-  return ztSuccess;
+  /* previous.seq from older version; its tree has the directory for it **/
+  snprintf(name, sizeof(name), "%s%s", dirs->workDir, PREV_SEQ_FILE);
 
-} /* END isEndNewer() **/
+  seqString = (isFileUsable(name) == ztSuccess) ? readPreviousID(name) : NULL;
 
-int getDiffersList(STRING_LIST *destList, PATH_PART *startPP, PATH_PART *endPP){
+  if(seqString && sequence2PathPart(&pathPart, seqString) == ztSuccess){
 
-  ASSERTARGS(destList && startPP && endPP);
+    for(index = 0; ! found && index < numTrees; index++){
 
-  ASSERTARGS(startPP->parentPath && startPP->fileEntry); // needed: is filled out structure?
-  ASSERTARGS(endPP->parentPath && endPP->fileEntry);
+      if(! trees[index])
+        continue;
 
-  if(DL_SIZE(destList)){
-    fprintf(stderr, "%s: Error destList is not empty.\n", progName);
-    logMessage(fLogPtr, "Error destList is not empty.");
-    return ztListNotEmpty;
+      snprintf(name, sizeof(name), "%s%s%s", trees[index], pathPart.rootEntry, pathPart.parentEntry);
+      if(isPathDirectory(name))
+        found = trees[index];
+    }
   }
 
-  int result;
-  STRING_LIST *parentsList;
-  STRING_LIST *childrenList;
+  if(seqString)
+    free(seqString);
 
-  char *newPath;
+  if(! found)
+    found = treeDir;
 
-  /* fill parentList: list of Parent Page(s) from startSequenceNum & endSequenceNum
-   * there will be one page when start & end share parent or two when they do not
-   *******************************************************************************/
-  parentsList = initialStringList();
-  if(!parentsList){
-    fprintf(stderr, "%s: Error failed initialStringList().\n", progName);
-    logMessage(fLogPtr, "Error failed initialStringList().");
+  if(claim && found){
 
-    return ztMemoryAllocate;
+    filePtr = fopen(markFile, "w");
+    if(! filePtr || fprintf(filePtr, "%s\n", found + workLength) < 0)
+      fprintf(stderr, "%s: Warning failed writing <%s>: %s\n", progName, markFile, strerror(errno));
+    if(filePtr)
+      fclose(filePtr);
   }
 
-  newPath = STRDUP(startPP->parentPath);
+  return found;
 
-  /* insert start 'parentPath' as FIRST element.
-   * ALWAYS use dynamically allocated memory for data pointer in ELEM. **/
+} /* END workSourceTree() **/
 
-  result = insertNextDL(parentsList, DL_TAIL(parentsList), (void *) newPath);
-  if(result != ztSuccess){
-    fprintf(stderr, "%s: Error failed insertNextTo() function.\n", progName);
-    logMessage(fLogPtr, "Error failed insertNextTo() function.");
+/* streamPair(): stream mode; called when state.txt for change file held in
+ * 'oscMemory' is on disk. Change file is checked, optionally written to its
+ * local name 'oscFile' (tee), then written to stream. 'previous.seq' is
+ * updated only after the whole file went out - a rerun after failure starts
+ * with the first file not fully emitted.
+ *
+ ***************************************************************************/
+
+static int streamPair(MEMORY_STRUCT *oscMemory, char *oscFile, char *stateFile){
+
+  ASSERTARGS(oscMemory && oscFile && stateFile);
+
+  int      result;
+  SEQ_NUM  seq;
+  char     seqStr[SEQ_STR_SIZE];
+
+  if(! isGzipComplete(oscMemory->memory, oscMemory->size)){
+    fprintf(stderr, "%s: Error downloaded change file is not complete gzip data: <%s>\n", progName, oscFile);
+    logMessage(fLogPtr, "Error downloaded change file is not complete gzip data; file below:");
+    logMessageLevel(fLogPtr, LOG_ERROR, oscFile);
+    return ztBadSizeDownload;
+  }
+
+  if(isStreamTee()){
+
+    result = memory2File(oscFile, oscMemory->memory, oscMemory->size);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed memory2File() for: <%s>\n", progName, oscFile);
+      logMessage(fLogPtr, "Error failed memory2File() for file below:");
+      logMessageLevel(fLogPtr, LOG_ERROR, oscFile);
+      return result;
+    }
+  }
 
+  result = streamWrite(oscMemory->memory, oscMemory->size, oscFile);
+  if(result != ztSuccess){
+    logMessage(fLogPtr, "Error failed streamWrite() for change file below:");
+    logMessageLevel(fLogPtr, LOG_ERROR, oscFile);
     return result;
   }
 
-  /* if they do NOT share parent entry, add end parentPath to list as SECOND element. **/
-  if(strcmp(startPP->parentPath, endPP->parentPath) != 0){
+  if(streamSeqFile){
 
-    newPath = STRDUP(endPP->parentPath);
+    result = path2Sequence(&seq, stateFile);
+    if(result == ztSuccess)
+      result = sequence2String(seqStr, sizeof(seqStr), seq);
 
-    result = insertNextDL(parentsList, DL_TAIL(parentsList), (void *) newPath);
-    if(result != ztSuccess){
-      fprintf(stderr, "%s: Error failed insertNextTo() function.\n", progName);
-      logMessage(fLogPtr, "Error failed insertNextTo() function.");
+    if(result == ztSuccess)
+      result = writeStartID(seqStr, streamSeqFile);
 
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed to update previous sequence file after streaming: <%s>\n",
+              progName, oscFile);
+      logMessage(fLogPtr, "Error failed to update previous sequence file after streaming file below:");
+      logMessageLevel(fLogPtr, LOG_ERROR, oscFile);
       return result;
     }
   }
 
-  ELEM *parentElem;
-  char *currentParent;
+  if(fVerbose)
+    fprintf(stdout, "%s: Streamed <%lu> bytes for: %s\n", progName, (unsigned long) oscMemory->size, oscFile);
 
-  ELEM *startElem;
-  ELEM *endElem;
-  ELEM *diffElem;
+  return ztSuccess;
 
-  char *filename;
-  char buffer[64] = {0};
-  char *newDiff;
+} /* END streamPair() **/
 
-  parentElem = DL_HEAD(parentsList);
+/* pairDone(): called by downloadFilesList() each time a change file and its
+ * state.txt file are both on local disk. Local filenames are full path.
+ *
+ ***************************************************************************/
 
-  while(parentElem){
+int pairDone(const char *oscFile, const char *stateFile){
 
-    currentParent = (char *) DL_DATA(parentElem);
+  ASSERTARGS(oscFile && stateFile);
 
-    childrenList = initialStringList();
-    if(!childrenList){
-      fprintf(stderr, "%s: Error failed initialStringList().\n", progName);
-      logMessage(fLogPtr, "Error failed initialStringList().");
+  int  result;
 
-      return ztMemoryAllocate;
+  if(isSummarizing()){
+
+    result = summaryPair(oscFile);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed summaryPair().\n", progName);
+      logMessage(fLogPtr, "Error failed summaryPair().");
+      return result;
     }
+  }
 
-    result = getParentPage(childrenList, currentParent);
+  if(isExpiring()){
+
+    result = expirePair(oscFile);
     if(result != ztSuccess){
-      fprintf(stderr, "%s: Error failed getParentPage() function.\n", progName);
-      logMessage(fLogPtr, "Error failed getParentPage() function.");
+      fprintf(stderr, "%s: Error failed expirePair().\n", progName);
+      logMessage(fLogPtr, "Error failed expirePair().");
+      return result;
+    }
+  }
 
+  if(isIndexing()){
+
+    result = indexPair(oscFile);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed indexPair().\n", progName);
+      logMessage(fLogPtr, "Error failed indexPair().");
       return result;
     }
+  }
 
-    char logStr[1024] = {0};
+  /* transcode job sends event when zstd file is ready **/
+  if(isTranscoding())
 
-    fprintf(stdout, "%s: Retrieved childrenList from remote server with size: %d\n", progName, DL_SIZE(childrenList));
-    sprintf(logStr, "Retrieved childrenList from remote server with size: %d", DL_SIZE(childrenList));
-    logMessage(fLogPtr, logStr);
-    /*
-      if(fVerbose){
-      fprintStringList(NULL, childrenList);
-      fprintStringList(fLogPtr, childrenList);
-      }
-    **/
-    if(parentElem == DL_HEAD(parentsList)){
-      startElem = findElemSubString(childrenList, startPP->fileEntry);
+    return transcodePair(oscFile, stateFile);
 
-      if(fUsingPreviousID){ /* start AFTER last one we downloaded **/
-        startElem = DL_NEXT(DL_NEXT(startElem));
-      }
-    }
-    else
-      startElem = DL_HEAD(childrenList);
+  result = emitPairEvent(oscFile, stateFile);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed emitPairEvent().\n", progName);
+    logMessage(fLogPtr, "Error failed emitPairEvent().");
+    return result;
+  }
 
-    if(parentElem == DL_TAIL(parentsList))
-      endElem = DL_NEXT(findElemSubString(childrenList, endPP->fileEntry)); // files are in pairs (.osc & .state.txt)
-    else
-      endElem = DL_TAIL(childrenList);
+  return ztSuccess;
 
-    diffElem = startElem;
-    while(diffElem){
+} /* END pairDone() **/
 
-      filename = (char *) DL_DATA(diffElem);
-      sprintf(buffer, "%s%s", currentParent, filename);
+/* commitPair(): journal entry for pair with local 'stateFile'; with pair
+ * publish the pair is appended to list file and 'previous.seq' is moved.
+ *
+ ***************************************************************************/
 
-      newDiff = STRDUP(buffer);
+static int commitPair(const char *stateFile){
 
-      result = insertNextDL(destList, DL_TAIL(destList), (void *) newDiff);
-      if(result != ztSuccess){
-        fprintf(stderr, "%s: Error failed insertNextDL().\n", progName);
-        logMessage(fLogPtr, "Error failed insertNextDL().");
-        return result;
-      }
+  ASSERTARGS(stateFile);
 
-      if(diffElem == endElem)
-        break;
+  int          result;
+  SEQ_NUM      seq;
+  char         seqPath[SEQ_PATH_SIZE];
+  char         seqStr[SEQ_STR_SIZE];
+  char         entry[64];
+  STRING_LIST  *pairList;
 
-      diffElem = DL_NEXT(diffElem);
-    }
+  if(! isJournalOn())
 
-    parentElem = DL_NEXT(parentElem);
+    return ztSuccess;
 
-  }/* end while(parentElem) **/
+  result = path2Sequence(&seq, stateFile);
+  if(result == ztSuccess)
+    result = journalPair(seq);
 
-  //TODO: cleanup
+  if(result != ztSuccess || ! pairPublish)
 
-  return ztSuccess;
+    return result;
 
-} /* END getDiffersList() **/
+  if(pairListFile){
 
+    pairList = initialStringList();
+    if(!pairList)
+      return ztMemoryAllocate;
 
-int downloadFilesList(STRING_LIST *completed, STRING_LIST *downloadList, char *localDestPrefix, int textOnly){
+    sequence2Path(seqPath, seq);
 
-  int    result;
-  ELEM   *elem;
-  char   *filename;
-  char   *pathSuffix;
-  char   localFilename[1024];
+    sprintf(entry, "%s%s", seqPath, CHANGE_EXT);
+    result = insertNextDL(pairList, DL_TAIL(pairList), (void *) STRDUP(entry));
 
-  int    iCount = 0;
-  int    sleepSeconds = 0;
+    sprintf(entry, "%s%s", seqPath, STATE_EXT);
+    if(result == ztSuccess)
+      result = insertNextDL(pairList, DL_TAIL(pairList), (void *) STRDUP(entry));
 
-  ASSERTARGS(completed && downloadList && localDestPrefix);
+    if(result == ztSuccess && pairGranularity)
+      result = prependGranularity(&pairList, pairGranularity);
 
-  /* completed: filename is inserted once download is completed successfully
-   * the list should be empty. caller initials list.
-   */
+    if(result == ztSuccess)
+      result = writeNewerFiles(pairListFile, pairList);
 
-  elem = DL_HEAD(downloadList);
-  while(elem){
+    zapStringList((void **) &pairList);
 
-    pathSuffix = (char *)DL_DATA(elem);
-    filename = lastOfPath(pathSuffix);
+    if(result != ztSuccess){
+      logMessage(fLogPtr, "Error failed to append committed pair to list file below:");
+      logMessageLevel(fLogPtr, LOG_ERROR, pairListFile);
+      return result;
+    }
+  }
 
-    if(textOnly && ! strstr(filename, ".state.txt")){
-      elem = DL_NEXT(elem);
-      continue;
+  if(pairSeqFile){
+
+    result = sequence2String(seqStr, sizeof(seqStr), seq);
+    if(result == ztSuccess)
+      result = writeStartID(seqStr, pairSeqFile);
+
+    if(result != ztSuccess){
+      logMessage(fLogPtr, "Error failed to update previous sequence file for committed pair.");
+      return result;
     }
+  }
 
-    iCount++;
+  return journalPublished(seq);
 
-    /* no delay for first 12 files **/
-    if(iCount < 11)
-      sleepSeconds = SLEEP_INTERVAL;
+} /* END commitPair() **/
 
-    /* increment sleep time after each 7 (had 4 before) files **/
-    else if( (iCount % 7) == 0 )
-      sleepSeconds += SLEEP_INTERVAL;
-      //sleepSeconds = SLEEP_INTERVAL;
+/* dropPublished(): pairs listed by interrupted run of same range are
+ * removed from download 'list'.
+ *
+ ***************************************************************************/
 
-    else ;
+static int dropPublished(STRING_LIST *list){
 
-    memset(localFilename, 0, sizeof(localFilename));
-    if(SLASH_ENDING(localDestPrefix))
-      sprintf(localFilename, "%s%s", localDestPrefix, pathSuffix + 1); // (pathSuffix + 1) skip FIRST slash in path
-    else
-      sprintf(localFilename, "%s/%s", localDestPrefix, pathSuffix + 1);
+  ASSERTARGS(list);
 
-    /* wait before next download **/
-    sleep(sleepSeconds);
+  ELEM     *elem, *next;
+  char     *data;
+  SEQ_NUM  seq;
+  int      dropped = 0;
 
-    result = myDownload(pathSuffix, localFilename);
-    if(result == ztSuccess){
-      /* each list must have its own copy of data; this is
-       * so zapString() does not free same pointer again. **/
+  elem = DL_HEAD(list);
+  while(elem){
 
-      char *pathSuffixCopy;
-      pathSuffixCopy = STRDUP(pathSuffix);
+    next = DL_NEXT(elem);
 
-      insertNextDL(completed, DL_TAIL(completed), (void *) pathSuffixCopy); //(void **) pathSuffixCopy);
-    }
-    else{
-      fprintf(stderr, "%s: Error failed myDownload() function for localFilename: <%s>\n",
-              progName, localFilename);
-      char logBuff[2048] = {0};
-      sprintf(logBuff, "Error failed myDownload() function for localFilename: <%s>\n", localFilename);
-      logMessage(fLogPtr, logBuff);
-      return result;
+    if(path2Sequence(&seq, (char *) DL_DATA(elem)) == ztSuccess && isPairPublished(seq)){
+
+      if(removeDL(list, elem, (void **) &data) != ztSuccess)
+        return ztUnknownError;
+
+      free(data);
+      dropped++;
     }
 
-    /* file sizes are checked in download2File() function **/
+    elem = next;
+  }
 
-    elem = DL_NEXT(elem);
+  if(dropped){
+    fprintf(stdout, "%s: Skipping <%d> files listed by interrupted run of same range.\n", progName, dropped);
+    logMessage(fLogPtr, "Skipping files listed by interrupted run of same range.");
   }
 
   return ztSuccess;
 
-} /* END downloadFilesList() **/
+} /* END dropPublished() **/
+
+static void onStopSignal(int signum){
+
+  (void) signum;
+
+  stopRequest = 1;
+
+} /* END onStopSignal() **/
 
 int getParentPage(STRING_LIST *destList, char *parentSuffix){
 
@@ -2344,9 +4556,14 @@ int prependGranularity(STRING_LIST **list, char *gString){
  * https://download.geofabrik.de/asia/india-updates/
  * https://download.geofabrik.de/europe/france-updates/
  *
+ * a mirror from "getdiff --serve" has any server; first entry in its path
+ * is upstream server name, rest is upstream path:
+ *
+ * http://mirror:8080/planet.openstreetmap.org/replication/minute/
+ *
  **************************************************************/
 
-int isSourceSupported(char const *source, const CURLU *cParseHandle){
+int isSourceSupported(char const *source, CURLU *cParseHandle){
 
   CURLUcode   curluCode;
   CURLU *localHandle;
@@ -2359,6 +4576,10 @@ int isSourceSupported(char const *source, const CURLU *cParseHandle){
   char *host = NULL;
   char *path = NULL;
 
+  char *server;      // upstream server and path; differ from above for mirror
+  char *serverPath;
+  char mirrorServer[PATH_MAX] = {0};
+
   ASSERTARGS(source && cParseHandle);
 
   localHandle = curl_url_dup(cParseHandle); /* clone parser handle! */
@@ -2427,7 +4648,23 @@ int isSourceSupported(char const *source, const CURLU *cParseHandle){
     return ztInvalidArg;
   }
 
-  if( ! isSupportedServer(host)){
+  server = host;
+  serverPath = path;
+
+  if( ! isSupportedServer(host) && path[0] == '/' && strchr(path + 1, '/')){
+
+    size_t length = strchr(path + 1, '/') - (path + 1);
+
+    if(length < sizeof(mirrorServer)){
+      memcpy(mirrorServer, path + 1, length);
+      if(isSupportedServer(mirrorServer)){
+        server = mirrorServer;
+        serverPath = path + 1 + length;
+      }
+    }
+  }
+
+  if( ! isSupportedServer(server)){
     fprintf(stderr, "%s: Error unsupported 'server' in source; server: <%s>\n", progName, host);
 
     curl_free(scheme);
@@ -2439,7 +4676,7 @@ int isSourceSupported(char const *source, const CURLU *cParseHandle){
     return ztInvalidArg;
   }
 
-  if(strstr(host, "planet") && ! isPlanetPath(path)){
+  if(strstr(server, "planet") && ! isPlanetPath(serverPath)){
     fprintf(stderr, "%s: Error invalid 'path' for server: <%s>; path: <%s>\n", progName, host, path);
 
     curl_free(scheme);
@@ -2451,7 +4688,7 @@ int isSourceSupported(char const *source, const CURLU *cParseHandle){
     return ztInvalidArg;
   }
 
-  if(strstr(host, "geofabrik") && ! isGeofabrikPath(path)){
+  if(strstr(server, "geofabrik") && ! isGeofabrikPath(serverPath)){
     fprintf(stderr, "%s: Error invalid 'path' for server: <%s>; path: <%s>\n", progName, host, path);
 
     curl_free(scheme);
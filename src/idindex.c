@@ -0,0 +1,1231 @@
+/*
+ * idindex.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * object id index; see idindex.h.
+ *
+ * jobs read one change file each and add (key, sequence) pairs to run array
+ * under a lock; a job that finds run array over INDEX_FLUSH_PAIRS takes it
+ * and writes it as a segment so a long catch up run does not hold all pairs
+ * in memory. finishIndex() writes what is left, then merges segments from
+ * main thread.
+ *
+ * segment file:
+ *
+ *   header         SEGMENT_HEADER
+ *   blocks         per key: varint key delta (first key in block is delta
+ *                  from zero), varint count, varint first sequence then
+ *                  varint sequence deltas
+ *   block index    numBlocks BLOCK_ENTRY; first key and file offset
+ *
+ * numbers are in machine byte order; index is local to this machine.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "idindex.h"
+#include "workers.h"
+#include "util.h"
+#include "fileio.h"
+#include "ztError.h"
+#include "getdiff.h"
+#include "debug.h"
+
+#define SEGMENT_MAGIC      "GDIDX01"
+#define INDEX_FLUSH_PAIRS  (8 * 1024 * 1024)   /* 128MB of pairs **/
+#define MAX_VARINT         10
+
+typedef struct SEGMENT_HEADER_ {
+
+  char      magic[8];
+  uint32_t  numKeys;
+  uint32_t  numBlocks;
+  uint32_t  firstSeq;
+  uint32_t  lastSeq;
+  uint64_t  indexOffset;   /* block index; blocks end here **/
+
+} SEGMENT_HEADER;
+
+typedef struct BLOCK_ENTRY_ {
+
+  uint64_t  firstKey;
+  uint64_t  offset;
+
+} BLOCK_ENTRY;
+
+typedef struct INDEX_PAIR_ {
+
+  uint64_t  key;
+  SEQ_NUM   seq;
+
+} INDEX_PAIR;
+
+typedef struct PAIR_ARRAY_ {
+
+  INDEX_PAIR  *pairs;
+  size_t      count;
+  size_t      size;
+
+} PAIR_ARRAY;
+
+typedef struct SEGMENT_WRITER_ {
+
+  FILE            *filePtr;
+  char            partName[PATH_MAX];
+  char            fileName[PATH_MAX];
+
+  SEGMENT_HEADER  header;
+  BLOCK_ENTRY     *blocks;
+  size_t          blocksSize;
+  uint64_t        offset;
+  uint64_t        prevKey;
+
+} SEGMENT_WRITER;
+
+typedef struct SEGMENT_READER_ {
+
+  FILE            *filePtr;
+  SEGMENT_HEADER  header;
+  uint32_t        keysRead;
+
+  int             hasKey;   /* current entry below is good **/
+  uint64_t        key;
+  SEQ_NUM         *seqs;
+  size_t          count;
+  size_t          size;
+
+} SEGMENT_READER;
+
+typedef struct SEGMENT_FILE_ {
+
+  unsigned int  number;
+  off_t         size;
+
+} SEGMENT_FILE;
+
+static WORK_POOL        *indexPool = NULL;
+static char             indexDir[PATH_MAX];
+static PAIR_ARRAY       runPairs = {NULL, 0, 0};
+static long             runFiles = 0;
+static long             runSegments = 0;
+static unsigned int     nextSegment = 1;
+static pthread_mutex_t  pairsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static int indexJob(void *arg);
+static int writePairs(PAIR_ARRAY *array, unsigned int number);
+static int compactIndex(const char *dir, long *merged);
+static int mergeSegments(const char *dir, SEGMENT_FILE *files, int numFiles, unsigned int number);
+static int listSegments(SEGMENT_FILE **files, int *numFiles, const char *dir);
+static int segmentName(char *buffer, size_t size, const char *dir, unsigned int number);
+static int lookupSegment(SEQ_NUM **seqs, size_t *count, size_t *size, const char *segFile, uint64_t key);
+
+static int writerOpen(SEGMENT_WRITER *writer, const char *fileName);
+static int writerAdd(SEGMENT_WRITER *writer, uint64_t key, const SEQ_NUM *seqs, size_t count);
+static int writerClose(SEGMENT_WRITER *writer, int keep);
+static int readerOpen(SEGMENT_READER *reader, const char *fileName);
+static int readerNext(SEGMENT_READER *reader);
+static void readerClose(SEGMENT_READER *reader);
+
+static int putVarint(FILE *filePtr, uint64_t value);
+static int getVarint(FILE *filePtr, uint64_t *value);
+static const unsigned char *decodeVarint(const unsigned char *ptr, const unsigned char *end, uint64_t *value);
+static int appendSeq(SEQ_NUM **seqs, size_t *count, size_t *size, SEQ_NUM seq);
+static size_t uniqueSeqs(SEQ_NUM *seqs, size_t count);
+static int comparePairs(const void *first, const void *second);
+static int compareSeqs(const void *first, const void *second);
+static int compareSegmentSize(const void *first, const void *second);
+
+/* startIndex(): 'prefix' is change files tree; makes index directory **/
+
+int startIndex(const char *prefix){
+
+  ASSERTARGS(prefix);
+
+  SEGMENT_FILE  *files = NULL;
+  int           numFiles = 0;
+  int           result;
+
+  if(snprintf(indexDir, sizeof(indexDir), "%s%s%s", prefix, SLASH_ENDING(prefix) ? "" : "/", INDEX_DIR) >= (int) sizeof(indexDir))
+    return ztFnameLong;
+
+  result = myMkDir(indexDir);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed making index directory: <%s>\n", progName, indexDir);
+    return result;
+  }
+
+  result = listSegments(&files, &numFiles, indexDir);
+  if(result != ztSuccess)
+    return result;
+
+  /* list is sorted by number **/
+  nextSegment = numFiles ? files[numFiles - 1].number + 1 : 1;
+  free(files);
+
+  indexPool = initialWorkPool(numCPUs() > 1 ? numCPUs() - 1 : 1, indexJob, free);
+  if(!indexPool){
+    fprintf(stderr, "%s: Error failed initialWorkPool().\n", progName);
+    return ztFailedSysCall;
+  }
+
+  runFiles = 0;
+  runSegments = 0;
+
+  return ztSuccess;
+
+} /* END startIndex() **/
+
+int isIndexing(void){
+
+  return (indexPool != NULL);
+
+} /* END isIndexing() **/
+
+int indexPair(const char *oscFile){
+
+  ASSERTARGS(oscFile);
+
+  char  *arg;
+  int   result;
+
+  arg = STRDUP(oscFile);
+
+  result = submitWork(indexPool, arg);
+  if(result != ztSuccess)
+    free(arg);
+
+  return result;
+
+} /* END indexPair() **/
+
+/* finishIndex(): waits for queued files, writes last segment and merges
+ * segments when there are too many; returns first failure.
+ **************************************************************************/
+
+int finishIndex(void){
+
+  char  buffer[PATH_MAX + 128];
+  long  merged = 0;
+  int   result;
+
+  if(!indexPool)
+    return ztSuccess;
+
+  result = finishWorkPool(&indexPool);
+
+  if(result == ztSuccess && runPairs.count){
+
+    result = writePairs(&runPairs, nextSegment++);
+    if(result == ztSuccess)
+      runSegments++;
+  }
+
+  free(runPairs.pairs);
+  memset(&runPairs, 0, sizeof(PAIR_ARRAY));
+
+  if(result == ztSuccess)
+    result = compactIndex(indexDir, &merged);
+
+  if(result != ztSuccess)
+    return result;
+
+  if(!runFiles)
+    return ztSuccess;
+
+  snprintf(buffer, sizeof(buffer), "Indexed %ld change files into %ld new segments; merged %ld segments in: %s",
+           runFiles, runSegments, merged, indexDir);
+  logMessage(fLogPtr, buffer);
+
+  if(fVerbose)
+    fprintf(stdout, "%s: %s\n", progName, buffer);
+
+  return ztSuccess;
+
+} /* END finishIndex() **/
+
+/* lookupIndex(): sequence numbers for 'key' from all segments, sorted and
+ * without duplicates in allocated '*seqs' - caller frees. No index or no
+ * match sets '*count' to zero.
+ **************************************************************************/
+
+int lookupIndex(SEQ_NUM **seqs, size_t *count, const char *prefix, uint64_t key){
+
+  ASSERTARGS(seqs && count && prefix);
+
+  SEGMENT_FILE  *files = NULL;
+  char          dir[PATH_MAX], segFile[PATH_MAX];
+  size_t        size = 0;
+  int           numFiles = 0;
+  int           index;
+  int           result;
+
+  *seqs = NULL;
+  *count = 0;
+
+  if(snprintf(dir, sizeof(dir), "%s%s%s", prefix, SLASH_ENDING(prefix) ? "" : "/", INDEX_DIR) >= (int) sizeof(dir))
+    return ztFnameLong;
+
+  if(! isPathDirectory(dir))
+    return ztSuccess;
+
+  result = listSegments(&files, &numFiles, dir);
+  if(result != ztSuccess)
+    return result;
+
+  for(index = 0; index < numFiles && result == ztSuccess; index++){
+
+    result = segmentName(segFile, sizeof(segFile), dir, files[index].number);
+    if(result == ztSuccess)
+      result = lookupSegment(seqs, count, &size, segFile, key);
+  }
+
+  free(files);
+
+  if(result != ztSuccess){
+    free(*seqs);
+    *seqs = NULL;
+    *count = 0;
+    return result;
+  }
+
+  /* segments may overlap after a crash during merge **/
+  *count = uniqueSeqs(*seqs, *count);
+
+  return ztSuccess;
+
+} /* END lookupIndex() **/
+
+/* string2IndexKey(): "way/123" or "w123"; node, way or relation **/
+
+int string2IndexKey(uint64_t *key, const char *string){
+
+  ASSERTARGS(key && string);
+
+  static const char *names[] = {"node/", "way/", "relation/"};
+
+  OSC_TYPE   type;
+  char       *endPtr;
+  long long  id;
+  int        found = 0;
+
+  for(type = OSC_NODE; type <= OSC_RELATION; type++){
+
+    if(strncmp(string, names[type], strlen(names[type])) == 0){
+      string += strlen(names[type]);
+      found = 1;
+      break;
+    }
+
+    if(string[0] == names[type][0] && string[1] >= '0' && string[1] <= '9'){
+      string++;
+      found = 1;
+      break;
+    }
+  }
+
+  if(!found || *string < '0' || *string > '9')
+    return ztInvalidArg;
+
+  errno = 0;
+  id = strtoll(string, &endPtr, 10);
+  if(errno || *endPtr != '\0' || id <= 0 || id > (LLONG_MAX >> 2))
+    return ztInvalidArg;
+
+  *key = INDEX_KEY(type, id);
+
+  return ztSuccess;
+
+} /* END string2IndexKey() **/
+
+/* indexJob(): 'arg' is change file name **/
+
+static int indexJob(void *arg){
+
+  char         *oscFile = (char *) arg;
+  OSC_READER   *reader;
+  OSC_ELEMENT  element;
+  PAIR_ARRAY   flush = {NULL, 0, 0};
+  INDEX_PAIR   *newPairs;
+  uint64_t     *keys = NULL, *newKeys;
+  size_t       count = 0, size = 0, index, kept, newSize;
+  unsigned int number = 0;
+  SEQ_NUM      seq;
+  int          result;
+
+  if(path2Sequence(&seq, oscFile) != ztSuccess){
+    fprintf(stderr, "%s: Error change file name has no sequence number: <%s>\n", progName, oscFile);
+    return ztInvalidArg;
+  }
+
+  reader = oscOpen(oscFile);
+  if(!reader){
+    fprintf(stderr, "%s: Error failed oscOpen() for: <%s>\n", progName, oscFile);
+    return ztOpenFileError;
+  }
+
+  while((result = oscNext(reader, &element)) == ztSuccess){
+
+    if(element.id <= 0 || element.id > (LLONG_MAX >> 2))
+      continue;
+
+    if(count == size){
+
+      newSize = size ? size * 2 : 4096;
+
+      newKeys = (uint64_t *) realloc(keys, newSize * sizeof(uint64_t));
+      if(!newKeys){
+        result = ztMemoryAllocate;
+        break;
+      }
+
+      keys = newKeys;
+      size = newSize;
+    }
+
+    keys[count++] = INDEX_KEY(element.type, element.id);
+  }
+
+  oscClose(&reader);
+
+  if(result != ztEndOfFile){
+    fprintf(stderr, "%s: Error failed reading change file: <%s>\n", progName, oscFile);
+    free(keys);
+    return (result == ztSuccess) ? ztUnknownError : result;
+  }
+
+  /* object may have more than one version in a change file **/
+  if(count > 1){
+
+    qsort(keys, count, sizeof(uint64_t), compareUint64);
+
+    for(index = 1, kept = 1; index < count; index++)
+      if(keys[index] != keys[kept - 1])
+        keys[kept++] = keys[index];
+
+    count = kept;
+  }
+
+  result = ztSuccess;
+
+  pthread_mutex_lock(&pairsLock);
+
+  if(runPairs.count + count > runPairs.size){
+
+    newSize = runPairs.size ? runPairs.size : 65536;
+    while(newSize < runPairs.count + count)
+      newSize *= 2;
+
+    newPairs = (INDEX_PAIR *) realloc(runPairs.pairs, newSize * sizeof(INDEX_PAIR));
+    if(newPairs){
+      runPairs.pairs = newPairs;
+      runPairs.size = newSize;
+    }
+    else
+      result = ztMemoryAllocate;
+  }
+
+  if(result == ztSuccess){
+
+    for(index = 0; index < count; index++){
+      runPairs.pairs[runPairs.count].key = keys[index];
+      runPairs.pairs[runPairs.count].seq = seq;
+      runPairs.count++;
+    }
+
+    runFiles++;
+
+    /* take full array; segment is written outside the lock **/
+    if(runPairs.count >= INDEX_FLUSH_PAIRS){
+      flush = runPairs;
+      memset(&runPairs, 0, sizeof(PAIR_ARRAY));
+      number = nextSegment++;
+    }
+  }
+
+  pthread_mutex_unlock(&pairsLock);
+
+  free(keys);
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error allocating memory in indexJob().\n", progName);
+    return result;
+  }
+
+  if(flush.count){
+
+    result = writePairs(&flush, number);
+    free(flush.pairs);
+
+    if(result == ztSuccess){
+      pthread_mutex_lock(&pairsLock);
+      runSegments++;
+      pthread_mutex_unlock(&pairsLock);
+    }
+  }
+
+  return result;
+
+} /* END indexJob() **/
+
+/* writePairs(): sorts 'array' and writes it as segment 'number' **/
+
+static int writePairs(PAIR_ARRAY *array, unsigned int number){
+
+  SEGMENT_WRITER  writer;
+  SEQ_NUM         *seqs = NULL;
+  char            fileName[PATH_MAX];
+  size_t          count = 0, size = 0, index;
+  int             result;
+
+  result = segmentName(fileName, sizeof(fileName), indexDir, number);
+  if(result != ztSuccess)
+    return result;
+
+  qsort(array->pairs, array->count, sizeof(INDEX_PAIR), comparePairs);
+
+  result = writerOpen(&writer, fileName);
+  if(result != ztSuccess)
+    return result;
+
+  for(index = 0; index < array->count && result == ztSuccess; index++){
+
+    /* same file may come twice; sorted so check last one only **/
+    if(!count || seqs[count - 1] != array->pairs[index].seq)
+      result = appendSeq(&seqs, &count, &size, array->pairs[index].seq);
+
+    if(result == ztSuccess && (index + 1 == array->count || array->pairs[index + 1].key != array->pairs[index].key)){
+      result = writerAdd(&writer, array->pairs[index].key, seqs, count);
+      count = 0;
+    }
+  }
+
+  free(seqs);
+
+  if(result != ztSuccess){
+    writerClose(&writer, 0);
+    return result;
+  }
+
+  return writerClose(&writer, 1);
+
+} /* END writePairs() **/
+
+/* compactIndex(): more than INDEX_MAX_SEGMENTS segments; smallest segments
+ * are merged into one - keep adding next smallest while it is not more than
+ * twice what is taken so far, so large segments are rewritten rarely.
+ **************************************************************************/
+
+static int compactIndex(const char *dir, long *merged){
+
+  SEGMENT_FILE  *files = NULL;
+  off_t         total;
+  int           numFiles = 0;
+  int           take;
+  int           result;
+
+  *merged = 0;
+
+  result = listSegments(&files, &numFiles, dir);
+  if(result != ztSuccess)
+    return result;
+
+  if(numFiles <= INDEX_MAX_SEGMENTS){
+    free(files);
+    return ztSuccess;
+  }
+
+  qsort(files, (size_t) numFiles, sizeof(SEGMENT_FILE), compareSegmentSize);
+
+  total = files[0].size + files[1].size;
+  take = 2;
+
+  while(take < numFiles && (take <= numFiles - INDEX_MAX_SEGMENTS || files[take].size <= 2 * total)){
+    total += files[take].size;
+    take++;
+  }
+
+  result = mergeSegments(dir, files, take, nextSegment++);
+  if(result == ztSuccess)
+    *merged = take;
+
+  free(files);
+
+  return result;
+
+} /* END compactIndex() **/
+
+/* mergeSegments(): k way merge of 'files' into segment 'number'; merged
+ * files are removed after new segment is in place.
+ **************************************************************************/
+
+static int mergeSegments(const char *dir, SEGMENT_FILE *files, int numFiles, unsigned int number){
+
+  SEGMENT_READER  *readers;
+  SEGMENT_WRITER  writer;
+  SEQ_NUM         *seqs = NULL;
+  char            fileName[PATH_MAX];
+  size_t          count = 0, size = 0, index;
+  uint64_t        key;
+  int             active, numOpen = 0;
+  int             result;
+
+  readers = (SEGMENT_READER *) calloc((size_t) numFiles, sizeof(SEGMENT_READER));
+  if(!readers)
+    return ztMemoryAllocate;
+
+  result = ztSuccess;
+
+  for(numOpen = 0; numOpen < numFiles && result == ztSuccess; numOpen++){
+
+    result = segmentName(fileName, sizeof(fileName), dir, files[numOpen].number);
+    if(result == ztSuccess)
+      result = readerOpen(&readers[numOpen], fileName);
+    if(result != ztSuccess)
+      break;
+  }
+
+  if(result == ztSuccess)
+    result = segmentName(fileName, sizeof(fileName), dir, number);
+
+  if(result == ztSuccess)
+    result = writerOpen(&writer, fileName);
+
+  if(result != ztSuccess){
+    while(numOpen--)
+      readerClose(&readers[numOpen]);
+    free(readers);
+    return result;
+  }
+
+  while(result == ztSuccess){
+
+    active = 0;
+    key = 0;
+
+    for(index = 0; index < (size_t) numFiles; index++)
+      if(readers[index].hasKey && (!active++ || readers[index].key < key))
+        key = readers[index].key;
+
+    if(!active)
+      break;
+
+    count = 0;
+
+    for(index = 0; index < (size_t) numFiles && result == ztSuccess; index++){
+
+      if(! readers[index].hasKey || readers[index].key != key)
+        continue;
+
+      for(size_t i = 0; i < readers[index].count && result == ztSuccess; i++)
+        result = appendSeq(&seqs, &count, &size, readers[index].seqs[i]);
+
+      if(result == ztSuccess)
+        result = readerNext(&readers[index]);
+    }
+
+    if(result != ztSuccess)
+      break;
+
+    if(numFiles > 1){
+      qsort(seqs, count, sizeof(SEQ_NUM), compareSeqs);
+      count = uniqueSeqs(seqs, count);
+    }
+
+    result = writerAdd(&writer, key, seqs, count);
+  }
+
+  for(index = 0; index < (size_t) numFiles; index++)
+    readerClose(&readers[index]);
+
+  free(readers);
+  free(seqs);
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed merging index segments in: <%s>\n", progName, dir);
+    writerClose(&writer, 0);
+    return result;
+  }
+
+  result = writerClose(&writer, 1);
+  if(result != ztSuccess)
+    return result;
+
+  for(index = 0; index < (size_t) numFiles; index++){
+
+    if(segmentName(fileName, sizeof(fileName), dir, files[index].number) == ztSuccess)
+      removeFile(fileName);
+  }
+
+  return ztSuccess;
+
+} /* END mergeSegments() **/
+
+/* listSegments(): segment files in 'dir' sorted by number; '*files' is
+ * allocated - caller frees.
+ **************************************************************************/
+
+static int listSegments(SEGMENT_FILE **files, int *numFiles, const char *dir){
+
+  DIR            *dirPtr;
+  struct dirent  *entry;
+  struct stat    status;
+  SEGMENT_FILE   *list = NULL, *newList;
+  char           fileName[PATH_MAX];
+  char           *endPtr;
+  unsigned long  number;
+  int            count = 0, size = 0;
+  int            index, inner;
+  int            result = ztSuccess;
+
+  *files = NULL;
+  *numFiles = 0;
+
+  dirPtr = opendir(dir);
+  if(!dirPtr){
+    fprintf(stderr, "%s: Error failed opendir() for <%s>: %s\n", progName, dir, strerror(errno));
+    return ztInaccessibleDir;
+  }
+
+  while((entry = readdir(dirPtr))){
+
+    if(entry->d_name[0] < '0' || entry->d_name[0] > '9')
+      continue;
+
+    number = strtoul(entry->d_name, &endPtr, 10);
+    if(strcmp(endPtr, INDEX_EXT) != 0 || number == 0 || number > UINT_MAX)
+      continue;
+
+    if(segmentName(fileName, sizeof(fileName), dir, (unsigned int) number) != ztSuccess ||
+       stat(fileName, &status) != 0)
+      continue;
+
+    if(count == size){
+
+      size = size ? size * 2 : 16;
+
+      newList = (SEGMENT_FILE *) realloc(list, (size_t) size * sizeof(SEGMENT_FILE));
+      if(!newList){
+        result = ztMemoryAllocate;
+        break;
+      }
+
+      list = newList;
+    }
+
+    list[count].number = (unsigned int) number;
+    list[count].size = status.st_size;
+    count++;
+  }
+
+  closedir(dirPtr);
+
+  if(result != ztSuccess){
+    free(list);
+    return result;
+  }
+
+  /* few files; insertion sort **/
+  for(index = 1; index < count; index++){
+
+    SEGMENT_FILE  item = list[index];
+
+    for(inner = index; inner > 0 && list[inner - 1].number > item.number; inner--)
+      list[inner] = list[inner - 1];
+
+    list[inner] = item;
+  }
+
+  *files = list;
+  *numFiles = count;
+
+  return ztSuccess;
+
+} /* END listSegments() **/
+
+static int segmentName(char *buffer, size_t size, const char *dir, unsigned int number){
+
+  if(snprintf(buffer, size, "%s/%08u%s", dir, number, INDEX_EXT) >= (int) size)
+    return ztFnameLong;
+
+  return ztSuccess;
+
+} /* END segmentName() **/
+
+/* lookupSegment(): binary search on block index then one block read;
+ * appends matches to '*seqs'.
+ **************************************************************************/
+
+static int lookupSegment(SEQ_NUM **seqs, size_t *count, size_t *size, const char *segFile, uint64_t key){
+
+  SEGMENT_HEADER       header;
+  BLOCK_ENTRY          entry;
+  unsigned char        *block;
+  const unsigned char  *ptr, *end;
+  uint64_t             value, keyNow = 0, numSeqs, seq;
+  uint64_t             low, high, middle, blockEnd;
+  int                  fd;
+  int                  result = ztSuccess;
+
+  fd = open(segFile, O_RDONLY);
+  if(fd < 0){
+    fprintf(stderr, "%s: Error failed open() for <%s>: %s\n", progName, segFile, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  if(pread(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header) ||
+     memcmp(header.magic, SEGMENT_MAGIC, sizeof(header.magic)) != 0){
+    fprintf(stderr, "%s: Error not an index segment: <%s>\n", progName, segFile);
+    close(fd);
+    return ztMalformedFile;
+  }
+
+  if(!header.numBlocks){
+    close(fd);
+    return ztSuccess;
+  }
+
+  /* last block with first key not after 'key' **/
+  low = 0;
+  high = header.numBlocks;
+
+  while(high - low > 1){
+
+    middle = low + (high - low) / 2;
+
+    if(pread(fd, &entry, sizeof(entry), (off_t) (header.indexOffset + middle * sizeof(entry))) != (ssize_t) sizeof(entry)){
+      close(fd);
+      return ztMalformedFile;
+    }
+
+    if(entry.firstKey <= key)
+      low = middle;
+    else
+      high = middle;
+  }
+
+  if(pread(fd, &entry, sizeof(entry), (off_t) (header.indexOffset + low * sizeof(entry))) != (ssize_t) sizeof(entry)){
+    close(fd);
+    return ztMalformedFile;
+  }
+
+  if(entry.firstKey > key){
+    close(fd);
+    return ztSuccess;
+  }
+
+  blockEnd = header.indexOffset;
+
+  if(low + 1 < header.numBlocks){
+
+    BLOCK_ENTRY  next;
+
+    if(pread(fd, &next, sizeof(next), (off_t) (header.indexOffset + (low + 1) * sizeof(next))) != (ssize_t) sizeof(next)){
+      close(fd);
+      return ztMalformedFile;
+    }
+
+    blockEnd = next.offset;
+  }
+
+  if(blockEnd <= entry.offset){
+    close(fd);
+    return ztMalformedFile;
+  }
+
+  block = (unsigned char *) malloc((size_t) (blockEnd - entry.offset));
+  if(!block){
+    close(fd);
+    return ztMemoryAllocate;
+  }
+
+  if(pread(fd, block, (size_t) (blockEnd - entry.offset), (off_t) entry.offset) != (ssize_t) (blockEnd - entry.offset)){
+    free(block);
+    close(fd);
+    return ztMalformedFile;
+  }
+
+  close(fd);
+
+  ptr = block;
+  end = block + (blockEnd - entry.offset);
+
+  while(ptr < end && result == ztSuccess){
+
+    if(!(ptr = decodeVarint(ptr, end, &value)))
+      break;
+    keyNow += value;
+
+    if(!(ptr = decodeVarint(ptr, end, &numSeqs)))
+      break;
+
+    seq = 0;
+
+    for(uint64_t i = 0; i < numSeqs && ptr && result == ztSuccess; i++){
+
+      if(!(ptr = decodeVarint(ptr, end, &value)))
+        break;
+      seq += value;
+
+      if(keyNow == key)
+        result = appendSeq(seqs, count, size, (SEQ_NUM) seq);
+    }
+
+    if(!ptr || keyNow >= key)
+      break;
+  }
+
+  free(block);
+
+  if(result == ztSuccess && !ptr){
+    fprintf(stderr, "%s: Error corrupt block in index segment: <%s>\n", progName, segFile);
+    result = ztMalformedFile;
+  }
+
+  return result;
+
+} /* END lookupSegment() **/
+
+static int writerOpen(SEGMENT_WRITER *writer, const char *fileName){
+
+  memset(writer, 0, sizeof(SEGMENT_WRITER));
+
+  if(snprintf(writer->fileName, sizeof(writer->fileName), "%s", fileName) >= (int) sizeof(writer->fileName) ||
+     snprintf(writer->partName, sizeof(writer->partName), "%s.part", fileName) >= (int) sizeof(writer->partName))
+    return ztFnameLong;
+
+  errno = 0;
+  writer->filePtr = fopen(writer->partName, "w");
+  if(!writer->filePtr){
+    fprintf(stderr, "%s: Error failed fopen() for <%s>: %s\n", progName, writer->partName, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  memcpy(writer->header.magic, SEGMENT_MAGIC, sizeof(writer->header.magic));
+
+  /* place holder; written again on close **/
+  if(fwrite(&writer->header, sizeof(SEGMENT_HEADER), 1, writer->filePtr) != 1){
+    fclose(writer->filePtr);
+    removeFile(writer->partName);
+    return ztWriteError;
+  }
+
+  writer->offset = sizeof(SEGMENT_HEADER);
+
+  return ztSuccess;
+
+} /* END writerOpen() **/
+
+/* writerAdd(): keys in ascending order; 'seqs' sorted, no duplicates **/
+
+static int writerAdd(SEGMENT_WRITER *writer, uint64_t key, const SEQ_NUM *seqs, size_t count){
+
+  BLOCK_ENTRY  *newBlocks;
+  size_t       newSize, index;
+  int          bytes;
+
+  if(!count)
+    return ztSuccess;
+
+  if(writer->header.numKeys % INDEX_BLOCK_KEYS == 0){
+
+    if(writer->header.numBlocks == writer->blocksSize){
+
+      newSize = writer->blocksSize ? writer->blocksSize * 2 : 1024;
+
+      newBlocks = (BLOCK_ENTRY *) realloc(writer->blocks, newSize * sizeof(BLOCK_ENTRY));
+      if(!newBlocks)
+        return ztMemoryAllocate;
+
+      writer->blocks = newBlocks;
+      writer->blocksSize = newSize;
+    }
+
+    writer->blocks[writer->header.numBlocks].firstKey = key;
+    writer->blocks[writer->header.numBlocks].offset = writer->offset;
+    writer->header.numBlocks++;
+    writer->prevKey = 0;
+  }
+
+  bytes = putVarint(writer->filePtr, key - writer->prevKey);
+  bytes += putVarint(writer->filePtr, count);
+  bytes += putVarint(writer->filePtr, seqs[0]);
+
+  for(index = 1; index < count; index++)
+    bytes += putVarint(writer->filePtr, seqs[index] - seqs[index - 1]);
+
+  if(ferror(writer->filePtr))
+    return ztWriteError;
+
+  writer->offset += (uint64_t) bytes;
+  writer->prevKey = key;
+  writer->header.numKeys++;
+
+  if(!writer->header.firstSeq || seqs[0] < writer->header.firstSeq)
+    writer->header.firstSeq = seqs[0];
+
+  if(seqs[count - 1] > writer->header.lastSeq)
+    writer->header.lastSeq = seqs[count - 1];
+
+  return ztSuccess;
+
+} /* END writerAdd() **/
+
+/* writerClose(): 'keep' FALSE drops partial file **/
+
+static int writerClose(SEGMENT_WRITER *writer, int keep){
+
+  int  result = ztSuccess;
+
+  if(keep){
+
+    writer->header.indexOffset = writer->offset;
+
+    if(writer->header.numBlocks &&
+       fwrite(writer->blocks, sizeof(BLOCK_ENTRY), writer->header.numBlocks, writer->filePtr) != writer->header.numBlocks)
+      result = ztWriteError;
+
+    if(result == ztSuccess &&
+       (fseek(writer->filePtr, 0L, SEEK_SET) != 0 ||
+        fwrite(&writer->header, sizeof(SEGMENT_HEADER), 1, writer->filePtr) != 1))
+      result = ztWriteError;
+  }
+
+  if(fclose(writer->filePtr) != 0)
+    result = ztWriteError;
+
+  free(writer->blocks);
+  writer->blocks = NULL;
+
+  if(keep && result == ztSuccess && rename(writer->partName, writer->fileName) != 0){
+    fprintf(stderr, "%s: Error failed rename() to <%s>: %s\n", progName, writer->fileName, strerror(errno));
+    result = ztFailedSysCall;
+  }
+
+  if(!keep || result != ztSuccess)
+    removeFile(writer->partName);
+
+  if(keep && result != ztSuccess)
+    fprintf(stderr, "%s: Error failed writing index segment: <%s>\n", progName, writer->fileName);
+
+  return result;
+
+} /* END writerClose() **/
+
+static int readerOpen(SEGMENT_READER *reader, const char *fileName){
+
+  memset(reader, 0, sizeof(SEGMENT_READER));
+
+  errno = 0;
+  reader->filePtr = fopen(fileName, "r");
+  if(!reader->filePtr){
+    fprintf(stderr, "%s: Error failed fopen() for <%s>: %s\n", progName, fileName, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  if(fread(&reader->header, sizeof(SEGMENT_HEADER), 1, reader->filePtr) != 1 ||
+     memcmp(reader->header.magic, SEGMENT_MAGIC, sizeof(reader->header.magic)) != 0){
+    fprintf(stderr, "%s: Error not an index segment: <%s>\n", progName, fileName);
+    readerClose(reader);
+    return ztMalformedFile;
+  }
+
+  return readerNext(reader);
+
+} /* END readerOpen() **/
+
+/* readerNext(): next entry in file order; clears 'hasKey' at end **/
+
+static int readerNext(SEGMENT_READER *reader){
+
+  uint64_t  value, numSeqs, seq = 0;
+  uint64_t  prevKey;
+  int       result;
+
+  reader->count = 0;
+
+  if(reader->keysRead == reader->header.numKeys){
+    reader->hasKey = 0;
+    return ztSuccess;
+  }
+
+  prevKey = (reader->keysRead % INDEX_BLOCK_KEYS == 0) ? 0 : reader->key;
+
+  if(getVarint(reader->filePtr, &value) != ztSuccess ||
+     getVarint(reader->filePtr, &numSeqs) != ztSuccess)
+    return ztMalformedFile;
+
+  reader->key = prevKey + value;
+
+  for(uint64_t i = 0; i < numSeqs; i++){
+
+    if(getVarint(reader->filePtr, &value) != ztSuccess)
+      return ztMalformedFile;
+
+    seq += value;
+
+    result = appendSeq(&reader->seqs, &reader->count, &reader->size, (SEQ_NUM) seq);
+    if(result != ztSuccess)
+      return result;
+  }
+
+  reader->keysRead++;
+  reader->hasKey = 1;
+
+  return ztSuccess;
+
+} /* END readerNext() **/
+
+static void readerClose(SEGMENT_READER *reader){
+
+  if(reader->filePtr)
+    fclose(reader->filePtr);
+
+  free(reader->seqs);
+
+  memset(reader, 0, sizeof(SEGMENT_READER));
+
+} /* END readerClose() **/
+
+/* putVarint(): 7 bits per byte, high bit set on all but last; returns bytes **/
+
+static int putVarint(FILE *filePtr, uint64_t value){
+
+  int  bytes = 1;
+
+  while(value >= 0x80){
+    putc((int) ((value & 0x7F) | 0x80), filePtr);
+    value >>= 7;
+    bytes++;
+  }
+
+  putc((int) value, filePtr);
+
+  return bytes;
+
+} /* END putVarint() **/
+
+static int getVarint(FILE *filePtr, uint64_t *value){
+
+  int  ch, shift;
+
+  *value = 0;
+
+  for(shift = 0; shift < 7 * MAX_VARINT; shift += 7){
+
+    ch = getc(filePtr);
+    if(ch == EOF)
+      return ztUnexpectedEOF;
+
+    *value |= (uint64_t) (ch & 0x7F) << shift;
+
+    if(!(ch & 0x80))
+      return ztSuccess;
+  }
+
+  return ztMalformedFile;
+
+} /* END getVarint() **/
+
+/* decodeVarint(): returns pointer after value, NULL when past 'end' **/
+
+static const unsigned char *decodeVarint(const unsigned char *ptr, const unsigned char *end, uint64_t *value){
+
+  int  shift;
+
+  *value = 0;
+
+  for(shift = 0; ptr < end && shift < 7 * MAX_VARINT; shift += 7, ptr++){
+
+    *value |= (uint64_t) (*ptr & 0x7F) << shift;
+
+    if(!(*ptr & 0x80))
+      return ptr + 1;
+  }
+
+  return NULL;
+
+} /* END decodeVarint() **/
+
+static int appendSeq(SEQ_NUM **seqs, size_t *count, size_t *size, SEQ_NUM seq){
+
+  SEQ_NUM  *newSeqs;
+  size_t   newSize;
+
+  if(*count == *size){
+
+    newSize = *size ? *size * 2 : 64;
+
+    newSeqs = (SEQ_NUM *) realloc(*seqs, newSize * sizeof(SEQ_NUM));
+    if(!newSeqs){
+      fprintf(stderr, "%s: Error allocating memory for sequence list.\n", progName);
+      return ztMemoryAllocate;
+    }
+
+    *seqs = newSeqs;
+    *size = newSize;
+  }
+
+  (*seqs)[(*count)++] = seq;
+
+  return ztSuccess;
+
+} /* END appendSeq() **/
+
+/* uniqueSeqs(): sorts and drops duplicates; returns new count **/
+
+static size_t uniqueSeqs(SEQ_NUM *seqs, size_t count){
+
+  size_t  index, kept;
+
+  if(count < 2)
+    return count;
+
+  qsort(seqs, count, sizeof(SEQ_NUM), compareSeqs);
+
+  for(index = 1, kept = 1; index < count; index++)
+    if(seqs[index] != seqs[kept - 1])
+      seqs[kept++] = seqs[index];
+
+  return kept;
+
+} /* END uniqueSeqs() **/
+
+static int comparePairs(const void *first, const void *second){
+
+  const INDEX_PAIR  *one = (const INDEX_PAIR *) first;
+  const INDEX_PAIR  *two = (const INDEX_PAIR *) second;
+
+  if(one->key != two->key)
+    return (one->key > two->key) - (one->key < two->key);
+
+  return (one->seq > two->seq) - (one->seq < two->seq);
+
+} /* END comparePairs() **/
+
+static int compareSeqs(const void *first, const void *second){
+
+  SEQ_NUM  one = *(const SEQ_NUM *) first;
+  SEQ_NUM  two = *(const SEQ_NUM *) second;
+
+  return (one > two) - (one < two);
+
+} /* END compareSeqs() **/
+
+static int compareSegmentSize(const void *first, const void *second){
+
+  const SEGMENT_FILE  *one = (const SEGMENT_FILE *) first;
+  const SEGMENT_FILE  *two = (const SEGMENT_FILE *) second;
+
+  return (one->size > two->size) - (one->size < two->size);
+
+} /* END compareSegmentSize() **/
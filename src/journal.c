@@ -0,0 +1,381 @@
+/*
+ * journal.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * pair commit journal; see journal.h.
+ *
+ * openJournal() reads journal left by last run, then replaces it - temporary
+ * file, fsync() and rename() - with new "B" record followed by records still
+ * good for this run: "P" records when last run did not end, its last "L"
+ * record too when it was same range. Records are appended from then on;
+ * journal is kept open until endJournal() or closeJournal().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "journal.h"
+#include "fileio.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+
+#define JOURNAL_LINE  64
+
+typedef struct SEQ_SET_ {
+
+  SEQ_NUM  *seqs;   /* in order **/
+  size_t   count;
+  size_t   size;
+
+} SEQ_SET;
+
+static int      journalFD = -1;
+static SEQ_SET  committed;
+static SEQ_NUM  published = SEQ_NONE;  /* last "L" record; earlier pairs too **/
+static size_t   resumed;
+
+static int readJournal(const char *name, int isRange, SEQ_NUM first, SEQ_NUM last);
+static int appendRecord(char type, SEQ_NUM seq);
+static int writeRecords(int fd, SEQ_SET *set);
+static int addSequence(SEQ_SET *set, SEQ_NUM seq);
+static int hasSequence(SEQ_SET *set, SEQ_NUM seq);
+static void zapSet(SEQ_SET *set);
+
+/* openJournal(): starts journal 'name' for this run; pairs committed by an
+ * unfinished run are kept - isPairCommitted() and isPairPublished() tell.
+ *
+ ***************************************************************************/
+
+int openJournal(const char *name, int isRange, SEQ_NUM first, SEQ_NUM last){
+
+  ASSERTARGS(name);
+
+  char  tmpName[PATH_MAX] = {0};
+  char  line[JOURNAL_LINE];
+  int   fd;
+  int   result;
+
+  closeJournal();
+
+  result = readJournal(name, isRange, first, last);
+  if(result != ztSuccess)
+
+    return result;
+
+  resumed = committed.count;
+
+  if(strlen(name) + 5 >= PATH_MAX){
+    fprintf(stderr, "%s: Error journal filename is too long.\n", progName);
+    return ztFnameLong;
+  }
+
+  sprintf(tmpName, "%s.tmp", name);
+
+  errno = 0;
+  fd = open(tmpName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if(fd < 0){
+    fprintf(stderr, "%s: Error failed open() for <%s>: %s\n", progName, tmpName, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  sprintf(line, "%c %c %u %u\n", JOURNAL_BEGIN, isRange ? 'r' : 'u', first, last);
+
+  result = (write(fd, line, strlen(line)) == (ssize_t) strlen(line)) ? ztSuccess : ztWriteError;
+
+  if(result == ztSuccess)
+    result = writeRecords(fd, &committed);
+
+  if(result == ztSuccess && published != SEQ_NONE){
+    sprintf(line, "%c %u\n", JOURNAL_PUBLISHED, published);
+    if(write(fd, line, strlen(line)) != (ssize_t) strlen(line))
+      result = ztWriteError;
+  }
+
+  if(result == ztSuccess && fsync(fd) != 0)
+    result = ztWriteError;
+
+  close(fd);
+
+  if(result == ztSuccess)
+    result = commitFile(tmpName, name);
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed writing journal file: <%s>\n", progName, name);
+    unlink(tmpName);
+    return result;
+  }
+
+  errno = 0;
+  journalFD = open(name, O_WRONLY | O_APPEND | O_CLOEXEC);
+  if(journalFD < 0){
+    fprintf(stderr, "%s: Error failed open() for <%s>: %s\n", progName, name, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  return ztSuccess;
+
+} /* END openJournal() **/
+
+int isJournalOn(void){
+
+  return (journalFD != -1);
+
+} /* END isJournalOn() **/
+
+/* journalResumed(): pairs committed by unfinished run; not downloaded again **/
+
+int journalResumed(void){
+
+  size_t  index;
+  int     count = 0;
+
+  for(index = 0; index < resumed && index < committed.count; index++)
+    if(! isPairPublished(committed.seqs[index]))
+      count++;
+
+  return count;
+
+} /* END journalResumed() **/
+
+int isPairCommitted(SEQ_NUM seq){
+
+  return hasSequence(&committed, seq);
+
+} /* END isPairCommitted() **/
+
+int isPairPublished(SEQ_NUM seq){
+
+  return (published != SEQ_NONE && seq <= published);
+
+} /* END isPairPublished() **/
+
+/* journalPair(): both files of pair 'seq' are renamed to final names **/
+
+int journalPair(SEQ_NUM seq){
+
+  int  result;
+
+  if(journalFD == -1 || hasSequence(&committed, seq))
+
+    return ztSuccess;
+
+  result = appendRecord(JOURNAL_PAIR, seq);
+  if(result == ztSuccess)
+    result = addSequence(&committed, seq);
+
+  return result;
+
+} /* END journalPair() **/
+
+/* journalPublished(): pair 'seq' - and all before it - are in list file **/
+
+int journalPublished(SEQ_NUM seq){
+
+  int  result;
+
+  if(journalFD == -1)
+
+    return ztSuccess;
+
+  result = appendRecord(JOURNAL_PUBLISHED, seq);
+  if(result == ztSuccess && seq > published)
+    published = seq;
+
+  return result;
+
+} /* END journalPublished() **/
+
+/* endJournal(): run finished; next run starts from nothing **/
+
+int endJournal(void){
+
+  int  result;
+
+  if(journalFD == -1)
+
+    return ztSuccess;
+
+  result = appendRecord(JOURNAL_END, SEQ_NONE);
+
+  closeJournal();
+
+  return result;
+
+} /* END endJournal() **/
+
+/* closeJournal(): without "E" record; next run resumes **/
+
+void closeJournal(void){
+
+  if(journalFD != -1){
+    close(journalFD);
+    journalFD = -1;
+  }
+
+  zapSet(&committed);
+  published = SEQ_NONE;
+
+  resumed = 0;
+
+  return;
+
+} /* END closeJournal() **/
+
+static int readJournal(const char *name, int isRange, SEQ_NUM first, SEQ_NUM last){
+
+  FILE      *fPtr;
+  char      line[JOURNAL_LINE];
+  char      mode;
+  unsigned  seq, runFirst, runLast;
+  int       sameRun = 0;
+  int       ended = 0;
+  int       result = ztSuccess;
+
+  errno = 0;
+  fPtr = fopen(name, "r");
+  if(!fPtr)
+
+    return (errno == ENOENT) ? ztSuccess : ztOpenFileError;
+
+  while(result == ztSuccess && fgets(line, sizeof(line), fPtr)){
+
+    if(! strchr(line, '\n')) /* partial record; crash while writing it **/
+      break;
+
+    if(line[0] == JOURNAL_BEGIN && sscanf(line + 1, " %c %u %u", &mode, &runFirst, &runLast) == 3)
+      sameRun = ((mode == 'r') == (isRange != 0) && runFirst == first && runLast == last);
+
+    /* pairs out of this run are not carried **/
+    else if(line[0] == JOURNAL_PAIR && sscanf(line + 1, "%u", &seq) == 1 &&
+            (SEQ_NUM) seq >= first && (SEQ_NUM) seq <= last)
+      result = addSequence(&committed, (SEQ_NUM) seq);
+
+    else if(line[0] == JOURNAL_PUBLISHED && sscanf(line + 1, "%u", &seq) == 1 && sameRun)
+      published = ((SEQ_NUM) seq > published) ? (SEQ_NUM) seq : published;
+
+    else if(line[0] == JOURNAL_END)
+      ended = 1;
+  }
+
+  fclose(fPtr);
+
+  /* last run finished; it has nothing to give **/
+  if(ended || result != ztSuccess){
+    zapSet(&committed);
+    published = SEQ_NONE;
+  }
+
+  return result;
+
+} /* END readJournal() **/
+
+static int appendRecord(char type, SEQ_NUM seq){
+
+  char  line[JOURNAL_LINE];
+
+  if(type == JOURNAL_END)
+    sprintf(line, "%c\n", type);
+  else
+    sprintf(line, "%c %u\n", type, seq);
+
+  errno = 0;
+  if(write(journalFD, line, strlen(line)) != (ssize_t) strlen(line) || fdatasync(journalFD) != 0){
+    fprintf(stderr, "%s: Error failed writing journal record: %s\n", progName, strerror(errno));
+    return ztWriteError;
+  }
+
+  return ztSuccess;
+
+} /* END appendRecord() **/
+
+static int writeRecords(int fd, SEQ_SET *set){
+
+  char    line[JOURNAL_LINE];
+  size_t  index;
+
+  for(index = 0; index < set->count; index++){
+
+    sprintf(line, "%c %u\n", JOURNAL_PAIR, set->seqs[index]);
+
+    if(write(fd, line, strlen(line)) != (ssize_t) strlen(line))
+      return ztWriteError;
+  }
+
+  return ztSuccess;
+
+} /* END writeRecords() **/
+
+/* addSequence(): records come mostly in order; insert keeps set sorted **/
+
+static int addSequence(SEQ_SET *set, SEQ_NUM seq){
+
+  size_t   index;
+  SEQ_NUM  *newSeqs;
+
+  if(hasSequence(set, seq))
+
+    return ztSuccess;
+
+  if(set->count == set->size){
+
+    newSeqs = (SEQ_NUM *) realloc(set->seqs, (set->size ? set->size * 2 : 64) * sizeof(SEQ_NUM));
+    if(!newSeqs){
+      fprintf(stderr, "%s: Error allocating memory in addSequence().\n", progName);
+      return ztMemoryAllocate;
+    }
+
+    set->seqs = newSeqs;
+    set->size = set->size ? set->size * 2 : 64;
+  }
+
+  index = set->count;
+  while(index > 0 && set->seqs[index - 1] > seq){
+    set->seqs[index] = set->seqs[index - 1];
+    index--;
+  }
+
+  set->seqs[index] = seq;
+  set->count++;
+
+  return ztSuccess;
+
+} /* END addSequence() **/
+
+static int hasSequence(SEQ_SET *set, SEQ_NUM seq){
+
+  size_t  low = 0, high = set->count, middle;
+
+  while(low < high){
+
+    middle = (low + high) / 2;
+
+    if(set->seqs[middle] == seq)
+      return 1;
+
+    if(set->seqs[middle] < seq)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  return 0;
+
+} /* END hasSequence() **/
+
+static void zapSet(SEQ_SET *set){
+
+  if(set->seqs)
+    free(set->seqs);
+
+  memset(set, 0, sizeof(SEQ_SET));
+
+  return;
+
+} /* END zapSet() **/
@@ -0,0 +1,509 @@
+/*
+ * localsrc.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * local source; see localsrc.h.
+ *
+ * file is placed under a ".part" name then renamed, so a file in change
+ * files tree is always whole - as with download. A hard link shares inode
+ * with source tree; getdiff never writes a file in place, neither does
+ * rsync without --inplace.
+ */
+
+#define _GNU_SOURCE   /* copy_file_range() **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+
+#include "localsrc.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+#include "debug.h"
+
+#define LOCAL_BUFFER  (128 * 1024)
+
+/* flag bits for listing; one byte per NNN entry **/
+#define HAS_DIR    0x01
+#define HAS_OSC    0x02
+#define HAS_STATE  0x04
+
+static char          localRoot[PATH_MAX];
+static int           localOn = 0;
+static LOCAL_REPORT  localReport;
+
+static int localPath(char *buffer, size_t size, const char *pathSuffix);
+static int placeLocal(const char *from, const char *to, long long *bytes);
+static int copyRange(int inFD, int outFD, long long *bytes);
+static int readLocal(const char *from, MEMORY_STRUCT *dst);
+static int listLocal(const char *dirName, const char *localFile, MEMORY_STRUCT *dst);
+
+/* isLocalSource(): TRUE for "file://" URL or absolute path **/
+
+int isLocalSource(const char *source){
+
+  ASSERTARGS(source);
+
+  if(strncasecmp(source, FILE_SCHEME, strlen(FILE_SCHEME)) == 0)
+
+    return TRUE;
+
+  return (source[0] == '/');
+
+} /* END isLocalSource() **/
+
+/* isGoodLocalSource(): TRUE when 'source' makes a local source URL;
+ * directory is checked later by startLocalSource().
+ **************************************************************************/
+
+int isGoodLocalSource(const char *source){
+
+  char  *url = NULL;
+
+  ASSERTARGS(source);
+
+  if(! isLocalSource(source) || localSourceURL(&url, source) != ztSuccess)
+
+    return FALSE;
+
+  free(url);
+
+  return TRUE;
+
+} /* END isGoodLocalSource() **/
+
+/* localSourceURL(): 'url' is "file:///dir/" for 'source'; case is kept -
+ * unlike server names, directory names are case sensitive. Caller frees.
+ **************************************************************************/
+
+int localSourceURL(char **url, const char *source){
+
+  ASSERTARGS(url && source);
+
+  const char  *path = source;
+  char        buffer[PATH_MAX];
+
+  *url = NULL;
+
+  if(strncasecmp(source, FILE_SCHEME, strlen(FILE_SCHEME)) == 0){
+
+    path = source + strlen(FILE_SCHEME);
+
+    /* empty or "localhost" host only **/
+    if(strncasecmp(path, "localhost/", 10) == 0)
+      path += 9;
+  }
+
+  if(path[0] != '/' || strchr(path, '%') || strstr(path, "/../") || isGoodDirName(path) != ztSuccess)
+    return ztInvalidArg;
+
+  if(snprintf(buffer, sizeof(buffer), "%s%s%s", FILE_SCHEME, path, SLASH_ENDING(path) ? "" : "/") >= (int) sizeof(buffer))
+    return ztFnameLong;
+
+  *url = STRDUP(buffer);
+
+  return ztSuccess;
+
+} /* END localSourceURL() **/
+
+/* startLocalSource(): 'sourceURL' from localSourceURL(); directory must
+ * have state.txt file as server directory has.
+ **************************************************************************/
+
+int startLocalSource(const char *sourceURL){
+
+  ASSERTARGS(sourceURL);
+
+  char  stateFile[PATH_MAX];
+  int   result;
+
+  memset(&localReport, 0, sizeof(LOCAL_REPORT));
+
+  if(strncmp(sourceURL, FILE_SCHEME, strlen(FILE_SCHEME)) != 0)
+    return ztInvalidArg;
+
+  if(snprintf(localRoot, sizeof(localRoot), "%s", sourceURL + strlen(FILE_SCHEME)) >= (int) sizeof(localRoot))
+    return ztFnameLong;
+
+  result = isDirUsable(localRoot);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error local source directory is not usable: <%s>\n", progName, localRoot);
+    return result;
+  }
+
+  if(strlen(localRoot) + strlen(STATE_FILE) >= sizeof(stateFile))
+    return ztFnameLong;
+
+  strcpy(stateFile, localRoot);
+  strcat(stateFile, STATE_FILE);
+
+  result = isFileUsable(stateFile);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error local source directory has no usable <%s> file: <%s>\n",
+            progName, STATE_FILE, localRoot);
+    return result;
+  }
+
+  localOn = 1;
+
+  return ztSuccess;
+
+} /* END startLocalSource() **/
+
+int isLocalSourceOn(void){
+
+  return localOn;
+
+} /* END isLocalSourceOn() **/
+
+/* localFetch(): "download" 'pathSuffix' from local source to 'localFile' or
+ * to 'dst' memory; exactly one is set. A directory gives its HTML listing.
+ * Missing file is ztResponse404 as from server.
+ **************************************************************************/
+
+int localFetch(const char *pathSuffix, const char *localFile, MEMORY_STRUCT *dst){
+
+  ASSERTARGS(pathSuffix && (localFile || dst));
+
+  char         fromName[PATH_MAX];
+  struct stat  status;
+  long long    bytes = 0;
+  int          result;
+
+  result = localPath(fromName, sizeof(fromName), pathSuffix);
+  if(result != ztSuccess)
+    return result;
+
+  if(stat(fromName, &status) != 0)
+    return (errno == ENOENT) ? ztResponse404 : ztFileError;
+
+  if(S_ISDIR(status.st_mode)){
+
+    result = listLocal(fromName, localFile, dst);
+    if(result == ztSuccess)
+      localReport.listings++;
+
+    return result;
+  }
+
+  if(! S_ISREG(status.st_mode))
+    return ztResponse404;
+
+  if(dst)
+    result = readLocal(fromName, dst);
+  else
+    result = placeLocal(fromName, localFile, &bytes);
+
+  if(result == ztSuccess)
+    localReport.bytes += dst ? (long long) dst->size : bytes;
+
+  return result;
+
+} /* END localFetch() **/
+
+/* isLocalFile(): ztSuccess when regular file for 'pathSuffix' exists;
+ * as isRemoteFile() for server.
+ **************************************************************************/
+
+int isLocalFile(const char *pathSuffix){
+
+  ASSERTARGS(pathSuffix);
+
+  char         fileName[PATH_MAX];
+  struct stat  status;
+  int          result;
+
+  result = localPath(fileName, sizeof(fileName), pathSuffix);
+  if(result != ztSuccess)
+    return result;
+
+  if(stat(fileName, &status) != 0 || ! S_ISREG(status.st_mode))
+    return ztFileNotFound;
+
+  return ztSuccess;
+
+} /* END isLocalFile() **/
+
+int finishLocalSource(void){
+
+  char  buffer[PATH_MAX + 256];
+
+  if(! localOn)
+    return ztSuccess;
+
+  snprintf(buffer, sizeof(buffer),
+           "Local source <%s>: linked %ld, cloned %ld, copied %ld files; %lld bytes; %ld listings.",
+           localRoot, localReport.linked, localReport.cloned, localReport.copied,
+           localReport.bytes, localReport.listings);
+
+  if(fVerbose)
+    fprintf(stdout, "%s: %s\n", progName, buffer);
+
+  logMessage(fLogPtr, buffer);
+
+  localOn = 0;
+
+  return ztSuccess;
+
+} /* END finishLocalSource() **/
+
+/* localPath(): full name in local source for 'pathSuffix' **/
+
+static int localPath(char *buffer, size_t size, const char *pathSuffix){
+
+  if(strstr(pathSuffix, ".."))
+    return ztInvalidArg;
+
+  if(pathSuffix[0] == '/')
+    pathSuffix++;
+
+  if(snprintf(buffer, size, "%s%s", localRoot, pathSuffix) >= (int) size)
+    return ztFnameLong;
+
+  return ztSuccess;
+
+} /* END localPath() **/
+
+/* placeLocal(): 'from' to 'to' through ".part" name; hard link, reflink or
+ * copy - first that works.
+ **************************************************************************/
+
+static int placeLocal(const char *from, const char *to, long long *bytes){
+
+  char         partName[PATH_MAX];
+  struct stat  status;
+  int          inFD, outFD;
+  int          result = ztSuccess;
+
+  if(snprintf(partName, sizeof(partName), "%s.part", to) >= (int) sizeof(partName))
+    return ztFnameLong;
+
+  unlink(partName);
+
+  if(link(from, partName) == 0){
+
+    if(stat(partName, &status) == 0)
+      *bytes = (long long) status.st_size;
+
+    localReport.linked++;
+  }
+  else {
+
+    inFD = open(from, O_RDONLY | O_CLOEXEC);
+    if(inFD < 0)
+      return ztOpenFileError;
+
+    outFD = open(partName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(outFD < 0){
+      close(inFD);
+      return ztOpenFileError;
+    }
+
+#ifdef FICLONE
+    if(ioctl(outFD, FICLONE, inFD) == 0){
+
+      if(fstat(outFD, &status) == 0)
+        *bytes = (long long) status.st_size;
+
+      localReport.cloned++;
+    }
+    else
+#endif
+    {
+      result = copyRange(inFD, outFD, bytes);
+      if(result == ztSuccess)
+        localReport.copied++;
+    }
+
+    close(inFD);
+
+    if(close(outFD) != 0 && result == ztSuccess)
+      result = ztWriteError;
+  }
+
+  if(result == ztSuccess && rename(partName, to) != 0){
+    fprintf(stderr, "%s: Error failed rename() to <%s>: %s\n", progName, to, strerror(errno));
+    result = ztFailedSysCall;
+  }
+
+  if(result != ztSuccess)
+    unlink(partName);
+
+  return result;
+
+} /* END placeLocal() **/
+
+/* copyRange(): kernel copy with copy_file_range(); read and write where
+ * file systems do not support it.
+ **************************************************************************/
+
+static int copyRange(int inFD, int outFD, long long *bytes){
+
+  unsigned char  *buffer;
+  ssize_t        got, written;
+  long long      total = 0;
+
+  while((got = copy_file_range(inFD, NULL, outFD, NULL, LOCAL_BUFFER * 8, 0)) > 0)
+    total += got;
+
+  if(got == 0){
+    *bytes = total;
+    return ztSuccess;
+  }
+
+  if(total || (errno != EXDEV && errno != ENOSYS && errno != EINVAL && errno != EOPNOTSUPP))
+    return ztWriteError;
+
+  buffer = (unsigned char *) malloc(LOCAL_BUFFER);
+  if(!buffer)
+    return ztMemoryAllocate;
+
+  while((got = read(inFD, buffer, LOCAL_BUFFER)) > 0){
+
+    written = write(outFD, buffer, (size_t) got);
+    if(written != got){
+      free(buffer);
+      return ztWriteError;
+    }
+
+    total += got;
+  }
+
+  free(buffer);
+
+  if(got < 0)
+    return ztFileError;
+
+  *bytes = total;
+
+  return ztSuccess;
+
+} /* END copyRange() **/
+
+/* readLocal(): whole file into 'dst'; memory as download2Memory() leaves it **/
+
+static int readLocal(const char *from, MEMORY_STRUCT *dst){
+
+  struct stat  status;
+  char         *memory;
+  ssize_t      got;
+  size_t       done = 0;
+  int          fd;
+
+  fd = open(from, O_RDONLY | O_CLOEXEC);
+  if(fd < 0)
+    return ztOpenFileError;
+
+  if(fstat(fd, &status) != 0){
+    close(fd);
+    return ztFileError;
+  }
+
+  memory = (char *) realloc(dst->memory, (size_t) status.st_size + 1);
+  if(!memory){
+    close(fd);
+    return ztMemoryAllocate;
+  }
+
+  dst->memory = memory;
+
+  while(done < (size_t) status.st_size &&
+        (got = read(fd, memory + done, (size_t) status.st_size - done)) > 0)
+    done += (size_t) got;
+
+  close(fd);
+
+  if(done != (size_t) status.st_size)
+    return ztFileError;
+
+  memory[done] = '\0';
+  dst->size = done;
+
+  return ztSuccess;
+
+} /* END readLocal() **/
+
+/* listLocal(): HTML listing for 'dirName' with "NNN/" directories and
+ * complete pairs only; as parseHtmlFile() reads server pages.
+ **************************************************************************/
+
+static int listLocal(const char *dirName, const char *localFile, MEMORY_STRUCT *dst){
+
+  unsigned char  flags[1000] = {0};
+  DIR            *dirPtr;
+  struct dirent  *entry;
+  FILE           *filePtr;
+  char           *memory = NULL;
+  size_t         size = 0;
+  int            number;
+  int            result = ztSuccess;
+
+  dirPtr = opendir(dirName);
+  if(!dirPtr)
+    return ztResponse404;
+
+  while((entry = readdir(dirPtr))){
+
+    number = leadTriplet(entry->d_name);
+    if(number < 0)
+      continue;
+
+    if(entry->d_name[3] == '\0')
+      flags[number] |= HAS_DIR;
+
+    else if(strcmp(entry->d_name + 3, CHANGE_EXT) == 0)
+      flags[number] |= HAS_OSC;
+
+    else if(strcmp(entry->d_name + 3, STATE_EXT) == 0)
+      flags[number] |= HAS_STATE;
+  }
+
+  closedir(dirPtr);
+
+  filePtr = dst ? open_memstream(&memory, &size) : fopen(localFile, "w");
+  if(!filePtr)
+    return ztOpenFileError;
+
+  fprintf(filePtr, "<html>\n<head><title>Index of %s</title></head>\n<body>\n<pre>\n", dirName);
+
+  for(number = 0; number < 1000; number++){
+
+    if(flags[number] & HAS_DIR)
+      fprintf(filePtr, "<a href=\"%03d/\">%03d/</a>\n", number, number);
+
+    if((flags[number] & (HAS_OSC | HAS_STATE)) == (HAS_OSC | HAS_STATE)){
+      fprintf(filePtr, "<a href=\"%03d%s\">%03d%s</a>\n", number, CHANGE_EXT, number, CHANGE_EXT);
+      fprintf(filePtr, "<a href=\"%03d%s\">%03d%s</a>\n", number, STATE_EXT, number, STATE_EXT);
+    }
+  }
+
+  fprintf(filePtr, "</pre>\n</body>\n</html>\n");
+
+  if(fclose(filePtr) != 0)
+    result = ztWriteError;
+
+  if(dst){
+
+    if(result == ztSuccess){
+      free(dst->memory);
+      dst->memory = memory;
+      dst->size = size;
+    }
+    else
+      free(memory);
+  }
+
+  return result;
+
+} /* END listLocal() **/
+
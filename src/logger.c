@@ -0,0 +1,600 @@
+/*
+ * logger.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * asynchronous log writer; see logger.h.
+ *
+ * Ring is a bounded multi producer queue: each slot has a sequence number,
+ * producers claim a position with compare and swap and publish the slot by
+ * storing its sequence; no lock is taken. Single consumer is the writer
+ * thread. Producers post the semaphore only when writer is asleep, so a
+ * burst of lines costs one wake up and one write() for the batch.
+ * Writer writes batches with write(2) on log descriptor - file is opened
+ * for append - so nothing is held in stdio and crash handler needs none.
+ *
+ * A line longer than a slot, or any line when logger is not running, is
+ * written in place by writeLogLine() as logMessage() always did.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "logger.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+
+#define LOG_SLOTS        1024          /* power of two **/
+#define LOG_SLOT_TEXT    1000
+#define LOG_BATCH_SIZE   (64 * 1024)
+#define LOG_STAMP_SIZE   32
+#define LOG_IDLE_SEC     1             /* writer wakes at least this often **/
+
+typedef struct LOG_SLOT_ {
+
+  atomic_size_t  sequence;
+  time_t         when;
+  int            kind;
+  char           text[LOG_SLOT_TEXT];
+
+} LOG_SLOT;
+
+static const char *startTemplate =
+  "+++++++++++++++++++++++++++++++++++ STARTING +++++++++++++++++++++++++++++++++\n"
+  "%s [%d]: %s started. (Version: %s)\n";
+
+static const char *doneTemplate =
+  "%s [%d]: %s is done.\n"
+  "===================================== DONE ===================================\n\n";
+
+static const char *levelNames[] = {"error", "warning", "info", "debug"};
+
+static LOG_SLOT       *ring = NULL;
+static atomic_size_t  enqueuePos;
+static size_t         dequeuePos = 0;      /* next slot to format; writer thread only **/
+static size_t         releasePos = 0;      /* first slot not yet freed; writer only **/
+static atomic_size_t  writtenPos;          /* lines written to log descriptor **/
+
+static FILE           *logFP = NULL;
+static int            logFD = -1;
+static LOG_LEVEL      logLevel = LOG_DEFAULT_LEVEL;
+static pid_t          logPID = 0;
+
+static pthread_t      writerThread;
+static sem_t          wakeSem;
+static atomic_int     running;
+static atomic_int     writerAsleep;
+static atomic_int     stopWriter;
+static atomic_int     crashing;
+
+/* cached per second; writer thread and crash handler only **/
+static time_t         stampTime = (time_t) -1;
+static char           stampString[LOG_STAMP_SIZE];
+
+static void *writerLoop(void *arg);
+static int drainRing(char *batch, size_t *length);
+static void writeBatch(const char *batch, size_t length);
+static const char *cachedStamp(time_t when);
+static int formatLine(char *dest, size_t size, const char *stamp, pid_t pid, int kind, const char *msg);
+static size_t crashLine(char *dest, const LOG_SLOT *slot);
+static void installCrashHandlers(void);
+static void onCrashSignal(int signum);
+
+/* string2LogLevel(): "error", "warning", "info" or "debug" **/
+
+int string2LogLevel(LOG_LEVEL *level, const char *string){
+
+  ASSERTARGS(level && string);
+
+  for(int index = LOG_ERROR; index <= LOG_DEBUG; index++){
+
+    if(strcmp(string, levelNames[index]) == 0){
+      *level = (LOG_LEVEL) index;
+      return ztSuccess;
+    }
+  }
+
+  return ztInvalidArg;
+
+} /* END string2LogLevel() **/
+
+const char *logLevel2String(LOG_LEVEL level){
+
+  if(level < LOG_ERROR || level > LOG_DEBUG)
+    return "unknown";
+
+  return levelNames[level];
+
+} /* END logLevel2String() **/
+
+/* messageLevel(): level from message text as callers write it;
+ * "Error ..." and "Warning ..." lines, all others are information.
+ *
+ ************************************************************************/
+LOG_LEVEL messageLevel(const char *msg){
+
+  ASSERTARGS(msg);
+
+  if(strncmp(msg, "Error", 5) == 0 || strncmp(msg, "error", 5) == 0)
+    return LOG_ERROR;
+
+  if(strncmp(msg, "Warning", 7) == 0 || strncmp(msg, "warning", 7) == 0)
+    return LOG_WARNING;
+
+  return LOG_INFO;
+
+} /* END messageLevel() **/
+
+/* startLogger(): starts writer thread for 'to' log file. Queued lines are
+ * written on exit by stopLogger() registered with atexit().
+ *
+ ************************************************************************/
+int startLogger(FILE *to, LOG_LEVEL level){
+
+  static int  registered = 0;
+  int         result;
+
+  ASSERTARGS(to);
+
+  if(atomic_load(&running))
+    return ztSuccess;
+
+  ring = (LOG_SLOT *) calloc(LOG_SLOTS, sizeof(LOG_SLOT));
+  if(!ring)
+    return ztMemoryAllocate;
+
+  for(size_t index = 0; index < LOG_SLOTS; index++)
+    atomic_init(&ring[index].sequence, index);
+
+  atomic_init(&enqueuePos, 0);
+  atomic_init(&writtenPos, 0);
+  atomic_init(&writerAsleep, 0);
+  atomic_init(&stopWriter, 0);
+  atomic_init(&crashing, 0);
+  dequeuePos = 0;
+  releasePos = 0;
+
+  /* writer goes around stdio from here on **/
+  fflush(to);
+
+  logFP = to;
+  logFD = fileno(to);
+  logLevel = level;
+  logPID = getpid();
+
+  if(sem_init(&wakeSem, 0, 0) != 0){
+    free(ring);
+    ring = NULL;
+    return ztFailedSysCall;
+  }
+
+  result = pthread_create(&writerThread, NULL, writerLoop, NULL);
+  if(result != 0){
+    fprintf(stderr, "%s: Error failed pthread_create() for log writer: %s\n", progName, strerror(result));
+    sem_destroy(&wakeSem);
+    free(ring);
+    ring = NULL;
+    return ztFailedSysCall;
+  }
+
+  atomic_store(&running, 1);
+
+  if(!registered){
+    atexit(stopLogger);
+    installCrashHandlers();
+    registered = 1;
+  }
+
+  return ztSuccess;
+
+} /* END startLogger() **/
+
+int isLoggerFor(FILE *to){
+
+  return atomic_load_explicit(&running, memory_order_acquire) && to == logFP;
+
+} /* END isLoggerFor() **/
+
+int isLevelLogged(LOG_LEVEL level){
+
+  return level <= logLevel;
+
+} /* END isLevelLogged() **/
+
+/* queueLogLine(): puts one line on ring; waits for a free slot when ring is
+ * full. Returns ztInvalidArg for 'msg' longer than a slot and ztInvalidUsage
+ * when logger is not running; caller writes line itself.
+ *
+ ************************************************************************/
+int queueLogLine(LOG_LEVEL level, int kind, const char *msg){
+
+  LOG_SLOT  *slot;
+  size_t    pos;
+  size_t    sequence;
+  intptr_t  diff;
+  size_t    length;
+
+  ASSERTARGS(msg);
+
+  if(!atomic_load_explicit(&running, memory_order_acquire) || atomic_load(&crashing))
+    return ztInvalidUsage;
+
+  if(!isLevelLogged(level))
+    return ztSuccess;
+
+  length = strlen(msg);
+  if(length >= LOG_SLOT_TEXT)
+    return ztInvalidArg;
+
+  pos = atomic_load_explicit(&enqueuePos, memory_order_relaxed);
+
+  while(1){
+
+    slot = &ring[pos & (LOG_SLOTS - 1)];
+    sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    diff = (intptr_t) sequence - (intptr_t) pos;
+
+    if(diff == 0){
+      if(atomic_compare_exchange_weak_explicit(&enqueuePos, &pos, pos + 1,
+                                               memory_order_relaxed, memory_order_relaxed))
+        break;
+    }
+    else if(diff < 0){
+      /* full; writer is behind **/
+      sem_post(&wakeSem);
+      sched_yield();
+      pos = atomic_load_explicit(&enqueuePos, memory_order_relaxed);
+    }
+    else
+      pos = atomic_load_explicit(&enqueuePos, memory_order_relaxed);
+  }
+
+  slot->when = time(NULL);
+  slot->kind = kind;
+  memcpy(slot->text, msg, length + 1);
+
+  atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+
+  if(atomic_load(&writerAsleep) && atomic_exchange(&writerAsleep, 0))
+    sem_post(&wakeSem);
+
+  return ztSuccess;
+
+} /* END queueLogLine() **/
+
+/* syncLogger(): returns after every line queued so far is in log file.
+ * Not to be called from writer thread.
+ *
+ ************************************************************************/
+void syncLogger(void){
+
+  size_t  target;
+  struct timespec  pause = {0, 200000};   /* 0.2 millisecond **/
+
+  if(!atomic_load(&running))
+    return;
+
+  target = atomic_load(&enqueuePos);
+
+  while(atomic_load(&writtenPos) < target && atomic_load(&running)){
+    sem_post(&wakeSem);
+    nanosleep(&pause, NULL);
+  }
+
+} /* END syncLogger() **/
+
+/* stopLogger(): drains ring, flushes and joins writer; lines after this
+ * are written in place. Safe to call more than once.
+ *
+ ************************************************************************/
+void stopLogger(void){
+
+  if(!atomic_load(&running))
+    return;
+
+  atomic_store(&stopWriter, 1);
+  sem_post(&wakeSem);
+
+  pthread_join(writerThread, NULL);
+
+  atomic_store(&running, 0);
+
+  sem_destroy(&wakeSem);
+
+  free(ring);
+  ring = NULL;
+  logFP = NULL;
+  logFD = -1;
+
+} /* END stopLogger() **/
+
+/* writeLogLine(): formats and writes one line in place with fflush();
+ * used when logger is not running.
+ *
+ ************************************************************************/
+int writeLogLine(FILE *to, int kind, const char *msg){
+
+  char       stamp[LOG_STAMP_SIZE];
+  char       line[PATH_MAX + 256];
+  struct tm  tmTime;
+  time_t     now = time(NULL);
+  int        length;
+
+  ASSERTARGS(to && msg);
+
+  localtime_r(&now, &tmTime);
+  strftime(stamp, sizeof(stamp), "%Y-%b-%d %H:%M:%S", &tmTime);
+
+  length = formatLine(line, sizeof(line), stamp, getpid(), kind, msg);
+  if(length < 0)
+    return ztInvalidArg;
+
+  fwrite(line, 1, (size_t) length, to);
+  fflush(to);
+
+  return ztSuccess;
+
+} /* END writeLogLine() **/
+
+static void *writerLoop(void *arg){
+
+  static char  batch[LOG_BATCH_SIZE];
+  size_t       length;
+  int          more;
+  struct timespec  deadline;
+
+  (void) arg;
+
+  while(1){
+
+    length = 0;
+
+    do {
+      more = drainRing(batch, &length);
+
+      writeBatch(batch, length);
+      length = 0;
+    } while(more);
+
+    if(atomic_load(&stopWriter)){
+      /* producers may still have published lines; one more pass **/
+      if(drainRing(batch, &length) || length){
+        writeBatch(batch, length);
+        continue;
+      }
+      break;
+    }
+
+    /* announce sleep then look again; producer may have missed flag **/
+    atomic_store(&writerAsleep, 1);
+
+    if(atomic_load_explicit(&ring[dequeuePos & (LOG_SLOTS - 1)].sequence,
+                            memory_order_acquire) == dequeuePos + 1){
+      atomic_store(&writerAsleep, 0);
+      continue;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += LOG_IDLE_SEC;
+
+    while(sem_timedwait(&wakeSem, &deadline) != 0 && errno == EINTR)
+      ;
+
+    atomic_store(&writerAsleep, 0);
+
+    /* collapse extra posts from the same burst **/
+    while(sem_trywait(&wakeSem) == 0)
+      ;
+  }
+
+  return NULL;
+
+} /* END writerLoop() **/
+
+/* drainRing(): appends published lines to 'batch' from 'length' on.
+ * Returns TRUE when batch filled before ring emptied. Slots stay taken
+ * until writeBatch(); crash handler still finds lines not yet written.
+ *
+ ************************************************************************/
+static int drainRing(char *batch, size_t *length){
+
+  LOG_SLOT  *slot;
+  int       written;
+
+  while(1){
+
+    slot = &ring[dequeuePos & (LOG_SLOTS - 1)];
+
+    if(atomic_load_explicit(&slot->sequence, memory_order_acquire) != dequeuePos + 1)
+      return FALSE;
+
+    /* slot text plus templates fits in 2 * LOG_SLOT_TEXT **/
+    if(*length + 2 * LOG_SLOT_TEXT > LOG_BATCH_SIZE)
+      return TRUE;
+
+    written = formatLine(batch + *length, LOG_BATCH_SIZE - *length,
+                         cachedStamp(slot->when), logPID, slot->kind, slot->text);
+    if(written > 0)
+      *length += (size_t) written;
+
+    dequeuePos++;
+  }
+
+} /* END drainRing() **/
+
+/* writeBatch(): writes 'batch' to log descriptor, publishes position for
+ * crash handler, then frees slots drained into it.
+ *
+ ************************************************************************/
+static void writeBatch(const char *batch, size_t length){
+
+  ssize_t  written;
+
+  while(length){
+
+    written = write(logFD, batch, length);
+    if(written < 0){
+      if(errno == EINTR)
+        continue;
+      break;
+    }
+
+    batch += written;
+    length -= (size_t) written;
+  }
+
+  atomic_store_explicit(&writtenPos, dequeuePos, memory_order_release);
+
+  while(releasePos < dequeuePos){
+    atomic_store_explicit(&ring[releasePos & (LOG_SLOTS - 1)].sequence,
+                          releasePos + LOG_SLOTS, memory_order_release);
+    releasePos++;
+  }
+
+} /* END writeBatch() **/
+
+/* cachedStamp(): time of day string; strftime() runs once per second **/
+
+static const char *cachedStamp(time_t when){
+
+  struct tm  tmTime;
+
+  if(when != stampTime){
+    localtime_r(&when, &tmTime);
+    strftime(stampString, sizeof(stampString), "%Y-%b-%d %H:%M:%S", &tmTime);
+    stampTime = when;
+  }
+
+  return stampString;
+
+} /* END cachedStamp() **/
+
+static int formatLine(char *dest, size_t size, const char *stamp, pid_t pid, int kind, const char *msg){
+
+  int  length;
+
+  if(kind == LOG_START)
+    length = snprintf(dest, size, startTemplate, stamp, (int) pid, progName, VERSION);
+
+  else if(kind == LOG_DONE)
+    length = snprintf(dest, size, doneTemplate, stamp, (int) pid, progName);
+
+  else
+    length = snprintf(dest, size, "%s [%d]: %s\n", stamp, (int) pid, msg);
+
+  if(length >= (int) size)
+    length = (int) size - 1;
+
+  return length;
+
+} /* END formatLine() **/
+
+static void installCrashHandlers(void){
+
+  struct sigaction  action;
+  int               signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = onCrashSignal;
+  action.sa_flags = SA_RESETHAND;
+  sigemptyset(&action.sa_mask);
+
+  for(size_t index = 0; index < sizeof(signals) / sizeof(signals[0]); index++)
+    sigaction(signals[index], &action, NULL);
+
+} /* END installCrashHandlers() **/
+
+/* onCrashSignal(): writes lines still on ring straight to log descriptor,
+ * from writer published position on, then signal is raised again with
+ * default action. Only write(2) is called; lines are put together by
+ * crashLine() with last cached timestamp.
+ *
+ ************************************************************************/
+static void onCrashSignal(int signum){
+
+  char      line[LOG_STAMP_SIZE + LOG_SLOT_TEXT + 32];
+  LOG_SLOT  *slot;
+  size_t    pos;
+  size_t    length;
+
+  if(atomic_load(&running) && !atomic_exchange(&crashing, 1)){
+
+    pos = atomic_load_explicit(&writtenPos, memory_order_acquire);
+
+    while(1){
+
+      slot = &ring[pos & (LOG_SLOTS - 1)];
+
+      /* writer freed it after writing, or nothing published yet **/
+      if(atomic_load_explicit(&slot->sequence, memory_order_acquire) != pos + 1)
+        break;
+
+      length = crashLine(line, slot);
+      if(write(logFD, line, length) < 0)
+        break;
+
+      pos++;
+    }
+  }
+
+  raise(signum);
+
+} /* END onCrashSignal() **/
+
+/* crashLine(): "stamp [pid]: text" line for crash handler; no stdio.
+ * 'dest' holds LOG_STAMP_SIZE + LOG_SLOT_TEXT + 32 characters.
+ *
+ ************************************************************************/
+static size_t crashLine(char *dest, const LOG_SLOT *slot){
+
+  char        digits[16];
+  const char  *text;
+  size_t      length, count;
+  int         pid = (int) logPID;
+  int         place = (int) sizeof(digits);
+
+  if(slot->kind == LOG_START)
+    text = "+++ STARTING +++";
+  else if(slot->kind == LOG_DONE)
+    text = "=== DONE ===";
+  else
+    text = slot->text;
+
+  do {
+    digits[--place] = (char) ('0' + pid % 10);
+    pid /= 10;
+  } while(pid && place);
+
+  length = strnlen(stampString, LOG_STAMP_SIZE);
+  memcpy(dest, stampString, length);
+
+  memcpy(dest + length, " [", 2);
+  length += 2;
+
+  count = sizeof(digits) - (size_t) place;
+  memcpy(dest + length, digits + place, count);
+  length += count;
+
+  memcpy(dest + length, "]: ", 3);
+  length += 3;
+
+  count = strnlen(text, LOG_SLOT_TEXT);
+  memcpy(dest + length, text, count);
+  length += count;
+
+  dest[length++] = '\n';
+
+  return length;
+
+} /* END crashLine() **/
@@ -0,0 +1,602 @@
+/*
+ * merge.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * merge change files into one osmChange file; see merge.h.
+ *
+ * elements are read with osc.c reader in file order, each gets 'order'
+ * number. Records are sorted by (type, id, version, order); the last record
+ * of each (type, id) group is the one we keep - highest version, later file
+ * wins a tie.
+ *
+ * when records in memory go over MERGE_MEM_LIMIT they are sorted and written
+ * to an unlinked temporary run file; runs are merged at the end. When
+ * MERGE_MAX_RUNS runs are open they are merged into one larger run first -
+ * keeping only the last record of each object - so input of any size is
+ * merged with MERGE_MAX_RUNS open files and one record per run in memory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "merge.h"
+#include "osc.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+#include "gd_primitives.h"
+
+typedef struct MERGE_REC_ {
+
+  OSC_TYPE            type;
+  OSC_ACTION          action;
+  long long           id;
+  long                version;
+  unsigned long long  order;  /* (file index << 32) + element index **/
+
+  size_t              length;
+  char                *text;
+
+} MERGE_REC;
+
+/* one sorted run file being read back **/
+typedef struct MERGE_RUN_ {
+
+  FILE       *fp;
+  MERGE_REC  current;
+  size_t     textSize;
+  int        done;
+
+} MERGE_RUN;
+
+typedef struct MERGE_OUT_ {
+
+  gzFile      gz;
+  OSC_ACTION  action;   /* open action block **/
+  long        count;
+
+} MERGE_OUT;
+
+static int compareRec(const void *first, const void *second);
+static int openRun(FILE **runFP, const char *tmpDir);
+static int putRecord(FILE *runFP, const MERGE_REC *rec);
+static int writeRun(FILE **runFP, MERGE_REC *records, size_t count, const char *tmpDir);
+static int readRun(MERGE_RUN *run);
+static int mergeRuns(MERGE_RUN *runs, int numRuns, MERGE_OUT *out, FILE *runFP);
+static int cascadeRuns(MERGE_RUN *runs, int *numRuns, const char *tmpDir);
+static int emitRecord(MERGE_OUT *out, const MERGE_REC *rec);
+static void freeRecords(MERGE_REC *records, size_t count);
+
+/* mergeChangeFiles(): merges 'oscFiles' - full path, in sequence order - into
+ * 'destFile' (.osc.gz). Output is written to "destFile.part" then renamed.
+ *
+ ***************************************************************************/
+
+int mergeChangeFiles(const char *destFile, STRING_LIST *oscFiles, const char *tmpDir){
+
+  ASSERTARGS(destFile && oscFiles && tmpDir);
+
+  OSC_READER    *reader;
+  OSC_ELEMENT   element;
+  MERGE_REC     *records = NULL;
+  MERGE_REC     *tmpRec;
+  MERGE_RUN     runs[MERGE_MAX_RUNS];
+  MERGE_OUT     out;
+  MERGE_REC     *pending;
+  ELEM          *elem;
+  char          partFile[PATH_MAX];
+  size_t        count = 0, capacity = 0;
+  size_t        memUsed = 0;
+  unsigned long fileIndex = 0, elemIndex;
+  int           numRuns = 0;
+  int           result = ztSuccess;
+  int           i;
+
+  memset(runs, 0, sizeof(runs));
+  memset(&out, 0, sizeof(MERGE_OUT));
+
+  if(snprintf(partFile, sizeof(partFile), "%s.part", destFile) >= (int) sizeof(partFile))
+
+    return ztFnameLong;
+
+  /* read all files; spill sorted runs when over memory limit **/
+  for(elem = DL_HEAD(oscFiles); elem; elem = DL_NEXT(elem), fileIndex++){
+
+    reader = oscOpen((char *) DL_DATA(elem));
+    if(!reader){
+      result = ztOpenFileError;
+      goto MERGE_CLEAN;
+    }
+
+    elemIndex = 0;
+
+    while((result = oscNext(reader, &element)) == ztSuccess){
+
+      if(count == capacity){
+
+        capacity = capacity ? capacity * 2 : 4096;
+        tmpRec = (MERGE_REC *) realloc(records, capacity * sizeof(MERGE_REC));
+        if(!tmpRec){
+          fprintf(stderr, "%s: Error allocating memory in mergeChangeFiles().\n", progName);
+          oscClose(&reader);
+          result = ztMemoryAllocate;
+          goto MERGE_CLEAN;
+        }
+        records = tmpRec;
+      }
+
+      tmpRec = records + count;
+      tmpRec->type = element.type;
+      tmpRec->action = element.action;
+      tmpRec->id = element.id;
+      tmpRec->version = element.version;
+      tmpRec->order = ((unsigned long long) fileIndex << 32) + elemIndex++;
+      tmpRec->length = element.length;
+      tmpRec->text = (char *) malloc(element.length + 1);
+      if(!tmpRec->text){
+        fprintf(stderr, "%s: Error allocating memory in mergeChangeFiles().\n", progName);
+        oscClose(&reader);
+        result = ztMemoryAllocate;
+        goto MERGE_CLEAN;
+      }
+      memcpy(tmpRec->text, element.text, element.length + 1);
+
+      count++;
+      memUsed += sizeof(MERGE_REC) + element.length + 1;
+
+      if(memUsed < MERGE_MEM_LIMIT)
+        continue;
+
+      if(numRuns == MERGE_MAX_RUNS){
+        result = cascadeRuns(runs, &numRuns, tmpDir);
+        if(result != ztSuccess){
+          oscClose(&reader);
+          goto MERGE_CLEAN;
+        }
+      }
+
+      qsort(records, count, sizeof(MERGE_REC), compareRec);
+
+      result = writeRun(&runs[numRuns].fp, records, count, tmpDir);
+      if(result != ztSuccess){
+        oscClose(&reader);
+        goto MERGE_CLEAN;
+      }
+
+      numRuns++;
+      freeRecords(records, count);
+      count = 0;
+      memUsed = 0;
+    }
+
+    oscClose(&reader);
+
+    if(result != ztEndOfFile){
+      fprintf(stderr, "%s: Error failed reading change file: <%s>\n", progName, (char *) DL_DATA(elem));
+      goto MERGE_CLEAN;
+    }
+  }
+
+  qsort(records, count, sizeof(MERGE_REC), compareRec);
+
+  /* last records join other runs on disk **/
+  if(numRuns && count){
+
+    if(numRuns == MERGE_MAX_RUNS){
+      result = cascadeRuns(runs, &numRuns, tmpDir);
+      if(result != ztSuccess)
+        goto MERGE_CLEAN;
+    }
+
+    result = writeRun(&runs[numRuns].fp, records, count, tmpDir);
+    if(result != ztSuccess)
+      goto MERGE_CLEAN;
+
+    numRuns++;
+    freeRecords(records, count);
+    count = 0;
+  }
+
+  out.gz = gzopen(partFile, "wb6");
+  if(!out.gz){
+    fprintf(stderr, "%s: Error failed gzopen() for merge output: <%s>\n", progName, partFile);
+    result = ztOpenFileError;
+    goto MERGE_CLEAN;
+  }
+
+  gzprintf(out.gz, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                   "<osmChange version=\"0.6\" generator=\"%s %s\">\n", progName, VERSION);
+
+  result = ztSuccess;
+  pending = NULL;
+
+  if(numRuns == 0){
+
+    for(size_t n = 0; n < count && result == ztSuccess; n++){
+
+      if(pending && (pending->type != records[n].type || pending->id != records[n].id))
+        result = emitRecord(&out, pending);
+
+      pending = records + n;
+    }
+
+    if(pending && result == ztSuccess)
+      result = emitRecord(&out, pending);
+  }
+  else
+
+    result = mergeRuns(runs, numRuns, &out, NULL);
+
+  if(result == ztSuccess && out.action != OSC_NO_ACTION)
+    gzprintf(out.gz, "</%s>\n", oscActionName(out.action));
+
+  gzprintf(out.gz, "</osmChange>\n");
+
+  if(gzclose(out.gz) != Z_OK && result == ztSuccess){
+    fprintf(stderr, "%s: Error failed gzclose() for merge output: <%s>\n", progName, partFile);
+    result = ztWriteError;
+  }
+
+  out.gz = NULL;
+
+  if(result == ztSuccess && rename(partFile, destFile) != 0){
+    fprintf(stderr, "%s: Error failed rename() to <%s>: %s\n", progName, destFile, strerror(errno));
+    result = ztFailedSysCall;
+  }
+
+  if(result == ztSuccess && fVerbose)
+    fprintf(stdout, "%s: Merged <%d> change files into <%ld> elements; used <%d> temporary runs.\n",
+            progName, DL_SIZE(oscFiles), out.count, numRuns);
+
+MERGE_CLEAN:
+
+  if(records)
+    freeRecords(records, count);
+
+  if(records)
+    free(records);
+
+  for(i = 0; i < numRuns; i++){
+    if(runs[i].fp)
+      fclose(runs[i].fp);
+    if(runs[i].current.text)
+      free(runs[i].current.text);
+  }
+
+  if(result != ztSuccess)
+    unlink(partFile);
+
+  return result;
+
+} /* END mergeChangeFiles() **/
+
+/* writeMergedState(): state.txt for merged file; sequenceNumber and
+ * timestamp are those of 'lastStateFile' - last file in merged range.
+ *
+ ***************************************************************************/
+
+int writeMergedState(const char *destFile, const char *lastStateFile, SEQ_NUM first, SEQ_NUM last){
+
+  ASSERTARGS(destFile && lastStateFile);
+
+  STATE_INFO  *si;
+  FILE        *fPtr;
+  int         result;
+
+  si = initialStateInfo();
+  if(!si){
+    fprintf(stderr, "%s: Error failed initialStateInfo().\n", progName);
+    return ztMemoryAllocate;
+  }
+
+  result = stateFile2StateInfo(si, lastStateFile);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed stateFile2StateInfo() for: <%s>\n", progName, lastStateFile);
+    zapStateInfo(&si);
+    return result;
+  }
+
+  errno = 0;
+  fPtr = fopen(destFile, "w");
+  if(!fPtr){
+    fprintf(stderr, "%s: Error failed fopen() for file <%s>: %s\n", progName, destFile, strerror(errno));
+    zapStateInfo(&si);
+    return ztOpenFileError;
+  }
+
+  fprintf(fPtr, "#%s merged change files: sequence %u to %u\n", progName, first, last);
+  fprintf(fPtr, "sequenceNumber=%s\n", si->seqNumStr);
+  fprintf(fPtr, "timestamp=%s\n", si->timeString);
+
+  zapStateInfo(&si);
+
+  if(fclose(fPtr) != 0){
+    fprintf(stderr, "%s: Error failed fclose() for file <%s>\n", progName, destFile);
+    return ztWriteError;
+  }
+
+  return ztSuccess;
+
+} /* END writeMergedState() **/
+
+static int compareRec(const void *first, const void *second){
+
+  const MERGE_REC  *a = (const MERGE_REC *) first;
+  const MERGE_REC  *b = (const MERGE_REC *) second;
+
+  if(a->type != b->type)
+    return (a->type < b->type) ? -1 : 1;
+
+  if(a->id != b->id)
+    return (a->id < b->id) ? -1 : 1;
+
+  if(a->version != b->version)
+    return (a->version < b->version) ? -1 : 1;
+
+  if(a->order != b->order)
+    return (a->order < b->order) ? -1 : 1;
+
+  return 0;
+
+} /* END compareRec() **/
+
+/* openRun(): unlinked temporary run file in 'tmpDir' **/
+
+static int openRun(FILE **runFP, const char *tmpDir){
+
+  char    template[PATH_MAX];
+  int     fd;
+  FILE    *fp;
+
+  snprintf(template, sizeof(template), "%s/mergeRun.XXXXXX", tmpDir);
+
+  fd = mkstemp(template);
+  if(fd < 0){
+    fprintf(stderr, "%s: Error failed mkstemp() in <%s>: %s\n", progName, tmpDir, strerror(errno));
+    return ztFailedSysCall;
+  }
+
+  /* gone from directory; space is returned when closed **/
+  unlink(template);
+
+  fp = fdopen(fd, "w+");
+  if(!fp){
+    close(fd);
+    return ztFailedSysCall;
+  }
+
+  *runFP = fp;
+
+  return ztSuccess;
+
+} /* END openRun() **/
+
+static int putRecord(FILE *runFP, const MERGE_REC *rec){
+
+  if(fwrite(rec, sizeof(MERGE_REC), 1, runFP) != 1 ||
+     fwrite(rec->text, 1, rec->length, runFP) != rec->length){
+
+    fprintf(stderr, "%s: Error failed writing merge run file.\n", progName);
+    return ztWriteError;
+  }
+
+  return ztSuccess;
+
+} /* END putRecord() **/
+
+/* writeRun(): sorted records to unlinked temporary file in 'tmpDir' **/
+
+static int writeRun(FILE **runFP, MERGE_REC *records, size_t count, const char *tmpDir){
+
+  FILE    *fp;
+  size_t  n;
+  int     result;
+
+  result = openRun(&fp, tmpDir);
+  if(result != ztSuccess)
+    return result;
+
+  for(n = 0; n < count; n++){
+
+    result = putRecord(fp, &records[n]);
+    if(result != ztSuccess){
+      fclose(fp);
+      return result;
+    }
+  }
+
+  if(fflush(fp) != 0){
+    fclose(fp);
+    return ztWriteError;
+  }
+
+  *runFP = fp;
+
+  return ztSuccess;
+
+} /* END writeRun() **/
+
+static int readRun(MERGE_RUN *run){
+
+  char    *text = run->current.text;
+  size_t  textSize = run->textSize;
+
+  if(fread(&run->current, sizeof(MERGE_REC), 1, run->fp) != 1){
+    run->current.text = text;
+    run->done = 1;
+    return ztSuccess;
+  }
+
+  if(run->current.length + 1 > textSize){
+
+    char *tmp = (char *) realloc(text, run->current.length + 1);
+    if(!tmp){
+      run->current.text = text;
+      return ztMemoryAllocate;
+    }
+
+    text = tmp;
+    run->textSize = run->current.length + 1;
+  }
+
+  run->current.text = text;
+
+  if(fread(text, 1, run->current.length, run->fp) != run->current.length){
+    fprintf(stderr, "%s: Error short read from merge run file.\n", progName);
+    return ztFileError;
+  }
+
+  text[run->current.length] = '\0';
+
+  return ztSuccess;
+
+} /* END readRun() **/
+
+/* mergeRuns(): k-way merge of sorted 'runs'; last record of each object
+ * goes to 'out' when set, else it is appended to 'runFP' as one run.
+ *
+ ***************************************************************************/
+static int mergeRuns(MERGE_RUN *runs, int numRuns, MERGE_OUT *out, FILE *runFP){
+
+  MERGE_REC  held;
+  MERGE_REC  *pending = NULL, *best;
+  int        result = ztSuccess;
+  int        i;
+
+  memset(&held, 0, sizeof(MERGE_REC));
+
+  for(i = 0; i < numRuns && result == ztSuccess; i++){
+    rewind(runs[i].fp);
+    runs[i].done = 0;
+    result = readRun(&runs[i]);
+  }
+
+  while(result == ztSuccess){
+
+    best = NULL;
+    for(i = 0; i < numRuns; i++)
+      if(!runs[i].done && (!best || compareRec(&runs[i].current, best) < 0))
+        best = &runs[i].current;
+
+    if(!best)
+      break;
+
+    if(pending && (held.type != best->type || held.id != best->id)){
+      result = out ? emitRecord(out, &held) : putRecord(runFP, &held);
+      if(result != ztSuccess)
+        break;
+    }
+
+    /* keep a copy; run buffer is reused on next read **/
+    if(held.text == NULL || held.length < best->length){
+      char *tmp = (char *) realloc(held.text, best->length + 1);
+      if(!tmp){
+        result = ztMemoryAllocate;
+        break;
+      }
+      held.text = tmp;
+    }
+
+    memcpy(held.text, best->text, best->length + 1);
+    held.type = best->type;
+    held.action = best->action;
+    held.id = best->id;
+    held.version = best->version;
+    held.order = best->order;
+    held.length = best->length;
+    pending = &held;
+
+    for(i = 0; i < numRuns; i++)
+      if(&runs[i].current == best)
+        result = readRun(&runs[i]);
+  }
+
+  if(pending && result == ztSuccess)
+    result = out ? emitRecord(out, pending) : putRecord(runFP, pending);
+
+  if(held.text)
+    free(held.text);
+
+  return result;
+
+} /* END mergeRuns() **/
+
+/* cascadeRuns(): merges all open runs into one new run; later records of
+ * an object still win over the ones kept here. Sets *numRuns to 1.
+ *
+ ***************************************************************************/
+static int cascadeRuns(MERGE_RUN *runs, int *numRuns, const char *tmpDir){
+
+  FILE  *fp;
+  int   result;
+  int   i;
+
+  result = openRun(&fp, tmpDir);
+  if(result != ztSuccess)
+    return result;
+
+  result = mergeRuns(runs, *numRuns, NULL, fp);
+
+  if(result == ztSuccess && fflush(fp) != 0)
+    result = ztWriteError;
+
+  if(result != ztSuccess){
+    fclose(fp);
+    return result;
+  }
+
+  for(i = 0; i < *numRuns; i++){
+    fclose(runs[i].fp);
+    if(runs[i].current.text)
+      free(runs[i].current.text);
+    memset(&runs[i], 0, sizeof(MERGE_RUN));
+  }
+
+  runs[0].fp = fp;
+  *numRuns = 1;
+
+  if(fVerbose)
+    fprintf(stdout, "%s: Merged <%d> temporary runs into one.\n", progName, MERGE_MAX_RUNS);
+
+  return ztSuccess;
+
+} /* END cascadeRuns() **/
+
+static int emitRecord(MERGE_OUT *out, const MERGE_REC *rec){
+
+  if(rec->action != out->action){
+
+    if(out->action != OSC_NO_ACTION)
+      gzprintf(out->gz, "</%s>\n", oscActionName(out->action));
+
+    gzprintf(out->gz, "<%s>\n", oscActionName(rec->action));
+    out->action = rec->action;
+  }
+
+  if(gzputs(out->gz, "  ") < 0 ||
+     gzwrite(out->gz, rec->text, (unsigned) rec->length) != (int) rec->length ||
+     gzputs(out->gz, "\n") < 0){
+
+    fprintf(stderr, "%s: Error failed writing merge output.\n", progName);
+    return ztWriteError;
+  }
+
+  out->count++;
+
+  return ztSuccess;
+
+} /* END emitRecord() **/
+
+static void freeRecords(MERGE_REC *records, size_t count){
+
+  for(size_t n = 0; n < count; n++){
+    free(records[n].text);
+    records[n].text = NULL;
+  }
+
+} /* END freeRecords() **/
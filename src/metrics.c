@@ -0,0 +1,716 @@
+/*
+ * metrics.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Prometheus textfile metrics; see metrics.h.
+ *
+ * Counters are kept in memory and written whole each time; file left by
+ * last run is read back by startMetrics() so counters keep going up across
+ * runs as Prometheus expects. A missing or foreign file starts from zero.
+ * Functions are called from main thread only - download functions in
+ * curlfn.c and downloadFilesList() - so no lock is taken.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "metrics.h"
+#include "gd_primitives.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+#include "debug.h"
+
+#define METRICS_PREFIX  "getdiff_"
+#define METRICS_CODES   32
+#define METRICS_LINE    1024
+#define METRICS_LABEL   512
+
+typedef struct CODE_COUNT_ {
+
+  long                code;    /* HTTP response code; zero is no response **/
+  unsigned long long  count;
+
+} CODE_COUNT;
+
+typedef struct CODE_SET_ {
+
+  CODE_COUNT  entry[METRICS_CODES];
+  int         count;
+
+} CODE_SET;
+
+/* freshness lag bucket upper bounds in seconds; last bucket is +Inf **/
+static const long lagBounds[] = {60, 120, 300, 600, 1800, 3600, 7200, 21600, 86400, 172800};
+
+#define LAG_BUCKETS  ((int) (sizeof(lagBounds) / sizeof(lagBounds[0])))
+
+static const char *phaseNames[] = {"setup", "latest", "list", "download", "finish"};
+
+static int   metricsOn = 0;
+static char  metricsName[PATH_MAX];
+static char  sourceLabel[METRICS_LABEL];
+
+static unsigned long long  filesTotal;
+static unsigned long long  bytesTotal;
+static unsigned long long  requestBytes;
+static unsigned long long  runsTotal[2];   /* failure, success **/
+static CODE_SET            requests;
+static CODE_SET            retries;
+
+static unsigned long long  lagBucket[LAG_BUCKETS + 1];  /* cumulative, last is +Inf **/
+static double              lagSum;
+static unsigned long long  lagCount;
+
+static long long  latestSeq = -1;
+static long long  latestTime = -1;
+static int        lastSuccess = -1;   /* kept while run goes **/
+
+static METRICS_PHASE    currentPhase;
+static double           phaseSeconds[METRICS_PHASES];
+static struct timespec  phaseStart;
+static struct timespec  runStart;
+static struct timespec  lastWrite;
+static time_t           runStartWall;
+
+static void resetCounters(void);
+static int readMetrics(const char *name);
+static int writeMetrics(int done);
+static void addCode(CODE_SET *set, long code, unsigned long long count);
+static int getLabel(char *dest, size_t size, const char *labels, const char *name);
+static double elapsed(struct timespec *since);
+static int escapeLabel(char *dest, size_t size, const char *value);
+
+/* startMetrics(): metrics file for source tree 'treeDir' in 'dir'; name and
+ * "source" label are 'treeDir' relative to 'workDir'. Counters from last
+ * run file are read back.
+ *
+ ***************************************************************************/
+
+int startMetrics(const char *dir, const char *treeDir, const char *workDir){
+
+  ASSERTARGS(dir && treeDir && workDir);
+
+  char    tree[PATH_MAX];
+  char    *ptr;
+  size_t  length;
+  int     result;
+
+  metricsOn = 0;
+
+  result = isDirUsable(dir);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error metrics directory is not usable: <%s>\n", progName, dir);
+    return result;
+  }
+
+  /* "planet/minute" from "{workDir}/planet/minute/" **/
+  length = strlen(workDir);
+  if(strncmp(treeDir, workDir, length) == 0)
+    treeDir += length;
+
+  while(*treeDir == '/')
+    treeDir++;
+
+  if(strlen(treeDir) >= sizeof(tree))
+    return ztFnameLong;
+
+  strcpy(tree, treeDir);
+
+  length = strlen(tree);
+  while(length && tree[length - 1] == '/')
+    tree[--length] = '\0';
+
+  if(!length)
+    strcpy(tree, "source");
+
+  if(escapeLabel(sourceLabel, sizeof(sourceLabel), tree) != ztSuccess)
+    return ztFnameLong;
+
+  for(ptr = tree; *ptr; ptr++)
+    if(*ptr == '/' || *ptr == ' ')
+      *ptr = '-';
+
+  if(snprintf(metricsName, sizeof(metricsName), "%s%sgetdiff-%s.prom",
+              dir, SLASH_ENDING(dir) ? "" : "/", tree) >= (int) sizeof(metricsName) - 4)
+    return ztFnameLong;
+
+  resetCounters();
+  memset(phaseSeconds, 0, sizeof(phaseSeconds));
+
+  /* counters start from zero when last file is not ours **/
+  if(access(metricsName, F_OK) == 0 && readMetrics(metricsName) != ztSuccess){
+
+    fprintf(stderr, "%s: Warning metrics file is not readable; counters start at zero: <%s>\n",
+            progName, metricsName);
+    logMessage(fLogPtr, "Warning metrics file is not readable; counters start at zero.");
+
+    resetCounters();
+  }
+
+  runStartWall = time(NULL);
+  clock_gettime(CLOCK_MONOTONIC, &runStart);
+  phaseStart = lastWrite = runStart;
+  currentPhase = METRICS_SETUP;
+
+  metricsOn = 1;
+
+  return ztSuccess;
+
+} /* END startMetrics() **/
+
+int isMetricsOn(void){
+
+  return metricsOn;
+
+} /* END isMetricsOn() **/
+
+/* metricsPhase(): ends current phase and starts 'phase'; time is added,
+ * so a phase entered twice is counted once with both parts.
+ *
+ ***************************************************************************/
+
+void metricsPhase(METRICS_PHASE phase){
+
+  if(!metricsOn || phase >= METRICS_PHASES)
+
+    return;
+
+  phaseSeconds[currentPhase] += elapsed(&phaseStart);
+
+  clock_gettime(CLOCK_MONOTONIC, &phaseStart);
+  currentPhase = phase;
+
+  return;
+
+} /* END metricsPhase() **/
+
+/* metricsRequest(): one transfer with response 'code' and 'bytes' received;
+ * called for every attempt, retries too.
+ *
+ ***************************************************************************/
+
+void metricsRequest(long code, long long bytes){
+
+  if(!metricsOn)
+
+    return;
+
+  addCode(&requests, code < 0 ? 0 : code, 1);
+
+  if(bytes > 0)
+    requestBytes += (unsigned long long) bytes;
+
+  return;
+
+} /* END metricsRequest() **/
+
+void metricsRetry(long code){
+
+  if(!metricsOn)
+
+    return;
+
+  addCode(&retries, code < 0 ? 0 : code, 1);
+
+  return;
+
+} /* END metricsRetry() **/
+
+/* metricsFile(): one file downloaded for source tree with 'bytes' size **/
+
+void metricsFile(long long bytes){
+
+  if(!metricsOn)
+
+    return;
+
+  filesTotal++;
+
+  if(bytes > 0)
+    bytesTotal += (unsigned long long) bytes;
+
+  return;
+
+} /* END metricsFile() **/
+
+/* metricsState(): latest local sequence and timestamp from 'stateFile'
+ * when it is newer than what we have.
+ *
+ ***************************************************************************/
+
+void metricsState(const char *stateFile){
+
+  STATE_INFO  *si;
+  long long   seq;
+
+  if(!metricsOn || !stateFile)
+
+    return;
+
+  si = initialStateInfo();
+  if(!si)
+
+    return;
+
+  if(stateFile2StateInfo(si, stateFile) == ztSuccess){
+
+    seq = atoll(si->seqNumStr);
+
+    if(seq >= latestSeq){
+      latestSeq = seq;
+      latestTime = (long long) si->timeValue;
+    }
+  }
+
+  zapStateInfo(&si);
+
+  return;
+
+} /* END metricsState() **/
+
+/* metricsTick(): writes metrics file when METRICS_INTERVAL seconds passed
+ * since last write; long runs show progress to collector.
+ *
+ ***************************************************************************/
+
+void metricsTick(void){
+
+  if(!metricsOn || elapsed(&lastWrite) < (double) METRICS_INTERVAL)
+
+    return;
+
+  if(writeMetrics(0) != ztSuccess)
+    logMessage(fLogPtr, "Warning failed writeMetrics() function.");
+
+  return;
+
+} /* END metricsTick() **/
+
+/* finishMetrics(): ends run with 'result'; counts run, observes freshness
+ * lag and writes metrics file for last time.
+ *
+ ***************************************************************************/
+
+int finishMetrics(int result){
+
+  int   retCode;
+  long  lag;
+  int   i;
+
+  if(!metricsOn)
+
+    return ztSuccess;
+
+  phaseSeconds[currentPhase] += elapsed(&phaseStart);
+  clock_gettime(CLOCK_MONOTONIC, &phaseStart);
+
+  runsTotal[result == ztSuccess ? 1 : 0]++;
+  lastSuccess = (result == ztSuccess);
+
+  if(latestTime >= 0){
+
+    lag = (long) (time(NULL) - (time_t) latestTime);
+    if(lag < 0)
+      lag = 0;
+
+    for(i = 0; i < LAG_BUCKETS; i++)
+      if(lag <= lagBounds[i])
+        lagBucket[i]++;
+
+    lagBucket[LAG_BUCKETS]++;
+    lagSum += (double) lag;
+    lagCount++;
+  }
+
+  retCode = writeMetrics(1);
+  if(retCode != ztSuccess){
+    fprintf(stderr, "%s: Error failed to write metrics file: <%s>\n", progName, metricsName);
+    logMessage(fLogPtr, "Error failed to write metrics file.");
+  }
+
+  metricsOn = 0;
+
+  return retCode;
+
+} /* END finishMetrics() **/
+
+static void resetCounters(void){
+
+  filesTotal = bytesTotal = requestBytes = 0;
+  runsTotal[0] = runsTotal[1] = 0;
+  memset(&requests, 0, sizeof(CODE_SET));
+  memset(&retries, 0, sizeof(CODE_SET));
+  memset(lagBucket, 0, sizeof(lagBucket));
+  lagSum = 0.0;
+  lagCount = 0;
+  latestSeq = latestTime = -1;
+  lastSuccess = -1;
+
+  return;
+
+} /* END resetCounters() **/
+
+/* readMetrics(): counters from metrics file 'name' written by last run;
+ * lines are "name{labels} value". Unknown lines are skipped.
+ *
+ ***************************************************************************/
+
+static int readMetrics(const char *name){
+
+  FILE                *fPtr;
+  char                line[METRICS_LINE];
+  char                label[64];
+  char                *metric, *labels, *value, *end;
+  unsigned long long  count;
+  double              number;
+  size_t              prefixLength = strlen(METRICS_PREFIX);
+  int                 i;
+
+  fPtr = fopen(name, "r");
+  if(!fPtr)
+
+    return ztOpenFileError;
+
+  while(fgets(line, sizeof(line), fPtr)){
+
+    if(line[0] == '#' || strncmp(line, METRICS_PREFIX, prefixLength) != 0)
+      continue;
+
+    metric = line + prefixLength;
+    labels = NULL;
+
+    value = strchr(metric, '{');
+    if(value){
+      *value = '\0';
+      labels = value + 1;
+
+      value = strrchr(labels, '}');
+      if(!value)
+        continue;
+
+      *value++ = '\0';
+    }
+    else {
+      value = strchr(metric, ' ');
+      if(!value)
+        continue;
+
+      *value++ = '\0';
+    }
+
+    errno = 0;
+    number = strtod(value, &end);
+    if(errno || end == value || number < 0)
+      continue;
+
+    count = (unsigned long long) number;
+
+    if(strcmp(metric, "files_downloaded_total") == 0)
+      filesTotal = count;
+
+    else if(strcmp(metric, "bytes_downloaded_total") == 0)
+      bytesTotal = count;
+
+    else if(strcmp(metric, "request_bytes_total") == 0)
+      requestBytes = count;
+
+    else if(strcmp(metric, "requests_total") == 0 ||
+            strcmp(metric, "retries_total") == 0){
+
+      if(!labels || getLabel(label, sizeof(label), labels, "code") != ztSuccess)
+        continue;
+
+      addCode(strcmp(metric, "requests_total") == 0 ? &requests : &retries,
+              strcmp(label, "none") == 0 ? 0 : atol(label), count);
+    }
+
+    else if(strcmp(metric, "runs_total") == 0){
+
+      if(!labels || getLabel(label, sizeof(label), labels, "result") != ztSuccess)
+        continue;
+
+      runsTotal[strcmp(label, "success") == 0 ? 1 : 0] = count;
+    }
+
+    else if(strcmp(metric, "freshness_lag_seconds_bucket") == 0){
+
+      if(!labels || getLabel(label, sizeof(label), labels, "le") != ztSuccess)
+        continue;
+
+      if(strcmp(label, "+Inf") == 0)
+        lagBucket[LAG_BUCKETS] = count;
+
+      else
+        for(i = 0; i < LAG_BUCKETS; i++)
+          if(atol(label) == lagBounds[i])
+            lagBucket[i] = count;
+    }
+
+    else if(strcmp(metric, "freshness_lag_seconds_sum") == 0)
+      lagSum = number;
+
+    else if(strcmp(metric, "freshness_lag_seconds_count") == 0)
+      lagCount = count;
+
+    else if(strcmp(metric, "latest_sequence") == 0)
+      latestSeq = (long long) count;
+
+    else if(strcmp(metric, "latest_timestamp_seconds") == 0)
+      latestTime = (long long) count;
+
+    else if(strcmp(metric, "last_run_success") == 0)
+      lastSuccess = (count != 0);
+
+    else ;
+  }
+
+  fclose(fPtr);
+
+  return ztSuccess;
+
+} /* END readMetrics() **/
+
+/* writeMetrics(): writes all metrics to temporary file in same directory,
+ * syncs then renames it over metrics file. 'done' is set at end of run.
+ *
+ ***************************************************************************/
+
+static int writeMetrics(int done){
+
+  FILE    *fPtr;
+  char    tmpName[PATH_MAX + 8];
+  char    codeStr[24];
+  double  phases[METRICS_PHASES];
+  double  runSeconds;
+  int     i;
+
+  const char *src = sourceLabel;
+
+  /* current phase up to now; it is not closed **/
+  memcpy(phases, phaseSeconds, sizeof(phases));
+  if(!done)
+    phases[currentPhase] += elapsed(&phaseStart);
+
+  runSeconds = elapsed(&runStart);
+
+  sprintf(tmpName, "%s.tmp", metricsName);
+
+  fPtr = fopen(tmpName, "w");
+  if(!fPtr){
+    fprintf(stderr, "%s: Error failed fopen() for metrics file: <%s>; %s\n", progName, tmpName, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  fprintf(fPtr, "# HELP getdiff_files_downloaded_total Change and state.txt files downloaded.\n"
+                "# TYPE getdiff_files_downloaded_total counter\n"
+                "getdiff_files_downloaded_total{source=\"%s\"} %llu\n", src, filesTotal);
+
+  fprintf(fPtr, "# HELP getdiff_bytes_downloaded_total Bytes in downloaded change and state.txt files.\n"
+                "# TYPE getdiff_bytes_downloaded_total counter\n"
+                "getdiff_bytes_downloaded_total{source=\"%s\"} %llu\n", src, bytesTotal);
+
+  fprintf(fPtr, "# HELP getdiff_request_bytes_total Bytes received by all requests; listings and retries too.\n"
+                "# TYPE getdiff_request_bytes_total counter\n"
+                "getdiff_request_bytes_total{source=\"%s\"} %llu\n", src, requestBytes);
+
+  fprintf(fPtr, "# HELP getdiff_requests_total Requests to remote server by response code; none is no response.\n"
+                "# TYPE getdiff_requests_total counter\n");
+
+  for(i = 0; i < requests.count; i++){
+    if(requests.entry[i].code)
+      sprintf(codeStr, "%ld", requests.entry[i].code);
+    else
+      strcpy(codeStr, "none");
+
+    fprintf(fPtr, "getdiff_requests_total{source=\"%s\",code=\"%s\"} %llu\n", src, codeStr, requests.entry[i].count);
+  }
+
+  fprintf(fPtr, "# HELP getdiff_retries_total Requests retried by response code of failed attempt.\n"
+                "# TYPE getdiff_retries_total counter\n");
+
+  for(i = 0; i < retries.count; i++){
+    if(retries.entry[i].code)
+      sprintf(codeStr, "%ld", retries.entry[i].code);
+    else
+      strcpy(codeStr, "none");
+
+    fprintf(fPtr, "getdiff_retries_total{source=\"%s\",code=\"%s\"} %llu\n", src, codeStr, retries.entry[i].count);
+  }
+
+  fprintf(fPtr, "# HELP getdiff_runs_total Program runs by result.\n"
+                "# TYPE getdiff_runs_total counter\n"
+                "getdiff_runs_total{source=\"%s\",result=\"success\"} %llu\n"
+                "getdiff_runs_total{source=\"%s\",result=\"failure\"} %llu\n",
+                src, runsTotal[1], src, runsTotal[0]);
+
+  fprintf(fPtr, "# HELP getdiff_phase_duration_seconds Time spent in each phase of last run.\n"
+                "# TYPE getdiff_phase_duration_seconds gauge\n");
+
+  for(i = 0; i < METRICS_PHASES; i++)
+    fprintf(fPtr, "getdiff_phase_duration_seconds{source=\"%s\",phase=\"%s\"} %.3f\n", src, phaseNames[i], phases[i]);
+
+  fprintf(fPtr, "# HELP getdiff_run_duration_seconds Duration of last run; so far while it runs.\n"
+                "# TYPE getdiff_run_duration_seconds gauge\n"
+                "getdiff_run_duration_seconds{source=\"%s\"} %.3f\n", src, runSeconds);
+
+  fprintf(fPtr, "# HELP getdiff_run_start_timestamp_seconds Start time of last run.\n"
+                "# TYPE getdiff_run_start_timestamp_seconds gauge\n"
+                "getdiff_run_start_timestamp_seconds{source=\"%s\"} %lld\n", src, (long long) runStartWall);
+
+  fprintf(fPtr, "# HELP getdiff_run_in_progress One while run is going; zero when it ended.\n"
+                "# TYPE getdiff_run_in_progress gauge\n"
+                "getdiff_run_in_progress{source=\"%s\"} %d\n", src, done ? 0 : 1);
+
+  if(lastSuccess >= 0)
+    fprintf(fPtr, "# HELP getdiff_last_run_success One when last ended run had no error.\n"
+                  "# TYPE getdiff_last_run_success gauge\n"
+                  "getdiff_last_run_success{source=\"%s\"} %d\n", src, lastSuccess);
+
+  if(latestSeq >= 0){
+
+    fprintf(fPtr, "# HELP getdiff_latest_sequence Latest sequence number in local change files tree.\n"
+                  "# TYPE getdiff_latest_sequence gauge\n"
+                  "getdiff_latest_sequence{source=\"%s\"} %lld\n", src, latestSeq);
+
+    fprintf(fPtr, "# HELP getdiff_latest_timestamp_seconds Timestamp in latest local state.txt file.\n"
+                  "# TYPE getdiff_latest_timestamp_seconds gauge\n"
+                  "getdiff_latest_timestamp_seconds{source=\"%s\"} %lld\n", src, latestTime);
+  }
+
+  fprintf(fPtr, "# HELP getdiff_freshness_lag_seconds Now minus latest local state.txt timestamp; one per run.\n"
+                "# TYPE getdiff_freshness_lag_seconds histogram\n");
+
+  for(i = 0; i < LAG_BUCKETS; i++)
+    fprintf(fPtr, "getdiff_freshness_lag_seconds_bucket{source=\"%s\",le=\"%ld\"} %llu\n", src, lagBounds[i], lagBucket[i]);
+
+  fprintf(fPtr, "getdiff_freshness_lag_seconds_bucket{source=\"%s\",le=\"+Inf\"} %llu\n"
+                "getdiff_freshness_lag_seconds_sum{source=\"%s\"} %.0f\n"
+                "getdiff_freshness_lag_seconds_count{source=\"%s\"} %llu\n",
+                src, lagBucket[LAG_BUCKETS], src, lagSum, src, lagCount);
+
+  if(fflush(fPtr) != 0 || ferror(fPtr) || fsync(fileno(fPtr)) != 0){
+    fprintf(stderr, "%s: Error failed writing metrics file: <%s>; %s\n", progName, tmpName, strerror(errno));
+    fclose(fPtr);
+    unlink(tmpName);
+    return ztWriteError;
+  }
+
+  fclose(fPtr);
+
+  if(rename(tmpName, metricsName) != 0){
+    fprintf(stderr, "%s: Error failed rename() for metrics file: <%s>; %s\n", progName, metricsName, strerror(errno));
+    unlink(tmpName);
+    return ztFailedSysCall;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &lastWrite);
+
+  return ztSuccess;
+
+} /* END writeMetrics() **/
+
+/* addCode(): adds 'count' to 'code' in 'set'; codes past METRICS_CODES
+ * are counted with last one.
+ *
+ ***************************************************************************/
+
+static void addCode(CODE_SET *set, long code, unsigned long long count){
+
+  int  i;
+
+  for(i = 0; i < set->count; i++)
+    if(set->entry[i].code == code){
+      set->entry[i].count += count;
+      return;
+    }
+
+  if(set->count == METRICS_CODES){
+    set->entry[METRICS_CODES - 1].count += count;
+    return;
+  }
+
+  set->entry[set->count].code = code;
+  set->entry[set->count].count = count;
+  set->count++;
+
+  return;
+
+} /* END addCode() **/
+
+/* getLabel(): value of label 'name' in 'labels' - a="1",b="2" - to 'dest' **/
+
+static int getLabel(char *dest, size_t size, const char *labels, const char *name){
+
+  const char  *ptr = labels;
+  const char  *end;
+  size_t      length = strlen(name);
+
+  while((ptr = strstr(ptr, name))){
+
+    if((ptr == labels || ptr[-1] == ',') && strncmp(ptr + length, "=\"", 2) == 0){
+
+      ptr += length + 2;
+      end = strchr(ptr, '"');
+      if(!end || (size_t) (end - ptr) >= size)
+
+        return ztParseError;
+
+      memcpy(dest, ptr, end - ptr);
+      dest[end - ptr] = '\0';
+
+      return ztSuccess;
+    }
+
+    ptr += length;
+  }
+
+  return ztStringNotFound;
+
+} /* END getLabel() **/
+
+static double elapsed(struct timespec *since){
+
+  struct timespec  now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (double) (now.tv_sec - since->tv_sec) + (double) (now.tv_nsec - since->tv_nsec) / 1e9;
+
+} /* END elapsed() **/
+
+/* escapeLabel(): label value with backslash, double quote and newline escaped **/
+
+static int escapeLabel(char *dest, size_t size, const char *value){
+
+  size_t  used = 0;
+
+  for(; *value; value++){
+
+    if(used + 3 > size)
+
+      return ztFnameLong;
+
+    if(*value == '\\' || *value == '"'){
+      dest[used++] = '\\';
+      dest[used++] = *value;
+    }
+    else if(*value == '\n'){
+      dest[used++] = '\\';
+      dest[used++] = 'n';
+    }
+    else
+      dest[used++] = *value;
+  }
+
+  dest[used] = '\0';
+
+  return ztSuccess;
+
+} /* END escapeLabel() **/
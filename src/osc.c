@@ -0,0 +1,500 @@
+/*
+ * osc.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * streaming osmChange reader; see osc.h.
+ *
+ * This is not a general XML parser. osmChange files have a fixed shape:
+ *
+ *  <osmChange version="0.6" ...>
+ *   <create|modify|delete>
+ *     <node .../> | <node ...> children </node>
+ *     <way ...> <nd .../> <tag .../> </way>
+ *     <relation ...> <member .../> <tag .../> </relation>
+ *   </create|modify|delete>
+ *  </osmChange>
+ *
+ * text between tags is white space only and is dropped; children are kept
+ * one per line in element text.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "osc.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+
+static int readChar(OSC_READER *reader);
+static int nextTag(OSC_READER *reader);
+static int appendElem(OSC_READER *reader, const char *text, size_t length);
+static int isTagName(const char *tag, const char *name);
+static int setElement(OSC_ELEMENT *element, OSC_READER *reader, OSC_TYPE type);
+
+OSC_READER *oscOpen(const char *filename){
+
+  ASSERTARGS(filename);
+
+  OSC_READER  *reader;
+
+  reader = (OSC_READER *) malloc(sizeof(OSC_READER));
+  if(!reader){
+    fprintf(stderr, "%s: Error allocating memory in oscOpen().\n", progName);
+    return NULL;
+  }
+
+  memset(reader, 0, sizeof(OSC_READER));
+
+  /* gzread() reads plain files too and concatenated gzip members **/
+  reader->gz = gzopen(filename, "rb");
+  if(!reader->gz){
+    fprintf(stderr, "%s: Error failed gzopen() for file: <%s>\n", progName, filename);
+    free(reader);
+    return NULL;
+  }
+
+  gzbuffer(reader->gz, 128 * 1024);
+
+  return reader;
+
+} /* END oscOpen() **/
+
+void oscClose(OSC_READER **reader){
+
+  ASSERTARGS(reader);
+
+  OSC_READER  *myReader = *reader;
+
+  if(!myReader)
+    return;
+
+  if(myReader->gz)
+    gzclose(myReader->gz);
+
+  if(myReader->tag)
+    free(myReader->tag);
+
+  if(myReader->elem)
+    free(myReader->elem);
+
+  free(myReader);
+
+  *reader = NULL;
+
+} /* END oscClose() **/
+
+/* oscNext(): next element in file.
+ *
+ * returns ztSuccess with 'element' set, ztEndOfFile when no more elements,
+ * ztMalformedFile for element outside an action or missing end tag,
+ * ztFileError on read error and ztMemoryAllocate.
+ *
+ ***************************************************************************/
+
+int oscNext(OSC_READER *reader, OSC_ELEMENT *element){
+
+  ASSERTARGS(reader && element);
+
+  int        result;
+  OSC_TYPE   type;
+  char       *name;
+  char       endTag[16];
+
+  while((result = nextTag(reader)) == ztSuccess){
+
+    name = reader->tag + 1;
+
+    if(*name == '/'){ /* closing create, modify, delete or osmChange **/
+
+      if(isTagName(name + 1, "create") || isTagName(name + 1, "modify") || isTagName(name + 1, "delete"))
+        reader->action = OSC_NO_ACTION;
+
+      continue;
+    }
+
+    /* empty action: <delete/> **/
+    if(reader->tag[reader->tagLen - 2] == '/' &&
+       (isTagName(name, "create") || isTagName(name, "modify") || isTagName(name, "delete")))
+      continue;
+
+    if(isTagName(name, "create")){
+      reader->action = OSC_CREATE;
+      continue;
+    }
+
+    if(isTagName(name, "modify")){
+      reader->action = OSC_MODIFY;
+      continue;
+    }
+
+    if(isTagName(name, "delete")){
+      reader->action = OSC_DELETE;
+      continue;
+    }
+
+    if(isTagName(name, "node"))
+      type = OSC_NODE;
+    else if(isTagName(name, "way"))
+      type = OSC_WAY;
+    else if(isTagName(name, "relation"))
+      type = OSC_RELATION;
+    else
+      continue; /* xml declaration, osmChange, bounds ... **/
+
+    if(reader->action == OSC_NO_ACTION){
+      fprintf(stderr, "%s: Error osmChange element outside create, modify or delete.\n", progName);
+      return ztMalformedFile;
+    }
+
+    reader->elemLen = 0;
+    if(appendElem(reader, reader->tag, reader->tagLen) != ztSuccess)
+      return ztMemoryAllocate;
+
+    /* start tag is kept at start of element text; attributes are read there **/
+    if(reader->tag[reader->tagLen - 2] == '/')
+
+      return setElement(element, reader, type);
+
+    sprintf(endTag, "</%s>", oscTypeName(type));
+
+    while((result = nextTag(reader)) == ztSuccess){
+
+      if(strcmp(reader->tag, endTag) == 0){
+
+        if(appendElem(reader, "\n  ", 3) != ztSuccess ||
+           appendElem(reader, reader->tag, reader->tagLen) != ztSuccess)
+          return ztMemoryAllocate;
+
+        return setElement(element, reader, type);
+      }
+
+      if(appendElem(reader, "\n    ", 5) != ztSuccess ||
+         appendElem(reader, reader->tag, reader->tagLen) != ztSuccess)
+        return ztMemoryAllocate;
+    }
+
+    if(result == ztEndOfFile){
+      fprintf(stderr, "%s: Error osmChange element without end tag.\n", progName);
+      return ztMalformedFile;
+    }
+
+    return result;
+  }
+
+  return result;
+
+} /* END oscNext() **/
+
+/* oscAttribute(): finds attribute 'name' in 'tag'; sets 'value' to its first
+ * character - not null terminated - and 'length'. Returns ztSuccess or
+ * ztStringNotFound.
+ *
+ ***************************************************************************/
+
+int oscAttribute(const char *tag, const char *name, const char **value, size_t *length){
+
+  ASSERTARGS(tag && name && value && length);
+
+  const char  *ptr = tag;
+  const char  *attrName, *close;
+  size_t      nameLen = strlen(name);
+  size_t      attrLen;
+  char        quote;
+
+  /* skip '<' and element name **/
+  if(*ptr == '<')
+    ptr++;
+
+  while(*ptr && *ptr != ' ' && *ptr != '\t' && *ptr != '\n' && *ptr != '\r' && *ptr != '>' && *ptr != '/')
+    ptr++;
+
+  while(*ptr){
+
+    while(*ptr == ' ' || *ptr == '\t' || *ptr == '\n' || *ptr == '\r')
+      ptr++;
+
+    if(*ptr == '\0' || *ptr == '>' || *ptr == '/')
+      break;
+
+    attrName = ptr;
+    while(*ptr && *ptr != '=' && *ptr != ' ' && *ptr != '>')
+      ptr++;
+
+    attrLen = (size_t) (ptr - attrName);
+
+    while(*ptr == ' ')
+      ptr++;
+
+    if(*ptr != '=')
+      break;
+
+    ptr++;
+    while(*ptr == ' ')
+      ptr++;
+
+    quote = *ptr;
+    if(quote != '"' && quote != '\'')
+      break;
+
+    ptr++;
+    close = strchr(ptr, quote);
+    if(!close)
+      break;
+
+    if(attrLen == nameLen && strncmp(attrName, name, nameLen) == 0){
+      *value = ptr;
+      *length = (size_t) (close - ptr);
+      return ztSuccess;
+    }
+
+    ptr = close + 1;
+  }
+
+  return ztStringNotFound;
+
+} /* END oscAttribute() **/
+
+const char *oscActionName(OSC_ACTION action){
+
+  switch(action){
+
+  case OSC_CREATE:
+    return "create";
+
+  case OSC_MODIFY:
+    return "modify";
+
+  case OSC_DELETE:
+    return "delete";
+
+  default:
+    break;
+  }
+
+  return "none";
+
+} /* END oscActionName() **/
+
+const char *oscTypeName(OSC_TYPE type){
+
+  switch(type){
+
+  case OSC_NODE:
+    return "node";
+
+  case OSC_WAY:
+    return "way";
+
+  case OSC_RELATION:
+    return "relation";
+
+  default:
+    break;
+  }
+
+  return "unknown";
+
+} /* END oscTypeName() **/
+
+static int setElement(OSC_ELEMENT *element, OSC_READER *reader, OSC_TYPE type){
+
+  const char  *value;
+  size_t      length;
+
+  memset(element, 0, sizeof(OSC_ELEMENT));
+
+  element->type = type;
+  element->action = reader->action;
+  element->text = reader->elem;
+  element->length = reader->elemLen;
+
+  /* attributes stop at first '>' - in start tag **/
+  if(oscAttribute(reader->elem, "id", &value, &length) != ztSuccess){
+    fprintf(stderr, "%s: Error osmChange %s element without id attribute.\n", progName, oscTypeName(type));
+    return ztMalformedFile;
+  }
+
+  element->id = strtoll(value, NULL, 10);
+
+  if(oscAttribute(reader->elem, "version", &value, &length) == ztSuccess)
+    element->version = strtol(value, NULL, 10);
+
+  if(type == OSC_NODE &&
+     oscAttribute(reader->elem, "lat", &value, &length) == ztSuccess){
+
+    element->lat = strtod(value, NULL);
+
+    if(oscAttribute(reader->elem, "lon", &value, &length) == ztSuccess){
+      element->lon = strtod(value, NULL);
+      element->hasLocation = 1;
+    }
+  }
+
+  return ztSuccess;
+
+} /* END setElement() **/
+
+/* isTagName(): TRUE when 'tag' - after '<' or "</" - starts with element 'name' **/
+
+static int isTagName(const char *tag, const char *name){
+
+  size_t  len = strlen(name);
+
+  if(strncmp(tag, name, len) != 0)
+    return FALSE;
+
+  return (tag[len] == ' ' || tag[len] == '>' || tag[len] == '/' ||
+          tag[len] == '\t' || tag[len] == '\n' || tag[len] == '\r');
+
+} /* END isTagName() **/
+
+static int readChar(OSC_READER *reader){
+
+  int  count;
+
+  if(reader->inPos < reader->inLen)
+
+    return reader->in[reader->inPos++];
+
+  if(reader->eof)
+
+    return EOF;
+
+  count = gzread(reader->gz, reader->in, sizeof(reader->in));
+
+  /* truncated gzip ends with Z_BUF_ERROR, not an error from gzread() **/
+  if(count == 0){
+    int zErr;
+    gzerror(reader->gz, &zErr);
+    if(zErr != Z_OK)
+      count = -1;
+  }
+
+  if(count <= 0){
+    reader->eof = (count == 0) ? 1 : -1;
+    return EOF;
+  }
+
+  reader->inLen = (size_t) count;
+  reader->inPos = 0;
+
+  return reader->in[reader->inPos++];
+
+} /* END readChar() **/
+
+/* nextTag(): reads next "<...>" into reader->tag; quoted '>' in attribute
+ * value does not end tag. Comments are skipped.
+ *
+ ***************************************************************************/
+
+static int nextTag(OSC_READER *reader){
+
+  int   ch;
+  char  quote = 0;
+  char  *tmp;
+
+  while(1){
+
+    while((ch = readChar(reader)) != EOF && ch != '<')
+      ;
+
+    if(ch == EOF)
+      return (reader->eof < 0) ? ztFileError : ztEndOfFile;
+
+    reader->tagLen = 0;
+    quote = 0;
+
+    do {
+
+      if(reader->tagLen + 2 > reader->tagSize){
+
+        size_t newSize = reader->tagSize ? reader->tagSize * 2 : 1024;
+
+        tmp = (char *) realloc(reader->tag, newSize);
+        if(!tmp){
+          fprintf(stderr, "%s: Error allocating memory in nextTag().\n", progName);
+          return ztMemoryAllocate;
+        }
+
+        reader->tag = tmp;
+        reader->tagSize = newSize;
+      }
+
+      reader->tag[reader->tagLen++] = (char) ch;
+
+      if(quote){
+        if(ch == quote)
+          quote = 0;
+      }
+      else if(ch == '"' || ch == '\'')
+        quote = (char) ch;
+      else if(ch == '>')
+        break;
+
+    } while((ch = readChar(reader)) != EOF);
+
+    if(ch == EOF)
+      return (reader->eof < 0) ? ztFileError : ztUnexpectedEOF;
+
+    reader->tag[reader->tagLen] = '\0';
+
+    if(reader->tagLen >= 4 && strncmp(reader->tag, "<!--", 4) == 0){
+
+      /* comment may have '>' in it; read up to "-->" **/
+      while(reader->tagLen < 7 || strcmp(reader->tag + reader->tagLen - 3, "-->") != 0){
+
+        int c1 = readChar(reader);
+        if(c1 == EOF)
+          return ztUnexpectedEOF;
+
+        if(reader->tagLen + 2 > reader->tagSize){
+          tmp = (char *) realloc(reader->tag, reader->tagSize * 2);
+          if(!tmp)
+            return ztMemoryAllocate;
+          reader->tag = tmp;
+          reader->tagSize *= 2;
+        }
+
+        reader->tag[reader->tagLen++] = (char) c1;
+        reader->tag[reader->tagLen] = '\0';
+      }
+
+      continue;
+    }
+
+    return ztSuccess;
+  }
+
+} /* END nextTag() **/
+
+static int appendElem(OSC_READER *reader, const char *text, size_t length){
+
+  char   *tmp;
+  size_t newSize;
+
+  if(reader->elemLen + length + 1 > reader->elemSize){
+
+    newSize = reader->elemSize ? reader->elemSize : 4096;
+    while(reader->elemLen + length + 1 > newSize)
+      newSize *= 2;
+
+    tmp = (char *) realloc(reader->elem, newSize);
+    if(!tmp){
+      fprintf(stderr, "%s: Error allocating memory in appendElem().\n", progName);
+      return ztMemoryAllocate;
+    }
+
+    reader->elem = tmp;
+    reader->elemSize = newSize;
+  }
+
+  memcpy(reader->elem + reader->elemLen, text, length);
+  reader->elemLen += length;
+  reader->elem[reader->elemLen] = '\0';
+
+  return ztSuccess;
+
+} /* END appendElem() **/
@@ -0,0 +1,693 @@
+/*
+ * pack.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * pack files for completed parent directories; see pack.h.
+ *
+ * pack is written to ".part" file, flushed to disk and renamed before any
+ * loose file is removed. A crash after rename leaves both; next packTree()
+ * removes loose files found in pack with the same length.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "pack.h"
+#include "crc32.h"
+#include "transcode.h"
+#include "util.h"
+#include "fileio.h"
+#include "ztError.h"
+#include "getdiff.h"
+#include "debug.h"
+
+#define PACK_BUFFER  (128 * 1024)
+
+static int packOneParent(PACK_REPORT *report, const char *rootDir, const char *parentEntry, SEQ_NUM base);
+static int removePacked(const char *parentDir, const char *packFile);
+static int listMembers(char ***names, size_t *count, const char *parentDir);
+static void freeNames(char **names, size_t count);
+static int copyFile(int outFD, const char *fileName, uint64_t *length, uint32_t *crc);
+static int isMemberName(const char *name);
+static int compareEntry(const void *key, const void *entry);
+
+/* packTree(): packs parent directories in 'prefix' with all sequence
+ * numbers before 'bound'; oldest first, at most PACK_MAX_PARENTS.
+ **************************************************************************/
+
+int packTree(PACK_REPORT *report, const char *prefix, SEQ_NUM bound){
+
+  ASSERTARGS(report && prefix);
+
+  char           **roots = NULL, **parents = NULL;
+  size_t         numRoots = 0, numParents = 0, rootIndex, parentIndex;
+  char           rootDir[PATH_MAX];
+  SEQ_NUM        base;
+  DIR            *dirPtr;
+  struct dirent  *entry;
+  char           **newNames;
+  size_t         size;
+  int            done = 0;
+  int            result = ztSuccess;
+
+  memset(report, 0, sizeof(PACK_REPORT));
+
+  if(bound == SEQ_NONE)
+    return ztSuccess;
+
+  /* root and parent names, sorted **/
+  dirPtr = opendir(prefix);
+  if(!dirPtr){
+    fprintf(stderr, "%s: Error failed opendir() for <%s>: %s\n", progName, prefix, strerror(errno));
+    return ztInaccessibleDir;
+  }
+
+  size = 0;
+  while((entry = readdir(dirPtr))){
+
+    if(triplet(entry->d_name) < 0)
+      continue;
+
+    if(numRoots == size){
+      size = size ? size * 2 : 16;
+      newNames = (char **) realloc(roots, size * sizeof(char *));
+      if(!newNames){
+        result = ztMemoryAllocate;
+        break;
+      }
+      roots = newNames;
+    }
+
+    roots[numRoots++] = STRDUP(entry->d_name);
+  }
+
+  closedir(dirPtr);
+
+  if(result == ztSuccess && numRoots > 1)
+    qsort(roots, numRoots, sizeof(char *), compareStrings);
+
+  for(rootIndex = 0; rootIndex < numRoots && result == ztSuccess && !done; rootIndex++){
+
+    base = (SEQ_NUM) triplet(roots[rootIndex]) * 1000000;
+    if(base >= bound)
+      break;
+
+    if(snprintf(rootDir, sizeof(rootDir), "%s%s%s", prefix, SLASH_ENDING(prefix) ? "" : "/", roots[rootIndex]) >= (int) sizeof(rootDir)){
+      result = ztFnameLong;
+      break;
+    }
+
+    dirPtr = opendir(rootDir);
+    if(!dirPtr)
+      continue;
+
+    numParents = 0;
+    size = 0;
+
+    while((entry = readdir(dirPtr))){
+
+      if(triplet(entry->d_name) < 0)
+        continue;
+
+      if(numParents == size){
+        size = size ? size * 2 : 64;
+        newNames = (char **) realloc(parents, size * sizeof(char *));
+        if(!newNames){
+          result = ztMemoryAllocate;
+          break;
+        }
+        parents = newNames;
+      }
+
+      parents[numParents++] = STRDUP(entry->d_name);
+    }
+
+    closedir(dirPtr);
+
+    if(result == ztSuccess && numParents > 1)
+      qsort(parents, numParents, sizeof(char *), compareStrings);
+
+    for(parentIndex = 0; parentIndex < numParents && result == ztSuccess; parentIndex++){
+
+      base = (SEQ_NUM) triplet(roots[rootIndex]) * 1000000 + (SEQ_NUM) triplet(parents[parentIndex]) * 1000;
+
+      /* hot directory; all after it too **/
+      if(base + 999 >= bound){
+        done = 1;
+        break;
+      }
+
+      if(report->parents == PACK_MAX_PARENTS){
+        report->more = 1;
+        done = 1;
+        break;
+      }
+
+      result = packOneParent(report, rootDir, parents[parentIndex], base);
+    }
+
+    for(parentIndex = 0; parentIndex < numParents; parentIndex++)
+      free(parents[parentIndex]);
+  }
+
+  free(parents);
+  freeNames(roots, numRoots);
+
+  return result;
+
+} /* END packTree() **/
+
+static int packOneParent(PACK_REPORT *report, const char *rootDir, const char *parentEntry, SEQ_NUM base){
+
+  char       parentDir[PATH_MAX], packFile[PATH_MAX];
+  long       files = 0;
+  long long  bytes = 0;
+  int        result;
+
+  if(snprintf(parentDir, sizeof(parentDir), "%s/%s", rootDir, parentEntry) >= (int) sizeof(parentDir) ||
+     snprintf(packFile, sizeof(packFile), "%s/%s%s", rootDir, parentEntry, PACK_EXT) >= (int) sizeof(packFile))
+    return ztFnameLong;
+
+  if(! isPathDirectory(parentDir))
+    return ztSuccess;
+
+  /* crash after rename last time **/
+  if(isFileReadable(packFile) == ztSuccess)
+    return removePacked(parentDir, packFile);
+
+  result = packParent(parentDir, packFile, base, &files, &bytes);
+  if(result != ztSuccess)
+    return result;
+
+  report->parents++;
+  report->files += files;
+  report->bytes += bytes;
+
+  return removePacked(parentDir, packFile);
+
+} /* END packOneParent() **/
+
+/* packParent(): writes members of 'parentDir' to 'packFile'; loose files
+ * are not removed here. Files not named "NNN.ext" and ".part" files are
+ * left out.
+ **************************************************************************/
+
+int packParent(const char *parentDir, const char *packFile, SEQ_NUM base, long *files, long long *bytes){
+
+  ASSERTARGS(parentDir && packFile);
+
+  PACK_TRAILER    trailer;
+  PACK_ENTRY      *entries = NULL;
+  char            **names = NULL;
+  char            partFile[PATH_MAX], fileName[PATH_MAX];
+  struct stat     status;
+  struct timespec times[2];
+  size_t          count = 0, index;
+  int64_t         newest = 0;
+  uint64_t        offset;
+  int             fd;
+  int             result;
+
+  if(snprintf(partFile, sizeof(partFile), "%s.part", packFile) >= (int) sizeof(partFile))
+    return ztFnameLong;
+
+  result = listMembers(&names, &count, parentDir);
+  if(result != ztSuccess)
+    return result;
+
+  entries = (PACK_ENTRY *) calloc(count ? count : 1, sizeof(PACK_ENTRY));
+  if(!entries){
+    freeNames(names, count);
+    return ztMemoryAllocate;
+  }
+
+  errno = 0;
+  fd = open(partFile, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if(fd < 0){
+    fprintf(stderr, "%s: Error failed open() for <%s>: %s\n", progName, partFile, strerror(errno));
+    free(entries);
+    freeNames(names, count);
+    return ztOpenFileError;
+  }
+
+  memset(&trailer, 0, sizeof(PACK_TRAILER));
+  trailer.base = base;
+
+  result = writeAll(fd, PACK_MAGIC, 8);
+  offset = 8;
+
+  for(index = 0; index < count && result == ztSuccess; index++){
+
+    if(snprintf(fileName, sizeof(fileName), "%s/%s", parentDir, names[index]) >= (int) sizeof(fileName)){
+      result = ztFnameLong;
+      break;
+    }
+
+    if(stat(fileName, &status) != 0){
+      result = ztFileNotFound;
+      break;
+    }
+
+    strcpy(entries[index].name, names[index]);
+    entries[index].offset = offset;
+    entries[index].mtime = (int64_t) status.st_mtime;
+
+    result = copyFile(fd, fileName, &entries[index].length, &entries[index].crc);
+
+    offset += entries[index].length;
+
+    if(entries[index].mtime > newest)
+      newest = entries[index].mtime;
+
+    if(strcmp(names[index] + 3, CHANGE_EXT) == 0 || strcmp(names[index] + 3, ZST_EXT) == 0)
+      trailer.changeCount++;
+  }
+
+  if(result == ztSuccess){
+
+    trailer.indexOffset = offset;
+    trailer.count = (uint32_t) count;
+    memcpy(trailer.magic, PACK_MAGIC, 8);
+
+    result = writeAll(fd, entries, count * sizeof(PACK_ENTRY));
+    if(result == ztSuccess)
+      result = writeAll(fd, &trailer, sizeof(PACK_TRAILER));
+  }
+
+  if(result == ztSuccess && fsync(fd) != 0)
+    result = ztWriteError;
+
+  if(result == ztSuccess){
+    times[0].tv_sec = times[1].tv_sec = (time_t) newest;
+    times[0].tv_nsec = times[1].tv_nsec = 0;
+    futimens(fd, times);
+  }
+
+  if(close(fd) != 0 && result == ztSuccess)
+    result = ztWriteError;
+
+  /* pack name and its directory entry are on disk before loose files go **/
+  if(result == ztSuccess)
+    result = commitFile(partFile, packFile);
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed writing pack file: <%s>\n", progName, packFile);
+    removeFile(partFile);
+  }
+  else {
+    if(files)
+      *files = (long) count;
+    if(bytes)
+      *bytes = (long long) offset;
+  }
+
+  free(entries);
+  freeNames(names, count);
+
+  return result;
+
+} /* END packParent() **/
+
+/* removePacked(): removes loose files found in pack with same length, then
+ * parent directory if it is empty.
+ **************************************************************************/
+
+static int removePacked(const char *parentDir, const char *packFile){
+
+  PACK_FILE         *pack;
+  const PACK_ENTRY  *entry;
+  char              **names = NULL;
+  char              fileName[PATH_MAX];
+  struct stat       status;
+  size_t            count = 0, index;
+  int               result;
+
+  pack = packOpen(packFile);
+  if(!pack)
+    return ztMalformedFile;
+
+  result = listMembers(&names, &count, parentDir);
+
+  for(index = 0; index < count && result == ztSuccess; index++){
+
+    entry = packFind(pack, names[index]);
+    if(!entry)
+      continue;
+
+    if(snprintf(fileName, sizeof(fileName), "%s/%s", parentDir, names[index]) >= (int) sizeof(fileName))
+      continue;
+
+    if(stat(fileName, &status) != 0 || (uint64_t) status.st_size != entry->length)
+      continue;
+
+    if(unlink(fileName) != 0)
+      fprintf(stderr, "%s: Error failed unlink() for <%s>: %s\n", progName, fileName, strerror(errno));
+  }
+
+  freeNames(names, count);
+  packClose(&pack);
+
+  /* left over ".part" or foreign files keep directory **/
+  if(rmdir(parentDir) != 0 && errno != ENOTEMPTY && errno != EEXIST)
+    fprintf(stderr, "%s: Error failed rmdir() for <%s>: %s\n", progName, parentDir, strerror(errno));
+
+  return result;
+
+} /* END removePacked() **/
+
+/* packOpen(): reads trailer and index; NULL on error **/
+
+PACK_FILE *packOpen(const char *packFile){
+
+  ASSERTARGS(packFile);
+
+  PACK_FILE    *pack;
+  struct stat  status;
+  char         magic[8];
+  size_t       indexSize;
+
+  pack = (PACK_FILE *) calloc(1, sizeof(PACK_FILE));
+  if(!pack)
+    return NULL;
+
+  pack->fd = open(packFile, O_RDONLY | O_CLOEXEC);
+  if(pack->fd < 0){
+    free(pack);
+    return NULL;
+  }
+
+  if(fstat(pack->fd, &status) != 0 || status.st_size < (off_t) (8 + sizeof(PACK_TRAILER)) ||
+     pread(pack->fd, magic, 8, 0) != 8 || memcmp(magic, PACK_MAGIC, 8) != 0 ||
+     pread(pack->fd, &pack->trailer, sizeof(PACK_TRAILER), status.st_size - (off_t) sizeof(PACK_TRAILER)) != (ssize_t) sizeof(PACK_TRAILER) ||
+     memcmp(pack->trailer.magic, PACK_MAGIC, 8) != 0){
+    fprintf(stderr, "%s: Error not a pack file or truncated: <%s>\n", progName, packFile);
+    packClose(&pack);
+    return NULL;
+  }
+
+  indexSize = (size_t) pack->trailer.count * sizeof(PACK_ENTRY);
+
+  if(pack->trailer.indexOffset + indexSize + sizeof(PACK_TRAILER) != (uint64_t) status.st_size){
+    fprintf(stderr, "%s: Error bad index in pack file: <%s>\n", progName, packFile);
+    packClose(&pack);
+    return NULL;
+  }
+
+  pack->entries = (PACK_ENTRY *) malloc(indexSize ? indexSize : 1);
+  if(!pack->entries ||
+     pread(pack->fd, pack->entries, indexSize, (off_t) pack->trailer.indexOffset) != (ssize_t) indexSize){
+    packClose(&pack);
+    return NULL;
+  }
+
+  return pack;
+
+} /* END packOpen() **/
+
+void packClose(PACK_FILE **pack){
+
+  if(!pack || !*pack)
+    return;
+
+  if((*pack)->fd >= 0)
+    close((*pack)->fd);
+
+  free((*pack)->entries);
+  free(*pack);
+
+  *pack = NULL;
+
+} /* END packClose() **/
+
+/* packFind(): member by name - "456.osc.gz"; NULL if not in pack **/
+
+const PACK_ENTRY *packFind(const PACK_FILE *pack, const char *name){
+
+  ASSERTARGS(pack && name);
+
+  return (const PACK_ENTRY *) bsearch(name, pack->entries, pack->trailer.count, sizeof(PACK_ENTRY), compareEntry);
+
+} /* END packFind() **/
+
+/* packCopy(): writes member to 'outFD' while checking its CRC32; negative
+ * 'outFD' checks only. ztMalformedFile for CRC mismatch - all bytes are
+ * already written then.
+ **************************************************************************/
+
+int packCopy(const PACK_FILE *pack, const PACK_ENTRY *entry, int outFD){
+
+  ASSERTARGS(pack && entry);
+
+  unsigned char  *buffer;
+  uint64_t       done = 0;
+  uint32_t       crc = 0;
+  size_t         chunk;
+  ssize_t        got;
+  int            result = ztSuccess;
+
+  if(entry->offset + entry->length > pack->trailer.indexOffset)
+    return ztMalformedFile;
+
+  buffer = (unsigned char *) malloc(PACK_BUFFER);
+  if(!buffer)
+    return ztMemoryAllocate;
+
+  while(done < entry->length && result == ztSuccess){
+
+    chunk = (entry->length - done < PACK_BUFFER) ? (size_t) (entry->length - done) : PACK_BUFFER;
+
+    got = pread(pack->fd, buffer, chunk, (off_t) (entry->offset + done));
+    if(got <= 0){
+      result = ztFileError;
+      break;
+    }
+
+    crc = crc32Update(crc, buffer, (size_t) got);
+
+    if(outFD >= 0)
+      result = writeAll(outFD, buffer, (size_t) got);
+
+    done += (uint64_t) got;
+  }
+
+  free(buffer);
+
+  if(result == ztSuccess && crc != entry->crc)
+    result = ztMalformedFile;
+
+  return result;
+
+} /* END packCopy() **/
+
+int packCheck(const PACK_FILE *pack, const PACK_ENTRY *entry){
+
+  return packCopy(pack, entry, -1);
+
+} /* END packCheck() **/
+
+/* packFileName(): {prefix}/NNN/NNN.pack for parent of 'seq' **/
+
+int packFileName(char *buffer, size_t size, const char *prefix, SEQ_NUM seq){
+
+  ASSERTARGS(buffer && prefix);
+
+  char  rootEntry[8], parentEntry[8];
+
+  sequence2Entries(rootEntry, parentEntry, NULL, seq);
+
+  if(snprintf(buffer, size, "%s%s%.3s/%.3s%s", prefix, SLASH_ENDING(prefix) ? "" : "/",
+              rootEntry, parentEntry, PACK_EXT) >= (int) size)
+    return ztFnameLong;
+
+  return ztSuccess;
+
+} /* END packFileName() **/
+
+/* extractMember(): copies file for 'seq' with extension 'ext' to 'outFD';
+ * loose file first then pack. ztFileNotFound when in neither.
+ **************************************************************************/
+
+int extractMember(const char *prefix, SEQ_NUM seq, const char *ext, int outFD){
+
+  ASSERTARGS(prefix && ext);
+
+  PACK_FILE         *pack;
+  const PACK_ENTRY  *entry;
+  char              seqPath[SEQ_PATH_SIZE];
+  char              fileName[PATH_MAX], member[PACK_NAME_SIZE];
+  uint64_t          length;
+  uint32_t          crc;
+  int               result;
+
+  sequence2Path(seqPath, seq);
+
+  if(snprintf(fileName, sizeof(fileName), "%s%s%s", prefix, seqPath + (SLASH_ENDING(prefix) ? 1 : 0), ext) >= (int) sizeof(fileName))
+    return ztFnameLong;
+
+  if(isFileReadable(fileName) == ztSuccess)
+    return copyFile(outFD, fileName, &length, &crc);
+
+  result = packFileName(fileName, sizeof(fileName), prefix, seq);
+  if(result != ztSuccess)
+    return result;
+
+  if(snprintf(member, sizeof(member), "%03u%s", SEQ_FILE(seq), ext) >= (int) sizeof(member))
+    return ztFileNotFound;
+
+  pack = packOpen(fileName);
+  if(!pack)
+    return ztFileNotFound;
+
+  entry = packFind(pack, member);
+
+  result = entry ? packCopy(pack, entry, outFD) : ztFileNotFound;
+
+  if(result == ztMalformedFile)
+    fprintf(stderr, "%s: Error CRC32 mismatch for <%s> in pack: <%s>\n", progName, member, fileName);
+
+  packClose(&pack);
+
+  return result;
+
+} /* END extractMember() **/
+
+/* listMembers(): sorted "NNN.ext" names in 'parentDir' without ".part" **/
+
+static int listMembers(char ***names, size_t *count, const char *parentDir){
+
+  DIR            *dirPtr;
+  struct dirent  *entry;
+  char           **list = NULL, **newList;
+  size_t         num = 0, size = 0;
+
+  *names = NULL;
+  *count = 0;
+
+  dirPtr = opendir(parentDir);
+  if(!dirPtr){
+    fprintf(stderr, "%s: Error failed opendir() for <%s>: %s\n", progName, parentDir, strerror(errno));
+    return ztInaccessibleDir;
+  }
+
+  while((entry = readdir(dirPtr))){
+
+    if(! isMemberName(entry->d_name))
+      continue;
+
+    if(num == size){
+
+      size = size ? size * 2 : 2048;
+
+      newList = (char **) realloc(list, size * sizeof(char *));
+      if(!newList){
+        closedir(dirPtr);
+        freeNames(list, num);
+        return ztMemoryAllocate;
+      }
+
+      list = newList;
+    }
+
+    list[num++] = STRDUP(entry->d_name);
+  }
+
+  closedir(dirPtr);
+
+  if(num > 1)
+    qsort(list, num, sizeof(char *), compareStrings);
+
+  *names = list;
+  *count = num;
+
+  return ztSuccess;
+
+} /* END listMembers() **/
+
+static void freeNames(char **names, size_t count){
+
+  size_t  index;
+
+  for(index = 0; index < count; index++)
+    free(names[index]);
+
+  free(names);
+
+} /* END freeNames() **/
+
+/* copyFile(): appends 'fileName' to 'outFD' - negative skips writing **/
+
+static int copyFile(int outFD, const char *fileName, uint64_t *length, uint32_t *crc){
+
+  unsigned char  *buffer;
+  ssize_t        got;
+  int            fd;
+  int            result = ztSuccess;
+
+  *length = 0;
+  *crc = 0;
+
+  fd = open(fileName, O_RDONLY | O_CLOEXEC);
+  if(fd < 0){
+    fprintf(stderr, "%s: Error failed open() for <%s>: %s\n", progName, fileName, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  buffer = (unsigned char *) malloc(PACK_BUFFER);
+  if(!buffer){
+    close(fd);
+    return ztMemoryAllocate;
+  }
+
+  while((got = read(fd, buffer, PACK_BUFFER)) > 0 && result == ztSuccess){
+
+    *crc = crc32Update(*crc, buffer, (size_t) got);
+    *length += (uint64_t) got;
+
+    if(outFD >= 0)
+      result = writeAll(outFD, buffer, (size_t) got);
+  }
+
+  if(got < 0)
+    result = ztFileError;
+
+  free(buffer);
+  close(fd);
+
+  return result;
+
+} /* END copyFile() **/
+
+/* isMemberName(): "NNN." then a short extension, not ".part" **/
+
+static int isMemberName(const char *name){
+
+  size_t  length = strlen(name);
+  int     i;
+
+  if(length < 5 || length >= PACK_NAME_SIZE)
+    return FALSE;
+
+  for(i = 0; i < 3; i++)
+    if(name[i] < '0' || name[i] > '9')
+      return FALSE;
+
+  if(name[3] != '.')
+    return FALSE;
+
+  return ! (length > 5 && strcmp(name + length - 5, ".part") == 0);
+
+} /* END isMemberName() **/
+
+static int compareEntry(const void *key, const void *entry){
+
+  return strncmp((const char *) key, ((const PACK_ENTRY *) entry)->name, PACK_NAME_SIZE);
+
+} /* END compareEntry() **/
@@ -9,10 +9,21 @@
 #include <stdlib.h>
 #include <string.h>
 #include <getopt.h>
+#include <errno.h>
+#include <limits.h>
+#include <arpa/inet.h>
 #include "ztError.h"
 #include "getdiff.h"
 #include "usage.h"
 #include "util.h"
+#include "transcode.h"
+#include "region.h"
+#include "expire.h"
+#include "idindex.h"
+#include "retain.h"
+#include "serve.h"
+#include "localsrc.h"
+#include "logger.h"
 
 
 /* parseCmdLine(): parses command line option using getopt_long().
@@ -25,6 +36,36 @@
  * use getcwd() library function.
  ***********************************************************************/
 
+/* long only options; values out of character range **/
+enum LONG_ONLY_OPT_ {
+
+  OPT_PENDING = 256,
+  OPT_ACK,
+  OPT_EVENTS,
+  OPT_STREAM,
+  OPT_TEE,
+  OPT_MERGE,
+  OPT_ZSTD,
+  OPT_VERIFY,
+  OPT_SUMMARY,
+  OPT_REGION,
+  OPT_EXPIRE,
+  OPT_INDEX,
+  OPT_LOOKUP,
+  OPT_RETAIN_DAYS,
+  OPT_RETAIN_COUNT,
+  OPT_RETAIN_SIZE,
+  OPT_PACK,
+  OPT_EXTRACT,
+  OPT_STORE,
+  OPT_SERVE,
+  OPT_COOKIE_CACHE,
+  OPT_PUBLIC_META,
+  OPT_LOG_LEVEL,
+  OPT_METRICS
+
+};
+
 int parseCmdLine(MY_SETTING *arguments, int argc, char* const argv[]){
 
   int    result;
@@ -44,6 +85,30 @@ int parseCmdLine(MY_SETTING *arguments, int argc, char* const argv[]){
     {"new", 0, NULL, 'n'},    /* do not require argument **/
     {"text", 0, NULL, 't'},
     {"help", 0, NULL, 'h'},
+    {"pending", 0, NULL, OPT_PENDING},
+    {"ack", 1, NULL, OPT_ACK},
+    {"events", 1, NULL, OPT_EVENTS},
+    {"stream", 1, NULL, OPT_STREAM},
+    {"tee", 0, NULL, OPT_TEE},
+    {"merge", 0, NULL, OPT_MERGE},
+    {"zstd", 1, NULL, OPT_ZSTD},
+    {"verify", 0, NULL, OPT_VERIFY},
+    {"summary", 0, NULL, OPT_SUMMARY},
+    {"region", 1, NULL, OPT_REGION},
+    {"expire", 1, NULL, OPT_EXPIRE},
+    {"index", 0, NULL, OPT_INDEX},
+    {"lookup", 1, NULL, OPT_LOOKUP},
+    {"retain-days", 1, NULL, OPT_RETAIN_DAYS},
+    {"retain-count", 1, NULL, OPT_RETAIN_COUNT},
+    {"retain-size", 1, NULL, OPT_RETAIN_SIZE},
+    {"pack", 0, NULL, OPT_PACK},
+    {"extract", 1, NULL, OPT_EXTRACT},
+    {"store", 1, NULL, OPT_STORE},
+    {"serve", 1, NULL, OPT_SERVE},
+    {"cookie-cache", 1, NULL, OPT_COOKIE_CACHE},
+    {"public-meta", 0, NULL, OPT_PUBLIC_META},
+    {"log-level", 1, NULL, OPT_LOG_LEVEL},
+    {"metrics", 1, NULL, OPT_METRICS},
     {NULL, 0, NULL, 0}
   };
 
@@ -209,7 +274,7 @@ int parseCmdLine(MY_SETTING *arguments, int argc, char* const argv[]){
 	return ztInvalidArg;
       }
 
-      if (isOkayFormat4URL(optarg) == FALSE) {
+      if (isOkayFormat4URL(optarg) == FALSE && isGoodLocalSource(optarg) == FALSE) {
 	fprintf(stderr, "%s: Error invalid source URL string for source option.\n"
 		" Argument: [%s].\n", progName, optarg);
 	return ztInvalidArg;
@@ -302,6 +367,356 @@ int parseCmdLine(MY_SETTING *arguments, int argc, char* const argv[]){
       newFlag = 1;
       break;
 
+    case OPT_EVENTS:
+
+      if (arguments->eventsPath){
+	fprintf(stderr, "%s: Error; duplicate \"events\" option!\n", progName);
+	return ztInvalidArg;
+      }
+
+      withPath = arg2FullPath(optarg);
+      if(!withPath){
+        fprintf(stderr, "%s: Error failed arg2FullPath() function in parseCmdLine().\n", progName);
+        return ztUnknownError;
+      }
+
+      result = isGoodFilename(withPath);
+      if (result != ztSuccess){
+        fprintf(stderr, "%s: Error events path <%s> is NOT good filename.\n"
+		" Filename is not good for: <%s> \n", progName, withPath, ztCode2Msg(result));
+        return result;
+      }
+
+      arguments->eventsPath = STRDUP(withPath);
+      break;
+
+    case OPT_STREAM:
+
+      if (arguments->streamTarget){
+	fprintf(stderr, "%s: Error; duplicate \"stream\" option!\n", progName);
+	return ztInvalidArg;
+      }
+
+      /* "-" is standard output, else an open file descriptor number **/
+      if (strcmp(optarg, "-") != 0){
+
+        char  *endPtr;
+        long  fd;
+
+        errno = 0;
+        fd = strtol(optarg, &endPtr, 10);
+        if (errno || *endPtr != '\0' || fd < 0 || fd > INT_MAX){
+          fprintf(stderr, "%s: Error invalid argument for \"stream\" option; must be \"-\" or file descriptor.\n"
+                  "Invalid argument : [%s].\n", progName, optarg);
+          return ztInvalidArg;
+        }
+      }
+
+      arguments->streamTarget = STRDUP(optarg);
+      break;
+
+    case OPT_TEE:
+
+      arguments->streamTee = 1;
+      break;
+
+    case OPT_MERGE:
+
+      arguments->merge = 1;
+      break;
+
+    case OPT_SUMMARY:
+
+      arguments->summary = 1;
+      break;
+
+    case OPT_EXPIRE:
+
+      if (arguments->expire){
+	fprintf(stderr, "%s: Error; duplicate \"expire\" option!\n", progName);
+	return ztInvalidArg;
+      }
+
+      if (string2ZoomRange(&arguments->expireMinZoom, &arguments->expireMaxZoom, optarg) != ztSuccess){
+	fprintf(stderr, "%s: Error invalid argument for \"expire\" option; must be ZOOM or MIN-MAX from 0 to %d.\n"
+		"Invalid argument : [%s].\n", progName, EXPIRE_MAX_ZOOM, optarg);
+	return ztInvalidArg;
+      }
+
+      arguments->expire = 1;
+      break;
+
+    case OPT_REGION:
+
+      /* NAME=FILE; FILE is Osmosis polygon (.poly) file **/
+      if (arguments->numRegions == MAX_REGIONS){
+	fprintf(stderr, "%s: Error too many \"region\" options; maximum is <%d>.\n", progName, MAX_REGIONS);
+	return ztInvalidArg;
+      }
+
+      {
+        char  *equal = strchr(optarg, '=');
+        char  name[REGION_NAME_MAX + 1];
+        char  buffer[PATH_MAX];
+        int   index;
+
+        if (!equal || equal == optarg || equal - optarg > REGION_NAME_MAX || ! equal[1]){
+          fprintf(stderr, "%s: Error invalid argument for \"region\" option; must be NAME=FILE.\n"
+                  "Invalid argument : [%s].\n", progName, optarg);
+          return ztInvalidArg;
+        }
+
+        memcpy(name, optarg, (size_t) (equal - optarg));
+        name[equal - optarg] = '\0';
+
+        if (! isGoodRegionName(name)){
+          fprintf(stderr, "%s: Error region name may have letters, digits, '-' and '_' only: [%s].\n", progName, name);
+          return ztInvalidArg;
+        }
+
+        for (index = 0; index < arguments->numRegions; index++)
+          if (strncmp(arguments->regionArgs[index], optarg, (size_t) (equal - optarg + 1)) == 0){
+            fprintf(stderr, "%s: Error; duplicate region name: [%s].\n", progName, name);
+            return ztInvalidArg;
+          }
+
+        withPath = arg2FullPath(equal + 1);
+        if (!withPath){
+          fprintf(stderr, "%s: Error failed arg2FullPath() function in parseCmdLine().\n", progName);
+          return ztUnknownError;
+        }
+
+        result = isFileReadable(withPath);
+        if (result != ztSuccess){
+          fprintf(stderr, "%s: Error polygon file <%s> for region is not readable: <%s>\n", progName, withPath, ztCode2Msg(result));
+          return result;
+        }
+
+        snprintf(buffer, sizeof(buffer), "%s=%s", name, withPath);
+        free(withPath);
+
+        arguments->regionArgs[arguments->numRegions++] = STRDUP(buffer);
+      }
+      break;
+
+    case OPT_ZSTD:
+
+      if (arguments->zstdMode != ZST_OFF){
+	fprintf(stderr, "%s: Error; duplicate \"zstd\" option!\n", progName);
+	return ztInvalidArg;
+      }
+
+      ZST_MODE  mode;
+
+      if (string2ZstdMode(&mode, optarg) != ztSuccess){
+	fprintf(stderr, "%s: Error invalid argument for \"zstd\" option; must be \"replace\" or \"copy\".\n"
+		"Invalid argument : [%s].\n", progName, optarg);
+	return ztInvalidArg;
+      }
+
+      if (! isZstdSupported()){
+	fprintf(stderr, "%s: Error \"zstd\" option; program was built without zstd support.\n", progName);
+	return ztInvalidArg;
+      }
+
+      arguments->zstdMode = (int) mode;
+      break;
+
+    case OPT_RETAIN_DAYS:
+    case OPT_RETAIN_COUNT:
+
+      {
+        char  *endPtr;
+        long  value;
+
+        errno = 0;
+        value = strtol(optarg, &endPtr, 10);
+        if (errno || *endPtr != '\0' || value < 1){
+          fprintf(stderr, "%s: Error invalid argument for \"%s\" option; must be positive integer.\n"
+                  "Invalid argument : [%s].\n", progName, (opt == OPT_RETAIN_DAYS) ? "retain-days" : "retain-count", optarg);
+          return ztInvalidArg;
+        }
+
+        if (opt == OPT_RETAIN_DAYS)
+          arguments->retainDays = value;
+        else
+          arguments->retainCount = value;
+      }
+      break;
+
+    case OPT_RETAIN_SIZE:
+
+      if (string2Bytes(&arguments->retainBytes, optarg) != ztSuccess){
+	fprintf(stderr, "%s: Error invalid argument for \"retain-size\" option; must be bytes with optional K, M, G or T suffix.\n"
+		"Invalid argument : [%s].\n", progName, optarg);
+	return ztInvalidArg;
+      }
+      break;
+
+    case OPT_INDEX:
+
+      arguments->index = 1;
+      break;
+
+    case OPT_PACK:
+
+      arguments->pack = 1;
+      break;
+
+    case OPT_STORE:
+
+      if (arguments->storeDir){
+	fprintf(stderr, "%s: Error; duplicate store directory option!\n", progName);
+	return ztInvalidArg;
+      }
+
+      if (isGoodDirName(optarg) != ztSuccess){
+	fprintf(stderr, "%s: Error invalid argument for \"store\" option; must be directory name.\n"
+		"Invalid argument : [%s].\n", progName, optarg);
+	return ztInvalidArg;
+      }
+
+      arguments->storeDir = STRDUP(optarg);
+      break;
+
+    case OPT_COOKIE_CACHE:
+
+      if (arguments->cookieCache){
+	fprintf(stderr, "%s: Error; duplicate cookie cache directory option!\n", progName);
+	return ztInvalidArg;
+      }
+
+      if (isGoodDirName(optarg) != ztSuccess){
+	fprintf(stderr, "%s: Error invalid argument for \"cookie-cache\" option; must be directory name.\n"
+		"Invalid argument : [%s].\n", progName, optarg);
+	return ztInvalidArg;
+      }
+
+      arguments->cookieCache = STRDUP(optarg);
+      break;
+
+    case OPT_PUBLIC_META:
+
+      arguments->publicMeta = 1;
+      break;
+
+    case OPT_LOG_LEVEL:
+
+      if (arguments->logLevel){
+	fprintf(stderr, "%s: Error; duplicate log level option!\n", progName);
+	return ztInvalidArg;
+      }
+
+      {
+	LOG_LEVEL  level;
+
+	if (string2LogLevel(&level, optarg) != ztSuccess){
+	  fprintf(stderr, "%s: Error invalid argument for \"log-level\" option; must be one of \"error\", \"warning\", \"info\" or \"debug\".\n"
+		  "Invalid argument : [%s].\n", progName, optarg);
+	  return ztInvalidArg;
+	}
+      }
+
+      arguments->logLevel = STRDUP(optarg);
+      break;
+
+    case OPT_METRICS:
+
+      if (arguments->metricsDir){
+	fprintf(stderr, "%s: Error; duplicate metrics directory option!\n", progName);
+	return ztInvalidArg;
+      }
+
+      if (isGoodDirName(optarg) != ztSuccess){
+	fprintf(stderr, "%s: Error invalid argument for \"metrics\" option; must be directory name.\n"
+		"Invalid argument : [%s].\n", progName, optarg);
+	return ztInvalidArg;
+      }
+
+      arguments->metricsDir = STRDUP(optarg);
+      break;
+
+    case OPT_PENDING:
+    case OPT_ACK:
+    case OPT_VERIFY:
+    case OPT_LOOKUP:
+    case OPT_EXTRACT:
+    case OPT_SERVE:
+
+      if (arguments->command != CMD_DOWNLOAD){
+	fprintf(stderr, "%s: Error; only one of \"pending\", \"ack\", \"verify\", \"lookup\", \"extract\" or \"serve\" options is allowed!\n", progName);
+	return ztInvalidArg;
+      }
+
+      if (opt == OPT_SERVE){
+
+	char  address[INET_ADDRSTRLEN];
+	int   port;
+
+	if (parseServeAddress(address, sizeof(address), &port, optarg) != ztSuccess){
+	  fprintf(stderr, "%s: Error invalid argument for \"serve\" option; must be PORT or ADDRESS:PORT as in \"8080\" or \"127.0.0.1:8080\".\n"
+		  "Invalid argument : [%s].\n", progName, optarg);
+	  return ztInvalidArg;
+	}
+
+	arguments->serveArg = STRDUP(optarg);
+	arguments->command = CMD_SERVE;
+	break;
+      }
+
+      if (opt == OPT_EXTRACT){
+
+	size_t  digits = strspn(optarg, "0123456789");
+
+	if (digits == 0 || digits > 9 || (optarg[digits] != '\0' && optarg[digits] != '.')){
+	  fprintf(stderr, "%s: Error invalid argument for \"extract\" option; must be SEQUENCE with optional extension as in \"4428\" or \"4428.state.txt\".\n"
+		  "Invalid argument : [%s].\n", progName, optarg);
+	  return ztInvalidArg;
+	}
+
+	arguments->extractArg = STRDUP(optarg);
+	arguments->command = CMD_EXTRACT;
+	break;
+      }
+
+      if (opt == OPT_LOOKUP){
+
+	uint64_t  key;
+
+	if (string2IndexKey(&key, optarg) != ztSuccess){
+	  fprintf(stderr, "%s: Error invalid argument for \"lookup\" option; must be TYPE/ID as in \"way/123\" or \"w123\".\n"
+		  "Invalid argument : [%s].\n", progName, optarg);
+	  return ztInvalidArg;
+	}
+
+	arguments->lookupObject = STRDUP(optarg);
+	arguments->command = CMD_LOOKUP;
+	break;
+      }
+
+      if (opt == OPT_PENDING){
+	arguments->command = CMD_PENDING;
+	break;
+      }
+
+      if (opt == OPT_VERIFY){
+	arguments->command = CMD_VERIFY;
+	break;
+      }
+
+      char  *endPtr;
+
+      errno = 0;
+      arguments->ackCount = strtol(optarg, &endPtr, 10);
+      if (errno || *endPtr != '\0' || arguments->ackCount < 1){
+	fprintf(stderr, "%s: Error invalid count for \"ack\" option; must be positive integer.\n"
+		"Invalid argument : [%s].\n", progName, optarg);
+	return ztInvalidArg;
+      }
+
+      arguments->command = CMD_ACK;
+      break;
+
     case 't':
     	/* this is for debugging, might be removed.
     	 * No list file is written when specified **/
@@ -338,6 +753,60 @@ int parseCmdLine(MY_SETTING *arguments, int argc, char* const argv[]){
     return ztMalformedCML;
   }
 
+  if (arguments->streamTee && ! arguments->streamTarget){
+    fprintf(stderr, "%s: Error \"tee\" option is only used with \"stream\" option.\n", progName);
+    return ztInvalidArg;
+  }
+
+  if (arguments->zstdMode != ZST_OFF && (arguments->streamTarget || arguments->textOnly || arguments->merge)){
+    fprintf(stderr, "%s: Error \"zstd\" option can not be used with \"stream\", \"text\" or \"merge\" options.\n", progName);
+    return ztInvalidArg;
+  }
+
+  /* summary job reads change file after download; it must stay on disk **/
+  if (arguments->summary && ((arguments->streamTarget && ! arguments->streamTee) ||
+                             arguments->textOnly || arguments->zstdMode == ZST_REPLACE)){
+    fprintf(stderr, "%s: Error \"summary\" option can not be used with \"text\", \"zstd replace\" or \"stream\" without \"tee\".\n", progName);
+    return ztInvalidArg;
+  }
+
+  /* regions are filtered from change files on disk after download **/
+  if (arguments->numRegions && ((arguments->streamTarget && ! arguments->streamTee) ||
+                                arguments->textOnly || arguments->zstdMode == ZST_REPLACE)){
+    fprintf(stderr, "%s: Error \"region\" option can not be used with \"text\", \"zstd replace\" or \"stream\" without \"tee\".\n", progName);
+    return ztInvalidArg;
+  }
+
+  /* tiles are read from change files on disk after download **/
+  if (arguments->expire && ((arguments->streamTarget && ! arguments->streamTee) ||
+                            arguments->textOnly || arguments->zstdMode == ZST_REPLACE)){
+    fprintf(stderr, "%s: Error \"expire\" option can not be used with \"text\", \"zstd replace\" or \"stream\" without \"tee\".\n", progName);
+    return ztInvalidArg;
+  }
+
+  /* index job reads change file after download **/
+  if (arguments->index && ((arguments->streamTarget && ! arguments->streamTee) ||
+                           arguments->textOnly || arguments->zstdMode == ZST_REPLACE)){
+    fprintf(stderr, "%s: Error \"index\" option can not be used with \"text\", \"zstd replace\" or \"stream\" without \"tee\".\n", progName);
+    return ztInvalidArg;
+  }
+
+  /* pack files are made from change files tree on disk **/
+  if (arguments->pack && ((arguments->streamTarget && ! arguments->streamTee) || arguments->textOnly)){
+    fprintf(stderr, "%s: Error \"pack\" option can not be used with \"text\" or \"stream\" without \"tee\".\n", progName);
+    return ztInvalidArg;
+  }
+
+  if (arguments->merge && (arguments->streamTarget || arguments->textOnly)){
+    fprintf(stderr, "%s: Error \"merge\" option can not be used with \"stream\" or \"text\" options.\n", progName);
+    return ztInvalidArg;
+  }
+
+  if (arguments->streamTarget && (arguments->textOnly || arguments->command != CMD_DOWNLOAD)){
+    fprintf(stderr, "%s: Error \"stream\" option can not be used with \"text\", \"pending\", \"ack\", \"verify\", \"lookup\", \"extract\" or \"serve\" options.\n", progName);
+    return ztInvalidArg;
+  }
+
   return ztSuccess;
 
 } /* END parseCmdLine() **/
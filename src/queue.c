@@ -0,0 +1,649 @@
+/*
+ * queue.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * append only queue file with separate consumer cursor file.
+ *
+ * getdiff (producer) appends new entries with one write() call then fsync();
+ * a record is complete only with its ending linefeed. A partial line left
+ * by a crash is cut off by the next append. Consumers read entries past
+ * their cursor and then advance the cursor; cursor file is replaced with
+ * rename() so it is always whole.
+ *
+ * Producer compacts the queue once consumed part is QUEUE_COMPACT_SIZE or
+ * more: unconsumed tail goes to a new file renamed over the queue, then the
+ * cursor is set to its start. Consumers hold the tree lock shared while they
+ * read and move the cursor, so neither runs during compaction.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+#include "queue.h"
+#include "fileio.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+
+#define QUEUE_FILE_MODE  (S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)
+#define QUEUE_HEAD       512  /* first line is looked for in this many bytes **/
+
+static int fsyncParentDir(const char *filename);
+static int cutPartialLine(int fd, off_t size);
+static char *readQueueTail(const char *queueFile, QUEUE_CURSOR *cursor, size_t *length);
+static unsigned int firstLineCRC(int fd, off_t size);
+
+/* queueAppend(): appends 'list' strings to 'queueFile', one per line.
+ *
+ * all entries go in a single write() followed by fsync(); file is created
+ * if not found. Caller must hold the source lock - single producer.
+ *
+ ***************************************************************************/
+
+int queueAppend(const char *queueFile, STRING_LIST *list){
+
+  ASSERTARGS(queueFile && list);
+
+  int          fd;
+  int          result;
+  int          created;
+  struct stat  status;
+  ELEM         *elem;
+  char         *buffer, *ptr;
+  size_t       size = 0;
+
+  if(DL_SIZE(list) == 0)
+
+    return ztSuccess;
+
+  elem = DL_HEAD(list);
+  while(elem){
+    size += strlen((char *) DL_DATA(elem)) + 1;
+    elem = DL_NEXT(elem);
+  }
+
+  buffer = (char *) malloc(size);
+  if(!buffer){
+    fprintf(stderr, "%s: Error allocating memory in queueAppend().\n", progName);
+    return ztMemoryAllocate;
+  }
+
+  ptr = buffer;
+  elem = DL_HEAD(list);
+  while(elem){
+    size_t len = strlen((char *) DL_DATA(elem));
+
+    memcpy(ptr, DL_DATA(elem), len);
+    ptr += len;
+    *ptr++ = '\n';
+
+    elem = DL_NEXT(elem);
+  }
+
+  created = (stat(queueFile, &status) != 0);
+
+  errno = 0;
+  fd = open(queueFile, O_RDWR | O_CREAT | O_APPEND, QUEUE_FILE_MODE); /* read for partial line check **/
+  if(fd < 0){
+    fprintf(stderr, "%s: Error failed open() in queueAppend() for <%s>.\n"
+            " System error message: %s\n", progName, queueFile, strerror(errno));
+    free(buffer);
+    return ztOpenFileError;
+  }
+
+  if(fstat(fd, &status) != 0){
+    fprintf(stderr, "%s: Error failed fstat() in queueAppend().\n", progName);
+    close(fd);
+    free(buffer);
+    return ztFailedSysCall;
+  }
+
+  result = cutPartialLine(fd, status.st_size);
+  if(result == ztSuccess)
+
+    result = writeAll(fd, buffer, size);
+
+  if(result == ztSuccess && fsync(fd) != 0){
+    fprintf(stderr, "%s: Error failed fsync() in queueAppend(): %s\n", progName, strerror(errno));
+    result = ztWriteError;
+  }
+
+  close(fd);
+  free(buffer);
+
+  if(result == ztSuccess && created)
+
+    result = fsyncParentDir(queueFile);
+
+  return result;
+
+} /* END queueAppend() **/
+
+/* queueReadCursor(): missing cursor file is not an error; cursor starts at
+ * zero. Returns ztMalformedFile if file is there but can not be parsed.
+ *
+ ***************************************************************************/
+
+int queueReadCursor(QUEUE_CURSOR *cursor, const char *cursorFile){
+
+  ASSERTARGS(cursor && cursorFile);
+
+  FILE                *fPtr;
+  long long           offset;
+  unsigned long long  inode;
+  unsigned int        first;
+
+  memset(cursor, 0, sizeof(QUEUE_CURSOR));
+
+  errno = 0;
+  fPtr = fopen(cursorFile, "r");
+  if(!fPtr){
+    if(errno == ENOENT)
+      return ztSuccess;
+
+    fprintf(stderr, "%s: Error failed fopen() for cursor file <%s>: %s\n",
+            progName, cursorFile, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  if(fscanf(fPtr, "%lld %llu", &offset, &inode) != 2 || offset < 0){
+    fprintf(stderr, "%s: Error malformed cursor file <%s>.\n", progName, cursorFile);
+    fclose(fPtr);
+    return ztMalformedFile;
+  }
+
+  /* cursor from older version has no first line CRC **/
+  if(fscanf(fPtr, "%x", &first) != 1)
+    first = 0;
+
+  fclose(fPtr);
+
+  cursor->offset = (off_t) offset;
+  cursor->inode = (ino_t) inode;
+  cursor->first = first;
+
+  return ztSuccess;
+
+} /* END queueReadCursor() **/
+
+/* queueWriteCursor(): writes temporary file, fsync() then rename() over
+ * 'cursorFile'; readers see old or new cursor, never a partial one.
+ *
+ ***************************************************************************/
+
+int queueWriteCursor(const char *cursorFile, const QUEUE_CURSOR *cursor){
+
+  ASSERTARGS(cursorFile && cursor);
+
+  char  tmpName[PATH_MAX] = {0};
+  char  line[64] = {0};
+  int   fd;
+  int   result;
+
+  if(strlen(cursorFile) + 5 >= PATH_MAX){
+    fprintf(stderr, "%s: Error cursor filename is too long.\n", progName);
+    return ztFnameLong;
+  }
+
+  sprintf(tmpName, "%s.tmp", cursorFile);
+  sprintf(line, "%lld %llu %08x\n", (long long) cursor->offset,
+          (unsigned long long) cursor->inode, cursor->first);
+
+  errno = 0;
+  fd = open(tmpName, O_WRONLY | O_CREAT | O_TRUNC, QUEUE_FILE_MODE);
+  if(fd < 0){
+    fprintf(stderr, "%s: Error failed open() for <%s>: %s\n", progName, tmpName, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  result = writeAll(fd, line, strlen(line));
+
+  if(result == ztSuccess && fsync(fd) != 0){
+    fprintf(stderr, "%s: Error failed fsync() for <%s>: %s\n", progName, tmpName, strerror(errno));
+    result = ztWriteError;
+  }
+
+  close(fd);
+
+  if(result != ztSuccess){
+    unlink(tmpName);
+    return result;
+  }
+
+  if(rename(tmpName, cursorFile) != 0){
+    fprintf(stderr, "%s: Error failed rename() for cursor file <%s>: %s\n",
+            progName, cursorFile, strerror(errno));
+    unlink(tmpName);
+    return ztFailedSysCall;
+  }
+
+  return fsyncParentDir(cursorFile);
+
+} /* END queueWriteCursor() **/
+
+/* queuePending(): fills 'pending' with complete entries past consumer cursor.
+ *
+ * 'next' - when not NULL - is set to cursor past the last returned entry;
+ * pass it to queueWriteCursor() after entries are consumed. Caller initials
+ * 'pending' list. Queue file not found is an empty queue.
+ *
+ ***************************************************************************/
+
+int queuePending(STRING_LIST *pending, QUEUE_CURSOR *next,
+                 const char *queueFile, const char *cursorFile){
+
+  ASSERTARGS(pending && queueFile && cursorFile);
+
+  QUEUE_CURSOR  cursor;
+  char          *buffer;
+  char          *line, *end;
+  size_t        length;
+  int           result;
+
+  result = queueReadCursor(&cursor, cursorFile);
+  if(result != ztSuccess)
+
+    return result;
+
+  buffer = readQueueTail(queueFile, &cursor, &length);
+  if(!buffer && length)
+
+    return ztFileError;
+
+  line = buffer;
+  while(line && (line < buffer + length)){
+
+    end = memchr(line, '\n', (size_t) (buffer + length - line));
+    if(!end) /* partial last line; producer not done or crashed **/
+      break;
+
+    *end = '\0';
+
+    if(*line){
+      result = insertNextDL(pending, DL_TAIL(pending), STRDUP(line));
+      if(result != ztSuccess){
+        free(buffer);
+        return result;
+      }
+    }
+
+    cursor.offset += (off_t) (end - line + 1);
+    line = end + 1;
+  }
+
+  if(buffer)
+    free(buffer);
+
+  if(next)
+    *next = cursor;
+
+  return ztSuccess;
+
+} /* END queuePending() **/
+
+/* queueAck(): advances consumer cursor over 'count' entries. **/
+
+int queueAck(const char *queueFile, const char *cursorFile, long count){
+
+  ASSERTARGS(queueFile && cursorFile);
+
+  QUEUE_CURSOR  cursor;
+  char          *buffer;
+  char          *end;
+  size_t        length, used = 0;
+  long          done = 0;
+  int           result;
+
+  if(count < 1){
+    fprintf(stderr, "%s: Error queueAck() 'count' must be positive.\n", progName);
+    return ztInvalidArg;
+  }
+
+  result = queueReadCursor(&cursor, cursorFile);
+  if(result != ztSuccess)
+
+    return result;
+
+  buffer = readQueueTail(queueFile, &cursor, &length);
+  if(!buffer && length)
+
+    return ztFileError;
+
+  while(done < count && used < length){
+
+    end = memchr(buffer + used, '\n', length - used);
+    if(!end)
+      break;
+
+    if(end != buffer + used) /* empty lines are not entries **/
+      done++;
+
+    used = (size_t) (end - buffer) + 1;
+  }
+
+  if(buffer)
+    free(buffer);
+
+  if(done < count){
+    fprintf(stderr, "%s: Error can not acknowledge %ld entries; only %ld pending.\n",
+            progName, count, done);
+    return ztInvalidArg;
+  }
+
+  cursor.offset += (off_t) used;
+
+  return queueWriteCursor(cursorFile, &cursor);
+
+} /* END queueAck() **/
+
+/* queueCompact(): drops consumed entries from 'queueFile' once cursor is
+ * QUEUE_COMPACT_SIZE bytes or more into it. Tail past cursor is written to
+ * a temporary file, synced and renamed over queue file; cursor is then reset
+ * to offset zero with new inode and first line CRC. A crash between the two
+ * leaves the old cursor; its inode does not match and the tail is read again
+ * from start - entries may be seen twice, none is lost.
+ * Caller holds source lock with tree state exclusive - sourceWriteBegin().
+ *
+ ***************************************************************************/
+
+int queueCompact(const char *queueFile, const char *cursorFile){
+
+  ASSERTARGS(queueFile && cursorFile);
+
+  QUEUE_CURSOR  cursor;
+  char          tmpName[PATH_MAX] = {0};
+  char          *buffer;
+  size_t        length;
+  off_t         consumed;
+  struct stat   status;
+  int           fd;
+  int           result;
+
+  result = queueReadCursor(&cursor, cursorFile);
+  if(result != ztSuccess)
+
+    return result;
+
+  consumed = cursor.offset;
+
+  if(consumed < QUEUE_COMPACT_SIZE)
+
+    return ztSuccess;
+
+  /* also checks cursor is for this file; offset is zero when it is not **/
+  buffer = readQueueTail(queueFile, &cursor, &length);
+  if(!buffer && length)
+
+    return ztFileError;
+
+  if(cursor.offset != consumed){
+    if(buffer)
+      free(buffer);
+    return ztSuccess;
+  }
+
+  if(strlen(queueFile) + 5 >= PATH_MAX){
+    fprintf(stderr, "%s: Error queue filename is too long.\n", progName);
+    if(buffer)
+      free(buffer);
+    return ztFnameLong;
+  }
+
+  sprintf(tmpName, "%s.tmp", queueFile);
+
+  errno = 0;
+  fd = open(tmpName, O_RDWR | O_CREAT | O_TRUNC, QUEUE_FILE_MODE);
+  if(fd < 0){
+    fprintf(stderr, "%s: Error failed open() for <%s>: %s\n", progName, tmpName, strerror(errno));
+    if(buffer)
+      free(buffer);
+    return ztOpenFileError;
+  }
+
+  result = length ? writeAll(fd, buffer, length) : ztSuccess;
+
+  if(buffer)
+    free(buffer);
+
+  if(result == ztSuccess && fsync(fd) != 0){
+    fprintf(stderr, "%s: Error failed fsync() for <%s>: %s\n", progName, tmpName, strerror(errno));
+    result = ztWriteError;
+  }
+
+  if(result == ztSuccess && fstat(fd, &status) != 0)
+    result = ztFailedSysCall;
+
+  if(result == ztSuccess){
+    cursor.offset = 0;
+    cursor.inode = status.st_ino;
+    cursor.first = firstLineCRC(fd, status.st_size);
+  }
+
+  close(fd);
+
+  if(result != ztSuccess){
+    unlink(tmpName);
+    return result;
+  }
+
+  if(rename(tmpName, queueFile) != 0){
+    fprintf(stderr, "%s: Error failed rename() for queue file <%s>: %s\n",
+            progName, queueFile, strerror(errno));
+    unlink(tmpName);
+    return ztFailedSysCall;
+  }
+
+  result = fsyncParentDir(queueFile);
+  if(result != ztSuccess)
+
+    return result;
+
+  return queueWriteCursor(cursorFile, &cursor);
+
+} /* END queueCompact() **/
+
+/* readQueueTail(): reads queue file from cursor offset to its end.
+ *
+ * cursor offset is reset to zero when queue file was replaced - different
+ * inode or different first line - or is shorter than offset; cursor inode
+ * and first line CRC are set to current file.
+ * Returns allocated buffer or NULL; 'length' is zero for empty tail.
+ *
+ ***************************************************************************/
+
+static char *readQueueTail(const char *queueFile, QUEUE_CURSOR *cursor, size_t *length){
+
+  int          fd;
+  struct stat  status;
+  char         *buffer;
+  size_t       size, got = 0;
+  ssize_t      count;
+  unsigned int first;
+
+  *length = 0;
+
+  errno = 0;
+  fd = open(queueFile, O_RDONLY);
+  if(fd < 0){
+    if(errno != ENOENT){
+      fprintf(stderr, "%s: Error failed open() for queue file <%s>: %s\n",
+              progName, queueFile, strerror(errno));
+      *length = 1; /* flag error to caller **/
+    }
+    return NULL;
+  }
+
+  if(fstat(fd, &status) != 0){
+    close(fd);
+    *length = 1;
+    return NULL;
+  }
+
+  first = firstLineCRC(fd, status.st_size);
+
+  /* same inode number may be given to new file; its first entry is not same **/
+  if((cursor->inode && cursor->inode != status.st_ino) || (cursor->offset > status.st_size) ||
+     (cursor->first && first && cursor->first != first))
+
+    cursor->offset = 0;
+
+  cursor->inode = status.st_ino;
+  cursor->first = first;
+
+  size = (size_t) (status.st_size - cursor->offset);
+  if(size == 0){
+    close(fd);
+    return NULL;
+  }
+
+  buffer = (char *) malloc(size);
+  if(!buffer){
+    fprintf(stderr, "%s: Error allocating memory in readQueueTail().\n", progName);
+    close(fd);
+    *length = 1;
+    return NULL;
+  }
+
+  while(got < size){
+    count = pread(fd, buffer + got, size - got, cursor->offset + (off_t) got);
+    if(count < 0 && errno == EINTR)
+      continue;
+    if(count <= 0)
+      break;
+    got += (size_t) count;
+  }
+
+  close(fd);
+
+  *length = got;
+
+  if(got == 0){
+    free(buffer);
+    return NULL;
+  }
+
+  return buffer;
+
+} /* END readQueueTail() **/
+
+/* firstLineCRC(): CRC32 of queue file first line with its linefeed; zero
+ * when file has no whole line yet. Never zero for a line.
+ *
+ ***************************************************************************/
+
+static unsigned int firstLineCRC(int fd, off_t size){
+
+  char          head[QUEUE_HEAD];
+  char          *end;
+  ssize_t       count;
+  unsigned int  crc;
+
+  if(size == 0)
+
+    return 0;
+
+  do {
+    count = pread(fd, head, (size_t) MIN(size, (off_t) sizeof(head)), 0);
+  } while(count < 0 && errno == EINTR);
+
+  if(count <= 0)
+
+    return 0;
+
+  end = memchr(head, '\n', (size_t) count);
+  if(!end)
+
+    return 0;
+
+  crc = (unsigned int) crc32(0L, (const Bytef *) head, (uInt) (end - head + 1));
+
+  return crc ? crc : 1;
+
+} /* END firstLineCRC() **/
+
+/* cutPartialLine(): truncates file after its last linefeed **/
+
+static int cutPartialLine(int fd, off_t size){
+
+  char   chunk[512];
+  off_t  pos;
+  size_t want;
+  ssize_t count;
+
+  if(size == 0)
+
+    return ztSuccess;
+
+  if(pread(fd, chunk, 1, size - 1) != 1)
+
+    return ztFileError;
+
+  if(chunk[0] == '\n')
+
+    return ztSuccess;
+
+  pos = size - 1;
+  while(pos > 0){
+
+    want = (size_t) MIN(pos, (off_t) sizeof(chunk));
+
+    count = pread(fd, chunk, want, pos - (off_t) want);
+    if(count != (ssize_t) want)
+      return ztFileError;
+
+    while(count > 0 && chunk[count - 1] != '\n')
+      count--;
+
+    if(count > 0){
+      pos = pos - (off_t) want + count;
+      break;
+    }
+
+    pos -= (off_t) want;
+  }
+
+  fprintf(stderr, "%s: Warning: removed partial last line from queue file.\n", progName);
+
+  if(ftruncate(fd, pos) != 0){
+    fprintf(stderr, "%s: Error failed ftruncate(): %s\n", progName, strerror(errno));
+    return ztFailedSysCall;
+  }
+
+  return ztSuccess;
+
+} /* END cutPartialLine() **/
+
+/* fsyncParentDir(): makes new directory entry - created or renamed - durable **/
+
+static int fsyncParentDir(const char *filename){
+
+  char  *copy;
+  int   fd;
+  int   result = ztSuccess;
+
+  copy = STRDUP(filename);
+
+  fd = open(dirname(copy), O_RDONLY | O_DIRECTORY);
+  if(fd < 0){
+    free(copy);
+    return ztFailedSysCall;
+  }
+
+  if(fsync(fd) != 0)
+    result = ztFailedSysCall;
+
+  close(fd);
+  free(copy);
+
+  return result;
+
+} /* END fsyncParentDir() **/
@@ -0,0 +1,1005 @@
+/*
+ * region.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * polygon filter for regional change files; see region.h.
+ *
+ * change file is read twice with osc.c reader, nothing is held in memory
+ * but one mask per node element:
+ *  - first pass: nodes only; region mask from location, cache is updated.
+ *    Ways later in file see final node locations - file order of elements
+ *    does not matter.
+ *  - second pass: ways and relations get mask from cache, then every element
+ *    is written to each region in its mask.
+ * Mask written for an element is old mask OR new mask; region that object
+ * moved out of gets the change too.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "region.h"
+#include "osc.h"
+#include "util.h"
+#include "fileio.h"
+#include "list.h"
+#include "ztError.h"
+#include "getdiff.h"
+#include "debug.h"
+
+#define CACHE_MAGIC    "getdiff-region-cache 1\n"
+#define CACHE_INITIAL  ((size_t) 1 << 16)
+
+#define OBJECT_KEY(type, id)  (((uint64_t) (id) << 2) | (uint64_t) (type))
+
+typedef struct REGION_OUT_ {
+
+  gzFile      gz;
+  OSC_ACTION  action;   /* open action block **/
+  char        partFile[PATH_MAX];
+  char        destFile[PATH_MAX];
+
+} REGION_OUT;
+
+static int loadCache(REGION_SET *set);
+static int saveCache(REGION_SET *set);
+static int regionNames(char *dest, size_t size, REGION_SET *set);
+static uint32_t cacheGet(REGION_CACHE_TABLE *table, uint64_t key);
+static int cacheSet(REGION_CACHE_TABLE *table, uint64_t key, uint32_t mask);
+static int growCache(REGION_CACHE_TABLE *table, size_t newSize);
+static size_t slotOf(const REGION_CACHE_TABLE *table, uint64_t key);
+static uint32_t locationMask(REGION_SET *set, double lat, double lon);
+static uint32_t referenceMask(REGION_SET *set, const OSC_ELEMENT *element);
+static int emitElement(REGION_OUT *out, const OSC_ELEMENT *element);
+static int copyStateFile(const char *destFile, const char *srcFile);
+static int makeSequenceDirs(const char *regionDir, SEQ_NUM seq);
+static void zapRegion(REGION *region);
+
+/* isGoodRegionName(): letters, digits, '-' and '_' only; used as directory **/
+
+int isGoodRegionName(const char *name){
+
+  ASSERTARGS(name);
+
+  const char  *ch;
+
+  if(! *name || strlen(name) > REGION_NAME_MAX)
+    return FALSE;
+
+  for(ch = name; *ch; ch++)
+    if(! isalnum((unsigned char) *ch) && *ch != '-' && *ch != '_')
+      return FALSE;
+
+  return TRUE;
+
+} /* END isGoodRegionName() **/
+
+/* initialRegionSet(): 'regionArgs' entries are "NAME=/full/path.poly";
+ * makes {workDir}/regions/{name} directories and loads object cache.
+ *
+ ***************************************************************************/
+
+REGION_SET *initialRegionSet(char **regionArgs, int numRegions, const char *workDir){
+
+  ASSERTARGS(regionArgs && workDir);
+
+  REGION_SET  *set;
+  REGION      *region;
+  char        buffer[PATH_MAX];
+  char        *equal;
+  int         index, result;
+
+  if(numRegions < 1 || numRegions > MAX_REGIONS){
+    fprintf(stderr, "%s: Error number of regions must be 1 to %d.\n", progName, MAX_REGIONS);
+    return NULL;
+  }
+
+  set = (REGION_SET *) calloc(1, sizeof(REGION_SET));
+  if(!set){
+    fprintf(stderr, "%s: Error allocating memory in initialRegionSet().\n", progName);
+    return NULL;
+  }
+
+  if(snprintf(buffer, sizeof(buffer), "%s%s%s", workDir, SLASH_ENDING(workDir) ? "" : "/", REGIONS_DIR) >= (int) sizeof(buffer) ||
+     myMkDir(buffer) != ztSuccess){
+    fprintf(stderr, "%s: Error failed making regions directory: <%s>\n", progName, buffer);
+    free(set);
+    return NULL;
+  }
+
+  set->regionsDir = STRDUP(buffer);
+
+  for(index = 0; index < numRegions; index++){
+
+    region = set->regions + index;
+
+    equal = strchr(regionArgs[index], '=');
+    if(!equal || equal - regionArgs[index] > REGION_NAME_MAX){
+      fprintf(stderr, "%s: Error bad region argument: <%s>\n", progName, regionArgs[index]);
+      closeRegionSet(&set);
+      return NULL;
+    }
+
+    memcpy(region->name, regionArgs[index], (size_t) (equal - regionArgs[index]));
+    region->name[equal - regionArgs[index]] = '\0';
+
+    set->numRegions++;
+
+    result = readPolyFile(region, equal + 1);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed readPolyFile() for region <%s>: %s\n", progName, region->name, equal + 1);
+      closeRegionSet(&set);
+      return NULL;
+    }
+
+    if(snprintf(buffer, sizeof(buffer), "%s/%s", set->regionsDir, region->name) >= (int) sizeof(buffer) ||
+       myMkDir(buffer) != ztSuccess){
+      fprintf(stderr, "%s: Error failed making region directory: <%s>\n", progName, buffer);
+      closeRegionSet(&set);
+      return NULL;
+    }
+  }
+
+  result = loadCache(set);
+  if(result != ztSuccess){
+    closeRegionSet(&set);
+    return NULL;
+  }
+
+  return set;
+
+} /* END initialRegionSet() **/
+
+/* filterChangeFile(): writes one change file and state.txt per region for
+ * 'oscFile'; 'pathSuffix' is its "/NNN/NNN/NNN.osc.gz" path part. Appends
+ * the new pair to {region}/newerFiles.txt.
+ *
+ ***************************************************************************/
+
+int filterChangeFile(REGION_SET *set, const char *oscFile, const char *stateFile, const char *pathSuffix){
+
+  ASSERTARGS(set && oscFile && stateFile && pathSuffix);
+
+  REGION_OUT   out[MAX_REGIONS];
+  OSC_READER   *reader;
+  OSC_ELEMENT  element;
+  uint32_t     *nodeMasks = NULL, *newMasks;
+  size_t       nodeCount = 0, nodeSize = 0, nodeIndex = 0;
+  uint32_t     oldMask, newMask, mask;
+  uint64_t     key;
+  SEQ_NUM      seq;
+  char         regionDir[PATH_MAX];
+  char         buffer[PATH_MAX];
+  char         seqPath[16];
+  STRING_LIST  *pairList;
+  int          index;
+  int          result;
+
+  result = path2Sequence(&seq, pathSuffix);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error no sequence number in path: <%s>\n", progName, pathSuffix);
+    return result;
+  }
+
+  sequence2Path(seqPath, seq);
+
+  /* first pass: nodes **/
+  reader = oscOpen(oscFile);
+  if(!reader){
+    fprintf(stderr, "%s: Error failed oscOpen() for: <%s>\n", progName, oscFile);
+    return ztOpenFileError;
+  }
+
+  while((result = oscNext(reader, &element)) == ztSuccess){
+
+    if(element.type != OSC_NODE)
+      continue;
+
+    key = OBJECT_KEY(OSC_NODE, element.id);
+
+    oldMask = cacheGet(&set->cache, key);
+
+    newMask = 0;
+    if(element.action != OSC_DELETE && element.hasLocation)
+      newMask = locationMask(set, element.lat, element.lon);
+
+    if(nodeCount == nodeSize){
+
+      nodeSize = nodeSize ? nodeSize * 2 : 4096;
+
+      newMasks = (uint32_t *) realloc(nodeMasks, nodeSize * sizeof(uint32_t));
+      if(!newMasks){
+        fprintf(stderr, "%s: Error allocating memory in filterChangeFile().\n", progName);
+        result = ztMemoryAllocate;
+        break;
+      }
+
+      nodeMasks = newMasks;
+    }
+
+    nodeMasks[nodeCount++] = oldMask | newMask;
+
+    result = cacheSet(&set->cache, key, newMask);
+    if(result != ztSuccess)
+      break;
+  }
+
+  oscClose(&reader);
+
+  if(result != ztEndOfFile){
+    fprintf(stderr, "%s: Error failed reading change file: <%s>\n", progName, oscFile);
+    free(nodeMasks);
+    return (result == ztSuccess) ? ztUnknownError : result;
+  }
+
+  /* open outputs **/
+  memset(out, 0, sizeof(out));
+
+  for(index = 0; index < set->numRegions; index++){
+
+    if(snprintf(regionDir, sizeof(regionDir), "%s/%s", set->regionsDir, set->regions[index].name) >= (int) sizeof(regionDir) ||
+       snprintf(out[index].destFile, PATH_MAX, "%s%s%s", regionDir, seqPath, CHANGE_EXT) >= PATH_MAX ||
+       snprintf(out[index].partFile, PATH_MAX, "%s.part", out[index].destFile) >= PATH_MAX){
+      fprintf(stderr, "%s: Error region filename is too long.\n", progName);
+      result = ztFnameLong;
+      goto FILTER_CLEAN;
+    }
+
+    result = makeSequenceDirs(regionDir, seq);
+    if(result != ztSuccess)
+      goto FILTER_CLEAN;
+
+    out[index].gz = gzopen(out[index].partFile, "wb6");
+    if(!out[index].gz){
+      fprintf(stderr, "%s: Error failed gzopen() for region output: <%s>\n", progName, out[index].partFile);
+      result = ztOpenFileError;
+      goto FILTER_CLEAN;
+    }
+
+    gzprintf(out[index].gz, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                            "<osmChange version=\"0.6\" generator=\"%s %s\">\n", progName, VERSION);
+  }
+
+  /* second pass: ways & relations, write all **/
+  reader = oscOpen(oscFile);
+  if(!reader){
+    fprintf(stderr, "%s: Error failed oscOpen() for: <%s>\n", progName, oscFile);
+    result = ztOpenFileError;
+    goto FILTER_CLEAN;
+  }
+
+  while((result = oscNext(reader, &element)) == ztSuccess){
+
+    if(element.type == OSC_NODE){
+
+      /* same file, same element order as first pass **/
+      if(nodeIndex >= nodeCount){
+        result = ztMalformedFile;
+        break;
+      }
+
+      mask = nodeMasks[nodeIndex++];
+    }
+    else {
+
+      key = OBJECT_KEY(element.type, element.id);
+
+      oldMask = cacheGet(&set->cache, key);
+
+      /* deleted way or relation has no members in change file **/
+      newMask = (element.action == OSC_DELETE) ? 0 : referenceMask(set, &element);
+
+      mask = oldMask | newMask;
+
+      result = cacheSet(&set->cache, key, newMask);
+      if(result != ztSuccess)
+        break;
+    }
+
+    for(index = 0; mask && index < set->numRegions; index++){
+
+      if(! (mask & ((uint32_t) 1 << index)))
+        continue;
+
+      result = emitElement(out + index, &element);
+      if(result != ztSuccess)
+        break;
+    }
+
+    if(result != ztSuccess)
+      break;
+  }
+
+  oscClose(&reader);
+
+  if(result != ztEndOfFile){
+    fprintf(stderr, "%s: Error failed filtering change file: <%s>\n", progName, oscFile);
+    if(result == ztSuccess)
+      result = ztUnknownError;
+    goto FILTER_CLEAN;
+  }
+
+  result = ztSuccess;
+
+  for(index = 0; index < set->numRegions; index++){
+
+    if(out[index].action != OSC_NO_ACTION)
+      gzprintf(out[index].gz, "</%s>\n", oscActionName(out[index].action));
+
+    gzprintf(out[index].gz, "</osmChange>\n");
+
+    if(gzclose(out[index].gz) != Z_OK && result == ztSuccess){
+      fprintf(stderr, "%s: Error failed gzclose() for region output: <%s>\n", progName, out[index].partFile);
+      result = ztWriteError;
+    }
+
+    out[index].gz = NULL;
+
+    if(result == ztSuccess && rename(out[index].partFile, out[index].destFile) != 0){
+      fprintf(stderr, "%s: Error failed rename() to <%s>: %s\n", progName, out[index].destFile, strerror(errno));
+      result = ztFailedSysCall;
+    }
+  }
+
+  if(result != ztSuccess)
+    goto FILTER_CLEAN;
+
+  /* state.txt next to each regional file, then latest state.txt **/
+  for(index = 0; index < set->numRegions && result == ztSuccess; index++){
+
+    snprintf(regionDir, sizeof(regionDir), "%s/%s", set->regionsDir, set->regions[index].name);
+
+    if(snprintf(buffer, sizeof(buffer), "%s%s%s", regionDir, seqPath, STATE_EXT) >= (int) sizeof(buffer)){
+      result = ztFnameLong;
+      break;
+    }
+
+    result = copyStateFile(buffer, stateFile);
+    if(result != ztSuccess)
+      break;
+
+    if(snprintf(buffer, sizeof(buffer), "%s/state.txt", regionDir) >= (int) sizeof(buffer)){
+      result = ztFnameLong;
+      break;
+    }
+
+    result = copyStateFile(buffer, stateFile);
+    if(result != ztSuccess)
+      break;
+
+    pairList = initialStringList();
+    if(!pairList){
+      result = ztMemoryAllocate;
+      break;
+    }
+
+    insertNextDL(pairList, DL_TAIL(pairList), (void *) STRDUP(pathSuffix));
+    snprintf(buffer, sizeof(buffer), "%s%s", seqPath, STATE_EXT);
+    insertNextDL(pairList, DL_TAIL(pairList), (void *) STRDUP(buffer));
+
+    if(snprintf(buffer, sizeof(buffer), "%s/%s", regionDir, NEW_DIFFERS) >= (int) sizeof(buffer))
+      result = ztFnameLong;
+    else
+      result = writeNewerFiles(buffer, pairList);
+
+    zapStringList((void **) &pairList);
+  }
+
+FILTER_CLEAN:
+
+  for(index = 0; index < set->numRegions; index++){
+
+    if(out[index].gz){
+      gzclose(out[index].gz);
+      out[index].gz = NULL;
+    }
+
+    if(result != ztSuccess && out[index].partFile[0])
+      unlink(out[index].partFile);
+  }
+
+  free(nodeMasks);
+
+  return result;
+
+} /* END filterChangeFile() **/
+
+/* closeRegionSet(): saves object cache, frees everything **/
+
+int closeRegionSet(REGION_SET **set){
+
+  ASSERTARGS(set);
+
+  int  index;
+  int  result = ztSuccess;
+
+  if(! *set)
+    return ztSuccess;
+
+  if((*set)->cache.keys)
+    result = saveCache(*set);
+
+  for(index = 0; index < (*set)->numRegions; index++)
+    zapRegion((*set)->regions + index);
+
+  free((*set)->cache.keys);
+  free((*set)->cache.masks);
+  free((*set)->regionsDir);
+  free(*set);
+
+  *set = NULL;
+
+  return result;
+
+} /* END closeRegionSet() **/
+
+/* readPolyFile(): Osmosis polygon filter file format:
+ *
+ *   name
+ *   1             <- ring; name starting with '!' is a hole
+ *      lon   lat
+ *      ...
+ *   END
+ *   END
+ *
+ * holes need no special care; pointInRegion() is even-odd over all rings.
+ ***************************************************************************/
+
+int readPolyFile(REGION *region, const char *polyFile){
+
+  ASSERTARGS(region && polyFile);
+
+  FILE       *fp;
+  char       line[256];
+  char       *ptr, *endPtr;
+  POLY_RING  *ring, *newRings;
+  double     lon, lat, *newLon, *newLat;
+  int        size = 0;
+  int        inRing = FALSE;
+  int        result = ztSuccess;
+
+  errno = 0;
+  fp = fopen(polyFile, "r");
+  if(!fp){
+    fprintf(stderr, "%s: Error failed fopen() for poly file <%s>: %s\n", progName, polyFile, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  /* first line is polygon name **/
+  if(! fgets(line, sizeof(line), fp)){
+    fclose(fp);
+    return ztFileEmpty;
+  }
+
+  region->minLon = region->minLat = 1000.0;
+  region->maxLon = region->maxLat = -1000.0;
+
+  while(fgets(line, sizeof(line), fp)){
+
+    for(ptr = line; isspace((unsigned char) *ptr); ptr++)
+      ;
+
+    ptr[strcspn(ptr, "\r\n")] = '\0';
+
+    if(! *ptr)
+      continue;
+
+    if(strcmp(ptr, "END") == 0){
+
+      if(! inRing)
+        break;   /* end of file **/
+
+      inRing = FALSE;
+      continue;
+    }
+
+    if(! inRing){ /* ring name **/
+
+      newRings = (POLY_RING *) realloc(region->rings, (size_t) (region->numRings + 1) * sizeof(POLY_RING));
+      if(!newRings){
+        result = ztMemoryAllocate;
+        break;
+      }
+
+      region->rings = newRings;
+      memset(region->rings + region->numRings, 0, sizeof(POLY_RING));
+      region->numRings++;
+
+      size = 0;
+      inRing = TRUE;
+      continue;
+    }
+
+    errno = 0;
+    lon = strtod(ptr, &endPtr);
+    lat = strtod(endPtr, &ptr);
+    if(errno || ptr == endPtr || lon < -180.0 || lon > 180.0 || lat < -90.0 || lat > 90.0){
+      fprintf(stderr, "%s: Error bad coordinates line in poly file <%s>: %s\n", progName, polyFile, line);
+      result = ztMalformedFile;
+      break;
+    }
+
+    ring = region->rings + region->numRings - 1;
+
+    if(ring->count == size){
+
+      size = size ? size * 2 : 64;
+
+      newLon = (double *) realloc(ring->lon, (size_t) size * sizeof(double));
+      if(newLon)
+        ring->lon = newLon;
+
+      newLat = (double *) realloc(ring->lat, (size_t) size * sizeof(double));
+      if(newLat)
+        ring->lat = newLat;
+
+      if(!newLon || !newLat){
+        result = ztMemoryAllocate;
+        break;
+      }
+    }
+
+    ring->lon[ring->count] = lon;
+    ring->lat[ring->count] = lat;
+    ring->count++;
+
+    if(lon < region->minLon) region->minLon = lon;
+    if(lon > region->maxLon) region->maxLon = lon;
+    if(lat < region->minLat) region->minLat = lat;
+    if(lat > region->maxLat) region->maxLat = lat;
+  }
+
+  fclose(fp);
+
+  if(result == ztSuccess && (inRing || region->numRings == 0 || region->rings[0].count < 3)){
+    fprintf(stderr, "%s: Error malformed poly file: <%s>\n", progName, polyFile);
+    result = ztMalformedFile;
+  }
+
+  return result;
+
+} /* END readPolyFile() **/
+
+/* pointInRegion(): even-odd ray casting over all rings **/
+
+int pointInRegion(const REGION *region, double lat, double lon){
+
+  ASSERTARGS(region);
+
+  const POLY_RING  *ring;
+  int              r, i, j;
+  int              inside = FALSE;
+
+  if(lon < region->minLon || lon > region->maxLon || lat < region->minLat || lat > region->maxLat)
+    return FALSE;
+
+  for(r = 0; r < region->numRings; r++){
+
+    ring = region->rings + r;
+
+    for(i = 0, j = ring->count - 1; i < ring->count; j = i++){
+
+      if(((ring->lat[i] > lat) != (ring->lat[j] > lat)) &&
+         (lon < (ring->lon[j] - ring->lon[i]) * (lat - ring->lat[i]) / (ring->lat[j] - ring->lat[i]) + ring->lon[i]))
+
+        inside = ! inside;
+    }
+  }
+
+  return inside;
+
+} /* END pointInRegion() **/
+
+static uint32_t locationMask(REGION_SET *set, double lat, double lon){
+
+  uint32_t  mask = 0;
+  int       index;
+
+  for(index = 0; index < set->numRegions; index++)
+    if(pointInRegion(set->regions + index, lat, lon))
+      mask |= (uint32_t) 1 << index;
+
+  return mask;
+
+} /* END locationMask() **/
+
+/* referenceMask(): OR of cached masks for <nd ref=".."> in way and
+ * <member type=".." ref=".."> in relation.
+ **************************************************************************/
+
+static uint32_t referenceMask(REGION_SET *set, const OSC_ELEMENT *element){
+
+  const char  *ptr, *end, *value;
+  const char  *tagName;
+  size_t      length;
+  OSC_TYPE    type = OSC_NODE;
+  uint32_t    mask = 0;
+
+  tagName = (element->type == OSC_WAY) ? "<nd " : "<member ";
+
+  ptr = element->text;
+  end = element->text + element->length;
+
+  while(ptr < end && (ptr = strstr(ptr, tagName))){
+
+    ptr++;
+
+    if(element->type == OSC_RELATION){
+
+      if(oscAttribute(ptr, "type", &value, &length) != ztSuccess)
+        continue;
+
+      if(length == 4 && strncmp(value, "node", 4) == 0)
+        type = OSC_NODE;
+      else if(length == 3 && strncmp(value, "way", 3) == 0)
+        type = OSC_WAY;
+      else if(length == 8 && strncmp(value, "relation", 8) == 0)
+        type = OSC_RELATION;
+      else
+        continue;
+    }
+
+    if(oscAttribute(ptr, "ref", &value, &length) != ztSuccess)
+      continue;
+
+    mask |= cacheGet(&set->cache, OBJECT_KEY(type, strtoll(value, NULL, 10)));
+  }
+
+  return mask;
+
+} /* END referenceMask() **/
+
+static int emitElement(REGION_OUT *out, const OSC_ELEMENT *element){
+
+  if(element->action != out->action){
+
+    if(out->action != OSC_NO_ACTION)
+      gzprintf(out->gz, "</%s>\n", oscActionName(out->action));
+
+    gzprintf(out->gz, "<%s>\n", oscActionName(element->action));
+    out->action = element->action;
+  }
+
+  if(gzputs(out->gz, "  ") < 0 ||
+     gzwrite(out->gz, element->text, (unsigned) element->length) != (int) element->length ||
+     gzputs(out->gz, "\n") < 0){
+
+    fprintf(stderr, "%s: Error failed writing region output.\n", progName);
+    return ztWriteError;
+  }
+
+  return ztSuccess;
+
+} /* END emitElement() **/
+
+static uint32_t cacheGet(REGION_CACHE_TABLE *table, uint64_t key){
+
+  size_t  slot;
+
+  if(! table->count)
+    return 0;
+
+  slot = slotOf(table, key);
+
+  return (table->keys[slot] == key) ? table->masks[slot] : 0;
+
+} /* END cacheGet() **/
+
+/* cacheSet(): zero mask is not inserted; existing entry is set to zero **/
+
+static int cacheSet(REGION_CACHE_TABLE *table, uint64_t key, uint32_t mask){
+
+  size_t  slot;
+  int     result;
+
+  if(table->size){
+
+    slot = slotOf(table, key);
+
+    if(table->keys[slot] == key){
+      table->masks[slot] = mask;
+      return ztSuccess;
+    }
+  }
+
+  if(! mask)
+    return ztSuccess;
+
+  /* keep load under one half **/
+  if((table->count + 1) * 2 > table->size){
+
+    result = growCache(table, table->size ? table->size * 2 : CACHE_INITIAL);
+    if(result != ztSuccess)
+      return result;
+  }
+
+  slot = slotOf(table, key);
+
+  table->keys[slot] = key;
+  table->masks[slot] = mask;
+  table->count++;
+
+  return ztSuccess;
+
+} /* END cacheSet() **/
+
+static int growCache(REGION_CACHE_TABLE *table, size_t newSize){
+
+  REGION_CACHE_TABLE  bigger;
+  size_t              index, slot;
+
+  bigger.keys = (uint64_t *) calloc(newSize, sizeof(uint64_t));
+  bigger.masks = (uint32_t *) calloc(newSize, sizeof(uint32_t));
+  bigger.size = newSize;
+  bigger.count = table->count;
+
+  if(!bigger.keys || !bigger.masks){
+    fprintf(stderr, "%s: Error allocating memory for region cache.\n", progName);
+    free(bigger.keys);
+    free(bigger.masks);
+    return ztMemoryAllocate;
+  }
+
+  for(index = 0; index < table->size; index++){
+
+    if(! table->keys[index])
+      continue;
+
+    slot = slotOf(&bigger, table->keys[index]);
+
+    bigger.keys[slot] = table->keys[index];
+    bigger.masks[slot] = table->masks[index];
+  }
+
+  free(table->keys);
+  free(table->masks);
+
+  *table = bigger;
+
+  return ztSuccess;
+
+} /* END growCache() **/
+
+/* slotOf(): slot with 'key' or first empty slot; linear probing **/
+
+static size_t slotOf(const REGION_CACHE_TABLE *table, uint64_t key){
+
+  size_t  slot;
+
+  slot = (size_t) ((key * 0x9E3779B97F4A7C15ULL) >> 17) & (table->size - 1);
+
+  while(table->keys[slot] && table->keys[slot] != key)
+    slot = (slot + 1) & (table->size - 1);
+
+  return slot;
+
+} /* END slotOf() **/
+
+/* cache file: text header then (key, mask) records in host byte order.
+ * Masks are bit positions in region list; different list - names or
+ * order - starts with empty cache.
+ **************************************************************************/
+
+static int loadCache(REGION_SET *set){
+
+  FILE      *fp;
+  char      cacheFile[PATH_MAX];
+  char      line[MAX_REGIONS * (REGION_NAME_MAX + 1) + 32];
+  char      names[MAX_REGIONS * (REGION_NAME_MAX + 1) + 32];
+  uint64_t  key;
+  uint32_t  mask;
+  long      count = 0, index;
+  int       result = ztSuccess;
+
+  snprintf(cacheFile, sizeof(cacheFile), "%s/%s", set->regionsDir, REGION_CACHE);
+
+  fp = fopen(cacheFile, "rb");
+  if(!fp)
+    return ztSuccess; /* first run **/
+
+  strcpy(names, "regions=");
+  regionNames(names + strlen(names), sizeof(names) - strlen(names), set);
+  strcat(names, "\n");
+
+  if(! fgets(line, sizeof(line), fp) || strcmp(line, CACHE_MAGIC) != 0 ||
+     ! fgets(line, sizeof(line), fp) || strcmp(line, names) != 0 ||
+     ! fgets(line, sizeof(line), fp) || sscanf(line, "count=%ld", &count) != 1 || count < 0){
+
+    fclose(fp);
+    fprintf(stdout, "%s: Region list changed or cache file is not ours; starting with empty cache.\n", progName);
+    logMessage(fLogPtr, "Region list changed or cache file is not ours; starting with empty cache.");
+    return ztSuccess;
+  }
+
+  for(index = 0; index < count && result == ztSuccess; index++){
+
+    if(fread(&key, sizeof(key), 1, fp) != 1 || fread(&mask, sizeof(mask), 1, fp) != 1){
+      fprintf(stderr, "%s: Error region cache file is truncated: <%s>\n", progName, cacheFile);
+      result = ztMalformedFile;
+      break;
+    }
+
+    result = cacheSet(&set->cache, key, mask);
+  }
+
+  fclose(fp);
+
+  if(result == ztSuccess && fVerbose)
+    fprintf(stdout, "%s: Loaded <%ld> objects into region cache.\n", progName, count);
+
+  return result;
+
+} /* END loadCache() **/
+
+static int saveCache(REGION_SET *set){
+
+  REGION_CACHE_TABLE  *table = &set->cache;
+  FILE                *fp;
+  char                cacheFile[PATH_MAX], partFile[PATH_MAX];
+  char                names[MAX_REGIONS * (REGION_NAME_MAX + 1) + 32];
+  size_t              index;
+  long                count = 0;
+  int                 result = ztSuccess;
+
+  snprintf(cacheFile, sizeof(cacheFile), "%s/%s", set->regionsDir, REGION_CACHE);
+  snprintf(partFile, sizeof(partFile), "%s/%s.part", set->regionsDir, REGION_CACHE);
+
+  /* objects out of all regions are dropped **/
+  for(index = 0; index < table->size; index++)
+    if(table->keys[index] && table->masks[index])
+      count++;
+
+  errno = 0;
+  fp = fopen(partFile, "wb");
+  if(!fp){
+    fprintf(stderr, "%s: Error failed fopen() for <%s>: %s\n", progName, partFile, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  regionNames(names, sizeof(names), set);
+
+  fprintf(fp, "%sregions=%s\ncount=%ld\n", CACHE_MAGIC, names, count);
+
+  for(index = 0; index < table->size; index++){
+
+    if(! table->keys[index] || ! table->masks[index])
+      continue;
+
+    if(fwrite(table->keys + index, sizeof(uint64_t), 1, fp) != 1 ||
+       fwrite(table->masks + index, sizeof(uint32_t), 1, fp) != 1){
+      result = ztWriteError;
+      break;
+    }
+  }
+
+  if(fclose(fp) != 0 && result == ztSuccess)
+    result = ztWriteError;
+
+  if(result == ztSuccess && rename(partFile, cacheFile) != 0)
+    result = ztFailedSysCall;
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed writing region cache file: <%s>\n", progName, cacheFile);
+    unlink(partFile);
+  }
+
+  return result;
+
+} /* END saveCache() **/
+
+static int regionNames(char *dest, size_t size, REGION_SET *set){
+
+  size_t  used = 0;
+  int     index;
+
+  dest[0] = '\0';
+
+  for(index = 0; index < set->numRegions; index++){
+
+    if(used + strlen(set->regions[index].name) + 2 > size)
+      return ztFnameLong;
+
+    used += (size_t) sprintf(dest + used, "%s%s", index ? "," : "", set->regions[index].name);
+  }
+
+  return ztSuccess;
+
+} /* END regionNames() **/
+
+/* copyStateFile(): copies through "destFile.part" **/
+
+static int copyStateFile(const char *destFile, const char *srcFile){
+
+  FILE    *in, *out;
+  char    partFile[PATH_MAX];
+  char    buffer[4096];
+  size_t  count;
+  int     result = ztSuccess;
+
+  if(snprintf(partFile, sizeof(partFile), "%s.part", destFile) >= (int) sizeof(partFile))
+    return ztFnameLong;
+
+  in = fopen(srcFile, "r");
+  if(!in){
+    fprintf(stderr, "%s: Error failed fopen() for <%s>\n", progName, srcFile);
+    return ztOpenFileError;
+  }
+
+  out = fopen(partFile, "w");
+  if(!out){
+    fprintf(stderr, "%s: Error failed fopen() for <%s>\n", progName, partFile);
+    fclose(in);
+    return ztOpenFileError;
+  }
+
+  while((count = fread(buffer, 1, sizeof(buffer), in)) > 0)
+    if(fwrite(buffer, 1, count, out) != count){
+      result = ztWriteError;
+      break;
+    }
+
+  if(ferror(in))
+    result = ztFileError;
+
+  fclose(in);
+
+  if(fclose(out) != 0 && result == ztSuccess)
+    result = ztWriteError;
+
+  if(result == ztSuccess && rename(partFile, destFile) != 0)
+    result = ztFailedSysCall;
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed copying state file to <%s>\n", progName, destFile);
+    unlink(partFile);
+  }
+
+  return result;
+
+} /* END copyStateFile() **/
+
+static int makeSequenceDirs(const char *regionDir, SEQ_NUM seq){
+
+  char  rootEntry[8], parentEntry[8];
+  char  buffer[PATH_MAX];
+  int   result;
+
+  sequence2Entries(rootEntry, parentEntry, NULL, seq);
+
+  if(snprintf(buffer, sizeof(buffer), "%s/%s", regionDir, rootEntry) >= (int) sizeof(buffer))
+    return ztFnameLong;
+
+  result = myMkDir(buffer);
+  if(result != ztSuccess)
+    return result;
+
+  if(strlen(buffer) + strlen(parentEntry) >= sizeof(buffer))
+    return ztFnameLong;
+
+  strcat(buffer, parentEntry);
+
+  return myMkDir(buffer);
+
+} /* END makeSequenceDirs() **/
+
+static void zapRegion(REGION *region){
+
+  int  r;
+
+  for(r = 0; r < region->numRings; r++){
+    free(region->rings[r].lon);
+    free(region->rings[r].lat);
+  }
+
+  free(region->rings);
+
+  region->rings = NULL;
+  region->numRings = 0;
+
+} /* END zapRegion() **/
@@ -0,0 +1,729 @@
+/*
+ * retain.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * change files tree retention; see retain.h.
+ *
+ * first pass counts change files - and bytes with size policy - per parent
+ * directory without keeping file names. Second pass walks parents oldest
+ * first and removes one sequence number at a time until all policies are
+ * met, 'bound' is reached or RETAIN_MAX_PAIRS are removed.
+ *
+ * pack files are removed whole - never opened up - when over a policy or
+ * when their newest member is older than 'maxDays'.
+ *
+ * startRetention() runs it as a single job on its own worker pool; report
+ * is logged from main thread by finishRetention().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "retain.h"
+#include "queue.h"
+#include "idindex.h"
+#include "merge.h"
+#include "transcode.h"
+#include "pack.h"
+#include "workers.h"
+#include "srclock.h"
+#include "util.h"
+#include "list.h"
+#include "ztError.h"
+#include "getdiff.h"
+#include "debug.h"
+
+#define SECONDS_PER_DAY  (24L * 60L * 60L)
+
+typedef struct PARENT_INFO_ {
+
+  SEQ_NUM    base;     /* first sequence number in parent directory **/
+  long       pairs;
+  long long  bytes;
+  time_t     mtime;    /* pack file only **/
+  int        isPack;   /* "NNN.pack" next to where directory was **/
+
+} PARENT_INFO;
+
+typedef struct RETAIN_JOB_ {
+
+  char           prefix[PATH_MAX];
+  RETAIN_POLICY  policy;
+  SEQ_NUM        bound;
+  RETAIN_REPORT  report;
+  int            result;
+
+} RETAIN_JOB;
+
+static WORK_POOL   *retainPool = NULL;
+static RETAIN_JOB  retainJob;
+
+static int retainWork(void *arg);
+static int scanParents(PARENT_INFO **parents, int *numParents, RETAIN_REPORT *report,
+                       const char *prefix, int withBytes);
+static int scanParent(PARENT_INFO *info, const char *parentDir, int withBytes);
+static int scanPack(PARENT_INFO *info, const char *packFile);
+static int removePack(RETAIN_REPORT *report, const RETAIN_POLICY *policy, const PARENT_INFO *info,
+                      const char *rootDir, long *pairs, long long *bytes, int *done);
+static int trimParent(RETAIN_REPORT *report, const RETAIN_POLICY *policy, const PARENT_INFO *info,
+                      const char *parentDir, long *pairs, long long *bytes, int *done);
+static int isOverPolicy(const RETAIN_POLICY *policy, long pairs, long long bytes);
+static int isChangeName(const char *name);
+static int isSequenceName(const char *name);
+static int compareParents(const void *first, const void *second);
+
+/* string2Bytes(): "500M", "20G", "1T" or plain bytes; K, M, G and T are
+ * powers of 1024.
+ **************************************************************************/
+
+int string2Bytes(long long *bytes, const char *string){
+
+  ASSERTARGS(bytes && string);
+
+  char       *endPtr;
+  long long  value;
+  int        shift = 0;
+
+  if(*string < '0' || *string > '9')
+    return ztInvalidArg;
+
+  errno = 0;
+  value = strtoll(string, &endPtr, 10);
+  if(errno || value <= 0)
+    return ztInvalidArg;
+
+  switch(*endPtr){
+
+  case '\0':           break;
+  case 'K': case 'k':  shift = 10; break;
+  case 'M': case 'm':  shift = 20; break;
+  case 'G': case 'g':  shift = 30; break;
+  case 'T': case 't':  shift = 40; break;
+
+  default:
+    return ztInvalidArg;
+  }
+
+  if(shift && endPtr[1] != '\0')
+    return ztInvalidArg;
+
+  if(value > (LLONG_MAX >> shift))
+    return ztInvalidArg;
+
+  *bytes = value << shift;
+
+  return ztSuccess;
+
+} /* END string2Bytes() **/
+
+/* consumerFloor(): smallest sequence number in queue entries updater has
+ * not consumed; SEQ_NONE when nothing is pending.
+ **************************************************************************/
+
+int consumerFloor(SEQ_NUM *floor, const char *queueFile, const char *cursorFile){
+
+  ASSERTARGS(floor && queueFile && cursorFile);
+
+  STRING_LIST  *pending;
+  ELEM         *elem;
+  SEQ_NUM      seq;
+  int          result;
+
+  *floor = SEQ_NONE;
+
+  pending = initialStringList();
+  if(!pending)
+    return ztMemoryAllocate;
+
+  result = queuePending(pending, NULL, queueFile, cursorFile);
+  if(result != ztSuccess){
+    zapStringList((void **) &pending);
+    return result;
+  }
+
+  /* merged file names have no sequence path; parts are older than last **/
+  for(elem = DL_HEAD(pending); elem; elem = DL_NEXT(elem)){
+
+    if(path2Sequence(&seq, (char *) DL_DATA(elem)) != ztSuccess)
+      continue;
+
+    if(*floor == SEQ_NONE || seq < *floor)
+      *floor = seq;
+  }
+
+  zapStringList((void **) &pending);
+
+  return ztSuccess;
+
+} /* END consumerFloor() **/
+
+int startRetention(const char *prefix, const RETAIN_POLICY *policy, SEQ_NUM bound){
+
+  ASSERTARGS(prefix && policy);
+
+  int  result;
+
+  memset(&retainJob, 0, sizeof(RETAIN_JOB));
+
+  if(snprintf(retainJob.prefix, sizeof(retainJob.prefix), "%s", prefix) >= (int) sizeof(retainJob.prefix))
+    return ztFnameLong;
+
+  retainJob.policy = *policy;
+  retainJob.bound = bound;
+
+  retainPool = initialWorkPool(1, retainWork, NULL);
+  if(!retainPool){
+    fprintf(stderr, "%s: Error failed initialWorkPool().\n", progName);
+    return ztFailedSysCall;
+  }
+
+  result = submitWork(retainPool, &retainJob);
+  if(result != ztSuccess)
+    finishWorkPool(&retainPool);
+
+  return result;
+
+} /* END startRetention() **/
+
+int isRetaining(void){
+
+  return (retainPool != NULL);
+
+} /* END isRetaining() **/
+
+/* finishRetention(): waits for retention job and writes its report to log **/
+
+int finishRetention(void){
+
+  RETAIN_REPORT  *report = &retainJob.report;
+  char           buffer[512];
+  int            result;
+
+  if(!retainPool)
+    return ztSuccess;
+
+  result = finishWorkPool(&retainPool);
+  if(result == ztSuccess)
+    result = retainJob.result;
+
+  snprintf(buffer, sizeof(buffer), "Retention removed %ld change files, %ld files, %lld bytes and %ld directories; "
+           "tree had %ld change files; kept from sequence: %u",
+           report->removedPairs, report->removedFiles, report->removedBytes, report->removedDirs,
+           report->pairs, report->bound);
+  logMessage(fLogPtr, buffer);
+
+  if(fVerbose)
+    fprintf(stdout, "%s: %s\n", progName, buffer);
+
+  if(report->more){
+    logMessage(fLogPtr, "Retention stopped at per run limit; more files are removed on next run.");
+
+    if(fVerbose)
+      fprintf(stdout, "%s: Retention stopped at per run limit; more files are removed on next run.\n", progName);
+  }
+
+  if(result != ztSuccess)
+    logMessage(fLogPtr, "Error retention job failed; see error output.");
+
+  return result;
+
+} /* END finishRetention() **/
+
+/* runRetention(): both passes on 'prefix' tree; 'report' is filled even on
+ * failure with what was done.
+ **************************************************************************/
+
+int runRetention(RETAIN_REPORT *report, const char *prefix, const RETAIN_POLICY *policy, SEQ_NUM bound){
+
+  ASSERTARGS(report && prefix && policy);
+
+  PARENT_INFO  *parents = NULL;
+  char         rootDir[PATH_MAX], parentDir[PATH_MAX];
+  char         rootEntry[8], parentEntry[8];   /* "NNN/" **/
+  const char   *slash;
+  long         pairs;
+  long long    bytes;
+  int          numParents = 0;
+  int          index;
+  int          done = 0;
+  int          result;
+
+  memset(report, 0, sizeof(RETAIN_REPORT));
+  report->bound = bound;
+
+  if(! RETAIN_POLICY_SET(policy) || bound == SEQ_NONE)
+    return ztSuccess;
+
+  result = scanParents(&parents, &numParents, report, prefix, policy->maxBytes != 0);
+  if(result != ztSuccess)
+    return result;
+
+  pairs = report->pairs;
+  bytes = report->bytes;
+
+  slash = SLASH_ENDING(prefix) ? "" : "/";
+
+  for(index = 0; index < numParents && !done && result == ztSuccess; index++){
+
+    if(parents[index].base >= bound)
+      break;
+
+    /* age is checked on files; count and size here **/
+    if(! policy->maxDays && ! isOverPolicy(policy, pairs, bytes))
+      break;
+
+    sequence2Entries(rootEntry, parentEntry, NULL, parents[index].base);
+
+    if(snprintf(rootDir, sizeof(rootDir), "%s%s%.3s", prefix, slash, rootEntry) >= (int) sizeof(rootDir) ||
+       snprintf(parentDir, sizeof(parentDir), "%s/%.3s", rootDir, parentEntry) >= (int) sizeof(parentDir)){
+      result = ztFnameLong;
+      break;
+    }
+
+    /* readers of tree wait for one parent at a time **/
+    result = sourceWriteBegin();
+    if(result != ztSuccess)
+      break;
+
+    if(parents[index].isPack){
+
+      result = removePack(report, policy, &parents[index], rootDir, &pairs, &bytes, &done);
+
+      if(result == ztSuccess && rmdir(rootDir) == 0)
+        report->removedDirs++;
+
+      sourceWriteEnd();
+      continue;
+    }
+
+    result = trimParent(report, policy, &parents[index], parentDir, &pairs, &bytes, &done);
+
+    /* fails when not empty; that is fine **/
+    if(result == ztSuccess && rmdir(parentDir) == 0){
+      report->removedDirs++;
+
+      if(rmdir(rootDir) == 0)
+        report->removedDirs++;
+    }
+
+    sourceWriteEnd();
+  }
+
+  free(parents);
+
+  return result;
+
+} /* END runRetention() **/
+
+static int retainWork(void *arg){
+
+  RETAIN_JOB  *job = (RETAIN_JOB *) arg;
+
+  job->result = runRetention(&job->report, job->prefix, &job->policy, job->bound);
+
+  return job->result;
+
+} /* END retainWork() **/
+
+/* scanParents(): NNN/NNN directories and NNN/NNN.pack files in 'prefix'
+ * sorted by sequence with their change file count; 'merged' and 'index'
+ * directories are skipped.
+ **************************************************************************/
+
+static int scanParents(PARENT_INFO **parents, int *numParents, RETAIN_REPORT *report,
+                       const char *prefix, int withBytes){
+
+  DIR            *rootDir, *parentDir;
+  struct dirent  *rootEntry, *parentEntry;
+  PARENT_INFO    *list = NULL, *newList;
+  char           rootName[PATH_MAX], parentName[PATH_MAX];
+  int            rootNum, parentNum;
+  int            count = 0, size = 0;
+  int            result = ztSuccess;
+
+  *parents = NULL;
+  *numParents = 0;
+
+  rootDir = opendir(prefix);
+  if(!rootDir){
+    fprintf(stderr, "%s: Error failed opendir() for <%s>: %s\n", progName, prefix, strerror(errno));
+    return ztInaccessibleDir;
+  }
+
+  while(result == ztSuccess && (rootEntry = readdir(rootDir))){
+
+    if(strcmp(rootEntry->d_name, MERGED_DIR) == 0 || strcmp(rootEntry->d_name, INDEX_DIR) == 0)
+      continue;
+
+    rootNum = triplet(rootEntry->d_name);
+    if(rootNum < 0)
+      continue;
+
+    if(snprintf(rootName, sizeof(rootName), "%s%s%s", prefix, SLASH_ENDING(prefix) ? "" : "/", rootEntry->d_name) >= (int) sizeof(rootName)){
+      result = ztFnameLong;
+      break;
+    }
+
+    parentDir = opendir(rootName);
+    if(!parentDir)
+      continue;
+
+    while(result == ztSuccess && (parentEntry = readdir(parentDir))){
+
+      /* "NNN.pack" or "NNN" **/
+      if(strlen(parentEntry->d_name) == 3 + strlen(PACK_EXT) && strcmp(parentEntry->d_name + 3, PACK_EXT) == 0){
+
+        char  parentPart[4];
+
+        memcpy(parentPart, parentEntry->d_name, 3);
+        parentPart[3] = '\0';
+        parentNum = triplet(parentPart);
+      }
+      else if(strlen(parentEntry->d_name) == 3)
+        parentNum = triplet(parentEntry->d_name);
+      else
+        parentNum = -1;
+
+      if(parentNum < 0)
+        continue;
+
+      if(snprintf(parentName, sizeof(parentName), "%s/%s", rootName, parentEntry->d_name) >= (int) sizeof(parentName)){
+        result = ztFnameLong;
+        break;
+      }
+
+      if(count == size){
+
+        size = size ? size * 2 : 256;
+
+        newList = (PARENT_INFO *) realloc(list, (size_t) size * sizeof(PARENT_INFO));
+        if(!newList){
+          result = ztMemoryAllocate;
+          break;
+        }
+
+        list = newList;
+      }
+
+      memset(&list[count], 0, sizeof(PARENT_INFO));
+      list[count].base = (SEQ_NUM) rootNum * 1000000 + (SEQ_NUM) parentNum * 1000;
+
+      if(parentEntry->d_name[3])
+        result = scanPack(&list[count], parentName);
+      else
+        result = scanParent(&list[count], parentName, withBytes);
+
+      if(result != ztSuccess)
+        break;
+
+      if(parentEntry->d_name[3] && ! list[count].isPack)
+        continue;
+
+      report->pairs += list[count].pairs;
+      report->bytes += list[count].bytes;
+      count++;
+    }
+
+    closedir(parentDir);
+  }
+
+  closedir(rootDir);
+
+  if(result != ztSuccess){
+    free(list);
+    return result;
+  }
+
+  if(count > 1)
+    qsort(list, (size_t) count, sizeof(PARENT_INFO), compareParents);
+
+  *parents = list;
+  *numParents = count;
+
+  return ztSuccess;
+
+} /* END scanParents() **/
+
+static int scanParent(PARENT_INFO *info, const char *parentDir, int withBytes){
+
+  DIR            *dirPtr;
+  struct dirent  *entry;
+  struct stat    status;
+  char           fileName[PATH_MAX];
+
+  dirPtr = opendir(parentDir);
+  if(!dirPtr)
+    return ztSuccess;
+
+  while((entry = readdir(dirPtr))){
+
+    if(entry->d_name[0] == '.')
+      continue;
+
+    if(isChangeName(entry->d_name))
+      info->pairs++;
+
+    if(!withBytes)
+      continue;
+
+    if(snprintf(fileName, sizeof(fileName), "%s/%s", parentDir, entry->d_name) >= (int) sizeof(fileName)){
+      closedir(dirPtr);
+      return ztFnameLong;
+    }
+
+    if(stat(fileName, &status) == 0 && S_ISREG(status.st_mode))
+      info->bytes += (long long) status.st_size;
+  }
+
+  closedir(dirPtr);
+
+  return ztSuccess;
+
+} /* END scanParent() **/
+
+/* scanPack(): change file count from pack trailer; size and time of pack
+ * file itself. Bad pack is left alone - not counted and not removed.
+ **************************************************************************/
+
+static int scanPack(PARENT_INFO *info, const char *packFile){
+
+  PACK_FILE    *pack;
+  struct stat  status;
+
+  if(stat(packFile, &status) != 0)
+    return ztSuccess;
+
+  pack = packOpen(packFile);
+  if(!pack)
+    return ztSuccess;
+
+  info->isPack = 1;
+  info->pairs = (long) pack->trailer.changeCount;
+  info->bytes = (long long) status.st_size;
+  info->mtime = status.st_mtime;
+
+  packClose(&pack);
+
+  return ztSuccess;
+
+} /* END scanPack() **/
+
+/* removePack(): removes whole pack file when over a policy or older than
+ * 'maxDays'; sets 'done' otherwise.
+ **************************************************************************/
+
+static int removePack(RETAIN_REPORT *report, const RETAIN_POLICY *policy, const PARENT_INFO *info,
+                      const char *rootDir, long *pairs, long long *bytes, int *done){
+
+  char    packFile[PATH_MAX];
+  time_t  cutoff;
+
+  cutoff = time(NULL) - (time_t) policy->maxDays * SECONDS_PER_DAY;
+
+  if(info->base + 999 >= report->bound ||
+     (! isOverPolicy(policy, *pairs, *bytes) && ! (policy->maxDays && info->mtime < cutoff))){
+    *done = 1;
+    return ztSuccess;
+  }
+
+  if(report->removedPairs + info->pairs > RETAIN_MAX_PAIRS){
+    report->more = 1;
+    *done = 1;
+    return ztSuccess;
+  }
+
+  if(snprintf(packFile, sizeof(packFile), "%s/%03u%s", rootDir, SEQ_PARENT(info->base), PACK_EXT) >= (int) sizeof(packFile))
+    return ztFnameLong;
+
+  if(unlink(packFile) != 0){
+    fprintf(stderr, "%s: Error failed unlink() for <%s>: %s\n", progName, packFile, strerror(errno));
+    return ztSuccess;
+  }
+
+  report->removedFiles++;
+  report->removedPairs += info->pairs;
+  report->removedBytes += info->bytes;
+
+  *pairs -= info->pairs;
+  *bytes -= info->bytes;
+
+  return ztSuccess;
+
+} /* END removePack() **/
+
+/* trimParent(): removes sequence numbers in one parent oldest first; sets
+ * 'done' when a kept sequence number is reached - all after it are kept.
+ **************************************************************************/
+
+static int trimParent(RETAIN_REPORT *report, const RETAIN_POLICY *policy, const PARENT_INFO *info,
+                      const char *parentDir, long *pairs, long long *bytes, int *done){
+
+  DIR            *dirPtr;
+  struct dirent  *entry;
+  struct stat    status;
+  char           **names = NULL, **newNames;
+  char           fileName[PATH_MAX];
+  time_t         cutoff, changeTime;
+  long long      groupBytes;
+  size_t         count = 0, size = 0, first, last, index;
+  int            fileNum, hasChange;
+  int            result = ztSuccess;
+
+  cutoff = time(NULL) - (time_t) policy->maxDays * SECONDS_PER_DAY;
+
+  dirPtr = opendir(parentDir);
+  if(!dirPtr)
+    return ztSuccess;
+
+  while((entry = readdir(dirPtr))){
+
+    if(! isSequenceName(entry->d_name))
+      continue;
+
+    if(count == size){
+
+      size = size ? size * 2 : 1024;
+
+      newNames = (char **) realloc(names, size * sizeof(char *));
+      if(!newNames){
+        result = ztMemoryAllocate;
+        break;
+      }
+
+      names = newNames;
+    }
+
+    names[count++] = STRDUP(entry->d_name);
+  }
+
+  closedir(dirPtr);
+
+  if(result == ztSuccess && count > 1)
+    qsort(names, count, sizeof(char *), compareStrings);
+
+  /* names with same "NNN." prefix are one sequence number **/
+  for(first = 0; first < count && result == ztSuccess && ! *done; first = last){
+
+    for(last = first + 1; last < count && strncmp(names[last], names[first], 4) == 0; last++)
+      ;
+
+    fileNum = (names[first][0] - '0') * 100 + (names[first][1] - '0') * 10 + (names[first][2] - '0');
+
+    if(info->base + (SEQ_NUM) fileNum >= report->bound){
+      *done = 1;
+      break;
+    }
+
+    groupBytes = 0;
+    changeTime = 0;
+    hasChange = 0;
+
+    for(index = first; index < last; index++){
+
+      if(snprintf(fileName, sizeof(fileName), "%s/%s", parentDir, names[index]) >= (int) sizeof(fileName)){
+        result = ztFnameLong;
+        break;
+      }
+
+      if(stat(fileName, &status) != 0)
+        continue;
+
+      groupBytes += (long long) status.st_size;
+
+      if(isChangeName(names[index])){
+        hasChange = 1;
+        changeTime = status.st_mtime;
+      }
+      else if(!changeTime)
+        changeTime = status.st_mtime;
+    }
+
+    if(result != ztSuccess)
+      break;
+
+    if(! isOverPolicy(policy, *pairs, *bytes) && ! (policy->maxDays && changeTime < cutoff)){
+      *done = 1;
+      break;
+    }
+
+    if(report->removedPairs == RETAIN_MAX_PAIRS){
+      report->more = 1;
+      *done = 1;
+      break;
+    }
+
+    for(index = first; index < last; index++){
+
+      /* length was checked above **/
+      if(snprintf(fileName, sizeof(fileName), "%s/%s", parentDir, names[index]) >= (int) sizeof(fileName))
+        continue;
+
+      if(unlink(fileName) == 0)
+        report->removedFiles++;
+      else if(errno != ENOENT)
+        fprintf(stderr, "%s: Error failed unlink() for <%s>: %s\n", progName, fileName, strerror(errno));
+    }
+
+    if(hasChange){
+      (*pairs)--;
+      report->removedPairs++;
+    }
+
+    *bytes -= groupBytes;
+    report->removedBytes += groupBytes;
+  }
+
+  for(index = 0; index < count; index++)
+    free(names[index]);
+
+  free(names);
+
+  return result;
+
+} /* END trimParent() **/
+
+static int isOverPolicy(const RETAIN_POLICY *policy, long pairs, long long bytes){
+
+  return (policy->maxCount && pairs > policy->maxCount) ||
+         (policy->maxBytes && bytes > policy->maxBytes);
+
+} /* END isOverPolicy() **/
+
+/* isChangeName(): "NNN.osc.gz" or "NNN.osc.zst" **/
+
+static int isChangeName(const char *name){
+
+  return (strlen(name) > 3 && (strcmp(name + 3, CHANGE_EXT) == 0 || strcmp(name + 3, ZST_EXT) == 0));
+
+} /* END isChangeName() **/
+
+/* isSequenceName(): "NNN." then anything; file of one sequence number **/
+
+static int isSequenceName(const char *name){
+
+  int  i;
+
+  for(i = 0; i < 3; i++)
+    if(name[i] < '0' || name[i] > '9')
+      return FALSE;
+
+  return (name[3] == '.');
+
+} /* END isSequenceName() **/
+
+static int compareParents(const void *first, const void *second){
+
+  const PARENT_INFO  *one = (const PARENT_INFO *) first;
+  const PARENT_INFO  *two = (const PARENT_INFO *) second;
+
+  return (one->base > two->base) - (one->base < two->base);
+
+} /* END compareParents() **/
@@ -0,0 +1,261 @@
+/*
+ * sequence.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * integer sequence numbers: parse, compare, range iteration and
+ * table driven formatting into "/NNN/NNN/NNN" path parts.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sequence.h"
+#include "ztError.h"
+#include "util.h"
+
+/* seqTriplets: "000" to "999" built at compile time; each path entry is a
+ * single 3 bytes copy instead of sprintf() with "%09d" then strncpy().
+ *
+ * adjacent string literals are concatenated by the compiler; so
+ * TRIPLET_1("4" "2") gives "420", "421", ... "429".
+ **********************************************************************/
+
+#define TRIPLET_1(p) p "0", p "1", p "2", p "3", p "4", p "5", p "6", p "7", p "8", p "9"
+
+#define TRIPLET_2(p) TRIPLET_1(p "0"), TRIPLET_1(p "1"), TRIPLET_1(p "2"), TRIPLET_1(p "3"), \
+                     TRIPLET_1(p "4"), TRIPLET_1(p "5"), TRIPLET_1(p "6"), TRIPLET_1(p "7"), \
+                     TRIPLET_1(p "8"), TRIPLET_1(p "9")
+
+static const char seqTriplets[SEQ_PER_DIR][4] = {
+
+  TRIPLET_2("0"), TRIPLET_2("1"), TRIPLET_2("2"), TRIPLET_2("3"), TRIPLET_2("4"),
+  TRIPLET_2("5"), TRIPLET_2("6"), TRIPLET_2("7"), TRIPLET_2("8"), TRIPLET_2("9")
+};
+
+/* string2Sequence(): converts sequence string to integer.
+ *
+ * string must be all digits, no leading zero, no sign and no white space,
+ * between 3 and 9 digits long; same rules as isGoodSequenceString().
+ *
+ * returns ztSuccess with 'seq' set, or ztInvalidArg with 'seq' untouched.
+ *
+ ***********************************************************************/
+
+int string2Sequence(SEQ_NUM *seq, const char *string){
+
+  ASSERTARGS(seq && string);
+
+  SEQ_NUM     value = 0;
+  const char  *ch;
+
+  if(string[0] == '0')
+
+    return ztInvalidArg;
+
+  for(ch = string; *ch; ch++){
+
+    if((*ch < '0') || (*ch > '9') || (ch - string) >= 9)
+
+      return ztInvalidArg;
+
+    value = value * 10 + (SEQ_NUM) (*ch - '0');
+  }
+
+  if(! isGoodSequence(value))
+
+    return ztInvalidArg;
+
+  *seq = value;
+
+  return ztSuccess;
+
+} /* END string2Sequence() **/
+
+int isGoodSequence(SEQ_NUM seq){
+
+  return ((seq >= SEQ_MIN) && (seq <= SEQ_MAX));
+
+} /* END isGoodSequence() **/
+
+/* sequence2String(): plain decimal - no leading zeros - into 'buffer'.
+ * 'size' should be at least SEQ_STR_SIZE.
+ *
+ ***********************************************************************/
+
+int sequence2String(char *buffer, size_t size, SEQ_NUM seq){
+
+  ASSERTARGS(buffer);
+
+  char  tmpBuf[SEQ_STR_SIZE];
+  char  *ptr;
+
+  if(! isGoodSequence(seq))
+
+    return ztInvalidArg;
+
+  ptr = tmpBuf + sizeof(tmpBuf) - 1;
+  *ptr = '\0';
+
+  do {
+    *(--ptr) = (char) ('0' + (seq % 10));
+    seq /= 10;
+  } while(seq);
+
+  if(strlen(ptr) >= size)
+
+    return ztInvalidArg;
+
+  strcpy(buffer, ptr);
+
+  return ztSuccess;
+
+} /* END sequence2String() **/
+
+/* sequence2Path(): formats 'seq' as "/NNN/NNN/NNN" into 'buffer';
+ * caller provides at least SEQ_PATH_SIZE bytes. 'seq' must be good.
+ *
+ ***********************************************************************/
+
+void sequence2Path(char *buffer, SEQ_NUM seq){
+
+  ASSERTARGS(buffer);
+
+  buffer[0] = '/';
+  memcpy(buffer + 1, seqTriplets[SEQ_ROOT(seq) % 1000], 3);
+  buffer[4] = '/';
+  memcpy(buffer + 5, seqTriplets[SEQ_PARENT(seq)], 3);
+  buffer[8] = '/';
+  memcpy(buffer + 9, seqTriplets[SEQ_FILE(seq)], 3);
+  buffer[12] = '\0';
+
+} /* END sequence2Path() **/
+
+/* sequence2Entries(): sets PATH_PART style entries; rootEntry and parentEntry
+ * are "NNN/" (5 bytes), fileEntry is "NNN" (4 bytes). Any may be NULL.
+ *
+ ***********************************************************************/
+
+void sequence2Entries(char *rootEntry, char *parentEntry, char *fileEntry, SEQ_NUM seq){
+
+  if(rootEntry){
+    memcpy(rootEntry, seqTriplets[SEQ_ROOT(seq) % 1000], 3);
+    rootEntry[3] = '/';
+    rootEntry[4] = '\0';
+  }
+
+  if(parentEntry){
+    memcpy(parentEntry, seqTriplets[SEQ_PARENT(seq)], 3);
+    parentEntry[3] = '/';
+    parentEntry[4] = '\0';
+  }
+
+  if(fileEntry){
+    memcpy(fileEntry, seqTriplets[SEQ_FILE(seq)], 3);
+    fileEntry[3] = '\0';
+  }
+
+} /* END sequence2Entries() **/
+
+/* path2Sequence(): sequence from path ending with "NNN/NNN/NNN" plus optional
+ * extension; as in "/000/004/428.osc.gz" or "/006/321/780.state.txt".
+ *
+ ***********************************************************************/
+
+int path2Sequence(SEQ_NUM *seq, const char *path){
+
+  ASSERTARGS(seq && path);
+
+  const char  *fileEntry, *ptr;
+  SEQ_NUM     value = 0;
+  int         i, j;
+
+  fileEntry = strrchr(path, '/');
+  if(! fileEntry || (fileEntry - path) < 8)
+
+    return ztInvalidArg;
+
+  fileEntry++;
+
+  /* entries start at: fileEntry - 8, fileEntry - 4 and fileEntry **/
+  for(i = 2; i >= 0; i--){
+
+    ptr = fileEntry - 4 * i;
+
+    if(i && ptr[3] != '/')
+      return ztInvalidArg;
+
+    for(j = 0; j < 3; j++){
+      if(ptr[j] < '0' || ptr[j] > '9')
+        return ztInvalidArg;
+      value = value * 10 + (SEQ_NUM) (ptr[j] - '0');
+    }
+  }
+
+  if(fileEntry[3] != '\0' && fileEntry[3] != '.')
+
+    return ztInvalidArg;
+
+  if(! isGoodSequence(value))
+
+    return ztInvalidArg;
+
+  *seq = value;
+
+  return ztSuccess;
+
+} /* END path2Sequence() **/
+
+/* leadTriplet(): value of 3 leading digits in 'name' - "NNN/..." or
+ * "NNN.osc.gz" - or -1; caller checks what follows.
+ *
+ * triplet(): "NNN" to number, -1 if not exactly 3 digits.
+ ***********************************************************************/
+
+int leadTriplet(const char *name){
+
+  ASSERTARGS(name);
+
+  if(name[0] < '0' || name[0] > '9' || name[1] < '0' || name[1] > '9' || name[2] < '0' || name[2] > '9')
+    return -1;
+
+  return (name[0] - '0') * 100 + (name[1] - '0') * 10 + (name[2] - '0');
+
+} /* END leadTriplet() **/
+
+int triplet(const char *name){
+
+  int  value = leadTriplet(name);
+
+  if(value < 0 || name[3] != '\0')
+    return -1;
+
+  return value;
+
+} /* END triplet() **/
+
+int areSameRoot(SEQ_NUM first, SEQ_NUM second){
+
+  return (SEQ_ROOT(first) == SEQ_ROOT(second));
+
+} /* END areSameRoot() **/
+
+/* areAdjacentParents(): TRUE when 'second' is in the same parent directory
+ * as 'first' or in the one right after it - under the same root.
+ *
+ ***********************************************************************/
+
+int areAdjacentParents(SEQ_NUM first, SEQ_NUM second){
+
+  if(! areSameRoot(first, second))
+
+    return FALSE;
+
+  if(SEQ_PARENT_KEY(second) < SEQ_PARENT_KEY(first))
+
+    return FALSE;
+
+  return ((SEQ_PARENT_KEY(second) - SEQ_PARENT_KEY(first)) <= 1);
+
+} /* END areAdjacentParents() **/
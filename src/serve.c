@@ -0,0 +1,1034 @@
+/*
+ * serve.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * local replication mirror; see serve.h.
+ *
+ * one connection is one job in worker pool; job serves requests on it until
+ * client closes, asks to close or is idle SERVE_IDLE_SECONDS. Listings and
+ * state.txt are made from directories on each request - tree changes while
+ * we serve it. Files are sent with sendfile(); pack members from pack file
+ * descriptor at member offset.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "serve.h"
+#include "pack.h"
+#include "workers.h"
+#include "sequence.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+
+#define SERVE_SEND_SECONDS  30
+
+/* flag bits in listing arrays; one byte per NNN entry **/
+#define HAS_DIR    0x01
+#define HAS_PACK   0x02
+#define HAS_OSC    0x01
+#define HAS_STATE  0x02
+
+typedef struct CONNECTION_ {
+
+  int   fd;
+  char  peer[INET_ADDRSTRLEN];
+  int   isHead;     /* current request; no body in any response **/
+
+} CONNECTION;
+
+typedef struct BODY_ {
+
+  char    *data;
+  size_t  length;
+  size_t  size;
+
+} BODY;
+
+static volatile sig_atomic_t  stopServer = 0;
+
+static SERVE_MOUNT      *serveMounts = NULL;
+static int              serveNumMounts = 0;
+static int              serveVerbose = 0;
+static SERVE_REPORT     *serveReport = NULL;
+static pthread_mutex_t  reportLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void stopHandler(int signum);
+static int serveConnection(void *arg);
+static int handleRequest(CONNECTION *conn, char *head, int *keepAlive);
+static int serveTree(CONNECTION *conn, const SERVE_MOUNT *mount, const char *rest, int isHead, int keepAlive);
+static int serveMember(CONNECTION *conn, const char *treeDir, SEQ_NUM seq, const char *ext, int isHead, int keepAlive);
+static int serveListing(CONNECTION *conn, const char *urlPath, const unsigned char flags[SEQ_PER_DIR],
+                        int isFiles, int isHead, int keepAlive);
+static int serveIndex(CONNECTION *conn, int isHead, int keepAlive);
+static int sendStatus(CONNECTION *conn, int status, int keepAlive);
+static int sendHead(CONNECTION *conn, int status, const char *type, long long length, time_t mtime, int keepAlive);
+static int sendAll(int fd, const char *data, size_t size);
+static int sendFileRange(int sock, int fd, off_t offset, long long length);
+static int listRoots(unsigned char flags[SEQ_PER_DIR], const char *treeDir);
+static int listParents(unsigned char flags[SEQ_PER_DIR], const char *treeDir, int root);
+static int listFiles(unsigned char flags[SEQ_PER_DIR], const char *treeDir, int root, int parent);
+static int latestPair(SEQ_NUM *seq, const char *treeDir);
+static int bodyAppend(BODY *body, const char *format, ...);
+static const char *statusText(int status);
+static void countRequest(int status, long long bytes, int isFile);
+
+/* parseServeAddress(): "PORT" or "ADDRESS:PORT"; IPv4 address in dotted
+ * form, port 1 to 65535. Address defaults to SERVE_DEFAULT_ADDRESS.
+ **************************************************************************/
+
+int parseServeAddress(char *address, size_t size, int *port, const char *arg){
+
+  ASSERTARGS(address && port && arg);
+
+  const char      *colon;
+  const char      *portStr;
+  struct in_addr  inAddr;
+  char            *endPtr;
+  long            value;
+  size_t          length;
+
+  colon = strrchr(arg, ':');
+
+  if(colon){
+    length = (size_t) (colon - arg);
+    if(length == 0 || length >= size)
+      return ztInvalidArg;
+
+    memcpy(address, arg, length);
+    address[length] = '\0';
+
+    portStr = colon + 1;
+  }
+  else{
+    snprintf(address, size, "%s", SERVE_DEFAULT_ADDRESS);
+    portStr = arg;
+  }
+
+  if(inet_pton(AF_INET, address, &inAddr) != 1)
+    return ztInvalidArg;
+
+  if(! isdigit((unsigned char) portStr[0]))
+    return ztInvalidArg;
+
+  errno = 0;
+  value = strtol(portStr, &endPtr, 10);
+  if(errno || *endPtr || value < 1 || value > 65535)
+    return ztInvalidArg;
+
+  *port = (int) value;
+
+  return ztSuccess;
+
+} /* END parseServeAddress() **/
+
+/* runServer(): serves 'mounts' on 'address':'port' until SIGINT or SIGTERM;
+ * then waits for open connections and fills 'report'.
+ **************************************************************************/
+
+int runServer(SERVE_REPORT *report, const char *address, int port,
+              SERVE_MOUNT *mounts, int numMounts, int numThreads, int verbose){
+
+  ASSERTARGS(report && address && mounts);
+
+  struct sigaction    action, oldInt, oldTerm;
+  struct sockaddr_in  sockAddr, peerAddr;
+  socklen_t           peerLength;
+  struct pollfd       pollFD;
+  struct timeval      timeout;
+  WORK_POOL           *pool;
+  CONNECTION          *conn;
+  int                 listenFD, clientFD;
+  int                 on = 1;
+  int                 result;
+
+  if(numMounts < 1 || numMounts > SERVE_MAX_MOUNTS)
+    return ztInvalidArg;
+
+  memset(report, 0, sizeof(SERVE_REPORT));
+
+  serveMounts = mounts;
+  serveNumMounts = numMounts;
+  serveVerbose = verbose;
+  serveReport = report;
+  stopServer = 0;
+
+  memset(&sockAddr, 0, sizeof(sockAddr));
+  sockAddr.sin_family = AF_INET;
+  sockAddr.sin_port = htons((uint16_t) port);
+
+  if(inet_pton(AF_INET, address, &sockAddr.sin_addr) != 1)
+    return ztInvalidArg;
+
+  listenFD = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(listenFD < 0){
+    fprintf(stderr, "%s: Error failed socket(): %s\n", progName, strerror(errno));
+    return ztFailedSysCall;
+  }
+
+  setsockopt(listenFD, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+  if(bind(listenFD, (struct sockaddr *) &sockAddr, sizeof(sockAddr)) != 0 ||
+     listen(listenFD, SOMAXCONN) != 0){
+    fprintf(stderr, "%s: Error failed bind() or listen() on <%s:%d>: %s\n",
+            progName, address, port, strerror(errno));
+    close(listenFD);
+    return ztFailedSysCall;
+  }
+
+  pool = initialWorkPool(numThreads, serveConnection, free);
+  if(!pool){
+    close(listenFD);
+    return ztMemoryAllocate;
+  }
+
+  /* no SA_RESTART; poll() returns on signal **/
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = stopHandler;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, &oldInt);
+  sigaction(SIGTERM, &action, &oldTerm);
+  signal(SIGPIPE, SIG_IGN);
+
+  fprintf(stdout, "%s: Serving on <http://%s:%d/> with %d threads:\n", progName, address, port, numThreads);
+  for(result = 0; result < numMounts; result++)
+    fprintf(stdout, "  %s -> %s\n", mounts[result].urlPath, mounts[result].treeDir);
+  fflush(stdout);
+
+  pollFD.fd = listenFD;
+  pollFD.events = POLLIN;
+
+  while(! stopServer){
+
+    if(poll(&pollFD, 1, 1000) <= 0)
+      continue;
+
+    peerLength = sizeof(peerAddr);
+    clientFD = accept(listenFD, (struct sockaddr *) &peerAddr, &peerLength);
+    if(clientFD < 0)
+      continue;
+
+    fcntl(clientFD, F_SETFD, FD_CLOEXEC);
+
+    timeout.tv_sec = SERVE_IDLE_SECONDS;
+    timeout.tv_usec = 0;
+    setsockopt(clientFD, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    timeout.tv_sec = SERVE_SEND_SECONDS;
+    setsockopt(clientFD, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    setsockopt(clientFD, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    conn = (CONNECTION *) malloc(sizeof(CONNECTION));
+    if(!conn){
+      close(clientFD);
+      continue;
+    }
+
+    conn->fd = clientFD;
+    conn->isHead = 0;
+    inet_ntop(AF_INET, &peerAddr.sin_addr, conn->peer, sizeof(conn->peer));
+
+    pthread_mutex_lock(&reportLock);
+    report->connections++;
+    pthread_mutex_unlock(&reportLock);
+
+    if(submitWork(pool, conn) != ztSuccess){
+      close(clientFD);
+      free(conn);
+    }
+  }
+
+  close(listenFD);
+
+  /* open connections end at next request or idle timeout **/
+  result = finishWorkPool(&pool);
+
+  sigaction(SIGINT, &oldInt, NULL);
+  sigaction(SIGTERM, &oldTerm, NULL);
+
+  serveMounts = NULL;
+  serveNumMounts = 0;
+  serveReport = NULL;
+
+  return result;
+
+} /* END runServer() **/
+
+static void stopHandler(int signum){
+
+  (void) signum;
+
+  stopServer = 1;
+
+} /* END stopHandler() **/
+
+/* serveConnection(): worker job; requests on one connection. Errors are
+ * the client's; job always succeeds.
+ **************************************************************************/
+
+static int serveConnection(void *arg){
+
+  CONNECTION  *conn = (CONNECTION *) arg;
+  char        head[SERVE_HEAD_SIZE + 1];
+  char        *end;
+  size_t      have = 0, used;
+  ssize_t     got;
+  int         keepAlive = 1;
+
+  while(keepAlive && ! stopServer){
+
+    head[have] = '\0';
+    end = strstr(head, "\r\n\r\n");
+
+    if(!end){
+
+      if(have == SERVE_HEAD_SIZE || strlen(head) != have){
+        sendStatus(conn, 400, 0);
+        break;
+      }
+
+      got = recv(conn->fd, head + have, SERVE_HEAD_SIZE - have, 0);
+      if(got <= 0)
+        break;
+
+      have += (size_t) got;
+      continue;
+    }
+
+    end[2] = '\0';   /* headers end with last "\r\n" **/
+    used = (size_t) (end + 4 - head);
+
+    if(handleRequest(conn, head, &keepAlive) != ztSuccess)
+      break;
+
+    /* pipelined requests **/
+    memmove(head, head + used, have - used);
+    have -= used;
+  }
+
+  close(conn->fd);
+
+  return ztSuccess;
+
+} /* END serveConnection() **/
+
+/* handleRequest(): one request in 'head'; request line and headers, null
+ * terminated. Sets 'keepAlive'. Returns error when connection is lost.
+ **************************************************************************/
+
+static int handleRequest(CONNECTION *conn, char *head, int *keepAlive){
+
+  char   *method, *target, *version, *line, *next, *value;
+  char   *query;
+  size_t length = 0;
+  int    isHead, isHttp11;
+  int    index;
+  int    result;
+
+  method = head;
+  target = strchr(method, ' ');
+  version = target ? strchr(target + 1, ' ') : NULL;
+  next = strstr(head, "\r\n");
+
+  if(!target || !version || !next || version > next){
+    *keepAlive = 0;
+    return sendStatus(conn, 400, 0);
+  }
+
+  *target++ = '\0';
+  *version++ = '\0';
+  *next = '\0';
+  next += 2;
+
+  if(strncmp(version, "HTTP/1.", 7) != 0){
+    *keepAlive = 0;
+    return sendStatus(conn, 400, 0);
+  }
+
+  isHttp11 = (strcmp(version, "HTTP/1.0") != 0);
+  *keepAlive = isHttp11;
+
+  /* headers; only connection and request body matter to us **/
+  for(line = next; *line; line = next){
+
+    next = strstr(line, "\r\n");
+    if(!next)
+      break;
+
+    *next = '\0';
+    next += 2;
+
+    value = strchr(line, ':');
+    if(!value)
+      continue;
+
+    *value++ = '\0';
+    while(*value == ' ' || *value == '\t')
+      value++;
+
+    if(strcasecmp(line, "connection") == 0){
+
+      for(index = 0; value[index]; index++)
+        value[index] = (char) tolower((unsigned char) value[index]);
+
+      if(strstr(value, "close"))
+        *keepAlive = 0;
+      else if(strstr(value, "keep-alive"))
+        *keepAlive = 1;
+    }
+    else if((strcasecmp(line, "content-length") == 0 && atol(value) != 0) ||
+            strcasecmp(line, "transfer-encoding") == 0){
+      /* we do not read request bodies **/
+      *keepAlive = 0;
+      return sendStatus(conn, 400, 0);
+    }
+  }
+
+  isHead = (strcmp(method, "HEAD") == 0);
+  conn->isHead = isHead;
+
+  if(! isHead && strcmp(method, "GET") != 0){
+    *keepAlive = 0;
+    return sendStatus(conn, 405, 0);
+  }
+
+  query = strchr(target, '?');
+  if(query)
+    *query = '\0';
+
+  if(target[0] != '/' || strstr(target, ".."))
+
+    result = sendStatus(conn, 404, *keepAlive);
+
+  else if(strcmp(target, "/") == 0)
+
+    result = serveIndex(conn, isHead, *keepAlive);
+
+  else {
+
+    for(index = 0; index < serveNumMounts; index++){
+
+      length = strlen(serveMounts[index].urlPath);
+
+      if(strncmp(target, serveMounts[index].urlPath, length) == 0 ||
+         (strlen(target) == length - 1 && strncmp(target, serveMounts[index].urlPath, length - 1) == 0))
+        break;
+    }
+
+    if(index == serveNumMounts)
+
+      result = sendStatus(conn, 404, *keepAlive);
+
+    else if(strlen(target) < length){
+
+      /* mount without ending slash; relative anchors need it **/
+      char  redirect[PATH_MAX];
+
+      snprintf(redirect, sizeof(redirect),
+               "HTTP/1.1 301 Moved Permanently\r\nServer: getdiff/%s\r\nLocation: %s\r\n"
+               "Content-Length: 0\r\nConnection: %s\r\n\r\n",
+               VERSION, serveMounts[index].urlPath, *keepAlive ? "keep-alive" : "close");
+
+      result = sendAll(conn->fd, redirect, strlen(redirect));
+      countRequest(301, 0, 0);
+    }
+    else
+
+      result = serveTree(conn, &serveMounts[index], target + length, isHead, *keepAlive);
+  }
+
+  if(serveVerbose)
+    fprintf(stdout, "%s: %s %s %s\n", progName, conn->peer, method, target);
+
+  return result;
+
+} /* END handleRequest() **/
+
+/* serveTree(): 'rest' is path below mount; one of:
+ *   ""  "state.txt"  "NNN/"  "NNN/NNN/"  "NNN/NNN/NNN.osc.gz"  "NNN/NNN/NNN.state.txt"
+ **************************************************************************/
+
+static int serveTree(CONNECTION *conn, const SERVE_MOUNT *mount, const char *rest, int isHead, int keepAlive){
+
+  unsigned char  flags[SEQ_PER_DIR];
+  char           urlPath[PATH_MAX];
+  const char     *ext;
+  SEQ_NUM        seq;
+  int            root, parent, file;
+
+  snprintf(urlPath, sizeof(urlPath), "%s%s", mount->urlPath, rest);
+
+  if(rest[0] == '\0'){
+
+    if(listRoots(flags, mount->treeDir) != ztSuccess)
+      return sendStatus(conn, 404, keepAlive);
+
+    return serveListing(conn, urlPath, flags, 0, isHead, keepAlive);
+  }
+
+  if(strcmp(rest, STATE_FILE) == 0){
+
+    if(latestPair(&seq, mount->treeDir) != ztSuccess)
+      return sendStatus(conn, 404, keepAlive);
+
+    return serveMember(conn, mount->treeDir, seq, STATE_EXT, isHead, keepAlive);
+  }
+
+  root = leadTriplet(rest);
+  if(root < 0 || rest[3] != '/')
+    return sendStatus(conn, 404, keepAlive);
+
+  if(rest[4] == '\0'){
+
+    if(listParents(flags, mount->treeDir, root) != ztSuccess)
+      return sendStatus(conn, 404, keepAlive);
+
+    return serveListing(conn, urlPath, flags, 0, isHead, keepAlive);
+  }
+
+  parent = leadTriplet(rest + 4);
+  if(parent < 0 || rest[7] != '/')
+    return sendStatus(conn, 404, keepAlive);
+
+  if(rest[8] == '\0'){
+
+    if(listFiles(flags, mount->treeDir, root, parent) != ztSuccess)
+      return sendStatus(conn, 404, keepAlive);
+
+    return serveListing(conn, urlPath, flags, 1, isHead, keepAlive);
+  }
+
+  file = leadTriplet(rest + 8);
+  ext = rest + 11;
+
+  if(file < 0 || (strcmp(ext, CHANGE_EXT) != 0 && strcmp(ext, STATE_EXT) != 0))
+    return sendStatus(conn, 404, keepAlive);
+
+  seq = (SEQ_NUM) (root * 1000000 + parent * 1000 + file);
+
+  return serveMember(conn, mount->treeDir, seq, ext, isHead, keepAlive);
+
+} /* END serveTree() **/
+
+/* serveMember(): loose file first then pack; as extractMember() **/
+
+static int serveMember(CONNECTION *conn, const char *treeDir, SEQ_NUM seq, const char *ext, int isHead, int keepAlive){
+
+  PACK_FILE         *pack;
+  const PACK_ENTRY  *entry;
+  struct stat       status;
+  char              seqPath[SEQ_PATH_SIZE];
+  char              fileName[PATH_MAX], member[PACK_NAME_SIZE];
+  const char        *type;
+  int               fd;
+  int               result;
+
+  type = (strcmp(ext, CHANGE_EXT) == 0) ? "application/gzip" : "text/plain";
+
+  sequence2Path(seqPath, seq);
+
+  snprintf(fileName, sizeof(fileName), "%s%s%s", treeDir, seqPath + (SLASH_ENDING(treeDir) ? 1 : 0), ext);
+
+  fd = open(fileName, O_RDONLY | O_CLOEXEC);
+
+  if(fd >= 0){
+
+    if(fstat(fd, &status) != 0 || ! S_ISREG(status.st_mode)){
+      close(fd);
+      return sendStatus(conn, 404, keepAlive);
+    }
+
+    result = sendHead(conn, 200, type, (long long) status.st_size, status.st_mtime, keepAlive);
+
+    if(result == ztSuccess && ! isHead)
+      result = sendFileRange(conn->fd, fd, 0, (long long) status.st_size);
+
+    close(fd);
+
+    countRequest(200, isHead ? 0 : (long long) status.st_size, ! isHead);
+
+    return result;
+  }
+
+  if(packFileName(fileName, sizeof(fileName), treeDir, seq) != ztSuccess)
+    return sendStatus(conn, 404, keepAlive);
+
+  snprintf(member, sizeof(member), "%03u%s", SEQ_FILE(seq), ext);
+
+  pack = packOpen(fileName);
+  if(!pack)
+    return sendStatus(conn, 404, keepAlive);
+
+  entry = packFind(pack, member);
+  if(!entry){
+    packClose(&pack);
+    return sendStatus(conn, 404, keepAlive);
+  }
+
+  /* CRC before first byte; a bad member is not sent **/
+  if(packCheck(pack, entry) != ztSuccess){
+    fprintf(stderr, "%s: Error CRC32 mismatch for <%s> in pack: <%s>\n", progName, member, fileName);
+    packClose(&pack);
+    return sendStatus(conn, 500, keepAlive);
+  }
+
+  result = sendHead(conn, 200, type, (long long) entry->length, (time_t) entry->mtime, keepAlive);
+
+  if(result == ztSuccess && ! isHead)
+    result = sendFileRange(conn->fd, pack->fd, (off_t) entry->offset, (long long) entry->length);
+
+  countRequest(200, isHead ? 0 : (long long) entry->length, ! isHead);
+
+  packClose(&pack);
+
+  return result;
+
+} /* END serveMember() **/
+
+/* serveListing(): HTML listing; one anchor per line as upstream servers
+ * send. Directories with any flag are listed as "NNN/"; files only as
+ * complete pairs - getdiff expects pairs, and pair being downloaded has
+ * no state file yet.
+ **************************************************************************/
+
+static int serveListing(CONNECTION *conn, const char *urlPath, const unsigned char flags[SEQ_PER_DIR],
+                        int isFiles, int isHead, int keepAlive){
+
+  BODY  body = {NULL, 0, 0};
+  int   index;
+  int   result;
+
+  result = bodyAppend(&body, "<html>\n<head><title>Index of %s</title></head>\n<body>\n"
+                      "<h1>Index of %s</h1><hr><pre><a href=\"../\">../</a>\n", urlPath, urlPath);
+
+  for(index = 0; index < SEQ_PER_DIR && result == ztSuccess; index++){
+
+    if(! flags[index])
+      continue;
+
+    if(! isFiles)
+      result = bodyAppend(&body, "<a href=\"%03d/\">%03d/</a>\n", index, index);
+
+    else if(flags[index] == (HAS_OSC | HAS_STATE)){
+
+      result = bodyAppend(&body, "<a href=\"%03d%s\">%03d%s</a>\n", index, CHANGE_EXT, index, CHANGE_EXT);
+
+      if(result == ztSuccess)
+        result = bodyAppend(&body, "<a href=\"%03d%s\">%03d%s</a>\n", index, STATE_EXT, index, STATE_EXT);
+    }
+  }
+
+  if(result == ztSuccess)
+    result = bodyAppend(&body, "</pre><hr></body>\n</html>\n");
+
+  if(result != ztSuccess){
+    free(body.data);
+    return sendStatus(conn, 500, keepAlive);
+  }
+
+  result = sendHead(conn, 200, "text/html", (long long) body.length, 0, keepAlive);
+
+  if(result == ztSuccess && ! isHead)
+    result = sendAll(conn->fd, body.data, body.length);
+
+  countRequest(200, isHead ? 0 : (long long) body.length, 0);
+
+  free(body.data);
+
+  return result;
+
+} /* END serveListing() **/
+
+/* serveIndex(): "/" lists mounts **/
+
+static int serveIndex(CONNECTION *conn, int isHead, int keepAlive){
+
+  BODY  body = {NULL, 0, 0};
+  int   index;
+  int   result;
+
+  result = bodyAppend(&body, "<html>\n<head><title>getdiff mirror</title></head>\n<body>\n<pre>\n");
+
+  for(index = 0; index < serveNumMounts && result == ztSuccess; index++)
+    result = bodyAppend(&body, "<a href=\"%s\">%s</a>\n", serveMounts[index].urlPath, serveMounts[index].urlPath);
+
+  if(result == ztSuccess)
+    result = bodyAppend(&body, "</pre>\n</body>\n</html>\n");
+
+  if(result != ztSuccess){
+    free(body.data);
+    return sendStatus(conn, 500, keepAlive);
+  }
+
+  result = sendHead(conn, 200, "text/html", (long long) body.length, 0, keepAlive);
+
+  if(result == ztSuccess && ! isHead)
+    result = sendAll(conn->fd, body.data, body.length);
+
+  countRequest(200, isHead ? 0 : (long long) body.length, 0);
+
+  free(body.data);
+
+  return result;
+
+} /* END serveIndex() **/
+
+/* sendStatus(): error response with short text body **/
+
+static int sendStatus(CONNECTION *conn, int status, int keepAlive){
+
+  char  body[128];
+  int   length;
+  int   result;
+
+  length = snprintf(body, sizeof(body), "%d %s\n", status, statusText(status));
+
+  result = sendHead(conn, status, "text/plain", (long long) length, 0, keepAlive);
+
+  if(result == ztSuccess && ! conn->isHead)
+    result = sendAll(conn->fd, body, (size_t) length);
+
+  countRequest(status, 0, 0);
+
+  return result;
+
+} /* END sendStatus() **/
+
+static int sendHead(CONNECTION *conn, int status, const char *type, long long length, time_t mtime, int keepAlive){
+
+  char       head[1024];
+  char       dateStr[64], modifiedStr[96];
+  time_t     now;
+  struct tm  tmBuffer;
+  int        size;
+
+  now = time(NULL);
+  strftime(dateStr, sizeof(dateStr), "%a, %d %b %Y %H:%M:%S GMT", gmtime_r(&now, &tmBuffer));
+
+  modifiedStr[0] = '\0';
+  if(mtime){
+    strcpy(modifiedStr, "Last-Modified: ");
+    strftime(modifiedStr + strlen(modifiedStr), sizeof(modifiedStr) - strlen(modifiedStr),
+             "%a, %d %b %Y %H:%M:%S GMT\r\n", gmtime_r(&mtime, &tmBuffer));
+  }
+
+  size = snprintf(head, sizeof(head),
+                  "HTTP/1.1 %d %s\r\n"
+                  "Server: getdiff/%s\r\n"
+                  "Date: %s\r\n"
+                  "%s"
+                  "Content-Type: %s\r\n"
+                  "Content-Length: %lld\r\n"
+                  "%s"
+                  "Connection: %s\r\n\r\n",
+                  status, statusText(status), VERSION, dateStr, modifiedStr, type, length,
+                  (status == 405) ? "Allow: GET, HEAD\r\n" : "", keepAlive ? "keep-alive" : "close");
+
+  return sendAll(conn->fd, head, (size_t) size);
+
+} /* END sendHead() **/
+
+static int sendAll(int fd, const char *data, size_t size){
+
+  ssize_t  sent;
+
+  while(size){
+
+    sent = send(fd, data, size, MSG_NOSIGNAL);
+    if(sent < 0 && errno == EINTR)
+      continue;
+
+    if(sent <= 0)
+      return ztWriteError;
+
+    data += sent;
+    size -= (size_t) sent;
+  }
+
+  return ztSuccess;
+
+} /* END sendAll() **/
+
+/* sendFileRange(): 'length' bytes of 'fd' from 'offset'; kernel copies **/
+
+static int sendFileRange(int sock, int fd, off_t offset, long long length){
+
+  ssize_t  sent;
+
+  while(length > 0){
+
+    sent = sendfile(sock, fd, &offset, (size_t) length);
+    if(sent < 0 && errno == EINTR)
+      continue;
+
+    if(sent <= 0)
+      return ztWriteError;
+
+    length -= sent;
+  }
+
+  return ztSuccess;
+
+} /* END sendFileRange() **/
+
+/* listRoots(): HAS_DIR for each "NNN" directory in 'treeDir' **/
+
+static int listRoots(unsigned char flags[SEQ_PER_DIR], const char *treeDir){
+
+  DIR            *dirPtr;
+  struct dirent  *entry;
+  int            number;
+
+  memset(flags, 0, SEQ_PER_DIR);
+
+  dirPtr = opendir(treeDir);
+  if(!dirPtr)
+    return ztFileNotFound;
+
+  while((entry = readdir(dirPtr))){
+
+    number = leadTriplet(entry->d_name);
+
+    if(number >= 0 && entry->d_name[3] == '\0')
+      flags[number] = HAS_DIR;
+  }
+
+  closedir(dirPtr);
+
+  return ztSuccess;
+
+} /* END listRoots() **/
+
+/* listParents(): HAS_DIR for "NNN" directories, HAS_PACK for "NNN.pack" **/
+
+static int listParents(unsigned char flags[SEQ_PER_DIR], const char *treeDir, int root){
+
+  DIR            *dirPtr;
+  struct dirent  *entry;
+  char           rootDir[PATH_MAX];
+  int            number;
+
+  memset(flags, 0, SEQ_PER_DIR);
+
+  snprintf(rootDir, sizeof(rootDir), "%s%s%03d", treeDir, SLASH_ENDING(treeDir) ? "" : "/", root);
+
+  dirPtr = opendir(rootDir);
+  if(!dirPtr)
+    return ztFileNotFound;
+
+  while((entry = readdir(dirPtr))){
+
+    number = leadTriplet(entry->d_name);
+    if(number < 0)
+      continue;
+
+    if(entry->d_name[3] == '\0')
+      flags[number] |= HAS_DIR;
+
+    else if(strcmp(entry->d_name + 3, PACK_EXT) == 0)
+      flags[number] |= HAS_PACK;
+  }
+
+  closedir(dirPtr);
+
+  return ztSuccess;
+
+} /* END listParents() **/
+
+/* listFiles(): HAS_OSC and HAS_STATE for pair files in parent directory,
+ * its pack file or both - crash between pack rename and loose removal.
+ **************************************************************************/
+
+static int listFiles(unsigned char flags[SEQ_PER_DIR], const char *treeDir, int root, int parent){
+
+  DIR            *dirPtr;
+  struct dirent  *entry;
+  PACK_FILE      *pack;
+  char           parentDir[PATH_MAX];
+  const char     *name;
+  uint32_t       index;
+  int            number;
+  int            found = 0;
+
+  memset(flags, 0, SEQ_PER_DIR);
+
+  snprintf(parentDir, sizeof(parentDir), "%s%s%03d/%03d", treeDir, SLASH_ENDING(treeDir) ? "" : "/", root, parent);
+
+  dirPtr = opendir(parentDir);
+  if(dirPtr){
+
+    found = 1;
+
+    while((entry = readdir(dirPtr))){
+
+      number = leadTriplet(entry->d_name);
+      if(number < 0)
+        continue;
+
+      if(strcmp(entry->d_name + 3, CHANGE_EXT) == 0)
+        flags[number] |= HAS_OSC;
+
+      else if(strcmp(entry->d_name + 3, STATE_EXT) == 0)
+        flags[number] |= HAS_STATE;
+    }
+
+    closedir(dirPtr);
+  }
+
+  strcat(parentDir, PACK_EXT);
+
+  pack = packOpen(parentDir);
+  if(pack){
+
+    found = 1;
+
+    for(index = 0; index < pack->trailer.count; index++){
+
+      name = pack->entries[index].name;
+
+      number = leadTriplet(name);
+      if(number < 0)
+        continue;
+
+      if(strcmp(name + 3, CHANGE_EXT) == 0)
+        flags[number] |= HAS_OSC;
+
+      else if(strcmp(name + 3, STATE_EXT) == 0)
+        flags[number] |= HAS_STATE;
+    }
+
+    packClose(&pack);
+  }
+
+  return found ? ztSuccess : ztFileNotFound;
+
+} /* END listFiles() **/
+
+/* latestPair(): newest sequence number with both change and state files.
+ * state file is written after its change file, so a pair being downloaded
+ * is not picked up.
+ **************************************************************************/
+
+static int latestPair(SEQ_NUM *seq, const char *treeDir){
+
+  unsigned char  roots[SEQ_PER_DIR], parents[SEQ_PER_DIR], files[SEQ_PER_DIR];
+  int            root, parent, file;
+
+  if(listRoots(roots, treeDir) != ztSuccess)
+    return ztFileNotFound;
+
+  for(root = SEQ_PER_DIR - 1; root >= 0; root--){
+
+    if(! roots[root] || listParents(parents, treeDir, root) != ztSuccess)
+      continue;
+
+    for(parent = SEQ_PER_DIR - 1; parent >= 0; parent--){
+
+      if(! parents[parent] || listFiles(files, treeDir, root, parent) != ztSuccess)
+        continue;
+
+      for(file = SEQ_PER_DIR - 1; file >= 0; file--){
+
+        if(files[file] == (HAS_OSC | HAS_STATE)){
+          *seq = (SEQ_NUM) (root * 1000000 + parent * 1000 + file);
+          return ztSuccess;
+        }
+      }
+    }
+  }
+
+  return ztFileNotFound;
+
+} /* END latestPair() **/
+
+static int bodyAppend(BODY *body, const char *format, ...){
+
+  va_list  args;
+  char     *newData;
+  size_t   newSize;
+  int      length;
+
+  va_start(args, format);
+  length = vsnprintf(NULL, 0, format, args);
+  va_end(args);
+
+  if(length < 0)
+    return ztFailedLibCall;
+
+  if(body->length + (size_t) length + 1 > body->size){
+
+    newSize = body->size ? body->size * 2 : 4096;
+    while(newSize < body->length + (size_t) length + 1)
+      newSize *= 2;
+
+    newData = (char *) realloc(body->data, newSize);
+    if(!newData)
+      return ztMemoryAllocate;
+
+    body->data = newData;
+    body->size = newSize;
+  }
+
+  va_start(args, format);
+  vsnprintf(body->data + body->length, body->size - body->length, format, args);
+  va_end(args);
+
+  body->length += (size_t) length;
+
+  return ztSuccess;
+
+} /* END bodyAppend() **/
+
+static const char *statusText(int status){
+
+  switch(status){
+
+  case 200: return "OK";
+  case 301: return "Moved Permanently";
+  case 400: return "Bad Request";
+  case 404: return "Not Found";
+  case 405: return "Method Not Allowed";
+  default:  return "Internal Server Error";
+  }
+
+} /* END statusText() **/
+
+static void countRequest(int status, long long bytes, int isFile){
+
+  pthread_mutex_lock(&reportLock);
+
+  serveReport->requests++;
+
+  if(isFile)
+    serveReport->files++;
+
+  if(status == 404)
+    serveReport->notFound++;
+
+  serveReport->bytes += bytes;
+
+  pthread_mutex_unlock(&reportLock);
+
+} /* END countRequest() **/
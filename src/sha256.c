@@ -0,0 +1,217 @@
+/*
+ * sha256.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * SHA-256 for content store; see sha256.h. Plain C from FIPS 180-4, one
+ * 64 bytes block per round; change files are small, hashing is a fraction
+ * of the time it took to download them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "sha256.h"
+#include "ztError.h"
+#include "util.h"
+
+#define SHA256_BUFFER  (128 * 1024)
+
+#define ROTR(x, n)  (((x) >> (n)) | ((x) << (32 - (n))))
+
+static const uint32_t K[64] = {
+
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static void sha256Block(uint32_t state[8], const unsigned char *block);
+
+void sha256Init(SHA256_CTX *ctx){
+
+  ASSERTARGS(ctx);
+
+  ctx->state[0] = 0x6a09e667;
+  ctx->state[1] = 0xbb67ae85;
+  ctx->state[2] = 0x3c6ef372;
+  ctx->state[3] = 0xa54ff53a;
+  ctx->state[4] = 0x510e527f;
+  ctx->state[5] = 0x9b05688c;
+  ctx->state[6] = 0x1f83d9ab;
+  ctx->state[7] = 0x5be0cd19;
+
+  ctx->length = 0;
+  ctx->used = 0;
+
+} /* END sha256Init() **/
+
+void sha256Update(SHA256_CTX *ctx, const unsigned char *data, size_t len){
+
+  ASSERTARGS(ctx);
+
+  size_t  take;
+
+  ctx->length += len;
+
+  if(ctx->used){
+
+    take = 64 - ctx->used;
+    if(take > len)
+      take = len;
+
+    memcpy(ctx->block + ctx->used, data, take);
+    ctx->used += take;
+    data += take;
+    len -= take;
+
+    if(ctx->used < 64)
+      return;
+
+    sha256Block(ctx->state, ctx->block);
+    ctx->used = 0;
+  }
+
+  while(len >= 64){
+    sha256Block(ctx->state, data);
+    data += 64;
+    len -= 64;
+  }
+
+  if(len){
+    memcpy(ctx->block, data, len);
+    ctx->used = len;
+  }
+
+} /* END sha256Update() **/
+
+void sha256Final(SHA256_CTX *ctx, unsigned char digest[SHA256_SIZE]){
+
+  ASSERTARGS(ctx && digest);
+
+  uint64_t  bits = ctx->length * 8;
+  int       i;
+
+  ctx->block[ctx->used++] = 0x80;
+
+  if(ctx->used > 56){
+    memset(ctx->block + ctx->used, 0, 64 - ctx->used);
+    sha256Block(ctx->state, ctx->block);
+    ctx->used = 0;
+  }
+
+  memset(ctx->block + ctx->used, 0, 56 - ctx->used);
+
+  for(i = 0; i < 8; i++)
+    ctx->block[56 + i] = (unsigned char) (bits >> (56 - 8 * i));
+
+  sha256Block(ctx->state, ctx->block);
+
+  for(i = 0; i < 8; i++){
+    digest[4 * i]     = (unsigned char) (ctx->state[i] >> 24);
+    digest[4 * i + 1] = (unsigned char) (ctx->state[i] >> 16);
+    digest[4 * i + 2] = (unsigned char) (ctx->state[i] >> 8);
+    digest[4 * i + 3] = (unsigned char) ctx->state[i];
+  }
+
+} /* END sha256Final() **/
+
+void sha256Hex(char hex[SHA256_HEX_SIZE], const unsigned char digest[SHA256_SIZE]){
+
+  static const char  digits[] = "0123456789abcdef";
+  int                i;
+
+  for(i = 0; i < SHA256_SIZE; i++){
+    hex[2 * i]     = digits[digest[i] >> 4];
+    hex[2 * i + 1] = digits[digest[i] & 0x0f];
+  }
+
+  hex[2 * SHA256_SIZE] = '\0';
+
+} /* END sha256Hex() **/
+
+/* sha256File(): hex digest and size of 'fileName' **/
+
+int sha256File(char hex[SHA256_HEX_SIZE], long long *size, const char *fileName){
+
+  ASSERTARGS(hex && fileName);
+
+  SHA256_CTX     ctx;
+  unsigned char  digest[SHA256_SIZE];
+  unsigned char  *buffer;
+  long long      total = 0;
+  ssize_t        got;
+  int            fd;
+
+  fd = open(fileName, O_RDONLY | O_CLOEXEC);
+  if(fd < 0)
+    return (errno == ENOENT) ? ztFileNotFound : ztOpenFileError;
+
+  buffer = (unsigned char *) malloc(SHA256_BUFFER);
+  if(!buffer){
+    close(fd);
+    return ztMemoryAllocate;
+  }
+
+  sha256Init(&ctx);
+
+  while((got = read(fd, buffer, SHA256_BUFFER)) > 0){
+    sha256Update(&ctx, buffer, (size_t) got);
+    total += got;
+  }
+
+  free(buffer);
+  close(fd);
+
+  if(got < 0)
+    return ztFileError;
+
+  sha256Final(&ctx, digest);
+  sha256Hex(hex, digest);
+
+  if(size)
+    *size = total;
+
+  return ztSuccess;
+
+} /* END sha256File() **/
+
+static void sha256Block(uint32_t state[8], const unsigned char *block){
+
+  uint32_t  w[64];
+  uint32_t  a, b, c, d, e, f, g, h, t1, t2;
+  int       i;
+
+  for(i = 0; i < 16; i++)
+    w[i] = ((uint32_t) block[4 * i] << 24) | ((uint32_t) block[4 * i + 1] << 16) |
+           ((uint32_t) block[4 * i + 2] << 8) | (uint32_t) block[4 * i + 3];
+
+  for(i = 16; i < 64; i++)
+    w[i] = (ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10)) + w[i - 7] +
+           (ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3)) + w[i - 16];
+
+  a = state[0]; b = state[1]; c = state[2]; d = state[3];
+  e = state[4]; f = state[5]; g = state[6]; h = state[7];
+
+  for(i = 0; i < 64; i++){
+
+    t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+    t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+
+    h = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+
+  state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+  state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+
+} /* END sha256Block() **/
@@ -0,0 +1,272 @@
+/*
+ * srclock.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * per-source locks; see srclock.h.
+ *
+ * fcntl() locks belong to the process; threads share them and any close()
+ * on the file drops them all. Write lock on tree state is counted, main
+ * thread and retention thread may hold it together; lock is taken by the
+ * first and let go by the last one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include "srclock.h"
+#include "fileio.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+
+static int  workFD = -1;
+static int  workExclusive = 0;
+
+static int  sourceFD = -1;
+static int  writers = 0;
+
+static pthread_mutex_t  writeMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int setLock(int fd, short type, off_t start, off_t length, int wait);
+
+/* lockWorkDir(): work directory lock; exclusive when no other download
+ * is running, else shared. Fails while an old version holds it.
+ *
+ ***************************************************************************/
+
+int lockWorkDir(const char *name){
+
+  ASSERTARGS(name);
+
+  errno = 0;
+
+  workFD = open(name, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+  if(workFD == -1){
+    fprintf(stderr, "%s: Error failed open() for lock file: <%s>.\n"
+            "System error message: <%s>\n", progName, name, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  workExclusive = (setLock(workFD, F_WRLCK, 0, 0, 0) == ztSuccess);
+
+  if(! workExclusive && setLock(workFD, F_RDLCK, 0, 0, 0) != ztSuccess){
+
+    fprintf(stderr, "%s: Error work directory is locked by another instance: <%s>.\n", progName, name);
+
+    close(workFD);
+    workFD = -1;
+
+    return ztFailedSysCall;
+  }
+
+  return ztSuccess;
+
+} /* END lockWorkDir() **/
+
+int isWorkDirExclusive(void){
+
+  return workExclusive;
+
+} /* END isWorkDirExclusive() **/
+
+/* shareWorkDir(): exclusive lock becomes shared; other sources may start **/
+
+int shareWorkDir(void){
+
+  int  result;
+
+  if(workFD == -1 || ! workExclusive)
+
+    return ztSuccess;
+
+  result = setLock(workFD, F_RDLCK, 0, 0, 0);
+  if(result == ztSuccess)
+    workExclusive = 0;
+
+  return result;
+
+} /* END shareWorkDir() **/
+
+/* lockSource(): one download for source; lock file gets our name and PID.
+ * When taken, holder in file is reported - as isOrphanedLock() tells it.
+ *
+ ***************************************************************************/
+
+int lockSource(const char *name){
+
+  char   writeBuffer[64] = {0};
+  int    fd;
+
+  ASSERTARGS(name);
+
+  errno = 0;
+
+  fd = open(name, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+  if(fd == -1){
+    fprintf(stderr, "%s: Error failed open() for source lock file: <%s>.\n"
+            "System error message: <%s>\n", progName, name, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  if(setLock(fd, F_WRLCK, SOURCE_RUN_BYTE, 1, 0) != ztSuccess){
+
+    close(fd);
+
+    /* holder is alive unless lock is stale on a network file system **/
+    if(isOrphanedLock((char *) name))
+      fprintf(stderr, "%s: Error source lock is held but its owner is gone: <%s>.\n"
+              "Is work directory on a network file system?\n", progName, name);
+    else
+      fprintf(stderr, "%s: Error another instance is downloading this source; lock: <%s>.\n",
+              progName, name);
+
+    return ztFailedSysCall;
+  }
+
+  if(ftruncate(fd, 0) == 0){
+    sprintf(writeBuffer, "%s %d", progName, (int) getpid());
+    if(write(fd, writeBuffer, strlen(writeBuffer)) < 0)
+      ;
+  }
+
+  sourceFD = fd;
+  writers = 0;
+
+  return ztSuccess;
+
+} /* END lockSource() **/
+
+/* unlockSource(): close() lets go source locks; files stay for next run **/
+
+void unlockSource(void){
+
+  if(sourceFD != -1){
+    close(sourceFD);
+    sourceFD = -1;
+  }
+
+  writers = 0;
+
+  return;
+
+} /* END unlockSource() **/
+
+/* unlockWorkDir(): lets go work directory lock from lockWorkDir() **/
+
+void unlockWorkDir(void){
+
+  if(workFD != -1){
+    close(workFD);
+    workFD = -1;
+  }
+
+  workExclusive = 0;
+
+  return;
+
+} /* END unlockWorkDir() **/
+
+/* sourceWriteBegin(): exclusive lock on tree state; waits for readers.
+ * No-op without lockSource(). Each call is paired with sourceWriteEnd().
+ *
+ ***************************************************************************/
+
+int sourceWriteBegin(void){
+
+  int  result = ztSuccess;
+
+  pthread_mutex_lock(&writeMutex);
+
+  if(sourceFD != -1 && writers == 0)
+    result = setLock(sourceFD, F_WRLCK, SOURCE_STATE_BYTE, 1, 1);
+
+  if(result == ztSuccess)
+    writers++;
+
+  pthread_mutex_unlock(&writeMutex);
+
+  return result;
+
+} /* END sourceWriteBegin() **/
+
+void sourceWriteEnd(void){
+
+  pthread_mutex_lock(&writeMutex);
+
+  if(writers > 0){
+
+    writers--;
+
+    if(sourceFD != -1 && writers == 0)
+      setLock(sourceFD, F_UNLCK, SOURCE_STATE_BYTE, 1, 0);
+  }
+
+  pthread_mutex_unlock(&writeMutex);
+
+  return;
+
+} /* END sourceWriteEnd() **/
+
+/* lockSourceRead(): shared lock on tree state for read-only commands.
+ * No lock file - source was never downloaded - is no error; 'pFD' is -1.
+ *
+ ***************************************************************************/
+
+int lockSourceRead(int *pFD, const char *name){
+
+  int  result;
+
+  ASSERTARGS(pFD && name);
+
+  errno = 0;
+
+  *pFD = open(name, O_RDONLY | O_CLOEXEC);
+  if(*pFD == -1)
+
+    return (errno == ENOENT) ? ztSuccess : ztOpenFileError;
+
+  result = setLock(*pFD, F_RDLCK, SOURCE_STATE_BYTE, 1, 1);
+  if(result != ztSuccess){
+    close(*pFD);
+    *pFD = -1;
+  }
+
+  return result;
+
+} /* END lockSourceRead() **/
+
+void unlockSourceRead(int fd){
+
+  if(fd != -1)
+    close(fd);
+
+  return;
+
+} /* END unlockSourceRead() **/
+
+static int setLock(int fd, short type, off_t start, off_t length, int wait){
+
+  struct flock  myLock;
+
+  memset(&myLock, 0, sizeof(myLock));
+
+  myLock.l_type = type;
+  myLock.l_whence = SEEK_SET;
+  myLock.l_start = start;
+  myLock.l_len = length;   /* zero for whole file **/
+
+  do {
+    errno = 0;
+    if(fcntl(fd, wait ? F_SETLKW : F_SETLK, &myLock) == 0)
+      return ztSuccess;
+  } while(wait && errno == EINTR);
+
+  return ztFailedSysCall;
+
+} /* END setLock() **/
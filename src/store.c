@@ -0,0 +1,585 @@
+/*
+ * store.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * content addressed store; see store.h.
+ *
+ * objects and manifests are written to a ".tmp" name in their shard
+ * directory and renamed; two getdiff processes adding the same object both
+ * rename same bytes to same name. Runs on download thread - hashing one
+ * file is small next to fetching it.
+ *
+ * Sweep at end of run goes over every shard; an object being fetched by
+ * another process may go between its check and link() - link fails and
+ * that process downloads the file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
+#include "store.h"
+#include "sha256.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+#include "debug.h"
+
+#define STORE_BUFFER  (128 * 1024)
+
+static char          storeRoot[PATH_MAX];
+static char          sourceKey[PATH_MAX];
+static int           storing = 0;
+static STORE_REPORT  storeReport;
+
+static int makeKey(char *key, size_t size, const char *pathSuffix);
+static void keyHash(char keyHex[SHA256_HEX_SIZE], const char *key);
+static int shardPath(char *buffer, size_t size, const char *dir, const char *hex, int create);
+static int readManifest(char hex[SHA256_HEX_SIZE], long long *size, const char *manifest, const char *key);
+static int writeManifest(const char *manifest, const char *hex, long long size, const char *key);
+static int placeFile(const char *from, const char *to);
+static int cloneFile(const char *from, const char *to);
+static int tempName(char *buffer, size_t size, const char *fileName);
+static int isTempName(const char *name);
+static void sweepStore(void);
+static void sweepShard(const char *dir, const char *shard);
+
+/* startStore(): 'storeDir' is made when missing; 'sourceURL' is lower case
+ * source with scheme.
+ **************************************************************************/
+
+int startStore(const char *storeDir, const char *sourceURL){
+
+  ASSERTARGS(storeDir && sourceURL);
+
+  char        dirName[PATH_MAX];
+  const char  *start;
+  size_t      length;
+  int         result;
+
+  memset(&storeReport, 0, sizeof(STORE_REPORT));
+
+  if(snprintf(storeRoot, sizeof(storeRoot), "%s", storeDir) >= (int) sizeof(storeRoot))
+    return ztFnameLong;
+
+  length = strlen(storeRoot);
+  if(length > 1 && SLASH_ENDING(storeRoot))
+    storeRoot[length - 1] = '\0';
+
+  start = strstr(sourceURL, "://");
+  start = start ? start + 3 : sourceURL;
+
+  if(snprintf(sourceKey, sizeof(sourceKey), "%s", start) >= (int) sizeof(sourceKey))
+    return ztFnameLong;
+
+  length = strlen(sourceKey);
+  if(length > 1 && SLASH_ENDING(sourceKey))
+    sourceKey[length - 1] = '\0';
+
+  result = myMkDir(storeRoot);
+
+  if(result == ztSuccess){
+    snprintf(dirName, sizeof(dirName), "%s/%s", storeRoot, STORE_OBJECTS);
+    result = myMkDir(dirName);
+  }
+
+  if(result == ztSuccess){
+    snprintf(dirName, sizeof(dirName), "%s/%s", storeRoot, STORE_KEYS);
+    result = myMkDir(dirName);
+  }
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed myMkDir() for store: <%s>\n", progName, storeRoot);
+    return result;
+  }
+
+  storing = 1;
+
+  return ztSuccess;
+
+} /* END startStore() **/
+
+int isStoring(void){
+
+  return storing;
+
+} /* END isStoring() **/
+
+/* storeFetch(): places file for 'pathSuffix' at 'localFile' from store;
+ * ztFileNotFound when store does not have it - caller downloads.
+ **************************************************************************/
+
+int storeFetch(const char *pathSuffix, const char *localFile){
+
+  ASSERTARGS(pathSuffix && localFile);
+
+  char           key[PATH_MAX], keyHex[SHA256_HEX_SIZE];
+  char           manifest[PATH_MAX], object[PATH_MAX];
+  char           hex[SHA256_HEX_SIZE], objectHex[SHA256_HEX_SIZE];
+  long long      size, objectSize;
+  int            result;
+
+  if(!storing)
+    return ztFileNotFound;
+
+  result = makeKey(key, sizeof(key), pathSuffix);
+  if(result != ztSuccess)
+    return result;
+
+  keyHash(keyHex, key);
+
+  if(shardPath(manifest, sizeof(manifest), STORE_KEYS, keyHex, FALSE) != ztSuccess ||
+     readManifest(hex, &size, manifest, key) != ztSuccess ||
+     shardPath(object, sizeof(object), STORE_OBJECTS, hex, FALSE) != ztSuccess)
+
+    return ztFileNotFound;
+
+  /* object may be cleaned; if not, it must still be what manifest says **/
+  result = sha256File(objectHex, &objectSize, object);
+  if(result == ztFileNotFound)
+    return result;
+
+  if(result != ztSuccess || objectSize != size || strcmp(objectHex, hex) != 0){
+
+    fprintf(stderr, "%s: Warning store object does not match its name; downloading: <%s>\n", progName, object);
+    return ztFileNotFound;
+  }
+
+  result = placeFile(object, localFile);
+  if(result != ztSuccess)
+    return ztFileNotFound;
+
+  storeReport.skipped++;
+  storeReport.savedBytes += size;
+
+  return ztSuccess;
+
+} /* END storeFetch() **/
+
+/* storeAdd(): hashes downloaded 'localFile'; links it to existing object
+ * or adds it as new object, then writes manifest for its key.
+ **************************************************************************/
+
+int storeAdd(const char *pathSuffix, const char *localFile){
+
+  ASSERTARGS(pathSuffix && localFile);
+
+  struct stat    status;
+  char           key[PATH_MAX], keyHex[SHA256_HEX_SIZE];
+  char           manifest[PATH_MAX], object[PATH_MAX], tmpName[PATH_MAX];
+  char           hex[SHA256_HEX_SIZE];
+  long long      size;
+  int            result;
+
+  if(!storing)
+    return ztSuccess;
+
+  result = makeKey(key, sizeof(key), pathSuffix);
+  if(result != ztSuccess)
+    return result;
+
+  result = sha256File(hex, &size, localFile);
+  if(result != ztSuccess)
+    return result;
+
+  result = shardPath(object, sizeof(object), STORE_OBJECTS, hex, TRUE);
+  if(result != ztSuccess)
+    return result;
+
+  /* same bytes are in store; keep one copy. Sweep may remove object
+   * after stat(); then it is added again **/
+  if(stat(object, &status) == 0 && (long long) status.st_size == size &&
+     placeFile(object, localFile) == ztSuccess){
+
+    storeReport.linked++;
+    storeReport.savedBytes += size;
+  }
+  else {
+
+    result = tempName(tmpName, sizeof(tmpName), object);
+    if(result != ztSuccess)
+      return result;
+
+    unlink(tmpName);
+
+    if(link(localFile, tmpName) != 0 && cloneFile(localFile, tmpName) != ztSuccess){
+      fprintf(stderr, "%s: Error failed adding file to store: <%s>\n", progName, localFile);
+      unlink(tmpName);
+      return ztWriteError;
+    }
+
+    if(rename(tmpName, object) != 0){
+      fprintf(stderr, "%s: Error failed rename() to <%s>: %s\n", progName, object, strerror(errno));
+      unlink(tmpName);
+      return ztFailedSysCall;
+    }
+
+    storeReport.added++;
+  }
+
+  keyHash(keyHex, key);
+
+  result = shardPath(manifest, sizeof(manifest), STORE_KEYS, keyHex, TRUE);
+  if(result != ztSuccess)
+    return result;
+
+  return writeManifest(manifest, hex, size, key);
+
+} /* END storeAdd() **/
+
+/* finishStore(): sweeps store then writes store report to log **/
+
+int finishStore(void){
+
+  char  buffer[PATH_MAX + 256];
+
+  if(!storing)
+    return ztSuccess;
+
+  sweepStore();
+
+  snprintf(buffer, sizeof(buffer), "Store added %ld files, linked %ld downloads and skipped %ld downloads; "
+           "%lld bytes not stored again; swept %ld objects (%lld bytes) and %ld manifests: %s",
+           storeReport.added, storeReport.linked, storeReport.skipped, storeReport.savedBytes,
+           storeReport.removed, storeReport.freedBytes, storeReport.dropped, storeRoot);
+  logMessage(fLogPtr, buffer);
+
+  if(fVerbose)
+    fprintf(stdout, "%s: %s\n", progName, buffer);
+
+  storing = 0;
+
+  return ztSuccess;
+
+} /* END finishStore() **/
+
+/* makeKey(): source without scheme plus 'pathSuffix'; Geofabrik INTERNAL
+ * state.txt files get PUBLIC server name.
+ **************************************************************************/
+
+static int makeKey(char *key, size_t size, const char *pathSuffix){
+
+  size_t      hostLength = strlen(INTERNAL_SERVER);
+  size_t      length = strlen(pathSuffix);
+  const char  *slash = (pathSuffix[0] == '/') ? "" : "/";
+  int         written;
+
+  if(strncmp(sourceKey, INTERNAL_SERVER, hostLength) == 0 && sourceKey[hostLength] == '/' &&
+     length > strlen(STATE_EXT) && strcmp(pathSuffix + length - strlen(STATE_EXT), STATE_EXT) == 0)
+
+    written = snprintf(key, size, "%s%s%s%s", PUBLIC_SERVER, sourceKey + hostLength, slash, pathSuffix);
+
+  else
+
+    written = snprintf(key, size, "%s%s%s", sourceKey, slash, pathSuffix);
+
+  return (written >= (int) size) ? ztFnameLong : ztSuccess;
+
+} /* END makeKey() **/
+
+static void keyHash(char keyHex[SHA256_HEX_SIZE], const char *key){
+
+  SHA256_CTX     ctx;
+  unsigned char  digest[SHA256_SIZE];
+
+  sha256Init(&ctx);
+  sha256Update(&ctx, (const unsigned char *) key, strlen(key));
+  sha256Final(&ctx, digest);
+  sha256Hex(keyHex, digest);
+
+} /* END keyHash() **/
+
+/* shardPath(): {store}/{dir}/ab/cdef...; shard directory is made when
+ * 'create' is set.
+ **************************************************************************/
+
+static int shardPath(char *buffer, size_t size, const char *dir, const char *hex, int create){
+
+  if(snprintf(buffer, size, "%s/%s/%.2s", storeRoot, dir, hex) >= (int) size)
+    return ztFnameLong;
+
+  if(create && mkdir(buffer, 0755) != 0 && errno != EEXIST){
+    fprintf(stderr, "%s: Error failed mkdir() for <%s>: %s\n", progName, buffer, strerror(errno));
+    return ztFailedSysCall;
+  }
+
+  if(snprintf(buffer, size, "%s/%s/%.2s/%s", storeRoot, dir, hex, hex + 2) >= (int) size)
+    return ztFnameLong;
+
+  return ztSuccess;
+
+} /* END shardPath() **/
+
+static int readManifest(char hex[SHA256_HEX_SIZE], long long *size, const char *manifest, const char *key){
+
+  FILE  *filePtr;
+  char  line[PATH_MAX + 128];
+  char  *keyPart;
+  int   good = FALSE;
+
+  filePtr = fopen(manifest, "r");
+  if(!filePtr)
+    return ztFileNotFound;
+
+  if(fgets(line, sizeof(line), filePtr)){
+
+    line[strcspn(line, "\n")] = '\0';
+
+    keyPart = strchr(line, ' ');
+    keyPart = keyPart ? strchr(keyPart + 1, ' ') : NULL;
+
+    if(keyPart && strcmp(keyPart + 1, key) == 0 &&
+       sscanf(line, "%64[0-9a-f] %lld", hex, size) == 2 && strlen(hex) == SHA256_HEX_SIZE - 1)
+
+      good = TRUE;
+  }
+
+  fclose(filePtr);
+
+  return good ? ztSuccess : ztFileNotFound;
+
+} /* END readManifest() **/
+
+static int writeManifest(const char *manifest, const char *hex, long long size, const char *key){
+
+  FILE  *filePtr;
+  char  tmpName[PATH_MAX];
+  int   result;
+
+  result = tempName(tmpName, sizeof(tmpName), manifest);
+  if(result != ztSuccess)
+    return result;
+
+  filePtr = fopen(tmpName, "w");
+  if(!filePtr){
+    fprintf(stderr, "%s: Error failed fopen() for <%s>: %s\n", progName, tmpName, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  fprintf(filePtr, "%s %lld %s\n", hex, size, key);
+
+  if(fclose(filePtr) != 0){
+    unlink(tmpName);
+    return ztWriteError;
+  }
+
+  if(rename(tmpName, manifest) != 0){
+    fprintf(stderr, "%s: Error failed rename() to <%s>: %s\n", progName, manifest, strerror(errno));
+    unlink(tmpName);
+    return ztFailedSysCall;
+  }
+
+  return ztSuccess;
+
+} /* END writeManifest() **/
+
+/* placeFile(): 'to' becomes hard link to 'from' - or reflink or copy -
+ * through a temporary name; old 'to' is replaced, not written.
+ **************************************************************************/
+
+static int placeFile(const char *from, const char *to){
+
+  char  tmpName[PATH_MAX];
+  int   result;
+
+  result = tempName(tmpName, sizeof(tmpName), to);
+  if(result != ztSuccess)
+    return result;
+
+  unlink(tmpName);
+
+  if(link(from, tmpName) != 0 && cloneFile(from, tmpName) != ztSuccess){
+    unlink(tmpName);
+    return ztWriteError;
+  }
+
+  if(rename(tmpName, to) != 0){
+    fprintf(stderr, "%s: Error failed rename() to <%s>: %s\n", progName, to, strerror(errno));
+    unlink(tmpName);
+    return ztFailedSysCall;
+  }
+
+  return ztSuccess;
+
+} /* END placeFile() **/
+
+/* cloneFile(): reflink where file system has it, else copy **/
+
+static int cloneFile(const char *from, const char *to){
+
+  unsigned char  *buffer;
+  ssize_t        got, written;
+  int            inFD, outFD;
+  int            result = ztSuccess;
+
+  inFD = open(from, O_RDONLY | O_CLOEXEC);
+  if(inFD < 0)
+    return ztOpenFileError;
+
+  outFD = open(to, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if(outFD < 0){
+    close(inFD);
+    return ztOpenFileError;
+  }
+
+#ifdef FICLONE
+  if(ioctl(outFD, FICLONE, inFD) == 0){
+    close(inFD);
+    return (close(outFD) == 0) ? ztSuccess : ztWriteError;
+  }
+#endif
+
+  buffer = (unsigned char *) malloc(STORE_BUFFER);
+  if(!buffer){
+    close(inFD);
+    close(outFD);
+    return ztMemoryAllocate;
+  }
+
+  while(result == ztSuccess && (got = read(inFD, buffer, STORE_BUFFER)) != 0){
+
+    if(got < 0){
+      result = ztFileError;
+      break;
+    }
+
+    written = write(outFD, buffer, (size_t) got);
+    if(written != got)
+      result = ztWriteError;
+  }
+
+  free(buffer);
+  close(inFD);
+
+  if(close(outFD) != 0 && result == ztSuccess)
+    result = ztWriteError;
+
+  return result;
+
+} /* END cloneFile() **/
+
+static int tempName(char *buffer, size_t size, const char *fileName){
+
+  if(snprintf(buffer, size, "%s.%ld.tmp", fileName, (long) getpid()) >= (int) size)
+    return ztFnameLong;
+
+  return ztSuccess;
+
+} /* END tempName() **/
+
+static int isTempName(const char *name){
+
+  size_t  length = strlen(name);
+
+  return (length > 4 && strcmp(name + length - 4, ".tmp") == 0);
+
+} /* END isTempName() **/
+
+/* sweepStore(): objects first, so manifests of objects removed now go in
+ * same run.
+ **************************************************************************/
+
+static void sweepStore(void){
+
+  char           dirName[PATH_MAX];
+  const char     *dirs[] = {STORE_OBJECTS, STORE_KEYS};
+  DIR            *dirPtr;
+  struct dirent  *entry;
+
+  for(size_t index = 0; index < sizeof(dirs) / sizeof(dirs[0]); index++){
+
+    if(snprintf(dirName, sizeof(dirName), "%s/%s", storeRoot, dirs[index]) >= (int) sizeof(dirName))
+      continue;
+
+    dirPtr = opendir(dirName);
+    if(!dirPtr)
+      continue;
+
+    while((entry = readdir(dirPtr))){
+
+      if(strlen(entry->d_name) == 2 && entry->d_name[0] != '.')
+        sweepShard(dirs[index], entry->d_name);
+    }
+
+    closedir(dirPtr);
+  }
+
+} /* END sweepStore() **/
+
+/* sweepShard(): in objects shard removes files with one link; in keys
+ * shard removes manifests naming an object that is not there.
+ **************************************************************************/
+
+static void sweepShard(const char *dir, const char *shard){
+
+  char           shardDir[PATH_MAX], object[PATH_MAX];
+  char           line[PATH_MAX + 128], hex[SHA256_HEX_SIZE];
+  struct stat    status;
+  DIR            *dirPtr;
+  struct dirent  *entry;
+  FILE           *filePtr;
+  int            isObjects = (strcmp(dir, STORE_OBJECTS) == 0);
+  int            fd, manifestFD, gone;
+
+  if(snprintf(shardDir, sizeof(shardDir), "%s/%s/%s", storeRoot, dir, shard) >= (int) sizeof(shardDir))
+    return;
+
+  dirPtr = opendir(shardDir);
+  if(!dirPtr)
+    return;
+
+  fd = dirfd(dirPtr);
+
+  while((entry = readdir(dirPtr))){
+
+    if(entry->d_name[0] == '.' || isTempName(entry->d_name))
+      continue;
+
+    if(fstatat(fd, entry->d_name, &status, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISREG(status.st_mode))
+      continue;
+
+    if(isObjects){
+
+      if(status.st_nlink == 1 && unlinkat(fd, entry->d_name, 0) == 0){
+        storeReport.removed++;
+        storeReport.freedBytes += (long long) status.st_size;
+      }
+      continue;
+    }
+
+    manifestFD = openat(fd, entry->d_name, O_RDONLY | O_CLOEXEC);
+    if(manifestFD < 0)
+      continue;
+
+    filePtr = fdopen(manifestFD, "r");
+    if(!filePtr){
+      close(manifestFD);
+      continue;
+    }
+
+    gone = (fgets(line, sizeof(line), filePtr) && sscanf(line, "%64[0-9a-f]", hex) == 1 &&
+            strlen(hex) == SHA256_HEX_SIZE - 1 &&
+            shardPath(object, sizeof(object), STORE_OBJECTS, hex, FALSE) == ztSuccess &&
+            stat(object, &status) != 0 && errno == ENOENT);
+
+    fclose(filePtr);
+
+    if(gone && unlinkat(fd, entry->d_name, 0) == 0)
+      storeReport.dropped++;
+  }
+
+  closedir(dirPtr);
+
+} /* END sweepShard() **/
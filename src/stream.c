@@ -0,0 +1,229 @@
+/*
+ * stream.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * stream mode output; see stream.h.
+ *
+ * change file is downloaded into memory and checked to be complete gzip
+ * data before its first byte goes out; a reader never gets a cut member
+ * from us. Caller updates 'previous.seq' after streamWrite() returns.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <zlib.h>
+
+#include "stream.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+
+static int   streamFD = -1;
+static int   streamTee = 0;
+
+/* openStream(): 'target' is "-" for standard output or a file descriptor
+ * number inherited from parent process.
+ *
+ ***************************************************************************/
+
+int openStream(const char *target, int tee){
+
+  ASSERTARGS(target);
+
+  int   fd;
+
+  if(strcmp(target, "-") == 0){
+
+    fd = dup(STDOUT_FILENO);
+    if(fd < 0){
+      fprintf(stderr, "%s: Error failed dup() for standard output: %s\n", progName, strerror(errno));
+      return ztFailedSysCall;
+    }
+
+    /* our own messages go to standard error from now on **/
+    fflush(stdout);
+    if(dup2(STDERR_FILENO, STDOUT_FILENO) < 0){
+      fprintf(stderr, "%s: Error failed dup2() for standard output: %s\n", progName, strerror(errno));
+      close(fd);
+      return ztFailedSysCall;
+    }
+  }
+  else {
+
+    fd = atoi(target);
+
+    if(fcntl(fd, F_GETFL) < 0){
+      fprintf(stderr, "%s: Error stream file descriptor <%d> is not open: %s\n", progName, fd, strerror(errno));
+      return ztInvalidArg;
+    }
+  }
+
+  /* curl and cookie helpers must not inherit stream **/
+  fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
+
+  /* reader going away is a write error, not a signal **/
+  signal(SIGPIPE, SIG_IGN);
+
+  streamFD = fd;
+  streamTee = tee;
+
+  return ztSuccess;
+
+} /* END openStream() **/
+
+int isStreaming(void){
+
+  return (streamFD >= 0);
+
+} /* END isStreaming() **/
+
+int isStreamTee(void){
+
+  return (streamFD >= 0 && streamTee);
+
+} /* END isStreamTee() **/
+
+/* isGzipComplete(): TRUE when 'data' is one or more complete gzip members;
+ * inflate checks CRC32 and length in each member trailer.
+ *
+ ***************************************************************************/
+
+int isGzipComplete(const char *data, size_t size){
+
+  ASSERTARGS(data);
+
+  z_stream       zs;
+  unsigned char  scratch[64 * 1024];
+  int            zResult;
+  int            members = 0;
+
+  if(size < 18 || (unsigned char) data[0] != 0x1f || (unsigned char) data[1] != 0x8b)
+
+    return FALSE;
+
+  memset(&zs, 0, sizeof(z_stream));
+
+  /* 16 + MAX_WBITS: gzip wrapper only **/
+  if(inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK)
+
+    return FALSE;
+
+  zs.next_in = (unsigned char *) data;
+  zs.avail_in = (uInt) size;
+
+  do {
+
+    zs.next_out = scratch;
+    zs.avail_out = sizeof(scratch);
+
+    zResult = inflate(&zs, Z_NO_FLUSH);
+
+    if(zResult == Z_STREAM_END){
+
+      members++;
+
+      if(zs.avail_in == 0)
+        break;
+
+      inflateReset(&zs);
+      zResult = Z_OK;
+    }
+
+  } while(zResult == Z_OK);
+
+  inflateEnd(&zs);
+
+  return (zResult == Z_STREAM_END && members > 0);
+
+} /* END isGzipComplete() **/
+
+/* streamWrite(): writes all 'size' bytes to stream; 'name' is for messages **/
+
+int streamWrite(const char *data, size_t size, const char *name){
+
+  ASSERTARGS(data && name);
+
+  size_t   done = 0;
+  ssize_t  count;
+
+  if(streamFD < 0){
+    fprintf(stderr, "%s: Error stream is not open.\n", progName);
+    return ztInvalidUsage;
+  }
+
+  while(done < size){
+
+    count = write(streamFD, data + done, size - done);
+
+    if(count < 0 && errno == EINTR)
+      continue;
+
+    if(count <= 0){
+      fprintf(stderr, "%s: Error failed write() to stream for <%s>: %s\n",
+              progName, name, strerror(errno));
+      return ztWriteError;
+    }
+
+    done += (size_t) count;
+  }
+
+  return ztSuccess;
+
+} /* END streamWrite() **/
+
+/* memory2File(): tee copy; data goes into temporary name then renamed,
+ * so 'filename' is either complete or missing.
+ *
+ ***************************************************************************/
+
+int memory2File(const char *filename, const char *data, size_t size){
+
+  ASSERTARGS(filename && data);
+
+  char   tmpName[PATH_MAX];
+  FILE   *fPtr;
+
+  if(snprintf(tmpName, sizeof(tmpName), "%s.part", filename) >= (int) sizeof(tmpName))
+
+    return ztFnameLong;
+
+  errno = 0;
+  fPtr = fopen(tmpName, "w");
+  if(!fPtr){
+    fprintf(stderr, "%s: Error failed fopen() for file <%s>: %s\n", progName, tmpName, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  int  written = (fwrite(data, 1, size, fPtr) == size);
+
+  if(fclose(fPtr) != 0 || ! written){
+    fprintf(stderr, "%s: Error failed to write file <%s>.\n", progName, tmpName);
+    unlink(tmpName);
+    return ztWriteError;
+  }
+
+  if(rename(tmpName, filename) != 0){
+    fprintf(stderr, "%s: Error failed rename() to <%s>: %s\n", progName, filename, strerror(errno));
+    unlink(tmpName);
+    return ztFailedSysCall;
+  }
+
+  return ztSuccess;
+
+} /* END memory2File() **/
+
+void closeStream(void){
+
+  if(streamFD >= 0)
+    close(streamFD);
+
+  streamFD = -1;
+  streamTee = 0;
+
+} /* END closeStream() **/
@@ -0,0 +1,401 @@
+/*
+ * summary.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * per change file summary sidecar; see summary.h.
+ *
+ * jobs run on their own worker pool; pairDone() submits each change file.
+ * Run totals are kept under a lock and written to log by finishSummary()
+ * from main thread - logMessage() is not thread safe.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "summary.h"
+#include "workers.h"
+#include "util.h"
+#include "fileio.h"
+#include "ztError.h"
+#include "getdiff.h"
+#include "debug.h"
+
+static WORK_POOL        *summaryPool = NULL;
+
+static OSC_SUMMARY      runTotal;
+static long             runFiles = 0;
+static pthread_mutex_t  totalLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void initialSummary(OSC_SUMMARY *summary);
+static void addSummary(OSC_SUMMARY *total, const OSC_SUMMARY *summary);
+static int summaryJob(void *arg);
+static long countChangesets(long long *ids, size_t count);
+static int compareIds(const void *first, const void *second);
+
+int startSummary(void){
+
+  summaryPool = initialWorkPool(numCPUs() > 1 ? numCPUs() - 1 : 1, summaryJob, free);
+  if(!summaryPool){
+    fprintf(stderr, "%s: Error failed initialWorkPool().\n", progName);
+    return ztFailedSysCall;
+  }
+
+  initialSummary(&runTotal);
+  runFiles = 0;
+
+  return ztSuccess;
+
+} /* END startSummary() **/
+
+int isSummarizing(void){
+
+  return (summaryPool != NULL);
+
+} /* END isSummarizing() **/
+
+int summaryPair(const char *oscFile){
+
+  ASSERTARGS(oscFile);
+
+  char  *arg;
+  int   result;
+
+  arg = STRDUP(oscFile);
+
+  result = submitWork(summaryPool, arg);
+  if(result != ztSuccess)
+    free(arg);
+
+  return result;
+
+} /* END summaryPair() **/
+
+/* finishSummary(): waits for queued files, writes run totals to log;
+ * returns first failure.
+ **************************************************************************/
+
+int finishSummary(void){
+
+  char  buffer[512];
+  int   type;
+  int   result;
+
+  if(!summaryPool)
+    return ztSuccess;
+
+  result = finishWorkPool(&summaryPool);
+
+  if(!runFiles)
+    return result;
+
+  snprintf(buffer, sizeof(buffer), "Summary for %ld change files; changesets: %ld", runFiles, runTotal.changesets);
+  logMessage(fLogPtr, buffer);
+
+  for(type = OSC_NODE; type <= OSC_RELATION; type++){
+
+    snprintf(buffer, sizeof(buffer), "  %-8s create: %ld modify: %ld delete: %ld ids: %lld - %lld",
+             oscTypeName((OSC_TYPE) type),
+             runTotal.count[type][OSC_CREATE], runTotal.count[type][OSC_MODIFY],
+             runTotal.count[type][OSC_DELETE],
+             runTotal.minId[type] == INT64_MAX ? 0 : runTotal.minId[type], runTotal.maxId[type]);
+    logMessage(fLogPtr, buffer);
+  }
+
+  if(runTotal.hasBox){
+    snprintf(buffer, sizeof(buffer), "  bounding box: %.7f,%.7f,%.7f,%.7f (min lon,min lat,max lon,max lat)",
+             runTotal.minLon, runTotal.minLat, runTotal.maxLon, runTotal.maxLat);
+    logMessage(fLogPtr, buffer);
+  }
+
+  if(fVerbose)
+    fprintf(stdout, "%s: Wrote summary files for %ld change files.\n", progName, runFiles);
+
+  return result;
+
+} /* END finishSummary() **/
+
+/* summarizeChangeFile(): one streaming pass over 'oscFile' **/
+
+int summarizeChangeFile(OSC_SUMMARY *summary, const char *oscFile){
+
+  ASSERTARGS(summary && oscFile);
+
+  OSC_READER   *reader;
+  OSC_ELEMENT  element;
+  long long    *ids = NULL, *newIds;
+  size_t       idCount = 0, idSize = 0;
+  long long    changeset;
+  const char   *value;
+  size_t       length;
+  int          result;
+
+  initialSummary(summary);
+
+  reader = oscOpen(oscFile);
+  if(!reader){
+    fprintf(stderr, "%s: Error failed oscOpen() for: <%s>\n", progName, oscFile);
+    return ztOpenFileError;
+  }
+
+  while((result = oscNext(reader, &element)) == ztSuccess){
+
+    if(element.action == OSC_NO_ACTION)
+      continue;
+
+    summary->count[element.type][element.action]++;
+
+    if(element.id < summary->minId[element.type])
+      summary->minId[element.type] = element.id;
+
+    if(element.id > summary->maxId[element.type])
+      summary->maxId[element.type] = element.id;
+
+    if(element.hasLocation){
+
+      if(! summary->hasBox){
+        summary->minLat = summary->maxLat = element.lat;
+        summary->minLon = summary->maxLon = element.lon;
+        summary->hasBox = 1;
+      }
+      else {
+        if(element.lat < summary->minLat) summary->minLat = element.lat;
+        if(element.lat > summary->maxLat) summary->maxLat = element.lat;
+        if(element.lon < summary->minLon) summary->minLon = element.lon;
+        if(element.lon > summary->maxLon) summary->maxLon = element.lon;
+      }
+    }
+
+    if(oscAttribute(element.text, "changeset", &value, &length) != ztSuccess)
+      continue;
+
+    changeset = strtoll(value, NULL, 10);
+
+    /* elements from one changeset mostly come together **/
+    if(idCount && ids[idCount - 1] == changeset)
+      continue;
+
+    if(idCount == idSize){
+
+      idSize = idSize ? idSize * 2 : 1024;
+
+      newIds = (long long *) realloc(ids, idSize * sizeof(long long));
+      if(!newIds){
+        fprintf(stderr, "%s: Error allocating memory in summarizeChangeFile().\n", progName);
+        free(ids);
+        oscClose(&reader);
+        return ztMemoryAllocate;
+      }
+
+      ids = newIds;
+    }
+
+    ids[idCount++] = changeset;
+  }
+
+  oscClose(&reader);
+
+  if(result != ztEndOfFile){
+    fprintf(stderr, "%s: Error failed reading change file: <%s>\n", progName, oscFile);
+    free(ids);
+    return result;
+  }
+
+  summary->changesets = countChangesets(ids, idCount);
+
+  free(ids);
+
+  return ztSuccess;
+
+} /* END summarizeChangeFile() **/
+
+/* writeSummaryFile(): writes "summaryFile.part" then renames it **/
+
+int writeSummaryFile(const char *summaryFile, const OSC_SUMMARY *summary){
+
+  ASSERTARGS(summaryFile && summary);
+
+  FILE  *filePtr;
+  char  partFile[PATH_MAX];
+  long  total = 0;
+  int   type, action;
+  int   result = ztSuccess;
+
+  if(snprintf(partFile, sizeof(partFile), "%s.part", summaryFile) >= (int) sizeof(partFile))
+    return ztFnameLong;
+
+  errno = 0;
+  filePtr = fopen(partFile, "w");
+  if(!filePtr){
+    fprintf(stderr, "%s: Error failed fopen() for <%s>: %s\n", progName, partFile, strerror(errno));
+    return ztOpenFileError;
+  }
+
+  for(type = OSC_NODE; type <= OSC_RELATION; type++)
+    for(action = OSC_CREATE; action <= OSC_DELETE; action++)
+      total += summary->count[type][action];
+
+  fprintf(filePtr, "# change file summary written by %s\n", progName);
+  fprintf(filePtr, "elements=%ld\n", total);
+
+  for(type = OSC_NODE; type <= OSC_RELATION; type++){
+
+    for(action = OSC_CREATE; action <= OSC_DELETE; action++)
+      fprintf(filePtr, "%s.%s=%ld\n", oscTypeName((OSC_TYPE) type),
+              oscActionName((OSC_ACTION) action), summary->count[type][action]);
+
+    if(summary->maxId[type]){
+      fprintf(filePtr, "%s.minId=%lld\n", oscTypeName((OSC_TYPE) type), summary->minId[type]);
+      fprintf(filePtr, "%s.maxId=%lld\n", oscTypeName((OSC_TYPE) type), summary->maxId[type]);
+    }
+  }
+
+  fprintf(filePtr, "changesets=%ld\n", summary->changesets);
+
+  if(summary->hasBox){
+    fprintf(filePtr, "minLat=%.7f\n", summary->minLat);
+    fprintf(filePtr, "minLon=%.7f\n", summary->minLon);
+    fprintf(filePtr, "maxLat=%.7f\n", summary->maxLat);
+    fprintf(filePtr, "maxLon=%.7f\n", summary->maxLon);
+  }
+
+  if(ferror(filePtr))
+    result = ztWriteError;
+
+  if(fclose(filePtr) != 0)
+    result = ztWriteError;
+
+  if(result == ztSuccess && rename(partFile, summaryFile) != 0){
+    fprintf(stderr, "%s: Error failed rename() for <%s>: %s\n", progName, partFile, strerror(errno));
+    result = ztFailedSysCall;
+  }
+
+  if(result != ztSuccess)
+    removeFile(partFile);
+
+  return result;
+
+} /* END writeSummaryFile() **/
+
+static void initialSummary(OSC_SUMMARY *summary){
+
+  int  type;
+
+  memset(summary, 0, sizeof(OSC_SUMMARY));
+
+  for(type = OSC_NODE; type <= OSC_RELATION; type++)
+    summary->minId[type] = INT64_MAX;
+
+} /* END initialSummary() **/
+
+static void addSummary(OSC_SUMMARY *total, const OSC_SUMMARY *summary){
+
+  int  type, action;
+
+  for(type = OSC_NODE; type <= OSC_RELATION; type++){
+
+    for(action = OSC_CREATE; action <= OSC_DELETE; action++)
+      total->count[type][action] += summary->count[type][action];
+
+    if(summary->minId[type] < total->minId[type])
+      total->minId[type] = summary->minId[type];
+
+    if(summary->maxId[type] > total->maxId[type])
+      total->maxId[type] = summary->maxId[type];
+  }
+
+  /* same changeset can span files; this is a sum **/
+  total->changesets += summary->changesets;
+
+  if(! summary->hasBox)
+    return;
+
+  if(! total->hasBox){
+    total->minLat = summary->minLat;
+    total->minLon = summary->minLon;
+    total->maxLat = summary->maxLat;
+    total->maxLon = summary->maxLon;
+    total->hasBox = 1;
+    return;
+  }
+
+  if(summary->minLat < total->minLat) total->minLat = summary->minLat;
+  if(summary->minLon < total->minLon) total->minLon = summary->minLon;
+  if(summary->maxLat > total->maxLat) total->maxLat = summary->maxLat;
+  if(summary->maxLon > total->maxLon) total->maxLon = summary->maxLon;
+
+} /* END addSummary() **/
+
+/* summaryJob(): 'arg' is change file name; sidecar replaces CHANGE_EXT **/
+
+static int summaryJob(void *arg){
+
+  char         *oscFile = (char *) arg;
+  char         summaryFile[PATH_MAX];
+  OSC_SUMMARY  summary;
+  size_t       length = strlen(oscFile);
+  int          result;
+
+  if(length < strlen(CHANGE_EXT) || strcmp(oscFile + length - strlen(CHANGE_EXT), CHANGE_EXT) != 0)
+    return ztInvalidArg;
+
+  length -= strlen(CHANGE_EXT);
+
+  if(length + strlen(SUMMARY_EXT) >= sizeof(summaryFile))
+    return ztFnameLong;
+
+  memcpy(summaryFile, oscFile, length);
+  strcpy(summaryFile + length, SUMMARY_EXT);
+
+  result = summarizeChangeFile(&summary, oscFile);
+  if(result != ztSuccess)
+    return result;
+
+  result = writeSummaryFile(summaryFile, &summary);
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed writeSummaryFile() for: <%s>\n", progName, summaryFile);
+    return result;
+  }
+
+  pthread_mutex_lock(&totalLock);
+  addSummary(&runTotal, &summary);
+  runFiles++;
+  pthread_mutex_unlock(&totalLock);
+
+  return ztSuccess;
+
+} /* END summaryJob() **/
+
+/* countChangesets(): sorts 'ids' and counts distinct values **/
+
+static long countChangesets(long long *ids, size_t count){
+
+  size_t  index;
+  long    distinct;
+
+  if(!count)
+    return 0;
+
+  qsort(ids, count, sizeof(long long), compareIds);
+
+  distinct = 1;
+  for(index = 1; index < count; index++)
+    if(ids[index] != ids[index - 1])
+      distinct++;
+
+  return distinct;
+
+} /* END countChangesets() **/
+
+static int compareIds(const void *first, const void *second){
+
+  long long  one = *(const long long *) first;
+  long long  two = *(const long long *) second;
+
+  return (one > two) - (one < two);
+
+} /* END compareIds() **/
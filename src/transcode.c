@@ -0,0 +1,441 @@
+/*
+ * transcode.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * gzip to zstd transcode stage; see transcode.h.
+ *
+ * pairDone() hands each completed pair to transcodePair(); the job runs on
+ * worker pool and sends the pair event itself - after the .osc.zst file is
+ * in place - so updater never gets a name that is about to be removed.
+ *
+ * Jobs finish out of order; each takes a ticket in submit order and its
+ * event waits on doneEvents list until every earlier ticket is done, so
+ * events go out in sequence order as they do without zstd.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <zlib.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "transcode.h"
+#include "workers.h"
+#include "events.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+#include "debug.h"
+
+typedef struct DONE_EVENT_ {
+
+  unsigned long       ticket;
+  char                *zstFile;    /* NULL: job failed, no event **/
+  char                *stateFile;
+  struct DONE_EVENT_  *next;
+
+} DONE_EVENT;
+
+typedef struct TRANSCODE_JOB_ {
+
+  char        *oscFile;
+  char        *stateFile;
+  DONE_EVENT  *done;       /* NULL once on doneEvents list **/
+
+} TRANSCODE_JOB;
+
+static WORK_POOL        *transcodePool = NULL;
+static ZST_MODE         transcodeMode = ZST_OFF;
+
+static unsigned long    nextTicket = 0;     /* main thread only **/
+
+/* eventLock: doneEvents list - sorted by ticket - and nextEvent **/
+static pthread_mutex_t  eventLock = PTHREAD_MUTEX_INITIALIZER;
+static DONE_EVENT       *doneEvents = NULL;
+static unsigned long    nextEvent = 0;
+
+static int transcodeJob(void *arg);
+static void eventInOrder(DONE_EVENT *done);
+static void freeJob(void *arg);
+static int zstdName(char *dest, size_t size, const char *gzName);
+
+int isZstdSupported(void){
+
+#ifdef HAVE_ZSTD
+  return TRUE;
+#else
+  return FALSE;
+#endif
+
+} /* END isZstdSupported() **/
+
+/* string2ZstdMode(): "replace" or "copy" **/
+
+int string2ZstdMode(ZST_MODE *mode, const char *string){
+
+  ASSERTARGS(mode && string);
+
+  if(strcmp(string, "replace") == 0)
+    *mode = ZST_REPLACE;
+  else if(strcmp(string, "copy") == 0)
+    *mode = ZST_COPY;
+  else
+    return ztInvalidArg;
+
+  return ztSuccess;
+
+} /* END string2ZstdMode() **/
+
+int startTranscode(ZST_MODE mode){
+
+  if(mode == ZST_OFF)
+    return ztSuccess;
+
+  if(! isZstdSupported()){
+    fprintf(stderr, "%s: Error program was built without zstd support.\n", progName);
+    return ztInvalidUsage;
+  }
+
+  /* leave one core for download and curl **/
+  transcodePool = initialWorkPool(numCPUs() > 1 ? numCPUs() - 1 : 1, transcodeJob, freeJob);
+  if(!transcodePool){
+    fprintf(stderr, "%s: Error failed initialWorkPool().\n", progName);
+    return ztFailedSysCall;
+  }
+
+  transcodeMode = mode;
+
+  return ztSuccess;
+
+} /* END startTranscode() **/
+
+int isTranscoding(void){
+
+  return (transcodePool != NULL);
+
+} /* END isTranscoding() **/
+
+int transcodePair(const char *oscFile, const char *stateFile){
+
+  ASSERTARGS(oscFile && stateFile);
+
+  TRANSCODE_JOB  *job;
+  int            result;
+
+  job = (TRANSCODE_JOB *) malloc(sizeof(TRANSCODE_JOB));
+  if(job)
+    job->done = (DONE_EVENT *) calloc(1, sizeof(DONE_EVENT));
+
+  if(!job || !job->done){
+    fprintf(stderr, "%s: Error allocating memory in transcodePair().\n", progName);
+    free(job);
+    return ztMemoryAllocate;
+  }
+
+  job->oscFile = STRDUP(oscFile);
+  job->stateFile = STRDUP(stateFile);
+  job->done->ticket = nextTicket++;
+
+  result = submitWork(transcodePool, job);
+  if(result != ztSuccess){
+    /* ticket is taken; later events must not wait for it **/
+    eventInOrder(job->done);
+    job->done = NULL;
+    freeJob(job);
+  }
+
+  return result;
+
+} /* END transcodePair() **/
+
+/* finishTranscode(): waits for queued files; returns first failure **/
+
+int finishTranscode(void){
+
+  int  result;
+
+  if(!transcodePool)
+    return ztSuccess;
+
+  result = finishWorkPool(&transcodePool);
+
+  return result;
+
+} /* END finishTranscode() **/
+
+/* gzip2Zstd(): inflates 'gzName' and writes 'zstName'. Output goes to
+ * "zstName.part" and is renamed when complete; gzread() fails on bad
+ * CRC32 or length so a corrupt download is never transcoded.
+ *
+ ***************************************************************************/
+
+int gzip2Zstd(const char *gzName, const char *zstName, int level){
+
+  ASSERTARGS(gzName && zstName);
+
+#ifndef HAVE_ZSTD
+
+  fprintf(stderr, "%s: Error program was built without zstd support.\n", progName);
+  return ztInvalidUsage;
+
+#else
+
+  gzFile         gz;
+  FILE           *out;
+  ZSTD_CCtx      *cctx;
+  ZSTD_inBuffer  input;
+  ZSTD_outBuffer output;
+  char           partFile[PATH_MAX];
+  size_t         inSize = ZSTD_CStreamInSize();
+  size_t         outSize = ZSTD_CStreamOutSize();
+  char           *inBuf, *outBuf;
+  size_t         remaining;
+  int            count, zErr;
+  int            result = ztSuccess;
+
+  if(snprintf(partFile, sizeof(partFile), "%s.part", zstName) >= (int) sizeof(partFile))
+    return ztFnameLong;
+
+  gz = gzopen(gzName, "rb");
+  if(!gz){
+    fprintf(stderr, "%s: Error failed gzopen() for: <%s>\n", progName, gzName);
+    return ztOpenFileError;
+  }
+
+  errno = 0;
+  out = fopen(partFile, "w");
+  if(!out){
+    fprintf(stderr, "%s: Error failed fopen() for <%s>: %s\n", progName, partFile, strerror(errno));
+    gzclose(gz);
+    return ztOpenFileError;
+  }
+
+  inBuf = (char *) malloc(inSize);
+  outBuf = (char *) malloc(outSize);
+  cctx = ZSTD_createCCtx();
+
+  if(!inBuf || !outBuf || !cctx){
+    fprintf(stderr, "%s: Error allocating memory in gzip2Zstd().\n", progName);
+    result = ztMemoryAllocate;
+    goto ZST_CLEAN;
+  }
+
+  ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+  ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+
+  do {
+
+    count = gzread(gz, inBuf, (unsigned) inSize);
+
+    /* plain file is read as is by gzread(); truncated file ends early
+     * with Z_BUF_ERROR **/
+    if(count >= 0 && (gzdirect(gz) || (count == 0 && (gzerror(gz, &zErr), zErr != Z_OK))))
+      count = -1;
+
+    if(count < 0){
+      fprintf(stderr, "%s: Error corrupt gzip file <%s>: %s\n", progName, gzName, gzerror(gz, &zErr));
+      result = ztMalformedFile;
+      goto ZST_CLEAN;
+    }
+
+    input.src = inBuf;
+    input.size = (size_t) count;
+    input.pos = 0;
+
+    /* count zero is end of input; flush frame **/
+    do {
+
+      output.dst = outBuf;
+      output.size = outSize;
+      output.pos = 0;
+
+      remaining = ZSTD_compressStream2(cctx, &output, &input, count ? ZSTD_e_continue : ZSTD_e_end);
+      if(ZSTD_isError(remaining)){
+        fprintf(stderr, "%s: Error ZSTD_compressStream2(): %s\n", progName, ZSTD_getErrorName(remaining));
+        result = ztFailedLibCall;
+        goto ZST_CLEAN;
+      }
+
+      if(fwrite(outBuf, 1, output.pos, out) != output.pos){
+        result = ztWriteError;
+        goto ZST_CLEAN;
+      }
+
+    } while(count ? (input.pos < input.size) : (remaining != 0));
+
+  } while(count > 0);
+
+ZST_CLEAN:
+
+  gzclose(gz);
+
+  if(fclose(out) != 0 && result == ztSuccess)
+    result = ztWriteError;
+
+  if(cctx)
+    ZSTD_freeCCtx(cctx);
+
+  free(inBuf);
+  free(outBuf);
+
+  if(result == ztSuccess && rename(partFile, zstName) != 0){
+    fprintf(stderr, "%s: Error failed rename() to <%s>: %s\n", progName, zstName, strerror(errno));
+    result = ztFailedSysCall;
+  }
+
+  if(result != ztSuccess)
+    unlink(partFile);
+
+  return result;
+
+#endif /* HAVE_ZSTD **/
+
+} /* END gzip2Zstd() **/
+
+/* zstdListNames(): list entries for change files are renamed to ZST_EXT;
+ * list file records what is on disk.
+ *
+ ***************************************************************************/
+
+int zstdListNames(STRING_LIST *list){
+
+  ASSERTARGS(list);
+
+  ELEM    *elem;
+  char    *name, *newName;
+  size_t  len, extLen = strlen(CHANGE_EXT);
+
+  for(elem = DL_HEAD(list); elem; elem = DL_NEXT(elem)){
+
+    name = (char *) DL_DATA(elem);
+    len = strlen(name);
+
+    if(len <= extLen || strcmp(name + len - extLen, CHANGE_EXT) != 0)
+      continue;
+
+    newName = (char *) malloc(len - extLen + strlen(ZST_EXT) + 1);
+    if(!newName)
+      return ztMemoryAllocate;
+
+    memcpy(newName, name, len - extLen);
+    strcpy(newName + len - extLen, ZST_EXT);
+
+    free(name);
+    elem->data = newName;
+  }
+
+  return ztSuccess;
+
+} /* END zstdListNames() **/
+
+static int transcodeJob(void *arg){
+
+  TRANSCODE_JOB  *job = (TRANSCODE_JOB *) arg;
+  char           zstFile[PATH_MAX];
+  int            result;
+
+  result = zstdName(zstFile, sizeof(zstFile), job->oscFile);
+  if(result == ztSuccess)
+    result = gzip2Zstd(job->oscFile, zstFile, ZST_LEVEL);
+
+  if(result != ztSuccess){
+    fprintf(stderr, "%s: Error failed gzip2Zstd() for: <%s>\n", progName, job->oscFile);
+    if(fLogPtr){
+      logMessage(fLogPtr, "Error failed gzip2Zstd() for file below:");
+      logMessageLevel(fLogPtr, LOG_ERROR, job->oscFile);
+    }
+  }
+  else{
+
+    if(transcodeMode == ZST_REPLACE)
+      unlink(job->oscFile);
+
+    if(fVerbose)
+      fprintf(stdout, "%s: Transcoded to zstd: %s\n", progName, zstFile);
+
+    job->done->zstFile = STRDUP(zstFile);
+    job->done->stateFile = job->stateFile;
+    job->stateFile = NULL;
+  }
+
+  /* failed job still releases its ticket **/
+  eventInOrder(job->done);
+  job->done = NULL;
+
+  return result;
+
+} /* END transcodeJob() **/
+
+static void freeJob(void *arg){
+
+  TRANSCODE_JOB  *job = (TRANSCODE_JOB *) arg;
+
+  if(!job)
+    return;
+
+  free(job->oscFile);
+  free(job->stateFile);
+  free(job->done);
+  free(job);
+
+} /* END freeJob() **/
+
+/* eventInOrder(): puts 'done' on doneEvents list, then sends events for
+ * list head while it is next ticket. Takes 'done'.
+ *
+ ***************************************************************************/
+
+static void eventInOrder(DONE_EVENT *done){
+
+  DONE_EVENT  **link;
+
+  pthread_mutex_lock(&eventLock);
+
+  for(link = &doneEvents; *link && (*link)->ticket < done->ticket; link = &(*link)->next)
+    ;
+
+  done->next = *link;
+  *link = done;
+
+  while(doneEvents && doneEvents->ticket == nextEvent){
+
+    done = doneEvents;
+    doneEvents = done->next;
+    nextEvent++;
+
+    if(done->zstFile && done->stateFile)
+      emitPairEvent(done->zstFile, done->stateFile);
+
+    free(done->zstFile);
+    free(done->stateFile);
+    free(done);
+  }
+
+  pthread_mutex_unlock(&eventLock);
+
+} /* END eventInOrder() **/
+
+static int zstdName(char *dest, size_t size, const char *gzName){
+
+  size_t  len = strlen(gzName);
+  size_t  extLen = strlen(CHANGE_EXT);
+
+  if(len <= extLen || strcmp(gzName + len - extLen, CHANGE_EXT) != 0)
+    return ztInvalidArg;
+
+  if(len - extLen + strlen(ZST_EXT) + 1 > size)
+    return ztFnameLong;
+
+  memcpy(dest, gzName, len - extLen);
+  strcpy(dest + len - extLen, ZST_EXT);
+
+  return ztSuccess;
+
+} /* END zstdName() **/
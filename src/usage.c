@@ -60,7 +60,35 @@ void showHelp(void){
     "   -c, --conf FILE     Configuration file to use, default {HOME}/getdiff.conf \n"
     "   -n, --new           Specify the action for newly downloaded files. By default, the program\n"
     "                       appends the newly downloaded file names to 'newerFiles.txt'. Use this\n"
-    "                       option to change this behavior.\n\n"
+    "                       option to change this behavior.\n"
+    "       --pending       Print file names from 'newerFiles.txt' not acknowledged yet and exit.\n"
+    "       --ack COUNT     Acknowledge COUNT file names printed by '--pending' and exit.\n"
+    "       --events PATH   Send an event line for each downloaded pair to FIFO or Unix socket PATH.\n"
+    "       --stream TARGET Write change files to TARGET as one gzip stream; \"-\" is standard output.\n"
+    "       --tee           With '--stream', keep change files on disk too.\n"
+    "       --merge         Merge downloaded change files into one change file.\n"
+    "       --zstd MODE     Transcode change files to zstd; MODE is \"replace\" or \"copy\".\n"
+    "       --verify        Check local change files for 'source' and exit.\n"
+    "       --summary       Write summary file with element counts next to each change file.\n"
+    "       --region N=FILE Write regional change files for region N in polygon FILE; repeatable.\n"
+    "       --expire ZOOMS  Write expired tiles list for zoom levels ZOOMS; \"14\" or \"10-16\".\n"
+    "       --index         Add downloaded change files to object id index.\n"
+    "       --lookup OBJ    Print change files that changed OBJ; \"way/123\" or \"w123\" and exit.\n"
+    "       --retain-days N Remove consumed change files downloaded more than N days ago.\n"
+    "       --retain-count N\n"
+    "                       Keep at most N change files; remove oldest consumed ones.\n"
+    "       --retain-size SIZE\n"
+    "                       Keep change files tree under SIZE bytes; K, M, G or T suffix.\n"
+    "       --pack          Pack consumed NNN/NNN directories into one NNN.pack file each.\n"
+    "       --extract SEQ   Write file for SEQ to standard output; \"4428\" or \"4428.state.txt\".\n"
+    "       --store DIR     Keep one copy of identical files in content store DIR.\n"
+    "       --serve ADDR    Serve change files as replication mirror on [ADDRESS:]PORT until stopped.\n"
+    "       --cookie-cache DIR\n"
+    "                       Keep internal server cookie in DIR; default {HOME}/.cache/getdiff.\n"
+    "       --public-meta   Internal server: state.txt and listings from public server, no cookie for them.\n"
+    "       --log-level LEVEL\n"
+    "                       Log lines at LEVEL and above: error, warning, info or debug; default info.\n"
+    "       --metrics DIR   Write Prometheus textfile metrics for this source to DIR after each run.\n\n"
 
     "Arguments are explained below.\n\n";
 
@@ -103,7 +131,19 @@ void showHelp(void){
 
     "https://planet.openstreetmap.org/replication/minute/\n"
     "https://planet.openstreetmap.org/replication/hour/\n"
-    "https://planet.openstreetmap.org/replication/day/\n\n";
+    "https://planet.openstreetmap.org/replication/day/\n\n"
+
+    "A mirror from --serve has upstream server and path after its own server:\n\n"
+
+    "http://{mirror}:{port}/planet.openstreetmap.org/replication/minute/\n\n"
+
+    "A local directory laid out as replication directory - an rsync copy or a mount\n"
+    "of a mirror - is given as 'file://' URL or absolute path; its last entry is as\n"
+    "on server: [minute | hour | day] or '{area}-updates'. Files are hard linked,\n"
+    "cloned or copied; nothing goes over the network:\n\n"
+
+    "file:///srv/mirror/replication/minute/\n"
+    "/srv/mirror/europe/{area}-updates/\n\n";
 
   char   *usageDir =
 
@@ -135,7 +175,7 @@ void showHelp(void){
       "Together with 'begin' set this provides a RANGE of change files to download.\n"
       "With 'end' equals 'begin'; that change file and its corresponding state.txt are downloaded.\n"
       "Note that both sequence numbers must be from the same GRANULARITY (minute, hour or day).\n"
-      "Downloaded file list are appended to 'rangeList.txt' file in working directory.\n\n";
+      "Downloaded file list are appended to 'rangeList.txt' file in source directory.\n\n";
 
   char   *usageName =
 
@@ -174,6 +214,152 @@ void showHelp(void){
     "file names to file 'newerFiles.txt' in its working directory. To stop this behaviour\n"
     "use this option (No argument is required on the command line).\n\n";
 
+  char   *usageQueue =
+
+    "COUNT for --ack:\n"
+
+    "File 'newerFiles.txt' is append only; your updater does not remove it. Updater\n"
+    "position is kept in 'newerFiles.cursor' file. Use '--pending' to list new file names\n"
+    "past that position, apply them then use '--ack COUNT' with the number of names\n"
+    "applied. Both options need the working directory only - '--directory' or DIRECTORY\n"
+    "key - and can be used while another instance is downloading. Download drops entries\n"
+    "already acknowledged once they reach 1 MiB. For a source other than the one using\n"
+    "work directory files set it with '--source' or SOURCE key.\n\n";
+
+  char   *usageEvents =
+
+    "PATH for --events:\n"
+
+    "PATH is a named pipe (FIFO) or Unix domain stream socket; a FIFO is created when PATH\n"
+    "does not exist. Each time a change file and its state.txt file are downloaded, one JSON\n"
+    "line is written with 'path', 'state', 'sequence', 'timestamp' and 'size' members. Your\n"
+    "updater can apply files while later files are still downloading. Program never waits\n"
+    "for the reader; with no reader, or a slow one, events are dropped and logged, names\n"
+    "are still appended to 'newerFiles.txt'.\n\n";
+
+  char   *usageStream =
+
+    "TARGET for --stream:\n"
+
+    "TARGET is \"-\" for standard output or an open file descriptor number. Change files are\n"
+    "written in sequence order as one concatenated gzip stream, each file is checked to be\n"
+    "complete before it is written. Program messages go to standard error. Change files\n"
+    "are not saved and 'newerFiles.txt' is not appended unless '--tee' is used; state.txt\n"
+    "files are saved. 'previous.seq' is updated after each change file is written, so an\n"
+    "interrupted run resumes with the first file not fully written.\n\n";
+
+  char   *usageMerge =
+
+    "Merge with --merge:\n"
+
+    "After download, change files are merged into one file in 'merged' directory under\n"
+    "the change files directory, named {first}-{last}.osc.gz with a state.txt file for the\n"
+    "last sequence. Only the last version of each node, way and relation is kept. The\n"
+    "merged pair is appended to the list file in place of downloaded files. With 'begin'\n"
+    "and 'end' the whole range is merged from the tree, files from earlier runs too. Memory\n"
+    "use is bounded; large merges use temporary files in program 'tmp' directory.\n\n";
+
+  char   *usageZstd =
+
+    "MODE for --zstd:\n"
+
+    "Each downloaded change file is checked then written as zstd '.osc.zst' file on worker\n"
+    "threads while next files download. With \"replace\" the '.osc.gz' file is removed, with\n"
+    "\"copy\" it is kept. List file and events name the '.osc.zst' file. Program must be\n"
+    "built with zstd support: make ZSTD=1\n\n";
+
+  char   *usageVerify =
+
+    "Checking with --verify:\n"
+
+    "Every '.osc.gz' file for 'source' is fully decompressed and its gzip CRC32 and length\n"
+    "checked; 'sequenceNumber' in each state.txt file must match its path. Files run on all\n"
+    "CPU cores. Corrupt files, orphaned files - one of the pair is missing - and gaps in\n"
+    "sequence numbers are listed. Use with 'begin' and 'end' to check a range only. Program\n"
+    "exits with non-zero code when problems are found.\n\n";
+
+  char   *usageSummary =
+
+    "Summary with --summary:\n"
+
+    "Each downloaded change file is read once on worker threads while next files download\n"
+    "and 'NNN.summary.txt' is written next to it with create, modify and delete counts for\n"
+    "node, way and relation, smallest and largest ids, number of changesets and bounding\n"
+    "box of nodes. Totals for the run are written to log file.\n\n";
+
+  char   *usageRegion =
+
+    "NAME=FILE for --region:\n"
+
+    "FILE is Osmosis polygon (.poly) file. After download each change file is filtered in\n"
+    "one pass for all regions into {workDir}/regions/NAME/ tree with the same sequence\n"
+    "numbers, each with its own state.txt and 'newerFiles.txt' files. Way and relation go\n"
+    "to regions of their nodes and members; a node location cache is kept between runs in\n"
+    "{workDir}/regions/objects.cache. Up to 32 regions; use option once per region.\n\n";
+
+  char   *usageExpire =
+
+    "ZOOMS for --expire:\n"
+
+    "Single zoom level or MIN-MAX range from 0 to 20. Node locations in downloaded change\n"
+    "files are turned into web mercator tiles on worker threads; tiles are written as\n"
+    "\"z/x/y\" lines without duplicates to 'expireTiles.txt' in source directory when done.\n"
+    "File is merged with tiles already in it; remove it when tiles are expired.\n\n";
+
+  char   *usageIndex =
+
+    "Object id index with --index and --lookup:\n"
+
+    "With --index each downloaded change file is read on worker threads and its node, way\n"
+    "and relation ids are added to index in {source tree}/index/ - one segment file per\n"
+    "run; segments are merged when there are more than 8. --lookup with 'source' prints\n"
+    "sequence number and change file for each change to OBJ found in index; OBJ is\n"
+    "node/ID, way/ID, relation/ID or n, w, r followed by ID. Only files downloaded with\n"
+    "--index are in index.\n\n";
+
+  char   *usageRetain =
+
+    "Retention with --retain-days, --retain-count and --retain-size:\n"
+
+    "Oldest change files - with state.txt and sidecar files - are removed from tree for\n"
+    "'source' until all given limits are met; emptied NNN/NNN directories are removed.\n"
+    "Files the updater has not consumed from 'newerFiles.txt' and the last downloaded\n"
+    "file are never removed. Runs on its own thread next to downloads; at most 20000\n"
+    "change files per run. Not used with --text, --new, --end or on first run.\n\n";
+
+  char   *usagePack =
+
+    "Pack files with --pack and --extract:\n"
+
+    "After download, each NNN/NNN directory whose files the updater has consumed is\n"
+    "written to NNN/NNN.pack - files with an index at the end - and the directory is\n"
+    "removed; recent directories stay loose files. At most 100 directories per run.\n"
+    "--extract with 'source' writes one file from the tree or its pack to standard\n"
+    "output; SEQ is sequence number with optional extension, default is \".osc.gz\".\n"
+    "--verify and --lookup read pack files; retention removes a pack file whole.\n\n";
+
+  char   *usageStore =
+
+    "Content store with --store:\n"
+
+    "Work directories may share one store DIR. Each downloaded file is hashed with\n"
+    "SHA-256 and hard linked to its object in DIR/objects - reflink or copy on another\n"
+    "file system - and a manifest for the remote file is kept in DIR/keys. A file the\n"
+    "store already has for 'source' is linked from it and not downloaded; Geofabrik\n"
+    "INTERNAL and PUBLIC sources share state.txt files. Keep DIR on the file system of\n"
+    "work directories; objects with one link are used by no tree and may be removed.\n\n";
+
+  char   *usageServe =
+
+    "Replication mirror with --serve:\n"
+
+    "Serves change files trees in work directory over HTTP on PORT - all addresses or\n"
+    "ADDRESS only - until SIGINT or SIGTERM. Each tree is under its upstream server\n"
+    "and path: planet trees always, Geofabrik tree when 'source' is Geofabrik. Layout\n"
+    "is that of upstream with state.txt for newest complete pair, so other getdiff\n"
+    "instances and osmosis-style tools use the mirror URL as source. Packed files are\n"
+    "served too. Read only; runs next to downloads in the same work directory.\n\n";
+
   char   *limitations =
 
     "Limitations:\n"
@@ -188,7 +374,9 @@ void showHelp(void){
     "KEY and VALUE separated by space and an optional equal sign '='.\n"
     "Comment lines start with '#' or ';' characters, no comment is allowed on a\n"
     "directive line. KEYS correspond to command line options. Allowed directive KEYS set:\n"
-    "{VERBOSE, USER, PASSWD, DIRECTORY, BEGIN, END, NEWER_FILE}.\n"
+    "{VERBOSE, USER, PASSWD, DIRECTORY, BEGIN, END, NEWER_FILE, EVENTS,\n"
+    "RETAIN_DAYS, RETAIN_COUNT, RETAIN_SIZE, STORE, COOKIE_CACHE, PUBLIC_META, LOG_LEVEL,\n"
+    "METRICS, LOGIN_HOST, CONSUMER_URL}.\n"
     "Unrecognized and duplicate directive 'KEYS' trigger error. You may set values to any\n"
     "number of KEYS or none.\n"
     "Default configuration file is {HOME}/getdiff.conf - user home directory. File is not\n"
@@ -212,7 +400,31 @@ void showHelp(void){
 
     " PASSWD : same as --passwd option.\n\n"
 
-    " NEWER_FILE : same as --new option.\n\n";
+    " NEWER_FILE : same as --new option.\n\n"
+
+    " EVENTS : same as --events option. Specify full path in configuration file.\n\n"
+
+    " RETAIN_DAYS : same as --retain-days option.\n\n"
+
+    " RETAIN_COUNT : same as --retain-count option.\n\n"
+
+    " RETAIN_SIZE : same as --retain-size option.\n\n"
+
+    " STORE : same as --store option. Specify full path in configuration file.\n\n"
+
+    " COOKIE_CACHE : same as --cookie-cache option. Specify full path in configuration file.\n\n"
+
+    " PUBLIC_META : same as --public-meta option; accepted values [on, true, 1] case ignored.\n\n"
+
+    " LOG_LEVEL : same as --log-level option.\n\n"
+
+    " METRICS : same as --metrics option. Specify full path in configuration file.\n\n"
+
+    " LOGIN_HOST : OSM login server for the cookie; no command line option.\n"
+    "   Default https://www.openstreetmap.org; set for stand-in server in tests.\n\n"
+
+    " CONSUMER_URL : Geofabrik cookie consumer URL; no command line option. Default\n"
+    "   https://osm-internal.download.geofabrik.de/get_cookie\n\n";
 
   char *confExample =
 
@@ -252,6 +464,9 @@ void showHelp(void){
     "# ignored.\n"
     "# NEWER_FILE = NONE\n\n"
 
+    "# Keep change files tree under 20 gigabytes; consumed files are removed oldest first.\n"
+    "# RETAIN_SIZE = 20G\n\n"
+
     "# End configuration example.\n\n";
 
   char   *howItworks =
@@ -297,32 +512,44 @@ void showHelp(void){
     STYLE_NO_BOLD
 
 
-    "The 'newerFiles.txt' file in the working directory acts as a \"bucket\" storing a list\n"
+    "The 'newerFiles.txt' file in the working directory acts as a queue storing a list\n"
     "of downloaded file names to destination directory. Downloaded file names are\n"
-    "appended to this file. Another process is expected to use listed file names in this\n"
-    "file to apply the update and remove 'newerFiles.txt' file when done; effectively\n"
-    "emptying the \"bucket\".\n\n"
+    "appended to this file and flushed to disk. Another process is expected to use listed\n"
+    "file names in this file to apply the update; it reads new names with '--pending' and\n"
+    "marks them done with '--ack COUNT'. Its position is kept in 'newerFiles.cursor' file.\n\n"
 
     "When using the 'range' function, program appends a list of downloaded files to file\n"
-    "'rangeList.txt' in its working directory.\n\n"
+    "'rangeList.txt' in source directory.\n\n"
 
     "Program writes minimal progress messages to terminal and log file in working directory,"
     "using 'verbose' option will generate extra messages for debugging.\n\n"
 
 
-    "Program writes the following files in its working directory:\n\n"
+    "Program writes 'getdiff.log' in its working directory, empty it once in awhile.\n"
+    "Sources run at the same time in one working directory; one instance per source.\n"
+    "Source directory is the working directory for the source that used it first - named\n"
+    "in '.source.getdiff' there; any other source uses '.source' under its change files\n"
+    "tree, {workDir}/geofabrik/.source/ or {workDir}/planet/{minute|hour|day}/.source/.\n"
+    "Source directory has:\n\n"
 
-    " - geofabrikCookie.txt : most recent geofabrik internal server cookie file - do NOT delete\n"
-    " - getdiff.log: program log file, you need to empty it once in awhile.\n"
-    " - newerFiles.txt: our \"bucket\" file, your script need to empty it.\n"
+    " - newerFiles.txt: our queue file, append only - use '--pending' and '--ack'.\n"
+    " - newerFiles.cursor: updater position in 'newerFiles.txt'.\n"
     " - previous.seq: sequence number of last downloaded change file.\n"
 	" - latest.state.txt: state file for latest successfully downloaded file.\n"
-    " - rangeList.txt: list of downloaded files when using 'range' function.\n\n"
+    " - rangeList.txt: list of downloaded files when using 'range' function.\n"
+    " - journal.wal: each downloaded pair is committed here; a rerun resumes from it.\n\n"
 
-	"Temporary files are written to 'tmp' directory under the program directory.\n\n"
+	"Temporary files are written to 'tmp' directory under source directory.\n\n"
+
+    "Each change file and state.txt pair is committed as it completes: list file and\n"
+    "'previous.seq' are advanced right away, so a failed or stopped run keeps its work.\n"
+    "SIGTERM or Ctrl-C stops download after the pair in progress; a second one stops at\n"
+    "once. A rerun - same range for 'range' function - does not download committed pairs\n"
+    "again. With merge, region, zstd, summary, expire and index options list file is still\n"
+    "written at the end; committed pairs are reused by the rerun.\n\n"
 
     STYLE_BOLD
-    "IMPORTANT: Do Not Delete 'previous.seq' from working directory.\n\n"
+    "IMPORTANT: Do Not Delete 'previous.seq' from source directory.\n\n"
     STYLE_NO_BOLD
     "Typically one would store SOURCE, USER and DIRECTORY in a configuration file and\n"
     "start the program with :\n"
@@ -359,6 +586,34 @@ void showHelp(void){
 
   fprintf(stdout, usageNew);
 
+  fprintf(stdout, usageQueue);
+
+  fprintf(stdout, usageEvents);
+
+  fprintf(stdout, usageStream);
+
+  fprintf(stdout, usageMerge);
+
+  fprintf(stdout, usageZstd);
+
+  fprintf(stdout, usageVerify);
+
+  fprintf(stdout, usageSummary);
+
+  fprintf(stdout, usageRegion);
+
+  fprintf(stdout, usageExpire);
+
+  fprintf(stdout, usageIndex);
+
+  fprintf(stdout, usageRetain);
+
+  fprintf(stdout, usagePack);
+
+  fprintf(stdout, usageStore);
+
+  fprintf(stdout, usageServe);
+
   fprintf(stdout, limitations);
 
   fprintf(stdout, confDscrp);
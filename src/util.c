@@ -14,6 +14,7 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <limits.h>
+#include <stdint.h>
 #include <pwd.h>
 #include <sys/types.h>
 #include <dirent.h>
@@ -1160,11 +1161,30 @@ int isOkayFormat4URL(char const *url){
   /* must pass our isGoodDirName() after the scheme **/
   char *path;
   char *delimiter = "://";
+  char *colon, *slash;
+  char noPort[PATH_MAX];
   int  result;
 
   /* get path from original url string **/
   path = strstr(url, delimiter) + strlen(delimiter);
 
+  /* server may have port number; "mirror:8080/..." is checked without it **/
+  colon = strchr(path, ':');
+  slash = strchr(path, '/');
+
+  if(colon && (!slash || colon < slash)){
+
+    size_t digits = strspn(colon + 1, "0123456789");
+
+    if(digits == 0 || (colon[1 + digits] != '/' && colon[1 + digits] != '\0') ||
+       strlen(path) >= sizeof(noPort))
+
+      return FALSE;
+
+    sprintf(noPort, "%.*s%s", (int) (colon - path), path, colon + 1 + digits);
+    path = noPort;
+  }
+
   result = isGoodDirName(path); /* leading & trailing slashes are optional **/
   if(result != ztSuccess)
 
@@ -2328,4 +2348,117 @@ char *arg2FullPath(const char *arg){
 
 } /* END arg2FullPath() **/
 
+/* compareUint64(): qsort() comparison for uint64_t keys **/
+
+int compareUint64(const void *first, const void *second){
+
+  uint64_t  one = *(const uint64_t *) first;
+  uint64_t  two = *(const uint64_t *) second;
+
+  return (one > two) - (one < two);
+
+} /* END compareUint64() **/
+
+/* compareStrings(): qsort() comparison for array of (char *) **/
+
+int compareStrings(const void *first, const void *second){
+
+  return strcmp(*(char * const *) first, *(char * const *) second);
+
+} /* END compareStrings() **/
+
+/* jsonValue(): copies string value for 'key' from flat JSON object to 'dst';
+ * handles escapes: \" \\ \/ and \u00XX.
+ **********************************************************************/
+
+int jsonValue(char *dst, size_t size, const char *json, const char *key){
+
+  char        pattern[128];
+  const char  *ptr;
+  size_t      length = 0;
+  unsigned    value;
+
+  ASSERTARGS(dst && json && key);
+
+  snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+
+  ptr = strstr(json, pattern);
+  if(! ptr)
+    return ztParseError;
+
+  ptr += strlen(pattern);
+
+  while(*ptr == ' ' || *ptr == '\t' || *ptr == '\r' || *ptr == '\n')
+    ptr++;
+
+  if(*ptr++ != ':')
+    return ztParseError;
+
+  while(*ptr == ' ' || *ptr == '\t' || *ptr == '\r' || *ptr == '\n')
+    ptr++;
+
+  if(*ptr++ != '"')
+    return ztParseError;
+
+  while(*ptr && *ptr != '"'){
+
+    if(length + 1 >= size)
+      return ztParseError;
+
+    if(*ptr == '\\'){
+
+      ptr++;
+
+      if(*ptr == 'u'){
+        if(sscanf(ptr + 1, "%4x", &value) != 1 || value == 0 || value > 0x7f)
+          return ztParseError;
+        dst[length++] = (char) value;
+        ptr += 5;
+        continue;
+      }
+
+      if(*ptr != '"' && *ptr != '\\' && *ptr != '/')
+        return ztParseError;
+    }
+
+    dst[length++] = *ptr++;
+  }
+
+  if(*ptr != '"')
+    return ztParseError;
+
+  dst[length] = '\0';
+
+  return ztSuccess;
+
+} /* END jsonValue() **/
+
+/* jsonEscape(): escapes 'src' for JSON string value; returns 0 on overflow **/
+
+size_t jsonEscape(char *dest, size_t size, const char *src){
+
+  size_t  used = 0;
+  unsigned char ch;
+
+  for(; *src; src++){
+
+    ch = (unsigned char) *src;
+
+    if(used + 7 >= size)
+      return 0;
+
+    if(ch == '"' || ch == '\\'){
+      dest[used++] = '\\';
+      dest[used++] = (char) ch;
+    }
+    else if(ch < 0x20)
+      used += (size_t) sprintf(dest + used, "\\u%04x", ch);
+    else
+      dest[used++] = (char) ch;
+  }
+
+  dest[used] = '\0';
+
+  return used + 1;
 
+} /* END jsonEscape() **/
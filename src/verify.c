@@ -0,0 +1,907 @@
+/*
+ * verify.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * local change files tree check; see verify.h.
+ *
+ * tree walk is done first - single thread, it is only readdir() - to find
+ * every sequence number with the files it has. Then sorted items are handed
+ * to worker pool in small batches; each job writes status into its own items
+ * only, so no locking. Report is printed in sequence order after the pool is
+ * done.
+ *
+ * pack files - --pack option - are checked on walk thread: member CRC32
+ * is compared while reading; items found in pack are marked IN_PACK with
+ * status set, jobs skip them.
+ *
+ * gzip is checked here and not with gzread(): we parse member header, raw
+ * inflate and compare trailer CRC32 / ISIZE ourselves. CRC is crc32Update()
+ * with carry-less multiply; that is most of the time per file after inflate.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+#include <zlib.h>
+
+#include "verify.h"
+#include "crc32.h"
+#include "summary.h"
+#include "idindex.h"
+#include "pack.h"
+#include "workers.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+#include "debug.h"
+
+#define VERIFY_BUFFER   (128 * 1024)
+#define VERIFY_BATCH    16
+
+/* VERIFY_ITEM flags **/
+#define HAS_OSC     0x01
+#define HAS_STATE   0x02
+#define HAS_ZST     0x04
+#define IN_PACK     0x08   /* checked on walk; status is set **/
+
+typedef struct VERIFY_ITEM_ {
+
+  SEQ_NUM        seq;
+  unsigned char  flags;
+  unsigned char  oscStatus;    /* VERIFY_STATUS **/
+  unsigned char  stateStatus;
+
+} VERIFY_ITEM;
+
+typedef struct ITEM_ARRAY_ {
+
+  VERIFY_ITEM  *items;
+  size_t       count;
+  size_t       size;
+
+} ITEM_ARRAY;
+
+typedef struct VERIFY_JOB_ {
+
+  const char   *prefix;
+  VERIFY_ITEM  *items;
+  size_t       count;
+
+} VERIFY_JOB;
+
+typedef struct IN_BUFFER_ {
+
+  int            fd;
+  unsigned char  *data;
+  size_t         pos;
+  size_t         len;
+  int            eof;
+  int            error;
+
+} IN_BUFFER;
+
+static int walkTree(ITEM_ARRAY *array, VERIFY_REPORT *report, const char *prefix, SEQ_NUM first, SEQ_NUM last);
+static int walkLeaf(ITEM_ARRAY *array, VERIFY_REPORT *report, const char *dirName, SEQ_NUM base, SEQ_NUM first, SEQ_NUM last);
+static int walkPack(ITEM_ARRAY *array, VERIFY_REPORT *report, const char *packFile, SEQ_NUM base, SEQ_NUM first, SEQ_NUM last);
+static void itemName(char *buffer, size_t size, const char *root, const VERIFY_ITEM *item, const char *ext);
+static int appendItem(ITEM_ARRAY *array, SEQ_NUM seq, unsigned char flags);
+static int compareItems(const void *first, const void *second);
+static int verifyJob(void *arg);
+static void reportMissing(VERIFY_REPORT *report, SEQ_NUM from, SEQ_NUM to);
+static int fillBuffer(IN_BUFFER *in);
+static int nextByte(IN_BUFFER *in);
+static VERIFY_STATUS readGzipHeader(IN_BUFFER *in);
+static VERIFY_STATUS endOfInput(IN_BUFFER *in);
+
+/* verifyTree(): checks tree under 'prefix'; 'first' and 'last' may be
+ * SEQ_NONE for no limit. Problems are listed on stdout, counts are set in
+ * 'report'. Returns ztSuccess when tree could be checked - even with
+ * problems found - caller looks at 'report'.
+ *
+ ***************************************************************************/
+
+int verifyTree(VERIFY_REPORT *report, const char *prefix, SEQ_NUM first, SEQ_NUM last, int numThreads){
+
+  ASSERTARGS(report && prefix);
+
+  ITEM_ARRAY   array = {NULL, 0, 0};
+  WORK_POOL    *pool;
+  VERIFY_JOB   *job;
+  VERIFY_ITEM  *item;
+  char         root[PATH_MAX];
+  char         fileName[PATH_MAX + 64];
+  size_t       index;
+  SEQ_NUM      next;
+  int          result;
+
+  memset(report, 0, sizeof(VERIFY_REPORT));
+
+  if(strlen(prefix) >= sizeof(root)){
+    fprintf(stderr, "%s: Error verify path is too long: <%s>\n", progName, prefix);
+    return ztFnameLong;
+  }
+
+  strcpy(root, prefix);
+  if(strlen(root) > 1 && SLASH_ENDING(root))
+    root[strlen(root) - 1] = '\0';
+
+  result = walkTree(&array, report, root, first, last);
+  if(result != ztSuccess){
+    free(array.items);
+    return result;
+  }
+
+  if(array.count)
+    qsort(array.items, array.count, sizeof(VERIFY_ITEM), compareItems);
+
+  report->pairs = (long) array.count;
+
+  if(numThreads < 1)
+    numThreads = 1;
+
+  pool = initialWorkPool(numThreads, verifyJob, free);
+  if(!pool){
+    fprintf(stderr, "%s: Error failed initialWorkPool() for verify.\n", progName);
+    free(array.items);
+    return ztMemoryAllocate;
+  }
+
+  for(index = 0; index < array.count; index += VERIFY_BATCH){
+
+    job = (VERIFY_JOB *) malloc(sizeof(VERIFY_JOB));
+    if(!job){
+      fprintf(stderr, "%s: Error allocating memory.\n", progName);
+      result = ztMemoryAllocate;
+      break;
+    }
+
+    job->prefix = root;
+    job->items = array.items + index;
+    job->count = (array.count - index < VERIFY_BATCH) ? array.count - index : VERIFY_BATCH;
+
+    result = submitWork(pool, job);
+    if(result != ztSuccess){
+      fprintf(stderr, "%s: Error failed submitWork() for verify.\n", progName);
+      free(job);
+      break;
+    }
+  }
+
+  /* wait even on error; jobs point into array **/
+  if(finishWorkPool(&pool) != ztSuccess && result == ztSuccess)
+    result = ztUnknownError;
+
+  if(result != ztSuccess){
+    free(array.items);
+    return result;
+  }
+
+  /* report in sequence order **/
+  next = first;
+
+  for(index = 0; index < array.count; index++){
+
+    item = array.items + index;
+
+    if(next != SEQ_NONE && item->seq > next)
+      reportMissing(report, next, item->seq - 1);
+
+    next = item->seq + 1;
+
+    if(item->flags & HAS_OSC){
+
+      report->checked++;
+
+      if(item->oscStatus != VERIFY_OK){
+        itemName(fileName, sizeof(fileName), root, item, ".osc.gz");
+        fprintf(stdout, "corrupt:    %s (%s)\n", fileName,
+                verifyStatusString((VERIFY_STATUS) item->oscStatus));
+        report->corrupt++;
+      }
+    }
+
+    if((item->flags & HAS_STATE) && item->stateStatus != VERIFY_OK){
+      itemName(fileName, sizeof(fileName), root, item, ".state.txt");
+      fprintf(stdout, "corrupt:    %s (%s)\n", fileName,
+              verifyStatusString((VERIFY_STATUS) item->stateStatus));
+      report->corrupt++;
+    }
+
+    if(! (item->flags & HAS_STATE)){
+      itemName(fileName, sizeof(fileName), root, item, (item->flags & HAS_OSC) ? ".osc.gz" : ".osc.zst");
+      fprintf(stdout, "orphaned:   %s (no state.txt file)\n", fileName);
+      report->orphaned++;
+    }
+    else if(! (item->flags & (HAS_OSC | HAS_ZST))){
+      itemName(fileName, sizeof(fileName), root, item, ".state.txt");
+      fprintf(stdout, "orphaned:   %s (no change file)\n", fileName);
+      report->orphaned++;
+    }
+  }
+
+  if(last != SEQ_NONE && next != SEQ_NONE && next <= last)
+    reportMissing(report, next, last);
+
+  free(array.items);
+
+  return ztSuccess;
+
+} /* END verifyTree() **/
+
+/* verifyGzipFile(): decompresses every member in gzip file 'path' **/
+
+VERIFY_STATUS verifyGzipFile(const char *path){
+
+  ASSERTARGS(path);
+
+  IN_BUFFER      in;
+  z_stream       strm;
+  unsigned char  *out;
+  unsigned int   crc, isize, trailer[8];
+  size_t         produced;
+  VERIFY_STATUS  status = VERIFY_OK;
+  int            ret, i, ch;
+
+  memset(&in, 0, sizeof(IN_BUFFER));
+  memset(&strm, 0, sizeof(z_stream));
+
+  in.fd = open(path, O_RDONLY | O_CLOEXEC);
+  if(in.fd < 0)
+    return VERIFY_READ_ERROR;
+
+  in.data = (unsigned char *) malloc(VERIFY_BUFFER);
+  out = (unsigned char *) malloc(VERIFY_BUFFER);
+
+  if(!in.data || !out || inflateInit2(&strm, -MAX_WBITS) != Z_OK){
+    free(in.data);
+    free(out);
+    close(in.fd);
+    return VERIFY_READ_ERROR;
+  }
+
+  if(! fillBuffer(&in))
+    status = in.error ? VERIFY_READ_ERROR : VERIFY_EMPTY;
+
+  /* one pass per gzip member **/
+  while(status == VERIFY_OK){
+
+    status = readGzipHeader(&in);
+    if(status != VERIFY_OK)
+      break;
+
+    inflateReset(&strm);
+    crc = 0;
+    isize = 0;
+    ret = Z_OK;
+
+    while(ret != Z_STREAM_END){
+
+      if(! fillBuffer(&in)){
+        status = endOfInput(&in);
+        break;
+      }
+
+      strm.next_in = in.data + in.pos;
+      strm.avail_in = (uInt) (in.len - in.pos);
+
+      do {
+        strm.next_out = out;
+        strm.avail_out = VERIFY_BUFFER;
+
+        ret = inflate(&strm, Z_NO_FLUSH);
+        if(ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR){
+          status = VERIFY_BAD_DATA;
+          break;
+        }
+
+        produced = VERIFY_BUFFER - strm.avail_out;
+        crc = crc32Update(crc, out, produced);
+        isize += (unsigned int) produced; /* modulo 2^32 as gzip trailer **/
+
+      } while(strm.avail_out == 0 && ret != Z_STREAM_END);
+
+      in.pos = in.len - strm.avail_in;
+
+      if(status != VERIFY_OK)
+        break;
+    }
+
+    if(status != VERIFY_OK)
+      break;
+
+    for(i = 0; i < 8; i++){
+      ch = nextByte(&in);
+      if(ch < 0)
+        break;
+      trailer[i] = (unsigned int) ch;
+    }
+
+    if(i < 8){
+      status = endOfInput(&in);
+      break;
+    }
+
+    if(crc != (trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | (trailer[3] << 24))){
+      status = VERIFY_BAD_CRC;
+      break;
+    }
+
+    if(isize != (trailer[4] | (trailer[5] << 8) | (trailer[6] << 16) | (trailer[7] << 24))){
+      status = VERIFY_BAD_SIZE;
+      break;
+    }
+
+    /* concatenated members are allowed, anything else after is not **/
+    if(! fillBuffer(&in)){
+      if(in.error)
+        status = VERIFY_READ_ERROR;
+      break;
+    }
+  }
+
+  inflateEnd(&strm);
+  free(in.data);
+  free(out);
+  close(in.fd);
+
+  return status;
+
+} /* END verifyGzipFile() **/
+
+/* verifyStateFile(): 'sequenceNumber' line must be there and equal 'seq' **/
+
+VERIFY_STATUS verifyStateFile(const char *path, SEQ_NUM seq){
+
+  ASSERTARGS(path);
+
+  FILE     *filePtr;
+  char     line[256];
+  char     *value;
+  SEQ_NUM  found;
+  int      empty = TRUE;
+
+  filePtr = fopen(path, "r");
+  if(!filePtr)
+    return VERIFY_READ_ERROR;
+
+  while(fgets(line, sizeof(line), filePtr)){
+
+    empty = FALSE;
+
+    if(strncmp(line, "sequenceNumber=", 15) != 0)
+      continue;
+
+    value = line + 15;
+    value[strcspn(value, "\r\n")] = '\0';
+
+    fclose(filePtr);
+
+    if(string2Sequence(&found, value) != ztSuccess)
+      return VERIFY_NO_SEQUENCE;
+
+    return (found == seq) ? VERIFY_OK : VERIFY_WRONG_SEQ;
+  }
+
+  fclose(filePtr);
+
+  return empty ? VERIFY_EMPTY : VERIFY_NO_SEQUENCE;
+
+} /* END verifyStateFile() **/
+
+const char *verifyStatusString(VERIFY_STATUS status){
+
+  switch(status){
+
+  case VERIFY_OK:           return "good";
+  case VERIFY_EMPTY:        return "empty file";
+  case VERIFY_BAD_HEADER:   return "not gzip or bad gzip header";
+  case VERIFY_BAD_DATA:     return "bad compressed data";
+  case VERIFY_TRUNCATED:    return "truncated";
+  case VERIFY_BAD_CRC:      return "CRC32 mismatch";
+  case VERIFY_BAD_SIZE:     return "ISIZE mismatch";
+  case VERIFY_NO_SEQUENCE:  return "no sequenceNumber line";
+  case VERIFY_WRONG_SEQ:    return "sequenceNumber does not match path";
+  case VERIFY_READ_ERROR:   return "read error";
+  }
+
+  return "unknown";
+
+} /* END verifyStatusString() **/
+
+/* walkTree(): {prefix}/NNN/NNN/ directories; skips whole directory out of
+ * range. 'merged' and 'index' directories are ours - made by --merge and
+ * --index options.
+ **************************************************************************/
+
+static int walkTree(ITEM_ARRAY *array, VERIFY_REPORT *report, const char *prefix, SEQ_NUM first, SEQ_NUM last){
+
+  DIR            *rootDir, *parentDir;
+  struct dirent  *rootEntry, *parentEntry;
+  char           rootName[PATH_MAX], parentName[PATH_MAX];
+  SEQ_NUM        rootBase, parentBase;
+  int            rootNum, parentNum;
+  int            result = ztSuccess;
+
+  rootDir = opendir(prefix);
+  if(!rootDir){
+    fprintf(stderr, "%s: Error failed opendir() for <%s>: %s\n", progName, prefix, strerror(errno));
+    return ztInaccessibleDir;
+  }
+
+  while(result == ztSuccess && (rootEntry = readdir(rootDir))){
+
+    if(rootEntry->d_name[0] == '.' || strcmp(rootEntry->d_name, "merged") == 0 ||
+       strcmp(rootEntry->d_name, INDEX_DIR) == 0)
+      continue;
+
+    if(snprintf(rootName, sizeof(rootName), "%s/%s", prefix, rootEntry->d_name) >= (int) sizeof(rootName)){
+      result = ztFnameLong;
+      break;
+    }
+
+    rootNum = triplet(rootEntry->d_name);
+    if(rootNum < 0 || ! isPathDirectory(rootName)){
+      fprintf(stdout, "unexpected: %s\n", rootName);
+      report->unexpected++;
+      continue;
+    }
+
+    rootBase = (SEQ_NUM) rootNum * 1000000;
+
+    if((first != SEQ_NONE && rootBase + 999999 < first) || (last != SEQ_NONE && rootBase > last))
+      continue;
+
+    parentDir = opendir(rootName);
+    if(!parentDir){
+      fprintf(stderr, "%s: Error failed opendir() for <%s>: %s\n", progName, rootName, strerror(errno));
+      result = ztInaccessibleDir;
+      break;
+    }
+
+    while(result == ztSuccess && (parentEntry = readdir(parentDir))){
+
+      if(parentEntry->d_name[0] == '.')
+        continue;
+
+      if(snprintf(parentName, sizeof(parentName), "%s/%s", rootName, parentEntry->d_name) >= (int) sizeof(parentName)){
+        result = ztFnameLong;
+        break;
+      }
+
+      /* "NNN.pack" is parent directory packed by --pack **/
+      if(strlen(parentEntry->d_name) == 3 + strlen(PACK_EXT) && strcmp(parentEntry->d_name + 3, PACK_EXT) == 0){
+
+        char  name[4];
+
+        memcpy(name, parentEntry->d_name, 3);
+        name[3] = '\0';
+        parentNum = triplet(name);
+
+        if(parentNum >= 0){
+
+          parentBase = rootBase + (SEQ_NUM) parentNum * 1000;
+
+          if((first != SEQ_NONE && parentBase + 999 < first) || (last != SEQ_NONE && parentBase > last))
+            continue;
+
+          result = walkPack(array, report, parentName, parentBase, first, last);
+          continue;
+        }
+      }
+
+      parentNum = triplet(parentEntry->d_name);
+      if(parentNum < 0 || ! isPathDirectory(parentName)){
+        fprintf(stdout, "unexpected: %s\n", parentName);
+        report->unexpected++;
+        continue;
+      }
+
+      parentBase = rootBase + (SEQ_NUM) parentNum * 1000;
+
+      if((first != SEQ_NONE && parentBase + 999 < first) || (last != SEQ_NONE && parentBase > last))
+        continue;
+
+      result = walkLeaf(array, report, parentName, parentBase, first, last);
+    }
+
+    closedir(parentDir);
+  }
+
+  closedir(rootDir);
+
+  return result;
+
+} /* END walkTree() **/
+
+static int walkLeaf(ITEM_ARRAY *array, VERIFY_REPORT *report, const char *dirName, SEQ_NUM base, SEQ_NUM first, SEQ_NUM last){
+
+  DIR            *dir;
+  struct dirent  *entry;
+  unsigned char  flags[1000];
+  unsigned char  flag;
+  const char     *ext;
+  SEQ_NUM        seq;
+  int            fileNum;
+  int            result = ztSuccess;
+
+  memset(flags, 0, sizeof(flags));
+
+  dir = opendir(dirName);
+  if(!dir){
+    fprintf(stderr, "%s: Error failed opendir() for <%s>: %s\n", progName, dirName, strerror(errno));
+    return ztInaccessibleDir;
+  }
+
+  while((entry = readdir(dir))){
+
+    if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+
+    fileNum = -1;
+    flag = 0;
+
+    if(strlen(entry->d_name) > 3 && entry->d_name[3] == '.'){
+
+      char  name[4];
+
+      memcpy(name, entry->d_name, 3);
+      name[3] = '\0';
+      fileNum = triplet(name);
+
+      ext = entry->d_name + 3;
+
+      if(strcmp(ext, ".osc.gz") == 0)
+        flag = HAS_OSC;
+      else if(strcmp(ext, ".state.txt") == 0)
+        flag = HAS_STATE;
+      else if(strcmp(ext, ".osc.zst") == 0)
+        flag = HAS_ZST;
+      else if(strcmp(ext, SUMMARY_EXT) == 0)
+        continue; /* --summary sidecar **/
+    }
+
+    seq = base + (SEQ_NUM) fileNum;
+
+    if(fileNum >= 0 && ((first != SEQ_NONE && seq < first) || (last != SEQ_NONE && seq > last)))
+      continue;
+
+    /* left over ".part" files show here too **/
+    if(fileNum < 0 || ! flag){
+      fprintf(stdout, "unexpected: %s/%s\n", dirName, entry->d_name);
+      report->unexpected++;
+      continue;
+    }
+
+    flags[fileNum] |= flag;
+  }
+
+  closedir(dir);
+
+  for(fileNum = 0; fileNum < 1000 && result == ztSuccess; fileNum++)
+    if(flags[fileNum])
+      result = appendItem(array, base + (SEQ_NUM) fileNum, flags[fileNum]);
+
+  return result;
+
+} /* END walkLeaf() **/
+
+/* walkPack(): as walkLeaf() for pack file; member CRC32 is checked here.
+ * Pack that can not be opened is one corrupt file. Sequence number found
+ * both loose and in pack - crash before loose files were removed - shows
+ * twice and is not an error.
+ **************************************************************************/
+
+static int walkPack(ITEM_ARRAY *array, VERIFY_REPORT *report, const char *packFile, SEQ_NUM base, SEQ_NUM first, SEQ_NUM last){
+
+  PACK_FILE         *pack;
+  const PACK_ENTRY  *entry;
+  unsigned char     flags[1000];
+  unsigned char     oscStatus[1000], stateStatus[1000];
+  unsigned char     flag;
+  const char        *ext;
+  char              name[4];
+  SEQ_NUM           seq;
+  uint32_t          index;
+  int               fileNum, status;
+  int               result = ztSuccess;
+
+  pack = packOpen(packFile);
+  if(!pack){
+    fprintf(stdout, "corrupt:    %s (not a pack file or truncated)\n", packFile);
+    report->corrupt++;
+    return ztSuccess;
+  }
+
+  memset(flags, 0, sizeof(flags));
+  memset(oscStatus, VERIFY_OK, sizeof(oscStatus));
+  memset(stateStatus, VERIFY_OK, sizeof(stateStatus));
+
+  for(index = 0; index < pack->trailer.count; index++){
+
+    entry = pack->entries + index;
+
+    fileNum = -1;
+    flag = 0;
+
+    if(strnlen(entry->name, PACK_NAME_SIZE) < PACK_NAME_SIZE && strlen(entry->name) > 3 && entry->name[3] == '.'){
+
+      memcpy(name, entry->name, 3);
+      name[3] = '\0';
+      fileNum = triplet(name);
+
+      ext = entry->name + 3;
+
+      if(strcmp(ext, ".osc.gz") == 0)
+        flag = HAS_OSC;
+      else if(strcmp(ext, ".state.txt") == 0)
+        flag = HAS_STATE;
+      else if(strcmp(ext, ".osc.zst") == 0)
+        flag = HAS_ZST;
+      else if(strcmp(ext, SUMMARY_EXT) == 0)
+        flag = IN_PACK; /* sidecar; CRC only **/
+    }
+
+    seq = base + (SEQ_NUM) fileNum;
+
+    if(fileNum >= 0 && ((first != SEQ_NONE && seq < first) || (last != SEQ_NONE && seq > last)))
+      continue;
+
+    if(fileNum < 0 || ! flag){
+      fprintf(stdout, "unexpected: %s:%.*s\n", packFile, PACK_NAME_SIZE, entry->name);
+      report->unexpected++;
+      continue;
+    }
+
+    status = (packCheck(pack, entry) == ztSuccess) ? VERIFY_OK : VERIFY_BAD_CRC;
+
+    if(flag == HAS_STATE)
+      stateStatus[fileNum] = (unsigned char) status;
+    else if(flag == HAS_OSC)
+      oscStatus[fileNum] = (unsigned char) status;
+    else if(status != VERIFY_OK){
+      fprintf(stdout, "corrupt:    %s:%s (%s)\n", packFile, entry->name, verifyStatusString((VERIFY_STATUS) status));
+      report->corrupt++;
+    }
+
+    if(flag != IN_PACK)
+      flags[fileNum] |= flag;
+  }
+
+  packClose(&pack);
+
+  for(fileNum = 0; fileNum < 1000 && result == ztSuccess; fileNum++){
+
+    if(! flags[fileNum])
+      continue;
+
+    result = appendItem(array, base + (SEQ_NUM) fileNum, flags[fileNum] | IN_PACK);
+    if(result != ztSuccess)
+      break;
+
+    array->items[array->count - 1].oscStatus = oscStatus[fileNum];
+    array->items[array->count - 1].stateStatus = stateStatus[fileNum];
+  }
+
+  return result;
+
+} /* END walkPack() **/
+
+/* itemName(): file name for report; "{root}/006/123.pack:456.osc.gz" for
+ * pack member.
+ **************************************************************************/
+
+static void itemName(char *buffer, size_t size, const char *root, const VERIFY_ITEM *item, const char *ext){
+
+  char  seqPath[16];
+
+  sequence2Path(seqPath, item->seq);
+
+  if(item->flags & IN_PACK)
+    snprintf(buffer, size, "%s%.8s%s:%s%s", root, seqPath, PACK_EXT, seqPath + 9, ext);
+  else
+    snprintf(buffer, size, "%s%s%s", root, seqPath, ext);
+
+} /* END itemName() **/
+
+static int appendItem(ITEM_ARRAY *array, SEQ_NUM seq, unsigned char flags){
+
+  VERIFY_ITEM  *newItems;
+  size_t       newSize;
+
+  if(array->count == array->size){
+
+    newSize = array->size ? array->size * 2 : 1024;
+
+    newItems = (VERIFY_ITEM *) realloc(array->items, newSize * sizeof(VERIFY_ITEM));
+    if(!newItems){
+      fprintf(stderr, "%s: Error allocating memory.\n", progName);
+      return ztMemoryAllocate;
+    }
+
+    array->items = newItems;
+    array->size = newSize;
+  }
+
+  array->items[array->count].seq = seq;
+  array->items[array->count].flags = flags;
+  array->items[array->count].oscStatus = VERIFY_OK;
+  array->items[array->count].stateStatus = VERIFY_OK;
+  array->count++;
+
+  return ztSuccess;
+
+} /* END appendItem() **/
+
+static int compareItems(const void *first, const void *second){
+
+  SEQ_NUM  one = ((const VERIFY_ITEM *) first)->seq;
+  SEQ_NUM  two = ((const VERIFY_ITEM *) second)->seq;
+
+  return (one > two) - (one < two);
+
+} /* END compareItems() **/
+
+/* verifyJob(): problems go in items; job itself does not fail **/
+
+static int verifyJob(void *arg){
+
+  VERIFY_JOB   *job = (VERIFY_JOB *) arg;
+  VERIFY_ITEM  *item;
+  char         path[PATH_MAX];
+  char         seqPath[16];
+  size_t       index;
+
+  for(index = 0; index < job->count; index++){
+
+    item = job->items + index;
+
+    if(item->flags & IN_PACK)
+      continue;
+
+    sequence2Path(seqPath, item->seq);
+
+    if(item->flags & HAS_OSC){
+      snprintf(path, sizeof(path), "%s%s.osc.gz", job->prefix, seqPath);
+      item->oscStatus = (unsigned char) verifyGzipFile(path);
+    }
+
+    if(item->flags & HAS_STATE){
+      snprintf(path, sizeof(path), "%s%s.state.txt", job->prefix, seqPath);
+      item->stateStatus = (unsigned char) verifyStateFile(path, item->seq);
+    }
+  }
+
+  return ztSuccess;
+
+} /* END verifyJob() **/
+
+static void reportMissing(VERIFY_REPORT *report, SEQ_NUM from, SEQ_NUM to){
+
+  char  fromPath[16], toPath[16];
+
+  sequence2Path(fromPath, from);
+
+  if(from == to)
+    fprintf(stdout, "missing:    %u (%s)\n", from, fromPath);
+  else {
+    sequence2Path(toPath, to);
+    fprintf(stdout, "missing:    %u - %u (%s - %s) %u sequence numbers\n", from, to, fromPath, toPath, to - from + 1);
+  }
+
+  report->missing += (long) (to - from + 1);
+
+} /* END reportMissing() **/
+
+/* fillBuffer(): returns 1 when there is input in buffer **/
+
+static int fillBuffer(IN_BUFFER *in){
+
+  ssize_t  count;
+
+  if(in->pos < in->len)
+    return 1;
+
+  if(in->eof || in->error)
+    return 0;
+
+  do {
+    count = read(in->fd, in->data, VERIFY_BUFFER);
+  } while(count < 0 && errno == EINTR);
+
+  if(count < 0){
+    in->error = 1;
+    return 0;
+  }
+
+  if(count == 0){
+    in->eof = 1;
+    return 0;
+  }
+
+  in->pos = 0;
+  in->len = (size_t) count;
+
+  return 1;
+
+} /* END fillBuffer() **/
+
+static int nextByte(IN_BUFFER *in){
+
+  if(! fillBuffer(in))
+    return -1;
+
+  return in->data[in->pos++];
+
+} /* END nextByte() **/
+
+/* readGzipHeader(): RFC 1952 member header; skips optional fields **/
+
+static VERIFY_STATUS readGzipHeader(IN_BUFFER *in){
+
+  int  id1, id2, method, flags;
+  int  ch, i, extraLength;
+
+  id1 = nextByte(in);
+  id2 = nextByte(in);
+  method = nextByte(in);
+  flags = nextByte(in);
+
+  if(flags < 0)
+    return endOfInput(in);
+
+  if(id1 != 0x1f || id2 != 0x8b || method != Z_DEFLATED || (flags & 0xe0))
+    return VERIFY_BAD_HEADER;
+
+  /* MTIME, XFL, OS **/
+  for(i = 0; i < 6; i++)
+    if(nextByte(in) < 0)
+      return endOfInput(in);
+
+  if(flags & 0x04){ /* FEXTRA **/
+
+    extraLength = nextByte(in);
+    ch = nextByte(in);
+    if(ch < 0)
+      return endOfInput(in);
+
+    extraLength |= ch << 8;
+
+    for(i = 0; i < extraLength; i++)
+      if(nextByte(in) < 0)
+        return endOfInput(in);
+  }
+
+  if(flags & 0x08) /* FNAME **/
+    do {
+      ch = nextByte(in);
+      if(ch < 0)
+        return endOfInput(in);
+    } while(ch);
+
+  if(flags & 0x10) /* FCOMMENT **/
+    do {
+      ch = nextByte(in);
+      if(ch < 0)
+        return endOfInput(in);
+    } while(ch);
+
+  if(flags & 0x02) /* FHCRC **/
+    for(i = 0; i < 2; i++)
+      if(nextByte(in) < 0)
+        return endOfInput(in);
+
+  return VERIFY_OK;
+
+} /* END readGzipHeader() **/
+
+static VERIFY_STATUS endOfInput(IN_BUFFER *in){
+
+  return in->error ? VERIFY_READ_ERROR : VERIFY_TRUNCATED;
+
+} /* END endOfInput() **/
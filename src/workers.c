@@ -0,0 +1,199 @@
+/*
+ * workers.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * fixed size thread pool; see workers.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "workers.h"
+#include "util.h"
+#include "ztError.h"
+#include "getdiff.h"
+
+static void *workerMain(void *arg);
+
+WORK_POOL *initialWorkPool(int numThreads, WORK_FUNC func, void (*freeArg)(void *arg)){
+
+  ASSERTARGS(func);
+
+  WORK_POOL  *pool;
+  int        i;
+
+  if(numThreads < 1)
+    numThreads = 1;
+
+  if(numThreads > MAX_WORKERS)
+    numThreads = MAX_WORKERS;
+
+  pool = (WORK_POOL *) malloc(sizeof(WORK_POOL));
+  if(!pool){
+    fprintf(stderr, "%s: Error allocating memory in initialWorkPool().\n", progName);
+    return NULL;
+  }
+
+  memset(pool, 0, sizeof(WORK_POOL));
+
+  pool->func = func;
+  pool->freeArg = freeArg;
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->hasWork, NULL);
+
+  for(i = 0; i < numThreads; i++){
+
+    if(pthread_create(&pool->threads[i], NULL, workerMain, pool) != 0){
+
+      fprintf(stderr, "%s: Error failed pthread_create() for worker %d.\n", progName, i);
+
+      /* keep the ones we have **/
+      if(i == 0){
+        pthread_mutex_destroy(&pool->lock);
+        pthread_cond_destroy(&pool->hasWork);
+        free(pool);
+        return NULL;
+      }
+      break;
+    }
+
+    pool->numThreads++;
+  }
+
+  return pool;
+
+} /* END initialWorkPool() **/
+
+int submitWork(WORK_POOL *pool, void *arg){
+
+  ASSERTARGS(pool);
+
+  WORK_JOB  *job;
+
+  job = (WORK_JOB *) malloc(sizeof(WORK_JOB));
+  if(!job){
+    fprintf(stderr, "%s: Error allocating memory in submitWork().\n", progName);
+    return ztMemoryAllocate;
+  }
+
+  job->arg = arg;
+  job->next = NULL;
+
+  pthread_mutex_lock(&pool->lock);
+
+  if(pool->tail)
+    pool->tail->next = job;
+  else
+    pool->head = job;
+
+  pool->tail = job;
+
+  pthread_cond_signal(&pool->hasWork);
+  pthread_mutex_unlock(&pool->lock);
+
+  return ztSuccess;
+
+} /* END submitWork() **/
+
+/* finishWorkPool(): runs remaining jobs, joins workers and frees pool;
+ * returns first error from any job or ztSuccess.
+ *
+ ***************************************************************************/
+
+int finishWorkPool(WORK_POOL **pool){
+
+  ASSERTARGS(pool);
+
+  WORK_POOL  *myPool = *pool;
+  int        result;
+  int        i;
+
+  if(!myPool)
+    return ztSuccess;
+
+  pthread_mutex_lock(&myPool->lock);
+  myPool->closing = 1;
+  pthread_cond_broadcast(&myPool->hasWork);
+  pthread_mutex_unlock(&myPool->lock);
+
+  for(i = 0; i < myPool->numThreads; i++)
+    pthread_join(myPool->threads[i], NULL);
+
+  result = myPool->firstError;
+
+  pthread_mutex_destroy(&myPool->lock);
+  pthread_cond_destroy(&myPool->hasWork);
+
+  free(myPool);
+  *pool = NULL;
+
+  return result;
+
+} /* END finishWorkPool() **/
+
+int numCPUs(void){
+
+  long  count = sysconf(_SC_NPROCESSORS_ONLN);
+
+  if(count < 1)
+    return 1;
+
+  if(count > MAX_WORKERS)
+    return MAX_WORKERS;
+
+  return (int) count;
+
+} /* END numCPUs() **/
+
+static void *workerMain(void *arg){
+
+  WORK_POOL  *pool = (WORK_POOL *) arg;
+  WORK_JOB   *job;
+  int        result;
+
+  while(1){
+
+    pthread_mutex_lock(&pool->lock);
+
+    while(!pool->head && !pool->closing)
+      pthread_cond_wait(&pool->hasWork, &pool->lock);
+
+    job = pool->head;
+    if(!job){ /* closing and nothing left **/
+      pthread_mutex_unlock(&pool->lock);
+      break;
+    }
+
+    pool->head = job->next;
+    if(!pool->head)
+      pool->tail = NULL;
+
+    pthread_mutex_unlock(&pool->lock);
+
+    result = pool->func(job->arg);
+
+    if(pool->freeArg)
+      pool->freeArg(job->arg);
+
+    free(job);
+
+    pthread_mutex_lock(&pool->lock);
+
+    pool->doneCount++;
+
+    if(result != ztSuccess){
+      pool->failedCount++;
+      if(pool->firstError == ztSuccess)
+        pool->firstError = result;
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+  }
+
+  return NULL;
+
+} /* END workerMain() **/